@@ -0,0 +1,104 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Fills atlases with random glyph-sized and sprite-sized rectangles using the
+// skyline and MaxRects packers, and reports the occupancy reached when the
+// first rectangle does not fit, and the insertion rate.
+
+#include "ppx/bitmap_atlas.h"
+#include "ppx/timer.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace ppx;
+
+static const uint32_t kIterationCount = 5;
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    struct Workload
+    {
+        const char* name;
+        uint32_t    minSize;
+        uint32_t    maxSize;
+    };
+    const Workload workloads[] = {
+        {"glyphs", 8, 32},
+        {"sprites", 16, 128},
+    };
+
+    struct Method
+    {
+        const char*     name;
+        AtlasPackMethod method;
+    };
+    const Method methods[] = {
+        {"skyline", ATLAS_PACK_METHOD_SKYLINE},
+        {"maxrects", ATLAS_PACK_METHOD_MAX_RECTS},
+    };
+
+    const uint32_t atlasSizes[] = {1024, 2048};
+
+    printf("%-8s %-9s %-9s %-8s %-11s %-10s\n", "atlas", "workload", "method", "rects", "occupancy", "inserts/s");
+    for (uint32_t atlasSize : atlasSizes) {
+        for (const Workload& workload : workloads) {
+            // Enough sizes to overflow the atlas.
+            const uint32_t        averageSize = (workload.minSize + workload.maxSize) / 2;
+            const uint32_t        sizeCount   = 2 * (atlasSize / averageSize) * (atlasSize / averageSize);
+            std::vector<uint32_t> sizes(2 * sizeCount);
+            uint32_t              state = 1;
+            for (uint32_t& size : sizes) {
+                state = state * 1664525u + 1013904223u;
+                size  = workload.minSize + ((state >> 8) % (workload.maxSize - workload.minSize + 1));
+            }
+
+            for (const Method& method : methods) {
+                AtlasPacker packer(atlasSize, atlasSize, method.method);
+                double      totalMs     = 0.0;
+                uint64_t    insertCount = 0;
+                for (uint32_t i = 0; i < kIterationCount; ++i) {
+                    packer.Clear();
+                    uint64_t startTimestamp = 0;
+                    uint64_t endTimestamp   = 0;
+                    Timer::Timestamp(&startTimestamp);
+                    for (uint32_t j = 0; j < sizeCount; ++j) {
+                        AtlasRect rect = {};
+                        if (!packer.Insert(sizes[2 * j], sizes[2 * j + 1], &rect)) {
+                            break;
+                        }
+                    }
+                    Timer::Timestamp(&endTimestamp);
+                    totalMs += Timer::TimestampToMillis(endTimestamp - startTimestamp);
+                    insertCount += packer.GetRectCount() + 1;
+                }
+
+                printf("%-8u %-9s %-9s %-8u %-11.1f %-10.0f\n",
+                       atlasSize,
+                       workload.name,
+                       method.name,
+                       packer.GetRectCount(),
+                       100.0f * packer.GetOccupancy(),
+                       insertCount / (totalMs / 1000.0));
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
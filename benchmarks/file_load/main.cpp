@@ -0,0 +1,173 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the time to load a whole file and read every byte of it:
+//  - stream:    std::ifstream read into a std::vector (the previous load_file path).
+//  - load_file: ppx::fs::load_file, memory-mapped then copied into a std::vector.
+//  - view:      ppx::fs::load_file_view, memory-mapped and read in place.
+// Each method is measured with a cold page cache (dropped with posix_fadvise
+// before each iteration) and a warm one.
+//
+// Usage: file_load [path]
+// Without a path, a 256 MiB file is generated in the temporary directory.
+
+#include "ppx/config.h"
+#include "ppx/fs.h"
+#include "ppx/timer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+using namespace ppx;
+
+static const uint64_t kGeneratedFileSize = 256ull << 20;
+static const uint32_t kIterationCount    = 5;
+
+// Sums the content so that every page is actually read.
+static uint64_t Checksum(const char* pData, size_t size)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+        uint64_t value = 0;
+        memcpy(&value, pData + i, std::min(sizeof(uint64_t), size - i));
+        sum += value;
+    }
+    return sum;
+}
+
+static bool DropPageCache(const std::filesystem::path& path)
+{
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    // Only clean pages are dropped; make sure none are dirty.
+    fdatasync(descriptor);
+    int result = posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+    close(descriptor);
+    return result == 0;
+}
+
+static bool GenerateFile(const std::filesystem::path& path, uint64_t size)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<uint64_t> block(1 << 16);
+    for (uint64_t written = 0; written < size; written += block.size() * sizeof(uint64_t)) {
+        for (size_t i = 0; i < block.size(); ++i) {
+            block[i] = written + i * 0x9E3779B97F4A7C15ull;
+        }
+        file.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(uint64_t));
+    }
+    return file.good();
+}
+
+static uint64_t LoadWithStream(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(0, std::ios::end);
+    size_t size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<char> buffer(size);
+    file.read(buffer.data(), size);
+    return Checksum(buffer.data(), buffer.size());
+}
+
+static uint64_t LoadWithLoadFile(const std::filesystem::path& path)
+{
+    auto buffer = fs::load_file(path);
+    return buffer.has_value() ? Checksum(buffer->data(), buffer->size()) : 0;
+}
+
+static uint64_t LoadWithView(const std::filesystem::path& path)
+{
+    auto view = fs::load_file_view(path);
+    return view.has_value() ? Checksum(view->GetData(), view->GetSize()) : 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::path path;
+    bool                  generated = false;
+    if (argc > 1) {
+        path = argv[1];
+    }
+    else {
+        path      = std::filesystem::temp_directory_path() / "ppx_file_load_benchmark.bin";
+        generated = true;
+        if (!GenerateFile(path, kGeneratedFileSize)) {
+            fprintf(stderr, "failed to generate %s\n", path.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    const uint64_t fileSize = std::filesystem::file_size(path);
+    printf("file: %s (%" PRIu64 " MiB)\n", path.c_str(), fileSize >> 20);
+    printf("%-10s %-6s %-10s %-10s\n", "method", "cache", "ms", "MiB/s");
+
+    struct Method
+    {
+        const char*                                           name;
+        std::function<uint64_t(const std::filesystem::path&)> load;
+    };
+    const Method methods[] = {
+        {"stream", LoadWithStream},
+        {"load_file", LoadWithLoadFile},
+        {"view", LoadWithView},
+    };
+
+    uint64_t expectedChecksum = LoadWithStream(path);
+    for (bool cold : {true, false}) {
+        for (const Method& method : methods) {
+            double totalMs = 0.0;
+            for (uint32_t i = 0; i < kIterationCount; ++i) {
+                if (cold && !DropPageCache(path)) {
+                    fprintf(stderr, "failed to drop the page cache of %s\n", path.c_str());
+                    return EXIT_FAILURE;
+                }
+                uint64_t startTimestamp = 0;
+                uint64_t endTimestamp   = 0;
+                Timer::Timestamp(&startTimestamp);
+                uint64_t checksum = method.load(path);
+                Timer::Timestamp(&endTimestamp);
+                if (checksum != expectedChecksum) {
+                    fprintf(stderr, "%s: checksum mismatch\n", method.name);
+                    return EXIT_FAILURE;
+                }
+                totalMs += Timer::TimestampToMillis(endTimestamp - startTimestamp);
+            }
+            double averageMs = totalMs / kIterationCount;
+            double mibPerSec = static_cast<double>(fileSize >> 20) / (averageMs / 1000.0);
+            printf("%-10s %-6s %-10.2f %-10.1f\n", method.name, cold ? "cold" : "warm", averageMs, mibPerSec);
+        }
+    }
+
+    if (generated) {
+        std::filesystem::remove(path);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -111,6 +111,9 @@ void GraphicsBenchmarkApp::InitKnobs()
     pDepthTestWrite->SetFlagDescription("Enable depth test and depth write for spheres.");
     pDepthTestWrite->SetIndent(1);
 
+    GetKnobManager().InitKnob(&pOptimizeSphereMesh, "optimize-sphere-mesh", false);
+    pOptimizeSphereMesh->SetFlagDescription("Optimize the triangle and vertex order of the sphere mesh for the vertex cache and overdraw, to compare with the generation order.");
+
     GetKnobManager().InitKnob(&pFullscreenQuadsCount, "fullscreen-quads-count", /* defaultValue = */ 0, /* minValue = */ 0, kMaxFullscreenQuadsCount);
     pFullscreenQuadsCount->SetDisplayName("Number of Fullscreen Quads");
     pFullscreenQuadsCount->SetFlagDescription("Select the number of fullscreen quads to render.");
@@ -564,7 +567,7 @@ void GraphicsBenchmarkApp::SetupSphereMeshes()
     uint32_t    meshIndex = 0;
     for (const auto& lod : kAvailableLODs) {
         PPX_LOG_INFO("LOD: " << lod.name);
-        SphereMesh sphereMesh(/* radius = */ 1, lod.value.longitudeSegments, lod.value.latitudeSegments);
+        SphereMesh sphereMesh(/* radius = */ 1, lod.value.longitudeSegments, lod.value.latitudeSegments, pOptimizeSphereMesh->GetValue());
         sphereMesh.ApplyGrid(grid);
         // Create a giant vertex buffer for each vb type to accommodate all copies of the sphere mesh
         PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), sphereMesh.GetLowPrecisionInterleaved(), &mSphereMeshes[meshIndex++]));
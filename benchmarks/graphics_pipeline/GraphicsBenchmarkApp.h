@@ -505,6 +505,7 @@ private:
     std::shared_ptr<KnobCheckbox>              pAlphaBlend;
     std::shared_ptr<KnobCheckbox>              pDepthTestWrite;
     std::shared_ptr<KnobCheckbox>              pAllTexturesTo1x1;
+    std::shared_ptr<KnobFlag<bool>>            pOptimizeSphereMesh;
 
     std::shared_ptr<KnobSlider<int>>                   pFullscreenQuadsCount;
     std::shared_ptr<KnobDropdown<FullscreenQuadsType>> pFullscreenQuadsType;
@@ -82,15 +82,21 @@ public:
         VERTEX_LAYOUT_TYPE_POSITION_PLANAR
     };
 
-    // Creates a SphereMesh and populates info for one sphere
-    SphereMesh(float radius, uint32_t longitudeSegments, uint32_t latitudeSegments)
+    // Creates a SphereMesh and populates info for one sphere, optionally reordered for the vertex cache and overdraw
+    SphereMesh(float radius, uint32_t longitudeSegments, uint32_t latitudeSegments, bool optimize = false)
     {
-        mSingleSphereMesh        = TriMesh::CreateSphere(radius, longitudeSegments, latitudeSegments, TriMeshOptions().Indices().TexCoords().Normals().Tangents());
+        TriMeshOptions options = TriMeshOptions().Indices().TexCoords().Normals().Tangents();
+        if (optimize) {
+            options.OptimizeOverdraw();
+        }
+        mSingleSphereMesh        = TriMesh::CreateSphere(radius, longitudeSegments, latitudeSegments, options);
         mSingleSphereVertexCount = mSingleSphereMesh.GetCountPositions();
         mSingleSphereTriCount    = mSingleSphereMesh.GetCountTriangles();
 
+        VertexCacheStatistics stats = mSingleSphereMesh.AnalyzeVertexCache();
         PPX_LOG_INFO("Creating SphereMesh:");
         PPX_LOG_INFO("  Sphere vertex count: " << mSingleSphereVertexCount << " | triangle count: " << mSingleSphereTriCount);
+        PPX_LOG_INFO("  Sphere ACMR: " << stats.acmr << " | ATVR: " << stats.atvr);
     };
 
     // Places copies of the spheres on the grid and creates all variants of geometry representations
@@ -0,0 +1,111 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the time CompareBitmaps takes on screenshot-sized images, with
+// and without SSIM and the heatmap, on one thread and on all of them.
+
+#include "ppx/bitmap.h"
+#include "ppx/image_diff.h"
+#include "ppx/timer.h"
+
+#include <cstdio>
+
+using namespace ppx;
+
+static const uint32_t kIterationCount = 5;
+
+static void FillBitmap(Bitmap* pBitmap, uint32_t seed)
+{
+    uint32_t state = seed;
+    for (uint32_t y = 0; y < pBitmap->GetHeight(); ++y) {
+        for (uint32_t x = 0; x < pBitmap->GetWidth(); ++x) {
+            uint8_t* pPixel = pBitmap->GetPixel8u(x, y);
+            state           = state * 1664525u + 1013904223u;
+            pPixel[0]       = static_cast<uint8_t>(x + (state >> 30));
+            pPixel[1]       = static_cast<uint8_t>(y + (state >> 29));
+            pPixel[2]       = static_cast<uint8_t>(x + y);
+            pPixel[3]       = 255;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    struct Size
+    {
+        const char* name;
+        uint32_t    width;
+        uint32_t    height;
+    };
+    const Size sizes[] = {
+        {"1080p", 1920, 1080},
+        {"4k", 3840, 2160},
+        {"8k", 7680, 4320},
+    };
+
+    struct Config
+    {
+        const char* name;
+        bool        computeSSIM;
+        bool        heatmap;
+        uint32_t    threadCount;
+    };
+    const Config configs[] = {
+        {"errors-1t", false, false, 1},
+        {"ssim-1t", true, false, 1},
+        {"errors", false, false, 0},
+        {"ssim", true, false, 0},
+        {"ssim-heatmap", true, true, 0},
+    };
+
+    printf("%-8s %-14s %-10s %-10s\n", "size", "config", "ms", "MP/s");
+    for (const Size& size : sizes) {
+        Bitmap reference = Bitmap::Create(size.width, size.height, Bitmap::FORMAT_RGBA_UINT8);
+        Bitmap test      = Bitmap::Create(size.width, size.height, Bitmap::FORMAT_RGBA_UINT8);
+        FillBitmap(&reference, 1);
+        FillBitmap(&test, 2);
+
+        for (const Config& config : configs) {
+            ImageDiffOptions options;
+            options.computeSSIM = config.computeSSIM;
+            options.threadCount = config.threadCount;
+
+            double totalMs = 0.0;
+            for (uint32_t i = 0; i < kIterationCount; ++i) {
+                ImageDiffStats stats;
+                Bitmap         heatmap;
+                uint64_t       startTimestamp = 0;
+                uint64_t       endTimestamp   = 0;
+                Timer::Timestamp(&startTimestamp);
+                if (Failed(CompareBitmaps(reference, test, options, &stats, config.heatmap ? &heatmap : nullptr))) {
+                    fprintf(stderr, "failed to compare %s images\n", size.name);
+                    return EXIT_FAILURE;
+                }
+                Timer::Timestamp(&endTimestamp);
+                totalMs += Timer::TimestampToMillis(endTimestamp - startTimestamp);
+            }
+
+            double averageMs  = totalMs / kIterationCount;
+            double megapixels = static_cast<double>(size.width) * size.height / 1e6;
+            printf("%-8s %-14s %-10.2f %-10.1f\n", size.name, config.name, averageMs, megapixels / (averageMs / 1000.0));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the vertex cache efficiency of meshes as generated and after the
+// TriMesh optimizations, along with the time the optimizations take:
+//  - raw:      the triangles in generation order.
+//  - vcache:   TriMeshOptions::OptimizeVertexCache.
+//  - overdraw: TriMeshOptions::OptimizeOverdraw, with the default threshold.
+// ACMR is reported for FIFO caches of 16 and 32 vertices.
+//
+// Usage: mesh_optimize [path]
+// With a path, the OBJ file is measured too.
+
+#include "ppx/config.h"
+#include "ppx/mesh_optimizer.h"
+#include "ppx/timer.h"
+#include "ppx/tri_mesh.h"
+
+#include <cstdio>
+#include <functional>
+
+using namespace ppx;
+
+static const uint32_t kIterationCount = 3;
+
+// Returns the average time in milliseconds to create the mesh.
+static double Measure(const std::function<TriMesh()>& fn, TriMesh* pMesh)
+{
+    double totalMs = 0.0;
+    for (uint32_t i = 0; i < kIterationCount; ++i) {
+        uint64_t startTimestamp = 0;
+        uint64_t endTimestamp   = 0;
+        Timer::Timestamp(&startTimestamp);
+        *pMesh = fn();
+        Timer::Timestamp(&endTimestamp);
+        totalMs += Timer::TimestampToMillis(endTimestamp - startTimestamp);
+    }
+    return totalMs / kIterationCount;
+}
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    struct Source
+    {
+        const char*                                   name;
+        std::function<TriMesh(const TriMeshOptions&)> create;
+    };
+    std::vector<Source> sources = {
+        {"sphere", [](const TriMeshOptions& options) { return TriMesh::CreateSphere(1.0f, 128, 64, options); }},
+        {"plane", [](const TriMeshOptions& options) { return TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 128, 128, options); }},
+    };
+    std::filesystem::path path;
+    if (argc > 1) {
+        path = argv[1];
+        sources.push_back({"obj", [&path](const TriMeshOptions& options) { return TriMesh::CreateFromOBJ(path, options); }});
+    }
+
+    struct Method
+    {
+        const char*    name;
+        TriMeshOptions options;
+    };
+    const TriMeshOptions baseOptions = TriMeshOptions().Indices().TexCoords().Normals();
+    const Method         methods[]   = {
+        {"raw", baseOptions},
+        {"vcache", TriMeshOptions(baseOptions).OptimizeVertexCache()},
+        {"overdraw", TriMeshOptions(baseOptions).OptimizeOverdraw()},
+    };
+
+    printf("%-8s %-10s %-10s %-8s %-8s %-8s %-10s\n", "mesh", "method", "triangles", "acmr16", "acmr32", "atvr16", "ms");
+    for (const Source& source : sources) {
+        for (const Method& method : methods) {
+            TriMesh mesh;
+            double  averageMs = Measure([&source, &method]() { return source.create(method.options); }, &mesh);
+
+            VertexCacheStatistics stats16 = mesh.AnalyzeVertexCache(16);
+            VertexCacheStatistics stats32 = mesh.AnalyzeVertexCache(32);
+            printf("%-8s %-10s %-10u %-8.3f %-8.3f %-8.3f %-10.2f\n", source.name, method.name, mesh.GetCountTriangles(), stats16.acmr, stats32.acmr, stats16.atvr, averageMs);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the throughput of mip chain generation, in MB of source levels
+// read per second:
+//  - stb:      Bitmap::ScaleTo with STBIR_FILTER_BOX, the previous Mipmap path.
+//  - box:      Bitmap::DownsampleTo.
+//  - box-srgb: Bitmap::DownsampleTo, averaging 8-bit colors in linear space.
+
+#include "ppx/bitmap.h"
+#include "ppx/mipmap.h"
+#include "ppx/timer.h"
+
+#include <cstdio>
+#include <functional>
+
+using namespace ppx;
+
+static const uint32_t kIterationCount = 5;
+
+// Returns the average time in milliseconds to generate the mip chain.
+static double Measure(Mipmap* pMipmap, const std::function<Result(const Bitmap&, Bitmap*)>& fn)
+{
+    double totalMs = 0.0;
+    for (uint32_t i = 0; i < kIterationCount; ++i) {
+        uint64_t startTimestamp = 0;
+        uint64_t endTimestamp   = 0;
+        Timer::Timestamp(&startTimestamp);
+        for (uint32_t level = 1; level < pMipmap->GetLevelCount(); ++level) {
+            if (Failed(fn(*pMipmap->GetMip(level - 1), pMipmap->GetMip(level)))) {
+                fprintf(stderr, "failed to generate level %u\n", level);
+                exit(EXIT_FAILURE);
+            }
+        }
+        Timer::Timestamp(&endTimestamp);
+        totalMs += Timer::TimestampToMillis(endTimestamp - startTimestamp);
+    }
+    return totalMs / kIterationCount;
+}
+
+static void FillBitmap(Bitmap* pBitmap)
+{
+    char*    pData = pBitmap->GetData();
+    uint32_t state = 1;
+    for (uint64_t i = 0; i < pBitmap->GetFootprintSize(); ++i) {
+        state    = state * 1664525u + 1013904223u;
+        pData[i] = static_cast<char>(state >> 24);
+    }
+    if (Bitmap::ChannelDataType(pBitmap->GetFormat()) == Bitmap::DATA_TYPE_FLOAT) {
+        float* pFloats = reinterpret_cast<float*>(pData);
+        for (uint64_t i = 0; i < pBitmap->GetFootprintSize() / sizeof(float); ++i) {
+            pFloats[i] = static_cast<float>(i % 1021) / 1020.0f;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    struct Size
+    {
+        uint32_t width;
+        uint32_t height;
+    };
+    const Size sizes[] = {
+        {2048, 2048},
+        {1999, 1001},
+    };
+
+    struct Format
+    {
+        const char*    name;
+        Bitmap::Format format;
+    };
+    const Format formats[] = {
+        {"rgba8", Bitmap::FORMAT_RGBA_UINT8},
+        {"rgba16", Bitmap::FORMAT_RGBA_UINT16},
+        {"rgba32f", Bitmap::FORMAT_RGBA_FLOAT},
+    };
+
+    struct Method
+    {
+        const char*                                   name;
+        bool                                          rgba8Only;
+        std::function<Result(const Bitmap&, Bitmap*)> generate;
+    };
+    const Method methods[] = {
+        {"stb", false, [](const Bitmap& src, Bitmap* pDst) { return src.ScaleTo(pDst, STBIR_FILTER_BOX); }},
+        {"box", false, [](const Bitmap& src, Bitmap* pDst) { return src.DownsampleTo(pDst); }},
+        {"box-srgb", true, [](const Bitmap& src, Bitmap* pDst) { return src.DownsampleTo(pDst, /* srgb= */ true); }},
+    };
+
+    printf("%-10s %-8s %-10s %-10s %-10s\n", "size", "format", "method", "ms", "MB/s");
+    for (const Size& size : sizes) {
+        for (const Format& format : formats) {
+            Mipmap mipmap(size.width, size.height, format.format, PPX_REMAINING_MIP_LEVELS);
+            FillBitmap(mipmap.GetMip(0));
+
+            uint64_t sourceBytes = 0;
+            for (uint32_t level = 0; level + 1 < mipmap.GetLevelCount(); ++level) {
+                sourceBytes += mipmap.GetMip(level)->GetFootprintSize();
+            }
+
+            for (const Method& method : methods) {
+                if (method.rgba8Only && (format.format != Bitmap::FORMAT_RGBA_UINT8)) {
+                    continue;
+                }
+
+                double averageMs = Measure(&mipmap, method.generate);
+                double mbPerSec  = (static_cast<double>(sourceBytes) / (1024.0 * 1024.0)) / (averageMs / 1000.0);
+
+                char sizeName[32] = {};
+                snprintf(sizeName, sizeof(sizeName), "%ux%u", size.width, size.height);
+                printf("%-10s %-8s %-10s %-10.2f %-10.1f\n", sizeName, format.name, method.name, averageMs, mbPerSec);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the time to load an OBJ file:
+//  - parse:   ppx::LoadOBJ with 1, 2, 4, ... threads, up to the hardware concurrency.
+//  - trimesh: TriMesh::CreateFromOBJ, without and with indices (shared vertices).
+// The file is read once beforehand so that the page cache is warm.
+//
+// Usage: obj_load [path]
+// Without a path, a grid of 5M triangles with texture coordinates and
+// normals is generated in the temporary directory.
+
+#include "ppx/config.h"
+#include "ppx/obj_parser.h"
+#include "ppx/timer.h"
+#include "ppx/tri_mesh.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+using namespace ppx;
+
+static const uint32_t kGeneratedGridSize = 1582; // 2 * 1582^2 ~ 5M triangles
+static const uint32_t kIterationCount    = 3;
+
+static bool GenerateGrid(const std::filesystem::path& path, uint32_t size)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    char line[128];
+    for (uint32_t y = 0; y <= size; ++y) {
+        for (uint32_t x = 0; x <= size; ++x) {
+            float u = static_cast<float>(x) / size;
+            float v = static_cast<float>(y) / size;
+            file.write(line, snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", u * 10.0f, v * 10.0f, u * v, u, v));
+        }
+    }
+    file << "vn 0 0 1\n";
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            uint32_t v0 = y * (size + 1) + x + 1;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v1 + size + 1;
+            uint32_t v3 = v0 + size + 1;
+            file.write(line, snprintf(line, sizeof(line), "f %u/%u/1 %u/%u/1 %u/%u/1\nf %u/%u/1 %u/%u/1 %u/%u/1\n", v0, v0, v1, v1, v2, v2, v0, v0, v2, v2, v3, v3));
+        }
+    }
+    return file.good();
+}
+
+// Returns the average time in milliseconds, or a negative value on failure.
+static double Measure(const std::function<bool()>& fn)
+{
+    double totalMs = 0.0;
+    for (uint32_t i = 0; i < kIterationCount; ++i) {
+        uint64_t startTimestamp = 0;
+        uint64_t endTimestamp   = 0;
+        Timer::Timestamp(&startTimestamp);
+        bool success = fn();
+        Timer::Timestamp(&endTimestamp);
+        if (!success) {
+            return -1.0;
+        }
+        totalMs += Timer::TimestampToMillis(endTimestamp - startTimestamp);
+    }
+    return totalMs / kIterationCount;
+}
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::path path;
+    bool                  generated = false;
+    if (argc > 1) {
+        path = argv[1];
+    }
+    else {
+        path      = std::filesystem::temp_directory_path() / "ppx_obj_load_benchmark.obj";
+        generated = true;
+        if (!GenerateGrid(path, kGeneratedGridSize)) {
+            fprintf(stderr, "failed to generate %s\n", path.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    ObjData obj;
+    if (Failed(LoadOBJ(path, &obj))) {
+        fprintf(stderr, "failed to load %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    const uint64_t fileSize = std::filesystem::file_size(path);
+    printf("file: %s (%" PRIu64 " MiB, %u triangles)\n", path.c_str(), fileSize >> 20, obj.GetCountTriangles());
+    printf("%-10s %-8s %-10s %-10s\n", "method", "threads", "ms", "MiB/s");
+
+    uint32_t maxThreadCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    for (uint32_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+        double averageMs = Measure([&path, &obj, threadCount]() { return !Failed(LoadOBJ(path, &obj, threadCount)); });
+        double mibPerSec = static_cast<double>(fileSize >> 20) / (averageMs / 1000.0);
+        printf("%-10s %-8u %-10.2f %-10.1f\n", "parse", threadCount, averageMs, mibPerSec);
+        if (threadCount == maxThreadCount) {
+            break;
+        }
+    }
+
+    struct Method
+    {
+        const char*    name;
+        TriMeshOptions options;
+    };
+    const Method methods[] = {
+        {"trimesh", TriMeshOptions().TexCoords().Normals()},
+        {"indexed", TriMeshOptions().Indices().TexCoords().Normals()},
+    };
+    for (const Method& method : methods) {
+        double averageMs = Measure([&path, &method]() {
+            TriMesh mesh;
+            return !Failed(TriMesh::CreateFromOBJ(path, method.options, &mesh));
+        });
+        double mibPerSec = static_cast<double>(fileSize >> 20) / (averageMs / 1000.0);
+        printf("%-10s %-8s %-10.2f %-10.1f\n", method.name, "auto", averageMs, mibPerSec);
+    }
+
+    if (generated) {
+        std::filesystem::remove(path);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Creates and destroys objects the way grfx::Device does, with the vector
+// and linear search it used to store objects and with the slot map
+// registry it uses now. Each cycle creates one object and destroys a random
+// live one, so the number of live objects stays constant. The objects are
+// stubs without an API object, which isolates the cost of the bookkeeping.
+
+#include "ppx/obj_ptr.h"
+#include "ppx/slot_map.h"
+#include "ppx/timer.h"
+#include "ppx/util.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace ppx;
+
+static const uint32_t kCycleCount = 100000;
+
+struct StubObject
+{
+    SlotHandle registryHandle;
+    uint64_t   payload = 0;
+};
+
+class VectorRegistry
+{
+public:
+    StubObject* Create()
+    {
+        StubObject* pObject = new StubObject();
+        mObjects.push_back(ObjPtr<StubObject>(pObject));
+        return pObject;
+    }
+
+    void Destroy(const StubObject* pObject)
+    {
+        auto it = std::find_if(
+            std::begin(mObjects),
+            std::end(mObjects),
+            [pObject](const ObjPtr<StubObject>& elem) -> bool { return elem.Get() == pObject; });
+        if (it == std::end(mObjects)) {
+            return;
+        }
+        ObjPtr<StubObject> object = *it;
+        RemoveElement(object, mObjects);
+        delete object.Get();
+    }
+
+    void DestroyAll()
+    {
+        for (ObjPtr<StubObject>& object : mObjects) {
+            delete object.Get();
+        }
+        mObjects.clear();
+    }
+
+private:
+    std::vector<ObjPtr<StubObject>> mObjects;
+};
+
+class SlotMapRegistry
+{
+public:
+    StubObject* Create()
+    {
+        StubObject* pObject     = new StubObject();
+        pObject->registryHandle = mObjects.Insert(ObjPtr<StubObject>(pObject));
+        return pObject;
+    }
+
+    void Destroy(const StubObject* pObject)
+    {
+        const ObjPtr<StubObject>* pElem = mObjects.Get(pObject->registryHandle);
+        if (IsNull(pElem) || (pElem->Get() != pObject)) {
+            return;
+        }
+        StubObject* ptr = pElem->Get();
+        mObjects.Remove(pObject->registryHandle);
+        delete ptr;
+    }
+
+    void DestroyAll()
+    {
+        mObjects.ForEach([](ObjPtr<StubObject>& object) { delete object.Get(); });
+        mObjects.Clear();
+    }
+
+private:
+    SlotMap<ObjPtr<StubObject>> mObjects;
+};
+
+// Returns the duration of the cycles in milliseconds.
+template <typename RegistryT>
+double RunChurn(uint32_t liveCount)
+{
+    RegistryT                registry;
+    std::vector<StubObject*> live(liveCount);
+    for (StubObject*& pObject : live) {
+        pObject = registry.Create();
+    }
+
+    uint32_t state          = 1;
+    uint64_t startTimestamp = 0;
+    uint64_t endTimestamp   = 0;
+    Timer::Timestamp(&startTimestamp);
+    for (uint32_t i = 0; i < kCycleCount; ++i) {
+        state                = state * 1664525u + 1013904223u;
+        const uint32_t index = (state >> 8) % liveCount;
+        registry.Destroy(live[index]);
+        live[index] = registry.Create();
+    }
+    Timer::Timestamp(&endTimestamp);
+
+    registry.DestroyAll();
+    return Timer::TimestampToMillis(endTimestamp - startTimestamp);
+}
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t liveCounts[] = {16, 256, 4096, 16384};
+
+    printf("%-8s %-12s %-12s %-8s\n", "live", "vector (ms)", "slotmap (ms)", "speedup");
+    for (uint32_t liveCount : liveCounts) {
+        const double vectorMs  = RunChurn<VectorRegistry>(liveCount);
+        const double slotMapMs = RunChurn<SlotMapRegistry>(liveCount);
+        printf("%-8u %-12.2f %-12.2f %-8.1f\n", liveCount, vectorMs, slotMapMs, vectorMs / slotMapMs);
+    }
+
+    return EXIT_SUCCESS;
+}
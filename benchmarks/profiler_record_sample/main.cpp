@@ -0,0 +1,87 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the CPU cost of Profiler::RecordSample() as the number of
+// registered events grows. Samples are recorded round-robin over all
+// registered tokens, which is the access pattern of the grfx API wrappers.
+
+#include "ppx/config.h"
+#include "ppx/profiler.h"
+#include "ppx/timer.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+using namespace ppx;
+
+static const uint32_t kEventCounts[] = {1, 4, 16, 32, 64, 128, 256, 512};
+static const uint32_t kSampleCount   = 1 << 22;
+
+int main(int argc, char** argv)
+{
+    if (Timer::InitializeStaticData() != TIMER_RESULT_SUCCESS) {
+        fprintf(stderr, "failed to initialize timer\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-8s %-12s %-10s\n", "events", "samples", "ns/sample");
+
+    for (uint32_t eventCount : kEventCounts) {
+        Profiler::ReinitializeGlobalVariables();
+
+        std::vector<ProfilerEventToken> tokens(eventCount);
+        for (uint32_t i = 0; i < eventCount; ++i) {
+            std::string name   = "event_" + std::to_string(i);
+            Result      ppxres = Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, name, PROFILER_EVENT_RECORD_ACTION_AVERAGE, &tokens[i]);
+            if (Failed(ppxres)) {
+                fprintf(stderr, "failed to register event %s\n", name.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+
+        Profiler* pProfiler = Profiler::GetProfilerForThread();
+        if (IsNull(pProfiler)) {
+            fprintf(stderr, "no profiler available for thread\n");
+            return EXIT_FAILURE;
+        }
+
+        ProfilerEventSample sample = {};
+        sample.endTimestamp        = 1;
+
+        uint64_t startTimestamp = 0;
+        uint64_t endTimestamp   = 0;
+        Timer::Timestamp(&startTimestamp);
+        for (uint32_t i = 0; i < kSampleCount; ++i) {
+            pProfiler->RecordSample(tokens[i % eventCount], sample);
+        }
+        Timer::Timestamp(&endTimestamp);
+
+        // Make sure the samples were actually recorded.
+        uint64_t recorded = 0;
+        for (const ProfilerEvent& event : pProfiler->GetEvents()) {
+            recorded += event.GetSampleCount();
+        }
+        if (recorded != kSampleCount) {
+            fprintf(stderr, "expected %u samples, recorded %" PRIu64 "\n", kSampleCount, recorded);
+            return EXIT_FAILURE;
+        }
+
+        double nanosPerSample = Timer::TimestampToNanos(endTimestamp - startTimestamp) / static_cast<double>(kSampleCount);
+        printf("%-8u %-12u %-10.2f\n", eventCount, kSampleCount, nanosPerSample);
+    }
+
+    Profiler::ReinitializeGlobalVariables();
+
+    return EXIT_SUCCESS;
+}
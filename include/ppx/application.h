@@ -22,6 +22,8 @@
 #include "ppx/knob.h"
 #include "ppx/math_config.h"
 #include "ppx/metrics.h"
+#include "ppx/profiler.h"
+#include "ppx/screenshot_capture.h"
 #include "ppx/timer.h"
 #include "ppx/window.h"
 #include "ppx/xr_component.h"
@@ -235,16 +237,24 @@ struct StandardOptions
     std::shared_ptr<KnobFlag<bool>> pDeterministic;
     std::shared_ptr<KnobFlag<bool>> pEnableMetrics;
     std::shared_ptr<KnobFlag<bool>> pOverwriteMetricsFile;
+    std::shared_ptr<KnobFlag<bool>> pMetricsStreamingGauges;
+    std::shared_ptr<KnobFlag<bool>> pMetricsKeepTimeSeries;
 
     // Options
     std::shared_ptr<KnobFlag<uint32_t>> pGpuIndex;
     std::shared_ptr<KnobFlag<uint64_t>> pFrameCount;
     std::shared_ptr<KnobFlag<uint32_t>> pRunTimeMs;
     std::shared_ptr<KnobFlag<int>>      pStatsFrameWindow;
+    std::shared_ptr<KnobFlag<int>>      pScreenshotFrameInterval;
     std::shared_ptr<KnobFlag<int>>      pScreenshotFrameNumber;
 
     std::shared_ptr<KnobFlag<std::string>> pScreenshotPath;
+    std::shared_ptr<KnobFlag<std::string>> pMeshCacheDir;
+    std::shared_ptr<KnobFlag<std::string>> pMetricsBinaryFilename;
     std::shared_ptr<KnobFlag<std::string>> pMetricsFilename;
+    std::shared_ptr<KnobFlag<std::string>> pPipelineCacheDir;
+    std::shared_ptr<KnobFlag<std::string>> pProfilerTraceFilename;
+    std::shared_ptr<KnobFlag<std::string>> pTextureCacheDir;
 
     std::shared_ptr<KnobFlag<std::pair<int, int>>> pResolution;
 #if defined(PPX_BUILD_XR)
@@ -358,15 +368,23 @@ struct ApplicationSettings
 #if !defined(PPX_LINUX_HEADLESS)
         bool headless = false;
 #endif
-        bool                listGpus              = false;
-        std::string         metricsFilename       = "report_@.json";
-        bool                overwriteMetricsFile  = false;
-        std::pair<int, int> resolution            = std::make_pair(0, 0);
-        uint32_t            runTimeMs             = 0;
-        int                 screenshotFrameNumber = -1;
-        std::string         screenshotPath        = "screenshot_frame_#.ppm";
-        int                 statsFrameWindow      = -1;
-        bool                useSoftwareRenderer   = false;
+        bool                listGpus                = false;
+        std::string         meshCacheDir            = "mesh_cache";
+        std::string         metricsBinaryFilename   = "";
+        std::string         metricsFilename         = "report_@.json";
+        bool                metricsKeepTimeSeries   = false;
+        bool                metricsStreamingGauges  = false;
+        bool                overwriteMetricsFile    = false;
+        std::string         pipelineCacheDir        = "pipeline_cache";
+        std::string         profilerTraceFilename   = "";
+        std::pair<int, int> resolution              = std::make_pair(0, 0);
+        uint32_t            runTimeMs               = 0;
+        int                 screenshotFrameInterval = 0;
+        int                 screenshotFrameNumber   = -1;
+        std::string         screenshotPath          = "screenshot_frame_#.ppm";
+        int                 statsFrameWindow        = -1;
+        std::string         textureCacheDir         = "texture_cache";
+        bool                useSoftwareRenderer     = false;
 #if defined(PPX_BUILD_XR)
         std::pair<int, int>      xrUiResolution       = std::make_pair(0, 0);
         std::vector<std::string> xrRequiredExtensions = {};
@@ -531,6 +549,12 @@ public:
     // See StartMetricsRun for why this wrapper is necessary.
     virtual bool RecordMetricData(metrics::MetricID id, const metrics::MetricData& data);
 
+    // Same as RecordMetricData, but may be called from any thread without locking.
+    // The data is applied to the run once per frame, after UpdateMetrics, and when
+    // the report is created.
+    // See StartMetricsRun for why this wrapper is necessary.
+    virtual bool RecordMetricDataConcurrent(metrics::MetricID id, const metrics::MetricData& data);
+
 #if defined(PPX_BUILD_XR)
     XrComponent& GetXrComponent()
     {
@@ -585,6 +609,25 @@ private:
     void UpdateAppMetrics();
     // Saves the metrics data to a file on disk.
     void SaveMetricsReportToDisk();
+    // Starts streaming the metrics to a binary report, if requested.
+    void StartBinaryMetricsReport();
+
+    // Sets the directory where meshes loaded from files are cached.
+    void InitMeshCache();
+    // Sets the directory where textures loaded from files are cached.
+    void InitTextureCache();
+
+    // Returns the file of the pipeline cache of the application, or an empty
+    // path if --pipeline-cache-dir is empty.
+    std::filesystem::path GetPipelineCachePath() const;
+
+    // Records the time taken by startup and pipeline creation, and whether
+    // the pipeline cache was warm.
+    void RecordStartupMetrics();
+
+    // Streams CPU profiler samples to the file set with --profiler-trace-filename.
+    void StartProfilerTraceCapture();
+    void StopProfilerTraceCapture();
 
     // Initializes standard knobs
     void InitStandardKnobs();
@@ -653,6 +696,12 @@ private:
     double            mFirstFrameTime    = 0;
     std::deque<float> mFrameTimesMs;
 
+    // Scoped around each frame so that traces show per-frame CPU timelines.
+    ProfilerEventToken mFrameProfilerEventToken = kInvalidProfilerEventToken;
+
+    // Copies and writes screenshots without stalling the frame loop.
+    ScreenshotCapture mScreenshotCapture;
+
     // Metrics
     struct
     {
@@ -664,6 +713,7 @@ private:
         double   framerateRecordTimer   = 0.0;
         uint64_t framerateFrameCount    = 0;
         bool     resetFramerateTracking = true;
+        uint64_t startupTimestamp       = 0;
     } mMetrics;
 
 #if defined(PPX_MSW)
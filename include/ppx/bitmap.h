@@ -24,6 +24,8 @@
 
 namespace ppx {
 
+class BitmapSink;
+
 //! @class Bitmap
 //!
 //!
@@ -95,7 +97,23 @@ public:
 
     Result Resize(uint32_t width, uint32_t height);
     Result ScaleTo(Bitmap* pTargetBitmap) const;
-    Result ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType) const;
+    //! Resizes into \b pTargetBitmap, which must have the same format. Large targets
+    //! are split into bands of rows that are resized in parallel on \b threadCount
+    //! threads, 0 picks a count from the target size and 1 resizes on the calling
+    //! thread. Bands use the same filter weights as a single resize.
+    Result ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType, uint32_t threadCount = 0) const;
+    //! Downsamples to half the width and height with a 2x2 box filter, rounding down
+    //! sizes and clamping them to 1. When a dimension is odd, the last pixel of each
+    //! row or column averages 3 source pixels so that none is dropped. If \b srgb is
+    //! true, 8-bit color channels are averaged in linear space.
+    Result DownsampleTo(Bitmap* pTargetBitmap, bool srgb = false) const;
+    //! Converts to \b format, which may have a different channel type or count.
+    //! Integer channels are normalized and float channels are clamped to [0, 1]
+    //! when converted to integers. Missing color channels are 0, missing alpha is
+    //! opaque and extra channels are dropped. 32-bit integer formats are not
+    //! supported. \b pTargetBitmap is reused if it already has the right size and
+    //! format, and is recreated otherwise.
+    Result ConvertTo(Bitmap::Format format, Bitmap* pTargetBitmap) const;
 
     template <typename PixelDataType>
     void Fill(PixelDataType r, PixelDataType g, PixelDataType b, PixelDataType a);
@@ -130,6 +148,16 @@ public:
 
     static Result LoadFromMemory(const size_t dataSize, const void* pData, Bitmap* pBitmap);
 
+    static constexpr uint32_t kDefaultStreamBandHeight = 64;
+
+    //! Decodes an image file into \b pSink in bands of \b bandHeight rows, with the
+    //! same pixels and format as LoadFile. PNG and Radiance HDR images are decoded
+    //! incrementally, so only one band and a few rows are held in memory at a time.
+    //! Other formats and interlaced PNGs are fully decoded first, then handed out in
+    //! bands of the decoded image.
+    static Result StreamFile(const std::filesystem::path& path, BitmapSink* pSink, uint32_t bandHeight = kDefaultStreamBandHeight);
+    static Result StreamFromMemory(const size_t dataSize, const void* pData, BitmapSink* pSink, uint32_t bandHeight = kDefaultStreamBandHeight);
+
     // ---------------------------------------------------------------------------------------------
 
     class PixelIterator
@@ -240,6 +268,25 @@ void Bitmap::Fill(PixelDataType r, PixelDataType g, PixelDataType b, PixelDataTy
     }
 }
 
+//! @class BitmapSink
+//!
+//! Receives an image decoded by Bitmap::StreamFile or Bitmap::StreamFromMemory,
+//! e.g. to write it to a mapped staging buffer as it is decoded.
+//!
+class BitmapSink
+{
+public:
+    virtual ~BitmapSink() {}
+
+    //! Called once before the first band. A failure stops the decode and is
+    //! returned by the stream function.
+    virtual Result Begin(uint32_t width, uint32_t height, Bitmap::Format format) = 0;
+
+    //! Called for the rows [firstRow, firstRow + band.GetHeight()), in order.
+    //! The band is only valid for the duration of the call.
+    virtual Result WriteBand(uint32_t firstRow, const Bitmap& band) = 0;
+};
+
 } // namespace ppx
 
 #endif // ppx_bitmap_h
@@ -0,0 +1,195 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_bitmap_atlas_h
+#define ppx_bitmap_atlas_h
+
+#include "ppx/bitmap.h"
+
+#include <vector>
+
+namespace ppx {
+
+//! @struct AtlasRect
+//!
+//! Rectangle in pixels.
+//!
+struct AtlasRect
+{
+    uint32_t x      = 0;
+    uint32_t y      = 0;
+    uint32_t width  = 0;
+    uint32_t height = 0;
+};
+
+//! @struct AtlasUVRect
+//!
+//! Normalized texture coordinates of the edges of an atlas entry.
+//!
+struct AtlasUVRect
+{
+    float u0 = 0;
+    float v0 = 0;
+    float u1 = 0;
+    float v1 = 0;
+};
+
+enum AtlasPackMethod
+{
+    //! Places each rectangle as low as possible on a skyline of the packed
+    //! rectangles. Fastest, but the space under the skyline is lost.
+    ATLAS_PACK_METHOD_SKYLINE = 0,
+
+    //! Tracks every maximal free rectangle and uses the one that leaves the
+    //! shortest side (best short side fit). Packs tighter, especially when
+    //! sizes vary a lot, at a higher insertion cost.
+    ATLAS_PACK_METHOD_MAX_RECTS = 1,
+};
+
+//! @class AtlasPacker
+//!
+//! Packs rectangles into a fixed-size area, one at a time. Rectangles are
+//! never moved once placed, so the packer can be used incrementally.
+//!
+class AtlasPacker
+{
+public:
+    AtlasPacker() {}
+    AtlasPacker(uint32_t width, uint32_t height, AtlasPackMethod method = ATLAS_PACK_METHOD_MAX_RECTS);
+
+    //! Changes the size and method, and removes every rectangle.
+    void Reset(uint32_t width, uint32_t height, AtlasPackMethod method);
+
+    //! Removes every rectangle.
+    void Clear();
+
+    //! Finds room for a \b width x \b height rectangle. Returns false if
+    //! there is none, or if either dimension is 0.
+    bool Insert(uint32_t width, uint32_t height, AtlasRect* pRect);
+
+    uint32_t        GetWidth() const { return mWidth; }
+    uint32_t        GetHeight() const { return mHeight; }
+    AtlasPackMethod GetMethod() const { return mMethod; }
+    uint32_t        GetRectCount() const { return mRectCount; }
+    uint64_t        GetUsedArea() const { return mUsedArea; }
+
+    //! Returns the fraction of the area covered by rectangles.
+    float GetOccupancy() const;
+
+private:
+    bool InsertSkyline(uint32_t width, uint32_t height, AtlasRect* pRect);
+    bool InsertMaxRects(uint32_t width, uint32_t height, AtlasRect* pRect);
+    void SplitFreeRects(const AtlasRect& used);
+    void PruneFreeRects();
+
+private:
+    struct SkylineSegment
+    {
+        uint32_t x     = 0;
+        uint32_t y     = 0;
+        uint32_t width = 0;
+    };
+
+    uint32_t                    mWidth     = 0;
+    uint32_t                    mHeight    = 0;
+    AtlasPackMethod             mMethod    = ATLAS_PACK_METHOD_MAX_RECTS;
+    uint32_t                    mRectCount = 0;
+    uint64_t                    mUsedArea  = 0;
+    std::vector<SkylineSegment> mSkyline;
+    std::vector<AtlasRect>      mFreeRects;
+    std::vector<AtlasRect>      mNewFreeRects;
+};
+
+//! @struct BitmapAtlasCreateInfo
+//!
+//! Size, format and layout of a BitmapAtlas.
+//!
+struct BitmapAtlasCreateInfo
+{
+    uint32_t        width        = 1024;
+    uint32_t        height       = 1024;
+    Bitmap::Format  format       = Bitmap::FORMAT_RGBA_UINT8;
+    uint32_t        padding      = 1;     // Gutter pixels on each side of every entry
+    uint32_t        alignment    = 1;     // Entries and gutters start on multiples of this, must be a power of two
+    bool            extrudeEdges = false; // Fill the gutters of inserted bitmaps with their edge pixels
+    AtlasPackMethod method       = ATLAS_PACK_METHOD_MAX_RECTS;
+};
+
+//! @struct AtlasEntry
+//!
+//! Location of an entry in the atlas, without its gutter.
+//!
+struct AtlasEntry
+{
+    AtlasRect   rect;
+    AtlasUVRect uvRect;
+};
+
+//! @class BitmapAtlas
+//!
+//! Packs bitmaps into a single bitmap, so that they can share one texture.
+//!
+//! Every entry is surrounded by a gutter of \b padding pixels so that
+//! bilinear filtering does not bleed between entries. With an \b alignment
+//! of 2^n, no texel of the first n mip levels mixes two entries, and a
+//! padding of 2^n keeps filtering at those levels within the gutter. Gutters
+//! are zero, or copies of the edge pixels of inserted bitmaps if
+//! \b extrudeEdges is set.
+//!
+//! The atlas tracks the area written since the last call to TakeDirtyRect,
+//! so that only that part needs to be uploaded again.
+//!
+class BitmapAtlas
+{
+public:
+    BitmapAtlas() {}
+
+    static Result Create(const BitmapAtlasCreateInfo& createInfo, BitmapAtlas* pAtlas);
+
+    //! Removes every entry and clears the bitmap.
+    void Clear();
+
+    //! Copies \b bitmap into the atlas, converting it to the atlas format if
+    //! needed. Returns ERROR_LIMIT_EXCEEDED if there is no room for it.
+    Result Insert(const Bitmap& bitmap, AtlasEntry* pEntry);
+
+    //! Reserves a \b width x \b height entry for the caller to write into,
+    //! e.g. with GetBitmap()->GetPixelAddress(rect.x, rect.y). Its gutter is
+    //! left zero. Returns ERROR_LIMIT_EXCEEDED if there is no room for it.
+    Result Allocate(uint32_t width, uint32_t height, AtlasEntry* pEntry);
+
+    //! Returns false if nothing was written since the last call. Otherwise
+    //! sets \b pRect to the bounds of the entries written since then.
+    bool TakeDirtyRect(AtlasRect* pRect);
+
+    const BitmapAtlasCreateInfo& GetCreateInfo() const { return mCreateInfo; }
+    const AtlasPacker&           GetPacker() const { return mPacker; }
+    const Bitmap&                GetBitmap() const { return mBitmap; }
+    Bitmap*                      GetBitmap() { return &mBitmap; }
+
+private:
+    void ExtrudeEdges(const AtlasRect& rect);
+    void AddDirtyRect(const AtlasRect& rect);
+
+private:
+    BitmapAtlasCreateInfo mCreateInfo = {};
+    AtlasPacker           mPacker;
+    Bitmap                mBitmap;
+    bool                  mHasDirtyRect = false;
+    AtlasRect             mDirtyRect    = {};
+};
+
+} // namespace ppx
+
+#endif // ppx_bitmap_atlas_h
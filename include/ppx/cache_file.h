@@ -0,0 +1,86 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_cache_file_h
+#define ppx_cache_file_h
+
+#include "ppx/config.h"
+#include "ppx/fs.h"
+
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace ppx {
+
+//! @class CacheFile
+//!
+//! Base of the binary caches that are read from a memory-mapped file, such as
+//! MeshCacheFile and TextureCacheFile. All values are little-endian, and every
+//! file starts with:
+//!
+//!   char[4] magic, uint32 version, uint32 headerSize, header
+//!
+//! The header starts with the key the file was written for, followed by the
+//! layout of the data of the file. A file fails to open if it is corrupt, has
+//! another version, or was written for another key.
+//!
+//! Files are written next to their final path under a name that no other
+//! writer uses, then renamed, so readers never see a partial file and
+//! concurrent writers of the same path do not collide.
+//!
+class CacheFile
+{
+public:
+    bool IsOpen() const { return mView.has_value(); }
+
+protected:
+    CacheFile() {}
+    ~CacheFile() {}
+
+    //! Writes the magic, version and header to path, then the rest of the file
+    //! with writeData. Stream positions are relative to the start of the file.
+    static Result WriteFile(
+        const std::filesystem::path&              path,
+        const char*                               pMagic,
+        uint32_t                                  version,
+        const std::vector<uint8_t>&               header,
+        const std::function<void(std::ostream&)>& writeData);
+
+    //! Maps path if it has the magic and version, and its header starts with
+    //! key. On success, pHeaderOffset is the offset of the header data that
+    //! follows the key.
+    Result MapFile(
+        const std::filesystem::path& path,
+        const char*                  pMagic,
+        uint32_t                     version,
+        const std::vector<uint8_t>&  key,
+        size_t*                      pHeaderOffset);
+
+    //! Returns the offset of the data that follows a header of headerSize bytes.
+    static size_t GetDataOffset(size_t headerSize);
+
+    void Unmap() { mView.reset(); }
+
+    const char* GetFileData() const { return mView->GetData(); }
+    size_t      GetFileSize() const { return mView->GetSize(); }
+
+private:
+    std::optional<fs::FileView> mView;
+};
+
+} // namespace ppx
+
+#endif // ppx_cache_file_h
@@ -0,0 +1,147 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_compressed_image_h
+#define ppx_compressed_image_h
+
+#include "ppx/bitmap.h"
+#include "ppx/mipmap.h"
+
+#include <filesystem>
+
+namespace ppx {
+
+//! @class CompressedImage
+//!
+//! Mip chain of a block-compressed 2D image, encoded on the CPU from a Bitmap
+//! or a Mipmap. Each level is stored as rows of 4x4 blocks, in the layout
+//! expected by the GPU. Levels that are not a multiple of 4 are padded by
+//! repeating their last row and column.
+//!
+//! Encoded channels by format:
+//!   - BC1: RGB, alpha is dropped.
+//!   - BC3: RGBA, color as BC1 and alpha as BC4.
+//!   - BC4: R.
+//!   - BC5: RG, as two BC4 blocks.
+//!   - BC7: RGBA, with mode 6 blocks (one subset, 7-bit endpoints and p-bits,
+//!          4-bit indices).
+//!
+//! Blocks are encoded in parallel on large levels.
+//!
+class CompressedImage
+{
+public:
+    enum Format
+    {
+        FORMAT_UNDEFINED = 0,
+        FORMAT_BC1,
+        FORMAT_BC3,
+        FORMAT_BC4,
+        FORMAT_BC5,
+        FORMAT_BC7,
+    };
+
+    //! Encoder presets, from fastest to highest quality:
+    //!   - FAST:   endpoints from the bounding box of the block.
+    //!   - NORMAL: endpoints along the principal axis of the block, refined once
+    //!             with a least squares fit.
+    //!   - HIGH:   NORMAL with more refinement, and a search around the quantized
+    //!             endpoints.
+    enum Quality
+    {
+        QUALITY_FAST = 0,
+        QUALITY_NORMAL,
+        QUALITY_HIGH,
+    };
+
+    static constexpr uint32_t kBlockDimension = 4;
+
+    CompressedImage() {}
+    ~CompressedImage() {}
+
+    //! Returns the size of a 4x4 block in bytes, or 0 for FORMAT_UNDEFINED.
+    static uint32_t    GetBlockSize(CompressedImage::Format format);
+    static const char* ToString(CompressedImage::Format format);
+
+    //! Encodes levels [0, levelCount) of mipmap. Levels that are not RGBA8 are
+    //! converted with Bitmap::ConvertTo first. threadCount is as for
+    //! Bitmap::ScaleTo: 0 picks a count from the level size.
+    static Result Encode(
+        const Mipmap&            mipmap,
+        CompressedImage::Format  format,
+        CompressedImage::Quality quality,
+        CompressedImage*         pImage,
+        uint32_t                 levelCount  = PPX_REMAINING_MIP_LEVELS,
+        uint32_t                 threadCount = 0);
+
+    //! Encodes a single level image.
+    static Result Encode(
+        const Bitmap&            bitmap,
+        CompressedImage::Format  format,
+        CompressedImage::Quality quality,
+        CompressedImage*         pImage,
+        uint32_t                 threadCount = 0);
+
+    //! Decodes a level to an RGBA8 bitmap. Channels that the format does not
+    //! store are 0, or 255 for alpha. Only the BC7 modes written by Encode are
+    //! supported.
+    Result Decode(uint32_t level, Bitmap* pBitmap) const;
+
+    //! Computes the peak signal-to-noise ratio in dB of a decoded level against
+    //! source, over the channels stored by the format. source must have the
+    //! size of the level and is converted to RGBA8 if needed. Identical images
+    //! give infinity.
+    Result ComputePSNR(uint32_t level, const Bitmap& source, double* pPSNR) const;
+
+    //! Writes a DDS file with a DX10 header. The file is written next to its
+    //! final path then renamed, so readers never see a partial file.
+    Result SaveDDS(const std::filesystem::path& path) const;
+
+    //! Loads a 2D DDS file in one of the supported formats, with a DX10 header
+    //! or a DXT1, DXT5, ATI1, BC4U, ATI2 or BC5U four character code.
+    static Result LoadDDS(const std::filesystem::path& path, CompressedImage* pImage);
+
+    bool                    IsOk() const { return (mFormat != FORMAT_UNDEFINED) && !mLevels.empty(); }
+    CompressedImage::Format GetFormat() const { return mFormat; }
+    uint32_t                GetLevelCount() const { return CountU32(mLevels); }
+    uint32_t                GetWidth(uint32_t level) const { return mLevels[level].width; }
+    uint32_t                GetHeight(uint32_t level) const { return mLevels[level].height; }
+    //! Row stride of a level in bytes, for one row of blocks.
+    uint32_t                GetRowStride(uint32_t level) const;
+    const char*             GetLevelData(uint32_t level) const { return mData.data() + mLevels[level].offset; }
+    uint64_t                GetLevelSize(uint32_t level) const { return mLevels[level].size; }
+    uint64_t                GetDataSize() const { return mData.size(); }
+
+private:
+    struct Level
+    {
+        uint32_t width  = 0;
+        uint32_t height = 0;
+        uint64_t offset = 0;
+        uint64_t size   = 0;
+    };
+
+    // Computes the offset and size of each level from its width and height,
+    // and resizes mData to hold them.
+    void AllocateLevels();
+
+private:
+    CompressedImage::Format mFormat = FORMAT_UNDEFINED;
+    std::vector<Level>      mLevels;
+    std::vector<char>       mData;
+};
+
+} // namespace ppx
+
+#endif // ppx_compressed_image_h
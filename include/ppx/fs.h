@@ -31,6 +31,7 @@
 #ifndef ppx_fs_h
 #define ppx_fs_h
 
+#include <memory>
 #include <optional>
 #include <vector>
 #include <filesystem>
@@ -60,9 +61,23 @@ class File
         STREAM_HANDLE = 1,
         // The file is accessible through an Android asset handle.
         ASSET_HANDLE = 2,
+        // The file is memory-mapped from a file descriptor.
+        MAPPED_HANDLE = 3,
     };
 
 public:
+    // How the content of the file is expected to be accessed.
+    // Only a hint for the OS when the file is memory-mapped.
+    enum AccessPattern
+    {
+        // No specific pattern.
+        ACCESS_PATTERN_NORMAL = 0,
+        // The whole file is read once from start to end. The OS reads ahead aggressively.
+        ACCESS_PATTERN_SEQUENTIAL = 1,
+        // Small reads at arbitrary offsets. The OS does not read ahead.
+        ACCESS_PATTERN_RANDOM = 2,
+    };
+
     File();
     File(const File& other)  = delete;
     File(const File&& other) = delete;
@@ -70,14 +85,17 @@ public:
 
     // Opens a file given a specific path.
     // path: the path of the file to open.
-    //  - On desktop, loads the regular file at `path`. (memory-mapping availability is implementation defined).
+    // accessPattern: how the file is expected to be read, see `AccessPattern`.
+    //  - On Linux, non-empty regular files are memory mapped.
+    //  - On Windows, loads the regular file at `path` through a stream.
     //  - On Android, relative path are assumed to be loaded from the APK, those are memory mapped.
-    //                absolute path are loaded as regular files (mapping availability is implementation defined).
+    //                absolute path are loaded as regular files, memory mapped if non-empty.
     //
     // - This API only supports regular files.
     // - This API expects the file not to change size or content while this handle is open.
+    //   This matters even more for mapped files: truncating a mapped file makes reads fault.
     // - This class supports RAII. File will be closed on destroy.
-    bool Open(const std::filesystem::path& path);
+    bool Open(const std::filesystem::path& path, AccessPattern accessPattern = ACCESS_PATTERN_NORMAL);
 
     // Reads `size` bytes from the file into `buffer`.
     // buffer: a pointer to a buffer with at least `count` writable bytes.
@@ -103,21 +121,53 @@ private:
     typedef void AAsset;
 #endif
 
+    // Tries to memory-map the file. Returns false if the file cannot be
+    // mapped, in which case it must be opened through another handle type.
+    bool OpenMapped(const std::filesystem::path& path, AccessPattern accessPattern);
+
     FileHandleType mHandleType = BAD_HANDLE;
     AAsset*        mAsset      = nullptr;
     const void*    mBuffer     = nullptr;
+    int            mDescriptor = -1;
     std::ifstream  mStream;
     size_t         mFileSize   = 0;
     size_t         mFileOffset = 0;
 };
 
+// Read-only view of the whole content of a file.
+// When the file can be memory-mapped, the view borrows the mapping and the
+// content is never copied. Otherwise it is loaded into a buffer owned by the view.
+// The data stays valid for the lifetime of the view.
+class FileView
+{
+public:
+    FileView()                      = default;
+    FileView(FileView&&)            = default;
+    FileView& operator=(FileView&&) = default;
+
+    const char* GetData() const { return mData; }
+    size_t      GetSize() const { return mSize; }
+    // Returns true if the data is borrowed from a memory-mapped file.
+    bool IsMapped() const { return mFile != nullptr; }
+
+private:
+    friend std::optional<FileView> load_file_view(const std::filesystem::path& path, File::AccessPattern accessPattern);
+
+    std::unique_ptr<File> mFile;
+    std::vector<char>     mBuffer;
+    const char*           mData = nullptr;
+    size_t                mSize = 0;
+};
+
+// Read-only stream over the content of a file, e.g. for parsers taking an std::istream.
+// The content is not copied when the file can be memory-mapped.
 class FileStream : public std::streambuf
 {
 public:
     bool Open(const char* path);
 
 private:
-    std::vector<char> mBuffer;
+    FileView mView;
 };
 
 // Opens a regular file and returns its content if the read succeeded.
@@ -127,6 +177,12 @@ private:
 //  - android: relative paths are assumed to be in APK's storage (Asset API). Absolute are loaded from disk.
 std::optional<std::vector<char>> load_file(const std::filesystem::path& path);
 
+// Same as `load_file`, but returns a view of the content instead of a copy when
+// the file can be memory-mapped. Prefer it when the content only needs to be
+// read while the returned view is alive.
+// `accessPattern`: how the content is going to be read, see `File::AccessPattern`.
+std::optional<FileView> load_file_view(const std::filesystem::path& path, File::AccessPattern accessPattern = File::ACCESS_PATTERN_SEQUENTIAL);
+
 // Returns true if a given path exists (file or directory).
 // `path`: the path to check.
 // The path is handled differently depending on the platform:
@@ -15,6 +15,7 @@
 #ifndef ppx_geometry_h
 #define ppx_geometry_h
 
+#include "ppx/meshlet.h"
 #include "ppx/tri_mesh.h"
 #include "ppx/wire_mesh.h"
 #include "ppx/grfx/grfx_config.h"
@@ -118,8 +119,9 @@ class Geometry
     friend class VertexDataProcessorBase;
     enum BufferType
     {
-        BUFFER_TYPE_VERTEX = 1,
-        BUFFER_TYPE_INDEX  = 2,
+        BUFFER_TYPE_VERTEX  = 1,
+        BUFFER_TYPE_INDEX   = 2,
+        BUFFER_TYPE_MESHLET = 3,
     };
 
 public:
@@ -224,6 +226,10 @@ public:
     static Result Create(const TriMesh& mesh, Geometry* pGeometry);
     static Result Create(const WireMesh& mesh, Geometry* pGeometry);
 
+    // Create object with a create info derived from mesh, along with the
+    // meshlet buffers of meshletData, which must have been built from mesh
+    static Result Create(const TriMesh& mesh, const MeshletData& meshletData, Geometry* pGeometry);
+
     grfx::IndexType         GetIndexType() const { return mCreateInfo.indexType; }
     const Geometry::Buffer* GetIndexBuffer() const { return &mIndexBuffer; }
     void                    SetIndexBuffer(const Geometry::Buffer& newIndexBuffer);
@@ -239,6 +245,17 @@ public:
     Geometry::Buffer*       GetVertexBuffer(uint32_t index);
     uint32_t                GetLargestBufferSize() const;
 
+    // Meshlet buffers, empty unless the geometry was created with meshlets:
+    //   - meshlet buffer: a MeshletDescriptor per meshlet
+    //   - meshlet vertex buffer: a UINT32 vertex index per meshlet vertex
+    //   - meshlet triangle buffer: a UINT32 per triangle, packing its 3 meshlet
+    //     vertex indices in bits 0-7, 8-15 and 16-23
+    //
+    uint32_t                GetMeshletCount() const { return mMeshletBuffer.GetElementCount(); }
+    const Geometry::Buffer* GetMeshletBuffer() const { return &mMeshletBuffer; }
+    const Geometry::Buffer* GetMeshletVertexBuffer() const { return &mMeshletVertexBuffer; }
+    const Geometry::Buffer* GetMeshletTriangleBuffer() const { return &mMeshletTriangleBuffer; }
+
     // Appends single index, triangle, or edge vertex indices to index buffer
     //
     // Will cast to uint16_t if geometry index type is UINT16.
@@ -277,6 +294,11 @@ private:
     uint32_t                                              mTexCoordBufferIndex  = PPX_VALUE_IGNORED;
     uint32_t                                              mTangentBufferIndex   = PPX_VALUE_IGNORED;
     uint32_t                                              mBitangentBufferIndex = PPX_VALUE_IGNORED;
+
+    // Meshlet buffers have fixed element sizes
+    Geometry::Buffer mMeshletBuffer         = Geometry::Buffer(BUFFER_TYPE_MESHLET, sizeof(MeshletDescriptor));
+    Geometry::Buffer mMeshletVertexBuffer   = Geometry::Buffer(BUFFER_TYPE_MESHLET, sizeof(uint32_t));
+    Geometry::Buffer mMeshletTriangleBuffer = Geometry::Buffer(BUFFER_TYPE_MESHLET, sizeof(uint32_t));
 };
 
 } // namespace ppx
@@ -0,0 +1,185 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_glyph_cache_h
+#define ppx_glyph_cache_h
+
+#include "ppx/bitmap_atlas.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ppx {
+
+//! Renders the glyph of \b codepoint into a \b width x \b height area of
+//! 8-bit coverage values starting at \b pOutput. Called from the background
+//! thread of the cache.
+using GlyphRasterizeFunc = std::function<void(uint32_t codepoint, uint32_t width, uint32_t height, uint32_t rowStride, unsigned char* pOutput)>;
+
+//! @struct GlyphCacheCreateInfo
+//!
+//! Size of the cache texture and of its cells, which bound the glyph size.
+//!
+struct GlyphCacheCreateInfo
+{
+    uint32_t           width      = 1024;
+    uint32_t           height     = 1024;
+    uint32_t           cellWidth  = 32; // Including the padding on both sides
+    uint32_t           cellHeight = 32; // Including the padding on both sides
+    uint32_t           padding    = 1;  // Zero pixels around every glyph
+    GlyphRasterizeFunc rasterize;
+};
+
+//! @struct RasterizedGlyph
+//!
+//! Coverage of a whole cell, ready to be copied to the cache texture.
+//!
+struct RasterizedGlyph
+{
+    uint32_t                   slot       = 0;
+    uint32_t                   generation = 0;
+    AtlasRect                  cellRect   = {};
+    std::vector<unsigned char> pixels; // cellRect.width x cellRect.height, tightly packed
+};
+
+//! @class GlyphCache
+//!
+//! Least recently used cache of glyphs laid out in a grid of equal cells.
+//! A glyph gets a cell, or slot, the first time it is acquired. It is then
+//! rasterized on a background thread, and becomes resident once the caller
+//! takes its pixels to upload them.
+//!
+//! When every slot is taken, the least recently used glyph is evicted,
+//! unless it was used during the current or the previous frame: the vertices
+//! drawn by those frames may still refer to it. Every eviction increments
+//! the generation of the slot, so that holders of a (slot, generation) pair
+//! can tell whether their glyph is still there.
+//!
+//! All functions except the rasterization callback run on the calling thread.
+//!
+class GlyphCache
+{
+public:
+    static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+
+    GlyphCache() {}
+    ~GlyphCache();
+
+    Result Create(const GlyphCacheCreateInfo& createInfo);
+
+    //! Stops the background thread and removes every glyph.
+    void Destroy();
+
+    bool IsCreated() const { return !mSlots.empty(); }
+
+    //! Returns the slot of \b codepoint and marks it as used by the current
+    //! frame. On a miss, takes the least recently used slot and queues the
+    //! glyph to be rasterized with a \b width x \b height size, which must
+    //! fit in a cell without its padding; \b pInserted is then set to true.
+    //! Returns kInvalidSlot if every slot is used by a recent frame.
+    uint32_t Acquire(uint32_t codepoint, uint32_t width, uint32_t height, bool* pInserted = nullptr);
+
+    //! Returns the slot of \b codepoint without marking it, or kInvalidSlot.
+    uint32_t Find(uint32_t codepoint) const;
+
+    //! Marks a glyph as used by the current frame. Returns false if its
+    //! slot was reused since \b generation.
+    bool Touch(uint32_t slot, uint32_t generation);
+
+    //! Ends the current frame.
+    void NextFrame() { ++mFrameIndex; }
+
+    //! Moves up to \b maxCount rasterized glyphs, oldest first, to the end of
+    //! \b pGlyphs, and marks them resident. Glyphs evicted since they were
+    //! queued are dropped. Returns the number of glyphs moved.
+    uint32_t TakeRasterizedGlyphs(uint32_t maxCount, std::vector<RasterizedGlyph>* pGlyphs);
+
+    //! Waits until every queued glyph is rasterized.
+    void WaitIdle();
+
+    const GlyphCacheCreateInfo& GetCreateInfo() const { return mCreateInfo; }
+
+    uint32_t           GetSlotCount() const { return static_cast<uint32_t>(mSlots.size()); }
+    uint32_t           GetGlyphCount() const { return static_cast<uint32_t>(mSlotsByCodepoint.size()); }
+    uint32_t           GetCodepoint(uint32_t slot) const { return mSlots[slot].codepoint; }
+    uint32_t           GetGeneration(uint32_t slot) const { return mSlots[slot].generation; }
+    bool               IsResident(uint32_t slot) const { return mSlots[slot].resident; }
+    const AtlasRect&   GetGlyphRect(uint32_t slot) const { return mSlots[slot].glyphRect; }
+    const AtlasUVRect& GetGlyphUVRect(uint32_t slot) const { return mSlots[slot].uvRect; }
+
+    uint64_t GetHitCount() const { return mHitCount; }
+    uint64_t GetMissCount() const { return mMissCount; }
+    uint64_t GetEvictionCount() const { return mEvictionCount; }
+
+private:
+    struct Slot
+    {
+        uint32_t    codepoint     = 0;
+        uint32_t    generation    = 0;
+        uint64_t    lastUsedFrame = 0;
+        bool        used          = false;
+        bool        resident      = false;
+        AtlasRect   cellRect      = {};
+        AtlasRect   glyphRect     = {};
+        AtlasUVRect uvRect        = {};
+        uint32_t    prev          = kInvalidSlot; // Toward the most recently used slot
+        uint32_t    next          = kInvalidSlot; // Toward the least recently used slot
+    };
+
+    struct Request
+    {
+        uint32_t codepoint  = 0;
+        uint32_t slot       = 0;
+        uint32_t generation = 0;
+        uint32_t width      = 0;
+        uint32_t height     = 0;
+        // Copied so that the thread does not read the slot.
+        AtlasRect cellRect = {};
+    };
+
+    // Moves a slot to the most recently used end of the list.
+    void MoveToFront(uint32_t slot);
+    void Unlink(uint32_t slot);
+    // Body of the background thread.
+    void RasterizeLoop();
+
+    GlyphCacheCreateInfo                   mCreateInfo = {};
+    std::vector<Slot>                      mSlots;
+    std::unordered_map<uint32_t, uint32_t> mSlotsByCodepoint;
+    uint32_t                               mFront      = kInvalidSlot;
+    uint32_t                               mBack       = kInvalidSlot;
+    uint64_t                               mFrameIndex = 2;
+
+    uint64_t mHitCount      = 0;
+    uint64_t mMissCount     = 0;
+    uint64_t mEvictionCount = 0;
+
+    // Guards the request and result queues.
+    std::mutex                  mMutex;
+    std::condition_variable     mCondition;
+    std::deque<Request>         mRequests;
+    std::deque<RasterizedGlyph> mResults;
+    uint32_t                    mBusyCount  = 0; // Requests taken by the thread and not yet in mResults
+    bool                        mStopThread = false;
+    std::thread                 mThread;
+};
+
+} // namespace ppx
+
+#endif // ppx_glyph_cache_h
@@ -19,6 +19,7 @@
 #include "ppx/grfx/grfx_queue.h"
 #include "ppx/grfx/grfx_texture.h"
 #include "ppx/bitmap.h"
+#include "ppx/compressed_image.h"
 #include "ppx/geometry.h"
 #include "ppx/mipmap.h"
 #include "gli/gli.hpp"
@@ -39,11 +40,13 @@ public:
     // clang-format off
     ImageOptions& AdditionalUsage(grfx::ImageUsageFlags flags) { mAdditionalUsage = flags; return *this; }
     ImageOptions& MipLevelCount(uint32_t levelCount) { mMipLevelCount = levelCount; return *this; }
+    ImageOptions& SRGBMipFilter(bool enable = true) { mSRGBMipFilter = enable; return *this; }
     // clang-format on
 
 private:
     grfx::ImageUsageFlags mAdditionalUsage = grfx::ImageUsageFlags();
     uint32_t              mMipLevelCount   = PPX_REMAINING_MIP_LEVELS;
+    bool                  mSRGBMipFilter   = false;
 
     friend Result CreateImageFromBitmap(
         grfx::Queue*        pQueue,
@@ -123,12 +126,19 @@ public:
     TextureOptions& AdditionalUsage(grfx::ImageUsageFlags flags) { mAdditionalUsage = flags; return *this; }
     TextureOptions& InitialState(grfx::ResourceState state) { mInitialState = state; return *this; }
     TextureOptions& MipLevelCount(uint32_t levelCount) { mMipLevelCount = levelCount; return *this; }
+    TextureOptions& SRGBMipFilter(bool enable = true) { mSRGBMipFilter = enable; return *this; }
+    TextureOptions& BlockCompression(CompressedImage::Format format, CompressedImage::Quality quality = CompressedImage::QUALITY_NORMAL) { mBlockCompressionFormat = format; mBlockCompressionQuality = quality; return *this; }
+    TextureOptions& BlockCompressionCache(bool enable = true) { mBlockCompressionCache = enable; return *this; }
     // clang-format on
 
 private:
-    grfx::ImageUsageFlags mAdditionalUsage = grfx::ImageUsageFlags();
-    grfx::ResourceState   mInitialState    = grfx::ResourceState::RESOURCE_STATE_SHADER_RESOURCE;
-    uint32_t              mMipLevelCount   = 1;
+    grfx::ImageUsageFlags    mAdditionalUsage         = grfx::ImageUsageFlags();
+    grfx::ResourceState      mInitialState            = grfx::ResourceState::RESOURCE_STATE_SHADER_RESOURCE;
+    uint32_t                 mMipLevelCount           = 1;
+    bool                     mSRGBMipFilter           = false;
+    CompressedImage::Format  mBlockCompressionFormat  = CompressedImage::FORMAT_UNDEFINED;
+    CompressedImage::Quality mBlockCompressionQuality = CompressedImage::QUALITY_NORMAL;
+    bool                     mBlockCompressionCache   = false;
 
     friend Result CreateTextureFromBitmap(
         grfx::Queue*          pQueue,
@@ -142,6 +152,12 @@ private:
         grfx::Texture**       ppTexture,
         const TextureOptions& options);
 
+    friend Result CreateTextureFromCompressedImage(
+        grfx::Queue*           pQueue,
+        const CompressedImage* pImage,
+        grfx::Texture**        ppTexture,
+        const TextureOptions&  options);
+
     friend Result CreateTextureFromFile(
         grfx::Queue*                 pQueue,
         const std::filesystem::path& path,
@@ -163,6 +179,10 @@ Result CopyBitmapToTexture(
 
 //! @fn CreateTextureFromBitmap
 //!
+//! If a block compression format is set in options, the mip chain is encoded
+//! on the CPU before upload. Bitmaps whose size is not a multiple of 4, and
+//! floating point bitmaps, whose range the 8-bit encoder would clamp, are
+//! uploaded uncompressed with a warning.
 //!
 Result CreateTextureFromBitmap(
     grfx::Queue*          pQueue,
@@ -180,8 +200,32 @@ Result CreateTextureFromMipmap(
     grfx::Texture**       ppTexture,
     const TextureOptions& options = TextureOptions());
 
+//! @fn CreateTextureFromCompressedImage
+//!
+//! Mip level count from pImage is used. Mip level count and block compression
+//! settings from options are ignored.
+//!
+Result CreateTextureFromCompressedImage(
+    grfx::Queue*           pQueue,
+    const CompressedImage* pImage,
+    grfx::Texture**        ppTexture,
+    const TextureOptions&  options = TextureOptions());
+
 //! @fn CreateTextureFromFile
 //!
+//! With block compression and its cache enabled in options, the encoded image
+//! is stored next to the source as <source>.<format>.<quality>[.srgb].dds, for
+//! example albedo.png.bc7.normal.dds, and reused while it is newer than the
+//! source and has enough mip levels. Only the requested mip levels are
+//! uploaded.
+//!
+//! Without block compression, if a texture cache directory is set with
+//! SetTextureCacheDirectory, the decoded mip chain is cached there by content
+//! hash and later loads skip decoding and mip generation.
+//!
+//! Otherwise, textures with a single mip level are decoded with
+//! Bitmap::StreamFile straight into the staging buffer, without holding the
+//! decoded image in memory.
 //!
 Result CreateTextureFromFile(
     grfx::Queue*                 pQueue,
@@ -439,6 +483,7 @@ Result CreateMeshFromFile(
 // -------------------------------------------------------------------------------------------------
 
 grfx::Format ToGrfxFormat(Bitmap::Format value);
+grfx::Format ToGrfxFormat(CompressedImage::Format value);
 
 } // namespace grfx_util
 } // namespace ppx
@@ -33,6 +33,7 @@ public:
 
     virtual Result Begin() override;
     virtual Result End() override;
+    virtual Result Reset() override;
 
 private:
     virtual void BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo) override;
@@ -207,6 +208,7 @@ private:
     UINT                           mHeapOffsetSampler        = 0;
     const grfx::PipelineInterface* mCurrentGraphicsInterface = nullptr;
     const grfx::PipelineInterface* mCurrentComputeInterface  = nullptr;
+    bool                           mRecording                = false;
 
     struct RootDescriptorTable
     {
@@ -88,9 +88,8 @@ public:
     typename D3D12DescriptorHeapPtr::InterfaceType* GetHeapCBVSRVUAV() const { return mHeapCBVSRVUAV.Get(); }
     typename D3D12DescriptorHeapPtr::InterfaceType* GetHeapSampler() const { return mHeapSampler.Get(); }
 
-    virtual Result UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) override;
-
 protected:
+    virtual Result UpdateApiDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) override;
     virtual Result CreateApiObjects(const grfx::internal::DescriptorSetCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
@@ -263,6 +263,9 @@ public:
 
     virtual Result Begin() = 0;
     virtual Result End()   = 0;
+    //! Returns the command buffer to the state it was in before Begin,
+    //! dropping what was recorded. Must not be called while it is pending.
+    virtual Result Reset() = 0;
 
     void BeginRenderPass(const grfx::RenderPassBeginInfo* pBeginInfo);
     void EndRenderPass();
@@ -16,12 +16,15 @@
 #define ppx_grfx_config_h
 
 #include "ppx/config.h"
+#include "ppx/slot_map.h"
 #include "ppx/grfx/grfx_constants.h"
 #include "ppx/grfx/grfx_enums.h"
 #include "ppx/grfx/grfx_format.h"
 #include "ppx/grfx/grfx_helper.h"
 #include "ppx/grfx/grfx_util.h"
 
+#include <atomic>
+
 namespace ppx {
 namespace grfx {
 
@@ -33,6 +36,7 @@ class DescriptorPool;
 class DescriptorSet;
 class DescriptorSet;
 class DescriptorSetLayout;
+class DescriptorWriteBatch;
 class Device;
 class DrawPass;
 class Fence;
@@ -297,6 +301,18 @@ private:
 
 // -------------------------------------------------------------------------------------------------
 
+namespace internal {
+
+//! Returns an identifier that is never returned again during the process,
+//! unlike object addresses, which are reused once objects are deleted.
+inline uint64_t NewObjectId()
+{
+    static std::atomic<uint64_t> sNextObjectId = 1;
+    return sNextObjectId.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace internal
+
 template <typename CreatInfoT>
 class DeviceObject
     : public CreateDestroyTraits<CreatInfoT>,
@@ -309,6 +325,8 @@ public:
         return ptr;
     }
 
+    uint64_t GetObjectId() const { return mObjectId; }
+
 private:
     void SetParent(grfx::Device* pDevice)
     {
@@ -318,6 +336,9 @@ private:
 
 private:
     grfx::DevicePtr mDevice;
+    // Slot of the object in the registry of its device
+    ppx::SlotHandle mRegistryHandle;
+    uint64_t        mObjectId = grfx::internal::NewObjectId();
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -16,6 +16,9 @@
 #define ppx_grfx_descriptor_h
 
 #include "ppx/grfx/grfx_config.h"
+#include "ppx/profiler.h"
+
+#include <unordered_map>
 
 namespace ppx {
 namespace grfx {
@@ -62,6 +65,16 @@ struct WriteDescriptor
     const grfx::Sampler*   pSampler               = nullptr;
 };
 
+//! @struct DescriptorSetWrite
+//!
+//! Write to the descriptor set \b pSet, see Device::UpdateDescriptorSets.
+//!
+struct DescriptorSetWrite
+{
+    grfx::DescriptorSet*  pSet  = nullptr;
+    grfx::WriteDescriptor write = {};
+};
+
 // -------------------------------------------------------------------------------------------------
 
 //! @struct DescriptorPoolCreateInfo
@@ -122,7 +135,9 @@ public:
     grfx::DescriptorPoolPtr          GetPool() const { return mCreateInfo.pPool; }
     const grfx::DescriptorSetLayout* GetLayout() const { return mCreateInfo.pLayout; }
 
-    virtual Result UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) = 0;
+    //! Skips the writes that would not change a descriptor, like
+    //! DescriptorWriteBatch does. The Update* helpers write through here.
+    Result UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites);
 
     Result UpdateSampler(
         uint32_t             binding,
@@ -145,6 +160,78 @@ public:
         const grfx::Buffer* pBuffer,
         uint64_t            offset = 0,
         uint64_t            range  = PPX_WHOLE_SIZE);
+
+protected:
+    virtual Result UpdateApiDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) = 0;
+    friend class grfx::Device;
+    friend class grfx::DescriptorWriteBatch;
+
+private:
+    // Returns true if the descriptor written by \b write already holds the
+    // same resource.
+    bool IsWritten(const grfx::WriteDescriptor& write) const;
+    void RecordWrite(const grfx::WriteDescriptor& write);
+
+private:
+    // Hash of the last write of each descriptor, by binding and array index
+    std::unordered_map<uint64_t, uint64_t> mWriteHashes;
+    std::unordered_map<uint64_t, uint32_t> mLastWriteIndices; // Index of the last write of each descriptor in an update
+    std::vector<grfx::WriteDescriptor>     mIssuedWrites;
+};
+
+//! @class DescriptorWriteBatch
+//!
+//! Collects descriptor writes to any number of sets and issues them with a
+//! single Device::UpdateDescriptorSets() call. Writes that would not change
+//! a descriptor are dropped: a write replaced by a later write to the same
+//! descriptor of the batch, and a write of the resource that the descriptor
+//! already holds. Resources are compared by object id, so a resource created
+//! at the address of a destroyed one is still written.
+//!
+//! Updating a set invalidates the command buffers it was bound in, so the
+//! batch must be flushed before recording the commands that use its sets.
+//! The sets must stay alive until the batch is flushed.
+//!
+//! The profiler counters "Descriptor writes issued" and "Descriptor writes
+//! elided" count the writes of all batches and DescriptorSet updates.
+//!
+class DescriptorWriteBatch
+{
+public:
+    DescriptorWriteBatch() {}
+    virtual ~DescriptorWriteBatch() {}
+
+    void Write(grfx::DescriptorSet* pSet, const grfx::WriteDescriptor& write);
+
+    //! Issues the writes that change a descriptor and clears the batch.
+    Result Flush();
+
+    uint32_t GetPendingCount() const { return CountU32(mWrites); }
+
+protected:
+    // Issues the writes of a flush, sorted by set. Calls
+    // Device::UpdateDescriptorSets() by default.
+    virtual Result UpdateDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites);
+
+private:
+    struct WriteKey
+    {
+        const grfx::DescriptorSet* pSet       = nullptr;
+        uint32_t                   binding    = 0;
+        uint32_t                   arrayIndex = 0;
+
+        bool operator==(const WriteKey& rhs) const;
+    };
+
+    struct WriteKeyHasher
+    {
+        size_t operator()(const WriteKey& key) const;
+    };
+
+    std::vector<grfx::DescriptorSetWrite>                  mWrites;
+    std::unordered_map<WriteKey, uint32_t, WriteKeyHasher> mWriteIndices;      // Index of the pending write of each descriptor
+    uint32_t                                               mReplacedCount = 0; // Writes replaced by a later write of the batch
+    std::vector<grfx::DescriptorSetWrite>                  mIssuedWrites;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -0,0 +1,150 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_descriptor_allocator_h
+#define ppx_grfx_descriptor_allocator_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_descriptor.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace ppx {
+namespace grfx {
+
+//! @struct FrameDescriptorAllocatorCreateInfo
+//!
+//!
+struct FrameDescriptorAllocatorCreateInfo
+{
+    uint32_t                       frameCount     = 1;                     // Usually Application::GetNumFramesInFlight()
+    grfx::DescriptorPoolCreateInfo pageSize       = {};                    // Descriptor counts of each pool
+    uint32_t                       maxSetsPerPage = PPX_MAX_SETS_PER_POOL; // Must not exceed PPX_MAX_SETS_PER_POOL
+};
+
+//! @class FrameDescriptorAllocator
+//!
+//! Allocates descriptor sets that are only used during one frame, such as a
+//! set per draw whose descriptors change every frame.
+//!
+//! Each frame in flight has its own chain of descriptor pools, called
+//! pages. Sets are taken from the current page until it runs out of
+//! descriptors, then from the next page, which is created when needed.
+//! BeginFrame() releases every set of a frame at once by rewinding its
+//! chain, without freeing anything: the sets allocated the last time the
+//! frame was used are handed out again to later requests for the same
+//! layout, so that a frame that repeats the work of the previous one makes
+//! no API allocation at all.
+//!
+//! Recycled sets are searched per layout, from the first page that may
+//! still hold one, so that layouts used in any order reuse the sets of all
+//! pages. Layouts are identified by object id, so a layout created at the
+//! address of a destroyed one does not get its sets.
+//!
+//! A recycled set still holds the descriptors written the last time it was
+//! used, so every binding read by the shaders must be written again.
+//!
+//! Pages that none of the sets were taken from the last time a frame was
+//! used are released when the frame begins again, along with the layouts it
+//! did not use. Sets of destroyed layouts therefore do not accumulate: the
+//! pages of a frame are bounded by what its last two uses needed.
+//!
+class FrameDescriptorAllocator
+{
+public:
+    FrameDescriptorAllocator() {}
+    virtual ~FrameDescriptorAllocator() {}
+
+    //! \b pDevice can be null in a subclass that overrides the pool and set
+    //! functions below.
+    Result Create(grfx::Device* pDevice, const grfx::FrameDescriptorAllocatorCreateInfo* pCreateInfo);
+
+    //! Frees the sets and pools. Pools left when the device is destroyed are
+    //! freed by the device, like any other object.
+    void Destroy();
+
+    //! Starts allocating the sets of frame \b frameIndex, usually
+    //! Application::GetInFlightFrameIndex(), and releases the sets allocated
+    //! the last time that frame was used. The fence of that frame must have
+    //! been waited on. Takes time proportional to the number of pages and
+    //! layouts of the frame, not to the number of sets.
+    void BeginFrame(uint32_t frameIndex);
+
+    //! Returns a set of layout \b pLayout that stays valid until the next
+    //! BeginFrame() call for the current frame index.
+    Result AllocateDescriptorSet(const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet);
+
+    //! Number of pools of all frames.
+    uint32_t GetPageCount() const;
+
+    //! Number of sets allocated in the current frame.
+    uint32_t GetFrameSetCount() const;
+
+protected:
+    // Pool and set functions, which call the device by default
+    virtual Result CreatePool(const grfx::DescriptorPoolCreateInfo* pCreateInfo, grfx::DescriptorPool** ppPool);
+    virtual void   DestroyPool(grfx::DescriptorPool* pPool);
+    virtual Result AllocateSet(grfx::DescriptorPool* pPool, const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet);
+    virtual void   FreeSet(grfx::DescriptorSet* pSet);
+
+private:
+    struct LayoutSets
+    {
+        std::vector<grfx::DescriptorSet*> sets;
+        uint32_t                          usedCount = 0;
+        uint64_t                          epoch     = 0; // usedCount is 0 if this is not the epoch of the frame
+    };
+
+    struct Page
+    {
+        grfx::DescriptorPoolPtr                  pool;
+        grfx::DescriptorPoolCreateInfo           remaining     = {};
+        uint32_t                                 remainingSets = 0;
+        std::unordered_map<uint64_t, LayoutSets> layouts; // By layout object id
+    };
+
+    // First page that may hold a set of a layout to recycle
+    struct LayoutCursor
+    {
+        uint32_t page  = 0;
+        uint64_t epoch = 0; // page is 0 if this is not the epoch of the frame
+    };
+
+    struct Frame
+    {
+        std::vector<std::unique_ptr<Page>>         pages;
+        std::unordered_map<uint64_t, LayoutCursor> cursors;           // By layout object id
+        uint32_t                                   firstFreePage = 0; // Pages before it cannot allocate any set
+        uint32_t                                   setCount      = 0;
+        uint64_t                                   epoch         = 1;
+    };
+
+    const grfx::DescriptorPoolCreateInfo* GetLayoutRequirements(const grfx::DescriptorSetLayout* pLayout);
+    void                                  ReleaseUnusedPages(Frame& frame);
+    void                                  DestroyPage(Page& page);
+    Result                                AddPage(Frame& frame);
+
+private:
+    grfx::DevicePtr                                              mDevice;
+    grfx::FrameDescriptorAllocatorCreateInfo                     mCreateInfo = {};
+    std::vector<Frame>                                           mFrames;
+    uint32_t                                                     mFrameIndex = 0;
+    std::unordered_map<uint64_t, grfx::DescriptorPoolCreateInfo> mLayoutRequirements; // By layout object id
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_descriptor_allocator_h
@@ -34,6 +34,10 @@
 #include "ppx/grfx/grfx_text_draw.h"
 #include "ppx/grfx/grfx_texture.h"
 
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
 namespace ppx {
 namespace grfx {
 
@@ -49,11 +53,17 @@ struct DeviceCreateInfo
     std::vector<std::string> vulkanExtensions       = {};      // [OPTIONAL] Additional device extensions
     const void*              pVulkanDeviceFeatures  = nullptr; // [OPTIONAL] Pointer to custom VkPhysicalDeviceFeatures
     ShadingRateMode          supportShadingRateMode = SHADING_RATE_NONE;
+    std::string              pipelineCachePath      = ""; // [OPTIONAL] File the pipeline cache is loaded from and saved to, empty to disable
 #if defined(PPX_BUILD_XR)
     XrComponent* pXrComponent = nullptr;
 #endif
 };
 
+//! Objects of one type created by a device. Each object keeps the handle of
+//! its slot, so that creating and destroying objects takes constant time.
+template <typename ObjectT>
+using ObjectRegistry = ppx::SlotMap<ObjPtr<ObjectT>>;
+
 //! @class Device
 //!
 //!
@@ -109,6 +119,15 @@ public:
     Result CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo2* pCreateInfo, grfx::GraphicsPipeline** ppGraphicsPipeline);
     void   DestroyGraphicsPipeline(const grfx::GraphicsPipeline* pGraphicsPipeline);
 
+    //! Compiles \b count pipelines on worker threads and returns without
+    //! waiting. \b pHandles receives one handle per create info. Pending
+    //! compilations of higher \b priority start first.
+    Result CompileGraphicsPipelinesAsync(uint32_t count, const grfx::GraphicsPipelineCreateInfo2* pCreateInfos, int32_t priority, grfx::PipelineCompileHandle* pHandles);
+    Result CompileComputePipelinesAsync(uint32_t count, const grfx::ComputePipelineCreateInfo* pCreateInfos, int32_t priority, grfx::PipelineCompileHandle* pHandles);
+
+    //! Blocks until every pipeline compilation started so far is done.
+    void WaitPipelineCompilation();
+
     Result CreateImage(const grfx::ImageCreateInfo* pCreateInfo, grfx::Image** ppImage);
     void   DestroyImage(const grfx::Image* pImage);
 
@@ -169,6 +188,10 @@ public:
     Result AllocateDescriptorSet(grfx::DescriptorPool* pPool, const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet);
     void   FreeDescriptorSet(const grfx::DescriptorSet* pSet);
 
+    //! Applies writes to any number of descriptor sets, with a single API
+    //! call on Vulkan. See also DescriptorWriteBatch.
+    Result UpdateDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites);
+
     uint32_t       GetGraphicsQueueCount() const;
     Result         GetGraphicsQueue(uint32_t index, grfx::Queue** ppQueue) const;
     grfx::QueuePtr GetGraphicsQueue(uint32_t index = 0) const;
@@ -192,6 +215,15 @@ public:
     virtual bool IndependentBlendingSupported() const      = 0;
     virtual bool FragmentStoresAndAtomicsSupported() const = 0;
 
+    //! Returns true if the pipeline cache was loaded from the file set in
+    //! DeviceCreateInfo::pipelineCachePath.
+    virtual bool IsPipelineCacheWarm() const { return false; }
+
+    //! Number of graphics and compute pipelines created so far, and the time
+    //! spent creating them.
+    uint32_t GetPipelineCreationCount() const { return mPipelineCreationCount; }
+    double   GetPipelineCreationTimeMs() const;
+
 protected:
     virtual Result Create(const grfx::DeviceCreateInfo* pCreateInfo) override;
     virtual void   Destroy() override;
@@ -229,59 +261,92 @@ protected:
     virtual Result AllocateObject(grfx::Texture** ppObject);
     virtual Result AllocateObject(grfx::TextureFont** ppObject);
 
+    // Applies writes grouped by set. Issues one update per set by default.
+    virtual Result UpdateApiDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites);
+
     template <
         typename ObjectT,
         typename CreateInfoT,
-        typename ContainerT = std::vector<ObjPtr<ObjectT>>>
+        typename ContainerT = grfx::ObjectRegistry<ObjectT>>
     Result CreateObject(const CreateInfoT* pCreateInfo, ContainerT& container, ObjectT** ppObject);
 
-    template <
-        typename ObjectT,
-        typename ContainerT = std::vector<ObjPtr<ObjectT>>>
-    void DestroyObject(ContainerT& container, const ObjectT* pObject);
+    template <typename ObjectT>
+    void StoreObject(std::vector<ObjPtr<ObjectT>>& container, ObjectT* pObject);
+
+    template <typename ObjectT>
+    void StoreObject(grfx::ObjectRegistry<ObjectT>& container, ObjectT* pObject);
+
+    template <typename ObjectT>
+    void DestroyObject(grfx::ObjectRegistry<ObjectT>& container, const ObjectT* pObject);
 
     template <typename ObjectT>
     void DestroyAllObjects(std::vector<ObjPtr<ObjectT>>& container);
 
+    template <typename ObjectT>
+    void DestroyAllObjects(grfx::ObjectRegistry<ObjectT>& container);
+
     Result CreateGraphicsQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue);
     Result CreateComputeQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue);
     Result CreateTransferQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue);
 
 protected:
-    grfx::InstancePtr                         mInstance;
-    std::vector<grfx::BufferPtr>              mBuffers;
-    std::vector<grfx::CommandBufferPtr>       mCommandBuffers;
-    std::vector<grfx::CommandPoolPtr>         mCommandPools;
-    std::vector<grfx::ComputePipelinePtr>     mComputePipelines;
-    std::vector<grfx::DepthStencilViewPtr>    mDepthStencilViews;
-    std::vector<grfx::DescriptorPoolPtr>      mDescriptorPools;
-    std::vector<grfx::DescriptorSetPtr>       mDescriptorSets;
-    std::vector<grfx::DescriptorSetLayoutPtr> mDescriptorSetLayouts;
-    std::vector<grfx::DrawPassPtr>            mDrawPasses;
-    std::vector<grfx::FencePtr>               mFences;
-    std::vector<grfx::ShadingRatePatternPtr>  mShadingRatePatterns;
-    std::vector<grfx::FullscreenQuadPtr>      mFullscreenQuads;
-    std::vector<grfx::GraphicsPipelinePtr>    mGraphicsPipelines;
-    std::vector<grfx::ImagePtr>               mImages;
-    std::vector<grfx::MeshPtr>                mMeshes;
-    std::vector<grfx::PipelineInterfacePtr>   mPipelineInterfaces;
-    std::vector<grfx::QueryPtr>               mQuerys;
-    std::vector<grfx::RenderPassPtr>          mRenderPasses;
-    std::vector<grfx::RenderTargetViewPtr>    mRenderTargetViews;
-    std::vector<grfx::SampledImageViewPtr>    mSampledImageViews;
-    std::vector<grfx::SamplerPtr>             mSamplers;
-    std::vector<grfx::SemaphorePtr>           mSemaphores;
-    std::vector<grfx::ShaderModulePtr>        mShaderModules;
-    std::vector<grfx::ShaderProgramPtr>       mShaderPrograms;
-    std::vector<grfx::StorageImageViewPtr>    mStorageImageViews;
-    std::vector<grfx::SwapchainPtr>           mSwapchains;
-    std::vector<grfx::TextDrawPtr>            mTextDraws;
-    std::vector<grfx::TexturePtr>             mTextures;
-    std::vector<grfx::TextureFontPtr>         mTextureFonts;
-    std::vector<grfx::QueuePtr>               mGraphicsQueues;
-    std::vector<grfx::QueuePtr>               mComputeQueues;
-    std::vector<grfx::QueuePtr>               mTransferQueues;
-    grfx::ShadingRateCapabilities             mShadingRateCapabilities;
+    grfx::InstancePtr                               mInstance;
+    grfx::ObjectRegistry<grfx::Buffer>              mBuffers;
+    grfx::ObjectRegistry<grfx::CommandBuffer>       mCommandBuffers;
+    grfx::ObjectRegistry<grfx::CommandPool>         mCommandPools;
+    grfx::ObjectRegistry<grfx::ComputePipeline>     mComputePipelines;
+    grfx::ObjectRegistry<grfx::DepthStencilView>    mDepthStencilViews;
+    grfx::ObjectRegistry<grfx::DescriptorPool>      mDescriptorPools;
+    grfx::ObjectRegistry<grfx::DescriptorSet>       mDescriptorSets;
+    grfx::ObjectRegistry<grfx::DescriptorSetLayout> mDescriptorSetLayouts;
+    grfx::ObjectRegistry<grfx::DrawPass>            mDrawPasses;
+    grfx::ObjectRegistry<grfx::Fence>               mFences;
+    grfx::ObjectRegistry<grfx::ShadingRatePattern>  mShadingRatePatterns;
+    grfx::ObjectRegistry<grfx::FullscreenQuad>      mFullscreenQuads;
+    grfx::ObjectRegistry<grfx::GraphicsPipeline>    mGraphicsPipelines;
+    grfx::ObjectRegistry<grfx::Image>               mImages;
+    grfx::ObjectRegistry<grfx::Mesh>                mMeshes;
+    grfx::ObjectRegistry<grfx::PipelineInterface>   mPipelineInterfaces;
+    grfx::ObjectRegistry<grfx::Query>               mQuerys;
+    grfx::ObjectRegistry<grfx::RenderPass>          mRenderPasses;
+    grfx::ObjectRegistry<grfx::RenderTargetView>    mRenderTargetViews;
+    grfx::ObjectRegistry<grfx::SampledImageView>    mSampledImageViews;
+    grfx::ObjectRegistry<grfx::Sampler>             mSamplers;
+    grfx::ObjectRegistry<grfx::Semaphore>           mSemaphores;
+    grfx::ObjectRegistry<grfx::ShaderModule>        mShaderModules;
+    grfx::ObjectRegistry<grfx::ShaderProgram>       mShaderPrograms;
+    grfx::ObjectRegistry<grfx::StorageImageView>    mStorageImageViews;
+    grfx::ObjectRegistry<grfx::Swapchain>           mSwapchains;
+    grfx::ObjectRegistry<grfx::TextDraw>            mTextDraws;
+    grfx::ObjectRegistry<grfx::Texture>             mTextures;
+    grfx::ObjectRegistry<grfx::TextureFont>         mTextureFonts;
+    std::vector<grfx::QueuePtr>                     mGraphicsQueues;
+    std::vector<grfx::QueuePtr>                     mComputeQueues;
+    std::vector<grfx::QueuePtr>                     mTransferQueues;
+    grfx::ShadingRateCapabilities                   mShadingRateCapabilities;
+
+private:
+    template <typename ObjectT, typename CreateInfoT>
+    Result CreatePipeline(const CreateInfoT* pCreateInfo, grfx::ObjectRegistry<ObjectT>& container, ObjectT** ppObject);
+
+    Result StartPipelineCompilation(const std::shared_ptr<grfx::internal::PipelineCompileJob>& job, int32_t priority, grfx::PipelineCompileHandle* pHandle);
+    void   CompilePipeline(grfx::internal::PipelineCompileJob* pJob);
+
+private:
+    // Guards the registries, which pipeline compilation threads add to
+    std::mutex mRegistryMutex;
+
+    // Addresses of the objects in the registries. DestroyObject() checks a
+    // pointer against it before reading the registry handle of the object,
+    // so that a stale pointer is ignored instead of dereferenced.
+    std::unordered_set<const void*> mRegisteredObjects;
+
+    // Started by the first asynchronous pipeline compilation
+    ppx::TaskPool mPipelineCompilePool;
+
+    // Atomic so that pipelines can be created from several threads
+    std::atomic<uint32_t> mPipelineCreationCount = 0;
+    std::atomic<uint64_t> mPipelineCreationTicks = 0;
 };
 
 } // namespace grfx
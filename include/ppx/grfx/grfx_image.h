@@ -126,6 +126,9 @@ public:
 
     const grfx::internal::ImageResourceView* GetResourceView() const { return mResourceView.get(); }
 
+    //! Identifies the view for the whole process, see grfx::internal::NewObjectId().
+    uint64_t GetViewId() const { return mViewId; }
+
 protected:
     void SetResourceView(std::unique_ptr<internal::ImageResourceView>&& view)
     {
@@ -134,6 +137,7 @@ protected:
 
 private:
     std::unique_ptr<internal::ImageResourceView> mResourceView;
+    uint64_t                                     mViewId = grfx::internal::NewObjectId();
 };
 
 // -------------------------------------------------------------------------------------------------
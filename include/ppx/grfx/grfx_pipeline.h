@@ -16,6 +16,7 @@
 #define ppx_grfx_pipeline_h
 
 #include "ppx/grfx/grfx_config.h"
+#include "ppx/task_pool.h"
 
 namespace ppx {
 namespace grfx {
@@ -277,6 +278,84 @@ private:
     std::vector<uint32_t> mSetNumbers               = {};
 };
 
+// -------------------------------------------------------------------------------------------------
+
+namespace internal {
+
+//! State shared by a PipelineCompileHandle and the task compiling its
+//! pipeline. The create info is copied, but the shader modules and the
+//! pipeline interface it points to must stay alive until the task is done.
+struct PipelineCompileJob
+{
+    bool                              compute            = false;
+    grfx::GraphicsPipelineCreateInfo2 graphicsCreateInfo = {};
+    grfx::ComputePipelineCreateInfo   computeCreateInfo  = {};
+    ppx::TaskHandle                   task;
+
+    // Cancel() and the task publishing the pipeline take the mutex, so
+    // that either the pipeline is ready or the cancellation is seen.
+    std::mutex mutex;
+    bool       cancelRequested = false;
+
+    // Written by the task before it completes.
+    Result                  result            = ppx::ERROR_FAILED;
+    grfx::GraphicsPipeline* pGraphicsPipeline = nullptr;
+    grfx::ComputePipeline*  pComputePipeline  = nullptr;
+    std::atomic<bool>       ready             = false;
+};
+
+} // namespace internal
+
+//! @class PipelineCompileHandle
+//!
+//! Refers to a pipeline compiled in the background by
+//! Device::CompileGraphicsPipelinesAsync or
+//! Device::CompileComputePipelinesAsync. Until the pipeline is ready,
+//! GetGraphicsPipeline and GetComputePipeline return the fallback pipeline
+//! passed to them, so that a frame can be drawn without blocking on the
+//! compilation.
+//!
+//! The compiled pipeline belongs to the device like any other pipeline and
+//! is destroyed with Device::DestroyGraphicsPipeline or
+//! Device::DestroyComputePipeline.
+//!
+class PipelineCompileHandle
+{
+public:
+    PipelineCompileHandle() {}
+    ~PipelineCompileHandle() {}
+
+    bool IsValid() const { return mJob != nullptr; }
+
+    //! Returns true once the pipeline was successfully compiled.
+    bool IsReady() const;
+
+    //! Returns true once the compilation finished, failed or was canceled.
+    bool IsDone() const;
+
+    //! Blocks until the compilation is done and returns its result.
+    Result Wait() const;
+
+    //! Returns ERROR_CANCELED if the compilation was canceled, the result of
+    //! the compilation if it is done, and ERROR_FAILED otherwise.
+    Result GetResult() const;
+
+    //! Cancels the compilation. A pipeline whose compilation already started
+    //! is destroyed as soon as it is created. Has no effect once the pipeline
+    //! is ready: it then belongs to the caller, see IsReady().
+    void Cancel();
+
+    //! Moves a pending compilation ahead of or behind the others.
+    void SetPriority(int32_t priority);
+
+    grfx::GraphicsPipeline* GetGraphicsPipeline(grfx::GraphicsPipeline* pFallback = nullptr) const;
+    grfx::ComputePipeline*  GetComputePipeline(grfx::ComputePipeline* pFallback = nullptr) const;
+
+private:
+    friend class grfx::Device;
+    std::shared_ptr<internal::PipelineCompileJob> mJob;
+};
+
 } // namespace grfx
 } // namespace ppx
 
@@ -41,6 +41,9 @@ public:
     virtual Result Wait(uint64_t timeout = UINT64_MAX) = 0;
     virtual Result Reset()                             = 0;
 
+    //! Returns true if the fence is signaled, without waiting.
+    virtual bool IsSignaled() const = 0;
+
     Result WaitAndReset(uint64_t timeout = UINT64_MAX);
 
 protected:
@@ -16,21 +16,20 @@
 #define ppx_grfx_text_draw_h
 
 #include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
 #include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/bitmap_atlas.h"
+#include "ppx/glyph_cache.h"
 #include "ppx/math_config.h"
 #include "ppx/font.h"
 #include "xxhash.h"
 
+#include <unordered_map>
+
 namespace ppx {
 namespace grfx {
 
-struct TextureFontUVRect
-{
-    float u0 = 0;
-    float v0 = 0;
-    float u1 = 0;
-    float v1 = 0;
-};
+using TextureFontUVRect = ppx::AtlasUVRect;
 
 struct TextureFontGlyphMetrics
 {
@@ -40,11 +39,25 @@ struct TextureFontGlyphMetrics
     TextureFontUVRect uvRect       = {};
 };
 
+//! Identifies the cache slot of a glyph of a dynamic TextureFont.
+struct TextureFontGlyphRef
+{
+    uint32_t slot       = GlyphCache::kInvalidSlot;
+    uint32_t generation = 0;
+};
+
 struct TextureFontCreateInfo
 {
     ppx::Font   font;
     float       size       = 16.0f;
-    std::string characters = ""; // Default characters if empty
+    std::string characters = ""; // GetDefaultCharacters() if empty. Rasterized up front, also if dynamicGlyphs
+
+    // Rasterize glyphs on first use into an LRU cache texture instead of
+    // rasterizing a fixed set at creation. See TextureFont::UploadGlyphs.
+    bool     dynamicGlyphs           = false;
+    uint32_t cacheTextureSize        = 1024; // Width and height of the cache texture
+    uint32_t maxGlyphUploadsPerFrame = 256;
+    uint32_t stagingFrameCount       = 3; // Frames whose glyph uploads may be in flight on the GPU
 };
 
 class TextureFont
@@ -54,6 +67,7 @@ public:
     TextureFont() {}
     virtual ~TextureFont() {}
 
+    //! Printable ASCII characters, used when no characters are requested.
     static std::string GetDefaultCharacters();
 
     const ppx::Font& GetFont() const { return mCreateInfo.font; }
@@ -66,14 +80,45 @@ public:
     float                                GetLineGap() const { return mFontMetrics.lineGap; }
     const grfx::TextureFontGlyphMetrics* GetGlyphMetrics(uint32_t codepoint) const;
 
+    bool              IsDynamic() const { return mCreateInfo.dynamicGlyphs; }
+    const GlyphCache& GetGlyphCache() const { return mGlyphCache; }
+
+    //! Returns the metrics of \b codepoint, or null if it has none. For a
+    //! dynamic font, caches the glyph on first use and sets \b pRef to its
+    //! slot; \b pResident tells whether its pixels are in the texture yet.
+    //! Static fonts always set \b pResident to true.
+    const grfx::TextureFontGlyphMetrics* AcquireGlyph(uint32_t codepoint, grfx::TextureFontGlyphRef* pRef, bool* pResident);
+
+    //! Marks a glyph acquired earlier as used by the current frame. Returns
+    //! false if it has been evicted since.
+    bool TouchGlyph(const grfx::TextureFontGlyphRef& ref);
+
+    //! Records the copy of the glyphs rasterized since the last call into
+    //! the texture, and ends the frame for the LRU cache. Call once per frame
+    //! outside of a render pass for dynamic fonts; does nothing otherwise.
+    ppx::Result UploadGlyphs(grfx::CommandBuffer* pCommandBuffer);
+
 protected:
     virtual Result CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    Result CreateDynamicGlyphCache(const grfx::TextureFontCreateInfo* pCreateInfo, const std::string& characters);
+
 private:
     FontMetrics                                mFontMetrics;
     std::vector<grfx::TextureFontGlyphMetrics> mGlyphMetrics;
     grfx::TexturePtr                           mTexture;
+
+    // Dynamic fonts
+    GlyphCache                                 mGlyphCache;
+    std::vector<grfx::TextureFontGlyphMetrics> mSlotMetrics;
+    grfx::BufferPtr                            mStagingBuffer;
+    uint32_t                                   mStagingRowStride  = 0;
+    uint64_t                                   mStagingGlyphSize  = 0;
+    uint32_t                                   mStagingFrameIndex = 0;
+    std::vector<RasterizedGlyph>               mRasterizedGlyphs;
+    std::vector<grfx::BufferToImageCopyInfo>   mGlyphCopyInfos;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -96,6 +141,9 @@ public:
     TextDraw() {}
     virtual ~TextDraw() {}
 
+    // Strings added again after Clear with the same arguments reuse the
+    // vertices built the first time. Strings not added again are forgotten
+    // by the next Clear.
     void Clear();
 
     void AddString(
@@ -126,20 +174,53 @@ protected:
     virtual void   DestroyApiObjects() override;
 
 private:
-    uint32_t                     mTextLength = 0;
-    grfx::BufferPtr              mCpuIndexBuffer;
-    grfx::BufferPtr              mCpuVertexBuffer;
-    grfx::BufferPtr              mGpuIndexBuffer;
-    grfx::BufferPtr              mGpuVertexBuffer;
-    grfx::IndexBufferView        mIndexBufferView  = {};
-    grfx::VertexBufferView       mVertexBufferView = {};
-    grfx::BufferPtr              mCpuConstantBuffer;
-    grfx::BufferPtr              mGpuConstantBuffer;
-    grfx::DescriptorPoolPtr      mDescriptorPool;
-    grfx::DescriptorSetLayoutPtr mDescriptorSetLayout;
-    grfx::DescriptorSetPtr       mDescriptorSet;
-    grfx::PipelineInterfacePtr   mPipelineInterface;
-    grfx::GraphicsPipelinePtr    mPipeline;
+    struct Vertex
+    {
+        float2   position;
+        float2   uv;
+        uint32_t rgba;
+    };
+
+    static constexpr size_t kGlyphIndicesSize  = 6 * sizeof(uint32_t);
+    static constexpr size_t kGlyphVerticesSize = 4 * sizeof(Vertex);
+
+    // Vertices of a string, reused by later calls to AddString with the same
+    // arguments as long as its glyphs stay in the font's cache.
+    struct StringRun
+    {
+        std::string                            string;
+        float2                                 position    = {};
+        float                                  tabSpacing  = 0;
+        float                                  lineSpacing = 0;
+        uint32_t                               rgba        = 0;
+        bool                                   complete    = false; // Every glyph was resident
+        bool                                   used        = false; // Added since the last Clear
+        std::vector<Vertex>                    vertices;
+        std::vector<grfx::TextureFontGlyphRef> glyphs;
+    };
+
+    // Lays out the string of a run.
+    void BuildRun(StringRun* pRun);
+    // Marks the glyphs of a run as used. Returns false if one was evicted.
+    bool TouchRunGlyphs(const StringRun& run);
+
+private:
+    uint32_t                                mTextLength              = 0;
+    uint32_t                                mUploadedIndexGlyphCount = 0;
+    std::unordered_map<uint64_t, StringRun> mRuns;
+    grfx::BufferPtr                         mCpuIndexBuffer;
+    grfx::BufferPtr                         mCpuVertexBuffer;
+    grfx::BufferPtr                         mGpuIndexBuffer;
+    grfx::BufferPtr                         mGpuVertexBuffer;
+    grfx::IndexBufferView                   mIndexBufferView         = {};
+    grfx::VertexBufferView                  mVertexBufferView        = {};
+    grfx::BufferPtr                         mCpuConstantBuffer;
+    grfx::BufferPtr                         mGpuConstantBuffer;
+    grfx::DescriptorPoolPtr                 mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr            mDescriptorSetLayout;
+    grfx::DescriptorSetPtr                  mDescriptorSet;
+    grfx::PipelineInterfacePtr              mPipelineInterface;
+    grfx::GraphicsPipelinePtr               mPipeline;
 };
 
 } // namespace grfx
@@ -33,6 +33,7 @@ public:
 
     virtual Result Begin() override;
     virtual Result End() override;
+    virtual Result Reset() override;
 
 private:
     virtual void BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo) override;
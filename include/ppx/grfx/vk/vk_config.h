@@ -119,6 +119,7 @@ using VkImagePtr               = VkHandlePtr<VkImage>;
 using VkImageViewPtr           = VkHandlePtr<VkImageView>;
 using VkInstancePtr            = VkHandlePtr<VkInstance>;
 using VkPhysicalDevicePtr      = VkHandlePtr<VkPhysicalDevice>;
+using VkPipelineCachePtr       = VkHandlePtr<VkPipelineCache>;
 using VkPipelinePtr            = VkHandlePtr<VkPipeline>;
 using VkPipelineLayoutPtr      = VkHandlePtr<VkPipelineLayout>;
 using VkQueryPoolPtr           = VkHandlePtr<VkQueryPool>;
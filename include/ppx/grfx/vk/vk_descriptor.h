@@ -41,6 +41,17 @@ private:
 
 // -------------------------------------------------------------------------------------------------
 
+//! Converts \b write to a write of \b vkSet. Depending on the descriptor
+//! type, \b pVkWrite points at \b pImageInfo, \b pBufferInfo or
+//! \b pTexelBufferView, which must outlive it.
+Result ToVkWriteDescriptorSet(
+    VkDescriptorSet              vkSet,
+    const grfx::WriteDescriptor& write,
+    VkDescriptorImageInfo*       pImageInfo,
+    VkDescriptorBufferInfo*      pBufferInfo,
+    VkBufferView*                pTexelBufferView,
+    VkWriteDescriptorSet*        pVkWrite);
+
 class DescriptorSet
     : public grfx::DescriptorSet
 {
@@ -50,9 +61,8 @@ public:
 
     VkDescriptorSetPtr GetVkDescriptorSet() const { return mDescriptorSet; }
 
-    virtual Result UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) override;
-
 protected:
+    virtual Result UpdateApiDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) override;
     virtual Result CreateApiObjects(const grfx::internal::DescriptorSetCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
@@ -65,10 +75,6 @@ private:
     std::vector<VkDescriptorImageInfo>  mImageInfoStore;
     std::vector<VkBufferView>           mTexelBufferStore;
     std::vector<VkDescriptorBufferInfo> mBufferInfoStore;
-    uint32_t                            mWriteCount       = 0;
-    uint32_t                            mImageCount       = 0;
-    uint32_t                            mTexelBufferCount = 0;
-    uint32_t                            mBufferCount      = 0;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -17,6 +17,9 @@
 
 #include "ppx/grfx/vk/vk_config.h"
 #include "ppx/grfx/grfx_device.h"
+#include "ppx/pipeline_cache_file.h"
+
+#include <mutex>
 
 namespace ppx {
 namespace grfx {
@@ -29,8 +32,9 @@ public:
     Device() {}
     virtual ~Device() {}
 
-    VkDevicePtr     GetVkDevice() const { return mDevice; }
-    VmaAllocatorPtr GetVmaAllocator() const { return mVmaAllocator; }
+    VkDevicePtr        GetVkDevice() const { return mDevice; }
+    VmaAllocatorPtr    GetVmaAllocator() const { return mVmaAllocator; }
+    VkPipelineCachePtr GetVkPipelineCache() const { return mPipelineCache; }
 
     const VkPhysicalDeviceFeatures& GetDeviceFeatures() const { return mDeviceFeatures; }
 
@@ -44,6 +48,7 @@ public:
     virtual bool DynamicRenderingSupported() const override;
     virtual bool IndependentBlendingSupported() const override;
     virtual bool FragmentStoresAndAtomicsSupported() const override;
+    virtual bool IsPipelineCacheWarm() const override { return mPipelineCacheWarm; }
 
     void ResetQueryPoolEXT(
         VkQueryPool queryPool,
@@ -83,6 +88,9 @@ protected:
     virtual Result AllocateObject(grfx::StorageImageView** ppObject) override;
     virtual Result AllocateObject(grfx::Swapchain** ppObject) override;
 
+    // Issues all writes with a single vkUpdateDescriptorSets call
+    virtual Result UpdateApiDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites) override;
+
 protected:
     virtual Result CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
@@ -101,6 +109,9 @@ private:
         VkPhysicalDevice               physicalDevice,
         grfx::ShadingRateCapabilities* pShadingRateCapabilities);
     Result CreateQueues(const grfx::DeviceCreateInfo* pCreateInfo);
+    Result CreatePipelineCache(const grfx::DeviceCreateInfo* pCreateInfo);
+    // Saves the pipeline cache to its file before destroying it
+    void DestroyPipelineCache();
 
 private:
     std::vector<std::string>                       mFoundExtensions;
@@ -108,6 +119,10 @@ private:
     VkDevicePtr                                    mDevice;
     VkPhysicalDeviceFeatures                       mDeviceFeatures = {};
     VmaAllocatorPtr                                mVmaAllocator;
+    VkPipelineCachePtr                             mPipelineCache;
+    std::string                                    mPipelineCachePath;
+    ppx::PipelineCacheDeviceInfo                   mPipelineCacheDeviceInfo                    = {};
+    bool                                           mPipelineCacheWarm                          = false;
     bool                                           mHasTimelineSemaphore                       = false;
     bool                                           mHasExtendedDynamicState                    = false;
     bool                                           mHasUnrestrictedDepthRange                  = false;
@@ -120,6 +135,14 @@ private:
     PFN_vkGetPhysicalDeviceFeatures2               mFnGetPhysicalDeviceFeatures2               = nullptr;
     PFN_vkGetPhysicalDeviceProperties2             mFnGetPhysicalDeviceProperties2             = nullptr;
     PFN_vkGetPhysicalDeviceFragmentShadingRatesKHR mFnGetPhysicalDeviceFragmentShadingRatesKHR = nullptr;
+
+    // Reduce memory allocations during descriptor updates. Sets can be
+    // updated from several threads, so the stores are guarded by the mutex.
+    std::mutex                          mDescriptorWriteStoreMutex;
+    std::vector<VkWriteDescriptorSet>   mDescriptorWriteStore;
+    std::vector<VkDescriptorImageInfo>  mDescriptorImageInfoStore;
+    std::vector<VkDescriptorBufferInfo> mDescriptorBufferInfoStore;
+    std::vector<VkBufferView>           mDescriptorTexelBufferStore;
 };
 
 extern PFN_vkCmdPushDescriptorSetKHR CmdPushDescriptorSetKHR;
@@ -0,0 +1,74 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_image_diff_h
+#define ppx_image_diff_h
+
+#include "ppx/bitmap.h"
+
+namespace ppx {
+
+//! @struct ImageDiffOptions
+//!
+//!
+struct ImageDiffOptions
+{
+    bool     computeSSIM     = true;
+    float    heatmapMaxError = 0.1f; // Absolute error shown with the hottest heatmap color
+    uint32_t threadCount     = 0;    // 0 uses the hardware concurrency
+};
+
+//! @struct ImageDiffStats
+//!
+//! Channel values are normalized to [0, 1] for integer formats and used as is
+//! for float formats. Per-channel arrays have one entry per channel of the
+//! compared format; psnr and ssim combine the color channels, which excludes
+//! alpha for RGBA formats.
+//!
+//! The relative error of a sample is |a - b| / max(|a|, |b|), and 0 when both
+//! values are 0. SSIM is computed over 8x8 windows placed every 4 pixels, with
+//! uniform weights, and is 1 for identical images.
+//!
+struct ImageDiffStats
+{
+    uint32_t width               = 0;
+    uint32_t height              = 0;
+    uint32_t channelCount        = 0;
+    uint64_t differentPixelCount = 0;
+    double   maxAbsError[4]      = {};
+    double   meanAbsError[4]     = {};
+    double   maxRelError[4]      = {};
+    double   meanRelError[4]     = {};
+    double   channelPSNR[4]      = {}; // [dB], infinity for identical channels
+    double   channelSSIM[4]      = {};
+    double   psnr                = 0;  // [dB], infinity for identical images
+    double   ssim                = 0;  // 0 if options.computeSSIM is false
+};
+
+//! Compares \b test against \b reference, which must have the same size and
+//! format. If \b pHeatmap is not null, it is set to an RGBA8 image of the
+//! same size showing the largest channel error of each pixel, from black for
+//! identical pixels to white for errors of options.heatmapMaxError or more.
+//!
+//! The image is split in bands of rows that are compared in parallel.
+Result CompareBitmaps(
+    const Bitmap&           reference,
+    const Bitmap&           test,
+    const ImageDiffOptions& options,
+    ImageDiffStats*         pStats,
+    Bitmap*                 pHeatmap = nullptr);
+
+} // namespace ppx
+
+#endif // ppx_image_diff_h
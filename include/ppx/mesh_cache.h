@@ -0,0 +1,109 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_mesh_cache_h
+#define ppx_mesh_cache_h
+
+#include "ppx/cache_file.h"
+#include "ppx/geometry.h"
+#include "ppx/tri_mesh.h"
+#include "ppx/grfx/grfx_mesh.h"
+
+namespace ppx {
+
+//! @class MeshCacheFile
+//!
+//! CacheFile of a mesh loaded from a file, holding its final index and vertex
+//! streams in the layout of the GPU buffers, so that they can be uploaded
+//! straight from the memory-mapped file.
+//!
+//! The key is the absolute path, size and modification time of the source
+//! file, and the TriMeshOptions it was loaded with. The next load overwrites
+//! a file whose key changed. The magic is "PPMC", and the header is:
+//!
+//!   header: string sourcePath, uint64 sourceSize, int64 sourceWriteTime,
+//!           uint32 optionsSize, options,
+//!           uint32 indexType, uint32 indexCount, uint32 vertexCount,
+//!           uint32 vertexBufferCount, vertexBufferCount x (
+//!             uint32 stride, uint32 inputRate, uint32 attributeCount,
+//!             attributeCount x (uint32 format, uint32 stride, uint32 semantic)),
+//!           (1 + vertexBufferCount) x (uint64 offset, uint64 size)
+//!
+//! Strings are a uint32 length followed by the characters. The streams are
+//! the index stream followed by the vertex streams, each one aligned to
+//! kStreamAlignment bytes from the start of the file.
+//!
+class MeshCacheFile : public CacheFile
+{
+public:
+    static constexpr uint32_t kVersion         = 1;
+    static constexpr uint32_t kStreamAlignment = 16;
+
+    MeshCacheFile() {}
+    ~MeshCacheFile() {}
+
+    //! Returns the path of the cache file of a source file loaded with options.
+    static std::filesystem::path GetCachePath(
+        const std::filesystem::path& cacheDirectory,
+        const std::filesystem::path& sourcePath,
+        const TriMeshOptions&        options);
+
+    //! Writes the streams of geometry to cachePath.
+    static Result Write(
+        const std::filesystem::path& cachePath,
+        const std::filesystem::path& sourcePath,
+        const TriMeshOptions&        options,
+        const Geometry&              geometry);
+
+    //! Maps cachePath. Returns ERROR_FAILED if the file does not exist, is
+    //! corrupt, or is stale for sourcePath and options.
+    Result Open(
+        const std::filesystem::path& cachePath,
+        const std::filesystem::path& sourcePath,
+        const TriMeshOptions&        options);
+
+    //! Create info of the mesh, as if derived from the cached geometry.
+    const grfx::MeshCreateInfo& GetMeshCreateInfo() const { return mCreateInfo; }
+
+    const char* GetIndexData() const { return GetStreamData(0); }
+    uint64_t    GetIndexDataSize() const { return mStreams.empty() ? 0 : mStreams[0].size; }
+    uint32_t    GetVertexBufferCount() const { return mCreateInfo.vertexBufferCount; }
+    const char* GetVertexData(uint32_t index) const { return GetStreamData(index + 1); }
+    uint64_t    GetVertexDataSize(uint32_t index) const { return mStreams[index + 1].size; }
+
+private:
+    struct Stream
+    {
+        uint64_t offset = 0;
+        uint64_t size   = 0;
+    };
+
+    // Returns the key of the source file and options, as stored in the header.
+    static bool GetKey(const std::filesystem::path& sourcePath, const TriMeshOptions& options, std::vector<uint8_t>* pKey);
+
+    const char* GetStreamData(uint32_t index) const { return GetFileData() + mStreams[index].offset; }
+
+private:
+    grfx::MeshCreateInfo mCreateInfo;
+    std::vector<Stream>  mStreams;
+};
+
+//! Sets the directory where CreateMeshFromFile caches the meshes it loads.
+//! An empty path, the default, disables the cache.
+void                  SetMeshCacheDirectory(const std::filesystem::path& directory);
+std::filesystem::path GetMeshCacheDirectory();
+
+} // namespace ppx
+
+#endif // ppx_mesh_cache_h
@@ -0,0 +1,103 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_mesh_optimizer_h
+#define ppx_mesh_optimizer_h
+
+#include "ppx/config.h"
+#include "ppx/math_config.h"
+
+namespace ppx {
+
+//! Size of the FIFO cache that AnalyzeVertexCache simulates by default,
+//! which is in the range of the post-transform caches of current GPUs.
+constexpr uint32_t kDefaultVertexCacheSize = 16;
+
+//! Default ACMR increase that OptimizeOverdraw accepts in exchange for
+//! finer clusters, i.e. 5%.
+constexpr float kDefaultOverdrawThreshold = 1.05f;
+
+//! @struct VertexCacheStatistics
+//!
+//! Post-transform vertex cache efficiency of a triangle list:
+//!   - acmr, the average cache miss ratio, is the number of transformed
+//!     vertices per triangle: 3 at worst, about 0.5 for a regular grid.
+//!   - atvr, the average transformed vertex ratio, is the number of
+//!     transformed vertices per referenced vertex: 1 at best.
+//!
+struct VertexCacheStatistics
+{
+    uint32_t transformedVertexCount = 0;
+    uint32_t referencedVertexCount  = 0;
+    float    acmr                   = 0;
+    float    atvr                   = 0;
+};
+
+//! @brief Simulates a FIFO post-transform vertex cache over a triangle list.
+//! @param pIndices The triangle list, 3 indices per triangle.
+//! @param indexCount The number of indices.
+//! @param vertexCount The number of vertices, every index must be less than it.
+//! @param cacheSize The number of vertices that the cache holds.
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kDefaultVertexCacheSize);
+
+//! @brief Reorders the triangles of a triangle list in place for the
+//!        post-transform vertex cache.
+//!
+//! Implements Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", which
+//! greedily emits the triangle with the highest score, the score favouring
+//! vertices that are in a simulated LRU cache and vertices with few
+//! triangles left. The result is good for any cache size and type.
+void OptimizeVertexCache(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount);
+
+//! @brief Reorders clusters of triangles in place to reduce overdraw.
+//! @param pIndices The triangle list, which should already be optimized with OptimizeVertexCache.
+//! @param pPositions The vertex positions.
+//! @param threshold The ACMR increase accepted in exchange for finer clusters, 1 to keep the ACMR.
+//!
+//! Implements the cluster sort of Sander et al., "Fast Triangle Reordering
+//! for Vertex Locality and Reduced Overdraw". The triangles are split into
+//! clusters where the cache is flushed, or where the ACMR of the cluster so
+//! far is within threshold of the ACMR of the whole run. The clusters are
+//! then sorted so that the ones facing away from the center of the mesh, which
+//! are more likely to occlude the others, come first.
+void OptimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float3* pPositions, uint32_t vertexCount, float threshold = kDefaultOverdrawThreshold);
+
+//! @brief Renumbers vertices in the order in which the triangles first use
+//!        them, so that the vertex fetches are mostly sequential.
+//! @param pIndices The triangle list, which is rewritten with the new vertex numbers.
+//! @param pRemap The new number of each vertex, of size vertexCount. Unreferenced vertices are numbered last, in their original order.
+//! @return The number of referenced vertices.
+uint32_t OptimizeVertexFetchRemap(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* pRemap);
+
+//! @brief Moves the elements of a vertex attribute array to their remapped positions.
+//! @param pRemap The remap table returned by OptimizeVertexFetchRemap.
+//! @param elementSize The number of T per vertex, e.g. the dimension of texture coordinates stored as floats.
+template <typename T>
+void RemapVertexAttribute(const std::vector<uint32_t>& remap, std::vector<T>* pAttribute, size_t elementSize = 1)
+{
+    if (pAttribute->size() != remap.size() * elementSize) {
+        return;
+    }
+    std::vector<T> remapped(pAttribute->size());
+    for (size_t i = 0; i < remap.size(); ++i) {
+        for (size_t j = 0; j < elementSize; ++j) {
+            remapped[remap[i] * elementSize + j] = (*pAttribute)[i * elementSize + j];
+        }
+    }
+    pAttribute->swap(remapped);
+}
+
+} // namespace ppx
+
+#endif // ppx_mesh_optimizer_h
@@ -0,0 +1,134 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_meshlet_h
+#define ppx_meshlet_h
+
+#include "ppx/bounding_volume.h"
+#include "ppx/tri_mesh.h"
+
+namespace ppx {
+
+//! Default meshlet limits, which fit the output limits of mesh shaders on
+//! most GPUs.
+constexpr uint32_t kDefaultMeshletMaxVertices  = 64;
+constexpr uint32_t kDefaultMeshletMaxTriangles = 124;
+
+//! Largest supported limits: meshlet vertices are addressed with 8 bits.
+constexpr uint32_t kMeshletMaxVertices  = 256;
+constexpr uint32_t kMeshletMaxTriangles = 512;
+
+//! Meshlets are built over consecutive ranges of this many triangles, which
+//! are processed in parallel. Meshlets never span two ranges, so the result
+//! does not depend on the number of threads.
+constexpr uint32_t kMeshletBuildRangeTriangleCount = 16384;
+
+//! @struct Meshlet
+//!
+//! A cluster of triangles of a mesh, with its bounds.
+//!
+//! The meshlet uses vertexCount entries of MeshletData::vertices starting at
+//! vertexOffset, which are vertex indices of the mesh. Its triangles are
+//! triangleCount triplets of MeshletData::triangles starting at the triplet
+//! triangleOffset, which index these entries.
+//!
+//! The normal cone bounds the normals of the triangles: the meshlet faces
+//! away from a camera at position p, and can be culled, if
+//!   dot(normalize(coneApex - p), coneAxis) >= coneCutoff
+//! When the normals are too spread out for the cone to be useful, coneAxis
+//! is zero and coneCutoff is 1, so that the test always fails.
+//!
+struct Meshlet
+{
+    uint32_t vertexOffset   = 0;
+    uint32_t vertexCount    = 0;
+    uint32_t triangleOffset = 0;
+    uint32_t triangleCount  = 0;
+    AABB     bounds;
+    float3   sphereCenter = float3(0);
+    float    sphereRadius = 0;
+    float3   coneApex     = float3(0);
+    float3   coneAxis     = float3(0);
+    float    coneCutoff   = 1;
+};
+
+//! @struct MeshletDescriptor
+//!
+//! GPU layout of a meshlet, with std430 compatible alignment. The counts are
+//! packed as vertexCount | (triangleCount << 16).
+//!
+struct MeshletDescriptor
+{
+    float3   sphereCenter;
+    float    sphereRadius;
+    float3   coneApex;
+    float    coneCutoff;
+    float3   coneAxis;
+    uint32_t vertexOffset;
+    float3   boundsMin;
+    uint32_t triangleOffset;
+    float3   boundsMax;
+    uint32_t counts;
+};
+
+//! @struct MeshletData
+//!
+//! The meshlets of a mesh, with the vertex and triangle lists they share.
+//!
+struct MeshletData
+{
+    std::vector<Meshlet>  meshlets;
+    std::vector<uint32_t> vertices;  // Mesh vertex index of each meshlet vertex
+    std::vector<uint8_t>  triangles; // Meshlet vertex indices, 3 per triangle
+
+    uint32_t GetCountMeshlets() const { return CountU32(meshlets); }
+
+    //! Returns the GPU layout of a meshlet.
+    MeshletDescriptor GetDescriptor(uint32_t meshletIndex) const;
+};
+
+//! @brief Partitions a triangle list into meshlets and computes their bounds.
+//! @param pIndices The triangle list, 3 indices per triangle.
+//! @param pPositions The vertex positions.
+//! @param maxVertices The maximum number of vertices of a meshlet, at most kMeshletMaxVertices.
+//! @param maxTriangles The maximum number of triangles of a meshlet, at most kMeshletMaxTriangles.
+//! @param threadCount The number of threads to build with, 0 to pick it from the triangle count and the hardware concurrency.
+//!
+//! Triangles are added to the current meshlet in order until one of the
+//! limits is reached, so the meshlets are as coherent as the triangle order:
+//! meshes should be optimized for the vertex cache first, see
+//! TriMeshOptions::OptimizeVertexCache. Returns ERROR_OUT_OF_RANGE if the
+//! limits are out of range or an index is not less than vertexCount.
+Result BuildMeshlets(
+    const uint32_t* pIndices,
+    size_t          indexCount,
+    const float3*   pPositions,
+    uint32_t        vertexCount,
+    uint32_t        maxVertices,
+    uint32_t        maxTriangles,
+    MeshletData*    pMeshletData,
+    uint32_t        threadCount = 0);
+
+//! @brief Partitions the triangles of a mesh into meshlets.
+//! @see BuildMeshlets
+Result BuildMeshlets(
+    const TriMesh& mesh,
+    MeshletData*   pMeshletData,
+    uint32_t       maxVertices  = kDefaultMeshletMaxVertices,
+    uint32_t       maxTriangles = kDefaultMeshletMaxTriangles,
+    uint32_t       threadCount  = 0);
+
+} // namespace ppx
+
+#endif // ppx_meshlet_h
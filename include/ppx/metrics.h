@@ -18,10 +18,13 @@
 #include "nlohmann/json.hpp"
 #include "ppx/config.h"
 
+#include <atomic>
 #include <filesystem>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -52,6 +55,18 @@ enum class MetricInterpretation
     LOWER_IS_BETTER,
 };
 
+// How a gauge computes its complex statistics.
+enum class GaugeMode
+{
+    // Every entry is kept and statistics are exact. Memory grows with the
+    // number of entries.
+    EXACT,
+    // Entries are folded into a QuantileSketch and running moments. Memory is
+    // constant and percentiles are within QuantileSketch::kDefaultRelativeAccuracy
+    // relative error. The raw time series is only kept if requested.
+    STREAMING,
+};
+
 struct Range
 {
     double lowerBound = std::numeric_limits<double>::min();
@@ -66,6 +81,12 @@ struct MetricMetadata
     MetricInterpretation interpretation = MetricInterpretation::NONE;
     Range                expectedRange;
 
+    // Gauges only.
+    GaugeMode gaugeMode = GaugeMode::EXACT;
+    // Gauges in GaugeMode::STREAMING only: also keep the raw time series so
+    // that it is exported with the report.
+    bool keepTimeSeries = false;
+
     nlohmann::json Export() const;
 };
 
@@ -92,6 +113,74 @@ struct MetricData
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Mergeable quantile sketch with bounded relative error (DDSketch).
+// Values are mapped to logarithmically sized buckets, so any quantile
+// estimate q' of a true quantile q satisfies |q' - q| <= relativeAccuracy * |q|.
+// Memory is bounded by maxBucketCount per sign: when a store would exceed it,
+// the buckets of the smallest magnitudes are collapsed together, which only
+// affects the accuracy of the lowest quantiles.
+class QuantileSketch
+{
+public:
+    static constexpr double   kDefaultRelativeAccuracy = 0.01;
+    static constexpr uint32_t kDefaultMaxBucketCount   = 2048;
+
+    QuantileSketch(double relativeAccuracy = kDefaultRelativeAccuracy, uint32_t maxBucketCount = kDefaultMaxBucketCount);
+
+    // NaN and infinite values are ignored.
+    void Add(double value);
+
+    // Both sketches must have been created with the same parameters.
+    bool Merge(const QuantileSketch& other);
+
+    // Returns an estimate of the value at the given 0-based rank, using the
+    // same rank convention as a sorted array of all the added values.
+    double GetValueAtRank(uint64_t rank) const;
+
+    uint64_t GetCount() const { return mCount; }
+    double   GetRelativeAccuracy() const { return mRelativeAccuracy; }
+
+private:
+    // Buckets for values of one sign, indexed by ceil(log_gamma(|value|)).
+    struct Store
+    {
+        std::vector<uint64_t> counts;
+        int32_t               minIndex = 0;
+        uint64_t              total    = 0;
+
+        void     Add(int32_t index, uint64_t count, uint32_t maxBucketCount);
+        int32_t  GetIndexAtRank(uint64_t rank) const;
+        int32_t  GetMaxIndex() const { return minIndex + static_cast<int32_t>(counts.size()) - 1; }
+    };
+
+    int32_t GetIndex(double absValue) const;
+    double  GetValue(int32_t index) const;
+
+private:
+    double   mRelativeAccuracy = 0.0;
+    uint32_t mMaxBucketCount   = 0;
+    double   mGamma            = 0.0;
+    double   mLogGamma         = 0.0;
+    uint64_t mCount            = 0;
+    uint64_t mZeroCount        = 0;
+    Store    mPositive;
+    Store    mNegative;
+};
+
+// Running mean and variance (Welford), mergeable with Chan's parallel update.
+struct RunningMoments
+{
+    uint64_t count = 0;
+    double   mean  = 0.0;
+    double   m2    = 0.0;
+
+    void   Add(double value);
+    void   Merge(const RunningMoments& other);
+    double GetVariance() const { return (count > 0) ? (m2 / static_cast<double>(count)) : 0.0; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 // Interface for all metric types.
 class Metric
 {
@@ -122,6 +211,9 @@ struct GaugeBasicStatistics
 
 // Complex statistics cannot be computed on the fly.
 // They require significant computation (e.g. sorting).
+// For gauges in GaugeMode::STREAMING they are estimated instead: percentiles
+// and the median are within QuantileSketch::kDefaultRelativeAccuracy relative
+// error, and the standard deviation is exact up to floating point error.
 struct GaugeComplexStatistics
 {
     double median            = 0.0;
@@ -152,6 +244,8 @@ public:
 
     // Exports this metric in JSON format.
     nlohmann::json Export() const override;
+    // Exports the "statistics" object of Export() only.
+    nlohmann::json ExportStatistics() const;
 
     MetricType GetType() const override
     {
@@ -175,13 +269,26 @@ private:
     }
     METRICS_NO_COPY(MetricGauge)
 
+    bool IsStreaming() const { return mMetadata.gaugeMode == GaugeMode::STREAMING; }
+    bool KeepsTimeSeries() const { return !IsStreaming() || mMetadata.keepTimeSeries; }
+
     GaugeComplexStatistics ComputeComplexStats() const;
 
+private:
+    GaugeComplexStatistics EstimateComplexStats() const;
+
 private:
     MetricMetadata               mMetadata;
     std::vector<TimeSeriesEntry> mTimeSeries;
     GaugeBasicStatistics         mBasicStats;
     double                       mAccumulatedValue = 0.0;
+    size_t                       mEntryCount       = 0;
+    double                       mFirstSeconds     = 0.0;
+    double                       mLastSeconds      = 0.0;
+
+    // GaugeMode::STREAMING only.
+    QuantileSketch mSketch;
+    RunningMoments mMoments;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -273,10 +380,13 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class BinaryReportWriter;
+
 class Manager final
 {
 public:
-    Manager() = default;
+    Manager();
+    ~Manager();
 
     // Starts a run. There may only be one active run at a time.
     void StartRun(const std::string& name);
@@ -292,16 +402,52 @@ public:
     // Records data for the given metric ID. Metrics for completed runs will be discarded.
     bool RecordMetricData(MetricID id, const MetricData& data);
 
+    // Records data for the given metric ID from any thread. The data is appended
+    // to a buffer owned by the calling thread without taking any lock, and is
+    // only applied to the metric by FlushConcurrentData. Validation happens at
+    // that point too, so this only returns false if there is no active run.
+    // Entries are tagged with the run they were recorded in; entries that
+    // race with EndRun may be dropped, but never reach a later run.
+    // Gauge entries from all threads are applied in 'seconds' order within a
+    // flush; entries older than the last entry applied by a previous flush
+    // are ignored, as with RecordMetricData.
+    bool RecordMetricDataConcurrent(MetricID id, const MetricData& data);
+
+    // Applies the data recorded with RecordMetricDataConcurrent to the metrics
+    // of the active run. Must be called from the thread that owns the manager,
+    // typically at frame boundaries. Data for completed runs is discarded.
+    void FlushConcurrentData();
+
     // Exports all the runs and metrics information into a report. Does NOT close the
-    // current run.
-    Report CreateReport(const std::string& reportPath) const;
+    // current run. Pending concurrent data is flushed first.
+    Report CreateReport(const std::string& reportPath);
 
     // Get Gauge Basic Statistics, only works for type GAUGE
     GaugeBasicStatistics GetGaugeBasicStatistics(MetricID id) const;
 
+    // Streams all subsequent runs to a binary report (see BinaryReportWriter)
+    // as they are recorded. Must be called while no run is active.
+    bool StartBinaryReport(const std::string& reportPath, bool overwriteExisting = false);
+    // Closes the binary report. Entries of an active run are written, but
+    // its statistics are only written when a run ends.
+    void StopBinaryReport();
+
 private:
     METRICS_NO_COPY(Manager)
 
+    struct PendingEntry
+    {
+        uint64_t   runEpoch;
+        MetricID   id;
+        MetricData data;
+    };
+
+    // Unbounded single-producer single-consumer queue of pending entries.
+    // The producer is the recording thread, the consumer is FlushConcurrentData.
+    class ThreadBuffer;
+
+    ThreadBuffer* GetThreadBuffer();
+
 private:
     std::unordered_map<std::string, std::unique_ptr<Run>> mRuns;
 
@@ -313,6 +459,20 @@ private:
 
     // Convenient to store with the manager, so the hop of going through the Run isn't necessary.
     std::unordered_map<MetricID, Metric*> mActiveMetrics;
+
+    // Concurrent recording. Thread buffers are created on first use by each
+    // thread and live as long as the manager. The run epoch is published to
+    // recording threads while a run accepts concurrent data, 0 otherwise.
+    const uint64_t                                                     mInstanceId;
+    uint64_t                                                           mActiveRunEpoch     = 0;
+    uint64_t                                                           mNextRunEpoch       = 1;
+    std::atomic<uint64_t>                                              mConcurrentRunEpoch = 0;
+    std::mutex                                                         mThreadBuffersMutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<ThreadBuffer>> mThreadBuffers;
+    std::vector<PendingEntry>                                          mPendingEntries;
+
+    // Set while a binary report is being written, otherwise null.
+    std::unique_ptr<BinaryReportWriter> mBinaryReport;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
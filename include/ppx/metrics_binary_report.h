@@ -0,0 +1,108 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_metrics_binary_report_h
+#define ppx_metrics_binary_report_h
+
+#include "ppx/metrics.h"
+
+#include <fstream>
+
+namespace ppx {
+namespace metrics {
+
+// Compact columnar alternative to the JSON report, written incrementally
+// while the runs are recorded.
+//
+// All integers and floats are little-endian. The file starts with the magic
+// "PPXM" and a uint32 version, followed by a sequence of chunks:
+//
+//   uint32 chunkId (four characters), uint32 payloadSize, payload
+//
+// Strings are stored as a uint32 length followed by the characters.
+//
+//   HEAD  string filename, string generatedAt
+//   RUN   string name; starts a run, later chunks belong to it
+//   META  uint32 metricId, uint32 type, string name, string unit,
+//         uint32 interpretation, f64 expectedLowerBound, f64 expectedUpperBound
+//   GAUG  uint32 metricId, uint32 count, int64 firstNanos,
+//         (count - 1) LEB128 nanosecond deltas, count f32 values
+//   GSTA  uint32 metricId, uint32 fieldCount, fieldCount x (string name, f64 value)
+//   CNTR  uint32 metricId, uint64 value, uint64 entryCount
+//   END   (empty); ends the current run
+//
+// Gauge timestamps are quantized to nanoseconds and values are stored as
+// 32-bit floats. Gauge statistics are computed from the full precision data
+// and written when the run ends. Gauge entries are written regardless of
+// MetricMetadata::keepTimeSeries.
+//
+// ReadBinaryReport and tools/metrics-binary-to-json.py convert a file back
+// to the JSON report schema.
+class BinaryReportWriter final
+{
+public:
+    static constexpr uint32_t kVersion             = 1;
+    static constexpr uint32_t kGaugeEntriesPerBlock = 4096;
+
+    BinaryReportWriter() = default;
+    ~BinaryReportWriter();
+
+    // Opens the file for writing. Any `@` in the filename is replaced with the
+    // current timestamp, and relative paths are resolved against the default
+    // output directory, as with Report.
+    bool Open(const std::string& reportPath, bool overwriteExisting);
+    // Flushes any pending gauge entries and closes the file.
+    void Close();
+    bool IsOpen() const { return mFile.is_open(); }
+
+    const std::filesystem::path& GetFilePath() const { return mFilePath; }
+
+    void BeginRun(const std::string& name);
+    void AddMetric(MetricID id, const MetricMetadata& metadata);
+    void AppendGaugeEntry(MetricID id, double seconds, double value);
+    // Writes the final statistics of a gauge, as exported in the JSON report.
+    // Pending entries of the gauge are written first.
+    void WriteGaugeStatistics(MetricID id, const nlohmann::json& statistics);
+    // Writes the final value of a counter, from its JSON export.
+    void WriteCounterSummary(MetricID id, const nlohmann::json& exported);
+    void EndRun();
+
+private:
+    struct GaugeColumns
+    {
+        std::vector<int64_t> nanos;
+        std::vector<float>   values;
+    };
+
+    void WriteGaugeBlock(MetricID id, GaugeColumns* pColumns);
+    void WriteChunk(const char* chunkId, const std::vector<uint8_t>& payload);
+
+private:
+    std::filesystem::path                      mFilePath;
+    std::ofstream                              mFile;
+    std::unordered_map<MetricID, GaugeColumns> mGauges;
+    // In the order they were added, so that blocks are written deterministically.
+    std::vector<MetricID> mGaugeOrder;
+    std::vector<uint8_t>  mScratch;
+};
+
+// Reads a binary report and converts it to the JSON report schema.
+// Runs that were not ended (e.g. the application crashed) are still
+// converted, but their gauges have no statistics.
+bool ReadBinaryReport(const std::filesystem::path& path, nlohmann::json* pContent);
+
+} // namespace metrics
+} // namespace ppx
+
+#endif // ppx_metrics_binary_report_h
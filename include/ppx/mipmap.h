@@ -16,6 +16,7 @@
 #define ppx_mipmap_h
 
 #include "ppx/bitmap.h"
+#include "ppx/scratch_pool.h"
 #include "ppx/grfx/grfx_constants.h"
 
 namespace ppx {
@@ -40,13 +41,14 @@ class Mipmap
 {
 public:
     Mipmap() {}
-    // Using the static, shared-memory pool is currently only safe in single-threaded applications!
-    // This should only be used for temporary mipmaps which will be destroyed prior to the creation of any new mipmap.
+    // Takes the storage from ScratchPool if useStaticPool is true, which is safe from any thread.
+    // This should only be used for temporary mipmaps, so that the storage is recycled quickly.
     Mipmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t levelCount, bool useStaticPool);
     Mipmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t levelCount);
-    // Using the static, shared-memory pool is currently only safe in single-threaded applications!
-    // This should only be used for temporary mipmaps which will be destroyed prior to the creation of any new mipmap.
-    Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool);
+    // Takes the storage from ScratchPool if useStaticPool is true, which is safe from any thread.
+    // This should only be used for temporary mipmaps, so that the storage is recycled quickly.
+    // Levels are generated with Bitmap::DownsampleTo, in linear space for 8-bit color channels if srgb is true.
+    Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool, bool srgb = false);
     Mipmap(const Bitmap& bitmap, uint32_t levelCount);
     ~Mipmap() {}
 
@@ -69,11 +71,9 @@ private:
     std::vector<char>   mData;
     std::vector<Bitmap> mMips;
 
-    // Static, shared-memory pool for temporary mipmap generation.
-    // NOTE: This is designed for single-threaded use ONLY as it's an unprotected memory block!
-    // This will need locks if the consuming paths ever become multi-threaded.
-    static std::vector<char> mStaticData;
-    bool                     mUseStaticPool = false;
+    // Pooled storage for temporary mipmap generation.
+    ScratchPool::Block mPoolBlock;
+    bool               mUseStaticPool = false;
 };
 
 } // namespace ppx
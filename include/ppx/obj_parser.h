@@ -0,0 +1,74 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_obj_parser_h
+#define ppx_obj_parser_h
+
+#include "ppx/config.h"
+#include "ppx/math_config.h"
+
+#include <filesystem>
+
+namespace ppx {
+
+//! @struct ObjIndex
+//!
+//! Zero-based indices of the attributes of a face corner, -1 if the
+//! corner does not reference the attribute.
+//!
+struct ObjIndex
+{
+    int32_t position = -1;
+    int32_t texCoord = -1;
+    int32_t normal   = -1;
+};
+
+//! @struct ObjData
+//!
+//! Geometry of an OBJ file. Faces are fan triangulated, so indices holds
+//! 3 corners per triangle. A shape starts at each non-empty `o` or `g`
+//! group; shapeFirstTriangles holds the first triangle of each shape and
+//! always starts with 0 when there are triangles.
+//!
+struct ObjData
+{
+    std::vector<float3>   positions;
+    std::vector<float3>   normals;
+    std::vector<float2>   texCoords;
+    std::vector<ObjIndex> indices;
+    std::vector<uint32_t> shapeFirstTriangles;
+
+    uint32_t GetCountTriangles() const { return static_cast<uint32_t>(indices.size() / 3); }
+};
+
+//! @brief Parses OBJ text in place.
+//! @param pText The OBJ text, it does not need to be null terminated.
+//! @param size The size of the text, in bytes.
+//! @param pObjData The parsed geometry.
+//! @param threadCount The number of threads to parse with, 0 to pick it from the size of the text and the hardware concurrency.
+//!
+//! The text is split into chunks on line boundaries, which are parsed in
+//! parallel. Only the geometry statements (v, vt, vn, f, o and g) are
+//! interpreted; all other statements, including materials, are ignored.
+//! Returns ERROR_GEOMETRY_FILE_LOAD_FAILED if a statement is malformed or
+//! an index is out of range.
+Result ParseOBJ(const char* pText, size_t size, ObjData* pObjData, uint32_t threadCount = 0);
+
+//! @brief Loads and parses an OBJ file; the file is memory-mapped when possible.
+//! @see ParseOBJ
+Result LoadOBJ(const std::filesystem::path& path, ObjData* pObjData, uint32_t threadCount = 0);
+
+} // namespace ppx
+
+#endif // ppx_obj_parser_h
@@ -0,0 +1,63 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_parallel_h
+#define ppx_parallel_h
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace ppx {
+
+// Returns the number of threads to split workCount items over, so that each
+// thread gets at least minWorkPerThread items. The result is at least 1, at
+// most the hardware concurrency, and at most maxThreadCount if it is not 0.
+inline uint32_t GetParallelThreadCount(size_t workCount, size_t minWorkPerThread, uint32_t maxThreadCount = 0)
+{
+    size_t count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    if (maxThreadCount > 0) {
+        count = std::min<size_t>(count, maxThreadCount);
+    }
+    count = std::min<size_t>(count, workCount / std::max<size_t>(minWorkPerThread, 1));
+    return static_cast<uint32_t>(std::max<size_t>(count, 1));
+}
+
+// Splits [0, count) into threadCount contiguous ranges of nearly equal size
+// and calls fn(rangeIndex, begin, end) for each of them in parallel. The
+// calling thread processes the first range. Returns once all ranges are done.
+template <typename Fn>
+void ParallelForRanges(size_t count, uint32_t threadCount, Fn&& fn)
+{
+    threadCount = std::max<uint32_t>(threadCount, 1);
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        size_t begin = (count * i) / threadCount;
+        size_t end   = (count * (i + 1)) / threadCount;
+        threads.emplace_back([&fn, i, begin, end]() { fn(i, begin, end); });
+    }
+
+    fn(0u, static_cast<size_t>(0), count / threadCount);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace ppx
+
+#endif // ppx_parallel_h
@@ -0,0 +1,67 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_pipeline_cache_file_h
+#define ppx_pipeline_cache_file_h
+
+#include "ppx/config.h"
+
+#include <filesystem>
+
+namespace ppx {
+
+//! @struct PipelineCacheDeviceInfo
+//!
+//! Identifies the driver that produced the data of a pipeline cache. Data
+//! from a different device or driver version is never loaded.
+//!
+struct PipelineCacheDeviceInfo
+{
+    uint32_t vendorId      = 0;
+    uint32_t deviceId      = 0;
+    uint32_t driverVersion = 0;
+    uint8_t  cacheUuid[16] = {};
+};
+
+//! @class PipelineCacheFile
+//!
+//! Stores the opaque data of an API pipeline cache on disk, such as the one
+//! returned by vkGetPipelineCacheData.
+//!
+//! All values are little-endian:
+//!
+//!   char[4] magic "PPPC", uint32 version,
+//!   uint32 vendorId, uint32 deviceId, uint32 driverVersion, uint8[16] cacheUuid,
+//!   uint64 dataSize, uint64 dataHash, data
+//!
+//! dataHash is the XXH64 hash of the data, which rejects truncated or
+//! corrupted files before the data reaches the driver.
+//!
+class PipelineCacheFile
+{
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    //! Reads the data of \b path into \b pData. Fails if the file is
+    //! missing, corrupted, or was written for another device or driver.
+    static Result Load(const std::filesystem::path& path, const PipelineCacheDeviceInfo& deviceInfo, std::vector<char>* pData);
+
+    //! Writes \b size bytes of \b pData to \b path. The file is replaced
+    //! atomically, so that a crash never leaves a partial file behind.
+    static Result Save(const std::filesystem::path& path, const PipelineCacheDeviceInfo& deviceInfo, const void* pData, size_t size);
+};
+
+} // namespace ppx
+
+#endif // ppx_pipeline_cache_file_h
@@ -18,6 +18,9 @@
 #include "ppx/config.h"
 #include "xxhash.h"
 
+#include <atomic>
+#include <filesystem>
+
 namespace ppx {
 
 enum ProfilerEventType
@@ -34,7 +37,26 @@ enum ProfileEventRecordAction
 
 // -------------------------------------------------------------------------------------------------
 
-using ProfilerEventToken = XXH64_hash_t;
+// A token is the dense index of an event in the per-thread event tables.
+// RegisterEvent() assigns the same index on every per-thread profiler, so
+// recording a sample is a direct array access rather than a search.
+using ProfilerEventToken = uint32_t;
+
+static constexpr ProfilerEventToken kInvalidProfilerEventToken = UINT32_MAX;
+
+// -------------------------------------------------------------------------------------------------
+
+// A counter token is the index of a counter in the global counter table.
+using ProfilerCounterToken = uint32_t;
+
+static constexpr ProfilerCounterToken kInvalidProfilerCounterToken = UINT32_MAX;
+
+// Value of a counter, see Profiler::GetCounters().
+struct ProfilerCounterValue
+{
+    std::string name;
+    uint64_t    value;
+};
 
 // -------------------------------------------------------------------------------------------------
 
@@ -44,6 +66,59 @@ struct ProfilerEventSample
     uint64_t endTimestamp;
 };
 
+// Sample drained from a per-thread ring buffer, see Profiler::DrainSamples().
+struct ProfilerThreadSample
+{
+    ProfilerEventToken  token;
+    uint32_t            threadIndex;
+    ProfilerEventSample sample;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+// Fixed-capacity, lock-free, single-producer/single-consumer queue of samples.
+// The owning thread pushes from the recording hot path and a drain thread pops.
+// Pushing never allocates or blocks: when the buffer is full the sample is
+// dropped and counted instead.
+class ProfilerSampleRingBuffer
+{
+public:
+    struct Entry
+    {
+        ProfilerEventToken  token;
+        ProfilerEventSample sample;
+    };
+
+    // Capacity is rounded up to the next power of two.
+    ProfilerSampleRingBuffer(uint32_t capacity);
+    ~ProfilerSampleRingBuffer();
+
+    // Producer side.
+    bool Push(const Entry& entry);
+
+    // Consumer side.
+    bool Pop(Entry* pEntry);
+    // Only counts the samples dropped from now on. The producer is the only
+    // writer of the count, so the consumer moves a baseline instead.
+    void ResetDroppedCount();
+
+    uint32_t GetCapacity() const { return mCapacity; }
+    uint32_t GetSize() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    std::unique_ptr<Entry[]> mEntries;
+    uint32_t                 mCapacity = 0;
+    uint32_t                 mMask     = 0;
+
+    // Kept on separate cache lines so the producer and the consumer don't
+    // contend on the same line.
+    alignas(64) std::atomic<uint64_t> mWriteIndex   = 0;
+    alignas(64) std::atomic<uint64_t> mReadIndex    = 0;
+    std::atomic<uint64_t>             mDroppedCount = 0;
+    std::atomic<uint64_t>             mDroppedBase  = 0; // Value of mDroppedCount at the last reset
+};
+
 // -------------------------------------------------------------------------------------------------
 
 class ProfilerScopedEventSample
@@ -62,13 +137,14 @@ private:
 class ProfilerEvent
 {
 public:
-    ProfilerEvent(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, const ProfilerEventToken& token);
+    ProfilerEvent(ProfilerEventType type, const std::string& name, XXH64_hash_t nameHash, ProfileEventRecordAction recordAction, const ProfilerEventToken& token);
     ~ProfilerEvent();
 
     ProfilerEventType                GetType() const { return mType; }
     const std::string&               GetName() const { return mName; }
+    ProfileEventRecordAction         GetRecordAction() const { return mAction; }
     const ProfilerEventToken&        GetToken() const { return mToken; }
-    std::vector<ProfilerEventSample> GetSamples() const { return mSamples; }
+    XXH64_hash_t                     GetNameHash() const { return mNameHash; }
     uint64_t                         GetSampleCount() const { return mSampleCount; }
     uint64_t                         GetSampleTotal() const { return mSampleTotal; }
     uint64_t                         GetSampleMin() const { return mSampleMin; }
@@ -80,15 +156,19 @@ private:
     friend class Profiler;
 
 private:
-    ProfilerEventType                mType = PROFILER_EVENT_TYPE_UNDEFINED;
-    std::string                      mName;
-    ProfileEventRecordAction         mAction;
-    ProfilerEventToken               mToken = 0;
-    std::vector<ProfilerEventSample> mSamples;                  // PROFILER_EVENT_RECORD_ACTION_INSERT
-    uint64_t                         mSampleCount = 0;          // PROFILER_EVENT_RECORD_ACTION_AVERAGE
-    uint64_t                         mSampleTotal = 0;          // PROFILER_EVENT_RECORD_ACTION_AVERAGE
-    uint64_t                         mSampleMin   = UINT64_MAX; // PROFILER_EVENT_RECORD_ACTION_AVERAGE
-    uint64_t                         mSampleMax   = 0;          // PROFILER_EVENT_RECORD_ACTION_AVERAGE
+    ProfilerEventType        mType = PROFILER_EVENT_TYPE_UNDEFINED;
+    std::string              mName;
+    ProfileEventRecordAction mAction;
+    ProfilerEventToken       mToken    = kInvalidProfilerEventToken;
+    XXH64_hash_t             mNameHash = 0;
+
+    // Aggregates are kept for every record action. The individual samples of
+    // PROFILER_EVENT_RECORD_ACTION_INSERT events go to the ring buffer of the
+    // owning Profiler.
+    uint64_t mSampleCount = 0;
+    uint64_t mSampleTotal = 0;
+    uint64_t mSampleMin   = UINT64_MAX;
+    uint64_t mSampleMax   = 0;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -105,6 +185,37 @@ public:
     static Result RegisterEvent(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken* pToken);
     static Result RegisterGrfxApiFnEvent(const std::string& name, ProfilerEventToken* pToken);
 
+    // Moves the samples of PROFILER_EVENT_RECORD_ACTION_INSERT events out of
+    // the ring buffers of all threads and appends them to pSamples. Safe to
+    // call while other threads are recording samples.
+    static void DrainSamples(std::vector<ProfilerThreadSample>* pSamples);
+
+    // Number of samples dropped because a thread's ring buffer was full,
+    // since the last trace capture started.
+    static uint64_t GetDroppedSampleCount();
+
+    // Starts a background thread that drains the ring buffers every
+    // drainIntervalMs and streams the samples to path as Chrome trace-event
+    // JSON, which can be opened in chrome://tracing or ui.perfetto.dev.
+    // Nested ProfilerScopedEventSample scopes on a thread show up as nested
+    // slices. Samples recorded before the capture starts are discarded.
+    static Result StartTraceCapture(const std::filesystem::path& path, uint32_t drainIntervalMs = 10);
+    // Drains the remaining samples, stops the background thread and closes the file.
+    static Result StopTraceCapture();
+    static bool   IsTraceCaptureActive();
+
+    // Counters are totals shared by all threads, such as the number of
+    // descriptor writes issued. Registering the name of an existing counter
+    // returns its token.
+    static Result RegisterCounter(const std::string& name, ProfilerCounterToken* pToken);
+    // Lock-free. Tokens that were not returned by RegisterCounter() are ignored.
+    static void     AddToCounter(ProfilerCounterToken token, uint64_t value);
+    static uint64_t GetCounterValue(ProfilerCounterToken token);
+    // Replaces the contents of pCounters with the value of every counter, in
+    // registration order.
+    static void GetCounters(std::vector<ProfilerCounterValue>* pCounters);
+
+    // Tokens that were not returned by RegisterEvent() are ignored.
     void RecordSample(const ProfilerEventToken& token, const ProfilerEventSample& sample);
 
     // Removed all previously registered events. It is not safe to call this function while
@@ -114,10 +225,11 @@ public:
     const std::vector<ProfilerEvent>& GetEvents() const { return mEvents; }
 
 private:
-    Result RegisterEventInternal(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken token);
+    Result RegisterEventInternal(ProfilerEventType type, const std::string& name, XXH64_hash_t nameHash, ProfileEventRecordAction recordAction, ProfilerEventToken token);
 
 private:
     std::vector<ProfilerEvent> mEvents;
+    ProfilerSampleRingBuffer   mSampleRingBuffer;
 };
 
 } // namespace ppx
@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scratch_pool_h
+#define ppx_scratch_pool_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ppx {
+
+//! @class ScratchPool
+//!
+//! Thread-safe pool of memory blocks for temporary data, such as the mip
+//! chains generated while creating textures from bitmaps.
+//!
+//! Block sizes are rounded up to a power of two size class. A released block
+//! goes to a cache owned by the releasing thread, and the next acquisition of
+//! the same size class on that thread reuses it. Nothing is shared between
+//! threads, so acquiring and releasing blocks never takes a lock.
+//!
+//! Each thread caches at most kMaxCachedBlocksPerClass blocks per size class
+//! and at most kMaxThreadCacheSize bytes in total, so an idle thread holds no
+//! more than that. Releasing a block that does not fit frees the largest
+//! cached blocks first. Blocks larger than kMaxCachedBlockSize are never
+//! cached. Cached blocks are freed when their thread exits or calls
+//! TrimThreadCache().
+//!
+class ScratchPool
+{
+public:
+    static constexpr size_t   kMinBlockSize            = 64 * 1024;
+    static constexpr size_t   kMaxCachedBlockSize      = 128 * 1024 * 1024;
+    static constexpr size_t   kMaxThreadCacheSize      = 128 * 1024 * 1024;
+    static constexpr size_t   kBlockAlignment          = 64;
+    static constexpr uint32_t kMaxCachedBlocksPerClass = 2;
+
+    //! @class Block
+    //!
+    //! Owns a block of the pool, and returns it to the cache of the calling
+    //! thread when it's released or destroyed.
+    //!
+    class Block
+    {
+    public:
+        Block() {}
+        Block(Block&& other);
+        ~Block();
+
+        Block& operator=(Block&& other);
+
+        Block(const Block&)            = delete;
+        Block& operator=(const Block&) = delete;
+
+        char*  GetData() const { return mData; }
+        size_t GetSize() const { return mSize; }
+        void   Release();
+
+    private:
+        friend class ScratchPool;
+
+        char*  mData = nullptr;
+        size_t mSize = 0;
+    };
+
+    //! Returns a block of at least size bytes, aligned to kBlockAlignment.
+    //! The contents of the block are undefined. The block is empty if size
+    //! is 0.
+    static Block Acquire(size_t size);
+
+    //! Frees the blocks cached by the calling thread.
+    static void TrimThreadCache();
+
+    //! Returns the total size of the blocks cached by the calling thread.
+    static size_t GetThreadCacheSize();
+};
+
+} // namespace ppx
+
+#endif // ppx_scratch_pool_h
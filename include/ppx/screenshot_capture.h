@@ -0,0 +1,129 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_screenshot_capture_h
+#define ppx_screenshot_capture_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_queue.h"
+#include "ppx/grfx/grfx_sync.h"
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppx {
+
+//! @class ScreenshotCapture
+//!
+//! Saves images to PPM files without stalling the render loop. Capture records
+//! a copy of the image into one of a ring of GPU_TO_CPU buffers and submits it
+//! with a fence. Update, called once per frame, hands the buffers whose fence
+//! has signaled to a background thread that converts and writes them, and
+//! recycles the buffers that have been written.
+//!
+//! The copy is submitted to the queue after the work already submitted, so
+//! the image is captured as that work leaves it. Capture only waits when the
+//! next buffer of the ring is still in use, i.e. when captures are requested
+//! faster than they can be written.
+//!
+class ScreenshotCapture
+{
+public:
+    static constexpr uint32_t kDefaultRingSize = 3;
+
+    ScreenshotCapture() {}
+    ~ScreenshotCapture();
+
+    Result Create(grfx::Queue* pQueue, uint32_t ringSize = kDefaultRingSize);
+
+    //! Writes the pending captures, then destroys the GPU objects and stops
+    //! the background thread. Must be called before the device is destroyed.
+    void Destroy();
+
+    bool IsCreated() const { return !mSlots.empty(); }
+
+    //! Copies \b pImage, which must be in \b imageState, to be written to
+    //! \b path as a PPM file. Returns once the copy is submitted.
+    Result Capture(grfx::Image* pImage, grfx::ResourceState imageState, const std::filesystem::path& path);
+
+    //! Starts writing the captures whose copy has completed, and recycles
+    //! the buffers of the captures that have been written. Never waits.
+    void Update();
+
+    //! Waits until every capture has been written.
+    void Flush();
+
+private:
+    enum SlotState
+    {
+        SLOT_STATE_FREE    = 0,
+        SLOT_STATE_COPYING = 1, // Copy submitted, waiting for the fence.
+        SLOT_STATE_WRITING = 2, // Buffer mapped and queued for the thread.
+        SLOT_STATE_WRITTEN = 3, // Thread done, buffer still mapped.
+    };
+
+    struct Slot
+    {
+        grfx::BufferPtr        buffer;
+        grfx::CommandBufferPtr commandBuffer;
+        grfx::FencePtr         fence;
+        SlotState              state    = SLOT_STATE_FREE;
+        const void*            pTexels  = nullptr;
+        grfx::Format           format   = grfx::FORMAT_UNDEFINED;
+        uint32_t               width    = 0;
+        uint32_t               height   = 0;
+        uint32_t               rowPitch = 0;
+        std::filesystem::path  path;
+
+        // Vulkan images of FORMAT_R10G10B10A2_UNORM hold
+        // VK_FORMAT_A2R10G10B10_UNORM_PACK32 texels, with red in the high
+        // bits. They are swizzled into this buffer before being written.
+        bool                  redInHighBits = false;
+        std::vector<uint32_t> swizzledTexels;
+    };
+
+    // Blocks until the slot is free.
+    void WaitForSlot(Slot* pSlot);
+    // Maps the buffer of a slot whose copy has completed and queues it.
+    void BeginWrite(Slot* pSlot);
+    // Unmaps the buffer of a written slot and frees it.
+    void EndWrite(Slot* pSlot);
+    // Fills the swizzled texels of a slot whose texels have red in the high
+    // bits, for ExportToPPM.
+    void SwapRedBlue10(Slot* pSlot);
+    // Body of the background thread.
+    void WriteLoop();
+
+    grfx::Queue*      mQueue = nullptr;
+    std::vector<Slot> mSlots;
+    uint32_t          mNextSlot = 0;
+
+    // Guards the slot states and the write queue.
+    std::mutex              mMutex;
+    std::condition_variable mCondition;
+    std::deque<Slot*>       mWriteQueue;
+    bool                    mStopThread = false;
+    std::thread             mThread;
+};
+
+} // namespace ppx
+
+#endif // ppx_screenshot_capture_h
@@ -0,0 +1,178 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_slot_map_h
+#define ppx_slot_map_h
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ppx {
+
+//! @struct SlotHandle
+//!
+//! Index of a slot in a SlotMap, and generation of the slot when the value
+//! was inserted. The handle goes stale when the value is removed, even if
+//! the slot is reused afterward.
+//!
+struct SlotHandle
+{
+    static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    uint32_t index      = kInvalidIndex;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != kInvalidIndex; }
+
+    bool operator==(const SlotHandle& rhs) const { return (index == rhs.index) && (generation == rhs.generation); }
+    bool operator!=(const SlotHandle& rhs) const { return !(*this == rhs); }
+};
+
+//! @class SlotMap
+//!
+//! Unordered container with O(1) insertion, lookup and removal by handle.
+//! Values live in a vector of slots; free slots are linked through the
+//! slots themselves, and insertion takes the most recently freed slot
+//! before growing the vector. Removing a value increments the generation of
+//! its slot, so that stale handles are rejected.
+//!
+template <typename T>
+class SlotMap
+{
+public:
+    SlotMap() {}
+    ~SlotMap() {}
+
+    //! Stores \b value and returns its handle.
+    SlotHandle Insert(T value)
+    {
+        uint32_t index = mFreeHead;
+        if (index != SlotHandle::kInvalidIndex) {
+            mFreeHead = mSlots[index].nextFree;
+        }
+        else {
+            index = static_cast<uint32_t>(mSlots.size());
+            mSlots.emplace_back();
+        }
+        Slot& slot    = mSlots[index];
+        slot.value    = std::move(value);
+        slot.nextFree = SlotHandle::kInvalidIndex;
+        slot.occupied = true;
+        ++mCount;
+        return SlotHandle{index, slot.generation};
+    }
+
+    //! Removes the value of \b handle. Returns false if the handle is stale.
+    bool Remove(const SlotHandle& handle)
+    {
+        if (!Contains(handle)) {
+            return false;
+        }
+        Slot& slot    = mSlots[handle.index];
+        slot.value    = T();
+        slot.occupied = false;
+        slot.generation += 1;
+        slot.nextFree = mFreeHead;
+        mFreeHead     = handle.index;
+        --mCount;
+        return true;
+    }
+
+    bool Contains(const SlotHandle& handle) const
+    {
+        return (handle.index < mSlots.size()) && mSlots[handle.index].occupied && (mSlots[handle.index].generation == handle.generation);
+    }
+
+    //! Returns the value of \b handle, or nullptr if the handle is stale.
+    //! std::addressof() because ObjPtr overloads operator&.
+    T* Get(const SlotHandle& handle) { return Contains(handle) ? std::addressof(mSlots[handle.index].value) : nullptr; }
+
+    const T* Get(const SlotHandle& handle) const { return Contains(handle) ? std::addressof(mSlots[handle.index].value) : nullptr; }
+
+    //! Returns the handle of the first value for which \b predicate returns
+    //! true, or an invalid handle. Linear in the number of slots.
+    template <typename PredicateT>
+    SlotHandle FindIf(PredicateT predicate) const
+    {
+        for (uint32_t i = 0; i < GetSlotCount(); ++i) {
+            if (mSlots[i].occupied && predicate(mSlots[i].value)) {
+                return SlotHandle{i, mSlots[i].generation};
+            }
+        }
+        return SlotHandle{};
+    }
+
+    //! Number of slots, occupied or not. Slots are never released, so
+    //! iterating from 0 to GetSlotCount() with GetHandle() visits every value
+    //! even if values are removed along the way.
+    uint32_t GetSlotCount() const { return static_cast<uint32_t>(mSlots.size()); }
+
+    //! Returns the handle of the value in slot \b index, or an invalid handle
+    //! if the slot is free.
+    SlotHandle GetHandle(uint32_t index) const
+    {
+        return ((index < mSlots.size()) && mSlots[index].occupied) ? SlotHandle{index, mSlots[index].generation} : SlotHandle{};
+    }
+
+    uint32_t GetCount() const { return mCount; }
+    bool     IsEmpty() const { return mCount == 0; }
+
+    //! Calls \b func on every value, in slot order.
+    template <typename FuncT>
+    void ForEach(FuncT func)
+    {
+        for (Slot& slot : mSlots) {
+            if (slot.occupied) {
+                func(slot.value);
+            }
+        }
+    }
+
+    //! Removes every value. Handles issued before stay stale.
+    void Clear()
+    {
+        mFreeHead = SlotHandle::kInvalidIndex;
+        for (uint32_t i = GetSlotCount(); i > 0; --i) {
+            Slot& slot = mSlots[i - 1];
+            if (slot.occupied) {
+                slot.value    = T();
+                slot.occupied = false;
+                slot.generation += 1;
+            }
+            // Lowest slots first, as in a new map.
+            slot.nextFree = mFreeHead;
+            mFreeHead     = i - 1;
+        }
+        mCount = 0;
+    }
+
+private:
+    struct Slot
+    {
+        T        value      = T();
+        uint32_t generation = 0;
+        uint32_t nextFree   = SlotHandle::kInvalidIndex;
+        bool     occupied   = false;
+    };
+
+    std::vector<Slot> mSlots;
+    uint32_t          mFreeHead = SlotHandle::kInvalidIndex;
+    uint32_t          mCount    = 0;
+};
+
+} // namespace ppx
+
+#endif // ppx_slot_map_h
@@ -0,0 +1,123 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_task_pool_h
+#define ppx_task_pool_h
+
+#include "ppx/config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppx {
+
+enum TaskStatus
+{
+    TASK_STATUS_PENDING  = 0,
+    TASK_STATUS_RUNNING  = 1,
+    TASK_STATUS_COMPLETE = 2,
+    TASK_STATUS_CANCELED = 3,
+};
+
+namespace internal {
+
+struct TaskState;
+
+} // namespace internal
+
+//! @class TaskHandle
+//!
+//! Refers to a task submitted to a TaskPool. Copies refer to the same task.
+//! A handle stays usable after its pool is destroyed.
+//!
+class TaskHandle
+{
+public:
+    TaskHandle() {}
+    ~TaskHandle() {}
+
+    bool IsValid() const { return mState != nullptr; }
+
+    TaskStatus GetStatus() const;
+
+    //! Returns true once the task completed or was canceled.
+    bool IsDone() const;
+
+    //! Blocks until the task completed or was canceled.
+    void Wait() const;
+
+    //! Cancels the task if no thread took it yet, in which case its function
+    //! never runs. Returns false if the task is running or done.
+    bool Cancel();
+
+    //! Changes the priority of a task that is still pending.
+    void SetPriority(int32_t priority);
+
+private:
+    friend class TaskPool;
+    std::shared_ptr<internal::TaskState> mState;
+};
+
+//! @class TaskPool
+//!
+//! Fixed set of threads running submitted functions. A free thread takes
+//! the pending task with the highest priority, and the oldest one among
+//! tasks of equal priority. Taking a task is linear in the number of
+//! pending tasks, which suits batches of coarse tasks such as pipeline
+//! compilations.
+//!
+class TaskPool
+{
+public:
+    using TaskFunc = std::function<void()>;
+
+    TaskPool() {}
+    ~TaskPool();
+
+    Result Create(uint32_t threadCount);
+
+    //! Cancels the pending tasks, waits for the running ones and stops the
+    //! threads.
+    void Destroy();
+
+    bool IsCreated() const { return !mThreads.empty(); }
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(mThreads.size()); }
+
+    TaskHandle Submit(TaskFunc func, int32_t priority = 0);
+
+    //! Blocks until no task is pending or running.
+    void WaitIdle();
+
+private:
+    // Body of the threads.
+    void RunTasks();
+
+    std::mutex                                        mMutex;
+    std::condition_variable                           mCondition;
+    std::vector<std::shared_ptr<internal::TaskState>> mPendingTasks; // Can hold canceled tasks until a thread drops them
+    uint64_t                                          mNextSequence = 0;
+    uint32_t                                          mRunningCount = 0;
+    bool                                              mStopThreads  = false;
+    std::vector<std::thread>                          mThreads;
+};
+
+} // namespace ppx
+
+#endif // ppx_task_pool_h
@@ -0,0 +1,110 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_texture_cache_h
+#define ppx_texture_cache_h
+
+#include "ppx/bitmap.h"
+#include "ppx/cache_file.h"
+#include "ppx/mipmap.h"
+
+namespace ppx {
+
+//! @class TextureCacheFile
+//!
+//! CacheFile of a texture loaded from an image file, holding its decoded mip
+//! chain in the layout of the staging buffer, so that a cache hit is a single
+//! copy from the memory-mapped file.
+//!
+//! The key is the XXH64 hash of the content of the source file, the mip
+//! settings and the copy alignments of the API. Identical images share one
+//! file wherever they are on disk, and editing an image changes its key
+//! instead of invalidating a file. The magic is "PPTC", and the header is:
+//!
+//!   header: uint64 contentHash, uint32 mipLevelCount, uint32 sRGBMipFilter,
+//!           uint32 rowStrideAlignment, uint32 offsetAlignment,
+//!           uint32 format, uint32 levelCount, levelCount x (
+//!             uint32 width, uint32 height, uint32 rowStride, uint64 offset),
+//!           uint64 dataOffset, uint64 dataSize
+//!
+//! Level offsets are relative to the start of the data, which is aligned to
+//! kDataAlignment bytes from the start of the file. Each level has height rows
+//! of rowStride bytes, padded to rowStrideAlignment, and starts at a multiple
+//! of offsetAlignment.
+//!
+class TextureCacheFile : public CacheFile
+{
+public:
+    static constexpr uint32_t kVersion       = 1;
+    static constexpr uint32_t kDataAlignment = 16;
+
+    struct Key
+    {
+        uint64_t contentHash        = 0;
+        uint32_t mipLevelCount      = 1;
+        bool     sRGBMipFilter      = false;
+        uint32_t rowStrideAlignment = 1;
+        uint32_t offsetAlignment    = 1;
+    };
+
+    struct Level
+    {
+        uint32_t width     = 0;
+        uint32_t height    = 0;
+        uint32_t rowStride = 0;
+        uint64_t offset    = 0;
+    };
+
+    TextureCacheFile() {}
+    ~TextureCacheFile() {}
+
+    //! Returns the XXH64 hash of the content of a source file.
+    static uint64_t HashContent(const void* pData, size_t size);
+
+    //! Returns the path of the cache file of key.
+    static std::filesystem::path GetCachePath(const std::filesystem::path& cacheDirectory, const TextureCacheFile::Key& key);
+
+    //! Writes the first key.mipLevelCount levels of mipmap to cachePath, or
+    //! all of them if it has fewer.
+    static Result Write(
+        const std::filesystem::path& cachePath,
+        const TextureCacheFile::Key& key,
+        const Mipmap&                mipmap);
+
+    //! Maps cachePath. Returns ERROR_FAILED if the file does not exist, is
+    //! corrupt, or was written for another key.
+    Result Open(const std::filesystem::path& cachePath, const TextureCacheFile::Key& key);
+
+    Bitmap::Format GetFormat() const { return mFormat; }
+    uint32_t       GetLevelCount() const { return CountU32(mLevels); }
+    const Level&   GetLevel(uint32_t level) const { return mLevels[level]; }
+    //! Data of all levels, to be copied as is to a staging buffer.
+    const char*    GetData() const { return GetFileData() + mDataOffset; }
+    uint64_t       GetDataSize() const { return mDataSize; }
+
+private:
+    Bitmap::Format     mFormat = Bitmap::FORMAT_UNDEFINED;
+    std::vector<Level> mLevels;
+    uint64_t           mDataOffset = 0;
+    uint64_t           mDataSize   = 0;
+};
+
+//! Sets the directory where CreateTextureFromFile caches the textures it
+//! loads. An empty path, the default, disables the cache.
+void                  SetTextureCacheDirectory(const std::filesystem::path& directory);
+std::filesystem::path GetTextureCacheDirectory();
+
+} // namespace ppx
+
+#endif // ppx_texture_cache_h
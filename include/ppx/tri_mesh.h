@@ -17,6 +17,7 @@
 
 #include "ppx/config.h"
 #include "ppx/math_config.h"
+#include "ppx/mesh_optimizer.h"
 #include "ppx/grfx/grfx_config.h"
 
 #include <filesystem>
@@ -106,20 +107,31 @@ public:
     TriMeshOptions& InvertTexCoordsV() { mInvertTexCoordsV = true; return *this; }
     //! Inverts winding order of ONLY indices
     TriMeshOptions& InvertWinding() { mInvertWinding = true; return *this; }
+    //! Enable/disable reordering triangles for the vertex cache and vertices for fetch locality, indexed meshes only
+    TriMeshOptions& OptimizeVertexCache(bool value = true) { mOptimizeVertexCache = value; return *this; }
+    //! Set and/or enable/disable sorting triangle clusters to reduce overdraw, implies OptimizeVertexCache
+    TriMeshOptions& OptimizeOverdraw(float threshold = kDefaultOverdrawThreshold, bool enable = true) { mOverdrawThreshold = threshold; mOptimizeOverdraw = enable; return *this; }
     // clang-format on
+
+    //! Appends a binary representation of the options, e.g. to key caches of loaded meshes
+    void Serialize(std::vector<uint8_t>* pBytes) const;
+
 private:
-    bool   mEnableIndices      = false;
-    bool   mEnableVertexColors = false;
-    bool   mEnableNormals      = false;
-    bool   mEnableTexCoords    = false;
-    bool   mEnableTangents     = false;
-    bool   mEnableObjectColor  = false;
-    bool   mInvertTexCoordsV   = false;
-    bool   mInvertWinding      = false;
-    float3 mObjectColor        = float3(0.7f);
-    float3 mTranslate          = float3(0, 0, 0);
-    float3 mScale              = float3(1, 1, 1);
-    float2 mTexCoordScale      = float2(1, 1);
+    bool   mEnableIndices       = false;
+    bool   mEnableVertexColors  = false;
+    bool   mEnableNormals       = false;
+    bool   mEnableTexCoords     = false;
+    bool   mEnableTangents      = false;
+    bool   mEnableObjectColor   = false;
+    bool   mInvertTexCoordsV    = false;
+    bool   mInvertWinding       = false;
+    bool   mOptimizeVertexCache = false;
+    bool   mOptimizeOverdraw    = false;
+    float  mOverdrawThreshold   = kDefaultOverdrawThreshold;
+    float3 mObjectColor         = float3(0.7f);
+    float3 mTranslate           = float3(0, 0, 0);
+    float3 mScale               = float3(1, 1, 1);
+    float2 mTexCoordScale       = float2(1, 1);
     friend class TriMesh;
 };
 
@@ -191,6 +203,13 @@ public:
     Result GetTriangle(uint32_t triIndex, uint32_t& v0, uint32_t& v1, uint32_t& v2) const;
     Result GetVertexData(uint32_t vtxIndex, TriMeshVertexData* pVertexData) const;
 
+    //! Computes the post-transform vertex cache statistics of the triangles, which are all zero for non-indexed meshes
+    VertexCacheStatistics AnalyzeVertexCache(uint32_t cacheSize = kDefaultVertexCacheSize) const;
+
+    //! Reorders the triangles for the vertex cache, optionally sorts clusters of them to reduce overdraw,
+    //! then renumbers the vertices in the order the triangles use them. Does nothing for non-indexed meshes.
+    void OptimizeVertexCache(bool optimizeOverdraw = false, float overdrawThreshold = kDefaultOverdrawThreshold);
+
     static TriMesh CreatePlane(TriMeshPlane plane, const float2& size, uint32_t usegs, uint32_t vsegs, const TriMeshOptions& options = TriMeshOptions());
     static TriMesh CreateCube(const float3& size, const TriMeshOptions& options = TriMeshOptions());
     static TriMesh CreateSphere(float radius, uint32_t usegs, uint32_t vsegs, const TriMeshOptions& options = TriMeshOptions());
@@ -202,6 +221,9 @@ private:
     void AppendIndexU16(uint16_t value);
     void AppendIndexU32(uint32_t value);
 
+    // Applies the optimizations requested in options and logs their statistics
+    void ApplyOptimizations(const TriMeshOptions& options);
+
     static void AppendIndexAndVertexData(
         std::vector<uint32_t>&    indexData,
         const std::vector<float>& vertexData,
@@ -14,9 +14,11 @@
 
 #include "ppx/application.h"
 #include "ppx/fs.h"
-#include "ppx/ppm_export.h"
+#include "ppx/mesh_cache.h"
 #include "ppx/profiler.h"
+#include "ppx/texture_cache.h"
 
+#include <cctype>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
@@ -352,6 +354,7 @@ Result Application::InitializeGrfxDevice()
         ci.vulkanExtensions       = {};
         ci.pVulkanDeviceFeatures  = nullptr;
         ci.supportShadingRateMode = mSettings.grfx.device.supportShadingRateMode;
+        ci.pipelineCachePath      = GetPipelineCachePath().string();
 #if defined(PPX_BUILD_XR)
         ci.pXrComponent = mSettings.xr.enable ? &mXrComponent : nullptr;
 #endif
@@ -585,6 +588,9 @@ void Application::StopGrfx()
 void Application::ShutdownGrfx()
 {
     if (mInstance) {
+        // Writes any pending screenshots.
+        mScreenshotCapture.Destroy();
+
         DestroySwapchains();
 
         if (mDevice) {
@@ -637,14 +643,20 @@ void Application::DispatchInitKnobs()
 
 void Application::DispatchSetup()
 {
+    InitMeshCache();
+    InitTextureCache();
+    StartBinaryMetricsReport();
     SetupMetrics();
+    StartProfilerTraceCapture();
     Setup();
+    RecordStartupMetrics();
 }
 
 void Application::DispatchShutdown()
 {
     Shutdown();
 
+    StopProfilerTraceCapture();
     ShutdownMetrics();
     SaveMetricsReportToDisk();
 
@@ -720,6 +732,11 @@ void Application::DispatchUpdateMetrics()
 
     // Then update custom app metrics.
     UpdateMetrics();
+
+    // Finally apply the data recorded from other threads during the frame.
+    if (HasActiveMetricsRun()) {
+        mMetrics.manager.FlushConcurrentData();
+    }
 }
 
 void Application::SetupMetrics()
@@ -766,6 +783,143 @@ void Application::SaveMetricsReportToDisk()
     // Export the report from the metrics manager to the disk.
     auto report = mMetrics.manager.CreateReport(mStandardOpts.pMetricsFilename->GetValue());
     report.WriteToDisk(mStandardOpts.pOverwriteMetricsFile->GetValue());
+
+    // The binary report has been streamed to disk during the runs; close it.
+    mMetrics.manager.StopBinaryReport();
+}
+
+void Application::StartBinaryMetricsReport()
+{
+    PPX_ASSERT_MSG(mStandardOpts.pMetricsBinaryFilename != nullptr, "The --metrics-binary-filename knob was not initialized.");
+    if (!mStandardOpts.pEnableMetrics->GetValue() || mStandardOpts.pMetricsBinaryFilename->GetValue().empty()) {
+        return;
+    }
+
+    if (!mMetrics.manager.StartBinaryReport(mStandardOpts.pMetricsBinaryFilename->GetValue(), mStandardOpts.pOverwriteMetricsFile->GetValue())) {
+        PPX_LOG_WARN("Binary metrics report disabled.");
+    }
+}
+
+void Application::InitMeshCache()
+{
+    PPX_ASSERT_MSG(mStandardOpts.pMeshCacheDir != nullptr, "The --mesh-cache-dir knob was not initialized.");
+    const std::string& directory = mStandardOpts.pMeshCacheDir->GetValue();
+    if (directory.empty()) {
+        SetMeshCacheDirectory("");
+        return;
+    }
+
+    SetMeshCacheDirectory(ppx::fs::GetFullPath(directory, ppx::fs::GetDefaultOutputDirectory()));
+}
+
+void Application::InitTextureCache()
+{
+    PPX_ASSERT_MSG(mStandardOpts.pTextureCacheDir != nullptr, "The --texture-cache-dir knob was not initialized.");
+    const std::string& directory = mStandardOpts.pTextureCacheDir->GetValue();
+    if (directory.empty()) {
+        SetTextureCacheDirectory("");
+        return;
+    }
+
+    SetTextureCacheDirectory(ppx::fs::GetFullPath(directory, ppx::fs::GetDefaultOutputDirectory()));
+}
+
+std::filesystem::path Application::GetPipelineCachePath() const
+{
+    PPX_ASSERT_MSG(mStandardOpts.pPipelineCacheDir != nullptr, "The --pipeline-cache-dir knob was not initialized.");
+    const std::string& directory = mStandardOpts.pPipelineCacheDir->GetValue();
+    if (directory.empty()) {
+        return {};
+    }
+
+    // One file per application and API, so that they don't overwrite each
+    // other's pipelines.
+    std::string filename = mSettings.appName + "_" + ToString(mSettings.grfx.api);
+    for (char& c : filename) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && (c != '-')) {
+            c = '_';
+        }
+    }
+    filename += ".bin";
+    return ppx::fs::GetFullPath(directory, ppx::fs::GetDefaultOutputDirectory()) / filename;
+}
+
+void Application::RecordStartupMetrics()
+{
+    uint64_t nowTimestamp = 0;
+    Timer::Timestamp(&nowTimestamp);
+    const double startupTimeMs  = Timer::TimestampToMillis(nowTimestamp - mMetrics.startupTimestamp);
+    const double pipelineTimeMs = mDevice->GetPipelineCreationTimeMs();
+    const char*  cacheState     = mDevice->IsPipelineCacheWarm() ? "warm" : "cold";
+    PPX_LOG_INFO("Startup with " << cacheState << " pipeline cache: " << startupTimeMs << " ms, "
+                                 << mDevice->GetPipelineCreationCount() << " pipelines created in " << pipelineTimeMs << " ms");
+
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    // The state of the cache is part of the metric names, so that the reports
+    // of a cold and a warm run can be compared side by side.
+    const std::pair<std::string, double> gauges[] = {
+        {std::string("startup_time_") + cacheState, startupTimeMs},
+        {std::string("pipeline_creation_time_") + cacheState, pipelineTimeMs},
+    };
+    for (const auto& gauge : gauges) {
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = gauge.first;
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        metrics::MetricID id             = mMetrics.manager.AddMetric(metadata);
+        if (id == metrics::kInvalidMetricID) {
+            PPX_LOG_WARN("Failed to create " << gauge.first << " metric");
+            continue;
+        }
+
+        metrics::MetricData data = {metrics::MetricType::GAUGE};
+        data.gauge.seconds       = 0.0;
+        data.gauge.value         = gauge.second;
+        mMetrics.manager.RecordMetricData(id, data);
+    }
+}
+
+void Application::StartProfilerTraceCapture()
+{
+    PPX_ASSERT_MSG(mStandardOpts.pProfilerTraceFilename != nullptr, "The --profiler-trace-filename knob was not initialized.");
+    const std::string& filename = mStandardOpts.pProfilerTraceFilename->GetValue();
+    if (filename.empty()) {
+        return;
+    }
+
+    if (mFrameProfilerEventToken == kInvalidProfilerEventToken) {
+        Result ppxres = Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "Frame", PROFILER_EVENT_RECORD_ACTION_INSERT, &mFrameProfilerEventToken);
+        if (Failed(ppxres)) {
+            PPX_LOG_WARN("Failed to register the profiler frame event");
+        }
+    }
+
+    std::stringstream timeStream;
+    timeStream << std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+    std::filesystem::path tracePath = ppx::fs::GetFullPath(filename, ppx::fs::GetDefaultOutputDirectory(), "@", timeStream.str());
+    Result                ppxres    = Profiler::StartTraceCapture(tracePath);
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("Failed to start profiler trace capture to " << tracePath);
+        return;
+    }
+    PPX_LOG_INFO("Capturing profiler trace to " << tracePath);
+}
+
+void Application::StopProfilerTraceCapture()
+{
+    if (!Profiler::IsTraceCaptureActive()) {
+        return;
+    }
+
+    Result ppxres = Profiler::StopTraceCapture();
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("Failed to write profiler trace");
+    }
 }
 
 void Application::InitStandardKnobs()
@@ -812,6 +966,26 @@ void Application::InitStandardKnobs()
         "Prints a list of the available GPUs on the current system with their "
         "index and exits. See also `--gpu`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pMeshCacheDir, "mesh-cache-dir", mSettings.standardKnobsDefaultValue.meshCacheDir);
+    mStandardOpts.pMeshCacheDir->SetFlagDescription(
+        "Directory where meshes loaded from files are cached in a binary format "
+        "that can be uploaded to the GPU as is. A cached mesh is reused until "
+        "its source file or load options change. If not a full path, will be "
+        "defined relative to the default output directory. Use an empty path "
+        "to disable the cache.");
+    mStandardOpts.pMeshCacheDir->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsBinaryFilename, "metrics-binary-filename", mSettings.standardKnobsDefaultValue.metricsBinaryFilename);
+    mStandardOpts.pMetricsBinaryFilename->SetFlagDescription(
+        "If metrics are enabled, also stream the metrics to a compact binary "
+        "columnar report at the provided path while the application runs. "
+        "Use tools/metrics-binary-to-json.py to convert it to the JSON report format. "
+        "If used, any `@` symbols in the filename (not the path) will be replaced "
+        "with the current timestamp. If not a full path, will be defined relative "
+        "to the default output directory. See also `--enable-metrics` and "
+        "`--overwrite-metrics-file`.");
+    mStandardOpts.pMetricsBinaryFilename->SetFlagParameters("<path>");
+
     GetKnobManager().InitKnob(&mStandardOpts.pMetricsFilename, "metrics-filename", mSettings.standardKnobsDefaultValue.metricsFilename);
     mStandardOpts.pMetricsFilename->SetFlagDescription(
         "If metrics are enabled, save the metrics report to the "
@@ -820,12 +994,44 @@ void Application::InitStandardKnobs()
         "If not a full path, will be defined relative to the default "
         "output directory. See also `--enable-metrics` and `--overwrite-metrics-file`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsKeepTimeSeries, "metrics-keep-time-series", mSettings.standardKnobsDefaultValue.metricsKeepTimeSeries);
+    mStandardOpts.pMetricsKeepTimeSeries->SetFlagDescription(
+        "Only applies if `--metrics-streaming-gauges` is set. Also keep the raw "
+        "time series of the default gauges and write it to the metrics report.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsStreamingGauges, "metrics-streaming-gauges", mSettings.standardKnobsDefaultValue.metricsStreamingGauges);
+    mStandardOpts.pMetricsStreamingGauges->SetFlagDescription(
+        "Only applies if metrics are enabled with `--enable-metrics`. "
+        "Record the default gauges (frame time, framerate) with constant memory. "
+        "Percentiles are estimated within 1% relative error and the raw time series "
+        "is not written to the report. See also `--metrics-keep-time-series`.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pOverwriteMetricsFile, "overwrite-metrics-file", mSettings.standardKnobsDefaultValue.overwriteMetricsFile);
     mStandardOpts.pOverwriteMetricsFile->SetFlagDescription(
         "Only applies if metrics are enabled with `--enable-metrics`. "
         "If an existing file at the path set with `--metrics-filename` is found, it will be overwritten. "
         "See also: `--enable-metrics` and `--metrics-filename`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pPipelineCacheDir, "pipeline-cache-dir", mSettings.standardKnobsDefaultValue.pipelineCacheDir);
+    mStandardOpts.pPipelineCacheDir->SetFlagDescription(
+        "Directory where the pipeline cache of the application is saved on exit "
+        "and loaded on startup, so that pipelines compiled by a previous run are "
+        "not compiled again. The cache is ignored if it was written by another "
+        "device or driver version. If not a full path, will be defined relative "
+        "to the default output directory. Use an empty path to disable the cache. "
+        "Only supported with Vulkan.");
+    mStandardOpts.pPipelineCacheDir->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pProfilerTraceFilename, "profiler-trace-filename", mSettings.standardKnobsDefaultValue.profilerTraceFilename);
+    mStandardOpts.pProfilerTraceFilename->SetFlagDescription(
+        "If set, stream CPU profiler events (one slice per frame, plus any events "
+        "registered with PROFILER_EVENT_RECORD_ACTION_INSERT) to the provided path "
+        "in Chrome trace-event JSON format. It can be opened in chrome://tracing or "
+        "ui.perfetto.dev. If used, any `@` symbols in the filename (not the path) will "
+        "be replaced with the current timestamp. If not a full path, will be defined "
+        "relative to the default output directory.");
+    mStandardOpts.pProfilerTraceFilename->SetFlagParameters("<path>");
+
     GetKnobManager().InitKnob(&mStandardOpts.pResolution, "resolution", mSettings.standardKnobsDefaultValue.resolution);
     mStandardOpts.pResolution->SetFlagDescription(
         "Specify the main window resolution in pixels. Width and Height must be "
@@ -844,6 +1050,11 @@ void Application::InitStandardKnobs()
     mStandardOpts.pRunTimeMs->SetFlagDescription(
         "Shutdown the application after N milliseconds. If 0, this is disabled.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pScreenshotFrameInterval, "screenshot-frame-interval", mSettings.standardKnobsDefaultValue.screenshotFrameInterval, 0, INT_MAX);
+    mStandardOpts.pScreenshotFrameInterval->SetFlagDescription(
+        "Take a screenshot every N frames and save it in PPM format. If 0, this is "
+        "disabled. See also `--screenshot-path`.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pScreenshotFrameNumber, "screenshot-frame-number", mSettings.standardKnobsDefaultValue.screenshotFrameNumber, -1, INT_MAX);
     mStandardOpts.pScreenshotFrameNumber->SetFlagDescription(
         "Take a screenshot of frame number N and save it in PPM format. See also "
@@ -862,6 +1073,15 @@ void Application::InitStandardKnobs()
         "Calculate frame statistics over the last N frames only. If 0, "
         "all frames since the beginning of the application will be used.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pTextureCacheDir, "texture-cache-dir", mSettings.standardKnobsDefaultValue.textureCacheDir);
+    mStandardOpts.pTextureCacheDir->SetFlagDescription(
+        "Directory where textures loaded from files are cached with their "
+        "decoded mip chain, so that they can be uploaded without being decoded "
+        "again. A cached texture is reused until its source file or load "
+        "options change. If not a full path, will be defined relative to the "
+        "default output directory. Use an empty path to disable the cache.");
+    mStandardOpts.pTextureCacheDir->SetFlagParameters("<path>");
+
     GetKnobManager().InitKnob(&mStandardOpts.pUseSoftwareRenderer, "use-software-renderer", mSettings.standardKnobsDefaultValue.useSoftwareRenderer);
     mStandardOpts.pUseSoftwareRenderer->SetFlagDescription(
         "Use a software renderer instead of a hardware device, if available.");
@@ -902,68 +1122,14 @@ void Application::TakeScreenshot()
     std::filesystem::path screenshotPath;
     screenshotPath = ppx::fs::GetFullPath(mStandardOpts.pScreenshotPath->GetValue(), ppx::fs::GetDefaultOutputDirectory(), "#", std::to_string(mFrameCount));
 
-    auto swapchainImg = GetSwapchain()->GetColorImage(GetSwapchain()->GetCurrentImageIndex());
-    auto queue        = mDevice->GetGraphicsQueue();
-
-    const grfx::FormatDesc* formatDesc = grfx::GetFormatDescription(swapchainImg->GetFormat());
-    const uint32_t          width      = swapchainImg->GetWidth();
-    const uint32_t          height     = swapchainImg->GetHeight();
-
-    // Create a buffer that will hold the swapchain image's texels.
-    // Increase its size by a factor of 2 to ensure that a larger-than-needed
-    // row pitch will not overflow the buffer.
-    uint64_t bufferSize = 2ull * formatDesc->bytesPerTexel * width * height;
-
-    grfx::BufferPtr        screenshotBuf = nullptr;
-    grfx::BufferCreateInfo bufferCi      = {};
-    bufferCi.size                        = bufferSize;
-    bufferCi.initialState                = grfx::RESOURCE_STATE_COPY_DST;
-    bufferCi.usageFlags.bits.transferDst = 1;
-    bufferCi.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
-    PPX_CHECKED_CALL(mDevice->CreateBuffer(&bufferCi, &screenshotBuf));
-
-    // We wait for idle so that we can avoid tracking swapchain fences.
-    // It's not ideal, but we won't be taking screenshots in
-    // performance-critical scenarios.
-    PPX_CHECKED_CALL(queue->WaitIdle());
-
-    // Copy the swapchain image into the buffer.
-    grfx::CommandBufferPtr cmdBuf;
-    PPX_CHECKED_CALL(queue->CreateCommandBuffer(&cmdBuf, 0, 0));
-
-    grfx::ImageToBufferOutputPitch outPitch;
-    cmdBuf->Begin();
-    {
-        cmdBuf->TransitionImageLayout(swapchainImg, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_COPY_SRC);
-
-        grfx::ImageToBufferCopyInfo bufCopyInfo = {};
-        bufCopyInfo.extent                      = {width, height, 0};
-        outPitch                                = cmdBuf->CopyImageToBuffer(&bufCopyInfo, swapchainImg, screenshotBuf);
-
-        cmdBuf->TransitionImageLayout(swapchainImg, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_PRESENT);
+    if (!mScreenshotCapture.IsCreated()) {
+        PPX_CHECKED_CALL(mScreenshotCapture.Create(mDevice->GetGraphicsQueue()));
     }
-    cmdBuf->End();
-
-    grfx::SubmitInfo submitInfo   = {};
-    submitInfo.commandBufferCount = 1;
-    submitInfo.ppCommandBuffers   = &cmdBuf;
-    queue->Submit(&submitInfo);
-
-    // Wait for the copy to be finished.
-    queue->WaitIdle();
 
-    // Export to PPM.
-    unsigned char* texels = nullptr;
-    screenshotBuf->MapMemory(0, (void**)&texels);
-
-    PPX_CHECKED_CALL(ExportToPPM(screenshotPath.string(), swapchainImg->GetFormat(), texels, width, height, outPitch.rowPitch));
-    PPX_LOG_INFO("Screenshot of frame " << mFrameCount << " saved to: " << screenshotPath.string());
-
-    screenshotBuf->UnmapMemory();
-
-    // Clean up temporary resources.
-    mDevice->DestroyBuffer(screenshotBuf);
-    queue->DestroyCommandBuffer(cmdBuf);
+    // The copy is queued behind the frame that was just submitted, and the
+    // PPM file is written on a background thread once the copy completes.
+    auto swapchainImg = GetSwapchain()->GetColorImage(GetSwapchain()->GetCurrentImageIndex());
+    PPX_CHECKED_CALL(mScreenshotCapture.Capture(swapchainImg, grfx::RESOURCE_STATE_PRESENT, screenshotPath));
 }
 
 void Application::MoveCallback(int32_t x, int32_t y)
@@ -1354,12 +1520,20 @@ void Application::MainLoop()
         if (!IsRunning()) {
             return;
         }
-        RenderFrame();
+        {
+            ProfilerScopedEventSample frameSample(mFrameProfilerEventToken);
+            RenderFrame();
+        }
 
-        // Take screenshot if this is the requested frame.
-        if (mFrameCount == static_cast<uint64_t>(mStandardOpts.pScreenshotFrameNumber->GetValue())) {
+        // Take screenshot if this is a requested frame.
+        const int screenshotFrameInterval = mStandardOpts.pScreenshotFrameInterval->GetValue();
+        if ((mFrameCount == static_cast<uint64_t>(mStandardOpts.pScreenshotFrameNumber->GetValue())) ||
+            ((screenshotFrameInterval > 0) && ((mFrameCount % static_cast<uint64_t>(screenshotFrameInterval)) == 0))) {
             TakeScreenshot();
         }
+        if (mScreenshotCapture.IsCreated()) {
+            mScreenshotCapture.Update();
+        }
 
         // Frame end general metrics data, used for recorded metrics, display, screenshots, and pacing.
         double nowMs       = mTimer.MillisSinceStart();
@@ -1457,6 +1631,8 @@ int Application::Run(int argc, char** argv)
 
     mDecoratedApiName = ToString(mSettings.grfx.api);
 
+    Timer::Timestamp(&mMetrics.startupTimestamp);
+
     // Initialize the window
     Result ppxres = InitializeWindow();
     if (Failed(ppxres)) {
@@ -1741,12 +1917,16 @@ void Application::StartMetricsRun(const std::string& name)
     mMetrics.manager.StartRun(name.c_str());
 
     // Add default metrics to every single run
+    metrics::GaugeMode gaugeMode      = mStandardOpts.pMetricsStreamingGauges->GetValue() ? metrics::GaugeMode::STREAMING : metrics::GaugeMode::EXACT;
+    bool               keepTimeSeries = mStandardOpts.pMetricsKeepTimeSeries->GetValue();
     {
         metrics::MetricMetadata metadata = {};
         metadata.type                    = metrics::MetricType::GAUGE;
         metadata.name                    = "cpu_frame_time";
         metadata.unit                    = "ms";
         metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        metadata.gaugeMode               = gaugeMode;
+        metadata.keepTimeSeries          = keepTimeSeries;
         mMetrics.cpuFrameTimeId          = mMetrics.manager.AddMetric(metadata);
         PPX_ASSERT_MSG(mMetrics.cpuFrameTimeId != metrics::kInvalidMetricID, "Failed to create frame time metric");
     }
@@ -1756,6 +1936,8 @@ void Application::StartMetricsRun(const std::string& name)
         metadata.name                    = "framerate";
         metadata.unit                    = "";
         metadata.interpretation          = metrics::MetricInterpretation::HIGHER_IS_BETTER;
+        metadata.gaugeMode               = gaugeMode;
+        metadata.keepTimeSeries          = keepTimeSeries;
         mMetrics.framerateId             = mMetrics.manager.AddMetric(metadata);
         PPX_ASSERT_MSG(mMetrics.framerateId != metrics::kInvalidMetricID, "Failed to create framerate metric");
     }
@@ -1815,6 +1997,17 @@ bool Application::RecordMetricData(metrics::MetricID id, const metrics::MetricDa
     return mMetrics.manager.RecordMetricData(id, data);
 }
 
+bool Application::RecordMetricDataConcurrent(metrics::MetricID id, const metrics::MetricData& data)
+{
+    if (!mStandardOpts.pEnableMetrics->GetValue()) {
+        PPX_LOG_ERROR("Attempting to record metric data with metrics disabled; ignoring.");
+        return false;
+    }
+
+    // This function already covers all other cases.
+    return mMetrics.manager.RecordMetricDataConcurrent(id, data);
+}
+
 void Application::AddAssetDirs()
 {
     std::filesystem::path projectRootPath = GetApplicationPath().remove_filename() / RELATIVE_PATH_TO_PROJECT_ROOT;
@@ -2090,6 +2283,24 @@ void Application::DrawProfilerGrfxApiFunctions()
 
             ImGui::EndTable();
         }
+
+        std::vector<ProfilerCounterValue> counters;
+        Profiler::GetCounters(&counters);
+        if (!counters.empty() && ImGui::BeginTable("#profiler_counters", 2, ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Counter");
+            ImGui::TableSetupColumn("Value");
+            ImGui::TableHeadersRow();
+
+            for (auto& counter : counters) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", counter.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%" PRIu64, counter.value);
+            }
+
+            ImGui::EndTable();
+        }
     }
     ImGui::End();
 }
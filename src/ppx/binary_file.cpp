@@ -0,0 +1,127 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_file.h"
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace ppx {
+namespace internal {
+
+void PutString(std::vector<uint8_t>* pBuffer, const std::string& value)
+{
+    Put<uint32_t>(pBuffer, static_cast<uint32_t>(value.size()));
+    pBuffer->insert(pBuffer->end(), value.begin(), value.end());
+}
+
+void PutVarint(std::vector<uint8_t>* pBuffer, uint64_t value)
+{
+    while (value >= 0x80) {
+        pBuffer->push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    pBuffer->push_back(static_cast<uint8_t>(value));
+}
+
+bool ByteReader::GetString(std::string* pValue)
+{
+    uint32_t length = 0;
+    if (!Get(&length) || (mSize - mOffset) < length) {
+        mValid = false;
+        return false;
+    }
+    pValue->assign(reinterpret_cast<const char*>(mData + mOffset), length);
+    mOffset += length;
+    return true;
+}
+
+bool ByteReader::GetVarint(uint64_t* pValue)
+{
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = 0;
+        if (!Get(&byte)) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *pValue = value;
+            return true;
+        }
+    }
+    mValid = false;
+    return false;
+}
+
+bool ByteReader::GetCount(uint32_t maxValue, uint32_t* pValue)
+{
+    if (Get(pValue) && (*pValue > maxValue)) {
+        mValid = false;
+    }
+    return mValid;
+}
+
+bool ByteReader::Skip(size_t size)
+{
+    if (!mValid || (mSize - mOffset) < size) {
+        mValid = false;
+        return false;
+    }
+    mOffset += size;
+    return true;
+}
+
+std::string GetUniqueTempSuffix()
+{
+    static const uint64_t        sProcessToken = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    static std::atomic<uint64_t> sCounter      = 0;
+
+    std::stringstream ss;
+    ss << "." << std::hex << sProcessToken << "-" << sCounter.fetch_add(1) << ".tmp";
+    return ss.str();
+}
+
+bool WriteFileAtomic(const std::filesystem::path& path, const std::function<void(std::ostream&)>& writeFunc)
+{
+    std::error_code       ec;
+    std::filesystem::path tempPath = path;
+    tempPath += GetUniqueTempSuffix();
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        writeFunc(file);
+
+        if (!file.good()) {
+            file.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace internal
+} // namespace ppx
@@ -0,0 +1,100 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_binary_file_h
+#define ppx_binary_file_h
+
+// Helpers shared by the binary files that ppx writes, such as the caches and
+// the binary metrics reports. Not part of the public headers.
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ppx {
+namespace internal {
+
+// Little-endian encoding helpers. Every platform supported by ppx is
+// little-endian, so values are copied as is.
+template <typename T>
+void Put(std::vector<uint8_t>* pBuffer, T value)
+{
+    static_assert(std::is_arithmetic_v<T>, "Only arithmetic types can be encoded");
+    size_t offset = pBuffer->size();
+    pBuffer->resize(offset + sizeof(T));
+    std::memcpy(pBuffer->data() + offset, &value, sizeof(T));
+}
+
+// Writes a uint32 length followed by the characters.
+void PutString(std::vector<uint8_t>* pBuffer, const std::string& value);
+
+// Writes value in LEB128, 7 bits per byte.
+void PutVarint(std::vector<uint8_t>* pBuffer, uint64_t value);
+
+// Bounds-checked decoding of the values written by the helpers above. Once a
+// read fails, all subsequent reads fail too.
+class ByteReader
+{
+public:
+    ByteReader(const void* pData, size_t size)
+        : mData(static_cast<const uint8_t*>(pData)), mSize(size) {}
+
+    template <typename T>
+    bool Get(T* pValue)
+    {
+        if (!mValid || (mSize - mOffset) < sizeof(T)) {
+            mValid = false;
+            return false;
+        }
+        std::memcpy(pValue, mData + mOffset, sizeof(T));
+        mOffset += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string* pValue);
+    bool GetVarint(uint64_t* pValue);
+    // Reads a uint32 that must be at most maxValue.
+    bool GetCount(uint32_t maxValue, uint32_t* pValue);
+    bool Skip(size_t size);
+
+    bool   IsValid() const { return mValid; }
+    size_t GetOffset() const { return mOffset; }
+    size_t GetRemainingSize() const { return mSize - mOffset; }
+
+private:
+    const uint8_t* mData   = nullptr;
+    size_t         mSize   = 0;
+    size_t         mOffset = 0;
+    bool           mValid  = true;
+};
+
+// Returns a suffix for the temporary file of a write that no other writer
+// uses, so that processes and threads writing the same file never write to
+// the same temporary file before renaming it.
+std::string GetUniqueTempSuffix();
+
+// Writes a file with writeFunc to a temporary file next to path, then
+// renames it to path, so that readers never see a partial file. Returns
+// false, leaving no temporary file behind, if any step fails.
+bool WriteFileAtomic(const std::filesystem::path& path, const std::function<void(std::ostream&)>& writeFunc);
+
+} // namespace internal
+} // namespace ppx
+
+#endif // ppx_binary_file_h
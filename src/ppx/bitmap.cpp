@@ -24,12 +24,21 @@
 #include "stb_image_resize.h"
 
 #include "ppx/fs.h"
+#include "ppx/parallel.h"
+
+#include <atomic>
 
 namespace ppx {
 
 static const char*  kRadianceSig     = "#?RADIANCE";
 static const size_t kRadianceSigSize = 10;
 
+// ScaleTo splits targets of at least this many pixels per thread into bands,
+// which are kept tall enough that the vertical filter taps shared between
+// neighbouring bands stay a small part of each band's work.
+static const size_t   kMinScalePixelsPerThread = 256 * 1024;
+static const uint32_t kMinScaleRowsPerBand     = 32;
+
 // -------------------------------------------------------------------------------------------------
 // Bitmap
 // -------------------------------------------------------------------------------------------------
@@ -262,7 +271,7 @@ Result Bitmap::ScaleTo(Bitmap* pTargetBitmap) const
     return ScaleTo(pTargetBitmap, STBIR_FILTER_DEFAULT);
 }
 
-Result Bitmap::ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType) const
+Result Bitmap::ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType, uint32_t threadCount) const
 {
     if (IsNull(pTargetBitmap)) {
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
@@ -284,27 +293,81 @@ Result Bitmap::ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType) const
     }
     // clang-format on
 
-    int res = stbir_resize(
-        static_cast<const void*>(GetData()),
-        static_cast<int>(GetWidth()),
-        static_cast<int>(GetHeight()),
-        static_cast<int>(GetRowStride()),
-        static_cast<void*>(pTargetBitmap->GetData()),
-        static_cast<int>(pTargetBitmap->GetWidth()),
-        static_cast<int>(pTargetBitmap->GetHeight()),
-        static_cast<int>(pTargetBitmap->GetRowStride()),
-        datatype,
-        static_cast<int>(Bitmap::ChannelCount(GetFormat())),
-        -1,
-        0,
-        STBIR_EDGE_CLAMP,
-        STBIR_EDGE_CLAMP,
-        filterType,
-        filterType,
-        STBIR_COLORSPACE_LINEAR,
-        nullptr);
+    const uint32_t targetWidth  = pTargetBitmap->GetWidth();
+    const uint32_t targetHeight = pTargetBitmap->GetHeight();
+    if (threadCount == 0) {
+        threadCount = GetParallelThreadCount(static_cast<size_t>(targetWidth) * targetHeight, kMinScalePixelsPerThread);
+    }
+    threadCount = std::min(threadCount, targetHeight / kMinScaleRowsPerBand);
+
+    if (threadCount <= 1) {
+        int res = stbir_resize(
+            static_cast<const void*>(GetData()),
+            static_cast<int>(GetWidth()),
+            static_cast<int>(GetHeight()),
+            static_cast<int>(GetRowStride()),
+            static_cast<void*>(pTargetBitmap->GetData()),
+            static_cast<int>(targetWidth),
+            static_cast<int>(targetHeight),
+            static_cast<int>(pTargetBitmap->GetRowStride()),
+            datatype,
+            static_cast<int>(Bitmap::ChannelCount(GetFormat())),
+            -1,
+            0,
+            STBIR_EDGE_CLAMP,
+            STBIR_EDGE_CLAMP,
+            filterType,
+            filterType,
+            STBIR_COLORSPACE_LINEAR,
+            nullptr);
+
+        if (res == 0) {
+            return ERROR_IMAGE_RESIZE_FAILED;
+        }
 
-    if (res == 0) {
+        return ppx::SUCCESS;
+    }
+
+    // Each band is the full resize shifted up by the band's first row, so its
+    // rows sample the source with the same filter weights as a single resize.
+    const float       xScale = static_cast<float>(targetWidth) / static_cast<float>(GetWidth());
+    const float       yScale = static_cast<float>(targetHeight) / static_cast<float>(GetHeight());
+    std::atomic<bool> failed(false);
+    ParallelForRanges(targetHeight, threadCount, [&](uint32_t, size_t begin, size_t end) {
+        if (begin == end) {
+            return;
+        }
+        char* pTargetRows = pTargetBitmap->GetData() + begin * pTargetBitmap->GetRowStride();
+        int   res         = stbir_resize_subpixel(
+            static_cast<const void*>(GetData()),
+            static_cast<int>(GetWidth()),
+            static_cast<int>(GetHeight()),
+            static_cast<int>(GetRowStride()),
+            static_cast<void*>(pTargetRows),
+            static_cast<int>(targetWidth),
+            static_cast<int>(end - begin),
+            static_cast<int>(pTargetBitmap->GetRowStride()),
+            datatype,
+            static_cast<int>(Bitmap::ChannelCount(GetFormat())),
+            -1,
+            0,
+            STBIR_EDGE_CLAMP,
+            STBIR_EDGE_CLAMP,
+            filterType,
+            filterType,
+            STBIR_COLORSPACE_LINEAR,
+            nullptr,
+            xScale,
+            yScale,
+            0.0f,
+            static_cast<float>(begin));
+
+        if (res == 0) {
+            failed = true;
+        }
+    });
+
+    if (failed) {
         return ERROR_IMAGE_RESIZE_FAILED;
     }
 
@@ -500,15 +563,16 @@ uint32_t Bitmap::FormatSize(Bitmap::Format value)
 
 uint64_t Bitmap::StorageFootprint(uint32_t width, uint32_t height, Bitmap::Format format)
 {
-    uint64_t size = width * height * Bitmap::FormatSize(format);
+    uint64_t size = static_cast<uint64_t>(width) * height * Bitmap::FormatSize(format);
     return size;
 }
 
 static Result IsRadianceFile(const std::filesystem::path& path, bool& isRadiance)
 {
     // Open file
+    // Only the signature is read.
     ppx::fs::File file;
-    if (!file.Open(path.string().c_str())) {
+    if (!file.Open(path.string().c_str(), ppx::fs::File::ACCESS_PATTERN_RANDOM)) {
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
     // Signature buffer
@@ -540,8 +604,9 @@ static Result IsRadianceImage(const size_t dataSize, const void* pData, bool& is
 
 Result Bitmap::StbiInfo(const std::filesystem::path& path, int* pX, int* pY, int* pComp)
 {
+    // Only the header is read when the file is mapped.
     ppx::fs::File file;
-    if (!file.Open(path)) {
+    if (!file.Open(path, ppx::fs::File::ACCESS_PATTERN_RANDOM)) {
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
 
@@ -610,7 +675,7 @@ Result Bitmap::GetFileProperties(const std::filesystem::path& path, uint32_t* pW
 char* Bitmap::StbiLoad(const std::filesystem::path& path, Bitmap::Format format, int* pWidth, int* pHeight, int* pChannels, int desiredChannels)
 {
     ppx::fs::File file;
-    if (!file.Open(path)) {
+    if (!file.Open(path, ppx::fs::File::ACCESS_PATTERN_SEQUENTIAL)) {
         return nullptr;
     }
 
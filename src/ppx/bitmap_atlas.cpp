@@ -0,0 +1,395 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/bitmap_atlas.h"
+#include "ppx/util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace ppx {
+
+namespace {
+
+bool Contains(const AtlasRect& outer, const AtlasRect& inner)
+{
+    return (inner.x >= outer.x) && (inner.y >= outer.y) &&
+           (inner.x + inner.width <= outer.x + outer.width) &&
+           (inner.y + inner.height <= outer.y + outer.height);
+}
+
+bool Intersects(const AtlasRect& a, const AtlasRect& b)
+{
+    return (a.x < b.x + b.width) && (b.x < a.x + a.width) &&
+           (a.y < b.y + b.height) && (b.y < a.y + a.height);
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// AtlasPacker
+// -------------------------------------------------------------------------------------------------
+AtlasPacker::AtlasPacker(uint32_t width, uint32_t height, AtlasPackMethod method)
+{
+    Reset(width, height, method);
+}
+
+void AtlasPacker::Reset(uint32_t width, uint32_t height, AtlasPackMethod method)
+{
+    mWidth  = width;
+    mHeight = height;
+    mMethod = method;
+    Clear();
+}
+
+void AtlasPacker::Clear()
+{
+    mRectCount = 0;
+    mUsedArea  = 0;
+    mSkyline.clear();
+    mFreeRects.clear();
+    if ((mWidth == 0) || (mHeight == 0)) {
+        return;
+    }
+
+    if (mMethod == ATLAS_PACK_METHOD_SKYLINE) {
+        mSkyline.push_back({0, 0, mWidth});
+    }
+    else {
+        mFreeRects.push_back({0, 0, mWidth, mHeight});
+    }
+}
+
+bool AtlasPacker::Insert(uint32_t width, uint32_t height, AtlasRect* pRect)
+{
+    PPX_ASSERT_NULL_ARG(pRect);
+    if ((width == 0) || (height == 0) || (width > mWidth) || (height > mHeight)) {
+        return false;
+    }
+
+    bool inserted = (mMethod == ATLAS_PACK_METHOD_SKYLINE) ? InsertSkyline(width, height, pRect) : InsertMaxRects(width, height, pRect);
+    if (inserted) {
+        mRectCount += 1;
+        mUsedArea += static_cast<uint64_t>(width) * height;
+    }
+    return inserted;
+}
+
+float AtlasPacker::GetOccupancy() const
+{
+    const uint64_t area = static_cast<uint64_t>(mWidth) * mHeight;
+    return (area > 0) ? static_cast<float>(static_cast<double>(mUsedArea) / area) : 0.0f;
+}
+
+bool AtlasPacker::InsertSkyline(uint32_t width, uint32_t height, AtlasRect* pRect)
+{
+    // Find the position with the lowest top edge, then the leftmost one. A
+    // rectangle starting at a segment rests on the highest segment below it.
+    size_t   bestIndex = mSkyline.size();
+    uint32_t bestX     = 0;
+    uint32_t bestY     = 0;
+    uint32_t bestTop   = std::numeric_limits<uint32_t>::max();
+    for (size_t i = 0; i < mSkyline.size(); ++i) {
+        const uint32_t x = mSkyline[i].x;
+        if (x + width > mWidth) {
+            break;
+        }
+
+        uint32_t y         = 0;
+        uint32_t remaining = width;
+        for (size_t j = i; remaining > 0; ++j) {
+            y         = std::max(y, mSkyline[j].y);
+            remaining = (mSkyline[j].width >= remaining) ? 0 : (remaining - mSkyline[j].width);
+        }
+        if ((y + height <= mHeight) && (y + height < bestTop)) {
+            bestIndex = i;
+            bestX     = x;
+            bestY     = y;
+            bestTop   = y + height;
+        }
+    }
+    if (bestIndex == mSkyline.size()) {
+        return false;
+    }
+
+    // Raise the skyline over the new rectangle, shortening or removing the
+    // segments it covers.
+    mSkyline.insert(mSkyline.begin() + bestIndex, SkylineSegment{bestX, bestTop, width});
+    const uint32_t right = bestX + width;
+    size_t         next  = bestIndex + 1;
+    while ((next < mSkyline.size()) && (mSkyline[next].x < right)) {
+        const uint32_t segmentRight = mSkyline[next].x + mSkyline[next].width;
+        if (segmentRight <= right) {
+            mSkyline.erase(mSkyline.begin() + next);
+            continue;
+        }
+        mSkyline[next].width = segmentRight - right;
+        mSkyline[next].x     = right;
+        break;
+    }
+
+    // Merge neighbors at the same height.
+    for (size_t i = 0; i + 1 < mSkyline.size();) {
+        if (mSkyline[i].y == mSkyline[i + 1].y) {
+            mSkyline[i].width += mSkyline[i + 1].width;
+            mSkyline.erase(mSkyline.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    *pRect = {bestX, bestY, width, height};
+    return true;
+}
+
+bool AtlasPacker::InsertMaxRects(uint32_t width, uint32_t height, AtlasRect* pRect)
+{
+    const AtlasRect* pBest     = nullptr;
+    uint32_t         bestShort = std::numeric_limits<uint32_t>::max();
+    uint32_t         bestLong  = std::numeric_limits<uint32_t>::max();
+    for (const AtlasRect& freeRect : mFreeRects) {
+        if ((freeRect.width < width) || (freeRect.height < height)) {
+            continue;
+        }
+        const uint32_t leftoverX     = freeRect.width - width;
+        const uint32_t leftoverY     = freeRect.height - height;
+        const uint32_t leftoverShort = std::min(leftoverX, leftoverY);
+        const uint32_t leftoverLong  = std::max(leftoverX, leftoverY);
+        if ((leftoverShort < bestShort) || ((leftoverShort == bestShort) && (leftoverLong < bestLong))) {
+            pBest     = &freeRect;
+            bestShort = leftoverShort;
+            bestLong  = leftoverLong;
+        }
+    }
+    if (IsNull(pBest)) {
+        return false;
+    }
+
+    *pRect = {pBest->x, pBest->y, width, height};
+    SplitFreeRects(*pRect);
+    PruneFreeRects();
+    return true;
+}
+
+void AtlasPacker::SplitFreeRects(const AtlasRect& used)
+{
+    // Replace every free rectangle that overlaps the used one by the up to
+    // four maximal rectangles around it.
+    mNewFreeRects.clear();
+    for (size_t i = 0; i < mFreeRects.size();) {
+        const AtlasRect freeRect = mFreeRects[i];
+        if (!Intersects(freeRect, used)) {
+            ++i;
+            continue;
+        }
+
+        const uint32_t freeRight  = freeRect.x + freeRect.width;
+        const uint32_t freeBottom = freeRect.y + freeRect.height;
+        const uint32_t usedRight  = used.x + used.width;
+        const uint32_t usedBottom = used.y + used.height;
+        if (used.x > freeRect.x) {
+            mNewFreeRects.push_back({freeRect.x, freeRect.y, used.x - freeRect.x, freeRect.height});
+        }
+        if (usedRight < freeRight) {
+            mNewFreeRects.push_back({usedRight, freeRect.y, freeRight - usedRight, freeRect.height});
+        }
+        if (used.y > freeRect.y) {
+            mNewFreeRects.push_back({freeRect.x, freeRect.y, freeRect.width, used.y - freeRect.y});
+        }
+        if (usedBottom < freeBottom) {
+            mNewFreeRects.push_back({freeRect.x, usedBottom, freeRect.width, freeBottom - usedBottom});
+        }
+
+        mFreeRects[i] = mFreeRects.back();
+        mFreeRects.pop_back();
+    }
+}
+
+void AtlasPacker::PruneFreeRects()
+{
+    // The new rectangles are parts of free rectangles that were maximal, so
+    // they cannot contain an untouched one. Only drop the new rectangles
+    // contained in another one.
+    for (size_t i = 0; i < mNewFreeRects.size();) {
+        bool redundant = false;
+        for (size_t j = 0; (j < mNewFreeRects.size()) && !redundant; ++j) {
+            // Of two identical rectangles, keep the first one.
+            redundant = (i != j) && Contains(mNewFreeRects[j], mNewFreeRects[i]) && ((j < i) || !Contains(mNewFreeRects[i], mNewFreeRects[j]));
+        }
+        for (size_t j = 0; (j < mFreeRects.size()) && !redundant; ++j) {
+            redundant = Contains(mFreeRects[j], mNewFreeRects[i]);
+        }
+        if (redundant) {
+            mNewFreeRects[i] = mNewFreeRects.back();
+            mNewFreeRects.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+    mFreeRects.insert(mFreeRects.end(), mNewFreeRects.begin(), mNewFreeRects.end());
+}
+
+// -------------------------------------------------------------------------------------------------
+// BitmapAtlas
+// -------------------------------------------------------------------------------------------------
+Result BitmapAtlas::Create(const BitmapAtlasCreateInfo& createInfo, BitmapAtlas* pAtlas)
+{
+    PPX_ASSERT_NULL_ARG(pAtlas);
+    if (IsNull(pAtlas)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.width == 0) || (createInfo.height == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    // Offsets are aligned with RoundUp, which requires a power of two.
+    if ((createInfo.alignment == 0) || ((createInfo.alignment & (createInfo.alignment - 1)) != 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    Result ppxres = Bitmap::Create(createInfo.width, createInfo.height, createInfo.format, &pAtlas->mBitmap);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    pAtlas->mCreateInfo = createInfo;
+    pAtlas->mPacker.Reset(createInfo.width, createInfo.height, createInfo.method);
+    pAtlas->mHasDirtyRect = false;
+    return ppx::SUCCESS;
+}
+
+void BitmapAtlas::Clear()
+{
+    mPacker.Clear();
+    memset(mBitmap.GetData(), 0, mBitmap.GetFootprintSize());
+    AddDirtyRect({0, 0, mBitmap.GetWidth(), mBitmap.GetHeight()});
+}
+
+Result BitmapAtlas::Allocate(uint32_t width, uint32_t height, AtlasEntry* pEntry)
+{
+    PPX_ASSERT_NULL_ARG(pEntry);
+    if (IsNull(pEntry)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    const uint32_t padding   = mCreateInfo.padding;
+    const uint32_t alignment = mCreateInfo.alignment;
+    AtlasRect      footprint = {};
+    if (!mPacker.Insert(RoundUp(width + 2 * padding, alignment), RoundUp(height + 2 * padding, alignment), &footprint)) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    const float invWidth  = 1.0f / static_cast<float>(mBitmap.GetWidth());
+    const float invHeight = 1.0f / static_cast<float>(mBitmap.GetHeight());
+    pEntry->rect          = {footprint.x + padding, footprint.y + padding, width, height};
+    pEntry->uvRect.u0     = pEntry->rect.x * invWidth;
+    pEntry->uvRect.v0     = pEntry->rect.y * invHeight;
+    pEntry->uvRect.u1     = (pEntry->rect.x + width) * invWidth;
+    pEntry->uvRect.v1     = (pEntry->rect.y + height) * invHeight;
+
+    AddDirtyRect(footprint);
+    return ppx::SUCCESS;
+}
+
+Result BitmapAtlas::Insert(const Bitmap& bitmap, AtlasEntry* pEntry)
+{
+    if (!bitmap.IsOk()) {
+        return ppx::ERROR_BITMAP_BAD_COPY_SOURCE;
+    }
+
+    const Bitmap* pSource = &bitmap;
+    Bitmap        converted;
+    if (bitmap.GetFormat() != mBitmap.GetFormat()) {
+        Result ppxres = bitmap.ConvertTo(mBitmap.GetFormat(), &converted);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        pSource = &converted;
+    }
+
+    Result ppxres = Allocate(pSource->GetWidth(), pSource->GetHeight(), pEntry);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const AtlasRect& rect     = pEntry->rect;
+    const size_t     rowBytes = static_cast<size_t>(rect.width) * mBitmap.GetPixelStride();
+    for (uint32_t y = 0; y < rect.height; ++y) {
+        memcpy(mBitmap.GetPixelAddress(rect.x, rect.y + y), pSource->GetPixelAddress(0, y), rowBytes);
+    }
+
+    if (mCreateInfo.extrudeEdges) {
+        ExtrudeEdges(rect);
+    }
+    return ppx::SUCCESS;
+}
+
+void BitmapAtlas::ExtrudeEdges(const AtlasRect& rect)
+{
+    const uint32_t padding     = mCreateInfo.padding;
+    const uint32_t pixelStride = mBitmap.GetPixelStride();
+
+    // Extend every row to the left and right, then copy the first and last
+    // rows, including their extended pixels, up and down.
+    for (uint32_t y = rect.y; y < rect.y + rect.height; ++y) {
+        const char* pFirst = mBitmap.GetPixelAddress(rect.x, y);
+        const char* pLast  = mBitmap.GetPixelAddress(rect.x + rect.width - 1, y);
+        for (uint32_t i = 1; i <= padding; ++i) {
+            memcpy(mBitmap.GetPixelAddress(rect.x - i, y), pFirst, pixelStride);
+            memcpy(mBitmap.GetPixelAddress(rect.x + rect.width - 1 + i, y), pLast, pixelStride);
+        }
+    }
+
+    const size_t rowBytes = static_cast<size_t>(rect.width + 2 * padding) * pixelStride;
+    const char*  pTop     = mBitmap.GetPixelAddress(rect.x - padding, rect.y);
+    const char*  pBottom  = mBitmap.GetPixelAddress(rect.x - padding, rect.y + rect.height - 1);
+    for (uint32_t i = 1; i <= padding; ++i) {
+        memcpy(mBitmap.GetPixelAddress(rect.x - padding, rect.y - i), pTop, rowBytes);
+        memcpy(mBitmap.GetPixelAddress(rect.x - padding, rect.y + rect.height - 1 + i), pBottom, rowBytes);
+    }
+}
+
+void BitmapAtlas::AddDirtyRect(const AtlasRect& rect)
+{
+    if (!mHasDirtyRect) {
+        mDirtyRect    = rect;
+        mHasDirtyRect = true;
+        return;
+    }
+
+    const uint32_t right  = std::max(mDirtyRect.x + mDirtyRect.width, rect.x + rect.width);
+    const uint32_t bottom = std::max(mDirtyRect.y + mDirtyRect.height, rect.y + rect.height);
+    mDirtyRect.x          = std::min(mDirtyRect.x, rect.x);
+    mDirtyRect.y          = std::min(mDirtyRect.y, rect.y);
+    mDirtyRect.width      = right - mDirtyRect.x;
+    mDirtyRect.height     = bottom - mDirtyRect.y;
+}
+
+bool BitmapAtlas::TakeDirtyRect(AtlasRect* pRect)
+{
+    PPX_ASSERT_NULL_ARG(pRect);
+    if (!mHasDirtyRect) {
+        return false;
+    }
+    *pRect        = mDirtyRect;
+    mHasDirtyRect = false;
+    return true;
+}
+
+} // namespace ppx
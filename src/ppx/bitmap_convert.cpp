@@ -0,0 +1,425 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Format conversion for Bitmap::ConvertTo.
+//
+// Conversions between 8-bit, 16-bit and float channels with the same channel
+// count have SSE2 kernels on x86, and RGB to RGBA 8-bit has an SSSE3 kernel
+// selected at runtime with GCC and Clang. They compute the same values as the
+// scalar path, which handles every other conversion and the end of rows.
+
+#include "ppx/bitmap.h"
+#include "ppx/parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PPX_CONVERT_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PPX_CONVERT_SSSE3
+#include <tmmintrin.h>
+#endif
+#endif
+
+namespace ppx {
+
+namespace {
+
+// Rows are converted in parallel for bitmaps of at least this many values per thread.
+constexpr size_t kMinConvertValuesPerThread = 1024 * 1024;
+
+// -------------------------------------------------------------------------------------------------
+// Scalar conversions
+// -------------------------------------------------------------------------------------------------
+
+// Integer channels are normalized. Float values are clamped to [0, 1] and
+// rounded to nearest when converted to integers.
+template <typename SrcT, typename DstT>
+DstT ConvertValue(SrcT value);
+
+template <>
+uint8_t ConvertValue<uint8_t, uint8_t>(uint8_t value)
+{
+    return value;
+}
+
+template <>
+uint16_t ConvertValue<uint8_t, uint16_t>(uint8_t value)
+{
+    return static_cast<uint16_t>(value * 257);
+}
+
+template <>
+float ConvertValue<uint8_t, float>(uint8_t value)
+{
+    return static_cast<float>(value) / 255.0f;
+}
+
+template <>
+uint8_t ConvertValue<uint16_t, uint8_t>(uint16_t value)
+{
+    // Rounds value / 257 to nearest.
+    uint32_t biased = static_cast<uint32_t>(value) + 128;
+    return static_cast<uint8_t>((biased - (biased >> 8)) >> 8);
+}
+
+template <>
+uint16_t ConvertValue<uint16_t, uint16_t>(uint16_t value)
+{
+    return value;
+}
+
+template <>
+float ConvertValue<uint16_t, float>(uint16_t value)
+{
+    return static_cast<float>(value) / 65535.0f;
+}
+
+float Saturate(float value)
+{
+    // Written so that NaN becomes 0, like the SIMD kernels.
+    value = (value > 0.0f) ? value : 0.0f;
+    return (value < 1.0f) ? value : 1.0f;
+}
+
+template <>
+uint8_t ConvertValue<float, uint8_t>(float value)
+{
+    return static_cast<uint8_t>(Saturate(value) * 255.0f + 0.5f);
+}
+
+template <>
+uint16_t ConvertValue<float, uint16_t>(float value)
+{
+    return static_cast<uint16_t>(Saturate(value) * 65535.0f + 0.5f);
+}
+
+template <>
+float ConvertValue<float, float>(float value)
+{
+    return value;
+}
+
+template <typename T>
+T MaxValue()
+{
+    return std::numeric_limits<T>::max();
+}
+
+template <>
+float MaxValue<float>()
+{
+    return 1.0f;
+}
+
+// Converts pixels [begin, width) of a row. Missing color channels are 0 and
+// missing alpha is opaque.
+template <typename SrcT, typename DstT>
+void ConvertRowScalar(const char* pSrcRow, uint32_t srcChannelCount, char* pDstRow, uint32_t dstChannelCount, uint32_t begin, uint32_t width)
+{
+    const SrcT* pSrc = reinterpret_cast<const SrcT*>(pSrcRow);
+    DstT*       pDst = reinterpret_cast<DstT*>(pDstRow);
+    for (uint32_t x = begin; x < width; ++x) {
+        for (uint32_t c = 0; c < dstChannelCount; ++c) {
+            DstT value = 0;
+            if (c < srcChannelCount) {
+                value = ConvertValue<SrcT, DstT>(pSrc[x * srcChannelCount + c]);
+            }
+            else if (c == 3) {
+                value = MaxValue<DstT>();
+            }
+            pDst[x * dstChannelCount + c] = value;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// SIMD kernels
+// -------------------------------------------------------------------------------------------------
+
+// Converts the first values of a row, and returns the number of pixels
+// converted, at most width.
+using ConvertRowFn = uint32_t (*)(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount);
+
+#if defined(PPX_CONVERT_SSE2)
+__m128i PackU32ToU16(__m128i a, __m128i b)
+{
+    // SSE2 only packs with signed saturation: bias the values to the signed
+    // range and back.
+    const __m128i bias   = _mm_set1_epi32(0x8000);
+    __m128i       packed = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+    return _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+}
+
+__m128i FloatToUnorm(__m128 value, __m128 scale)
+{
+    value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), _mm_set1_ps(0.5f)));
+}
+
+uint32_t ConvertRowU8ToU16SSE2(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount)
+{
+    const uint32_t count = width * channelCount;
+
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // Interleaving a byte with itself multiplies it by 257.
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcRow + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 2 * i), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 2 * i + 16), _mm_unpackhi_epi8(v, v));
+    }
+    return i / channelCount;
+}
+
+uint32_t ConvertRowU16ToU8SSE2(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount)
+{
+    const uint32_t count = width * channelCount;
+    const __m128i  zero  = _mm_setzero_si128();
+    const __m128i  half  = _mm_set1_epi32(128);
+
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i packed[2];
+        for (uint32_t k = 0; k < 2; ++k) {
+            __m128i v      = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcRow + 2 * i + 16 * k));
+            __m128i lo     = _mm_add_epi32(_mm_unpacklo_epi16(v, zero), half);
+            __m128i hi     = _mm_add_epi32(_mm_unpackhi_epi16(v, zero), half);
+            lo             = _mm_srli_epi32(_mm_sub_epi32(lo, _mm_srli_epi32(lo, 8)), 8);
+            hi             = _mm_srli_epi32(_mm_sub_epi32(hi, _mm_srli_epi32(hi, 8)), 8);
+            packed[k] = _mm_packs_epi32(lo, hi);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + i), _mm_packus_epi16(packed[0], packed[1]));
+    }
+    return i / channelCount;
+}
+
+uint32_t ConvertRowU8ToF32SSE2(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount)
+{
+    const uint32_t count = width * channelCount;
+    const __m128i  zero  = _mm_setzero_si128();
+    const __m128   scale = _mm_set1_ps(255.0f);
+    float*         pDst  = reinterpret_cast<float*>(pDstRow);
+
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcRow + i));
+        __m128i lo    = _mm_unpacklo_epi8(v, zero);
+        __m128i hi    = _mm_unpackhi_epi8(v, zero);
+        __m128i u32[] = {
+            _mm_unpacklo_epi16(lo, zero),
+            _mm_unpackhi_epi16(lo, zero),
+            _mm_unpacklo_epi16(hi, zero),
+            _mm_unpackhi_epi16(hi, zero),
+        };
+        for (uint32_t k = 0; k < 4; ++k) {
+            _mm_storeu_ps(pDst + i + 4 * k, _mm_div_ps(_mm_cvtepi32_ps(u32[k]), scale));
+        }
+    }
+    return i / channelCount;
+}
+
+uint32_t ConvertRowU16ToF32SSE2(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount)
+{
+    const uint32_t count = width * channelCount;
+    const __m128i  zero  = _mm_setzero_si128();
+    const __m128   scale = _mm_set1_ps(65535.0f);
+    float*         pDst  = reinterpret_cast<float*>(pDstRow);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcRow + 2 * i));
+        _mm_storeu_ps(pDst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), scale));
+        _mm_storeu_ps(pDst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), scale));
+    }
+    return i / channelCount;
+}
+
+uint32_t ConvertRowF32ToU8SSE2(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount)
+{
+    const uint32_t count = width * channelCount;
+    const __m128   scale = _mm_set1_ps(255.0f);
+    const float*   pSrc  = reinterpret_cast<const float*>(pSrcRow);
+
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i v0 = FloatToUnorm(_mm_loadu_ps(pSrc + i), scale);
+        __m128i v1 = FloatToUnorm(_mm_loadu_ps(pSrc + i + 4), scale);
+        __m128i v2 = FloatToUnorm(_mm_loadu_ps(pSrc + i + 8), scale);
+        __m128i v3 = FloatToUnorm(_mm_loadu_ps(pSrc + i + 12), scale);
+        __m128i lo = _mm_packs_epi32(v0, v1);
+        __m128i hi = _mm_packs_epi32(v2, v3);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + i), _mm_packus_epi16(lo, hi));
+    }
+    return i / channelCount;
+}
+
+uint32_t ConvertRowF32ToU16SSE2(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t channelCount)
+{
+    const uint32_t count = width * channelCount;
+    const __m128   scale = _mm_set1_ps(65535.0f);
+    const float*   pSrc  = reinterpret_cast<const float*>(pSrcRow);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v0 = FloatToUnorm(_mm_loadu_ps(pSrc + i), scale);
+        __m128i v1 = FloatToUnorm(_mm_loadu_ps(pSrc + i + 4), scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 2 * i), PackU32ToU16(v0, v1));
+    }
+    return i / channelCount;
+}
+#endif // defined(PPX_CONVERT_SSE2)
+
+#if defined(PPX_CONVERT_SSSE3)
+__attribute__((target("ssse3"))) uint32_t ConvertRowRGB8ToRGBA8SSSE3(const char* pSrcRow, char* pDstRow, uint32_t width, uint32_t)
+{
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha  = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    // Each load reads 16 bytes, 4 pixels and 4 bytes of the next 2, so the
+    // loop stops while 6 pixels are left and the scalar path finishes the
+    // row without reading past it.
+    uint32_t x = 0;
+    for (; x + 6 <= width; x += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcRow + 3 * x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 4 * x), _mm_or_si128(_mm_shuffle_epi8(v, expand), alpha));
+    }
+    return x;
+}
+
+bool IsSSSE3Supported()
+{
+    static const bool sSupported = __builtin_cpu_supports("ssse3");
+    return sSupported;
+}
+#endif // defined(PPX_CONVERT_SSSE3)
+
+ConvertRowFn GetConvertRowFn(Bitmap::Format srcFormat, Bitmap::Format dstFormat)
+{
+    const uint32_t         srcChannelCount = Bitmap::ChannelCount(srcFormat);
+    const uint32_t         dstChannelCount = Bitmap::ChannelCount(dstFormat);
+    const Bitmap::DataType srcType         = Bitmap::ChannelDataType(srcFormat);
+    const Bitmap::DataType dstType         = Bitmap::ChannelDataType(dstFormat);
+
+#if defined(PPX_CONVERT_SSSE3)
+    if ((srcFormat == Bitmap::FORMAT_RGB_UINT8) && (dstFormat == Bitmap::FORMAT_RGBA_UINT8) && IsSSSE3Supported()) {
+        return ConvertRowRGB8ToRGBA8SSSE3;
+    }
+#endif
+    if (srcChannelCount != dstChannelCount) {
+        return nullptr;
+    }
+#if defined(PPX_CONVERT_SSE2)
+    // clang-format off
+    switch (srcType) {
+        default: break;
+        case Bitmap::DATA_TYPE_UINT8: {
+            if (dstType == Bitmap::DATA_TYPE_UINT16) return ConvertRowU8ToU16SSE2;
+            if (dstType == Bitmap::DATA_TYPE_FLOAT)  return ConvertRowU8ToF32SSE2;
+        } break;
+        case Bitmap::DATA_TYPE_UINT16: {
+            if (dstType == Bitmap::DATA_TYPE_UINT8) return ConvertRowU16ToU8SSE2;
+            if (dstType == Bitmap::DATA_TYPE_FLOAT) return ConvertRowU16ToF32SSE2;
+        } break;
+        case Bitmap::DATA_TYPE_FLOAT: {
+            if (dstType == Bitmap::DATA_TYPE_UINT8)  return ConvertRowF32ToU8SSE2;
+            if (dstType == Bitmap::DATA_TYPE_UINT16) return ConvertRowF32ToU16SSE2;
+        } break;
+    }
+    // clang-format on
+#endif
+    return nullptr;
+}
+
+template <typename SrcT, typename DstT>
+void Convert(const Bitmap& src, Bitmap* pDst)
+{
+    const uint32_t srcChannelCount = src.GetChannelCount();
+    const uint32_t dstChannelCount = pDst->GetChannelCount();
+    const uint32_t width           = src.GetWidth();
+    const uint32_t height          = src.GetHeight();
+    ConvertRowFn   rowFn           = GetConvertRowFn(src.GetFormat(), pDst->GetFormat());
+
+    const size_t valueCount  = static_cast<size_t>(width) * height * std::max(srcChannelCount, dstChannelCount);
+    uint32_t     threadCount = std::min<uint32_t>(GetParallelThreadCount(valueCount, kMinConvertValuesPerThread), height);
+    ParallelForRanges(height, threadCount, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            const char* pSrcRow = src.GetData() + y * src.GetRowStride();
+            char*       pDstRow = pDst->GetData() + y * pDst->GetRowStride();
+
+            uint32_t x = 0;
+            if (rowFn != nullptr) {
+                x = rowFn(pSrcRow, pDstRow, width, srcChannelCount);
+            }
+            ConvertRowScalar<SrcT, DstT>(pSrcRow, srcChannelCount, pDstRow, dstChannelCount, x, width);
+        }
+    });
+}
+
+template <typename SrcT>
+Result ConvertFrom(const Bitmap& src, Bitmap* pDst)
+{
+    // clang-format off
+    switch (Bitmap::ChannelDataType(pDst->GetFormat())) {
+        default: return ppx::ERROR_IMAGE_INVALID_FORMAT;
+        case Bitmap::DATA_TYPE_UINT8  : Convert<SrcT, uint8_t>(src, pDst); break;
+        case Bitmap::DATA_TYPE_UINT16 : Convert<SrcT, uint16_t>(src, pDst); break;
+        case Bitmap::DATA_TYPE_FLOAT  : Convert<SrcT, float>(src, pDst); break;
+    }
+    // clang-format on
+    return ppx::SUCCESS;
+}
+
+} // namespace
+
+Result Bitmap::ConvertTo(Bitmap::Format format, Bitmap* pTargetBitmap) const
+{
+    if (IsNull(pTargetBitmap)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (pTargetBitmap == this) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    if (!IsOk()) {
+        return ppx::ERROR_BITMAP_BAD_COPY_SOURCE;
+    }
+
+    if ((ChannelDataType(mFormat) == Bitmap::DATA_TYPE_UINT32) || (ChannelDataType(format) == Bitmap::DATA_TYPE_UINT32) || (format == Bitmap::FORMAT_UNDEFINED)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    // Reuse the target's storage if it already fits.
+    bool fits = pTargetBitmap->IsOk() && (pTargetBitmap->GetFormat() == format) && (pTargetBitmap->GetWidth() == mWidth) && (pTargetBitmap->GetHeight() == mHeight);
+    if (!fits) {
+        Result ppxres = Bitmap::Create(mWidth, mHeight, format, pTargetBitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // clang-format off
+    switch (ChannelDataType(mFormat)) {
+        default: return ppx::ERROR_IMAGE_INVALID_FORMAT;
+        case Bitmap::DATA_TYPE_UINT8  : return ConvertFrom<uint8_t>(*this, pTargetBitmap);
+        case Bitmap::DATA_TYPE_UINT16 : return ConvertFrom<uint16_t>(*this, pTargetBitmap);
+        case Bitmap::DATA_TYPE_FLOAT  : return ConvertFrom<float>(*this, pTargetBitmap);
+    }
+    // clang-format on
+}
+
+} // namespace ppx
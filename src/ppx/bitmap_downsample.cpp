@@ -0,0 +1,452 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// 2x2 box filter downsampling for Bitmap::DownsampleTo.
+//
+// RGBA 8-bit, 16-bit and float rows have SSE2 kernels on x86, and AVX2
+// kernels selected at runtime with GCC and Clang. Every other case, including
+// the last pixel of rows and columns of odd size, goes through the scalar
+// path. The kernels sum the same samples in the same order as the scalar
+// path, so the results do not depend on the instruction set.
+
+#include "ppx/bitmap.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PPX_DOWNSAMPLE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PPX_DOWNSAMPLE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+namespace ppx {
+
+namespace {
+
+// Returns the first source column (or row) of a destination pixel and the
+// number of source columns it averages: 2, or 3 for the last pixel when the
+// source size is odd so that no source pixel is dropped, or 1 when the
+// source size is 1.
+uint32_t GetTapCount(uint32_t dst, uint32_t dstSize, uint32_t srcSize, uint32_t* pFirst)
+{
+    if (srcSize == 1) {
+        *pFirst = 0;
+        return 1;
+    }
+    *pFirst = 2 * dst;
+    return ((dst == dstSize - 1) && ((srcSize & 1) != 0)) ? 3 : 2;
+}
+
+template <typename T>
+struct Accumulator
+{
+    using Type = uint32_t;
+};
+
+template <>
+struct Accumulator<uint32_t>
+{
+    using Type = uint64_t;
+};
+
+template <>
+struct Accumulator<float>
+{
+    using Type = float;
+};
+
+// Rounds to nearest.
+template <typename T, typename SumT>
+T Average(SumT sum, uint32_t count)
+{
+    return static_cast<T>((sum + count / 2) / count);
+}
+
+template <>
+float Average<float, float>(float sum, uint32_t count)
+{
+    return sum / static_cast<float>(count);
+}
+
+// Downsamples destination pixels [dstBegin, dstWidth) of a row from rowCount
+// source rows. Samples are summed column by column, each column from top to
+// bottom.
+template <typename T>
+void DownsampleRowScalar(const char* const* ppRows, uint32_t rowCount, uint32_t srcWidth, uint32_t channelCount, uint32_t dstBegin, uint32_t dstWidth, char* pDstRow)
+{
+    using SumT = typename Accumulator<T>::Type;
+
+    T* pDst = reinterpret_cast<T*>(pDstRow);
+    for (uint32_t x = dstBegin; x < dstWidth; ++x) {
+        uint32_t first    = 0;
+        uint32_t tapCount = GetTapCount(x, dstWidth, srcWidth, &first);
+        uint32_t count    = tapCount * rowCount;
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            SumT sum = 0;
+            for (uint32_t i = 0; i < tapCount; ++i) {
+                const uint32_t offset    = (first + i) * channelCount + c;
+                SumT           columnSum = reinterpret_cast<const T*>(ppRows[0])[offset];
+                for (uint32_t r = 1; r < rowCount; ++r) {
+                    columnSum += reinterpret_cast<const T*>(ppRows[r])[offset];
+                }
+                sum = (i == 0) ? columnSum : (sum + columnSum);
+            }
+            pDst[x * channelCount + c] = Average<T>(sum, count);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// sRGB
+// -------------------------------------------------------------------------------------------------
+constexpr uint32_t kSRGBEncodeBucketCount = 4096;
+
+struct SRGBTables
+{
+    float toLinear[256];
+    // Linear value halfway between consecutive 8-bit sRGB values: encoding
+    // rounds to i + 1 from thresholds[i].
+    float thresholds[255];
+    // Encoding of the start of each bucket of linear values, which is at
+    // most a couple of values away from the encoding of values in the bucket.
+    uint8_t encodeBuckets[kSRGBEncodeBucketCount];
+};
+
+float SRGBToLinear(float value)
+{
+    return (value <= 0.04045f) ? (value / 12.92f) : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+const SRGBTables& GetSRGBTables()
+{
+    static const SRGBTables sTables = []() {
+        SRGBTables tables = {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            tables.toLinear[i] = SRGBToLinear(static_cast<float>(i) / 255.0f);
+        }
+        for (uint32_t i = 0; i < 255; ++i) {
+            tables.thresholds[i] = SRGBToLinear((static_cast<float>(i) + 0.5f) / 255.0f);
+        }
+        uint32_t encoded = 0;
+        for (uint32_t i = 0; i < kSRGBEncodeBucketCount; ++i) {
+            float value = static_cast<float>(i) / static_cast<float>(kSRGBEncodeBucketCount - 1);
+            while ((encoded < 255) && (tables.thresholds[encoded] <= value)) {
+                ++encoded;
+            }
+            tables.encodeBuckets[i] = static_cast<uint8_t>(encoded);
+        }
+        return tables;
+    }();
+    return sTables;
+}
+
+// Rounds to the nearest 8-bit sRGB value, exactly.
+uint8_t LinearToSRGB(const SRGBTables& tables, float value)
+{
+    float    bucket  = std::min(std::max(value, 0.0f), 1.0f) * static_cast<float>(kSRGBEncodeBucketCount - 1);
+    uint32_t encoded = tables.encodeBuckets[static_cast<uint32_t>(bucket)];
+    while ((encoded < 255) && (tables.thresholds[encoded] <= value)) {
+        ++encoded;
+    }
+    while ((encoded > 0) && (tables.thresholds[encoded - 1] > value)) {
+        --encoded;
+    }
+    return static_cast<uint8_t>(encoded);
+}
+
+// Averages the color channels in linear space. The fourth channel is alpha,
+// which is linear already.
+void DownsampleRowSRGB(const char* const* ppRows, uint32_t rowCount, uint32_t srcWidth, uint32_t channelCount, uint32_t dstWidth, char* pDstRow)
+{
+    const SRGBTables& tables = GetSRGBTables();
+
+    uint8_t* pDst = reinterpret_cast<uint8_t*>(pDstRow);
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+        uint32_t first    = 0;
+        uint32_t tapCount = GetTapCount(x, dstWidth, srcWidth, &first);
+        uint32_t count    = tapCount * rowCount;
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            const bool isAlpha = (c == 3);
+            float      sum     = 0;
+            uint32_t   sumU8   = 0;
+            for (uint32_t i = 0; i < tapCount; ++i) {
+                for (uint32_t r = 0; r < rowCount; ++r) {
+                    uint8_t value = reinterpret_cast<const uint8_t*>(ppRows[r])[(first + i) * channelCount + c];
+                    sum += tables.toLinear[value];
+                    sumU8 += value;
+                }
+            }
+            pDst[x * channelCount + c] = isAlpha ? Average<uint8_t>(sumU8, count) : LinearToSRGB(tables, sum / static_cast<float>(count));
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// SIMD kernels
+// -------------------------------------------------------------------------------------------------
+
+// Downsamples the first pixels of a row from two source rows, 2x2 samples
+// each, and returns the number of pixels written, at most dstCount.
+using DownsampleRowFn = uint32_t (*)(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow);
+
+#if defined(PPX_DOWNSAMPLE_SSE2)
+uint32_t DownsampleRowRGBA8SSE2(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two  = _mm_set1_epi16(2);
+
+    uint32_t x = 0;
+    for (; x + 4 <= dstCount; x += 4) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + 8 * x));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + 8 * x + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + 8 * x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + 8 * x + 16));
+
+        // Column sums of source pixels 0-1, 2-3, 4-5 and 6-7, in 16 bits.
+        __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // Add pixel pairs, which end up in the low half of each register.
+        s01 = _mm_add_epi16(s01, _mm_srli_si128(s01, 8));
+        s23 = _mm_add_epi16(s23, _mm_srli_si128(s23, 8));
+        s45 = _mm_add_epi16(s45, _mm_srli_si128(s45, 8));
+        s67 = _mm_add_epi16(s67, _mm_srli_si128(s67, 8));
+
+        __m128i d01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s01, s23), two), 2);
+        __m128i d23 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s45, s67), two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 4 * x), _mm_packus_epi16(d01, d23));
+    }
+    return x;
+}
+
+uint32_t DownsampleRowRGBA16SSE2(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two  = _mm_set1_epi32(2);
+    const __m128i bias = _mm_set1_epi32(0x8000);
+
+    uint32_t x = 0;
+    for (; x + 2 <= dstCount; x += 2) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + 16 * x));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + 16 * x + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + 16 * x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + 16 * x + 16));
+
+        // Column sums of each source pixel in 32 bits, then pixel pairs.
+        __m128i d0 = _mm_add_epi32(
+            _mm_add_epi32(_mm_unpacklo_epi16(a0, zero), _mm_unpacklo_epi16(b0, zero)),
+            _mm_add_epi32(_mm_unpackhi_epi16(a0, zero), _mm_unpackhi_epi16(b0, zero)));
+        __m128i d1 = _mm_add_epi32(
+            _mm_add_epi32(_mm_unpacklo_epi16(a1, zero), _mm_unpacklo_epi16(b1, zero)),
+            _mm_add_epi32(_mm_unpackhi_epi16(a1, zero), _mm_unpackhi_epi16(b1, zero)));
+        d0 = _mm_srli_epi32(_mm_add_epi32(d0, two), 2);
+        d1 = _mm_srli_epi32(_mm_add_epi32(d1, two), 2);
+
+        // SSE2 only packs with signed saturation: bias the values to the
+        // signed range and back.
+        __m128i packed = _mm_packs_epi32(_mm_sub_epi32(d0, bias), _mm_sub_epi32(d1, bias));
+        packed         = _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 8 * x), packed);
+    }
+    return x;
+}
+
+uint32_t DownsampleRowRGBA32FSSE2(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+
+    const float* pSrc0 = reinterpret_cast<const float*>(pRow0);
+    const float* pSrc1 = reinterpret_cast<const float*>(pRow1);
+    float*       pDst  = reinterpret_cast<float*>(pDstRow);
+    for (uint32_t x = 0; x < dstCount; ++x) {
+        __m128 c0 = _mm_add_ps(_mm_loadu_ps(pSrc0 + 8 * x), _mm_loadu_ps(pSrc1 + 8 * x));
+        __m128 c1 = _mm_add_ps(_mm_loadu_ps(pSrc0 + 8 * x + 4), _mm_loadu_ps(pSrc1 + 8 * x + 4));
+        _mm_storeu_ps(pDst + 4 * x, _mm_mul_ps(_mm_add_ps(c0, c1), quarter));
+    }
+    return dstCount;
+}
+#endif // defined(PPX_DOWNSAMPLE_SSE2)
+
+#if defined(PPX_DOWNSAMPLE_AVX2)
+__attribute__((target("avx2"))) uint32_t DownsampleRowRGBA8AVX2(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow)
+{
+    // Interleaves the channels of pixel pairs, so that multiplying and adding
+    // adjacent bytes sums the pairs.
+    const __m256i interleave = _mm256_setr_epi8(
+        0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15,
+        0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i two  = _mm256_set1_epi16(2);
+
+    uint32_t x = 0;
+    for (; x + 4 <= dstCount; x += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + 8 * x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + 8 * x));
+        a         = _mm256_maddubs_epi16(_mm256_shuffle_epi8(a, interleave), ones);
+        b         = _mm256_maddubs_epi16(_mm256_shuffle_epi8(b, interleave), ones);
+
+        __m256i d = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(a, b), two), 2);
+        d         = _mm256_permute4x64_epi64(_mm256_packus_epi16(d, d), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 4 * x), _mm256_castsi256_si128(d));
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) uint32_t DownsampleRowRGBA16AVX2(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two  = _mm256_set1_epi32(2);
+
+    uint32_t x = 0;
+    for (; x + 2 <= dstCount; x += 2) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + 16 * x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + 16 * x));
+
+        // The low and high halves of each lane are the two pixels of a pair.
+        __m256i d = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_unpacklo_epi16(a, zero), _mm256_unpacklo_epi16(b, zero)),
+            _mm256_add_epi32(_mm256_unpackhi_epi16(a, zero), _mm256_unpackhi_epi16(b, zero)));
+        d = _mm256_srli_epi32(_mm256_add_epi32(d, two), 2);
+        d = _mm256_permute4x64_epi64(_mm256_packus_epi32(d, d), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDstRow + 8 * x), _mm256_castsi256_si128(d));
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) uint32_t DownsampleRowRGBA32FAVX2(const char* pRow0, const char* pRow1, uint32_t dstCount, char* pDstRow)
+{
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+
+    const float* pSrc0 = reinterpret_cast<const float*>(pRow0);
+    const float* pSrc1 = reinterpret_cast<const float*>(pRow1);
+    float*       pDst  = reinterpret_cast<float*>(pDstRow);
+
+    uint32_t x = 0;
+    for (; x + 2 <= dstCount; x += 2) {
+        __m256 c01 = _mm256_add_ps(_mm256_loadu_ps(pSrc0 + 8 * x), _mm256_loadu_ps(pSrc1 + 8 * x));
+        __m256 c23 = _mm256_add_ps(_mm256_loadu_ps(pSrc0 + 8 * x + 8), _mm256_loadu_ps(pSrc1 + 8 * x + 8));
+        __m256 c02 = _mm256_permute2f128_ps(c01, c23, 0x20);
+        __m256 c13 = _mm256_permute2f128_ps(c01, c23, 0x31);
+        _mm256_storeu_ps(pDst + 4 * x, _mm256_mul_ps(_mm256_add_ps(c02, c13), quarter));
+    }
+    return x;
+}
+
+bool IsAVX2Supported()
+{
+    static const bool sSupported = __builtin_cpu_supports("avx2");
+    return sSupported;
+}
+#endif // defined(PPX_DOWNSAMPLE_AVX2)
+
+DownsampleRowFn GetDownsampleRowFn(Bitmap::Format format)
+{
+#if defined(PPX_DOWNSAMPLE_AVX2)
+    if (IsAVX2Supported()) {
+        switch (format) {
+            default: break;
+            case Bitmap::FORMAT_RGBA_UINT8: return DownsampleRowRGBA8AVX2;
+            case Bitmap::FORMAT_RGBA_UINT16: return DownsampleRowRGBA16AVX2;
+            case Bitmap::FORMAT_RGBA_FLOAT: return DownsampleRowRGBA32FAVX2;
+        }
+    }
+#endif
+#if defined(PPX_DOWNSAMPLE_SSE2)
+    switch (format) {
+        default: break;
+        case Bitmap::FORMAT_RGBA_UINT8: return DownsampleRowRGBA8SSE2;
+        case Bitmap::FORMAT_RGBA_UINT16: return DownsampleRowRGBA16SSE2;
+        case Bitmap::FORMAT_RGBA_FLOAT: return DownsampleRowRGBA32FSSE2;
+    }
+#endif
+    return nullptr;
+}
+
+template <typename T>
+void Downsample(const Bitmap& src, Bitmap* pDst, bool srgb)
+{
+    const uint32_t  srcWidth     = src.GetWidth();
+    const uint32_t  dstWidth     = pDst->GetWidth();
+    const uint32_t  dstHeight    = pDst->GetHeight();
+    const uint32_t  channelCount = src.GetChannelCount();
+    DownsampleRowFn rowFn        = srgb ? nullptr : GetDownsampleRowFn(src.GetFormat());
+
+    // Destination pixels that the kernels can process: all but the last one
+    // if the source width is odd.
+    const uint32_t simdCount = (srcWidth > 1) ? (dstWidth - (srcWidth & 1)) : 0;
+
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+        uint32_t    first    = 0;
+        uint32_t    rowCount = GetTapCount(y, dstHeight, src.GetHeight(), &first);
+        const char* rows[3]  = {};
+        for (uint32_t r = 0; r < rowCount; ++r) {
+            rows[r] = src.GetData() + static_cast<size_t>(first + r) * src.GetRowStride();
+        }
+        char* pDstRow = pDst->GetData() + static_cast<size_t>(y) * pDst->GetRowStride();
+
+        if (srgb) {
+            DownsampleRowSRGB(rows, rowCount, srcWidth, channelCount, dstWidth, pDstRow);
+            continue;
+        }
+
+        uint32_t dstBegin = 0;
+        if ((rowFn != nullptr) && (rowCount == 2)) {
+            dstBegin = rowFn(rows[0], rows[1], simdCount, pDstRow);
+        }
+        DownsampleRowScalar<T>(rows, rowCount, srcWidth, channelCount, dstBegin, dstWidth, pDstRow);
+    }
+}
+
+} // namespace
+
+Result Bitmap::DownsampleTo(Bitmap* pTargetBitmap, bool srgb) const
+{
+    if (IsNull(pTargetBitmap)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if ((pTargetBitmap->GetFormat() != mFormat) || (mFormat == Bitmap::FORMAT_UNDEFINED)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    if ((mWidth == 0) || (mHeight == 0) ||
+        (pTargetBitmap->GetWidth() != std::max<uint32_t>(mWidth / 2, 1)) ||
+        (pTargetBitmap->GetHeight() != std::max<uint32_t>(mHeight / 2, 1))) {
+        return ppx::ERROR_BITMAP_FOOTPRINT_MISMATCH;
+    }
+
+    if (IsNull(mData) || IsNull(pTargetBitmap->GetData())) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    // clang-format off
+    switch (ChannelDataType(mFormat)) {
+        default: return ppx::ERROR_IMAGE_INVALID_FORMAT;
+        case Bitmap::DATA_TYPE_UINT8  : Downsample<uint8_t>(*this, pTargetBitmap, srgb); break;
+        case Bitmap::DATA_TYPE_UINT16 : Downsample<uint16_t>(*this, pTargetBitmap, false); break;
+        case Bitmap::DATA_TYPE_UINT32 : Downsample<uint32_t>(*this, pTargetBitmap, false); break;
+        case Bitmap::DATA_TYPE_FLOAT  : Downsample<float>(*this, pTargetBitmap, false); break;
+    }
+    // clang-format on
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
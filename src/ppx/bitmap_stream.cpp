@@ -0,0 +1,1034 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Incremental PNG and Radiance HDR decoders for Bitmap::StreamFromMemory.
+//
+// stb_image decodes a whole image at once, so these decoders reimplement the
+// parts of it needed to produce rows in order: a resumable inflate for PNG and
+// the run-length scanlines of HDR. Pixels and formats match what LoadFile gets
+// from stb_image with 4 requested channels.
+
+#include "ppx/bitmap.h"
+#include "ppx/fs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ppx {
+
+namespace {
+
+// Same limit as STBI_MAX_DIMENSIONS, so that row sizes fit in 32 bits for
+// every format.
+const uint32_t kMaxDimension = 1 << 24;
+
+// -------------------------------------------------------------------------------------------------
+// Band output
+// -------------------------------------------------------------------------------------------------
+
+// Collects decoded rows into a band and hands full bands to the sink.
+class BandWriter
+{
+public:
+    BandWriter(BitmapSink* pSink, uint32_t bandHeight)
+        : mSink(pSink), mBandHeight(bandHeight) {}
+
+    Result Begin(uint32_t width, uint32_t height, Bitmap::Format format)
+    {
+        if ((width > kMaxDimension) || (height > kMaxDimension)) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+
+        // Bitmaps address their storage with 32-bit sizes, so the band gets
+        // fewer rows if they would not fit.
+        const uint64_t rowSize = static_cast<uint64_t>(width) * Bitmap::FormatSize(format);
+        const uint64_t maxRows = std::max<uint64_t>(UINT32_MAX / rowSize, 1);
+
+        mWidth      = width;
+        mHeight     = height;
+        mFormat     = format;
+        mBandHeight = static_cast<uint32_t>(std::min<uint64_t>({mBandHeight, height, maxRows}));
+
+        Result ppxres = Bitmap::Create(width, mBandHeight, format, &mBand);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        return mSink->Begin(width, height, format);
+    }
+
+    // Returns the storage of the next row.
+    char* GetRow() { return mBand.GetData() + mBandRow * mBand.GetRowStride(); }
+
+    // Commits the row returned by GetRow.
+    Result NextRow()
+    {
+        ++mBandRow;
+        if ((mBandRow == mBandHeight) || ((mFirstRow + mBandRow) == mHeight)) {
+            return Flush();
+        }
+        return ppx::SUCCESS;
+    }
+
+private:
+    Result Flush()
+    {
+        // The last band is a view of the first rows of the band storage.
+        Bitmap band;
+        Result ppxres = Bitmap::Create(mWidth, mBandRow, mFormat, mBand.GetRowStride(), mBand.GetData(), &band);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        ppxres = mSink->WriteBand(mFirstRow, band);
+        mFirstRow += mBandRow;
+        mBandRow = 0;
+        return ppxres;
+    }
+
+private:
+    BitmapSink*    mSink       = nullptr;
+    uint32_t       mBandHeight = 0;
+    uint32_t       mWidth      = 0;
+    uint32_t       mHeight     = 0;
+    Bitmap::Format mFormat     = Bitmap::FORMAT_UNDEFINED;
+    Bitmap         mBand;
+    uint32_t       mFirstRow = 0;
+    uint32_t       mBandRow  = 0;
+};
+
+// -------------------------------------------------------------------------------------------------
+// Inflate
+// -------------------------------------------------------------------------------------------------
+
+// Canonical Huffman code, decoded with a lookup table for short codes and a
+// search by code length for the others.
+class HuffmanCode
+{
+public:
+    static constexpr uint32_t kFastBits = 9;
+    static constexpr uint32_t kMaxBits  = 15;
+
+    bool Build(const uint8_t* pLengths, uint32_t count)
+    {
+        uint32_t lengthCounts[kMaxBits + 1] = {};
+        for (uint32_t i = 0; i < count; ++i) {
+            ++lengthCounts[pLengths[i]];
+        }
+        lengthCounts[0] = 0;
+        for (uint32_t i = 1; i <= kMaxBits; ++i) {
+            if (lengthCounts[i] > (1u << i)) {
+                return false;
+            }
+        }
+
+        uint32_t nextCode[kMaxBits + 1] = {};
+        uint32_t code                   = 0;
+        uint32_t symbolIndex            = 0;
+        for (uint32_t i = 1; i <= kMaxBits; ++i) {
+            nextCode[i]    = code;
+            mFirstCode[i]  = static_cast<uint16_t>(code);
+            mFirstIndex[i] = static_cast<uint16_t>(symbolIndex);
+            code += lengthCounts[i];
+            if ((lengthCounts[i] != 0) && ((code - 1) >= (1u << i))) {
+                return false;
+            }
+            // Codes of this length are below mMaxCode[i] once left aligned to 16 bits.
+            mMaxCode[i] = code << (16 - i);
+            code <<= 1;
+            symbolIndex += lengthCounts[i];
+        }
+        mMaxCode[kMaxBits + 1] = 0x10000;
+
+        std::fill(std::begin(mFast), std::end(mFast), kNoFastEntry);
+        for (uint32_t symbol = 0; symbol < count; ++symbol) {
+            uint32_t length = pLengths[symbol];
+            if (length == 0) {
+                continue;
+            }
+            uint32_t index  = nextCode[length] - mFirstCode[length] + mFirstIndex[length];
+            mLengths[index] = static_cast<uint8_t>(length);
+            mSymbols[index] = static_cast<uint16_t>(symbol);
+            if (length <= kFastBits) {
+                // Deflate stores codes from the most significant bit, the bit
+                // reader returns the least significant bit first.
+                for (uint32_t j = ReverseBits(nextCode[length], length); j < (1u << kFastBits); j += (1u << length)) {
+                    mFast[j] = static_cast<uint16_t>(index);
+                }
+            }
+            ++nextCode[length];
+        }
+        return true;
+    }
+
+    // Decodes a symbol from the low bits of bits. Returns the symbol and sets
+    // *pLength to the code length, or returns -1 for an invalid code.
+    int32_t Decode(uint64_t bits, uint32_t* pLength) const
+    {
+        uint16_t index = mFast[bits & ((1u << kFastBits) - 1)];
+        if (index != kNoFastEntry) {
+            *pLength = mLengths[index];
+            return mSymbols[index];
+        }
+
+        uint32_t code   = ReverseBits(static_cast<uint32_t>(bits & 0xFFFF), 16);
+        uint32_t length = kFastBits + 1;
+        while ((length <= kMaxBits) && (code >= mMaxCode[length])) {
+            ++length;
+        }
+        if (length > kMaxBits) {
+            return -1;
+        }
+        uint32_t symbolIndex = (code >> (16 - length)) - mFirstCode[length] + mFirstIndex[length];
+        if ((symbolIndex >= std::size(mSymbols)) || (mLengths[symbolIndex] != length)) {
+            return -1;
+        }
+        *pLength = length;
+        return mSymbols[symbolIndex];
+    }
+
+private:
+    static constexpr uint16_t kNoFastEntry = 0xFFFF;
+
+    static uint32_t ReverseBits(uint32_t value, uint32_t count)
+    {
+        uint32_t result = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            result = (result << 1) | ((value >> i) & 1);
+        }
+        return result;
+    }
+
+    uint16_t mFast[1u << kFastBits]    = {};
+    uint16_t mFirstCode[kMaxBits + 1]  = {};
+    uint16_t mFirstIndex[kMaxBits + 1] = {};
+    uint32_t mMaxCode[kMaxBits + 2]    = {};
+    uint8_t  mLengths[288]             = {};
+    uint16_t mSymbols[288]             = {};
+};
+
+// Zlib stream decoder that produces its output on demand, keeping only the
+// 32 KiB window that back-references can reach. The compressed stream may be
+// split across several spans, as the IDAT chunks of a PNG.
+class Inflater
+{
+public:
+    struct Span
+    {
+        const uint8_t* pData = nullptr;
+        size_t         size  = 0;
+    };
+
+    explicit Inflater(std::vector<Span> spans)
+        : mSpans(std::move(spans)), mWindow(kWindowSize) {}
+
+    // Reads the zlib header. Returns false if it is invalid or uses a preset
+    // dictionary, which PNG does not allow.
+    bool Begin()
+    {
+        uint32_t cmf = GetBits(8);
+        uint32_t flg = GetBits(8);
+        return !mOverrun && ((cmf & 0xF) == 8) && (((cmf << 8) | flg) % 31 == 0) && ((flg & 0x20) == 0);
+    }
+
+    // Decompresses exactly size bytes to pDst. Returns false on corrupt or
+    // truncated data.
+    bool Read(uint8_t* pDst, size_t size)
+    {
+        while (size > 0) {
+            if (mMatchLength > 0) {
+                size_t count = std::min<size_t>(mMatchLength, size);
+                for (size_t i = 0; i < count; ++i) {
+                    uint8_t value = mWindow[(mPosition - mMatchDistance) & kWindowMask];
+                    Put(value);
+                    *pDst++ = value;
+                }
+                mMatchLength -= static_cast<uint32_t>(count);
+                size -= count;
+            }
+            else if (mStoredRemaining > 0) {
+                uint8_t value = static_cast<uint8_t>(GetBits(8));
+                Put(value);
+                *pDst++ = value;
+                --mStoredRemaining;
+                --size;
+            }
+            else if (!mInBlock) {
+                if (mFinalBlock || !BeginBlock()) {
+                    return false;
+                }
+            }
+            else {
+                int32_t symbol = DecodeSymbol(mLiteralCode);
+                if (symbol < 0) {
+                    return false;
+                }
+                if (symbol < 256) {
+                    Put(static_cast<uint8_t>(symbol));
+                    *pDst++ = static_cast<uint8_t>(symbol);
+                    --size;
+                }
+                else if (symbol == 256) {
+                    mInBlock = false;
+                }
+                else if (!BeginMatch(symbol)) {
+                    return false;
+                }
+            }
+            if (mOverrun) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint32_t kWindowSize = 32768;
+    static constexpr uint32_t kWindowMask = kWindowSize - 1;
+
+    void Put(uint8_t value)
+    {
+        mWindow[mPosition & kWindowMask] = value;
+        ++mPosition;
+    }
+
+    void Refill()
+    {
+        while (mBitCount <= 56) {
+            while ((mSpanIndex < mSpans.size()) && (mSpanOffset == mSpans[mSpanIndex].size)) {
+                ++mSpanIndex;
+                mSpanOffset = 0;
+            }
+            if (mSpanIndex == mSpans.size()) {
+                // Pad with zero bytes past the end, reads of the padding are
+                // caught when the bits are consumed.
+                mPaddingBits += 8;
+            }
+            else {
+                mBits |= static_cast<uint64_t>(mSpans[mSpanIndex].pData[mSpanOffset++]) << mBitCount;
+            }
+            mBitCount += 8;
+        }
+    }
+
+    void Consume(uint32_t count)
+    {
+        mBits >>= count;
+        mBitCount -= count;
+        if (mBitCount < mPaddingBits) {
+            mOverrun = true;
+        }
+    }
+
+    uint32_t GetBits(uint32_t count)
+    {
+        if (count == 0) {
+            return 0;
+        }
+        if (mBitCount < count) {
+            Refill();
+        }
+        uint32_t value = static_cast<uint32_t>(mBits & ((1ull << count) - 1));
+        Consume(count);
+        return value;
+    }
+
+    int32_t DecodeSymbol(const HuffmanCode& code)
+    {
+        if (mBitCount < 16) {
+            Refill();
+        }
+        uint32_t length = 0;
+        int32_t  symbol = code.Decode(mBits, &length);
+        if (symbol >= 0) {
+            Consume(length);
+        }
+        return symbol;
+    }
+
+    bool BeginBlock()
+    {
+        mFinalBlock   = (GetBits(1) != 0);
+        uint32_t type = GetBits(2);
+        switch (type) {
+            case 0: {
+                // Stored blocks start on a byte boundary.
+                GetBits(mBitCount % 8);
+                uint32_t length  = GetBits(16);
+                uint32_t nlength = GetBits(16);
+                if ((length ^ 0xFFFF) != nlength) {
+                    return false;
+                }
+                mStoredRemaining = length;
+                return !mOverrun;
+            }
+            case 1: {
+                uint8_t lengths[288 + 32];
+                std::fill(lengths, lengths + 144, static_cast<uint8_t>(8));
+                std::fill(lengths + 144, lengths + 256, static_cast<uint8_t>(9));
+                std::fill(lengths + 256, lengths + 280, static_cast<uint8_t>(7));
+                std::fill(lengths + 280, lengths + 288, static_cast<uint8_t>(8));
+                std::fill(lengths + 288, lengths + 320, static_cast<uint8_t>(5));
+                mInBlock = mLiteralCode.Build(lengths, 288) && mDistanceCode.Build(lengths + 288, 32);
+                return mInBlock;
+            }
+            case 2: {
+                mInBlock = ReadDynamicCodes();
+                return mInBlock;
+            }
+            default: break;
+        }
+        return false;
+    }
+
+    bool ReadDynamicCodes()
+    {
+        static const uint8_t kCodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        uint32_t literalCount    = GetBits(5) + 257;
+        uint32_t distanceCount   = GetBits(5) + 1;
+        uint32_t codeLengthCount = GetBits(4) + 4;
+        // HLIT and HDIST can encode more codes than the alphabets have.
+        if ((literalCount > 286) || (distanceCount > 30)) {
+            return false;
+        }
+
+        uint8_t codeLengthLengths[19] = {};
+        for (uint32_t i = 0; i < codeLengthCount; ++i) {
+            codeLengthLengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(GetBits(3));
+        }
+        HuffmanCode codeLengthCode;
+        if (mOverrun || !codeLengthCode.Build(codeLengthLengths, 19)) {
+            return false;
+        }
+
+        uint8_t  lengths[286 + 32] = {};
+        uint32_t totalCount        = literalCount + distanceCount;
+        uint32_t count             = 0;
+        while (count < totalCount) {
+            int32_t symbol = DecodeSymbol(codeLengthCode);
+            if ((symbol < 0) || mOverrun) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[count++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t  value  = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (count == 0) {
+                    return false;
+                }
+                value  = lengths[count - 1];
+                repeat = 3 + GetBits(2);
+            }
+            else if (symbol == 17) {
+                repeat = 3 + GetBits(3);
+            }
+            else {
+                repeat = 11 + GetBits(7);
+            }
+            if ((count + repeat) > totalCount) {
+                return false;
+            }
+            std::fill(lengths + count, lengths + count + repeat, value);
+            count += repeat;
+        }
+
+        // The end of block code must be present.
+        if (lengths[256] == 0) {
+            return false;
+        }
+        return mLiteralCode.Build(lengths, literalCount) && mDistanceCode.Build(lengths + literalCount, distanceCount);
+    }
+
+    bool BeginMatch(int32_t symbol)
+    {
+        static const uint16_t kLengthBase[29]    = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t  kLengthExtra[29]   = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const uint16_t kDistanceBase[30]  = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const uint8_t  kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        uint32_t lengthIndex = static_cast<uint32_t>(symbol - 257);
+        if (lengthIndex >= 29) {
+            return false;
+        }
+        uint32_t length = kLengthBase[lengthIndex] + GetBits(kLengthExtra[lengthIndex]);
+
+        int32_t distanceSymbol = DecodeSymbol(mDistanceCode);
+        if ((distanceSymbol < 0) || (distanceSymbol >= 30)) {
+            return false;
+        }
+        uint32_t distance = kDistanceBase[distanceSymbol] + GetBits(kDistanceExtra[distanceSymbol]);
+        if (distance > mPosition) {
+            return false;
+        }
+
+        mMatchLength   = length;
+        mMatchDistance = distance;
+        return true;
+    }
+
+private:
+    std::vector<Span>    mSpans;
+    size_t               mSpanIndex   = 0;
+    size_t               mSpanOffset  = 0;
+    uint64_t             mBits        = 0;
+    uint32_t             mBitCount    = 0;
+    uint32_t             mPaddingBits = 0;
+    bool                 mOverrun     = false;
+    std::vector<uint8_t> mWindow;
+    uint64_t             mPosition        = 0;
+    bool                 mInBlock         = false;
+    bool                 mFinalBlock      = false;
+    uint32_t             mStoredRemaining = 0;
+    uint32_t             mMatchLength     = 0;
+    uint32_t             mMatchDistance   = 0;
+    HuffmanCode          mLiteralCode;
+    HuffmanCode          mDistanceCode;
+};
+
+// -------------------------------------------------------------------------------------------------
+// PNG
+// -------------------------------------------------------------------------------------------------
+
+const uint8_t kPNGSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+enum PNGColorType
+{
+    PNG_COLOR_TYPE_GRAY       = 0,
+    PNG_COLOR_TYPE_RGB        = 2,
+    PNG_COLOR_TYPE_PALETTE    = 3,
+    PNG_COLOR_TYPE_GRAY_ALPHA = 4,
+    PNG_COLOR_TYPE_RGBA       = 6,
+};
+
+uint32_t ReadBigEndian32(const uint8_t* pData)
+{
+    return (static_cast<uint32_t>(pData[0]) << 24) | (static_cast<uint32_t>(pData[1]) << 16) | (static_cast<uint32_t>(pData[2]) << 8) | pData[3];
+}
+
+uint16_t ReadBigEndian16(const uint8_t* pData)
+{
+    return static_cast<uint16_t>((pData[0] << 8) | pData[1]);
+}
+
+uint8_t Paeth(int a, int b, int c)
+{
+    int p  = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if ((pa <= pb) && (pa <= pc)) {
+        return static_cast<uint8_t>(a);
+    }
+    return static_cast<uint8_t>((pb <= pc) ? b : c);
+}
+
+// Reverses the filter of a row in place. pPrevious is the unfiltered previous
+// row, all zeros for the first row.
+bool Unfilter(uint8_t filter, uint8_t* pRow, const uint8_t* pPrevious, size_t size, size_t bytesPerPixel)
+{
+    switch (filter) {
+        case 0: break;
+        case 1: {
+            for (size_t i = bytesPerPixel; i < size; ++i) {
+                pRow[i] = static_cast<uint8_t>(pRow[i] + pRow[i - bytesPerPixel]);
+            }
+        } break;
+        case 2: {
+            for (size_t i = 0; i < size; ++i) {
+                pRow[i] = static_cast<uint8_t>(pRow[i] + pPrevious[i]);
+            }
+        } break;
+        case 3: {
+            for (size_t i = 0; i < size; ++i) {
+                int left = (i >= bytesPerPixel) ? pRow[i - bytesPerPixel] : 0;
+                pRow[i]  = static_cast<uint8_t>(pRow[i] + ((left + pPrevious[i]) >> 1));
+            }
+        } break;
+        case 4: {
+            for (size_t i = 0; i < size; ++i) {
+                int left   = (i >= bytesPerPixel) ? pRow[i - bytesPerPixel] : 0;
+                int upLeft = (i >= bytesPerPixel) ? pPrevious[i - bytesPerPixel] : 0;
+                pRow[i]    = static_cast<uint8_t>(pRow[i] + Paeth(left, pPrevious[i], upLeft));
+            }
+        } break;
+        default: return false;
+    }
+    return true;
+}
+
+struct PNGInfo
+{
+    uint32_t                    width               = 0;
+    uint32_t                    height              = 0;
+    uint32_t                    bitDepth            = 0;
+    uint32_t                    colorType           = 0;
+    uint32_t                    channels            = 0;
+    uint8_t                     palette[256][4]     = {};
+    uint32_t                    paletteCount        = 0;
+    bool                        hasTransparentColor = false;
+    uint16_t                    transparentColor[3] = {};
+    std::vector<Inflater::Span> idat;
+};
+
+// Parses the chunks of a PNG. Returns ERROR_IMAGE_FILE_LOAD_FAILED for a corrupt
+// file and sets *pSupported to false for valid files that must be decoded by
+// stb_image instead.
+Result ParsePNG(const uint8_t* pData, size_t size, PNGInfo* pInfo, bool* pSupported)
+{
+    *pSupported = true;
+
+    size_t offset     = sizeof(kPNGSignature);
+    bool   hasHeader  = false;
+    bool   hasEnd     = false;
+    bool   interlaced = false;
+    while (!hasEnd) {
+        if ((size - offset) < 12) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+        uint32_t       length = ReadBigEndian32(pData + offset);
+        const uint8_t* pType  = pData + offset + 4;
+        const uint8_t* pChunk = pData + offset + 8;
+        if (length > (size - offset - 12)) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+        offset += 12 + static_cast<size_t>(length);
+
+        if (std::memcmp(pType, "IHDR", 4) == 0) {
+            if (hasHeader || (length != 13)) {
+                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+            }
+            hasHeader        = true;
+            pInfo->width     = ReadBigEndian32(pChunk);
+            pInfo->height    = ReadBigEndian32(pChunk + 4);
+            pInfo->bitDepth  = pChunk[8];
+            pInfo->colorType = pChunk[9];
+            interlaced       = (pChunk[12] != 0);
+            if ((pChunk[10] != 0) || (pChunk[11] != 0) || (pChunk[12] > 1)) {
+                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+            }
+            continue;
+        }
+        if (!hasHeader) {
+            // IHDR must come first; CgBI files from iOS put a chunk before it.
+            *pSupported = false;
+            return ppx::SUCCESS;
+        }
+
+        if (std::memcmp(pType, "PLTE", 4) == 0) {
+            if (((length % 3) != 0) || (length > 3 * 256)) {
+                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+            }
+            pInfo->paletteCount = length / 3;
+            for (uint32_t i = 0; i < pInfo->paletteCount; ++i) {
+                pInfo->palette[i][0] = pChunk[3 * i + 0];
+                pInfo->palette[i][1] = pChunk[3 * i + 1];
+                pInfo->palette[i][2] = pChunk[3 * i + 2];
+                pInfo->palette[i][3] = 255;
+            }
+        }
+        else if (std::memcmp(pType, "tRNS", 4) == 0) {
+            if (pInfo->colorType == PNG_COLOR_TYPE_PALETTE) {
+                if (length > pInfo->paletteCount) {
+                    return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+                }
+                for (uint32_t i = 0; i < length; ++i) {
+                    pInfo->palette[i][3] = pChunk[i];
+                }
+            }
+            else if ((pInfo->colorType == PNG_COLOR_TYPE_GRAY) || (pInfo->colorType == PNG_COLOR_TYPE_RGB)) {
+                uint32_t channels = (pInfo->colorType == PNG_COLOR_TYPE_GRAY) ? 1 : 3;
+                if (length != 2 * channels) {
+                    return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+                }
+                pInfo->hasTransparentColor = true;
+                for (uint32_t i = 0; i < channels; ++i) {
+                    uint16_t value             = ReadBigEndian16(pChunk + 2 * i);
+                    pInfo->transparentColor[i] = (pInfo->bitDepth == 16) ? value : static_cast<uint16_t>(value & 0xFF);
+                }
+            }
+            else {
+                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+            }
+        }
+        else if (std::memcmp(pType, "IDAT", 4) == 0) {
+            pInfo->idat.push_back({pChunk, length});
+        }
+        else if (std::memcmp(pType, "IEND", 4) == 0) {
+            hasEnd = true;
+        }
+        else if ((pType[0] & 0x20) == 0) {
+            // Unknown critical chunk.
+            *pSupported = false;
+            return ppx::SUCCESS;
+        }
+    }
+
+    // clang-format off
+    switch (pInfo->colorType) {
+        default: return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        case PNG_COLOR_TYPE_GRAY       : pInfo->channels = 1; break;
+        case PNG_COLOR_TYPE_RGB        : pInfo->channels = 3; break;
+        case PNG_COLOR_TYPE_PALETTE    : pInfo->channels = 1; break;
+        case PNG_COLOR_TYPE_GRAY_ALPHA : pInfo->channels = 2; break;
+        case PNG_COLOR_TYPE_RGBA       : pInfo->channels = 4; break;
+    }
+    // clang-format on
+
+    const uint32_t depth      = pInfo->bitDepth;
+    const bool     validDepth = (pInfo->colorType == PNG_COLOR_TYPE_GRAY)      ? ((depth == 1) || (depth == 2) || (depth == 4) || (depth == 8) || (depth == 16))
+                                : (pInfo->colorType == PNG_COLOR_TYPE_PALETTE) ? ((depth == 1) || (depth == 2) || (depth == 4) || (depth == 8))
+                                                                               : ((depth == 8) || (depth == 16));
+    if (!validDepth || (pInfo->width == 0) || (pInfo->height == 0) || pInfo->idat.empty()) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    if ((pInfo->width > kMaxDimension) || (pInfo->height > kMaxDimension)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    if ((pInfo->colorType == PNG_COLOR_TYPE_PALETTE) && (pInfo->paletteCount == 0)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    // Adam7 passes do not produce rows in order.
+    if (interlaced) {
+        *pSupported = false;
+    }
+    return ppx::SUCCESS;
+}
+
+// Expands an unfiltered row to RGBA8, as stb_image does: 16-bit values keep
+// their high byte, low bit depth gray is scaled to the full range, and a tRNS
+// color makes matching pixels transparent.
+void ExpandPNGRow(const PNGInfo& info, const uint8_t* pSrc, uint8_t* pDst)
+{
+    static const uint8_t kDepthScale[9] = {0, 0xFF, 0x55, 0, 0x11, 0, 0, 0, 0x01};
+
+    const uint32_t width = info.width;
+    if (info.bitDepth < 8) {
+        const uint32_t depth = info.bitDepth;
+        const uint32_t mask  = (1u << depth) - 1;
+        for (uint32_t x = 0; x < width; ++x) {
+            uint32_t bit   = x * depth;
+            uint32_t value = (pSrc[bit / 8] >> (8 - depth - (bit % 8))) & mask;
+            uint8_t* pOut  = pDst + 4 * x;
+            if (info.colorType == PNG_COLOR_TYPE_PALETTE) {
+                std::memcpy(pOut, info.palette[value], 4);
+            }
+            else {
+                uint8_t gray = static_cast<uint8_t>(value * kDepthScale[depth]);
+                pOut[0]      = gray;
+                pOut[1]      = gray;
+                pOut[2]      = gray;
+                pOut[3]      = (info.hasTransparentColor && (gray == static_cast<uint8_t>(info.transparentColor[0] * kDepthScale[depth]))) ? 0 : 255;
+            }
+        }
+        return;
+    }
+
+    const uint32_t bytesPerChannel = info.bitDepth / 8;
+    const uint32_t channels        = info.channels;
+    for (uint32_t x = 0; x < width; ++x) {
+        const uint8_t* pIn  = pSrc + x * channels * bytesPerChannel;
+        uint8_t*       pOut = pDst + 4 * x;
+
+        uint16_t values[4] = {};
+        for (uint32_t c = 0; c < channels; ++c) {
+            values[c] = (bytesPerChannel == 2) ? ReadBigEndian16(pIn + 2 * c) : pIn[c];
+        }
+        // clang-format off
+        switch (info.colorType) {
+            default: break;
+            case PNG_COLOR_TYPE_PALETTE    : std::memcpy(pOut, info.palette[values[0]], 4); continue;
+            case PNG_COLOR_TYPE_GRAY       : values[1] = values[0]; values[2] = values[0]; break;
+            case PNG_COLOR_TYPE_GRAY_ALPHA : values[3] = values[1]; values[1] = values[0]; values[2] = values[0]; break;
+            case PNG_COLOR_TYPE_RGB        : break;
+            case PNG_COLOR_TYPE_RGBA       : break;
+        }
+        // clang-format on
+
+        bool opaqueType = (info.colorType == PNG_COLOR_TYPE_GRAY) || (info.colorType == PNG_COLOR_TYPE_RGB);
+        if (opaqueType) {
+            bool transparent = info.hasTransparentColor;
+            for (uint32_t c = 0; c < channels; ++c) {
+                transparent = transparent && (values[c] == info.transparentColor[c]);
+            }
+            values[3] = transparent ? 0 : ((bytesPerChannel == 2) ? 0xFFFF : 0xFF);
+        }
+
+        for (uint32_t c = 0; c < 4; ++c) {
+            pOut[c] = static_cast<uint8_t>((bytesPerChannel == 2) ? (values[c] >> 8) : values[c]);
+        }
+    }
+}
+
+Result StreamPNG(const PNGInfo& info, BandWriter* pWriter)
+{
+    Result ppxres = pWriter->Begin(info.width, info.height, Bitmap::FORMAT_RGBA_UINT8);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t bitsPerPixel  = info.channels * info.bitDepth;
+    const size_t   rowSize       = (static_cast<size_t>(info.width) * bitsPerPixel + 7) / 8;
+    const size_t   bytesPerPixel = std::max<size_t>(1, bitsPerPixel / 8);
+
+    Inflater inflater(info.idat);
+    if (!inflater.Begin()) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    // Filter byte followed by the row, for the current and the previous row.
+    std::vector<uint8_t> rows[2] = {std::vector<uint8_t>(rowSize + 1), std::vector<uint8_t>(rowSize + 1)};
+    for (uint32_t y = 0; y < info.height; ++y) {
+        std::vector<uint8_t>&       row      = rows[y & 1];
+        const std::vector<uint8_t>& previous = rows[(y + 1) & 1];
+        if (!inflater.Read(row.data(), row.size())) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+        if (!Unfilter(row[0], row.data() + 1, previous.data() + 1, rowSize, bytesPerPixel)) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+        ExpandPNGRow(info, row.data() + 1, reinterpret_cast<uint8_t*>(pWriter->GetRow()));
+
+        ppxres = pWriter->NextRow();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Radiance HDR
+// -------------------------------------------------------------------------------------------------
+
+bool IsHDR(const uint8_t* pData, size_t size)
+{
+    auto startsWith = [pData, size](const char* pPrefix) {
+        size_t length = std::strlen(pPrefix);
+        return (size >= length) && (std::memcmp(pData, pPrefix, length) == 0);
+    };
+    return startsWith("#?RADIANCE\n") || startsWith("#?RGBE\n");
+}
+
+void ConvertRGBE(const uint8_t* pRGBE, float* pOut)
+{
+    if (pRGBE[3] != 0) {
+        float scale = static_cast<float>(std::ldexp(1.0f, pRGBE[3] - static_cast<int>(128 + 8)));
+        pOut[0]     = pRGBE[0] * scale;
+        pOut[1]     = pRGBE[1] * scale;
+        pOut[2]     = pRGBE[2] * scale;
+    }
+    else {
+        pOut[0] = 0.0f;
+        pOut[1] = 0.0f;
+        pOut[2] = 0.0f;
+    }
+    pOut[3] = 1.0f;
+}
+
+Result StreamHDR(const uint8_t* pData, size_t size, BandWriter* pWriter)
+{
+    size_t offset   = 0;
+    auto   readLine = [&](std::string* pLine) {
+        pLine->clear();
+        while ((offset < size) && (pData[offset] != '\n')) {
+            pLine->push_back(static_cast<char>(pData[offset++]));
+        }
+        bool found = (offset < size);
+        ++offset;
+        return found;
+    };
+
+    // Header lines up to an empty line, then the resolution.
+    std::string line;
+    bool        validFormat = false;
+    readLine(&line);
+    while (readLine(&line) && !line.empty()) {
+        if (line == "FORMAT=32-bit_rle_rgbe") {
+            validFormat = true;
+        }
+    }
+    if (!validFormat || !readLine(&line)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    int height = 0;
+    int width  = 0;
+    if ((std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2) || (width <= 0) || (height <= 0)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    if ((static_cast<uint32_t>(width) > kMaxDimension) || (static_cast<uint32_t>(height) > kMaxDimension)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    Result ppxres = pWriter->Begin(static_cast<uint32_t>(width), static_cast<uint32_t>(height), Bitmap::FORMAT_RGBA_FLOAT);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    std::vector<uint8_t> scanline(4 * static_cast<size_t>(width));
+    // Scanlines that are not run-length encoded mean the rest of the image is flat.
+    bool flat = (width < 8) || (width >= 32768);
+    for (int y = 0; y < height; ++y) {
+        if (!flat) {
+            if ((size - offset) < 4) {
+                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+            }
+            const uint8_t* pHeader = pData + offset;
+            if ((pHeader[0] != 2) || (pHeader[1] != 2) || ((pHeader[2] & 0x80) != 0)) {
+                flat = true;
+            }
+            else {
+                if ((((pHeader[2] << 8) | pHeader[3])) != width) {
+                    return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+                }
+                offset += 4;
+                for (int channel = 0; channel < 4; ++channel) {
+                    int x = 0;
+                    while (x < width) {
+                        if (offset >= size) {
+                            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+                        }
+                        int count = pData[offset++];
+                        if (count > 128) {
+                            count -= 128;
+                            if ((offset >= size) || (count > (width - x))) {
+                                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+                            }
+                            uint8_t value = pData[offset++];
+                            for (int i = 0; i < count; ++i) {
+                                scanline[4 * (x++) + channel] = value;
+                            }
+                        }
+                        else {
+                            if ((count == 0) || (count > (width - x)) || ((size - offset) < static_cast<size_t>(count))) {
+                                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+                            }
+                            for (int i = 0; i < count; ++i) {
+                                scanline[4 * (x++) + channel] = pData[offset++];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        if (flat) {
+            if ((size - offset) < scanline.size()) {
+                return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+            }
+            std::memcpy(scanline.data(), pData + offset, scanline.size());
+            offset += scanline.size();
+        }
+
+        float* pRow = reinterpret_cast<float*>(pWriter->GetRow());
+        for (int x = 0; x < width; ++x) {
+            ConvertRGBE(scanline.data() + 4 * x, pRow + 4 * x);
+        }
+        ppxres = pWriter->NextRow();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Fallback
+// -------------------------------------------------------------------------------------------------
+
+Result StreamDecodedBitmap(const size_t dataSize, const void* pData, BitmapSink* pSink, uint32_t bandHeight)
+{
+    Bitmap bitmap;
+    Result ppxres = Bitmap::LoadFromMemory(dataSize, pData, &bitmap);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = pSink->Begin(bitmap.GetWidth(), bitmap.GetHeight(), bitmap.GetFormat());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    for (uint32_t firstRow = 0; firstRow < bitmap.GetHeight(); firstRow += bandHeight) {
+        uint32_t rowCount = std::min(bandHeight, bitmap.GetHeight() - firstRow);
+        Bitmap   band;
+        ppxres = Bitmap::Create(bitmap.GetWidth(), rowCount, bitmap.GetFormat(), bitmap.GetRowStride(), bitmap.GetPixelAddress(0, firstRow), &band);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        ppxres = pSink->WriteBand(firstRow, band);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// Bitmap
+// -------------------------------------------------------------------------------------------------
+
+Result Bitmap::StreamFile(const std::filesystem::path& path, BitmapSink* pSink, uint32_t bandHeight)
+{
+    if (!ppx::fs::path_exists(path)) {
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+
+    // A mapped file keeps the compressed data out of the heap.
+    auto view = fs::load_file_view(path);
+    if (!view.has_value()) {
+        PPX_LOG_ERROR("Failed to open file '" + path.string() + "'");
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    return StreamFromMemory(view->GetSize(), view->GetData(), pSink, bandHeight);
+}
+
+Result Bitmap::StreamFromMemory(const size_t dataSize, const void* pData, BitmapSink* pSink, uint32_t bandHeight)
+{
+    if ((dataSize == 0) || IsNull(pData) || IsNull(pSink)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (bandHeight == 0) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    BandWriter     writer(pSink, bandHeight);
+
+    if ((dataSize >= sizeof(kPNGSignature)) && (std::memcmp(pBytes, kPNGSignature, sizeof(kPNGSignature)) == 0)) {
+        PNGInfo info;
+        bool    supported = true;
+        Result  ppxres    = ParsePNG(pBytes, dataSize, &info, &supported);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        if (supported) {
+            return StreamPNG(info, &writer);
+        }
+    }
+    else if (IsHDR(pBytes, dataSize)) {
+        return StreamHDR(pBytes, dataSize, &writer);
+    }
+
+    return StreamDecodedBitmap(dataSize, pData, pSink, bandHeight);
+}
+
+} // namespace ppx
@@ -0,0 +1,101 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/cache_file.h"
+#include "ppx/binary_file.h"
+
+#include <cstring>
+
+namespace ppx {
+
+namespace {
+
+const size_t kMagicSize      = 4;
+const size_t kFileHeaderSize = kMagicSize + 2 * sizeof(uint32_t);
+
+} // namespace
+
+Result CacheFile::WriteFile(
+    const std::filesystem::path&              path,
+    const char*                               pMagic,
+    uint32_t                                  version,
+    const std::vector<uint8_t>&               header,
+    const std::function<void(std::ostream&)>& writeData)
+{
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    bool written = internal::WriteFileAtomic(path, [&](std::ostream& file) {
+        uint32_t headerSize = CountU32(header);
+        file.write(pMagic, kMagicSize);
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&headerSize), sizeof(headerSize));
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        writeData(file);
+    });
+    if (!written) {
+        PPX_LOG_WARN("Failed to write cache file: " << path);
+        return ppx::ERROR_FAILED;
+    }
+    return ppx::SUCCESS;
+}
+
+size_t CacheFile::GetDataOffset(size_t headerSize)
+{
+    return kFileHeaderSize + headerSize;
+}
+
+Result CacheFile::MapFile(
+    const std::filesystem::path& path,
+    const char*                  pMagic,
+    uint32_t                     version,
+    const std::vector<uint8_t>&  key,
+    size_t*                      pHeaderOffset)
+{
+    mView.reset();
+    if (!std::filesystem::exists(path)) {
+        return ppx::ERROR_FAILED;
+    }
+
+    auto view = fs::load_file_view(path);
+    if (!view.has_value()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    internal::ByteReader reader(view->GetData(), view->GetSize());
+    char                 magic[kMagicSize] = {};
+    uint32_t             fileVersion       = 0;
+    uint32_t             headerSize        = 0;
+    for (char& c : magic) {
+        reader.Get(&c);
+    }
+    reader.Get(&fileVersion);
+    reader.Get(&headerSize);
+    if (!reader.IsValid() || (std::memcmp(magic, pMagic, kMagicSize) != 0) || (fileVersion != version)) {
+        return ppx::ERROR_FAILED;
+    }
+
+    // The header starts with the key.
+    if ((headerSize < key.size()) || (reader.GetRemainingSize() < key.size()) || (std::memcmp(view->GetData() + kFileHeaderSize, key.data(), key.size()) != 0)) {
+        return ppx::ERROR_FAILED;
+    }
+
+    mView          = std::move(view);
+    *pHeaderOffset = kFileHeaderSize + key.size();
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
@@ -0,0 +1,1351 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/compressed_image.h"
+#include "ppx/binary_file.h"
+#include "ppx/fs.h"
+#include "ppx/math_config.h"
+#include "ppx/parallel.h"
+
+#include <cmath>
+#include <limits>
+
+namespace ppx {
+
+namespace {
+
+// Levels are encoded in parallel for at least this many blocks per thread.
+constexpr size_t kMinEncodeBlocksPerThread = 256;
+
+constexpr uint32_t kBlockTexelCount = 16;
+
+// RGBA8 texels of a block, in row-major order.
+using BlockTexels = uint8_t[kBlockTexelCount][4];
+
+void LoadBlock(const Bitmap& bitmap, uint32_t blockX, uint32_t blockY, BlockTexels& texels)
+{
+    // Texels past the edge repeat the last row and column.
+    const uint32_t maxX = bitmap.GetWidth() - 1;
+    const uint32_t maxY = bitmap.GetHeight() - 1;
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        uint32_t x = std::min(blockX * 4 + (i % 4), maxX);
+        uint32_t y = std::min(blockY * 4 + (i / 4), maxY);
+        memcpy(texels[i], bitmap.GetData() + y * bitmap.GetRowStride() + x * 4, 4);
+    }
+}
+
+void StoreBlock(const BlockTexels& texels, uint32_t blockX, uint32_t blockY, Bitmap* pBitmap)
+{
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        uint32_t x = blockX * 4 + (i % 4);
+        uint32_t y = blockY * 4 + (i / 4);
+        if ((x < pBitmap->GetWidth()) && (y < pBitmap->GetHeight())) {
+            memcpy(pBitmap->GetData() + y * pBitmap->GetRowStride() + x * 4, texels[i], 4);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Endpoint fitting
+// -------------------------------------------------------------------------------------------------
+
+template <typename VecT>
+VecT Clamp255(const VecT& value)
+{
+    return glm::clamp(value, VecT(0.0f), VecT(255.0f));
+}
+
+// Returns the endpoints of the segment covering the colors along their
+// principal axis, found by power iteration on the covariance matrix.
+template <typename VecT>
+void FitPrincipalAxis(const VecT* pColors, VecT* pEndpoint0, VecT* pEndpoint1)
+{
+    constexpr int kN = VecT::length();
+
+    VecT mean = VecT(0.0f);
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        mean += pColors[i];
+    }
+    mean /= static_cast<float>(kBlockTexelCount);
+
+    float covariance[kN][kN] = {};
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        VecT d = pColors[i] - mean;
+        for (int r = 0; r < kN; ++r) {
+            for (int c = 0; c < kN; ++c) {
+                covariance[r][c] += d[r] * d[c];
+            }
+        }
+    }
+
+    // Start from the row of the channel with the largest variance, which is
+    // never orthogonal to the principal axis.
+    int maxChannel = 0;
+    for (int c = 1; c < kN; ++c) {
+        if (covariance[c][c] > covariance[maxChannel][maxChannel]) {
+            maxChannel = c;
+        }
+    }
+    VecT axis = VecT(0.0f);
+    for (int c = 0; c < kN; ++c) {
+        axis[c] = covariance[maxChannel][c];
+    }
+
+    for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+        VecT  next   = VecT(0.0f);
+        float maxAbs = 0.0f;
+        for (int r = 0; r < kN; ++r) {
+            for (int c = 0; c < kN; ++c) {
+                next[r] += covariance[r][c] * axis[c];
+            }
+            maxAbs = std::max(maxAbs, std::fabs(next[r]));
+        }
+        if (maxAbs == 0.0f) {
+            break;
+        }
+        axis = next / maxAbs;
+    }
+
+    float length = glm::length(axis);
+    if (length == 0.0f) {
+        *pEndpoint0 = mean;
+        *pEndpoint1 = mean;
+        return;
+    }
+    axis /= length;
+
+    float minT = std::numeric_limits<float>::max();
+    float maxT = -std::numeric_limits<float>::max();
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        float t = glm::dot(pColors[i] - mean, axis);
+        minT    = std::min(minT, t);
+        maxT    = std::max(maxT, t);
+    }
+    *pEndpoint0 = Clamp255(mean + axis * maxT);
+    *pEndpoint1 = Clamp255(mean + axis * minT);
+}
+
+// Returns the bounding box of the colors, inset by 1/16 of its size to
+// account for the endpoints being interpolated towards each other.
+template <typename VecT>
+void FitBoundingBox(const VecT* pColors, VecT* pEndpoint0, VecT* pEndpoint1)
+{
+    VecT minColor = pColors[0];
+    VecT maxColor = pColors[0];
+    for (uint32_t i = 1; i < kBlockTexelCount; ++i) {
+        minColor = glm::min(minColor, pColors[i]);
+        maxColor = glm::max(maxColor, pColors[i]);
+    }
+    VecT inset  = (maxColor - minColor) / 16.0f;
+    *pEndpoint0 = maxColor - inset;
+    *pEndpoint1 = minColor + inset;
+}
+
+// Solves for the endpoints that minimize the squared error of the colors,
+// given the weight of endpoint 1 in the interpolated value of each color.
+// Returns false if the system is degenerate, e.g. all colors use one index.
+template <typename VecT>
+bool SolveEndpoints(const VecT* pColors, const float* pWeights, VecT* pEndpoint0, VecT* pEndpoint1)
+{
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    VecT  ax = VecT(0.0f);
+    VecT  bx = VecT(0.0f);
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        float b = pWeights[i];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        ax += a * pColors[i];
+        bx += b * pColors[i];
+    }
+
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    *pEndpoint0 = Clamp255((ax * bb - bx * ab) / det);
+    *pEndpoint1 = Clamp255((bx * aa - ax * ab) / det);
+    return true;
+}
+
+template <uint32_t N>
+uint32_t SquaredDistance(const int* pA, const int* pB)
+{
+    uint32_t distance = 0;
+    for (uint32_t c = 0; c < N; ++c) {
+        int d = pA[c] - pB[c];
+        distance += static_cast<uint32_t>(d * d);
+    }
+    return distance;
+}
+
+// Assigns each texel the closest palette entry and returns the total error.
+template <uint32_t N, uint32_t PaletteSize>
+uint32_t FitIndices(const int (*pTexels)[N], const int (*pPalette)[N], uint8_t* pIndices)
+{
+    uint32_t totalError = 0;
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (uint32_t k = 0; k < PaletteSize; ++k) {
+            uint32_t error = SquaredDistance<N>(pTexels[i], pPalette[k]);
+            if (error < bestError) {
+                bestError   = error;
+                pIndices[i] = static_cast<uint8_t>(k);
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+// -------------------------------------------------------------------------------------------------
+// BC1 color blocks
+// -------------------------------------------------------------------------------------------------
+
+// Weight of color 1 for each index in four color mode.
+constexpr float kColorWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+constexpr uint32_t kRGB565Max[3]   = {31, 63, 31};
+constexpr uint32_t kRGB565Shift[3] = {11, 5, 0};
+
+uint16_t QuantizeRGB565(const float3& color)
+{
+    uint32_t packed = 0;
+    for (uint32_t c = 0; c < 3; ++c) {
+        float    scaled = color[c] * static_cast<float>(kRGB565Max[c]) / 255.0f + 0.5f;
+        uint32_t value  = static_cast<uint32_t>(std::max(scaled, 0.0f));
+        packed |= std::min(value, kRGB565Max[c]) << kRGB565Shift[c];
+    }
+    return static_cast<uint16_t>(packed);
+}
+
+void ExpandRGB565(uint16_t packed, int* pColor)
+{
+    uint32_t r = (packed >> 11) & 0x1F;
+    uint32_t g = (packed >> 5) & 0x3F;
+    uint32_t b = packed & 0x1F;
+    pColor[0]  = static_cast<int>((r << 3) | (r >> 2));
+    pColor[1]  = static_cast<int>((g << 2) | (g >> 4));
+    pColor[2]  = static_cast<int>((b << 3) | (b >> 2));
+}
+
+void GetColorPalette(uint16_t color0, uint16_t color1, bool fourColor, int (*pPalette)[4])
+{
+    ExpandRGB565(color0, pPalette[0]);
+    ExpandRGB565(color1, pPalette[1]);
+    for (uint32_t c = 0; c < 3; ++c) {
+        int a = pPalette[0][c];
+        int b = pPalette[1][c];
+        if (fourColor) {
+            pPalette[2][c] = (2 * a + b) / 3;
+            pPalette[3][c] = (a + 2 * b) / 3;
+        }
+        else {
+            pPalette[2][c] = (a + b) / 2;
+            pPalette[3][c] = 0;
+        }
+    }
+    pPalette[0][3] = 255;
+    pPalette[1][3] = 255;
+    pPalette[2][3] = 255;
+    pPalette[3][3] = fourColor ? 255 : 0;
+}
+
+uint32_t FitColorIndices(const int (*pTexels)[3], uint16_t color0, uint16_t color1, uint8_t* pIndices)
+{
+    int palette4[4][4];
+    GetColorPalette(color0, color1, /* fourColor= */ true, palette4);
+    int palette[4][3];
+    for (uint32_t k = 0; k < 4; ++k) {
+        memcpy(palette[k], palette4[k], sizeof(palette[k]));
+    }
+    return FitIndices<3, 4>(pTexels, palette, pIndices);
+}
+
+// Writes a four color mode block. BC3 always decodes colors in that mode,
+// and BC1 does when color0 > color1.
+void EncodeColorBlock(const BlockTexels& texels, CompressedImage::Quality quality, uint8_t* pBlock)
+{
+    float3 colors[kBlockTexelCount];
+    int    texelColors[kBlockTexelCount][3];
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            colors[i][c]      = static_cast<float>(texels[i][c]);
+            texelColors[i][c] = texels[i][c];
+        }
+    }
+
+    float3 endpoint0;
+    float3 endpoint1;
+    if (quality == CompressedImage::QUALITY_FAST) {
+        FitBoundingBox(colors, &endpoint0, &endpoint1);
+    }
+    else {
+        FitPrincipalAxis(colors, &endpoint0, &endpoint1);
+    }
+
+    uint16_t color0 = QuantizeRGB565(endpoint0);
+    uint16_t color1 = QuantizeRGB565(endpoint1);
+    uint8_t  indices[kBlockTexelCount];
+    uint32_t error = FitColorIndices(texelColors, color0, color1, indices);
+
+    const uint32_t refineCount = (quality == CompressedImage::QUALITY_FAST) ? 0 : ((quality == CompressedImage::QUALITY_NORMAL) ? 1 : 3);
+    for (uint32_t iteration = 0; (iteration < refineCount) && (error > 0); ++iteration) {
+        float weights[kBlockTexelCount];
+        for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+            weights[i] = kColorWeights[indices[i]];
+        }
+        if (!SolveEndpoints(colors, weights, &endpoint0, &endpoint1)) {
+            break;
+        }
+
+        uint16_t refined0 = QuantizeRGB565(endpoint0);
+        uint16_t refined1 = QuantizeRGB565(endpoint1);
+        uint8_t  refinedIndices[kBlockTexelCount];
+        uint32_t refinedError = FitColorIndices(texelColors, refined0, refined1, refinedIndices);
+        if (refinedError >= error) {
+            break;
+        }
+        color0 = refined0;
+        color1 = refined1;
+        error  = refinedError;
+        memcpy(indices, refinedIndices, sizeof(indices));
+    }
+
+    if (quality == CompressedImage::QUALITY_HIGH) {
+        // Greedy search over +/-1 steps of each quantized channel.
+        bool improved = true;
+        for (uint32_t pass = 0; improved && (pass < 4) && (error > 0); ++pass) {
+            improved = false;
+            for (uint32_t endpoint = 0; endpoint < 2; ++endpoint) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    for (int step : {-1, 1}) {
+                        uint16_t candidate[2] = {color0, color1};
+                        int      value        = static_cast<int>((candidate[endpoint] >> kRGB565Shift[c]) & kRGB565Max[c]) + step;
+                        if ((value < 0) || (value > static_cast<int>(kRGB565Max[c]))) {
+                            continue;
+                        }
+                        candidate[endpoint] &= static_cast<uint16_t>(~(kRGB565Max[c] << kRGB565Shift[c]));
+                        candidate[endpoint] |= static_cast<uint16_t>(value << kRGB565Shift[c]);
+
+                        uint8_t  candidateIndices[kBlockTexelCount];
+                        uint32_t candidateError = FitColorIndices(texelColors, candidate[0], candidate[1], candidateIndices);
+                        if (candidateError < error) {
+                            color0   = candidate[0];
+                            color1   = candidate[1];
+                            error    = candidateError;
+                            improved = true;
+                            memcpy(indices, candidateIndices, sizeof(indices));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Four color mode requires color0 > color1: swapping the colors swaps
+    // indices 0 with 1 and 2 with 3. Equal colors decode the same in both
+    // modes as long as every index is 0.
+    if (color0 < color1) {
+        std::swap(color0, color1);
+        for (uint8_t& index : indices) {
+            index ^= 1;
+        }
+    }
+    else if (color0 == color1) {
+        memset(indices, 0, sizeof(indices));
+    }
+
+    uint32_t packedIndices = 0;
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        packedIndices |= static_cast<uint32_t>(indices[i]) << (2 * i);
+    }
+    memcpy(pBlock, &color0, 2);
+    memcpy(pBlock + 2, &color1, 2);
+    memcpy(pBlock + 4, &packedIndices, 4);
+}
+
+void DecodeColorBlock(const uint8_t* pBlock, bool allowThreeColor, BlockTexels& texels)
+{
+    uint16_t color0        = 0;
+    uint16_t color1        = 0;
+    uint32_t packedIndices = 0;
+    memcpy(&color0, pBlock, 2);
+    memcpy(&color1, pBlock + 2, 2);
+    memcpy(&packedIndices, pBlock + 4, 4);
+
+    int palette[4][4];
+    GetColorPalette(color0, color1, !allowThreeColor || (color0 > color1), palette);
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        uint32_t index = (packedIndices >> (2 * i)) & 0x3;
+        for (uint32_t c = 0; c < 4; ++c) {
+            texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// BC4 single channel blocks
+// -------------------------------------------------------------------------------------------------
+
+// Values of the eight indices. endpoint0 > endpoint1 interpolates six values
+// between them, otherwise four values are interpolated and 0 and 255 added.
+void GetChannelPalette(uint8_t endpoint0, uint8_t endpoint1, int (*pPalette)[1])
+{
+    const int a    = endpoint0;
+    const int b    = endpoint1;
+    pPalette[0][0] = a;
+    pPalette[1][0] = b;
+    if (a > b) {
+        for (int i = 2; i < 8; ++i) {
+            pPalette[i][0] = ((8 - i) * a + (i - 1) * b + 3) / 7;
+        }
+    }
+    else {
+        for (int i = 2; i < 6; ++i) {
+            pPalette[i][0] = ((6 - i) * a + (i - 1) * b + 2) / 5;
+        }
+        pPalette[6][0] = 0;
+        pPalette[7][0] = 255;
+    }
+}
+
+uint32_t FitChannelIndices(const int (*pValues)[1], uint8_t endpoint0, uint8_t endpoint1, uint8_t* pIndices)
+{
+    int palette[8][1];
+    GetChannelPalette(endpoint0, endpoint1, palette);
+    return FitIndices<1, 8>(pValues, palette, pIndices);
+}
+
+void EncodeChannelBlock(const BlockTexels& texels, uint32_t channel, CompressedImage::Quality quality, uint8_t* pBlock)
+{
+    int values[kBlockTexelCount][1];
+    int minValue      = 255;
+    int maxValue      = 0;
+    int minInnerValue = 255;
+    int maxInnerValue = 0;
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        int value    = texels[i][channel];
+        values[i][0] = value;
+        minValue     = std::min(minValue, value);
+        maxValue     = std::max(maxValue, value);
+        if ((value != 0) && (value != 255)) {
+            minInnerValue = std::min(minInnerValue, value);
+            maxInnerValue = std::max(maxInnerValue, value);
+        }
+    }
+
+    // Eight value mode over the full range. A constant block has equal
+    // endpoints, which decode in six value mode with every index 0.
+    uint8_t  endpoint0 = static_cast<uint8_t>(maxValue);
+    uint8_t  endpoint1 = static_cast<uint8_t>(minValue);
+    uint8_t  indices[kBlockTexelCount];
+    uint32_t error = FitChannelIndices(values, endpoint0, endpoint1, indices);
+
+    auto tryEndpoints = [&](int candidate0, int candidate1) {
+        if ((candidate0 < 0) || (candidate0 > 255) || (candidate1 < 0) || (candidate1 > 255)) {
+            return;
+        }
+        uint8_t  candidateIndices[kBlockTexelCount];
+        uint32_t candidateError = FitChannelIndices(values, static_cast<uint8_t>(candidate0), static_cast<uint8_t>(candidate1), candidateIndices);
+        if (candidateError < error) {
+            endpoint0 = static_cast<uint8_t>(candidate0);
+            endpoint1 = static_cast<uint8_t>(candidate1);
+            error     = candidateError;
+            memcpy(indices, candidateIndices, sizeof(indices));
+        }
+    };
+
+    if ((quality != CompressedImage::QUALITY_FAST) && (minInnerValue <= maxInnerValue)) {
+        // Six value mode, with 0 and 255 covered by the extra indices.
+        tryEndpoints(minInnerValue, maxInnerValue);
+    }
+    if (quality == CompressedImage::QUALITY_HIGH) {
+        const int radius = 3;
+        for (int d0 = -radius; d0 <= radius; ++d0) {
+            for (int d1 = -radius; d1 <= radius; ++d1) {
+                if ((maxValue + d0) > (minValue + d1)) {
+                    tryEndpoints(maxValue + d0, minValue + d1);
+                }
+                if (minInnerValue <= maxInnerValue) {
+                    tryEndpoints(std::min(minInnerValue + d0, maxInnerValue + d1), maxInnerValue + d1);
+                }
+            }
+        }
+    }
+
+    uint64_t packedIndices = 0;
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        packedIndices |= static_cast<uint64_t>(indices[i]) << (3 * i);
+    }
+    pBlock[0] = endpoint0;
+    pBlock[1] = endpoint1;
+    memcpy(pBlock + 2, &packedIndices, 6);
+}
+
+void DecodeChannelBlock(const uint8_t* pBlock, uint32_t channel, BlockTexels& texels)
+{
+    uint64_t packedIndices = 0;
+    memcpy(&packedIndices, pBlock + 2, 6);
+
+    int palette[8][1];
+    GetChannelPalette(pBlock[0], pBlock[1], palette);
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        texels[i][channel] = static_cast<uint8_t>(palette[(packedIndices >> (3 * i)) & 0x7][0]);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// BC7 mode 6 blocks
+// -------------------------------------------------------------------------------------------------
+
+constexpr uint32_t kMode6Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// Endpoints are 7 bits per channel plus a p-bit shared by the channels of
+// each endpoint, which becomes the low bit of the 8-bit values.
+struct Mode6Endpoints
+{
+    int color[2][4] = {};
+    int pbit[2]     = {};
+};
+
+int GetMode6Value(const Mode6Endpoints& endpoints, uint32_t endpoint, uint32_t channel)
+{
+    return (endpoints.color[endpoint][channel] << 1) | endpoints.pbit[endpoint];
+}
+
+// Quantizes an endpoint with the given p-bit, and returns the squared error.
+float QuantizeMode6Endpoint(const float4& value, int pbit, int* pColor)
+{
+    float error = 0.0f;
+    for (uint32_t c = 0; c < 4; ++c) {
+        int quantized = static_cast<int>(std::floor((value[c] - static_cast<float>(pbit)) / 2.0f + 0.5f));
+        pColor[c]     = std::min(std::max(quantized, 0), 127);
+        float d       = static_cast<float>((pColor[c] << 1) | pbit) - value[c];
+        error += d * d;
+    }
+    return error;
+}
+
+void GetMode6Palette(const Mode6Endpoints& endpoints, int (*pPalette)[4])
+{
+    for (uint32_t k = 0; k < 16; ++k) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            int a          = GetMode6Value(endpoints, 0, c);
+            int b          = GetMode6Value(endpoints, 1, c);
+            pPalette[k][c] = static_cast<int>(((64 - kMode6Weights[k]) * a + kMode6Weights[k] * b + 32) >> 6);
+        }
+    }
+}
+
+uint32_t FitMode6Indices(const int (*pTexels)[4], const Mode6Endpoints& endpoints, uint8_t* pIndices)
+{
+    int palette[16][4];
+    GetMode6Palette(endpoints, palette);
+    return FitIndices<4, 16>(pTexels, palette, pIndices);
+}
+
+// Picks indices by projecting texels on the segment between the endpoints,
+// which is cheaper than a search when the palette lies on a line.
+uint32_t ProjectMode6Indices(const int (*pTexels)[4], const Mode6Endpoints& endpoints, uint8_t* pIndices)
+{
+    int palette[16][4];
+    GetMode6Palette(endpoints, palette);
+
+    float4 a;
+    float4 b;
+    for (uint32_t c = 0; c < 4; ++c) {
+        a[c] = static_cast<float>(GetMode6Value(endpoints, 0, c));
+        b[c] = static_cast<float>(GetMode6Value(endpoints, 1, c));
+    }
+    const float4 axis         = b - a;
+    const float  lengthSquare = glm::dot(axis, axis);
+
+    uint32_t totalError = 0;
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        float t = 0.0f;
+        if (lengthSquare > 0.0f) {
+            float4 texel = float4(pTexels[i][0], pTexels[i][1], pTexels[i][2], pTexels[i][3]);
+            t            = glm::clamp(glm::dot(texel - a, axis) / lengthSquare, 0.0f, 1.0f);
+        }
+
+        // The weights are nearly uniform: check the neighbours of the
+        // closest uniform step.
+        int      center    = static_cast<int>(t * 15.0f + 0.5f);
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (int k = std::max(center - 1, 0); k <= std::min(center + 1, 15); ++k) {
+            uint32_t error = SquaredDistance<4>(pTexels[i], palette[k]);
+            if (error < bestError) {
+                bestError   = error;
+                pIndices[i] = static_cast<uint8_t>(k);
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+// Quantizes the endpoints and fits indices. With searchPBits the four p-bit
+// combinations are tried, otherwise each endpoint takes its closest p-bit.
+uint32_t QuantizeMode6(
+    const int (*pTexels)[4],
+    const float4& endpoint0,
+    const float4& endpoint1,
+    bool          searchPBits,
+    bool          exactIndices,
+    Mode6Endpoints* pEndpoints,
+    uint8_t*        pIndices)
+{
+    auto fit = [&](const Mode6Endpoints& endpoints, uint8_t* pFitIndices) {
+        return exactIndices ? FitMode6Indices(pTexels, endpoints, pFitIndices) : ProjectMode6Indices(pTexels, endpoints, pFitIndices);
+    };
+
+    if (!searchPBits) {
+        for (uint32_t e = 0; e < 2; ++e) {
+            const float4& value = (e == 0) ? endpoint0 : endpoint1;
+            int           color0[4];
+            int           color1[4];
+            float         error0 = QuantizeMode6Endpoint(value, 0, color0);
+            float         error1 = QuantizeMode6Endpoint(value, 1, color1);
+            pEndpoints->pbit[e]  = (error1 < error0) ? 1 : 0;
+            memcpy(pEndpoints->color[e], (error1 < error0) ? color1 : color0, sizeof(color0));
+        }
+        return fit(*pEndpoints, pIndices);
+    }
+
+    uint32_t bestError = std::numeric_limits<uint32_t>::max();
+    for (int pbits = 0; pbits < 4; ++pbits) {
+        Mode6Endpoints candidate;
+        candidate.pbit[0] = pbits & 1;
+        candidate.pbit[1] = pbits >> 1;
+        QuantizeMode6Endpoint(endpoint0, candidate.pbit[0], candidate.color[0]);
+        QuantizeMode6Endpoint(endpoint1, candidate.pbit[1], candidate.color[1]);
+
+        uint8_t  candidateIndices[kBlockTexelCount];
+        uint32_t error = fit(candidate, candidateIndices);
+        if (error < bestError) {
+            bestError   = error;
+            *pEndpoints = candidate;
+            memcpy(pIndices, candidateIndices, kBlockTexelCount);
+        }
+    }
+    return bestError;
+}
+
+class BlockBitWriter
+{
+public:
+    BlockBitWriter(uint8_t* pBlock)
+        : mBlock(pBlock)
+    {
+        memset(mBlock, 0, 16);
+    }
+
+    void Write(uint32_t value, uint32_t bitCount)
+    {
+        for (uint32_t i = 0; i < bitCount; ++i, ++mOffset) {
+            mBlock[mOffset / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (mOffset % 8));
+        }
+    }
+
+private:
+    uint8_t* mBlock  = nullptr;
+    uint32_t mOffset = 0;
+};
+
+class BlockBitReader
+{
+public:
+    BlockBitReader(const uint8_t* pBlock)
+        : mBlock(pBlock) {}
+
+    uint32_t Read(uint32_t bitCount)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bitCount; ++i, ++mOffset) {
+            value |= static_cast<uint32_t>((mBlock[mOffset / 8] >> (mOffset % 8)) & 1) << i;
+        }
+        return value;
+    }
+
+private:
+    const uint8_t* mBlock  = nullptr;
+    uint32_t       mOffset = 0;
+};
+
+void EncodeMode6Block(const BlockTexels& texels, CompressedImage::Quality quality, uint8_t* pBlock)
+{
+    float4 colors[kBlockTexelCount];
+    int    texelColors[kBlockTexelCount][4];
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            colors[i][c]      = static_cast<float>(texels[i][c]);
+            texelColors[i][c] = texels[i][c];
+        }
+    }
+
+    const bool fast = (quality == CompressedImage::QUALITY_FAST);
+
+    float4 endpoint0;
+    float4 endpoint1;
+    if (fast) {
+        FitBoundingBox(colors, &endpoint0, &endpoint1);
+    }
+    else {
+        FitPrincipalAxis(colors, &endpoint0, &endpoint1);
+    }
+
+    Mode6Endpoints endpoints;
+    uint8_t        indices[kBlockTexelCount];
+    uint32_t       error = QuantizeMode6(texelColors, endpoint0, endpoint1, !fast, !fast, &endpoints, indices);
+
+    const uint32_t refineCount = fast ? 0 : ((quality == CompressedImage::QUALITY_NORMAL) ? 1 : 3);
+    for (uint32_t iteration = 0; (iteration < refineCount) && (error > 0); ++iteration) {
+        float weights[kBlockTexelCount];
+        for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+            weights[i] = static_cast<float>(kMode6Weights[indices[i]]) / 64.0f;
+        }
+        if (!SolveEndpoints(colors, weights, &endpoint0, &endpoint1)) {
+            break;
+        }
+
+        Mode6Endpoints refined;
+        uint8_t        refinedIndices[kBlockTexelCount];
+        uint32_t       refinedError = QuantizeMode6(texelColors, endpoint0, endpoint1, true, true, &refined, refinedIndices);
+        if (refinedError >= error) {
+            break;
+        }
+        endpoints = refined;
+        error     = refinedError;
+        memcpy(indices, refinedIndices, sizeof(indices));
+    }
+
+    if (quality == CompressedImage::QUALITY_HIGH) {
+        // Greedy search over +/-1 steps of each quantized channel.
+        bool improved = true;
+        for (uint32_t pass = 0; improved && (pass < 4) && (error > 0); ++pass) {
+            improved = false;
+            for (uint32_t e = 0; e < 2; ++e) {
+                for (uint32_t c = 0; c < 4; ++c) {
+                    for (int step : {-1, 1}) {
+                        Mode6Endpoints candidate = endpoints;
+                        candidate.color[e][c] += step;
+                        if ((candidate.color[e][c] < 0) || (candidate.color[e][c] > 127)) {
+                            continue;
+                        }
+
+                        uint8_t  candidateIndices[kBlockTexelCount];
+                        uint32_t candidateError = FitMode6Indices(texelColors, candidate, candidateIndices);
+                        if (candidateError < error) {
+                            endpoints = candidate;
+                            error     = candidateError;
+                            improved  = true;
+                            memcpy(indices, candidateIndices, sizeof(indices));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // The most significant bit of the first index is implied to be 0.
+    if (indices[0] >= 8) {
+        std::swap(endpoints.color[0], endpoints.color[1]);
+        std::swap(endpoints.pbit[0], endpoints.pbit[1]);
+        for (uint8_t& index : indices) {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    BlockBitWriter writer(pBlock);
+    writer.Write(1 << 6, 7);
+    for (uint32_t c = 0; c < 4; ++c) {
+        writer.Write(static_cast<uint32_t>(endpoints.color[0][c]), 7);
+        writer.Write(static_cast<uint32_t>(endpoints.color[1][c]), 7);
+    }
+    writer.Write(static_cast<uint32_t>(endpoints.pbit[0]), 1);
+    writer.Write(static_cast<uint32_t>(endpoints.pbit[1]), 1);
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        writer.Write(indices[i], (i == 0) ? 3 : 4);
+    }
+}
+
+bool DecodeMode6Block(const uint8_t* pBlock, BlockTexels& texels)
+{
+    BlockBitReader reader(pBlock);
+    if (reader.Read(7) != (1 << 6)) {
+        return false;
+    }
+
+    Mode6Endpoints endpoints;
+    for (uint32_t c = 0; c < 4; ++c) {
+        endpoints.color[0][c] = static_cast<int>(reader.Read(7));
+        endpoints.color[1][c] = static_cast<int>(reader.Read(7));
+    }
+    endpoints.pbit[0] = static_cast<int>(reader.Read(1));
+    endpoints.pbit[1] = static_cast<int>(reader.Read(1));
+
+    int palette[16][4];
+    GetMode6Palette(endpoints, palette);
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        uint32_t index = reader.Read((i == 0) ? 3 : 4);
+        for (uint32_t c = 0; c < 4; ++c) {
+            texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+        }
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Blocks by format
+// -------------------------------------------------------------------------------------------------
+
+void EncodeBlock(CompressedImage::Format format, CompressedImage::Quality quality, const BlockTexels& texels, uint8_t* pBlock)
+{
+    // clang-format off
+    switch (format) {
+        default: break;
+        case CompressedImage::FORMAT_BC1 : EncodeColorBlock(texels, quality, pBlock); break;
+        case CompressedImage::FORMAT_BC3 : {
+            EncodeChannelBlock(texels, 3, quality, pBlock);
+            EncodeColorBlock(texels, quality, pBlock + 8);
+        } break;
+        case CompressedImage::FORMAT_BC4 : EncodeChannelBlock(texels, 0, quality, pBlock); break;
+        case CompressedImage::FORMAT_BC5 : {
+            EncodeChannelBlock(texels, 0, quality, pBlock);
+            EncodeChannelBlock(texels, 1, quality, pBlock + 8);
+        } break;
+        case CompressedImage::FORMAT_BC7 : EncodeMode6Block(texels, quality, pBlock); break;
+    }
+    // clang-format on
+}
+
+bool DecodeBlock(CompressedImage::Format format, const uint8_t* pBlock, BlockTexels& texels)
+{
+    memset(texels, 0, sizeof(texels));
+    for (uint32_t i = 0; i < kBlockTexelCount; ++i) {
+        texels[i][3] = 255;
+    }
+
+    // clang-format off
+    switch (format) {
+        default: return false;
+        case CompressedImage::FORMAT_BC1 : DecodeColorBlock(pBlock, /* allowThreeColor= */ true, texels); break;
+        case CompressedImage::FORMAT_BC3 : {
+            DecodeColorBlock(pBlock + 8, /* allowThreeColor= */ false, texels);
+            DecodeChannelBlock(pBlock, 3, texels);
+        } break;
+        case CompressedImage::FORMAT_BC4 : DecodeChannelBlock(pBlock, 0, texels); break;
+        case CompressedImage::FORMAT_BC5 : {
+            DecodeChannelBlock(pBlock, 0, texels);
+            DecodeChannelBlock(pBlock + 8, 1, texels);
+        } break;
+        case CompressedImage::FORMAT_BC7 : return DecodeMode6Block(pBlock, texels);
+    }
+    // clang-format on
+    return true;
+}
+
+uint32_t GetEncodedChannelCount(CompressedImage::Format format)
+{
+    // clang-format off
+    switch (format) {
+        default: break;
+        case CompressedImage::FORMAT_BC1 : return 3;
+        case CompressedImage::FORMAT_BC3 : return 4;
+        case CompressedImage::FORMAT_BC4 : return 1;
+        case CompressedImage::FORMAT_BC5 : return 2;
+        case CompressedImage::FORMAT_BC7 : return 4;
+    }
+    // clang-format on
+    return 0;
+}
+
+Result EncodeLevel(const Bitmap& source, CompressedImage::Format format, CompressedImage::Quality quality, uint32_t threadCount, char* pLevelData)
+{
+    const Bitmap* pRGBA8 = &source;
+    Bitmap        converted;
+    if (source.GetFormat() != Bitmap::FORMAT_RGBA_UINT8) {
+        Result ppxres = source.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &converted);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        pRGBA8 = &converted;
+    }
+
+    const uint32_t blockSize   = CompressedImage::GetBlockSize(format);
+    const uint32_t blockCountX = (source.GetWidth() + 3) / 4;
+    const uint32_t blockCountY = (source.GetHeight() + 3) / 4;
+    if (threadCount == 0) {
+        threadCount = GetParallelThreadCount(static_cast<size_t>(blockCountX) * blockCountY, kMinEncodeBlocksPerThread);
+    }
+    threadCount = std::min(threadCount, blockCountY);
+
+    ParallelForRanges(blockCountY, threadCount, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t blockY = begin; blockY < end; ++blockY) {
+            uint8_t* pBlock = reinterpret_cast<uint8_t*>(pLevelData) + blockY * blockCountX * blockSize;
+            for (uint32_t blockX = 0; blockX < blockCountX; ++blockX, pBlock += blockSize) {
+                BlockTexels texels;
+                LoadBlock(*pRGBA8, blockX, static_cast<uint32_t>(blockY), texels);
+                EncodeBlock(format, quality, texels, pBlock);
+            }
+        }
+    });
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+// DDS
+// -------------------------------------------------------------------------------------------------
+
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+{
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+constexpr uint32_t kDDSMagic           = MakeFourCC('D', 'D', 'S', ' ');
+constexpr uint32_t kDDSHeaderSize      = 124;
+constexpr uint32_t kDDSPixelFormatSize = 32;
+constexpr uint32_t kDDSFlagsCaps       = 0x1;
+constexpr uint32_t kDDSFlagsHeight     = 0x2;
+constexpr uint32_t kDDSFlagsWidth      = 0x4;
+constexpr uint32_t kDDSFlagsPixelFmt   = 0x1000;
+constexpr uint32_t kDDSFlagsMipCount   = 0x20000;
+constexpr uint32_t kDDSFlagsLinearSize = 0x80000;
+constexpr uint32_t kDDSPixelFourCC     = 0x4;
+constexpr uint32_t kDDSCapsComplex     = 0x8;
+constexpr uint32_t kDDSCapsTexture     = 0x1000;
+constexpr uint32_t kDDSCapsMipmap      = 0x400000;
+constexpr uint32_t kDX10Texture2D      = 3;
+
+// Offsets in uint32 of the DDS_HEADER fields that are used.
+enum DDSHeaderField
+{
+    DDS_FIELD_SIZE         = 0,
+    DDS_FIELD_FLAGS        = 1,
+    DDS_FIELD_HEIGHT       = 2,
+    DDS_FIELD_WIDTH        = 3,
+    DDS_FIELD_LINEAR_SIZE  = 4,
+    DDS_FIELD_DEPTH        = 5,
+    DDS_FIELD_MIP_COUNT    = 6,
+    DDS_FIELD_PF_SIZE      = 18,
+    DDS_FIELD_PF_FLAGS     = 19,
+    DDS_FIELD_PF_FOURCC    = 20,
+    DDS_FIELD_CAPS         = 26,
+    DDS_FIELD_COUNT        = 31,
+    DX10_FIELD_FORMAT      = 0,
+    DX10_FIELD_DIMENSION   = 1,
+    DX10_FIELD_ARRAY_SIZE  = 3,
+    DX10_FIELD_COUNT       = 5,
+};
+
+// DXGI_FORMAT values, the sRGB ones are only read.
+struct DXGIFormat
+{
+    uint32_t                dxgiFormat;
+    CompressedImage::Format format;
+};
+
+constexpr DXGIFormat kDXGIFormats[] = {
+    {71, CompressedImage::FORMAT_BC1},
+    {72, CompressedImage::FORMAT_BC1},
+    {77, CompressedImage::FORMAT_BC3},
+    {78, CompressedImage::FORMAT_BC3},
+    {80, CompressedImage::FORMAT_BC4},
+    {83, CompressedImage::FORMAT_BC5},
+    {98, CompressedImage::FORMAT_BC7},
+    {99, CompressedImage::FORMAT_BC7},
+};
+
+struct FourCCFormat
+{
+    uint32_t                fourCC;
+    CompressedImage::Format format;
+};
+
+constexpr FourCCFormat kFourCCFormats[] = {
+    {MakeFourCC('D', 'X', 'T', '1'), CompressedImage::FORMAT_BC1},
+    {MakeFourCC('D', 'X', 'T', '5'), CompressedImage::FORMAT_BC3},
+    {MakeFourCC('A', 'T', 'I', '1'), CompressedImage::FORMAT_BC4},
+    {MakeFourCC('B', 'C', '4', 'U'), CompressedImage::FORMAT_BC4},
+    {MakeFourCC('A', 'T', 'I', '2'), CompressedImage::FORMAT_BC5},
+    {MakeFourCC('B', 'C', '5', 'U'), CompressedImage::FORMAT_BC5},
+};
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// CompressedImage
+// -------------------------------------------------------------------------------------------------
+uint32_t CompressedImage::GetBlockSize(CompressedImage::Format format)
+{
+    // clang-format off
+    switch (format) {
+        default: break;
+        case CompressedImage::FORMAT_BC1 : return 8;
+        case CompressedImage::FORMAT_BC3 : return 16;
+        case CompressedImage::FORMAT_BC4 : return 8;
+        case CompressedImage::FORMAT_BC5 : return 16;
+        case CompressedImage::FORMAT_BC7 : return 16;
+    }
+    // clang-format on
+    return 0;
+}
+
+const char* CompressedImage::ToString(CompressedImage::Format format)
+{
+    // clang-format off
+    switch (format) {
+        default: break;
+        case CompressedImage::FORMAT_BC1 : return "bc1";
+        case CompressedImage::FORMAT_BC3 : return "bc3";
+        case CompressedImage::FORMAT_BC4 : return "bc4";
+        case CompressedImage::FORMAT_BC5 : return "bc5";
+        case CompressedImage::FORMAT_BC7 : return "bc7";
+    }
+    // clang-format on
+    return "undefined";
+}
+
+uint32_t CompressedImage::GetRowStride(uint32_t level) const
+{
+    return ((mLevels[level].width + 3) / 4) * GetBlockSize(mFormat);
+}
+
+void CompressedImage::AllocateLevels()
+{
+    uint64_t offset = 0;
+    for (Level& level : mLevels) {
+        const uint64_t blockCountX = (static_cast<uint64_t>(level.width) + 3) / 4;
+        const uint64_t blockCountY = (static_cast<uint64_t>(level.height) + 3) / 4;
+        level.offset               = offset;
+        level.size                 = blockCountX * blockCountY * GetBlockSize(mFormat);
+        offset += level.size;
+    }
+    mData.assign(offset, 0);
+}
+
+Result CompressedImage::Encode(
+    const Mipmap&            mipmap,
+    CompressedImage::Format  format,
+    CompressedImage::Quality quality,
+    CompressedImage*         pImage,
+    uint32_t                 levelCount,
+    uint32_t                 threadCount)
+{
+    if (IsNull(pImage)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (GetBlockSize(format) == 0) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    if (!mipmap.IsOk()) {
+        return ppx::ERROR_BITMAP_BAD_COPY_SOURCE;
+    }
+
+    levelCount = std::min(levelCount, mipmap.GetLevelCount());
+
+    CompressedImage image;
+    image.mFormat = format;
+    image.mLevels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        image.mLevels[level].width  = mipmap.GetWidth(level);
+        image.mLevels[level].height = mipmap.GetHeight(level);
+    }
+    image.AllocateLevels();
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        Result ppxres = EncodeLevel(*mipmap.GetMip(level), format, quality, threadCount, image.mData.data() + image.mLevels[level].offset);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    *pImage = std::move(image);
+    return ppx::SUCCESS;
+}
+
+Result CompressedImage::Encode(
+    const Bitmap&            bitmap,
+    CompressedImage::Format  format,
+    CompressedImage::Quality quality,
+    CompressedImage*         pImage,
+    uint32_t                 threadCount)
+{
+    if (IsNull(pImage)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (GetBlockSize(format) == 0) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    if (!bitmap.IsOk()) {
+        return ppx::ERROR_BITMAP_BAD_COPY_SOURCE;
+    }
+
+    CompressedImage image;
+    image.mFormat = format;
+    image.mLevels.resize(1);
+    image.mLevels[0].width  = bitmap.GetWidth();
+    image.mLevels[0].height = bitmap.GetHeight();
+    image.AllocateLevels();
+
+    Result ppxres = EncodeLevel(bitmap, format, quality, threadCount, image.mData.data());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    *pImage = std::move(image);
+    return ppx::SUCCESS;
+}
+
+Result CompressedImage::Decode(uint32_t level, Bitmap* pBitmap) const
+{
+    if (IsNull(pBitmap)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (level >= GetLevelCount()) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    Result ppxres = Bitmap::Create(GetWidth(level), GetHeight(level), Bitmap::FORMAT_RGBA_UINT8, pBitmap);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t blockSize   = GetBlockSize(mFormat);
+    const uint32_t blockCountX = (GetWidth(level) + 3) / 4;
+    const uint32_t blockCountY = (GetHeight(level) + 3) / 4;
+    const uint8_t* pBlock      = reinterpret_cast<const uint8_t*>(GetLevelData(level));
+    for (uint32_t blockY = 0; blockY < blockCountY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blockCountX; ++blockX, pBlock += blockSize) {
+            BlockTexels texels;
+            if (!DecodeBlock(mFormat, pBlock, texels)) {
+                return ppx::ERROR_IMAGE_INVALID_FORMAT;
+            }
+            StoreBlock(texels, blockX, blockY, pBitmap);
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result CompressedImage::ComputePSNR(uint32_t level, const Bitmap& source, double* pPSNR) const
+{
+    if (IsNull(pPSNR)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (level >= GetLevelCount()) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    if (!source.IsOk()) {
+        return ppx::ERROR_BITMAP_BAD_COPY_SOURCE;
+    }
+
+    if ((source.GetWidth() != GetWidth(level)) || (source.GetHeight() != GetHeight(level))) {
+        return ppx::ERROR_BITMAP_FOOTPRINT_MISMATCH;
+    }
+
+    const Bitmap* pRGBA8 = &source;
+    Bitmap        converted;
+    if (source.GetFormat() != Bitmap::FORMAT_RGBA_UINT8) {
+        Result ppxres = source.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &converted);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        pRGBA8 = &converted;
+    }
+
+    Bitmap decoded;
+    Result ppxres = Decode(level, &decoded);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t channelCount = GetEncodedChannelCount(mFormat);
+    uint64_t       sumSquares   = 0;
+    for (uint32_t y = 0; y < decoded.GetHeight(); ++y) {
+        const uint8_t* pExpected = reinterpret_cast<const uint8_t*>(pRGBA8->GetData() + y * pRGBA8->GetRowStride());
+        const uint8_t* pActual   = reinterpret_cast<const uint8_t*>(decoded.GetData() + y * decoded.GetRowStride());
+        for (uint32_t x = 0; x < decoded.GetWidth(); ++x) {
+            for (uint32_t c = 0; c < channelCount; ++c) {
+                int d = static_cast<int>(pExpected[4 * x + c]) - static_cast<int>(pActual[4 * x + c]);
+                sumSquares += static_cast<uint64_t>(d * d);
+            }
+        }
+    }
+
+    if (sumSquares == 0) {
+        *pPSNR = std::numeric_limits<double>::infinity();
+        return ppx::SUCCESS;
+    }
+
+    const double valueCount = static_cast<double>(decoded.GetWidth()) * decoded.GetHeight() * channelCount;
+    const double mse        = static_cast<double>(sumSquares) / valueCount;
+    *pPSNR                  = 10.0 * std::log10((255.0 * 255.0) / mse);
+    return ppx::SUCCESS;
+}
+
+Result CompressedImage::SaveDDS(const std::filesystem::path& path) const
+{
+    if (!IsOk()) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    uint32_t dxgiFormat = 0;
+    for (const DXGIFormat& entry : kDXGIFormats) {
+        if (entry.format == mFormat) {
+            dxgiFormat = entry.dxgiFormat;
+            break;
+        }
+    }
+
+    uint32_t header[DDS_FIELD_COUNT] = {};
+    header[DDS_FIELD_SIZE]           = kDDSHeaderSize;
+    header[DDS_FIELD_FLAGS]          = kDDSFlagsCaps | kDDSFlagsHeight | kDDSFlagsWidth | kDDSFlagsPixelFmt | kDDSFlagsMipCount | kDDSFlagsLinearSize;
+    header[DDS_FIELD_HEIGHT]         = GetHeight(0);
+    header[DDS_FIELD_WIDTH]          = GetWidth(0);
+    header[DDS_FIELD_LINEAR_SIZE]    = static_cast<uint32_t>(GetLevelSize(0));
+    header[DDS_FIELD_MIP_COUNT]      = GetLevelCount();
+    header[DDS_FIELD_PF_SIZE]        = kDDSPixelFormatSize;
+    header[DDS_FIELD_PF_FLAGS]       = kDDSPixelFourCC;
+    header[DDS_FIELD_PF_FOURCC]      = MakeFourCC('D', 'X', '1', '0');
+    header[DDS_FIELD_CAPS]           = kDDSCapsTexture | ((GetLevelCount() > 1) ? (kDDSCapsComplex | kDDSCapsMipmap) : 0);
+
+    uint32_t dx10Header[DX10_FIELD_COUNT] = {};
+    dx10Header[DX10_FIELD_FORMAT]         = dxgiFormat;
+    dx10Header[DX10_FIELD_DIMENSION]      = kDX10Texture2D;
+    dx10Header[DX10_FIELD_ARRAY_SIZE]     = 1;
+
+    bool written = internal::WriteFileAtomic(path, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&kDDSMagic), sizeof(kDDSMagic));
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(dx10Header), sizeof(dx10Header));
+        file.write(mData.data(), mData.size());
+    });
+    if (!written) {
+        PPX_LOG_WARN("Failed to write DDS file: " << path);
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result CompressedImage::LoadDDS(const std::filesystem::path& path, CompressedImage* pImage)
+{
+    if (IsNull(pImage)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    auto view = fs::load_file_view(path);
+    if (!view.has_value()) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    const char* pData    = view->GetData();
+    size_t      dataSize = view->GetSize();
+    size_t      offset   = sizeof(kDDSMagic) + sizeof(uint32_t) * DDS_FIELD_COUNT;
+
+    uint32_t magic                   = 0;
+    uint32_t header[DDS_FIELD_COUNT] = {};
+    if (dataSize < offset) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    memcpy(&magic, pData, sizeof(magic));
+    memcpy(header, pData + sizeof(magic), sizeof(header));
+    if ((magic != kDDSMagic) || (header[DDS_FIELD_SIZE] != kDDSHeaderSize) || ((header[DDS_FIELD_PF_FLAGS] & kDDSPixelFourCC) == 0)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    CompressedImage image;
+    const uint32_t  fourCC = header[DDS_FIELD_PF_FOURCC];
+    if (fourCC == MakeFourCC('D', 'X', '1', '0')) {
+        uint32_t dx10Header[DX10_FIELD_COUNT] = {};
+        if (dataSize < (offset + sizeof(dx10Header))) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+        memcpy(dx10Header, pData + offset, sizeof(dx10Header));
+        offset += sizeof(dx10Header);
+        if ((dx10Header[DX10_FIELD_DIMENSION] != kDX10Texture2D) || (dx10Header[DX10_FIELD_ARRAY_SIZE] > 1)) {
+            return ppx::ERROR_IMAGE_INVALID_FORMAT;
+        }
+        for (const DXGIFormat& entry : kDXGIFormats) {
+            if (entry.dxgiFormat == dx10Header[DX10_FIELD_FORMAT]) {
+                image.mFormat = entry.format;
+            }
+        }
+    }
+    else {
+        for (const FourCCFormat& entry : kFourCCFormats) {
+            if (entry.fourCC == fourCC) {
+                image.mFormat = entry.format;
+            }
+        }
+    }
+    if (image.mFormat == FORMAT_UNDEFINED) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const uint32_t width  = header[DDS_FIELD_WIDTH];
+    const uint32_t height = header[DDS_FIELD_HEIGHT];
+    if ((width == 0) || (height == 0) || (header[DDS_FIELD_DEPTH] > 1)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    uint32_t levelCount = 1;
+    if ((header[DDS_FIELD_FLAGS] & kDDSFlagsMipCount) != 0) {
+        levelCount = std::max<uint32_t>(header[DDS_FIELD_MIP_COUNT], 1);
+    }
+    // Levels past the ones a Mipmap of this size would have are ignored, like
+    // levels smaller than a block would be by the GPU upload.
+    levelCount = std::min(levelCount, Mipmap::CalculateLevelCount(width, height));
+
+    image.mLevels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        image.mLevels[level].width  = std::max<uint32_t>(width >> level, 1);
+        image.mLevels[level].height = std::max<uint32_t>(height >> level, 1);
+    }
+
+    // Checked before allocating, so that a corrupt header cannot request
+    // more memory than the file holds. Block counts are computed in 64 bits
+    // so that sizes near 2^32 do not wrap to empty levels.
+    uint64_t levelDataSize = 0;
+    for (const Level& level : image.mLevels) {
+        const uint64_t blockCountX = (static_cast<uint64_t>(level.width) + 3) / 4;
+        const uint64_t blockCountY = (static_cast<uint64_t>(level.height) + 3) / 4;
+        if ((blockCountX * GetBlockSize(image.mFormat)) > std::numeric_limits<uint32_t>::max()) {
+            return ppx::ERROR_IMAGE_INVALID_FORMAT;
+        }
+        levelDataSize += blockCountX * blockCountY * GetBlockSize(image.mFormat);
+    }
+    if ((dataSize - offset) < levelDataSize) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    image.AllocateLevels();
+    memcpy(image.mData.data(), pData + offset, image.mData.size());
+
+    *pImage = std::move(image);
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
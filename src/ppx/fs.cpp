@@ -20,6 +20,13 @@
 #include <optional>
 #include <vector>
 
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #if defined(PPX_ANDROID)
 #include <android_native_app_glue.h>
 android_app* gAndroidContext;
@@ -52,12 +59,70 @@ File::~File()
         case STREAM_HANDLE:
             mStream.close();
             break;
+        case MAPPED_HANDLE:
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+            munmap(const_cast<void*>(mBuffer), mFileSize);
+            close(mDescriptor);
+#else
+            PPX_ASSERT_MSG(false, "Bad implem. This case should never be reached.");
+#endif
+            break;
         default:
             break;
     }
 }
 
-bool File::Open(const std::filesystem::path& path)
+bool File::OpenMapped(const std::filesystem::path& path, AccessPattern accessPattern)
+{
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+    int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    // Empty files cannot be mapped, and non-regular files may not support it.
+    struct stat info = {};
+    if ((fstat(descriptor, &info) != 0) || !S_ISREG(info.st_mode) || (info.st_size <= 0)) {
+        close(descriptor);
+        return false;
+    }
+
+    const size_t size    = static_cast<size_t>(info.st_size);
+    void*        pMapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (pMapped == MAP_FAILED) {
+        close(descriptor);
+        return false;
+    }
+
+    switch (accessPattern) {
+        case ACCESS_PATTERN_SEQUENTIAL:
+            // Start reading the whole file in the background right away.
+            madvise(pMapped, size, MADV_SEQUENTIAL);
+            madvise(pMapped, size, MADV_WILLNEED);
+            break;
+        case ACCESS_PATTERN_RANDOM:
+            madvise(pMapped, size, MADV_RANDOM);
+            break;
+        default:
+            break;
+    }
+
+    // The descriptor is kept open with the mapping, so that the file is
+    // accounted for the same way as with a stream handle.
+    mDescriptor = descriptor;
+    mBuffer     = pMapped;
+    mFileSize   = size;
+    mFileOffset = 0;
+    mHandleType = MAPPED_HANDLE;
+    return true;
+#else
+    (void)path;
+    (void)accessPattern;
+    return false;
+#endif
+}
+
+bool File::Open(const std::filesystem::path& path, AccessPattern accessPattern)
 {
 #if defined(PPX_ANDROID)
     if (!path.is_absolute()) {
@@ -70,6 +135,10 @@ bool File::Open(const std::filesystem::path& path)
     }
 #endif
 
+    if (OpenMapped(path, accessPattern)) {
+        return true;
+    }
+
     mStream.open(path, std::ios::binary);
     if (!mStream.good()) {
         return false;
@@ -88,6 +157,9 @@ bool File::IsValid() const
     if (mHandleType == STREAM_HANDLE) {
         return mStream.good();
     }
+    if (mHandleType == MAPPED_HANDLE) {
+        return mBuffer != nullptr;
+    }
     return mHandleType == ASSET_HANDLE && mAsset != nullptr;
 }
 
@@ -133,18 +205,21 @@ const void* File::GetMappedData() const
 
 bool FileStream::Open(const char* path)
 {
-    auto optional_buffer = load_file(path);
-    if (!optional_buffer.has_value())
+    auto optional_view = load_file_view(path);
+    if (!optional_view.has_value())
         return false;
-    mBuffer = optional_buffer.value();
-    setg(mBuffer.data(), mBuffer.data(), mBuffer.data() + mBuffer.size());
+    mView = std::move(optional_view.value());
+    // The get area is never written to by std::streambuf, so the read-only
+    // mapping can back it directly.
+    char* pData = const_cast<char*>(mView.GetData());
+    setg(pData, pData, pData + mView.GetSize());
     return true;
 }
 
 std::optional<std::vector<char>> load_file(const std::filesystem::path& path)
 {
     ppx::fs::File file;
-    if (!file.Open(path)) {
+    if (!file.Open(path, File::ACCESS_PATTERN_SEQUENTIAL)) {
         return std::nullopt;
     }
     const size_t      size = file.GetLength();
@@ -156,6 +231,30 @@ std::optional<std::vector<char>> load_file(const std::filesystem::path& path)
     return buffer;
 }
 
+std::optional<FileView> load_file_view(const std::filesystem::path& path, File::AccessPattern accessPattern)
+{
+    auto file = std::make_unique<ppx::fs::File>();
+    if (!file->Open(path, accessPattern)) {
+        return std::nullopt;
+    }
+
+    FileView view;
+    view.mSize = file->GetLength();
+    if (file->IsMapped()) {
+        view.mData = reinterpret_cast<const char*>(file->GetMappedData());
+        view.mFile = std::move(file);
+        return view;
+    }
+
+    view.mBuffer.resize(view.mSize);
+    const size_t readSize = file->Read(view.mBuffer.data(), view.mSize);
+    if (readSize != view.mSize) {
+        return std::nullopt;
+    }
+    view.mData = view.mBuffer.data();
+    return view;
+}
+
 bool path_exists(const std::filesystem::path& path)
 {
 #if defined(PPX_ANDROID)
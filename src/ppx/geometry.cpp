@@ -1010,6 +1010,34 @@ Result Geometry::Create(const TriMesh& mesh, Geometry* pGeometry)
     return ppx::SUCCESS;
 }
 
+Result Geometry::Create(const TriMesh& mesh, const MeshletData& meshletData, Geometry* pGeometry)
+{
+    Result ppxres = Create(mesh, pGeometry);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    uint32_t meshletCount = meshletData.GetCountMeshlets();
+    pGeometry->mMeshletBuffer.SetSize(meshletCount * static_cast<uint32_t>(sizeof(MeshletDescriptor)));
+    MeshletDescriptor* pDescriptors = reinterpret_cast<MeshletDescriptor*>(pGeometry->mMeshletBuffer.GetData());
+    for (uint32_t i = 0; i < meshletCount; ++i) {
+        pDescriptors[i] = meshletData.GetDescriptor(i);
+    }
+
+    pGeometry->mMeshletVertexBuffer.SetSize(0);
+    pGeometry->mMeshletVertexBuffer.Append(CountU32(meshletData.vertices), meshletData.vertices.data());
+
+    uint32_t triangleCount = CountU32(meshletData.triangles) / 3;
+    pGeometry->mMeshletTriangleBuffer.SetSize(triangleCount * static_cast<uint32_t>(sizeof(uint32_t)));
+    uint32_t*      pPacked    = reinterpret_cast<uint32_t*>(pGeometry->mMeshletTriangleBuffer.GetData());
+    const uint8_t* pTriangles = meshletData.triangles.data();
+    for (uint32_t i = 0; i < triangleCount; ++i) {
+        pPacked[i] = pTriangles[3 * i + 0] | (pTriangles[3 * i + 1] << 8) | (pTriangles[3 * i + 2] << 16);
+    }
+
+    return ppx::SUCCESS;
+}
+
 Result Geometry::Create(const WireMesh& mesh, Geometry* pGeometry)
 {
     GeometryOptions createInfo       = {};
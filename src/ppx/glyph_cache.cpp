@@ -0,0 +1,241 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/glyph_cache.h"
+#include "ppx/util.h"
+
+namespace ppx {
+
+GlyphCache::~GlyphCache()
+{
+    Destroy();
+}
+
+Result GlyphCache::Create(const GlyphCacheCreateInfo& createInfo)
+{
+    PPX_ASSERT_MSG(!IsCreated(), "GlyphCache is already created");
+    if (!createInfo.rasterize ||
+        (createInfo.cellWidth <= 2 * createInfo.padding) ||
+        (createInfo.cellHeight <= 2 * createInfo.padding)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    const uint32_t columnCount = createInfo.width / createInfo.cellWidth;
+    const uint32_t rowCount    = createInfo.height / createInfo.cellHeight;
+    if ((columnCount == 0) || (rowCount == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mCreateInfo = createInfo;
+    mSlots.resize(columnCount * rowCount);
+    for (uint32_t i = 0; i < CountU32(mSlots); ++i) {
+        Slot& slot    = mSlots[i];
+        slot.cellRect = {(i % columnCount) * createInfo.cellWidth, (i / columnCount) * createInfo.cellHeight, createInfo.cellWidth, createInfo.cellHeight};
+        slot.prev     = (i > 0) ? (i - 1) : kInvalidSlot;
+        slot.next     = (i + 1 < CountU32(mSlots)) ? (i + 1) : kInvalidSlot;
+    }
+    mFront = 0;
+    mBack  = CountU32(mSlots) - 1;
+
+    mStopThread = false;
+    mThread     = std::thread(&GlyphCache::RasterizeLoop, this);
+    return ppx::SUCCESS;
+}
+
+void GlyphCache::Destroy()
+{
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopThread = true;
+            mRequests.clear();
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    mResults.clear();
+    mBusyCount = 0;
+    mSlots.clear();
+    mSlotsByCodepoint.clear();
+    mFront = kInvalidSlot;
+    mBack  = kInvalidSlot;
+}
+
+uint32_t GlyphCache::Acquire(uint32_t codepoint, uint32_t width, uint32_t height, bool* pInserted)
+{
+    PPX_ASSERT_MSG(IsCreated(), "GlyphCache is not created");
+    if (!IsNull(pInserted)) {
+        *pInserted = false;
+    }
+
+    auto it = mSlotsByCodepoint.find(codepoint);
+    if (it != mSlotsByCodepoint.end()) {
+        ++mHitCount;
+        Slot& slot         = mSlots[it->second];
+        slot.lastUsedFrame = mFrameIndex;
+        MoveToFront(it->second);
+        return it->second;
+    }
+
+    ++mMissCount;
+    const uint32_t padding = mCreateInfo.padding;
+    PPX_ASSERT_MSG((width + 2 * padding <= mCreateInfo.cellWidth) && (height + 2 * padding <= mCreateInfo.cellHeight), "glyph does not fit in a cell");
+
+    // The back of the list is the least recently used slot. If a recent
+    // frame used it, it used every other slot too.
+    const uint32_t index = mBack;
+    Slot&          slot  = mSlots[index];
+    if (slot.lastUsedFrame + 1 >= mFrameIndex) {
+        return kInvalidSlot;
+    }
+    if (slot.used) {
+        mSlotsByCodepoint.erase(slot.codepoint);
+        ++mEvictionCount;
+    }
+
+    slot.codepoint     = codepoint;
+    slot.generation    = slot.generation + 1;
+    slot.lastUsedFrame = mFrameIndex;
+    slot.used          = true;
+    slot.resident      = false;
+    slot.glyphRect     = {slot.cellRect.x + padding, slot.cellRect.y + padding, width, height};
+
+    const float invWidth  = 1.0f / static_cast<float>(mCreateInfo.width);
+    const float invHeight = 1.0f / static_cast<float>(mCreateInfo.height);
+    slot.uvRect.u0        = slot.glyphRect.x * invWidth;
+    slot.uvRect.v0        = slot.glyphRect.y * invHeight;
+    slot.uvRect.u1        = (slot.glyphRect.x + width) * invWidth;
+    slot.uvRect.v1        = (slot.glyphRect.y + height) * invHeight;
+
+    mSlotsByCodepoint[codepoint] = index;
+    MoveToFront(index);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRequests.push_back(Request{codepoint, index, slot.generation, width, height, slot.cellRect});
+    }
+    mCondition.notify_all();
+
+    if (!IsNull(pInserted)) {
+        *pInserted = true;
+    }
+    return index;
+}
+
+uint32_t GlyphCache::Find(uint32_t codepoint) const
+{
+    auto it = mSlotsByCodepoint.find(codepoint);
+    return (it != mSlotsByCodepoint.end()) ? it->second : kInvalidSlot;
+}
+
+bool GlyphCache::Touch(uint32_t slot, uint32_t generation)
+{
+    if ((slot >= CountU32(mSlots)) || (mSlots[slot].generation != generation) || !mSlots[slot].used) {
+        return false;
+    }
+    mSlots[slot].lastUsedFrame = mFrameIndex;
+    MoveToFront(slot);
+    return true;
+}
+
+uint32_t GlyphCache::TakeRasterizedGlyphs(uint32_t maxCount, std::vector<RasterizedGlyph>* pGlyphs)
+{
+    PPX_ASSERT_NULL_ARG(pGlyphs);
+    uint32_t count = 0;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    while ((count < maxCount) && !mResults.empty()) {
+        RasterizedGlyph& glyph = mResults.front();
+        Slot&            slot  = mSlots[glyph.slot];
+        if (slot.generation == glyph.generation) {
+            slot.resident = true;
+            pGlyphs->push_back(std::move(glyph));
+            ++count;
+        }
+        mResults.pop_front();
+    }
+    return count;
+}
+
+void GlyphCache::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]() { return mRequests.empty() && (mBusyCount == 0); });
+}
+
+void GlyphCache::Unlink(uint32_t slot)
+{
+    Slot& s = mSlots[slot];
+    if (s.prev != kInvalidSlot) {
+        mSlots[s.prev].next = s.next;
+    }
+    else {
+        mFront = s.next;
+    }
+    if (s.next != kInvalidSlot) {
+        mSlots[s.next].prev = s.prev;
+    }
+    else {
+        mBack = s.prev;
+    }
+    s.prev = kInvalidSlot;
+    s.next = kInvalidSlot;
+}
+
+void GlyphCache::MoveToFront(uint32_t slot)
+{
+    if (mFront == slot) {
+        return;
+    }
+    Unlink(slot);
+    mSlots[slot].next = mFront;
+    if (mFront != kInvalidSlot) {
+        mSlots[mFront].prev = slot;
+    }
+    mFront = slot;
+    if (mBack == kInvalidSlot) {
+        mBack = slot;
+    }
+}
+
+void GlyphCache::RasterizeLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this]() { return mStopThread || !mRequests.empty(); });
+        if (mStopThread) {
+            return;
+        }
+        Request request = mRequests.front();
+        mRequests.pop_front();
+        ++mBusyCount;
+
+        lock.unlock();
+        const uint32_t  padding = mCreateInfo.padding;
+        RasterizedGlyph glyph   = {};
+        glyph.slot              = request.slot;
+        glyph.generation        = request.generation;
+        glyph.cellRect          = request.cellRect;
+        glyph.pixels.assign(static_cast<size_t>(request.cellRect.width) * request.cellRect.height, 0);
+        unsigned char* pOutput = glyph.pixels.data() + (padding * request.cellRect.width) + padding;
+        mCreateInfo.rasterize(request.codepoint, request.width, request.height, request.cellRect.width, pOutput);
+        lock.lock();
+
+        mResults.push_back(std::move(glyph));
+        --mBusyCount;
+        mCondition.notify_all();
+    }
+}
+
+} // namespace ppx
@@ -16,8 +16,11 @@
 #include "ppx/generate_mip_shader_DX.h"
 #include "ppx/graphics_util.h"
 #include "ppx/bitmap.h"
+#include "ppx/compressed_image.h"
 #include "ppx/fs.h"
+#include "ppx/mesh_cache.h"
 #include "ppx/mipmap.h"
+#include "ppx/texture_cache.h"
 #include "ppx/timer.h"
 #include "ppx/grfx/grfx_buffer.h"
 #include "ppx/grfx/grfx_command.h"
@@ -28,6 +31,10 @@
 #include "ppx/grfx/grfx_scope.h"
 #include "gli/gli.hpp"
 
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
 namespace ppx {
 namespace grfx_util {
 
@@ -57,6 +64,21 @@ grfx::Format ToGrfxFormat(Bitmap::Format value)
     return grfx::FORMAT_UNDEFINED;
 }
 
+grfx::Format ToGrfxFormat(CompressedImage::Format value)
+{
+    // clang-format off
+    switch (value) {
+        default: break;
+        case CompressedImage::FORMAT_BC1 : return grfx::FORMAT_BC1_RGB_UNORM; break;
+        case CompressedImage::FORMAT_BC3 : return grfx::FORMAT_BC3_UNORM; break;
+        case CompressedImage::FORMAT_BC4 : return grfx::FORMAT_BC4_UNORM; break;
+        case CompressedImage::FORMAT_BC5 : return grfx::FORMAT_BC5_UNORM; break;
+        case CompressedImage::FORMAT_BC7 : return grfx::FORMAT_BC7_UNORM; break;
+    }
+    // clang-format on
+    return grfx::FORMAT_UNDEFINED;
+}
+
 grfx::Format ToGrfxFormat(gli::format value)
 {
     // clang-format off
@@ -238,8 +260,8 @@ Result CreateImageFromBitmap(
         SCOPED_DESTROYER.AddObject(targetImage);
     }
 
-    // Since this mipmap is temporary, it's safe to use the static pool.
-    Mipmap mipmap = Mipmap(*pBitmap, mipLevelCount, /* useStaticPool= */ true);
+    // Since this mipmap is temporary, take its storage from the scratch pool.
+    Mipmap mipmap = Mipmap(*pBitmap, mipLevelCount, /* useStaticPool= */ true, options.mSRGBMipFilter);
     if (!mipmap.IsOk()) {
         return ppx::ERROR_FAILED;
     }
@@ -875,6 +897,65 @@ Result CopyBitmapToTexture(
 
 // -------------------------------------------------------------------------------------------------
 
+// Returns why an image of this size and format is uploaded uncompressed
+// instead of block compressed, or null if it can be compressed. Block
+// compressed textures need a top level that is a whole number of blocks,
+// smaller mips are padded by the encoder. The encoder takes 8-bit values,
+// so floating point images would lose their range.
+static const char* GetBlockCompressionFallbackReason(uint32_t width, uint32_t height, Bitmap::Format format)
+{
+    if (((width % CompressedImage::kBlockDimension) != 0) || ((height % CompressedImage::kBlockDimension) != 0)) {
+        return "Bitmap size is not a multiple of 4";
+    }
+    if (Bitmap::ChannelDataType(format) == Bitmap::DATA_TYPE_FLOAT) {
+        return "Bitmap format is floating point";
+    }
+    return nullptr;
+}
+
+// Returns the path where CreateTextureFromFile caches the encoding of the
+// image at path. The encoding depends on the quality, and its mips on the
+// filter, so both are part of the name.
+static std::filesystem::path GetBlockCompressionCachePath(
+    const std::filesystem::path& path,
+    CompressedImage::Format      format,
+    CompressedImage::Quality     quality,
+    bool                         sRGBMipFilter)
+{
+    const char* qualityName = "normal";
+    switch (quality) {
+        case CompressedImage::QUALITY_FAST: qualityName = "fast"; break;
+        case CompressedImage::QUALITY_NORMAL: qualityName = "normal"; break;
+        case CompressedImage::QUALITY_HIGH: qualityName = "high"; break;
+    }
+
+    std::filesystem::path cachePath = path;
+    cachePath += "." + std::string(CompressedImage::ToString(format)) + "." + qualityName;
+    if (sRGBMipFilter) {
+        cachePath += ".srgb";
+    }
+    cachePath += ".dds";
+    return cachePath;
+}
+
+static Result EncodeBitmapMips(
+    const Bitmap&            bitmap,
+    uint32_t                 mipLevelCount,
+    bool                     sRGBMipFilter,
+    CompressedImage::Format  format,
+    CompressedImage::Quality quality,
+    CompressedImage*         pImage)
+{
+    // Since this mipmap is temporary, take its storage from the scratch pool.
+    Mipmap mipmap = Mipmap(bitmap, mipLevelCount, /* useStaticPool= */ true, sRGBMipFilter);
+    if (!mipmap.IsOk()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    ScopedTimer timer("Block compression to " + std::string(CompressedImage::ToString(format)));
+    return CompressedImage::Encode(mipmap, format, quality, pImage);
+}
+
 Result CreateTextureFromBitmap(
     grfx::Queue*          pQueue,
     const Bitmap*         pBitmap,
@@ -894,6 +975,20 @@ Result CreateTextureFromBitmap(
     uint32_t maxMipLevelCount = Mipmap::CalculateLevelCount(pBitmap->GetWidth(), pBitmap->GetHeight());
     uint32_t mipLevelCount    = std::min<uint32_t>(options.mMipLevelCount, maxMipLevelCount);
 
+    // Encode and upload block compressed mips
+    if (options.mBlockCompressionFormat != CompressedImage::FORMAT_UNDEFINED) {
+        const char* pFallbackReason = GetBlockCompressionFallbackReason(pBitmap->GetWidth(), pBitmap->GetHeight(), pBitmap->GetFormat());
+        if (IsNull(pFallbackReason)) {
+            CompressedImage image;
+            ppxres = EncodeBitmapMips(*pBitmap, mipLevelCount, options.mSRGBMipFilter, options.mBlockCompressionFormat, options.mBlockCompressionQuality, &image);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            return CreateTextureFromCompressedImage(pQueue, &image, ppTexture, options);
+        }
+        PPX_LOG_WARN(pFallbackReason << ", uploading it uncompressed");
+    }
+
     // Create target texture
     grfx::TexturePtr targetTexture;
     {
@@ -929,8 +1024,8 @@ Result CreateTextureFromBitmap(
         SCOPED_DESTROYER.AddObject(targetTexture);
     }
 
-    // Since this mipmap is temporary, it's safe to use the static pool.
-    Mipmap mipmap = Mipmap(*pBitmap, mipLevelCount, /* useStaticPool= */ true);
+    // Since this mipmap is temporary, take its storage from the scratch pool.
+    Mipmap mipmap = Mipmap(*pBitmap, mipLevelCount, /* useStaticPool= */ true, options.mSRGBMipFilter);
     if (!mipmap.IsOk()) {
         return ppx::ERROR_FAILED;
     }
@@ -1040,8 +1135,464 @@ Result CreateTextureFromMipmap(
     return ppx::SUCCESS;
 }
 
+// Uploads the first mipLevelCount levels of pImage.
+static Result CreateTextureFromCompressedLevels(
+    grfx::Queue*           pQueue,
+    const CompressedImage* pImage,
+    uint32_t               mipLevelCount,
+    grfx::ImageUsageFlags  additionalUsage,
+    grfx::ResourceState    initialState,
+    grfx::Texture**        ppTexture)
+{
+    PPX_ASSERT_MSG(mipLevelCount <= pImage->GetLevelCount(), "The image does not have enough mip levels");
+
+    Result ppxres = ppx::ERROR_FAILED;
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    // Row stride and texture offset alignment to handle DX's requirements
+    const uint32_t rowStrideAlignment = grfx::IsDx12(pQueue->GetDevice()->GetApi()) ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
+    const uint32_t offsetAlignment    = grfx::IsDx12(pQueue->GetDevice()->GetApi()) ? PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : 1;
+
+    // Compute each mip level layout in the staging buffer. Levels are stored
+    // as whole blocks, so the buffer extent is rounded up to the block size.
+    grfx::BufferCreateInfo bufferCreateInfo      = {};
+    bufferCreateInfo.size                        = 0;
+    bufferCreateInfo.usageFlags.bits.transferSrc = true;
+    bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+    std::vector<MipLevel> levelSizes(mipLevelCount);
+    for (uint32_t level = 0; level < mipLevelCount; ++level) {
+        MipLevel& ls    = levelSizes[level];
+        ls.width        = pImage->GetWidth(level);
+        ls.height       = pImage->GetHeight(level);
+        ls.bufferWidth  = RoundUp<uint32_t>(ls.width, CompressedImage::kBlockDimension);
+        ls.bufferHeight = RoundUp<uint32_t>(ls.height, CompressedImage::kBlockDimension);
+        ls.srcRowStride = pImage->GetRowStride(level);
+        ls.dstRowStride = RoundUp<uint32_t>(ls.srcRowStride, rowStrideAlignment);
+        ls.offset       = bufferCreateInfo.size;
+
+        const uint32_t blockRowCount = ls.bufferHeight / CompressedImage::kBlockDimension;
+        bufferCreateInfo.size += static_cast<uint64_t>(blockRowCount) * ls.dstRowStride;
+        bufferCreateInfo.size = RoundUp<uint64_t>(bufferCreateInfo.size, offsetAlignment);
+    }
+
+    // Create staging buffer
+    grfx::BufferPtr stagingBuffer;
+    ppxres = pQueue->GetDevice()->CreateBuffer(&bufferCreateInfo, &stagingBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(stagingBuffer);
+
+    // Map and copy to staging buffer
+    void* pBufferAddress = nullptr;
+    ppxres               = stagingBuffer->MapMemory(0, &pBufferAddress);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (uint32_t level = 0; level < mipLevelCount; ++level) {
+        const MipLevel& ls = levelSizes[level];
+
+        const uint32_t blockRowCount = ls.bufferHeight / CompressedImage::kBlockDimension;
+        const char*    pSrc          = pImage->GetLevelData(level);
+        char*          pDst          = static_cast<char*>(pBufferAddress) + ls.offset;
+        for (uint32_t row = 0; row < blockRowCount; ++row) {
+            memcpy(pDst + row * ls.dstRowStride, pSrc + row * ls.srcRowStride, ls.srcRowStride);
+        }
+    }
+
+    stagingBuffer->UnmapMemory();
+
+    // Create target texture
+    grfx::TexturePtr targetTexture;
+    {
+        grfx::TextureCreateInfo ci     = {};
+        ci.pImage                      = nullptr;
+        ci.imageType                   = grfx::IMAGE_TYPE_2D;
+        ci.width                       = pImage->GetWidth(0);
+        ci.height                      = pImage->GetHeight(0);
+        ci.depth                       = 1;
+        ci.imageFormat                 = ToGrfxFormat(pImage->GetFormat());
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = mipLevelCount;
+        ci.arrayLayerCount             = 1;
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        ci.initialState                = initialState;
+        ci.RTVClearValue               = {{0, 0, 0, 0}};
+        ci.DSVClearValue               = {1.0f, 0xFF};
+        ci.sampledImageViewType        = grfx::IMAGE_VIEW_TYPE_UNDEFINED;
+        ci.sampledImageViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.renderTargetViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.depthStencilViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.storageImageViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.ownership                   = grfx::OWNERSHIP_REFERENCE;
+
+        ci.usageFlags.flags |= additionalUsage;
+
+        ppxres = pQueue->GetDevice()->CreateTexture(&ci, &targetTexture);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(targetTexture);
+    }
+
+    std::vector<grfx::BufferToImageCopyInfo> copyInfos(mipLevelCount);
+    for (uint32_t level = 0; level < mipLevelCount; ++level) {
+        const MipLevel& ls       = levelSizes[level];
+        auto&           copyInfo = copyInfos[level];
+
+        // Copy info
+        copyInfo.srcBuffer.imageWidth      = ls.bufferWidth;
+        copyInfo.srcBuffer.imageHeight     = ls.bufferHeight;
+        copyInfo.srcBuffer.imageRowStride  = ls.dstRowStride;
+        copyInfo.srcBuffer.footprintOffset = ls.offset;
+        copyInfo.srcBuffer.footprintWidth  = ls.bufferWidth;
+        copyInfo.srcBuffer.footprintHeight = ls.bufferHeight;
+        copyInfo.srcBuffer.footprintDepth  = 1;
+        copyInfo.dstImage.mipLevel         = level;
+        copyInfo.dstImage.arrayLayer       = 0;
+        copyInfo.dstImage.arrayLayerCount  = 1;
+        copyInfo.dstImage.x                = 0;
+        copyInfo.dstImage.y                = 0;
+        copyInfo.dstImage.z                = 0;
+        copyInfo.dstImage.width            = ls.width;
+        copyInfo.dstImage.height           = ls.height;
+        copyInfo.dstImage.depth            = 1;
+    }
+
+    // Copy to GPU image
+    ppxres = pQueue->CopyBufferToImage(
+        copyInfos,
+        stagingBuffer,
+        targetTexture->GetImage(),
+        PPX_ALL_SUBRESOURCES,
+        initialState,
+        initialState);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppTexture = targetTexture;
+
+    return ppx::SUCCESS;
+}
+
+Result CreateTextureFromCompressedImage(
+    grfx::Queue*           pQueue,
+    const CompressedImage* pImage,
+    grfx::Texture**        ppTexture,
+    const TextureOptions&  options)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pImage);
+    PPX_ASSERT_NULL_ARG(ppTexture);
+
+    if (!pImage->IsOk()) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    return CreateTextureFromCompressedLevels(pQueue, pImage, pImage->GetLevelCount(), options.mAdditionalUsage, options.mInitialState, ppTexture);
+}
+
 // -------------------------------------------------------------------------------------------------
 
+// Uploads a cached mip chain. The cache file already has the layout of the
+// staging buffer, so its data is copied from the mapping in one go.
+static Result CreateTextureFromCacheFile(
+    grfx::Queue*            pQueue,
+    const TextureCacheFile& cache,
+    grfx::ImageUsageFlags   additionalUsage,
+    grfx::ResourceState     initialState,
+    grfx::Texture**         ppTexture)
+{
+    Result ppxres = ppx::ERROR_FAILED;
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    // Create staging buffer
+    grfx::BufferPtr stagingBuffer;
+    {
+        grfx::BufferCreateInfo ci      = {};
+        ci.size                        = cache.GetDataSize();
+        ci.usageFlags.bits.transferSrc = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        ppxres = pQueue->GetDevice()->CreateBuffer(&ci, &stagingBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(stagingBuffer);
+
+        // Map and copy to staging buffer
+        void* pBufferAddress = nullptr;
+        ppxres               = stagingBuffer->MapMemory(0, &pBufferAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        memcpy(pBufferAddress, cache.GetData(), cache.GetDataSize());
+        stagingBuffer->UnmapMemory();
+    }
+
+    // Create target texture
+    const uint32_t   mipLevelCount = cache.GetLevelCount();
+    grfx::TexturePtr targetTexture;
+    {
+        grfx::TextureCreateInfo ci     = {};
+        ci.pImage                      = nullptr;
+        ci.imageType                   = grfx::IMAGE_TYPE_2D;
+        ci.width                       = cache.GetLevel(0).width;
+        ci.height                      = cache.GetLevel(0).height;
+        ci.depth                       = 1;
+        ci.imageFormat                 = ToGrfxFormat(cache.GetFormat());
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = mipLevelCount;
+        ci.arrayLayerCount             = 1;
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        ci.initialState                = initialState;
+        ci.RTVClearValue               = {{0, 0, 0, 0}};
+        ci.DSVClearValue               = {1.0f, 0xFF};
+        ci.sampledImageViewType        = grfx::IMAGE_VIEW_TYPE_UNDEFINED;
+        ci.sampledImageViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.renderTargetViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.depthStencilViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.storageImageViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.ownership                   = grfx::OWNERSHIP_REFERENCE;
+
+        ci.usageFlags.flags |= additionalUsage;
+
+        ppxres = pQueue->GetDevice()->CreateTexture(&ci, &targetTexture);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(targetTexture);
+    }
+
+    std::vector<grfx::BufferToImageCopyInfo> copyInfos(mipLevelCount);
+    for (uint32_t level = 0; level < mipLevelCount; ++level) {
+        const TextureCacheFile::Level& ls       = cache.GetLevel(level);
+        auto&                          copyInfo = copyInfos[level];
+
+        // Copy info
+        copyInfo.srcBuffer.imageWidth      = ls.width;
+        copyInfo.srcBuffer.imageHeight     = ls.height;
+        copyInfo.srcBuffer.imageRowStride  = ls.rowStride;
+        copyInfo.srcBuffer.footprintOffset = ls.offset;
+        copyInfo.srcBuffer.footprintWidth  = ls.width;
+        copyInfo.srcBuffer.footprintHeight = ls.height;
+        copyInfo.srcBuffer.footprintDepth  = 1;
+        copyInfo.dstImage.mipLevel         = level;
+        copyInfo.dstImage.arrayLayer       = 0;
+        copyInfo.dstImage.arrayLayerCount  = 1;
+        copyInfo.dstImage.x                = 0;
+        copyInfo.dstImage.y                = 0;
+        copyInfo.dstImage.z                = 0;
+        copyInfo.dstImage.width            = ls.width;
+        copyInfo.dstImage.height           = ls.height;
+        copyInfo.dstImage.depth            = 1;
+    }
+
+    // Copy to GPU image
+    ppxres = pQueue->CopyBufferToImage(
+        copyInfos,
+        stagingBuffer,
+        targetTexture->GetImage(),
+        PPX_ALL_SUBRESOURCES,
+        initialState,
+        initialState);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppTexture = targetTexture;
+
+    return ppx::SUCCESS;
+}
+
+// Decodes an image straight into a mapped staging buffer, with the row stride
+// required by the API, so the decoded image is never held in memory.
+class StagingBufferSink : public BitmapSink
+{
+public:
+    StagingBufferSink(grfx::Device* pDevice)
+        : mDevice(pDevice) {}
+
+    ~StagingBufferSink()
+    {
+        if (!IsNull(mMappedAddress)) {
+            mStagingBuffer->UnmapMemory();
+        }
+    }
+
+    Result Begin(uint32_t width, uint32_t height, Bitmap::Format format) override
+    {
+        const uint32_t rowAlignment = grfx::IsDx12(mDevice->GetApi()) ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
+
+        mWidth     = width;
+        mHeight    = height;
+        mFormat    = format;
+        mRowStride = RoundUp<uint32_t>(width * Bitmap::FormatSize(format), rowAlignment);
+
+        grfx::BufferCreateInfo ci      = {};
+        ci.size                        = static_cast<uint64_t>(mRowStride) * height;
+        ci.usageFlags.bits.transferSrc = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        Result ppxres = mDevice->CreateBuffer(&ci, &mStagingBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        return mStagingBuffer->MapMemory(0, &mMappedAddress);
+    }
+
+    Result WriteBand(uint32_t firstRow, const Bitmap& band) override
+    {
+        const uint32_t rowCopySize = band.GetWidth() * band.GetPixelStride();
+        char*          pDst        = static_cast<char*>(mMappedAddress) + static_cast<uint64_t>(firstRow) * mRowStride;
+        for (uint32_t y = 0; y < band.GetHeight(); ++y) {
+            memcpy(pDst, band.GetPixelAddress(0, y), rowCopySize);
+            pDst += mRowStride;
+        }
+        return ppx::SUCCESS;
+    }
+
+    // Unmaps the staging buffer once the decode is done.
+    void Finish()
+    {
+        if (!IsNull(mMappedAddress)) {
+            mStagingBuffer->UnmapMemory();
+            mMappedAddress = nullptr;
+        }
+    }
+
+    grfx::BufferPtr GetStagingBuffer() const { return mStagingBuffer; }
+    uint32_t        GetWidth() const { return mWidth; }
+    uint32_t        GetHeight() const { return mHeight; }
+    Bitmap::Format  GetFormat() const { return mFormat; }
+    uint32_t        GetRowStride() const { return mRowStride; }
+
+private:
+    grfx::Device*   mDevice = nullptr;
+    grfx::BufferPtr mStagingBuffer;
+    void*           mMappedAddress = nullptr;
+    uint32_t        mWidth         = 0;
+    uint32_t        mHeight        = 0;
+    Bitmap::Format  mFormat        = Bitmap::FORMAT_UNDEFINED;
+    uint32_t        mRowStride     = 0;
+};
+
+// Creates a single level texture by streaming the decode of an image file to
+// the staging buffer. Peak memory is the staging buffer and one band of rows.
+static Result CreateTextureFromStreamedFile(
+    grfx::Queue*                 pQueue,
+    const std::filesystem::path& path,
+    grfx::ImageUsageFlags        additionalUsage,
+    grfx::ResourceState          initialState,
+    grfx::Texture**              ppTexture)
+{
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    StagingBufferSink sink(pQueue->GetDevice());
+    Result            ppxres = Bitmap::StreamFile(path, &sink);
+    if (sink.GetStagingBuffer()) {
+        SCOPED_DESTROYER.AddObject(sink.GetStagingBuffer());
+    }
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    sink.Finish();
+
+    // Create target texture
+    grfx::TexturePtr targetTexture;
+    {
+        grfx::TextureCreateInfo ci     = {};
+        ci.pImage                      = nullptr;
+        ci.imageType                   = grfx::IMAGE_TYPE_2D;
+        ci.width                       = sink.GetWidth();
+        ci.height                      = sink.GetHeight();
+        ci.depth                       = 1;
+        ci.imageFormat                 = ToGrfxFormat(sink.GetFormat());
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = 1;
+        ci.arrayLayerCount             = 1;
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        ci.initialState                = initialState;
+        ci.RTVClearValue               = {{0, 0, 0, 0}};
+        ci.DSVClearValue               = {1.0f, 0xFF};
+        ci.sampledImageViewType        = grfx::IMAGE_VIEW_TYPE_UNDEFINED;
+        ci.sampledImageViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.renderTargetViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.depthStencilViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.storageImageViewFormat      = grfx::FORMAT_UNDEFINED;
+        ci.ownership                   = grfx::OWNERSHIP_REFERENCE;
+
+        ci.usageFlags.flags |= additionalUsage;
+
+        ppxres = pQueue->GetDevice()->CreateTexture(&ci, &targetTexture);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(targetTexture);
+    }
+
+    // Copy info
+    grfx::BufferToImageCopyInfo copyInfo = {};
+    copyInfo.srcBuffer.imageWidth        = sink.GetWidth();
+    copyInfo.srcBuffer.imageHeight       = sink.GetHeight();
+    copyInfo.srcBuffer.imageRowStride    = sink.GetRowStride();
+    copyInfo.srcBuffer.footprintOffset   = 0;
+    copyInfo.srcBuffer.footprintWidth    = sink.GetWidth();
+    copyInfo.srcBuffer.footprintHeight   = sink.GetHeight();
+    copyInfo.srcBuffer.footprintDepth    = 1;
+    copyInfo.dstImage.mipLevel           = 0;
+    copyInfo.dstImage.arrayLayer         = 0;
+    copyInfo.dstImage.arrayLayerCount    = 1;
+    copyInfo.dstImage.x                  = 0;
+    copyInfo.dstImage.y                  = 0;
+    copyInfo.dstImage.z                  = 0;
+    copyInfo.dstImage.width              = sink.GetWidth();
+    copyInfo.dstImage.height             = sink.GetHeight();
+    copyInfo.dstImage.depth              = 1;
+
+    // Copy to GPU image
+    ppxres = pQueue->CopyBufferToImage(
+        std::vector<grfx::BufferToImageCopyInfo>{copyInfo},
+        sink.GetStagingBuffer(),
+        targetTexture->GetImage(),
+        PPX_ALL_SUBRESOURCES,
+        initialState,
+        initialState);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppTexture = targetTexture;
+
+    return ppx::SUCCESS;
+}
+
 Result CreateTextureFromFile(
     grfx::Queue*                 pQueue,
     const std::filesystem::path& path,
@@ -1053,13 +1604,116 @@ Result CreateTextureFromFile(
 
     ScopedTimer timer("Texture creation from image file '" + path.string() + "'");
 
+    const CompressedImage::Format compressionFormat = options.mBlockCompressionFormat;
+    const bool                    useCache          = (compressionFormat != CompressedImage::FORMAT_UNDEFINED) && options.mBlockCompressionCache;
+
+    const std::filesystem::path cachePath = GetBlockCompressionCachePath(path, compressionFormat, options.mBlockCompressionQuality, options.mSRGBMipFilter);
+
+    // Use the cached encoding if it is up to date. The source header is
+    // checked too, so that a cache file is never used for an image that
+    // would not be block compressed, or that has another size.
+    if (useCache) {
+        std::error_code ec;
+        auto            sourceTime   = std::filesystem::last_write_time(path, ec);
+        auto            cacheTime    = ec ? sourceTime : std::filesystem::last_write_time(cachePath, ec);
+        uint32_t        sourceWidth  = 0;
+        uint32_t        sourceHeight = 0;
+        Bitmap::Format  sourceFormat = Bitmap::FORMAT_UNDEFINED;
+        if (!ec && (cacheTime >= sourceTime) &&
+            Success(Bitmap::GetFileProperties(path, &sourceWidth, &sourceHeight, &sourceFormat)) &&
+            IsNull(GetBlockCompressionFallbackReason(sourceWidth, sourceHeight, sourceFormat))) {
+            CompressedImage image;
+            if (Success(CompressedImage::LoadDDS(cachePath, &image)) && (image.GetFormat() == compressionFormat) &&
+                (image.GetWidth(0) == sourceWidth) && (image.GetHeight(0) == sourceHeight)) {
+                // A file with more levels than requested was written for
+                // another mip level count, only the requested ones are used.
+                const uint32_t maxMipLevelCount = Mipmap::CalculateLevelCount(image.GetWidth(0), image.GetHeight(0));
+                const uint32_t mipLevelCount    = std::min<uint32_t>(options.mMipLevelCount, maxMipLevelCount);
+                if (image.GetLevelCount() >= mipLevelCount) {
+                    return CreateTextureFromCompressedLevels(pQueue, &image, mipLevelCount, options.mAdditionalUsage, options.mInitialState, ppTexture);
+                }
+            }
+        }
+    }
+
+    // Reuse the cached mip chain if an image with the same content was
+    // already loaded with the same options.
+    std::filesystem::path textureCacheDirectory = GetTextureCacheDirectory();
+    if ((compressionFormat == CompressedImage::FORMAT_UNDEFINED) && !textureCacheDirectory.empty()) {
+        auto view = fs::load_file_view(path);
+        if (!view.has_value()) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+
+        const bool isDx12 = grfx::IsDx12(pQueue->GetDevice()->GetApi());
+
+        TextureCacheFile::Key key = {};
+        key.contentHash           = TextureCacheFile::HashContent(view->GetData(), view->GetSize());
+        key.mipLevelCount         = options.mMipLevelCount;
+        key.sRGBMipFilter         = options.mSRGBMipFilter;
+        key.rowStrideAlignment    = isDx12 ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
+        key.offsetAlignment       = isDx12 ? PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : 1;
+
+        std::filesystem::path cachePath = TextureCacheFile::GetCachePath(textureCacheDirectory, key);
+        TextureCacheFile      cache;
+        if (Success(cache.Open(cachePath, key))) {
+            return CreateTextureFromCacheFile(pQueue, cache, options.mAdditionalUsage, options.mInitialState, ppTexture);
+        }
+
+        // Decode from the content that was just hashed instead of reading
+        // the file again.
+        Bitmap bitmap;
+        Result ppxres = Bitmap::LoadFromMemory(view->GetSize(), view->GetData(), &bitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        uint32_t maxMipLevelCount = Mipmap::CalculateLevelCount(bitmap.GetWidth(), bitmap.GetHeight());
+        uint32_t mipLevelCount    = std::min<uint32_t>(options.mMipLevelCount, maxMipLevelCount);
+
+        // Since this mipmap is temporary, take its storage from the scratch pool.
+        Mipmap mipmap = Mipmap(bitmap, mipLevelCount, /* useStaticPool= */ true, options.mSRGBMipFilter);
+        if (!mipmap.IsOk()) {
+            return ppx::ERROR_FAILED;
+        }
+
+        if (Failed(TextureCacheFile::Write(cachePath, key, mipmap))) {
+            PPX_LOG_WARN("Texture cache disabled for: " << path);
+        }
+        return CreateTextureFromMipmap(pQueue, &mipmap, ppTexture, options);
+    }
+
+    // Without mips to generate, the decoded image is only needed in the
+    // staging buffer.
+    if ((compressionFormat == CompressedImage::FORMAT_UNDEFINED) && (options.mMipLevelCount == 1)) {
+        return CreateTextureFromStreamedFile(pQueue, path, options.mAdditionalUsage, options.mInitialState, ppTexture);
+    }
+
     // Load bitmap
     Bitmap bitmap;
     Result ppxres = Bitmap::LoadFile(path, &bitmap);
     if (Failed(ppxres)) {
         return ppxres;
     }
-    return CreateTextureFromBitmap(pQueue, &bitmap, ppTexture, options);
+
+    if (!useCache || !IsNull(GetBlockCompressionFallbackReason(bitmap.GetWidth(), bitmap.GetHeight(), bitmap.GetFormat()))) {
+        return CreateTextureFromBitmap(pQueue, &bitmap, ppTexture, options);
+    }
+
+    // Encode, then store the result next to the source. A failed write only
+    // costs an encode on the next load.
+    uint32_t maxMipLevelCount = Mipmap::CalculateLevelCount(bitmap.GetWidth(), bitmap.GetHeight());
+    uint32_t mipLevelCount    = std::min<uint32_t>(options.mMipLevelCount, maxMipLevelCount);
+
+    CompressedImage image;
+    ppxres = EncodeBitmapMips(bitmap, mipLevelCount, options.mSRGBMipFilter, compressionFormat, options.mBlockCompressionQuality, &image);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    if (Failed(image.SaveDDS(cachePath))) {
+        PPX_LOG_WARN("Failed to write block compression cache file: " << cachePath);
+    }
+    return CreateTextureFromCompressedImage(pQueue, &image, ppTexture, options);
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -1128,6 +1782,61 @@ SubImage CalcSubimageCrossHorizontalLeft(
     return subImage;
 }
 
+// The tokens of an .ibl file are separated by whitespace. They are read
+// straight from the bytes of the file.
+static const char* kIBLWhitespace = " \t\n\v\f\r";
+
+static void SkipIBLWhitespace(std::string_view* pText)
+{
+    size_t start = pText->find_first_not_of(kIBLWhitespace);
+    pText->remove_prefix(std::min(start, pText->size()));
+}
+
+// Reads a file name, in double quotes if it contains whitespace. Quoted names
+// can escape characters with a backslash, like std::quoted.
+static bool ReadIBLPath(std::string_view* pText, std::filesystem::path* pPath)
+{
+    SkipIBLWhitespace(pText);
+    if (pText->empty()) {
+        return false;
+    }
+
+    std::string name;
+    if (pText->front() != '"') {
+        size_t end = std::min(pText->find_first_of(kIBLWhitespace), pText->size());
+        name       = std::string(pText->substr(0, end));
+        pText->remove_prefix(end);
+    }
+    else {
+        size_t i = 1;
+        for (; (i < pText->size()) && ((*pText)[i] != '"'); ++i) {
+            if (((*pText)[i] == '\\') && ((i + 1) < pText->size())) {
+                ++i;
+            }
+            name.push_back((*pText)[i]);
+        }
+        if (i == pText->size()) {
+            return false;
+        }
+        pText->remove_prefix(i + 1);
+    }
+
+    *pPath = name;
+    return !name.empty();
+}
+
+static bool ReadIBLUint32(std::string_view* pText, uint32_t* pValue)
+{
+    SkipIBLWhitespace(pText);
+    const char* pEnd   = pText->data() + pText->size();
+    auto [pNext, errc] = std::from_chars(pText->data(), pEnd, *pValue);
+    if ((errc != std::errc()) || ((pNext != pEnd) && (std::strchr(kIBLWhitespace, *pNext) == nullptr))) {
+        return false;
+    }
+    pText->remove_prefix(pNext - pText->data());
+    return true;
+}
+
 Result CreateIBLTexturesFromFile(
     grfx::Queue*                 pQueue,
     const std::filesystem::path& path,
@@ -1138,32 +1847,24 @@ Result CreateIBLTexturesFromFile(
     PPX_ASSERT_NULL_ARG(ppIrradianceTexture);
     PPX_ASSERT_NULL_ARG(ppEnvironmentTexture);
 
-    auto fileBytes = ppx::fs::load_file(path);
+    auto fileBytes = ppx::fs::load_file_view(path);
     if (!fileBytes.has_value()) {
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
 
-    auto is = std::istringstream(std::string(fileBytes.value().data(), fileBytes.value().size()));
-    if (!is.good()) {
-        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
-    }
-
+    std::string_view      text(fileBytes.value().GetData(), fileBytes.value().GetSize());
     std::filesystem::path irrFile;
-    is >> irrFile;
-
     std::filesystem::path envFile;
-    is >> envFile;
-
-    uint32_t baseWidth = 0;
-    is >> baseWidth;
-
-    uint32_t baseHeight = 0;
-    is >> baseHeight;
-
-    uint32_t levelCount = 0;
-    is >> levelCount;
-
-    if (irrFile.empty() || envFile.empty() || (baseWidth == 0) || (baseHeight == 0) || (levelCount == 0)) {
+    uint32_t              baseWidth  = 0;
+    uint32_t              baseHeight = 0;
+    uint32_t              levelCount = 0;
+
+    bool parsed = ReadIBLPath(&text, &irrFile) &&
+                  ReadIBLPath(&text, &envFile) &&
+                  ReadIBLUint32(&text, &baseWidth) &&
+                  ReadIBLUint32(&text, &baseHeight) &&
+                  ReadIBLUint32(&text, &levelCount);
+    if (!parsed || (baseWidth == 0) || (baseHeight == 0) || (levelCount == 0)) {
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
 
@@ -1333,21 +2034,29 @@ Result CreateCubeMapFromFile(
 
 // -------------------------------------------------------------------------------------------------
 
-Result CreateMeshFromGeometry(
-    grfx::Queue*    pQueue,
-    const Geometry* pGeometry,
-    grfx::Mesh**    ppMesh)
+// Index data followed by the data of each vertex buffer, in the layout of the
+// GPU buffers.
+struct MeshStream
 {
-    PPX_ASSERT_NULL_ARG(pQueue);
-    PPX_ASSERT_NULL_ARG(pGeometry);
-    PPX_ASSERT_NULL_ARG(ppMesh);
+    const void* pData = nullptr;
+    uint64_t    size  = 0;
+};
 
+static Result CreateMeshFromStreams(
+    grfx::Queue*                   pQueue,
+    const grfx::MeshCreateInfo&    createInfo,
+    const std::vector<MeshStream>& streams,
+    grfx::Mesh**                   ppMesh)
+{
     grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
 
     // Create staging buffer
     grfx::BufferPtr stagingBuffer;
     {
-        uint32_t biggestBufferSize = pGeometry->GetLargestBufferSize();
+        uint64_t biggestBufferSize = 0;
+        for (const MeshStream& stream : streams) {
+            biggestBufferSize = std::max(biggestBufferSize, stream.size);
+        }
 
         grfx::BufferCreateInfo ci      = {};
         ci.size                        = biggestBufferSize;
@@ -1364,7 +2073,7 @@ Result CreateMeshFromGeometry(
     // Create target mesh
     grfx::MeshPtr targetMesh;
     {
-        grfx::MeshCreateInfo ci = grfx::MeshCreateInfo(*pGeometry);
+        grfx::MeshCreateInfo ci = createInfo;
 
         Result ppxres = pQueue->GetDevice()->CreateMesh(&ci, &targetMesh);
         if (Failed(ppxres)) {
@@ -1373,24 +2082,21 @@ Result CreateMeshFromGeometry(
         SCOPED_DESTROYER.AddObject(targetMesh);
     }
 
-    // Copy geometry data to mesh
+    // Copy stream data to mesh
     {
         // Copy info
         grfx::BufferToBufferCopyInfo copyInfo = {};
 
         // Index buffer
-        if (pGeometry->GetIndexType() != grfx::INDEX_TYPE_UNDEFINED) {
-            const Geometry::Buffer* pGeoBuffer = pGeometry->GetIndexBuffer();
-            PPX_ASSERT_NULL_ARG(pGeoBuffer);
+        if (createInfo.indexType != grfx::INDEX_TYPE_UNDEFINED) {
+            const MeshStream& stream = streams[0];
 
-            uint32_t geoBufferSize = pGeoBuffer->GetSize();
-
-            Result ppxres = stagingBuffer->CopyFromSource(geoBufferSize, pGeoBuffer->GetData());
+            Result ppxres = stagingBuffer->CopyFromSource(static_cast<uint32_t>(stream.size), stream.pData);
             if (Failed(ppxres)) {
                 return ppxres;
             }
 
-            copyInfo.size = geoBufferSize;
+            copyInfo.size = stream.size;
 
             // Copy to GPU buffer
             ppxres = pQueue->CopyBufferToBuffer(&copyInfo, stagingBuffer, targetMesh->GetIndexBuffer(), grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_INDEX_BUFFER);
@@ -1400,19 +2106,15 @@ Result CreateMeshFromGeometry(
         }
 
         // Vertex buffers
-        uint32_t vertexBufferCount = pGeometry->GetVertexBufferCount();
-        for (uint32_t i = 0; i < vertexBufferCount; ++i) {
-            const Geometry::Buffer* pGeoBuffer = pGeometry->GetVertexBuffer(i);
-            PPX_ASSERT_NULL_ARG(pGeoBuffer);
-
-            uint32_t geoBufferSize = pGeoBuffer->GetSize();
+        for (uint32_t i = 0; i < createInfo.vertexBufferCount; ++i) {
+            const MeshStream& stream = streams[i + 1];
 
-            Result ppxres = stagingBuffer->CopyFromSource(geoBufferSize, pGeoBuffer->GetData());
+            Result ppxres = stagingBuffer->CopyFromSource(static_cast<uint32_t>(stream.size), stream.pData);
             if (Failed(ppxres)) {
                 return ppxres;
             }
 
-            copyInfo.size = geoBufferSize;
+            copyInfo.size = stream.size;
 
             grfx::BufferPtr targetBuffer = targetMesh->GetVertexBuffer(i);
 
@@ -1433,6 +2135,26 @@ Result CreateMeshFromGeometry(
     return ppx::SUCCESS;
 }
 
+Result CreateMeshFromGeometry(
+    grfx::Queue*    pQueue,
+    const Geometry* pGeometry,
+    grfx::Mesh**    ppMesh)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pGeometry);
+    PPX_ASSERT_NULL_ARG(ppMesh);
+
+    std::vector<MeshStream> streams;
+    streams.push_back({pGeometry->GetIndexBuffer()->GetData(), pGeometry->GetIndexBuffer()->GetSize()});
+    for (uint32_t i = 0; i < pGeometry->GetVertexBufferCount(); ++i) {
+        const Geometry::Buffer* pGeoBuffer = pGeometry->GetVertexBuffer(i);
+        PPX_ASSERT_NULL_ARG(pGeoBuffer);
+        streams.push_back({pGeoBuffer->GetData(), pGeoBuffer->GetSize()});
+    }
+
+    return CreateMeshFromStreams(pQueue, grfx::MeshCreateInfo(*pGeometry), streams, ppMesh);
+}
+
 // -------------------------------------------------------------------------------------------------
 
 Result CreateMeshFromTriMesh(
@@ -1498,9 +2220,41 @@ Result CreateMeshFromFile(
     PPX_ASSERT_NULL_ARG(pQueue);
     PPX_ASSERT_NULL_ARG(ppMesh);
 
-    TriMesh mesh = TriMesh::CreateFromOBJ(path, options);
+    // Reuse the cached streams if the file was already loaded with the same
+    // options and has not changed since.
+    std::filesystem::path cacheDirectory = GetMeshCacheDirectory();
+    std::filesystem::path cachePath;
+    if (!cacheDirectory.empty()) {
+        cachePath = MeshCacheFile::GetCachePath(cacheDirectory, path, options);
+
+        MeshCacheFile cache;
+        if (Success(cache.Open(cachePath, path, options))) {
+            std::vector<MeshStream> streams;
+            streams.push_back({cache.GetIndexData(), cache.GetIndexDataSize()});
+            for (uint32_t i = 0; i < cache.GetVertexBufferCount(); ++i) {
+                streams.push_back({cache.GetVertexData(i), cache.GetVertexDataSize(i)});
+            }
+            return CreateMeshFromStreams(pQueue, cache.GetMeshCreateInfo(), streams, ppMesh);
+        }
+    }
 
-    Result ppxres = CreateMeshFromTriMesh(pQueue, &mesh, ppMesh);
+    TriMesh mesh;
+    Result  ppxres = TriMesh::CreateFromOBJ(path, options, &mesh);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    Geometry geo;
+    ppxres = Geometry::Create(mesh, &geo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    if (!cachePath.empty() && Failed(MeshCacheFile::Write(cachePath, path, options, geo))) {
+        PPX_LOG_WARN("Mesh cache disabled for: " << path);
+    }
+
+    ppxres = CreateMeshFromGeometry(pQueue, &geo, ppMesh);
     if (Failed(ppxres)) {
         return ppxres;
     }
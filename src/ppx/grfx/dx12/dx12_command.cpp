@@ -136,6 +136,7 @@ Result CommandBuffer::Begin()
         PPX_ASSERT_MSG(false, "ID3D12CommandList::Reset failed");
         return ppx::ERROR_API_FAILURE;
     }
+    mRecording = true;
 
     // Reset current root signatures
     mCurrentGraphicsInterface = nullptr;
@@ -165,6 +166,8 @@ Result CommandBuffer::Begin()
 
 Result CommandBuffer::End()
 {
+    mRecording = false;
+
     HRESULT hr = mCommandList->Close();
     if (FAILED(hr)) {
         PPX_ASSERT_MSG(false, "ID3D12CommandList::Close failed");
@@ -174,6 +177,19 @@ Result CommandBuffer::End()
     return ppx::SUCCESS;
 }
 
+Result CommandBuffer::Reset()
+{
+    // Only a closed command list can be reset, and Begin resets both the
+    // allocator and the list, so a list that is recording only needs to be
+    // closed. Close fails for a list with invalid commands but still closes it.
+    if (mRecording) {
+        mRecording = false;
+        mCommandList->Close();
+    }
+
+    return ppx::SUCCESS;
+}
+
 void CommandBuffer::BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo)
 {
     PPX_ASSERT_NULL_ARG(pBeginInfo->pRenderPass);
@@ -238,7 +238,7 @@ void DescriptorSet::DestroyApiObjects()
     }
 }
 
-Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
+Result DescriptorSet::UpdateApiDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
 {
     // Check descriptor types
     for (uint32_t writeIndex = 0; writeIndex < writeCount; ++writeIndex) {
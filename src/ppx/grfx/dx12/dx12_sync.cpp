@@ -73,6 +73,11 @@ Result Fence::Wait(uint64_t timeout)
     return ppx::SUCCESS;
 }
 
+bool Fence::IsSignaled() const
+{
+    return (mFence->GetCompletedValue() >= GetWaitForValue());
+}
+
 Result Fence::Reset()
 {
     return ppx::SUCCESS;
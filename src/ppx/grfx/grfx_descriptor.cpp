@@ -13,15 +13,115 @@
 // limitations under the License.
 
 #include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_device.h"
 #include "ppx/grfx/grfx_image.h"
 #include "ppx/grfx/grfx_texture.h"
 
+#include <algorithm>
+#include <functional>
+
 namespace ppx {
 namespace grfx {
 
+namespace {
+
+uint64_t GetWriteKey(const grfx::WriteDescriptor& write)
+{
+    return (static_cast<uint64_t>(write.binding) << 32) | static_cast<uint64_t>(write.arrayIndex);
+}
+
+// Hashes what a write puts in its descriptor.
+uint64_t HashWrite(const grfx::WriteDescriptor& write)
+{
+    struct
+    {
+        uint64_t type;
+        uint64_t bufferOffset;
+        uint64_t bufferRange;
+        uint64_t structuredElementCount;
+        uint64_t bufferId;
+        uint64_t imageViewId;
+        uint64_t samplerId;
+    } content = {};
+
+    content.type                   = static_cast<uint64_t>(write.type);
+    content.bufferOffset           = write.bufferOffset;
+    content.bufferRange            = write.bufferRange;
+    content.structuredElementCount = write.structuredElementCount;
+    content.bufferId               = IsNull(write.pBuffer) ? 0 : write.pBuffer->GetObjectId();
+    content.imageViewId            = IsNull(write.pImageView) ? 0 : write.pImageView->GetViewId();
+    content.samplerId              = IsNull(write.pSampler) ? 0 : write.pSampler->GetObjectId();
+
+    return static_cast<uint64_t>(XXH64(&content, sizeof(content), 0));
+}
+
+struct WriteCounters
+{
+    ppx::ProfilerCounterToken issued = ppx::kInvalidProfilerCounterToken;
+    ppx::ProfilerCounterToken elided = ppx::kInvalidProfilerCounterToken;
+};
+
+// The counters are shared by the updates of all sets and batches.
+const WriteCounters& GetWriteCounters()
+{
+    static const WriteCounters sCounters = []() {
+        WriteCounters counters = {};
+        Profiler::RegisterCounter("Descriptor writes issued", &counters.issued);
+        Profiler::RegisterCounter("Descriptor writes elided", &counters.elided);
+        return counters;
+    }();
+    return sCounters;
+}
+
+} // namespace
+
 // -------------------------------------------------------------------------------------------------
 // DescriptorSet
 // -------------------------------------------------------------------------------------------------
+Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
+{
+    if (writeCount == 0) {
+        return ppx::SUCCESS;
+    }
+    PPX_ASSERT_NULL_ARG(pWrites);
+
+    // Skip the writes replaced by a later write to the same descriptor, and
+    // the writes of the resource that a descriptor already holds.
+    if (writeCount > 1) {
+        mLastWriteIndices.clear();
+        for (uint32_t i = 0; i < writeCount; ++i) {
+            mLastWriteIndices[GetWriteKey(pWrites[i])] = i;
+        }
+    }
+
+    mIssuedWrites.clear();
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        bool isReplaced = (writeCount > 1) && (mLastWriteIndices[GetWriteKey(pWrites[i])] != i);
+        if (!isReplaced && !IsWritten(pWrites[i])) {
+            mIssuedWrites.push_back(pWrites[i]);
+        }
+    }
+
+    const WriteCounters& counters = GetWriteCounters();
+    Profiler::AddToCounter(counters.elided, writeCount - CountU32(mIssuedWrites));
+    if (mIssuedWrites.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = UpdateApiDescriptors(CountU32(mIssuedWrites), mIssuedWrites.data());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (const grfx::WriteDescriptor& write : mIssuedWrites) {
+        RecordWrite(write);
+    }
+
+    Profiler::AddToCounter(counters.issued, mIssuedWrites.size());
+    return ppx::SUCCESS;
+}
+
 Result DescriptorSet::UpdateSampler(
     uint32_t             binding,
     uint32_t             arrayIndex,
@@ -102,6 +202,95 @@ Result DescriptorSet::UpdateUniformBuffer(
     return ppx::SUCCESS;
 }
 
+bool DescriptorSet::IsWritten(const grfx::WriteDescriptor& write) const
+{
+    auto it = mWriteHashes.find(GetWriteKey(write));
+    return (it != mWriteHashes.end()) && (it->second == HashWrite(write));
+}
+
+void DescriptorSet::RecordWrite(const grfx::WriteDescriptor& write)
+{
+    mWriteHashes[GetWriteKey(write)] = HashWrite(write);
+}
+
+// -------------------------------------------------------------------------------------------------
+// DescriptorWriteBatch
+// -------------------------------------------------------------------------------------------------
+bool DescriptorWriteBatch::WriteKey::operator==(const WriteKey& rhs) const
+{
+    return (pSet == rhs.pSet) && (binding == rhs.binding) && (arrayIndex == rhs.arrayIndex);
+}
+
+size_t DescriptorWriteBatch::WriteKeyHasher::operator()(const WriteKey& key) const
+{
+    return std::hash<const void*>()(key.pSet) ^ std::hash<uint64_t>()((static_cast<uint64_t>(key.binding) << 32) | key.arrayIndex);
+}
+
+void DescriptorWriteBatch::Write(grfx::DescriptorSet* pSet, const grfx::WriteDescriptor& write)
+{
+    PPX_ASSERT_NULL_ARG(pSet);
+
+    WriteKey key   = {};
+    key.pSet       = pSet;
+    key.binding    = write.binding;
+    key.arrayIndex = write.arrayIndex;
+
+    auto it = mWriteIndices.find(key);
+    if (it != mWriteIndices.end()) {
+        mWrites[it->second].write = write;
+        mReplacedCount += 1;
+        return;
+    }
+
+    mWriteIndices.emplace(key, CountU32(mWrites));
+    mWrites.push_back({pSet, write});
+}
+
+Result DescriptorWriteBatch::Flush()
+{
+    const WriteCounters& counters = GetWriteCounters();
+
+    mIssuedWrites.clear();
+    for (auto& write : mWrites) {
+        if (!write.pSet->IsWritten(write.write)) {
+            mIssuedWrites.push_back(write);
+        }
+    }
+    uint32_t elidedCount = mReplacedCount + CountU32(mWrites) - CountU32(mIssuedWrites);
+
+    mWrites.clear();
+    mWriteIndices.clear();
+    mReplacedCount = 0;
+
+    Profiler::AddToCounter(counters.elided, elidedCount);
+    if (mIssuedWrites.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    // Keep the writes of each set together for the backends that update
+    // one set at a time.
+    std::stable_sort(
+        mIssuedWrites.begin(),
+        mIssuedWrites.end(),
+        [](const grfx::DescriptorSetWrite& a, const grfx::DescriptorSetWrite& b) -> bool {
+            return std::less<const grfx::DescriptorSet*>()(a.pSet, b.pSet);
+        });
+
+    Result ppxres = UpdateDescriptorSets(CountU32(mIssuedWrites), mIssuedWrites.data());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    Profiler::AddToCounter(counters.issued, mIssuedWrites.size());
+    return ppx::SUCCESS;
+}
+
+Result DescriptorWriteBatch::UpdateDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites)
+{
+    grfx::Device* pDevice = pWrites[0].pSet->GetDevice();
+    return pDevice->UpdateDescriptorSets(writeCount, pWrites);
+}
+
 // -------------------------------------------------------------------------------------------------
 // DescriptorSetLayout
 // -------------------------------------------------------------------------------------------------
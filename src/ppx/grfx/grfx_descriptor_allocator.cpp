@@ -0,0 +1,309 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_descriptor_allocator.h"
+#include "ppx/grfx/grfx_device.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ppx {
+namespace grfx {
+
+namespace {
+
+// Returns the pool count that descriptors of type \b type are taken from.
+uint32_t* GetPoolCount(grfx::DescriptorPoolCreateInfo& counts, grfx::DescriptorType type)
+{
+    switch (type) {
+        default: break;
+        case grfx::DESCRIPTOR_TYPE_SAMPLER                : return &counts.sampler;
+        case grfx::DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : return &counts.combinedImageSampler;
+        case grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE          : return &counts.sampledImage;
+        case grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE          : return &counts.storageImage;
+        case grfx::DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER   : return &counts.uniformTexelBuffer;
+        case grfx::DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER   : return &counts.storageTexelBuffer;
+        case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER         : return &counts.uniformBuffer;
+        case grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER     : return &counts.rawStorageBuffer;
+        case grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER   : return &counts.structuredBuffer;
+        case grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER   : return &counts.structuredBuffer;
+        case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : return &counts.uniformBufferDynamic;
+        case grfx::DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : return &counts.storageBufferDynamic;
+        case grfx::DESCRIPTOR_TYPE_INPUT_ATTACHMENT       : return &counts.inputAttachment;
+    }
+    return nullptr;
+}
+
+// Applies \b func to each pair of counts of \b a and \b b.
+template <typename CountsT, typename Func>
+void ForEachCount(CountsT& a, const grfx::DescriptorPoolCreateInfo& b, Func func)
+{
+    func(a.sampler, b.sampler);
+    func(a.combinedImageSampler, b.combinedImageSampler);
+    func(a.sampledImage, b.sampledImage);
+    func(a.storageImage, b.storageImage);
+    func(a.uniformTexelBuffer, b.uniformTexelBuffer);
+    func(a.storageTexelBuffer, b.storageTexelBuffer);
+    func(a.uniformBuffer, b.uniformBuffer);
+    func(a.rawStorageBuffer, b.rawStorageBuffer);
+    func(a.structuredBuffer, b.structuredBuffer);
+    func(a.uniformBufferDynamic, b.uniformBufferDynamic);
+    func(a.storageBufferDynamic, b.storageBufferDynamic);
+    func(a.inputAttachment, b.inputAttachment);
+}
+
+bool Fits(const grfx::DescriptorPoolCreateInfo& required, const grfx::DescriptorPoolCreateInfo& available)
+{
+    bool fits = true;
+    ForEachCount(required, available, [&fits](uint32_t count, uint32_t availableCount) { fits = fits && (count <= availableCount); });
+    return fits;
+}
+
+} // namespace
+
+Result FrameDescriptorAllocator::Create(grfx::Device* pDevice, const grfx::FrameDescriptorAllocatorCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_MSG(mFrames.empty(), "FrameDescriptorAllocator is already created");
+
+    if ((pCreateInfo->frameCount == 0) || (pCreateInfo->maxSetsPerPage == 0) || (pCreateInfo->maxSetsPerPage > PPX_MAX_SETS_PER_POOL)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mDevice     = pDevice;
+    mCreateInfo = *pCreateInfo;
+    mFrames.resize(pCreateInfo->frameCount);
+    mFrameIndex = 0;
+
+    return ppx::SUCCESS;
+}
+
+void FrameDescriptorAllocator::Destroy()
+{
+    for (auto& frame : mFrames) {
+        for (auto& page : frame.pages) {
+            DestroyPage(*page);
+        }
+    }
+    mFrames.clear();
+    mLayoutRequirements.clear();
+    mDevice.Reset();
+}
+
+void FrameDescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+    PPX_ASSERT_MSG(frameIndex < CountU32(mFrames), "frame index out of range");
+    mFrameIndex = frameIndex;
+
+    // Sets and cursors of the previous epoch are treated as unused the next
+    // time they are looked at, so they do not need to be reset here.
+    Frame& frame = mFrames[mFrameIndex];
+    ReleaseUnusedPages(frame);
+    frame.setCount = 0;
+    frame.epoch += 1;
+}
+
+Result FrameDescriptorAllocator::AllocateDescriptorSet(const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet)
+{
+    PPX_ASSERT_NULL_ARG(pLayout);
+    PPX_ASSERT_NULL_ARG(ppSet);
+    PPX_ASSERT_MSG(!mFrames.empty(), "FrameDescriptorAllocator is not created");
+
+    const grfx::DescriptorPoolCreateInfo* pRequired = GetLayoutRequirements(pLayout);
+    if (!Fits(*pRequired, mCreateInfo.pageSize)) {
+        PPX_ASSERT_MSG(false, "descriptor set layout does not fit in a FrameDescriptorAllocator page");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    Frame&         frame    = mFrames[mFrameIndex];
+    const uint64_t layoutId = pLayout->GetObjectId();
+
+    // Recycle a set allocated by a previous use of this frame
+    LayoutCursor& cursor = frame.cursors[layoutId];
+    if (cursor.epoch != frame.epoch) {
+        cursor.page  = 0;
+        cursor.epoch = frame.epoch;
+    }
+    for (; cursor.page < CountU32(frame.pages); ++cursor.page) {
+        auto it = frame.pages[cursor.page]->layouts.find(layoutId);
+        if (it == frame.pages[cursor.page]->layouts.end()) {
+            continue;
+        }
+        LayoutSets& sets = it->second;
+        if (sets.epoch != frame.epoch) {
+            sets.usedCount = 0;
+            sets.epoch     = frame.epoch;
+        }
+        if (sets.usedCount < CountU32(sets.sets)) {
+            *ppSet = sets.sets[sets.usedCount];
+            sets.usedCount += 1;
+            frame.setCount += 1;
+            return ppx::SUCCESS;
+        }
+    }
+
+    // Allocate a new set from the first page that has room for it. Every
+    // set of the layout in the pages is in use, so the new one is marked
+    // used as well.
+    for (uint32_t pageIndex = frame.firstFreePage;; ++pageIndex) {
+        if (pageIndex == CountU32(frame.pages)) {
+            Result ppxres = AddPage(frame);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+        }
+
+        Page& page = *frame.pages[pageIndex];
+        if ((page.remainingSets > 0) && Fits(*pRequired, page.remaining)) {
+            grfx::DescriptorSet* pSet   = nullptr;
+            Result               ppxres = AllocateSet(page.pool, pLayout, &pSet);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            ForEachCount(page.remaining, *pRequired, [](uint32_t& count, uint32_t requiredCount) { count -= requiredCount; });
+            page.remainingSets -= 1;
+
+            LayoutSets& sets = page.layouts[layoutId];
+            if (sets.epoch != frame.epoch) {
+                sets.usedCount = 0;
+                sets.epoch     = frame.epoch;
+            }
+            sets.sets.push_back(pSet);
+            sets.usedCount += 1;
+            frame.setCount += 1;
+            *ppSet = pSet;
+            return ppx::SUCCESS;
+        }
+
+        if ((page.remainingSets == 0) && (pageIndex == frame.firstFreePage)) {
+            frame.firstFreePage += 1;
+        }
+    }
+}
+
+uint32_t FrameDescriptorAllocator::GetPageCount() const
+{
+    uint32_t count = 0;
+    for (auto& frame : mFrames) {
+        count += CountU32(frame.pages);
+    }
+    return count;
+}
+
+uint32_t FrameDescriptorAllocator::GetFrameSetCount() const
+{
+    return mFrames.empty() ? 0 : mFrames[mFrameIndex].setCount;
+}
+
+Result FrameDescriptorAllocator::CreatePool(const grfx::DescriptorPoolCreateInfo* pCreateInfo, grfx::DescriptorPool** ppPool)
+{
+    PPX_ASSERT_MSG(mDevice, "FrameDescriptorAllocator has no device");
+    return mDevice->CreateDescriptorPool(pCreateInfo, ppPool);
+}
+
+void FrameDescriptorAllocator::DestroyPool(grfx::DescriptorPool* pPool)
+{
+    PPX_ASSERT_MSG(mDevice, "FrameDescriptorAllocator has no device");
+    mDevice->DestroyDescriptorPool(pPool);
+}
+
+Result FrameDescriptorAllocator::AllocateSet(grfx::DescriptorPool* pPool, const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet)
+{
+    PPX_ASSERT_MSG(mDevice, "FrameDescriptorAllocator has no device");
+    return mDevice->AllocateDescriptorSet(pPool, pLayout, ppSet);
+}
+
+void FrameDescriptorAllocator::FreeSet(grfx::DescriptorSet* pSet)
+{
+    PPX_ASSERT_MSG(mDevice, "FrameDescriptorAllocator has no device");
+    mDevice->FreeDescriptorSet(pSet);
+}
+
+const grfx::DescriptorPoolCreateInfo* FrameDescriptorAllocator::GetLayoutRequirements(const grfx::DescriptorSetLayout* pLayout)
+{
+    auto it = mLayoutRequirements.find(pLayout->GetObjectId());
+    if (it != mLayoutRequirements.end()) {
+        return &it->second;
+    }
+
+    grfx::DescriptorPoolCreateInfo required = {};
+    for (auto& binding : pLayout->GetBindings()) {
+        uint32_t* pCount = GetPoolCount(required, binding.type);
+        PPX_ASSERT_MSG(!IsNull(pCount), "unknown descriptor type: " << binding.type);
+        *pCount += binding.arrayCount;
+    }
+    return &mLayoutRequirements.emplace(pLayout->GetObjectId(), required).first->second;
+}
+
+void FrameDescriptorAllocator::ReleaseUnusedPages(Frame& frame)
+{
+    // A page none of whose sets were handed out the last time the frame was
+    // used only holds sets of layouts that were not used, such as destroyed
+    // ones, or that the other pages had enough sets for. The pools are not
+    // reset, so release the whole page to get its capacity back.
+    auto isUsed = [&frame](const std::unique_ptr<Page>& page) {
+        return std::any_of(page->layouts.begin(), page->layouts.end(), [&frame](const auto& it) {
+            return (it.second.epoch == frame.epoch) && (it.second.usedCount > 0);
+        });
+    };
+    auto unusedBegin = std::stable_partition(frame.pages.begin(), frame.pages.end(), isUsed);
+    if (unusedBegin != frame.pages.end()) {
+        PPX_LOG_DEBUG("FrameDescriptorAllocator: released " << (frame.pages.end() - unusedBegin) << " pages of frame " << (&frame - mFrames.data()));
+        for (auto it = unusedBegin; it != frame.pages.end(); ++it) {
+            DestroyPage(**it);
+        }
+        frame.pages.erase(unusedBegin, frame.pages.end());
+        frame.firstFreePage = 0;
+    }
+
+    // Forget the layouts that the frame did not use, and the requirements of
+    // layouts that no frame used.
+    for (auto it = frame.cursors.begin(); it != frame.cursors.end();) {
+        it = (it->second.epoch == frame.epoch) ? std::next(it) : frame.cursors.erase(it);
+    }
+    for (auto it = mLayoutRequirements.begin(); it != mLayoutRequirements.end();) {
+        bool used = std::any_of(mFrames.begin(), mFrames.end(), [&it](const Frame& otherFrame) {
+            return otherFrame.cursors.find(it->first) != otherFrame.cursors.end();
+        });
+        it = used ? std::next(it) : mLayoutRequirements.erase(it);
+    }
+}
+
+void FrameDescriptorAllocator::DestroyPage(Page& page)
+{
+    for (auto& it : page.layouts) {
+        for (grfx::DescriptorSet* pSet : it.second.sets) {
+            FreeSet(pSet);
+        }
+    }
+    DestroyPool(page.pool);
+}
+
+Result FrameDescriptorAllocator::AddPage(Frame& frame)
+{
+    auto   page   = std::make_unique<Page>();
+    Result ppxres = CreatePool(&mCreateInfo.pageSize, &page->pool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    page->remaining     = mCreateInfo.pageSize;
+    page->remainingSets = mCreateInfo.maxSetsPerPage;
+    frame.pages.push_back(std::move(page));
+
+    PPX_LOG_DEBUG("FrameDescriptorAllocator: added page " << frame.pages.size() << " to frame " << (&frame - mFrames.data()));
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -15,6 +15,9 @@
 #include "ppx/grfx/grfx_device.h"
 #include "ppx/grfx/grfx_gpu.h"
 #include "ppx/grfx/grfx_instance.h"
+#include "ppx/timer.h"
+
+#include <thread>
 
 namespace ppx {
 namespace grfx {
@@ -32,6 +35,9 @@ Result Device::Create(const grfx::DeviceCreateInfo* pCreateInfo)
 
 void Device::Destroy()
 {
+    // Stop compiling pipelines before the objects they use go away
+    mPipelineCompilePool.Destroy();
+
     // Destroy queues first to clear any pending work
     DestroyAllObjects(mGraphicsQueues);
     DestroyAllObjects(mComputeQueues);
@@ -115,32 +121,56 @@ Result Device::CreateObject(const CreateInfoT* pCreateInfo, ContainerT& containe
         return ppxres;
     }
     // Store
-    container.push_back(ObjPtr<ObjectT>(pObject));
+    StoreObject(container, pObject);
     // Assign
     *ppObject = pObject;
     // Success
     return ppx::SUCCESS;
 }
 
-template <
-    typename ObjectT,
-    typename ContainerT>
-void Device::DestroyObject(ContainerT& container, const ObjectT* pObject)
-{
-    // Make sure object is in container
-    auto it = std::find_if(
-        std::begin(container),
-        std::end(container),
-        [pObject](const ObjPtr<ObjectT>& elem) -> bool {
-            bool res = (elem == pObject);
-            return res; });
-    if (it == std::end(container)) {
+template <typename ObjectT>
+void Device::StoreObject(std::vector<ObjPtr<ObjectT>>& container, ObjectT* pObject)
+{
+    container.push_back(ObjPtr<ObjectT>(pObject));
+}
+
+template <typename ObjectT>
+void Device::StoreObject(grfx::ObjectRegistry<ObjectT>& container, ObjectT* pObject)
+{
+    std::lock_guard<std::mutex> lock(mRegistryMutex);
+    pObject->mRegistryHandle = container.Insert(ObjPtr<ObjectT>(pObject));
+    mRegisteredObjects.insert(pObject);
+}
+
+template <typename ObjectT>
+void Device::DestroyObject(grfx::ObjectRegistry<ObjectT>& container, const ObjectT* pObject)
+{
+    if (IsNull(pObject)) {
         return;
     }
-    // Copy pointer
-    ObjPtr<ObjectT> object = *it;
-    // Remove object pointer from container
-    RemoveElement(object, container);
+
+    ObjPtr<ObjectT> object;
+    {
+        std::lock_guard<std::mutex> lock(mRegistryMutex);
+        // Objects already destroyed, by a previous call or by Destroy() before
+        // their owner releases them, are no longer registered and their memory
+        // may be gone, so check the address before reading the handle.
+        auto it = mRegisteredObjects.find(pObject);
+        if (it == mRegisteredObjects.end()) {
+            return;
+        }
+        // Make sure object is in container
+        const SlotHandle       handle = pObject->mRegistryHandle;
+        const ObjPtr<ObjectT>* pElem  = container.Get(handle);
+        if (IsNull(pElem) || (pElem->Get() != pObject)) {
+            return;
+        }
+        // Copy pointer
+        object = *pElem;
+        // Remove object pointer from container
+        container.Remove(handle);
+        mRegisteredObjects.erase(it);
+    }
     // Destroy internal objects
     object->Destroy();
     // Delete allocation
@@ -165,6 +195,157 @@ void Device::DestroyAllObjects(std::vector<ObjPtr<ObjectT>>& container)
     container.clear();
 }
 
+template <typename ObjectT>
+void Device::DestroyAllObjects(grfx::ObjectRegistry<ObjectT>& container)
+{
+    // Objects can destroy other objects of the same type, so remove each one
+    // before destroying it.
+    for (uint32_t i = 0; i < container.GetSlotCount(); ++i) {
+        const SlotHandle handle = container.GetHandle(i);
+        if (!handle.IsValid()) {
+            continue;
+        }
+        // Get object pointer
+        ObjPtr<ObjectT> object = *container.Get(handle);
+        {
+            std::lock_guard<std::mutex> lock(mRegistryMutex);
+            container.Remove(handle);
+            mRegisteredObjects.erase(object.Get());
+        }
+        // Destroy internal objects
+        object->Destroy();
+        // Delete allocation
+        ObjectT* ptr = object.Get();
+        delete ptr;
+    }
+}
+
+template <typename ObjectT, typename CreateInfoT>
+Result Device::CreatePipeline(const CreateInfoT* pCreateInfo, grfx::ObjectRegistry<ObjectT>& container, ObjectT** ppObject)
+{
+    uint64_t startTimestamp = 0;
+    uint64_t endTimestamp   = 0;
+    Timer::Timestamp(&startTimestamp);
+    Result ppxres = CreateObject(pCreateInfo, container, ppObject);
+    Timer::Timestamp(&endTimestamp);
+    if (Success(ppxres)) {
+        mPipelineCreationCount += 1;
+        mPipelineCreationTicks += (endTimestamp - startTimestamp);
+    }
+    return ppxres;
+}
+
+double Device::GetPipelineCreationTimeMs() const
+{
+    return Timer::TimestampToMillis(mPipelineCreationTicks);
+}
+
+Result Device::StartPipelineCompilation(const std::shared_ptr<grfx::internal::PipelineCompileJob>& job, int32_t priority, grfx::PipelineCompileHandle* pHandle)
+{
+    if (!mPipelineCompilePool.IsCreated()) {
+        // Leave a core to the thread submitting the frames
+        uint32_t threadCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 2) - 1;
+        Result   ppxres      = mPipelineCompilePool.Create(threadCount);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        PPX_LOG_INFO("Started " << threadCount << " pipeline compilation threads");
+    }
+
+    job->task     = mPipelineCompilePool.Submit([this, job]() { CompilePipeline(job.get()); }, priority);
+    pHandle->mJob = job;
+    return ppx::SUCCESS;
+}
+
+void Device::CompilePipeline(grfx::internal::PipelineCompileJob* pJob)
+{
+    // Canceled after the task started
+    {
+        std::lock_guard<std::mutex> lock(pJob->mutex);
+        if (pJob->cancelRequested) {
+            pJob->result = ppx::ERROR_CANCELED;
+            return;
+        }
+    }
+
+    if (pJob->compute) {
+        pJob->result = CreatePipeline(&pJob->computeCreateInfo, mComputePipelines, &pJob->pComputePipeline);
+    }
+    else {
+        grfx::GraphicsPipelineCreateInfo createInfo = {};
+        grfx::internal::FillOutGraphicsPipelineCreateInfo(&pJob->graphicsCreateInfo, &createInfo);
+        pJob->result = CreatePipeline(&createInfo, mGraphicsPipelines, &pJob->pGraphicsPipeline);
+    }
+
+    if (Failed(pJob->result)) {
+        PPX_LOG_WARN("Asynchronous pipeline compilation failed: " << ppx::ToString(pJob->result));
+        return;
+    }
+
+    // Publish the pipeline unless the compilation was canceled while running
+    bool canceled = false;
+    {
+        std::lock_guard<std::mutex> lock(pJob->mutex);
+        canceled = pJob->cancelRequested;
+        if (!canceled) {
+            pJob->ready = true;
+        }
+    }
+    if (canceled) {
+        if (pJob->compute) {
+            DestroyComputePipeline(pJob->pComputePipeline);
+            pJob->pComputePipeline = nullptr;
+        }
+        else {
+            DestroyGraphicsPipeline(pJob->pGraphicsPipeline);
+            pJob->pGraphicsPipeline = nullptr;
+        }
+        pJob->result = ppx::ERROR_CANCELED;
+    }
+}
+
+Result Device::CompileGraphicsPipelinesAsync(uint32_t count, const grfx::GraphicsPipelineCreateInfo2* pCreateInfos, int32_t priority, grfx::PipelineCompileHandle* pHandles)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfos);
+    PPX_ASSERT_NULL_ARG(pHandles);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        auto job                = std::make_shared<grfx::internal::PipelineCompileJob>();
+        job->graphicsCreateInfo = pCreateInfos[i];
+
+        Result ppxres = StartPipelineCompilation(job, priority, &pHandles[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+Result Device::CompileComputePipelinesAsync(uint32_t count, const grfx::ComputePipelineCreateInfo* pCreateInfos, int32_t priority, grfx::PipelineCompileHandle* pHandles)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfos);
+    PPX_ASSERT_NULL_ARG(pHandles);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        auto job               = std::make_shared<grfx::internal::PipelineCompileJob>();
+        job->compute           = true;
+        job->computeCreateInfo = pCreateInfos[i];
+
+        Result ppxres = StartPipelineCompilation(job, priority, &pHandles[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+void Device::WaitPipelineCompilation()
+{
+    if (mPipelineCompilePool.IsCreated()) {
+        mPipelineCompilePool.WaitIdle();
+    }
+}
+
 Result Device::AllocateObject(grfx::DrawPass** ppObject)
 {
     grfx::DrawPass* pObject = new grfx::DrawPass();
@@ -255,7 +436,7 @@ Result Device::CreateComputePipeline(const grfx::ComputePipelineCreateInfo* pCre
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
     PPX_ASSERT_NULL_ARG(ppComputePipeline);
-    return CreateObject(pCreateInfo, mComputePipelines, ppComputePipeline);
+    return CreatePipeline(pCreateInfo, mComputePipelines, ppComputePipeline);
 }
 
 void Device::DestroyComputePipeline(const grfx::ComputePipeline* pComputePipeline)
@@ -382,7 +563,7 @@ Result Device::CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo* pC
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
     PPX_ASSERT_NULL_ARG(ppGraphicsPipeline);
-    return CreateObject(pCreateInfo, mGraphicsPipelines, ppGraphicsPipeline);
+    return CreatePipeline(pCreateInfo, mGraphicsPipelines, ppGraphicsPipeline);
 }
 
 Result Device::CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo2* pCreateInfo, grfx::GraphicsPipeline** ppGraphicsPipeline)
@@ -393,7 +574,7 @@ Result Device::CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo2* p
     grfx::GraphicsPipelineCreateInfo createInfo = {};
     grfx::internal::FillOutGraphicsPipelineCreateInfo(pCreateInfo, &createInfo);
 
-    return CreateObject(&createInfo, mGraphicsPipelines, ppGraphicsPipeline);
+    return CreatePipeline(&createInfo, mGraphicsPipelines, ppGraphicsPipeline);
 }
 
 void Device::DestroyGraphicsPipeline(const grfx::GraphicsPipeline* pGraphicsPipeline)
@@ -666,6 +847,48 @@ void Device::FreeDescriptorSet(const grfx::DescriptorSet* pSet)
     DestroyObject(mDescriptorSets, pSet);
 }
 
+Result Device::UpdateDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites)
+{
+    if (writeCount == 0) {
+        return ppx::SUCCESS;
+    }
+    PPX_ASSERT_NULL_ARG(pWrites);
+
+    Result ppxres = UpdateApiDescriptorSets(writeCount, pWrites);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        pWrites[i].pSet->RecordWrite(pWrites[i].write);
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Device::UpdateApiDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites)
+{
+    std::vector<grfx::WriteDescriptor> setWrites;
+    for (uint32_t first = 0; first < writeCount;) {
+        grfx::DescriptorSet* pSet = pWrites[first].pSet;
+        PPX_ASSERT_NULL_ARG(pSet);
+
+        setWrites.clear();
+        uint32_t end = first;
+        while ((end < writeCount) && (pWrites[end].pSet == pSet)) {
+            setWrites.push_back(pWrites[end].write);
+            ++end;
+        }
+
+        Result ppxres = pSet->UpdateApiDescriptors(CountU32(setWrites), DataPtr(setWrites));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        first = end;
+    }
+    return ppx::SUCCESS;
+}
+
 Result Device::CreateGraphicsQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
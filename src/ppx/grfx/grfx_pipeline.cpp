@@ -404,5 +404,71 @@ const grfx::DescriptorSetLayout* PipelineInterface::GetSetLayout(uint32_t setNum
     return pLayout;
 }
 
+// -------------------------------------------------------------------------------------------------
+// PipelineCompileHandle
+// -------------------------------------------------------------------------------------------------
+bool PipelineCompileHandle::IsReady() const
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid pipeline compile handle");
+    return mJob->ready;
+}
+
+bool PipelineCompileHandle::IsDone() const
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid pipeline compile handle");
+    return mJob->task.IsDone();
+}
+
+Result PipelineCompileHandle::Wait() const
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid pipeline compile handle");
+    mJob->task.Wait();
+    return GetResult();
+}
+
+Result PipelineCompileHandle::GetResult() const
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid pipeline compile handle");
+    ppx::TaskStatus status = mJob->task.GetStatus();
+    if (status == ppx::TASK_STATUS_CANCELED) {
+        return ppx::ERROR_CANCELED;
+    }
+    if (status == ppx::TASK_STATUS_COMPLETE) {
+        return mJob->result;
+    }
+    return ppx::ERROR_FAILED;
+}
+
+void PipelineCompileHandle::Cancel()
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid pipeline compile handle");
+    {
+        std::lock_guard<std::mutex> lock(mJob->mutex);
+        if (mJob->ready) {
+            return;
+        }
+        mJob->cancelRequested = true;
+    }
+    mJob->task.Cancel();
+}
+
+void PipelineCompileHandle::SetPriority(int32_t priority)
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid pipeline compile handle");
+    mJob->task.SetPriority(priority);
+}
+
+grfx::GraphicsPipeline* PipelineCompileHandle::GetGraphicsPipeline(grfx::GraphicsPipeline* pFallback) const
+{
+    PPX_ASSERT_MSG(IsValid() && !mJob->compute, "invalid graphics pipeline compile handle");
+    return mJob->ready ? mJob->pGraphicsPipeline : pFallback;
+}
+
+grfx::ComputePipeline* PipelineCompileHandle::GetComputePipeline(grfx::ComputePipeline* pFallback) const
+{
+    PPX_ASSERT_MSG(IsValid() && mJob->compute, "invalid compute pipeline compile handle");
+    return mJob->ready ? mJob->pComputePipeline : pFallback;
+}
+
 } // namespace grfx
 } // namespace ppx
@@ -14,20 +14,27 @@
 
 #include "ppx/grfx/grfx_text_draw.h"
 #include "ppx/grfx/grfx_device.h"
-#include "ppx/bitmap.h"
+#include "ppx/bitmap_atlas.h"
 #include "ppx/graphics_util.h"
+#include "ppx/util.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
 
 #include "utf8.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace ppx {
 namespace grfx {
 
 // -------------------------------------------------------------------------------------------------
 // TextureFont
 // -------------------------------------------------------------------------------------------------
+constexpr float kSubpixelShiftX = 0.5f;
+constexpr float kSubpixelShiftY = 0.5f;
+
 std::string TextureFont::GetDefaultCharacters()
 {
     std::string characters;
@@ -52,9 +59,13 @@ Result TextureFont::CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateI
     // Font metrics
     pCreateInfo->font.GetFontMetrics(pCreateInfo->size, &mFontMetrics);
 
+    if (pCreateInfo->dynamicGlyphs) {
+        return CreateDynamicGlyphCache(pCreateInfo, characters);
+    }
+
     // Subpixel shift
-    float subpixelShiftX = 0.5f;
-    float subpixelShiftY = 0.5f;
+    float subpixelShiftX = kSubpixelShiftX;
+    float subpixelShiftY = kSubpixelShiftY;
 
     // Get glyph metrics and max bounds
     utf8::iterator<std::string::iterator> it(characters.begin(), characters.begin(), characters.end());
@@ -77,61 +88,62 @@ Result TextureFont::CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateI
         mGlyphMetrics.emplace_back(grfx::TextureFontGlyphMetrics{codepoint, metrics});
     }
 
-    // Figure out a squarish somewhat texture size
-    const size_t  nc           = characters.size();
-    const int32_t sqrtnc       = static_cast<int32_t>(sqrtf(static_cast<float>(nc)) + 0.5f) + 1;
-    int32_t       bitmapWidth  = 0;
-    int32_t       bitmapHeight = 0;
-    size_t        glyphIndex   = 0;
-    for (int32_t i = 0; (i < sqrtnc) && (glyphIndex < nc); ++i) {
-        int32_t height = 0;
-        int32_t width  = 0;
-        for (int32_t j = 0; (j < sqrtnc) && (glyphIndex < nc); ++j, ++glyphIndex) {
-            const GlyphMetrics& metrics = mGlyphMetrics[glyphIndex].glyphMetrics;
-            int32_t             w       = (metrics.box.x1 - metrics.box.x0) + 1;
-            int32_t             h       = (metrics.box.y1 - metrics.box.y0) + 1;
-            width                       = width + w;
-            height                      = std::max<int32_t>(height, h);
+    // Pack the glyphs tallest first, starting from a square atlas a bit
+    // larger than their total area and growing it until they all fit.
+    const uint32_t        glyphCount = CountU32(mGlyphMetrics);
+    std::vector<uint32_t> glyphOrder(glyphCount);
+    std::vector<uint2>    glyphSizes(glyphCount);
+    uint64_t              totalArea = 0;
+    for (uint32_t i = 0; i < glyphCount; ++i) {
+        const GlyphMetrics& metrics = mGlyphMetrics[i].glyphMetrics;
+        glyphOrder[i]               = i;
+        glyphSizes[i].x             = static_cast<uint32_t>(metrics.box.x1 - metrics.box.x0) + 1;
+        glyphSizes[i].y             = static_cast<uint32_t>(metrics.box.y1 - metrics.box.y0) + 1;
+        totalArea += static_cast<uint64_t>(glyphSizes[i].x + 2) * (glyphSizes[i].y + 2);
+    }
+    std::sort(glyphOrder.begin(), glyphOrder.end(), [&glyphSizes](uint32_t a, uint32_t b) {
+        return glyphSizes[a].y > glyphSizes[b].y;
+    });
+
+    // One pixel gutter so that bilinear filtering does not bleed between glyphs.
+    BitmapAtlasCreateInfo atlasCreateInfo = {};
+    atlasCreateInfo.width                 = static_cast<uint32_t>(sqrtf(1.1f * static_cast<float>(totalArea))) + 1;
+    atlasCreateInfo.height                = atlasCreateInfo.width;
+    atlasCreateInfo.format                = Bitmap::FORMAT_R_UINT8;
+    atlasCreateInfo.padding               = 1;
+
+    BitmapAtlas             atlas;
+    std::vector<AtlasEntry> entries(glyphCount);
+    for (;;) {
+        ppx::Result ppxres = BitmapAtlas::Create(atlasCreateInfo, &atlas);
+        if (Failed(ppxres)) {
+            return ppxres;
         }
-        bitmapWidth  = std::max<int32_t>(bitmapWidth, width);
-        bitmapHeight = bitmapHeight + height;
-    }
 
-    // Storage bitmap
-    Bitmap bitmap = Bitmap::Create(bitmapWidth, bitmapHeight, Bitmap::Format::FORMAT_R_UINT8);
+        bool allFit = true;
+        for (uint32_t i = 0; (i < glyphCount) && allFit; ++i) {
+            const uint32_t glyphIndex = glyphOrder[i];
+            allFit                    = (atlas.Allocate(glyphSizes[glyphIndex].x, glyphSizes[glyphIndex].y, &entries[glyphIndex]) == ppx::SUCCESS);
+        }
+        if (allFit) {
+            break;
+        }
+        atlasCreateInfo.width += std::max<uint32_t>(atlasCreateInfo.width / 4, 1);
+        atlasCreateInfo.height = atlasCreateInfo.width;
+    }
 
     // Render glyph bitmaps
-    const float    invBitmapWidth  = 1.0f / static_cast<float>(bitmapWidth);
-    const float    invBitmapHeight = 1.0f / static_cast<float>(bitmapHeight);
-    const uint32_t rowStride       = bitmap.GetRowStride();
-    const uint32_t pixelStride     = bitmap.GetPixelStride();
-    uint32_t       y               = 0;
-    glyphIndex                     = 0;
-    for (int32_t i = 0; (i < sqrtnc) && (glyphIndex < nc); ++i) {
-        uint32_t x      = 0;
-        uint32_t height = 0;
-        for (int32_t j = 0; (j < sqrtnc) && (glyphIndex < nc); ++j, ++glyphIndex) {
-            uint32_t            codepoint = mGlyphMetrics[glyphIndex].codepoint;
-            const GlyphMetrics& metrics   = mGlyphMetrics[glyphIndex].glyphMetrics;
-            uint32_t            w         = static_cast<uint32_t>(metrics.box.x1 - metrics.box.x0) + 1;
-            uint32_t            h         = static_cast<uint32_t>(metrics.box.y1 - metrics.box.y0) + 1;
-
-            uint32_t offset  = (y * rowStride) + (x * pixelStride);
-            char*    pOutput = bitmap.GetData() + offset;
-            pCreateInfo->font.RenderGlyphBitmap(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, w, h, rowStride, reinterpret_cast<unsigned char*>(pOutput));
-
-            mGlyphMetrics[glyphIndex].size.x = static_cast<float>(w);
-            mGlyphMetrics[glyphIndex].size.y = static_cast<float>(h);
-
-            mGlyphMetrics[glyphIndex].uvRect.u0 = x * invBitmapWidth;
-            mGlyphMetrics[glyphIndex].uvRect.v0 = y * invBitmapHeight;
-            mGlyphMetrics[glyphIndex].uvRect.u1 = (x + w - 1) * invBitmapWidth;
-            mGlyphMetrics[glyphIndex].uvRect.v1 = (y + h - 1) * invBitmapHeight;
-
-            x      = x + w;
-            height = std::max<int32_t>(height, h);
-        }
-        y += height;
+    Bitmap&        bitmap    = *atlas.GetBitmap();
+    const uint32_t rowStride = bitmap.GetRowStride();
+    for (uint32_t glyphIndex = 0; glyphIndex < glyphCount; ++glyphIndex) {
+        const AtlasEntry& entry     = entries[glyphIndex];
+        uint32_t          codepoint = mGlyphMetrics[glyphIndex].codepoint;
+        char*             pOutput   = bitmap.GetPixelAddress(entry.rect.x, entry.rect.y);
+        pCreateInfo->font.RenderGlyphBitmap(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, entry.rect.width, entry.rect.height, rowStride, reinterpret_cast<unsigned char*>(pOutput));
+
+        mGlyphMetrics[glyphIndex].size.x = static_cast<float>(entry.rect.width);
+        mGlyphMetrics[glyphIndex].size.y = static_cast<float>(entry.rect.height);
+        mGlyphMetrics[glyphIndex].uvRect = entry.uvRect;
     }
 
     ppx::Result ppxres = grfx_util::CreateTextureFromBitmap(GetDevice()->GetGraphicsQueue(), &bitmap, &mTexture);
@@ -145,16 +157,227 @@ Result TextureFont::CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateI
     return ppx::SUCCESS;
 }
 
+Result TextureFont::CreateDynamicGlyphCache(const grfx::TextureFontCreateInfo* pCreateInfo, const std::string& characters)
+{
+    if ((pCreateInfo->maxGlyphUploadsPerFrame == 0) || (pCreateInfo->stagingFrameCount == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Cells fit the tallest glyphs of the font plus a gutter. Wider glyphs
+    // are clipped.
+    const uint32_t padding  = 1;
+    const uint32_t cellSize = static_cast<uint32_t>(ceilf(mFontMetrics.ascent - mFontMetrics.descent)) + 1 + 2 * padding;
+
+    // The font is copied into the callback so that the thread does not
+    // depend on mCreateInfo.
+    GlyphCacheCreateInfo cacheCreateInfo = {};
+    cacheCreateInfo.width                = pCreateInfo->cacheTextureSize;
+    cacheCreateInfo.height               = pCreateInfo->cacheTextureSize;
+    cacheCreateInfo.cellWidth            = cellSize;
+    cacheCreateInfo.cellHeight           = cellSize;
+    cacheCreateInfo.padding              = padding;
+    cacheCreateInfo.rasterize            = [font = pCreateInfo->font, size = pCreateInfo->size](uint32_t codepoint, uint32_t width, uint32_t height, uint32_t rowStride, unsigned char* pOutput) {
+        font.RenderGlyphBitmap(size, codepoint, kSubpixelShiftX, kSubpixelShiftY, width, height, rowStride, pOutput);
+    };
+
+    ppx::Result ppxres = mGlyphCache.Create(cacheCreateInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    mSlotMetrics.resize(mGlyphCache.GetSlotCount());
+
+    // Cache texture, filled as glyphs are uploaded
+    {
+        grfx::TextureCreateInfo createInfo     = {};
+        createInfo.imageType                   = grfx::IMAGE_TYPE_2D;
+        createInfo.width                       = pCreateInfo->cacheTextureSize;
+        createInfo.height                      = pCreateInfo->cacheTextureSize;
+        createInfo.depth                       = 1;
+        createInfo.imageFormat                 = grfx::FORMAT_R8_UNORM;
+        createInfo.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount               = 1;
+        createInfo.arrayLayerCount             = 1;
+        createInfo.usageFlags.bits.transferDst = true;
+        createInfo.usageFlags.bits.sampled     = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        ppxres = GetDevice()->CreateTexture(&createInfo, &mTexture);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Staging buffer with room for maxGlyphUploadsPerFrame cells per frame
+    {
+        const bool     isDx12          = grfx::IsDx12(GetDevice()->GetApi());
+        const uint32_t rowAlignment    = isDx12 ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
+        const uint32_t offsetAlignment = isDx12 ? PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : 1;
+        mStagingRowStride              = RoundUp<uint32_t>(cellSize, rowAlignment);
+        mStagingGlyphSize              = RoundUp<uint64_t>(static_cast<uint64_t>(mStagingRowStride) * cellSize, offsetAlignment);
+        mStagingFrameIndex             = 0;
+
+        grfx::BufferCreateInfo createInfo      = {};
+        createInfo.size                        = mStagingGlyphSize * pCreateInfo->maxGlyphUploadsPerFrame * pCreateInfo->stagingFrameCount;
+        createInfo.usageFlags.bits.transferSrc = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+
+        ppxres = GetDevice()->CreateBuffer(&createInfo, &mStagingBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Start rasterizing the requested characters, or the printable ASCII
+    // ones if none were requested. Others are cached on first use.
+    auto it = characters.begin();
+    while (it != characters.end()) {
+        grfx::TextureFontGlyphRef ref      = {};
+        bool                      resident = false;
+        AcquireGlyph(utf8::next(it, characters.end()), &ref, &resident);
+    }
+
+    return ppx::SUCCESS;
+}
+
 void TextureFont::DestroyApiObjects()
 {
+    mGlyphCache.Destroy();
+    mSlotMetrics.clear();
+    mRasterizedGlyphs.clear();
+
+    if (mStagingBuffer) {
+        GetDevice()->DestroyBuffer(mStagingBuffer);
+        mStagingBuffer.Reset();
+    }
+
     if (mTexture) {
         GetDevice()->DestroyTexture(mTexture);
         mTexture.Reset();
     }
 }
 
+const grfx::TextureFontGlyphMetrics* TextureFont::AcquireGlyph(uint32_t codepoint, grfx::TextureFontGlyphRef* pRef, bool* pResident)
+{
+    PPX_ASSERT_NULL_ARG(pRef);
+    PPX_ASSERT_NULL_ARG(pResident);
+    if (!IsDynamic()) {
+        *pRef      = {};
+        *pResident = true;
+        return GetGlyphMetrics(codepoint);
+    }
+
+    uint32_t slot = mGlyphCache.Find(codepoint);
+    if (slot != GlyphCache::kInvalidSlot) {
+        mGlyphCache.Acquire(codepoint, 0, 0);
+    }
+    else {
+        GlyphMetrics metrics = {};
+        mCreateInfo.font.GetGlyphMetrics(mCreateInfo.size, codepoint, kSubpixelShiftX, kSubpixelShiftY, &metrics);
+
+        const GlyphCacheCreateInfo& cacheCreateInfo = mGlyphCache.GetCreateInfo();
+        const uint32_t              maxWidth        = cacheCreateInfo.cellWidth - 2 * cacheCreateInfo.padding;
+        const uint32_t              maxHeight       = cacheCreateInfo.cellHeight - 2 * cacheCreateInfo.padding;
+        const uint32_t              width           = std::min<uint32_t>(static_cast<uint32_t>(metrics.box.x1 - metrics.box.x0) + 1, maxWidth);
+        const uint32_t              height          = std::min<uint32_t>(static_cast<uint32_t>(metrics.box.y1 - metrics.box.y0) + 1, maxHeight);
+
+        slot = mGlyphCache.Acquire(codepoint, width, height);
+        if (slot == GlyphCache::kInvalidSlot) {
+            return nullptr;
+        }
+
+        grfx::TextureFontGlyphMetrics& slotMetrics = mSlotMetrics[slot];
+        slotMetrics.codepoint                      = codepoint;
+        slotMetrics.glyphMetrics                   = metrics;
+        slotMetrics.size                           = float2(static_cast<float>(width), static_cast<float>(height));
+        slotMetrics.uvRect                         = mGlyphCache.GetGlyphUVRect(slot);
+    }
+
+    pRef->slot       = slot;
+    pRef->generation = mGlyphCache.GetGeneration(slot);
+    *pResident       = mGlyphCache.IsResident(slot);
+    return &mSlotMetrics[slot];
+}
+
+bool TextureFont::TouchGlyph(const grfx::TextureFontGlyphRef& ref)
+{
+    if (!IsDynamic() || (ref.slot == GlyphCache::kInvalidSlot)) {
+        return true;
+    }
+    return mGlyphCache.Touch(ref.slot, ref.generation);
+}
+
+ppx::Result TextureFont::UploadGlyphs(grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    if (!IsDynamic()) {
+        return ppx::SUCCESS;
+    }
+
+    // Map before taking the glyphs, which marks them resident.
+    void*       pMappedAddress = nullptr;
+    ppx::Result ppxres         = mStagingBuffer->MapMemory(0, &pMappedAddress);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    mRasterizedGlyphs.clear();
+    mGlyphCache.TakeRasterizedGlyphs(mCreateInfo.maxGlyphUploadsPerFrame, &mRasterizedGlyphs);
+
+    // Each frame writes its own part of the staging buffer, so that the
+    // copies of the previous frames can still be in flight.
+    const uint64_t frameOffset = static_cast<uint64_t>(mStagingFrameIndex) * mCreateInfo.maxGlyphUploadsPerFrame * mStagingGlyphSize;
+    mGlyphCopyInfos.resize(mRasterizedGlyphs.size());
+    for (size_t i = 0; i < mRasterizedGlyphs.size(); ++i) {
+        const RasterizedGlyph& glyph  = mRasterizedGlyphs[i];
+        const uint64_t         offset = frameOffset + i * mStagingGlyphSize;
+        char*                  pDst   = static_cast<char*>(pMappedAddress) + offset;
+        for (uint32_t y = 0; y < glyph.cellRect.height; ++y) {
+            memcpy(pDst + y * mStagingRowStride, glyph.pixels.data() + y * glyph.cellRect.width, glyph.cellRect.width);
+        }
+
+        grfx::BufferToImageCopyInfo& copyInfo = mGlyphCopyInfos[i];
+        copyInfo                              = {};
+        copyInfo.srcBuffer.imageWidth         = glyph.cellRect.width;
+        copyInfo.srcBuffer.imageHeight        = glyph.cellRect.height;
+        copyInfo.srcBuffer.imageRowStride     = mStagingRowStride;
+        copyInfo.srcBuffer.footprintOffset    = offset;
+        copyInfo.srcBuffer.footprintWidth     = glyph.cellRect.width;
+        copyInfo.srcBuffer.footprintHeight    = glyph.cellRect.height;
+        copyInfo.srcBuffer.footprintDepth     = 1;
+        copyInfo.dstImage.mipLevel            = 0;
+        copyInfo.dstImage.arrayLayer          = 0;
+        copyInfo.dstImage.arrayLayerCount     = 1;
+        copyInfo.dstImage.x                   = glyph.cellRect.x;
+        copyInfo.dstImage.y                   = glyph.cellRect.y;
+        copyInfo.dstImage.z                   = 0;
+        copyInfo.dstImage.width               = glyph.cellRect.width;
+        copyInfo.dstImage.height              = glyph.cellRect.height;
+        copyInfo.dstImage.depth               = 1;
+    }
+    mStagingBuffer->UnmapMemory();
+
+    // All the glyphs of the frame are copied between a single pair of barriers.
+    if (!mGlyphCopyInfos.empty()) {
+        grfx::Image* pImage = mTexture->GetImage();
+        pCommandBuffer->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_COPY_DST);
+        pCommandBuffer->CopyBufferToImage(mGlyphCopyInfos, mStagingBuffer, pImage);
+        pCommandBuffer->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mStagingFrameIndex = (mStagingFrameIndex + 1) % mCreateInfo.stagingFrameCount;
+    }
+
+    mGlyphCache.NextFrame();
+    return ppx::SUCCESS;
+}
+
 const grfx::TextureFontGlyphMetrics* TextureFont::GetGlyphMetrics(uint32_t codepoint) const
 {
+    if (IsDynamic()) {
+        const uint32_t slot = mGlyphCache.Find(codepoint);
+        return (slot != GlyphCache::kInvalidSlot) ? &mSlotMetrics[slot] : nullptr;
+    }
+
     const grfx::TextureFontGlyphMetrics* ptr = nullptr;
     auto                                 it  = FindIf(
         mGlyphMetrics,
@@ -170,16 +393,6 @@ const grfx::TextureFontGlyphMetrics* TextureFont::GetGlyphMetrics(uint32_t codep
 // -------------------------------------------------------------------------------------------------
 // TextDraw
 // -------------------------------------------------------------------------------------------------
-struct Vertex
-{
-    float2   position;
-    float2   uv;
-    uint32_t rgba;
-};
-
-constexpr size_t kGlyphIndicesSize  = 6 * sizeof(uint32_t);
-constexpr size_t kGlyphVerticesSize = 4 * sizeof(Vertex);
-
 static grfx::SamplerPtr sSampler;
 
 Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
@@ -205,6 +418,26 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
             return ppxres;
         }
 
+        // Every glyph is a quad, so the indices never change.
+        void* pMappedAddress = nullptr;
+        ppxres               = mCpuIndexBuffer->MapMemory(0, &pMappedAddress);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed mapping CPU index buffer");
+            return ppxres;
+        }
+        uint32_t* pIndices = static_cast<uint32_t*>(pMappedAddress);
+        for (uint32_t i = 0; i < pCreateInfo->maxTextLength; ++i, pIndices += 6) {
+            const uint32_t vertexCount = i * 4;
+            pIndices[0]                = vertexCount + 0;
+            pIndices[1]                = vertexCount + 1;
+            pIndices[2]                = vertexCount + 2;
+            pIndices[3]                = vertexCount + 0;
+            pIndices[4]                = vertexCount + 2;
+            pIndices[5]                = vertexCount + 3;
+        }
+        mCpuIndexBuffer->UnmapMemory();
+        mUploadedIndexGlyphCount = 0;
+
         createInfo.usageFlags.bits.transferSrc = false;
         createInfo.usageFlags.bits.transferDst = true;
         createInfo.usageFlags.bits.indexBuffer = true;
@@ -403,6 +636,8 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
 
 void TextDraw::DestroyApiObjects()
 {
+    mRuns.clear();
+
     if (mCpuIndexBuffer) {
         GetDevice()->DestroyBuffer(mCpuIndexBuffer);
         mCpuIndexBuffer.Reset();
@@ -462,107 +697,151 @@ void TextDraw::DestroyApiObjects()
 void TextDraw::Clear()
 {
     mTextLength = 0;
-}
 
-void TextDraw::AddString(
-    const float2&      position,
-    const std::string& string,
-    float              tabSpacing,
-    float              lineSpacing,
-    const float3&      color,
-    float              opacity)
-{
-    if (mTextLength >= mCreateInfo.maxTextLength) {
-        return;
+    for (auto it = mRuns.begin(); it != mRuns.end();) {
+        if (!it->second.used) {
+            it = mRuns.erase(it);
+            continue;
+        }
+        it->second.used = false;
+        ++it;
     }
+}
 
-    // Map index buffer
-    void*       mappedAddress = nullptr;
-    ppx::Result ppxres        = mCpuIndexBuffer->MapMemory(0, &mappedAddress);
-    if (Failed(ppxres)) {
-        return;
+bool TextDraw::TouchRunGlyphs(const StringRun& run)
+{
+    for (const grfx::TextureFontGlyphRef& ref : run.glyphs) {
+        if (!mCreateInfo.pFont->TouchGlyph(ref)) {
+            return false;
+        }
     }
-    uint8_t* pIndicesBaseAddr = static_cast<uint8_t*>(mappedAddress);
+    return true;
+}
 
-    // Map vertex buffer
-    ppxres = mCpuVertexBuffer->MapMemory(0, &mappedAddress);
-    if (Failed(ppxres)) {
-        return;
-    }
-    uint8_t* pVerticesBaseAddr = static_cast<uint8_t*>(mappedAddress);
+void TextDraw::BuildRun(StringRun* pRun)
+{
+    pRun->vertices.clear();
+    pRun->glyphs.clear();
+    pRun->complete = true;
 
-    // Convert to 8 bit color
-    uint32_t r    = std::min<uint32_t>(static_cast<uint32_t>(color.r * 255.0f), 255);
-    uint32_t g    = std::min<uint32_t>(static_cast<uint32_t>(color.g * 255.0f), 255);
-    uint32_t b    = std::min<uint32_t>(static_cast<uint32_t>(color.b * 255.0f), 255);
-    uint32_t a    = std::min<uint32_t>(static_cast<uint32_t>(opacity * 255.0f), 255);
-    uint32_t rgba = (a << 24) | (b << 16) | (g << 8) | (r << 0);
+    grfx::TextureFont* pFont = mCreateInfo.pFont;
 
-    utf8::iterator<std::string::const_iterator> it(string.begin(), string.begin(), string.end());
-    utf8::iterator<std::string::const_iterator> it_end(string.end(), string.begin(), string.end());
-    float2                                      baseline = position;
-    float                                       ascent   = mCreateInfo.pFont->GetAscent();
-    float                                       descent  = mCreateInfo.pFont->GetDescent();
-    float                                       lineGap  = mCreateInfo.pFont->GetLineGap();
-    lineSpacing                                          = lineSpacing * (ascent - descent + lineGap);
+    utf8::iterator<std::string::const_iterator> it(pRun->string.begin(), pRun->string.begin(), pRun->string.end());
+    utf8::iterator<std::string::const_iterator> it_end(pRun->string.end(), pRun->string.begin(), pRun->string.end());
+    float2                                      baseline    = pRun->position;
+    float                                       ascent      = pFont->GetAscent();
+    float                                       descent     = pFont->GetDescent();
+    float                                       lineGap     = pFont->GetLineGap();
+    float                                       lineSpacing = pRun->lineSpacing * (ascent - descent + lineGap);
 
     while (it != it_end) {
         uint32_t codepoint = utf8::next(it, it_end);
         if (codepoint == '\n') {
-            baseline.x = position.x;
+            baseline.x = pRun->position.x;
             baseline.y += lineSpacing;
             continue;
         }
-        else if (codepoint == '\t') {
-            const grfx::TextureFontGlyphMetrics* pMetrics = mCreateInfo.pFont->GetGlyphMetrics(32);
-            baseline.x += tabSpacing * pMetrics->glyphMetrics.advance;
+
+        grfx::TextureFontGlyphRef            ref      = {};
+        bool                                 resident = false;
+        const grfx::TextureFontGlyphMetrics* pMetrics = nullptr;
+        if (codepoint == '\t') {
+            pMetrics = pFont->AcquireGlyph(32, &ref, &resident);
+            if (!IsNull(pMetrics)) {
+                baseline.x += pRun->tabSpacing * pMetrics->glyphMetrics.advance;
+            }
             continue;
         }
 
-        const grfx::TextureFontGlyphMetrics* pMetrics = mCreateInfo.pFont->GetGlyphMetrics(codepoint);
+        pMetrics = pFont->AcquireGlyph(codepoint, &ref, &resident);
         if (IsNull(pMetrics)) {
-            pMetrics = mCreateInfo.pFont->GetGlyphMetrics(32);
+            pMetrics = pFont->AcquireGlyph(32, &ref, &resident);
+        }
+        if (IsNull(pMetrics)) {
+            // The glyph cache is full of glyphs in use.
+            pRun->complete = false;
+            continue;
+        }
+        if (ref.slot != GlyphCache::kInvalidSlot) {
+            pRun->glyphs.push_back(ref);
         }
 
-        size_t indexBufferOffset    = mTextLength * kGlyphIndicesSize;
-        size_t vertexBufferOffset   = mTextLength * kGlyphVerticesSize;
-        bool   exceededIndexBuffer  = (indexBufferOffset >= mCpuIndexBuffer->GetSize());
-        bool   exceededVertexBuffer = (vertexBufferOffset >= mCpuVertexBuffer->GetSize());
-        if (exceededIndexBuffer || exceededVertexBuffer) {
-            break;
+        // A glyph that is not in the texture yet still takes its room, and
+        // the run is built again until it is.
+        if (resident) {
+            float2 P   = baseline + float2(pMetrics->glyphMetrics.box.x0, pMetrics->glyphMetrics.box.y0);
+            float2 P0  = P;
+            float2 P1  = P + float2(0, pMetrics->size.y);
+            float2 P2  = P + pMetrics->size;
+            float2 P3  = P + float2(pMetrics->size.x, 0);
+            float2 uv0 = float2(pMetrics->uvRect.u0, pMetrics->uvRect.v0);
+            float2 uv1 = float2(pMetrics->uvRect.u0, pMetrics->uvRect.v1);
+            float2 uv2 = float2(pMetrics->uvRect.u1, pMetrics->uvRect.v1);
+            float2 uv3 = float2(pMetrics->uvRect.u1, pMetrics->uvRect.v0);
+
+            pRun->vertices.push_back(Vertex{P0, uv0, pRun->rgba});
+            pRun->vertices.push_back(Vertex{P1, uv1, pRun->rgba});
+            pRun->vertices.push_back(Vertex{P2, uv2, pRun->rgba});
+            pRun->vertices.push_back(Vertex{P3, uv3, pRun->rgba});
+        }
+        else {
+            pRun->complete = false;
         }
 
-        uint32_t* pIndices  = reinterpret_cast<uint32_t*>(pIndicesBaseAddr + indexBufferOffset);
-        Vertex*   pVertices = reinterpret_cast<Vertex*>(pVerticesBaseAddr + vertexBufferOffset);
-
-        float2 P   = baseline + float2(pMetrics->glyphMetrics.box.x0, pMetrics->glyphMetrics.box.y0);
-        float2 P0  = P;
-        float2 P1  = P + float2(0, pMetrics->size.y);
-        float2 P2  = P + pMetrics->size;
-        float2 P3  = P + float2(pMetrics->size.x, 0);
-        float2 uv0 = float2(pMetrics->uvRect.u0, pMetrics->uvRect.v0);
-        float2 uv1 = float2(pMetrics->uvRect.u0, pMetrics->uvRect.v1);
-        float2 uv2 = float2(pMetrics->uvRect.u1, pMetrics->uvRect.v1);
-        float2 uv3 = float2(pMetrics->uvRect.u1, pMetrics->uvRect.v0);
-
-        pVertices[0] = Vertex{P0, uv0, rgba};
-        pVertices[1] = Vertex{P1, uv1, rgba};
-        pVertices[2] = Vertex{P2, uv2, rgba};
-        pVertices[3] = Vertex{P3, uv3, rgba};
-
-        uint32_t vertexCount = mTextLength * 4;
-        pIndices[0]          = vertexCount + 0;
-        pIndices[1]          = vertexCount + 1;
-        pIndices[2]          = vertexCount + 2;
-        pIndices[3]          = vertexCount + 0;
-        pIndices[4]          = vertexCount + 2;
-        pIndices[5]          = vertexCount + 3;
-
-        mTextLength += 1;
         baseline.x += pMetrics->glyphMetrics.advance;
     }
+}
+
+void TextDraw::AddString(
+    const float2&      position,
+    const std::string& string,
+    float              tabSpacing,
+    float              lineSpacing,
+    const float3&      color,
+    float              opacity)
+{
+    if (mTextLength >= mCreateInfo.maxTextLength) {
+        return;
+    }
+
+    // Convert to 8 bit color
+    uint32_t r    = std::min<uint32_t>(static_cast<uint32_t>(color.r * 255.0f), 255);
+    uint32_t g    = std::min<uint32_t>(static_cast<uint32_t>(color.g * 255.0f), 255);
+    uint32_t b    = std::min<uint32_t>(static_cast<uint32_t>(color.b * 255.0f), 255);
+    uint32_t a    = std::min<uint32_t>(static_cast<uint32_t>(opacity * 255.0f), 255);
+    uint32_t rgba = (a << 24) | (b << 16) | (g << 8) | (r << 0);
+
+    // Find the run of a string added with the same arguments
+    const float    params[4] = {position.x, position.y, tabSpacing, lineSpacing};
+    const uint64_t key       = XXH64(params, sizeof(params), XXH64(string.data(), string.size(), rgba));
+    StringRun&     run       = mRuns[key];
+    const bool     sameArgs  = (run.string == string) && (run.position == position) && (run.tabSpacing == tabSpacing) && (run.lineSpacing == lineSpacing) && (run.rgba == rgba);
+    if (!run.complete || !sameArgs || !TouchRunGlyphs(run)) {
+        run.string      = string;
+        run.position    = position;
+        run.tabSpacing  = tabSpacing;
+        run.lineSpacing = lineSpacing;
+        run.rgba        = rgba;
+        BuildRun(&run);
+    }
+    run.used = true;
+
+    const uint32_t glyphCount = std::min<uint32_t>(CountU32(run.vertices) / 4, mCreateInfo.maxTextLength - mTextLength);
+    if (glyphCount == 0) {
+        return;
+    }
+
+    // Map vertex buffer
+    void*       mappedAddress = nullptr;
+    ppx::Result ppxres        = mCpuVertexBuffer->MapMemory(0, &mappedAddress);
+    if (Failed(ppxres)) {
+        return;
+    }
+    uint8_t* pVerticesBaseAddr = static_cast<uint8_t*>(mappedAddress);
+
+    memcpy(pVerticesBaseAddr + mTextLength * kGlyphVerticesSize, run.vertices.data(), glyphCount * kGlyphVerticesSize);
+    mTextLength += glyphCount;
 
-    mCpuIndexBuffer->UnmapMemory();
     mCpuVertexBuffer->UnmapMemory();
 }
 
@@ -587,6 +866,8 @@ ppx::Result TextDraw::UploadToGpu(grfx::Queue* pQueue)
         return ppxres;
     }
 
+    mUploadedIndexGlyphCount = mCreateInfo.maxTextLength;
+
     copyInfo.size = mCpuVertexBuffer->GetSize();
     ppxres        = pQueue->CopyBufferToBuffer(&copyInfo, mCpuVertexBuffer, mGpuVertexBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER, grfx::RESOURCE_STATE_VERTEX_BUFFER);
     if (Failed(ppxres)) {
@@ -599,15 +880,26 @@ ppx::Result TextDraw::UploadToGpu(grfx::Queue* pQueue)
 void TextDraw::UploadToGpu(grfx::CommandBuffer* pCommandBuffer)
 {
     grfx::BufferToBufferCopyInfo copyInfo = {};
-    copyInfo.size                         = mTextLength * kGlyphIndicesSize;
-    copyInfo.srcBuffer.offset             = 0;
-    copyInfo.dstBuffer.offset             = 0;
 
-    pCommandBuffer->BufferResourceBarrier(mGpuIndexBuffer, grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_COPY_DST);
-    pCommandBuffer->CopyBufferToBuffer(&copyInfo, mCpuIndexBuffer, mGpuIndexBuffer);
-    pCommandBuffer->BufferResourceBarrier(mGpuIndexBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_INDEX_BUFFER);
+    // The indices only need to be copied once.
+    if (mTextLength > mUploadedIndexGlyphCount) {
+        copyInfo.size             = (mTextLength - mUploadedIndexGlyphCount) * kGlyphIndicesSize;
+        copyInfo.srcBuffer.offset = mUploadedIndexGlyphCount * kGlyphIndicesSize;
+        copyInfo.dstBuffer.offset = mUploadedIndexGlyphCount * kGlyphIndicesSize;
+
+        pCommandBuffer->BufferResourceBarrier(mGpuIndexBuffer, grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_COPY_DST);
+        pCommandBuffer->CopyBufferToBuffer(&copyInfo, mCpuIndexBuffer, mGpuIndexBuffer);
+        pCommandBuffer->BufferResourceBarrier(mGpuIndexBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_INDEX_BUFFER);
+        mUploadedIndexGlyphCount = mTextLength;
+    }
+
+    if (mTextLength == 0) {
+        return;
+    }
 
-    copyInfo.size = mTextLength * kGlyphVerticesSize;
+    copyInfo.size             = mTextLength * kGlyphVerticesSize;
+    copyInfo.srcBuffer.offset = 0;
+    copyInfo.dstBuffer.offset = 0;
     pCommandBuffer->BufferResourceBarrier(mGpuVertexBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER, grfx::RESOURCE_STATE_COPY_DST);
     pCommandBuffer->CopyBufferToBuffer(&copyInfo, mCpuVertexBuffer, mGpuVertexBuffer);
     pCommandBuffer->BufferResourceBarrier(mGpuVertexBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_VERTEX_BUFFER);
@@ -87,6 +87,17 @@ Result CommandBuffer::End()
     return ppx::SUCCESS;
 }
 
+Result CommandBuffer::Reset()
+{
+    VkResult vkres = vkResetCommandBuffer(mCommandBuffer, 0);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkResetCommandBuffer failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    return ppx::SUCCESS;
+}
+
 void CommandBuffer::BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo)
 {
     VkRect2D rect = {};
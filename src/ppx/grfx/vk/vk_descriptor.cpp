@@ -92,6 +92,90 @@ void DescriptorPool::DestroyApiObjects()
     }
 }
 
+// -------------------------------------------------------------------------------------------------
+// ToVkWriteDescriptorSet
+// -------------------------------------------------------------------------------------------------
+Result ToVkWriteDescriptorSet(
+    VkDescriptorSet              vkSet,
+    const grfx::WriteDescriptor& write,
+    VkDescriptorImageInfo*       pImageInfo,
+    VkDescriptorBufferInfo*      pBufferInfo,
+    VkBufferView*                pTexelBufferView,
+    VkWriteDescriptorSet*        pVkWrite)
+{
+    VkDescriptorImageInfo*  pWriteImageInfo       = nullptr;
+    VkBufferView*           pWriteTexelBufferView = nullptr;
+    VkDescriptorBufferInfo* pWriteBufferInfo      = nullptr;
+
+    VkDescriptorType descriptorType = ToVkDescriptorType(write.type);
+    switch (descriptorType) {
+        default: {
+            PPX_ASSERT_MSG(false, "unknown descriptor type: " << ToString(descriptorType) << "(" << descriptorType << ")");
+            return ppx::ERROR_GRFX_UNKNOWN_DESCRIPTOR_TYPE;
+        } break;
+
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: {
+            pWriteImageInfo = pImageInfo;
+            // Fill out info
+            pImageInfo->sampler     = VK_NULL_HANDLE;
+            pImageInfo->imageView   = VK_NULL_HANDLE;
+            pImageInfo->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            switch (descriptorType) {
+                default: break;
+                case VK_DESCRIPTOR_TYPE_SAMPLER: {
+                    pImageInfo->sampler = ToApi(write.pSampler)->GetVkSampler();
+                } break;
+
+                case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: {
+                    pImageInfo->sampler     = ToApi(write.pSampler)->GetVkSampler();
+                    pImageInfo->imageView   = ToApi(write.pImageView->GetResourceView())->GetVkImageView();
+                    pImageInfo->imageLayout = ToApi(write.pImageView->GetResourceView())->GetVkImageLayout();
+                } break;
+
+                case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: {
+                    pImageInfo->imageView   = ToApi(write.pImageView->GetResourceView())->GetVkImageView();
+                    pImageInfo->imageLayout = ToApi(write.pImageView->GetResourceView())->GetVkImageLayout();
+                } break;
+            }
+        } break;
+
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: {
+            PPX_ASSERT_MSG(false, "TEXEL BUFFER NOT IMPLEMENTED");
+            pWriteTexelBufferView = pTexelBufferView;
+        } break;
+
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
+            pWriteBufferInfo = pBufferInfo;
+            // Fill out info
+            pBufferInfo->buffer = ToApi(write.pBuffer)->GetVkBuffer();
+            pBufferInfo->offset = write.bufferOffset;
+            pBufferInfo->range  = (write.bufferRange == PPX_WHOLE_SIZE) ? VK_WHOLE_SIZE : static_cast<VkDeviceSize>(write.bufferRange);
+        } break;
+    }
+
+    *pVkWrite                  = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    pVkWrite->dstSet           = vkSet;
+    pVkWrite->dstBinding       = write.binding;
+    pVkWrite->dstArrayElement  = write.arrayIndex;
+    pVkWrite->descriptorCount  = 1;
+    pVkWrite->descriptorType   = descriptorType;
+    pVkWrite->pImageInfo       = pWriteImageInfo;
+    pVkWrite->pBufferInfo      = pWriteBufferInfo;
+    pVkWrite->pTexelBufferView = pWriteTexelBufferView;
+
+    return ppx::SUCCESS;
+}
+
 // -------------------------------------------------------------------------------------------------
 // DescriptorSet
 // -------------------------------------------------------------------------------------------------
@@ -142,7 +226,7 @@ void DescriptorSet::DestroyApiObjects()
     }
 }
 
-Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
+Result DescriptorSet::UpdateApiDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
 {
     if (writeCount == 0) {
         return ppx::ERROR_UNEXPECTED_COUNT_VALUE;
@@ -155,97 +239,22 @@ Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDe
         mTexelBufferStore.resize(writeCount);
     }
 
-    mImageCount       = 0;
-    mBufferCount      = 0;
-    mTexelBufferCount = 0;
-    for (mWriteCount = 0; mWriteCount < writeCount; ++mWriteCount) {
-        const grfx::WriteDescriptor& srcWrite = pWrites[mWriteCount];
-
-        VkDescriptorImageInfo*  pImageInfo       = nullptr;
-        VkBufferView*           pTexelBufferView = nullptr;
-        VkDescriptorBufferInfo* pBufferInfo      = nullptr;
-
-        VkDescriptorType descriptorType = ToVkDescriptorType(srcWrite.type);
-        switch (descriptorType) {
-            default: {
-                PPX_ASSERT_MSG(false, "unknown descriptor type: " << ToString(descriptorType) << "(" << descriptorType << ")");
-                return ppx::ERROR_GRFX_UNKNOWN_DESCRIPTOR_TYPE;
-            } break;
-
-            case VK_DESCRIPTOR_TYPE_SAMPLER:
-            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: {
-                PPX_ASSERT_MSG(mImageCount < mImageInfoStore.size(), "image count exceeds image store capacity");
-                pImageInfo = &mImageInfoStore[mImageCount];
-                // Fill out info
-                pImageInfo->sampler     = VK_NULL_HANDLE;
-                pImageInfo->imageView   = VK_NULL_HANDLE;
-                pImageInfo->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                switch (descriptorType) {
-                    default: break;
-                    case VK_DESCRIPTOR_TYPE_SAMPLER: {
-                        pImageInfo->sampler = ToApi(srcWrite.pSampler)->GetVkSampler();
-                    } break;
-
-                    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: {
-                        pImageInfo->sampler     = ToApi(srcWrite.pSampler)->GetVkSampler();
-                        pImageInfo->imageView   = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageView();
-                        pImageInfo->imageLayout = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageLayout();
-                    } break;
-
-                    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-                    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-                    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: {
-                        pImageInfo->imageView   = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageView();
-                        pImageInfo->imageLayout = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageLayout();
-                    } break;
-                }
-                // Increment count
-                mImageCount += 1;
-            } break;
-
-            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: {
-                PPX_ASSERT_MSG(false, "TEXEL BUFFER NOT IMPLEMENTED");
-                PPX_ASSERT_MSG(mTexelBufferCount < mImageInfoStore.size(), "texel buffer count exceeds texel buffer store capacity");
-                pTexelBufferView = &mTexelBufferStore[mTexelBufferCount];
-                // Fill out info
-                // Increment count
-                mTexelBufferCount += 1;
-            } break;
-
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
-                PPX_ASSERT_MSG(mBufferCount < mBufferInfoStore.size(), "buffer count exceeds buffer store capacity");
-                pBufferInfo = &mBufferInfoStore[mBufferCount];
-                // Fill out info
-                pBufferInfo->buffer = ToApi(srcWrite.pBuffer)->GetVkBuffer();
-                pBufferInfo->offset = srcWrite.bufferOffset;
-                pBufferInfo->range  = (srcWrite.bufferRange == PPX_WHOLE_SIZE) ? VK_WHOLE_SIZE : static_cast<VkDeviceSize>(srcWrite.bufferRange);
-                // Increment count
-                mBufferCount += 1;
-            } break;
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        Result ppxres = ToVkWriteDescriptorSet(
+            mDescriptorSet,
+            pWrites[i],
+            &mImageInfoStore[i],
+            &mBufferInfoStore[i],
+            &mTexelBufferStore[i],
+            &mWriteStore[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
         }
-
-        VkWriteDescriptorSet& vkWrite = mWriteStore[mWriteCount];
-        vkWrite                       = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        vkWrite.dstSet                = mDescriptorSet;
-        vkWrite.dstBinding            = srcWrite.binding;
-        vkWrite.dstArrayElement       = srcWrite.arrayIndex;
-        vkWrite.descriptorCount       = 1;
-        vkWrite.descriptorType        = descriptorType;
-        vkWrite.pImageInfo            = pImageInfo;
-        vkWrite.pBufferInfo           = pBufferInfo;
-        vkWrite.pTexelBufferView      = pTexelBufferView;
     }
 
     vk::UpdateDescriptorSets(
         ToApi(GetDevice())->GetVkDevice(),
-        mWriteCount,
+        writeCount,
         mWriteStore.data(),
         0,
         nullptr);
@@ -693,6 +693,12 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         }
     }
 
+    // Pipeline cache
+    ppxres = CreatePipelineCache(pCreateInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
     // Create queues
     ppxres = CreateQueues(pCreateInfo);
     if (Failed(ppxres)) {
@@ -702,8 +708,83 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
     return ppx::SUCCESS;
 }
 
+Result Device::CreatePipelineCache(const grfx::DeviceCreateInfo* pCreateInfo)
+{
+    // The file is only valid for the driver that wrote it.
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &properties);
+    mPipelineCacheDeviceInfo.vendorId      = properties.vendorID;
+    mPipelineCacheDeviceInfo.deviceId      = properties.deviceID;
+    mPipelineCacheDeviceInfo.driverVersion = properties.driverVersion;
+    static_assert(sizeof(mPipelineCacheDeviceInfo.cacheUuid) == VK_UUID_SIZE, "pipeline cache UUID size mismatch");
+    std::memcpy(mPipelineCacheDeviceInfo.cacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    mPipelineCachePath = pCreateInfo->pipelineCachePath;
+
+    std::vector<char> initialData;
+    if (!mPipelineCachePath.empty()) {
+        if (Success(PipelineCacheFile::Load(mPipelineCachePath, mPipelineCacheDeviceInfo, &initialData))) {
+            PPX_LOG_INFO("Loaded Vulkan pipeline cache (" << initialData.size() << " bytes): " << mPipelineCachePath);
+        }
+        else {
+            PPX_LOG_INFO("No valid Vulkan pipeline cache for this device and driver, starting cold: " << mPipelineCachePath);
+        }
+    }
+
+    VkPipelineCacheCreateInfo vkci = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    vkci.initialDataSize           = initialData.size();
+    vkci.pInitialData              = DataPtr(initialData);
+
+    VkResult vkres = vkCreatePipelineCache(mDevice, &vkci, nullptr, &mPipelineCache);
+    if ((vkres != VK_SUCCESS) && !initialData.empty()) {
+        // The header matched but the driver rejected the data, start cold.
+        PPX_LOG_WARN("vkCreatePipelineCache rejected the cached data: " << ToString(vkres));
+        initialData.clear();
+        vkci.initialDataSize = 0;
+        vkci.pInitialData    = nullptr;
+        vkres                = vkCreatePipelineCache(mDevice, &vkci, nullptr, &mPipelineCache);
+    }
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreatePipelineCache failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    mPipelineCacheWarm = !initialData.empty();
+    return ppx::SUCCESS;
+}
+
+void Device::DestroyPipelineCache()
+{
+    if (!mPipelineCache) {
+        return;
+    }
+
+    if (!mPipelineCachePath.empty()) {
+        size_t   size  = 0;
+        VkResult vkres = vkGetPipelineCacheData(mDevice, mPipelineCache, &size, nullptr);
+
+        std::vector<char> data(size);
+        if ((vkres == VK_SUCCESS) && (size > 0)) {
+            vkres = vkGetPipelineCacheData(mDevice, mPipelineCache, &size, DataPtr(data));
+        }
+        if ((vkres == VK_SUCCESS) && (size > 0)) {
+            if (Success(PipelineCacheFile::Save(mPipelineCachePath, mPipelineCacheDeviceInfo, DataPtr(data), size))) {
+                PPX_LOG_INFO("Saved Vulkan pipeline cache (" << size << " bytes): " << mPipelineCachePath);
+            }
+        }
+        else if (vkres != VK_SUCCESS) {
+            PPX_LOG_WARN("vkGetPipelineCacheData failed: " << ToString(vkres));
+        }
+    }
+
+    vkDestroyPipelineCache(mDevice, mPipelineCache, nullptr);
+    mPipelineCache.Reset();
+}
+
 void Device::DestroyApiObjects()
 {
+    DestroyPipelineCache();
+
     if (mVmaAllocator) {
         vmaDestroyAllocator(mVmaAllocator);
         mVmaAllocator.Reset();
@@ -950,6 +1031,40 @@ Result Device::AllocateObject(grfx::Swapchain** ppObject)
     return ppx::SUCCESS;
 }
 
+Result Device::UpdateApiDescriptorSets(uint32_t writeCount, const grfx::DescriptorSetWrite* pWrites)
+{
+    std::lock_guard<std::mutex> lock(mDescriptorWriteStoreMutex);
+
+    if (CountU32(mDescriptorWriteStore) < writeCount) {
+        mDescriptorWriteStore.resize(writeCount);
+        mDescriptorImageInfoStore.resize(writeCount);
+        mDescriptorBufferInfoStore.resize(writeCount);
+        mDescriptorTexelBufferStore.resize(writeCount);
+    }
+
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        Result ppxres = ToVkWriteDescriptorSet(
+            ToApi(pWrites[i].pSet)->GetVkDescriptorSet(),
+            pWrites[i].write,
+            &mDescriptorImageInfoStore[i],
+            &mDescriptorBufferInfoStore[i],
+            &mDescriptorTexelBufferStore[i],
+            &mDescriptorWriteStore[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    vk::UpdateDescriptorSets(
+        mDevice,
+        writeCount,
+        mDescriptorWriteStore.data(),
+        0,
+        nullptr);
+
+    return ppx::SUCCESS;
+}
+
 Result Device::WaitIdle()
 {
     VkResult vkres = vkDeviceWaitIdle(mDevice);
@@ -19,31 +19,31 @@ namespace ppx {
 namespace grfx {
 namespace vk {
 
-static ProfilerEventToken s_vkCreateBuffer           = 0;
-static ProfilerEventToken s_vkCreateImage            = 0;
-static ProfilerEventToken s_vkCreateImageView        = 0;
-static ProfilerEventToken s_vkCreateCommandPool      = 0;
-static ProfilerEventToken s_vkCreateRenderPass       = 0;
-static ProfilerEventToken s_vkCreateRenderPass2      = 0;
-static ProfilerEventToken s_vkAllocateCommandBuffers = 0;
-static ProfilerEventToken s_vkFreeCommandBuffers     = 0;
-static ProfilerEventToken s_vkAllocateDescriptorSets = 0;
-static ProfilerEventToken s_vkFreeDescriptorSets     = 0;
-static ProfilerEventToken s_vkUpdateDescriptorSets   = 0;
-static ProfilerEventToken s_vkQueuePresent           = 0;
-static ProfilerEventToken s_vkQueueSubmit            = 0;
-static ProfilerEventToken s_vkBeginCommandBuffer     = 0;
-static ProfilerEventToken s_vkEndCommandBuffer       = 0;
-static ProfilerEventToken s_vkCmdPipelineBarrier     = 0;
-static ProfilerEventToken s_vkCmdBeginRenderPass     = 0;
-static ProfilerEventToken s_vkCmdEndRenderPass       = 0;
-static ProfilerEventToken s_vkCmdBindDescriptorSets  = 0;
-static ProfilerEventToken s_vkCmdBindIndexBuffer     = 0;
-static ProfilerEventToken s_vkCmdBindPipeline        = 0;
-static ProfilerEventToken s_vkCmdBindVertexBuffers   = 0;
-static ProfilerEventToken s_vkCmdDispatch            = 0;
-static ProfilerEventToken s_vkCmdDraw                = 0;
-static ProfilerEventToken s_vkCmdDrawIndexed         = 0;
+static ProfilerEventToken s_vkCreateBuffer           = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCreateImage            = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCreateImageView        = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCreateCommandPool      = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCreateRenderPass       = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCreateRenderPass2      = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkAllocateCommandBuffers = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkFreeCommandBuffers     = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkAllocateDescriptorSets = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkFreeDescriptorSets     = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkUpdateDescriptorSets   = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkQueuePresent           = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkQueueSubmit            = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkBeginCommandBuffer     = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkEndCommandBuffer       = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdPipelineBarrier     = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdBeginRenderPass     = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdEndRenderPass       = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdBindDescriptorSets  = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdBindIndexBuffer     = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdBindPipeline        = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdBindVertexBuffers   = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdDispatch            = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdDraw                = kInvalidProfilerEventToken;
+static ProfilerEventToken s_vkCmdDrawIndexed         = kInvalidProfilerEventToken;
 
 void RegisterProfilerFunctions()
 {
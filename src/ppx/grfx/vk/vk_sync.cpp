@@ -68,6 +68,12 @@ Result Fence::Wait(uint64_t timeout)
     return ppx::SUCCESS;
 }
 
+bool Fence::IsSignaled() const
+{
+    VkResult vkres = vkGetFenceStatus(ToApi(GetDevice())->GetVkDevice(), mFence);
+    return (vkres == VK_SUCCESS);
+}
+
 Result Fence::Reset()
 {
     VkResult vkres = vkResetFences(
@@ -0,0 +1,550 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Image comparison for CompareBitmaps.
+//
+// Rows of both images are converted to RGBA floats, one vector per pixel
+// with one lane per channel, so that every format goes through the same
+// kernels. The vector type maps to SSE2 on x86 and to plain floats
+// elsewhere. The image is split in bands of 4-row groups compared in
+// parallel; each band also sums the 4x4 blocks of the group that follows it
+// so that the SSIM windows straddling two bands are counted once.
+
+#include "ppx/image_diff.h"
+#include "ppx/parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PPX_IMAGE_DIFF_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ppx {
+
+namespace {
+
+// SSIM windows are 2x2 blocks of kBlockSize x kBlockSize pixels.
+constexpr uint32_t kBlockSize        = 4;
+constexpr float    kWindowPixelCount = 4 * kBlockSize * kBlockSize;
+constexpr float    kSSIMC1           = 0.01f * 0.01f;
+constexpr float    kSSIMC2           = 0.03f * 0.03f;
+
+// Minimum number of block rows compared by each thread.
+constexpr size_t kMinGroupsPerThread = 16;
+
+// -------------------------------------------------------------------------------------------------
+// Vec4
+// -------------------------------------------------------------------------------------------------
+#if defined(PPX_IMAGE_DIFF_SSE2)
+struct Vec4
+{
+    __m128 v = _mm_setzero_ps();
+
+    Vec4() {}
+    Vec4(__m128 value)
+        : v(value) {}
+    explicit Vec4(float value)
+        : v(_mm_set1_ps(value)) {}
+
+    static Vec4 Load(const float* p) { return _mm_loadu_ps(p); }
+    void        Store(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+inline Vec4 operator+(Vec4 a, Vec4 b) { return _mm_add_ps(a.v, b.v); }
+inline Vec4 operator-(Vec4 a, Vec4 b) { return _mm_sub_ps(a.v, b.v); }
+inline Vec4 operator*(Vec4 a, Vec4 b) { return _mm_mul_ps(a.v, b.v); }
+inline Vec4 operator/(Vec4 a, Vec4 b) { return _mm_div_ps(a.v, b.v); }
+inline Vec4 Max(Vec4 a, Vec4 b) { return _mm_max_ps(a.v, b.v); }
+inline Vec4 Abs(Vec4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+
+inline float HorizontalMax(Vec4 a)
+{
+    __m128 m = _mm_max_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m        = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(m);
+}
+#else
+struct Vec4
+{
+    float v[4] = {};
+
+    Vec4() {}
+    explicit Vec4(float value)
+        : v{value, value, value, value} {}
+
+    static Vec4 Load(const float* p)
+    {
+        Vec4 r;
+        std::copy(p, p + 4, r.v);
+        return r;
+    }
+    void Store(float* p) const { std::copy(v, v + 4, p); }
+};
+
+template <typename Fn>
+inline Vec4 Map(Vec4 a, Vec4 b, Fn fn)
+{
+    Vec4 r;
+    for (uint32_t i = 0; i < 4; ++i) {
+        r.v[i] = fn(a.v[i], b.v[i]);
+    }
+    return r;
+}
+
+inline Vec4 operator+(Vec4 a, Vec4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+inline Vec4 operator-(Vec4 a, Vec4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+inline Vec4 operator*(Vec4 a, Vec4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+inline Vec4 operator/(Vec4 a, Vec4 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+inline Vec4 Max(Vec4 a, Vec4 b) { return Map(a, b, [](float x, float y) { return (x > y) ? x : y; }); }
+inline Vec4 Abs(Vec4 a) { return Map(a, a, [](float x, float) { return std::fabs(x); }); }
+
+inline float HorizontalMax(Vec4 a)
+{
+    return std::max(std::max(a.v[0], a.v[1]), std::max(a.v[2], a.v[3]));
+}
+#endif
+
+inline void Accumulate(const Vec4& value, double* pDst)
+{
+    float lanes[4];
+    value.Store(lanes);
+    for (uint32_t i = 0; i < 4; ++i) {
+        pDst[i] += lanes[i];
+    }
+}
+
+inline void AccumulateMax(const Vec4& value, double* pDst)
+{
+    float lanes[4];
+    value.Store(lanes);
+    for (uint32_t i = 0; i < 4; ++i) {
+        pDst[i] = std::max<double>(pDst[i], lanes[i]);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Row loading
+// -------------------------------------------------------------------------------------------------
+// Converts row y to normalized RGBA floats. Missing channels are set to 0.
+void LoadRow(const Bitmap& bitmap, uint32_t y, float* pDst)
+{
+    const uint32_t width        = bitmap.GetWidth();
+    const uint32_t channelCount = bitmap.GetChannelCount();
+    const char*    pRow         = bitmap.GetPixelAddress(0, y);
+
+    uint32_t x = 0;
+#if defined(PPX_IMAGE_DIFF_SSE2)
+    if (bitmap.GetFormat() == Bitmap::FORMAT_RGBA_UINT8) {
+        const __m128i zero  = _mm_setzero_si128();
+        const __m128  scale = _mm_set1_ps(1.0f / 255.0f);
+        for (; x + 4 <= width; x += 4) {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + 4 * x));
+            __m128i lo     = _mm_unpacklo_epi8(texels, zero);
+            __m128i hi     = _mm_unpackhi_epi8(texels, zero);
+            _mm_storeu_ps(pDst + 4 * x + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+            _mm_storeu_ps(pDst + 4 * x + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+            _mm_storeu_ps(pDst + 4 * x + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+            _mm_storeu_ps(pDst + 4 * x + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+        }
+    }
+#endif
+
+    const uint32_t pixelStride = bitmap.GetPixelStride();
+    for (; x < width; ++x) {
+        const char* pPixel = pRow + x * pixelStride;
+        float*      pOut   = pDst + 4 * x;
+        for (uint32_t c = 0; c < 4; ++c) {
+            float value = 0.0f;
+            if (c < channelCount) {
+                // clang-format off
+                switch (Bitmap::ChannelDataType(bitmap.GetFormat())) {
+                    default: break;
+                    case Bitmap::DATA_TYPE_UINT8  : value = reinterpret_cast<const uint8_t*>(pPixel)[c] * (1.0f / 255.0f); break;
+                    case Bitmap::DATA_TYPE_UINT16 : value = reinterpret_cast<const uint16_t*>(pPixel)[c] / 65535.0f; break;
+                    case Bitmap::DATA_TYPE_UINT32 : value = static_cast<float>(reinterpret_cast<const uint32_t*>(pPixel)[c] / 4294967295.0); break;
+                    case Bitmap::DATA_TYPE_FLOAT  : value = reinterpret_cast<const float*>(pPixel)[c]; break;
+                }
+                // clang-format on
+            }
+            pOut[c] = value;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Heatmap
+// -------------------------------------------------------------------------------------------------
+// Number of heatmap colors above black.
+constexpr uint32_t kHeatmapSteps = 3 * 255;
+
+// Ramp from black to red, yellow then white.
+struct HeatmapColors
+{
+    uint8_t rgba[kHeatmapSteps + 1][4];
+
+    HeatmapColors()
+    {
+        for (uint32_t i = 0; i <= kHeatmapSteps; ++i) {
+            rgba[i][0] = static_cast<uint8_t>(std::min<uint32_t>(i, 255));
+            rgba[i][1] = static_cast<uint8_t>(std::clamp<uint32_t>(i, 255, 510) - 255);
+            rgba[i][2] = static_cast<uint8_t>(std::max<uint32_t>(i, 510) - 510);
+            rgba[i][3] = 255;
+        }
+    }
+};
+
+void WriteHeatmapRow(const float* pPixelErrors, uint32_t width, float scale, uint8_t* pDst)
+{
+    static const HeatmapColors sColors;
+    for (uint32_t x = 0; x < width; ++x) {
+        float    step  = pPixelErrors[x] * scale + 0.5f;
+        uint32_t index = (step < static_cast<float>(kHeatmapSteps)) ? static_cast<uint32_t>(step) : kHeatmapSteps;
+        memcpy(pDst + 4 * x, sColors.rgba[index], 4);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// SSIM
+// -------------------------------------------------------------------------------------------------
+struct BlockSums
+{
+    Vec4 s1;  // Sum of reference values
+    Vec4 s2;  // Sum of test values
+    Vec4 ss;  // Sum of squared reference and test values
+    Vec4 s12; // Sum of reference * test values
+};
+
+// Adds the pixels of one row to the blocks of a block row.
+void AccumulateBlocks(const float* pRowA, const float* pRowB, uint32_t blockCount, BlockSums* pBlocks)
+{
+    for (uint32_t bx = 0; bx < blockCount; ++bx) {
+        BlockSums& block = pBlocks[bx];
+        for (uint32_t i = 0; i < kBlockSize; ++i) {
+            const uint32_t offset = 4 * (bx * kBlockSize + i);
+            Vec4           a      = Vec4::Load(pRowA + offset);
+            Vec4           b      = Vec4::Load(pRowB + offset);
+            block.s1              = block.s1 + a;
+            block.s2              = block.s2 + b;
+            block.ss              = block.ss + (a * a + b * b);
+            block.s12             = block.s12 + a * b;
+        }
+    }
+}
+
+Vec4 ComputeSSIM(const BlockSums& sums, float pixelCount)
+{
+    const Vec4 invCount(1.0f / pixelCount);
+    const Vec4 two(2.0f);
+    const Vec4 c1(kSSIMC1);
+    const Vec4 c2(kSSIMC2);
+
+    Vec4 mu1      = sums.s1 * invCount;
+    Vec4 mu2      = sums.s2 * invCount;
+    Vec4 mu1mu2   = mu1 * mu2;
+    Vec4 muSq     = mu1 * mu1 + mu2 * mu2;
+    Vec4 sigmaSq  = sums.ss * invCount - muSq;
+    Vec4 covar    = sums.s12 * invCount - mu1mu2;
+    Vec4 numer    = (two * mu1mu2 + c1) * (two * covar + c2);
+    Vec4 denom    = (muSq + c1) * (sigmaSq + c2);
+    return numer / denom;
+}
+
+// Sums the SSIM of the windows made of two consecutive block rows.
+Vec4 SumWindowRow(const BlockSums* pTop, const BlockSums* pBottom, uint32_t blockCount)
+{
+    Vec4 sum;
+    for (uint32_t bx = 0; bx + 1 < blockCount; ++bx) {
+        BlockSums window;
+        window.s1  = pTop[bx].s1 + pTop[bx + 1].s1 + pBottom[bx].s1 + pBottom[bx + 1].s1;
+        window.s2  = pTop[bx].s2 + pTop[bx + 1].s2 + pBottom[bx].s2 + pBottom[bx + 1].s2;
+        window.ss  = pTop[bx].ss + pTop[bx + 1].ss + pBottom[bx].ss + pBottom[bx + 1].ss;
+        window.s12 = pTop[bx].s12 + pTop[bx + 1].s12 + pBottom[bx].s12 + pBottom[bx + 1].s12;
+        sum        = sum + ComputeSSIM(window, kWindowPixelCount);
+    }
+    return sum;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Bands
+// -------------------------------------------------------------------------------------------------
+struct BandStats
+{
+    uint64_t differentPixelCount = 0;
+    double   sumAbsError[4]      = {};
+    double   sumSqError[4]       = {};
+    double   sumRelError[4]      = {};
+    double   maxAbsError[4]      = {};
+    double   maxRelError[4]      = {};
+    double   sumSSIM[4]          = {};
+};
+
+struct BandContext
+{
+    const Bitmap* pReference      = nullptr;
+    const Bitmap* pTest           = nullptr;
+    Bitmap*       pHeatmap        = nullptr;
+    float         heatmapScale    = 0; // Heatmap steps per unit of error
+    uint32_t      blockCols       = 0;
+    uint32_t      blockRows       = 0; // 0 if SSIM windows are not computed
+};
+
+// Compares one row and stores the largest channel error of each pixel.
+void CompareRow(const float* pRowA, const float* pRowB, uint32_t width, float* pPixelErrors, BandStats* pStats)
+{
+    const Vec4 tiny(FLT_MIN);
+
+    Vec4 sumAbs;
+    Vec4 sumSq;
+    Vec4 sumRel;
+    Vec4 maxAbs;
+    Vec4 maxRel;
+    for (uint32_t x = 0; x < width; ++x) {
+        Vec4 a      = Vec4::Load(pRowA + 4 * x);
+        Vec4 b      = Vec4::Load(pRowB + 4 * x);
+        Vec4 diff   = a - b;
+        Vec4 absErr = Abs(diff);
+        Vec4 relErr = absErr / Max(Max(Abs(a), Abs(b)), tiny);
+        sumAbs      = sumAbs + absErr;
+        sumSq       = sumSq + diff * diff;
+        sumRel      = sumRel + relErr;
+        maxAbs      = Max(maxAbs, absErr);
+        maxRel      = Max(maxRel, relErr);
+
+        pPixelErrors[x] = HorizontalMax(absErr);
+    }
+    Accumulate(sumAbs, pStats->sumAbsError);
+    Accumulate(sumSq, pStats->sumSqError);
+    Accumulate(sumRel, pStats->sumRelError);
+    AccumulateMax(maxAbs, pStats->maxAbsError);
+    AccumulateMax(maxRel, pStats->maxRelError);
+
+    uint32_t differentPixelCount = 0;
+    for (uint32_t x = 0; x < width; ++x) {
+        differentPixelCount += (pPixelErrors[x] > 0.0f) ? 1 : 0;
+    }
+    pStats->differentPixelCount += differentPixelCount;
+}
+
+// Compares the rows of block rows [groupBegin, groupEnd), and the SSIM
+// windows whose top block row is in that range.
+void CompareBand(const BandContext& ctx, uint32_t groupBegin, uint32_t groupEnd, BandStats* pStats)
+{
+    const uint32_t width  = ctx.pReference->GetWidth();
+    const uint32_t height = ctx.pReference->GetHeight();
+
+    std::vector<float>     rowA(4 * width);
+    std::vector<float>     rowB(4 * width);
+    std::vector<float>     pixelErrors(width);
+    std::vector<BlockSums> prevBlocks(ctx.blockCols);
+    std::vector<BlockSums> currBlocks(ctx.blockCols);
+    bool                   hasPrevBlocks = false;
+
+    auto finishBlockRow = [&]() {
+        if (hasPrevBlocks) {
+            Accumulate(SumWindowRow(prevBlocks.data(), currBlocks.data(), ctx.blockCols), pStats->sumSSIM);
+        }
+        std::swap(prevBlocks, currBlocks);
+        std::fill(currBlocks.begin(), currBlocks.end(), BlockSums());
+        hasPrevBlocks = true;
+    };
+
+    for (uint32_t group = groupBegin; group < groupEnd; ++group) {
+        const bool     sumBlocks = (group < ctx.blockRows);
+        const uint32_t rowEnd    = std::min(height, (group + 1) * kBlockSize);
+        for (uint32_t y = group * kBlockSize; y < rowEnd; ++y) {
+            LoadRow(*ctx.pReference, y, rowA.data());
+            LoadRow(*ctx.pTest, y, rowB.data());
+
+            CompareRow(rowA.data(), rowB.data(), width, pixelErrors.data(), pStats);
+            if (!IsNull(ctx.pHeatmap)) {
+                WriteHeatmapRow(pixelErrors.data(), width, ctx.heatmapScale, ctx.pHeatmap->GetPixel8u(0, y));
+            }
+
+            if (sumBlocks) {
+                AccumulateBlocks(rowA.data(), rowB.data(), ctx.blockCols, currBlocks.data());
+            }
+        }
+        if (sumBlocks) {
+            finishBlockRow();
+        }
+    }
+
+    // The windows of the last block row of the band extend into the next one.
+    if (hasPrevBlocks && (groupEnd < ctx.blockRows)) {
+        for (uint32_t y = groupEnd * kBlockSize; y < (groupEnd + 1) * kBlockSize; ++y) {
+            LoadRow(*ctx.pReference, y, rowA.data());
+            LoadRow(*ctx.pTest, y, rowB.data());
+            AccumulateBlocks(rowA.data(), rowB.data(), ctx.blockCols, currBlocks.data());
+        }
+        finishBlockRow();
+    }
+}
+
+// Computes the SSIM of an image too small for 8x8 windows as a single
+// window covering the whole image.
+Vec4 ComputeWholeImageSSIM(const Bitmap& reference, const Bitmap& test)
+{
+    const uint32_t width = reference.GetWidth();
+
+    std::vector<float> rowA(4 * width);
+    std::vector<float> rowB(4 * width);
+    double             sums[4][4] = {};
+    for (uint32_t y = 0; y < reference.GetHeight(); ++y) {
+        LoadRow(reference, y, rowA.data());
+        LoadRow(test, y, rowB.data());
+        for (uint32_t x = 0; x < width; ++x) {
+            Vec4 a = Vec4::Load(rowA.data() + 4 * x);
+            Vec4 b = Vec4::Load(rowB.data() + 4 * x);
+            Accumulate(a, sums[0]);
+            Accumulate(b, sums[1]);
+            Accumulate(a * a + b * b, sums[2]);
+            Accumulate(a * b, sums[3]);
+        }
+    }
+
+    // Normalize in double before going back to floats.
+    const double pixelCount = static_cast<double>(width) * reference.GetHeight();
+    float        means[4][4];
+    for (uint32_t i = 0; i < 4; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            means[i][c] = static_cast<float>(sums[i][c] / pixelCount);
+        }
+    }
+    BlockSums window;
+    window.s1  = Vec4::Load(means[0]);
+    window.s2  = Vec4::Load(means[1]);
+    window.ss  = Vec4::Load(means[2]);
+    window.s12 = Vec4::Load(means[3]);
+    return ComputeSSIM(window, 1.0f);
+}
+
+double ToPSNR(double mse)
+{
+    return (mse > 0.0) ? 10.0 * std::log10(1.0 / mse) : std::numeric_limits<double>::infinity();
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// CompareBitmaps
+// -------------------------------------------------------------------------------------------------
+Result CompareBitmaps(
+    const Bitmap&           reference,
+    const Bitmap&           test,
+    const ImageDiffOptions& options,
+    ImageDiffStats*         pStats,
+    Bitmap*                 pHeatmap)
+{
+    PPX_ASSERT_NULL_ARG(pStats);
+    if (IsNull(pStats)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (!reference.IsOk() || !test.IsOk() || (reference.GetFormat() != test.GetFormat())) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if ((reference.GetWidth() != test.GetWidth()) || (reference.GetHeight() != test.GetHeight())) {
+        return ppx::ERROR_BITMAP_FOOTPRINT_MISMATCH;
+    }
+
+    const uint32_t width        = reference.GetWidth();
+    const uint32_t height       = reference.GetHeight();
+    const uint32_t channelCount = reference.GetChannelCount();
+
+    if (!IsNull(pHeatmap)) {
+        Result ppxres = Bitmap::Create(width, height, Bitmap::FORMAT_RGBA_UINT8, pHeatmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    BandContext ctx     = {};
+    ctx.pReference      = &reference;
+    ctx.pTest           = &test;
+    ctx.pHeatmap        = pHeatmap;
+    ctx.heatmapScale    = (options.heatmapMaxError > 0.0f) ? (kHeatmapSteps / options.heatmapMaxError) : FLT_MAX;
+    ctx.blockCols       = width / kBlockSize;
+
+    const bool useWindows = options.computeSSIM && (width >= 2 * kBlockSize) && (height >= 2 * kBlockSize);
+    if (useWindows) {
+        ctx.blockRows = height / kBlockSize;
+    }
+
+    const uint32_t         groupCount  = (height + kBlockSize - 1) / kBlockSize;
+    const uint32_t         threadCount = GetParallelThreadCount(groupCount, kMinGroupsPerThread, options.threadCount);
+    std::vector<BandStats> bands(threadCount);
+    ParallelForRanges(groupCount, threadCount, [&](uint32_t band, size_t begin, size_t end) {
+        CompareBand(ctx, static_cast<uint32_t>(begin), static_cast<uint32_t>(end), &bands[band]);
+    });
+
+    BandStats total;
+    for (const BandStats& band : bands) {
+        total.differentPixelCount += band.differentPixelCount;
+        for (uint32_t c = 0; c < 4; ++c) {
+            total.sumAbsError[c] += band.sumAbsError[c];
+            total.sumSqError[c] += band.sumSqError[c];
+            total.sumRelError[c] += band.sumRelError[c];
+            total.maxAbsError[c] = std::max(total.maxAbsError[c], band.maxAbsError[c]);
+            total.maxRelError[c] = std::max(total.maxRelError[c], band.maxRelError[c]);
+            total.sumSSIM[c] += band.sumSSIM[c];
+        }
+    }
+
+    if (options.computeSSIM) {
+        if (useWindows) {
+            const double windowCount = static_cast<double>(ctx.blockCols - 1) * (ctx.blockRows - 1);
+            for (uint32_t c = 0; c < 4; ++c) {
+                total.sumSSIM[c] /= windowCount;
+            }
+        }
+        else {
+            Accumulate(ComputeWholeImageSSIM(reference, test), total.sumSSIM);
+        }
+    }
+
+    *pStats                     = {};
+    pStats->width               = width;
+    pStats->height              = height;
+    pStats->channelCount        = channelCount;
+    pStats->differentPixelCount = total.differentPixelCount;
+
+    // Alpha does not contribute to the combined metrics of RGBA images.
+    const uint32_t colorChannelCount = (channelCount == 4) ? 3 : channelCount;
+    const double   pixelCount        = static_cast<double>(width) * height;
+    double         colorSqError      = 0;
+    double         colorSSIM         = 0;
+    for (uint32_t c = 0; c < channelCount; ++c) {
+        pStats->maxAbsError[c]  = total.maxAbsError[c];
+        pStats->meanAbsError[c] = total.sumAbsError[c] / pixelCount;
+        pStats->maxRelError[c]  = total.maxRelError[c];
+        pStats->meanRelError[c] = total.sumRelError[c] / pixelCount;
+        pStats->channelPSNR[c]  = ToPSNR(total.sumSqError[c] / pixelCount);
+        pStats->channelSSIM[c]  = total.sumSSIM[c];
+        if (c < colorChannelCount) {
+            colorSqError += total.sumSqError[c];
+            colorSSIM += total.sumSSIM[c];
+        }
+    }
+    pStats->psnr = ToPSNR(colorSqError / (pixelCount * colorChannelCount));
+    pStats->ssim = colorSSIM / colorChannelCount;
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
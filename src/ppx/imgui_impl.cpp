@@ -265,7 +265,7 @@ Result ImGuiImplVk::InitApiObjects(ppx::Application* pApp)
         init_info.Device                    = grfx::vk::ToApi(pApp->GetDevice())->GetVkDevice();
         init_info.QueueFamily               = grfx::vk::ToApi(pApp->GetGraphicsQueue())->GetQueueFamilyIndex();
         init_info.Queue                     = grfx::vk::ToApi(pApp->GetGraphicsQueue())->GetVkQueue();
-        init_info.PipelineCache             = VK_NULL_HANDLE;
+        init_info.PipelineCache             = grfx::vk::ToApi(pApp->GetDevice())->GetVkPipelineCache();
         init_info.DescriptorPool            = grfx::vk::ToApi(mPool)->GetVkDescriptorPool();
         init_info.MinImageCount             = pApp->GetUISwapchain()->GetImageCount();
         init_info.ImageCount                = pApp->GetUISwapchain()->GetImageCount();
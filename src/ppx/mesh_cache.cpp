@@ -0,0 +1,222 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/mesh_cache.h"
+#include "ppx/binary_file.h"
+
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace ppx {
+
+namespace {
+
+using internal::Put;
+using internal::PutString;
+
+const char kMagic[4] = {'P', 'P', 'M', 'C'};
+
+std::mutex            sCacheDirectoryMutex;
+std::filesystem::path sCacheDirectory;
+
+uint64_t HashBytes(const std::vector<uint8_t>& bytes)
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (uint8_t byte : bytes) {
+        hash = (hash ^ byte) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+uint64_t AlignStreamOffset(uint64_t offset)
+{
+    return RoundUp<uint64_t>(offset, MeshCacheFile::kStreamAlignment);
+}
+
+} // namespace
+
+std::filesystem::path MeshCacheFile::GetCachePath(
+    const std::filesystem::path& cacheDirectory,
+    const std::filesystem::path& sourcePath,
+    const TriMeshOptions&        options)
+{
+    // The name only depends on the path and the options; a change to the
+    // source file replaces its cache file instead of adding another one.
+    std::vector<uint8_t> nameKey;
+    PutString(&nameKey, std::filesystem::absolute(sourcePath).lexically_normal().string());
+    options.Serialize(&nameKey);
+
+    std::stringstream ss;
+    ss << sourcePath.stem().string() << "-" << std::hex << std::setw(16) << std::setfill('0') << HashBytes(nameKey) << ".ppxmesh";
+    return cacheDirectory / ss.str();
+}
+
+bool MeshCacheFile::GetKey(const std::filesystem::path& sourcePath, const TriMeshOptions& options, std::vector<uint8_t>* pKey)
+{
+    // Files that are not on disk (e.g. Android assets) have no modification
+    // time and cannot be cached.
+    std::error_code ec;
+    auto            writeTime = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    auto sourceSize = std::filesystem::file_size(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+
+    PutString(pKey, std::filesystem::absolute(sourcePath).lexically_normal().string());
+    Put<uint64_t>(pKey, static_cast<uint64_t>(sourceSize));
+    Put<int64_t>(pKey, static_cast<int64_t>(writeTime.time_since_epoch().count()));
+
+    std::vector<uint8_t> optionsBytes;
+    options.Serialize(&optionsBytes);
+    Put<uint32_t>(pKey, CountU32(optionsBytes));
+    pKey->insert(pKey->end(), optionsBytes.begin(), optionsBytes.end());
+    return true;
+}
+
+Result MeshCacheFile::Write(
+    const std::filesystem::path& cachePath,
+    const std::filesystem::path& sourcePath,
+    const TriMeshOptions&        options,
+    const Geometry&              geometry)
+{
+    std::vector<uint8_t> header;
+    if (!GetKey(sourcePath, options, &header)) {
+        return ppx::ERROR_FAILED;
+    }
+
+    grfx::MeshCreateInfo createInfo = grfx::MeshCreateInfo(geometry);
+    Put<uint32_t>(&header, static_cast<uint32_t>(createInfo.indexType));
+    Put<uint32_t>(&header, createInfo.indexCount);
+    Put<uint32_t>(&header, createInfo.vertexCount);
+    Put<uint32_t>(&header, createInfo.vertexBufferCount);
+    for (uint32_t i = 0; i < createInfo.vertexBufferCount; ++i) {
+        const grfx::MeshVertexBufferDescription& buffer = createInfo.vertexBuffers[i];
+        Put<uint32_t>(&header, buffer.stride);
+        Put<uint32_t>(&header, static_cast<uint32_t>(buffer.vertexInputRate));
+        Put<uint32_t>(&header, buffer.attributeCount);
+        for (uint32_t j = 0; j < buffer.attributeCount; ++j) {
+            Put<uint32_t>(&header, static_cast<uint32_t>(buffer.attributes[j].format));
+            Put<uint32_t>(&header, buffer.attributes[j].stride);
+            Put<uint32_t>(&header, static_cast<uint32_t>(buffer.attributes[j].vertexSemantic));
+        }
+    }
+
+    // Streams: the index buffer, then the vertex buffers.
+    std::vector<const Geometry::Buffer*> buffers;
+    buffers.push_back(geometry.GetIndexBuffer());
+    for (uint32_t i = 0; i < geometry.GetVertexBufferCount(); ++i) {
+        buffers.push_back(geometry.GetVertexBuffer(i));
+    }
+
+    size_t   streamTableSize = buffers.size() * 2 * sizeof(uint64_t);
+    uint64_t offset          = AlignStreamOffset(GetDataOffset(header.size() + streamTableSize));
+
+    std::vector<Stream> streams(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        streams[i].offset = offset;
+        streams[i].size   = buffers[i]->GetSize();
+        Put<uint64_t>(&header, streams[i].offset);
+        Put<uint64_t>(&header, streams[i].size);
+        offset = AlignStreamOffset(offset + streams[i].size);
+    }
+
+    return WriteFile(cachePath, kMagic, kVersion, header, [&](std::ostream& file) {
+        const char padding[kStreamAlignment] = {};
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            file.write(padding, streams[i].offset - static_cast<uint64_t>(file.tellp()));
+            file.write(buffers[i]->GetData(), streams[i].size);
+        }
+    });
+}
+
+Result MeshCacheFile::Open(
+    const std::filesystem::path& cachePath,
+    const std::filesystem::path& sourcePath,
+    const TriMeshOptions&        options)
+{
+    Unmap();
+    mCreateInfo = grfx::MeshCreateInfo();
+    mStreams.clear();
+
+    std::vector<uint8_t> key;
+    size_t               headerOffset = 0;
+    if (!GetKey(sourcePath, options, &key) || Failed(MapFile(cachePath, kMagic, kVersion, key, &headerOffset))) {
+        return ppx::ERROR_FAILED;
+    }
+
+    internal::ByteReader reader(GetFileData(), GetFileSize());
+    reader.Skip(headerOffset);
+
+    grfx::MeshCreateInfo createInfo = {};
+    uint32_t             indexType  = 0;
+    reader.Get(&indexType);
+    reader.Get(&createInfo.indexCount);
+    reader.Get(&createInfo.vertexCount);
+    reader.GetCount(PPX_MAX_VERTEX_BINDINGS, &createInfo.vertexBufferCount);
+    createInfo.indexType = static_cast<grfx::IndexType>(indexType);
+    for (uint32_t i = 0; reader.IsValid() && (i < createInfo.vertexBufferCount); ++i) {
+        grfx::MeshVertexBufferDescription& buffer    = createInfo.vertexBuffers[i];
+        uint32_t                           inputRate = 0;
+        reader.Get(&buffer.stride);
+        reader.Get(&inputRate);
+        reader.GetCount(PPX_MAX_VERTEX_BINDINGS, &buffer.attributeCount);
+        buffer.vertexInputRate = static_cast<grfx::VertexInputRate>(inputRate);
+        for (uint32_t j = 0; reader.IsValid() && (j < buffer.attributeCount); ++j) {
+            uint32_t format   = 0;
+            uint32_t semantic = 0;
+            reader.Get(&format);
+            reader.Get(&buffer.attributes[j].stride);
+            reader.Get(&semantic);
+            buffer.attributes[j].format         = static_cast<grfx::Format>(format);
+            buffer.attributes[j].vertexSemantic = static_cast<grfx::VertexSemantic>(semantic);
+        }
+    }
+
+    std::vector<Stream> streams(reader.IsValid() ? (1 + createInfo.vertexBufferCount) : 0);
+    for (Stream& stream : streams) {
+        reader.Get(&stream.offset);
+        reader.Get(&stream.size);
+        if ((stream.offset > GetFileSize()) || (stream.size > (GetFileSize() - stream.offset))) {
+            Unmap();
+            return ppx::ERROR_FAILED;
+        }
+    }
+    if (!reader.IsValid()) {
+        Unmap();
+        return ppx::ERROR_FAILED;
+    }
+
+    mCreateInfo = createInfo;
+    mStreams    = std::move(streams);
+    return ppx::SUCCESS;
+}
+
+void SetMeshCacheDirectory(const std::filesystem::path& directory)
+{
+    std::lock_guard<std::mutex> lock(sCacheDirectoryMutex);
+    sCacheDirectory = directory;
+}
+
+std::filesystem::path GetMeshCacheDirectory()
+{
+    std::lock_guard<std::mutex> lock(sCacheDirectoryMutex);
+    return sCacheDirectory;
+}
+
+} // namespace ppx
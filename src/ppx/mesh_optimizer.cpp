@@ -0,0 +1,385 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ppx {
+
+namespace {
+
+// Tuning of the vertex scores, from the original paper.
+constexpr uint32_t kForsythCacheSize    = 32;
+constexpr float    kCacheDecayPower     = 1.5f;
+constexpr float    kLastTriangleScore   = 0.75f;
+constexpr float    kValenceBoostScale   = 2.0f;
+constexpr float    kValenceBoostPower   = 0.5f;
+constexpr uint32_t kValenceScoreEntries = 64;
+
+class ForsythScores
+{
+public:
+    ForsythScores()
+    {
+        for (uint32_t i = 0; i < kForsythCacheSize; ++i) {
+            if (i < 3) {
+                mCacheScores[i] = kLastTriangleScore;
+            }
+            else {
+                float scaler    = 1.0f / static_cast<float>(kForsythCacheSize - 3);
+                mCacheScores[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, kCacheDecayPower);
+            }
+        }
+        mValenceScores[0] = 0;
+        for (uint32_t i = 1; i < kValenceScoreEntries; ++i) {
+            mValenceScores[i] = ValenceScore(i);
+        }
+    }
+
+    // Score of a vertex at cachePosition, -1 if not in the cache, that is
+    // used by remainingTriangles triangles that were not emitted yet.
+    float Get(int32_t cachePosition, uint32_t remainingTriangles) const
+    {
+        if (remainingTriangles == 0) {
+            return -1.0f;
+        }
+        float score = (cachePosition >= 0) ? mCacheScores[cachePosition] : 0.0f;
+        score += (remainingTriangles < kValenceScoreEntries) ? mValenceScores[remainingTriangles] : ValenceScore(remainingTriangles);
+        return score;
+    }
+
+private:
+    static float ValenceScore(uint32_t remainingTriangles)
+    {
+        return kValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+    }
+
+    float mCacheScores[kForsythCacheSize];
+    float mValenceScores[kValenceScoreEntries];
+};
+
+// FIFO cache simulation. A vertex is in the cache if fewer than cacheSize
+// vertices were transformed since it was.
+class FifoCache
+{
+public:
+    FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+        : mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+    // Returns true if the vertex had to be transformed.
+    bool Access(uint32_t vertex)
+    {
+        if ((mTime - mTimestamps[vertex]) > mCacheSize) {
+            mTimestamps[vertex] = mTime++;
+            return true;
+        }
+        return false;
+    }
+
+    uint32_t AccessTriangle(const uint32_t* pTriangle)
+    {
+        return static_cast<uint32_t>(Access(pTriangle[0])) + static_cast<uint32_t>(Access(pTriangle[1])) + static_cast<uint32_t>(Access(pTriangle[2]));
+    }
+
+    void Flush() { mTime += mCacheSize + 1; }
+
+private:
+    std::vector<uint32_t> mTimestamps;
+    uint32_t              mCacheSize = 0;
+    uint32_t              mTime      = 0;
+};
+
+} // namespace
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+    PPX_ASSERT_MSG((indexCount % 3) == 0, "index count must be a multiple of 3");
+
+    VertexCacheStatistics stats = {};
+    if (indexCount == 0) {
+        return stats;
+    }
+
+    FifoCache         cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t vertex = pIndices[i];
+        PPX_ASSERT_MSG(vertex < vertexCount, "vertex index out of range");
+        stats.transformedVertexCount += static_cast<uint32_t>(cache.Access(vertex));
+        if (!referenced[vertex]) {
+            referenced[vertex] = true;
+            stats.referencedVertexCount += 1;
+        }
+    }
+
+    stats.acmr = static_cast<float>(stats.transformedVertexCount) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(stats.transformedVertexCount) / static_cast<float>(stats.referencedVertexCount);
+    return stats;
+}
+
+void OptimizeVertexCache(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount)
+{
+    PPX_ASSERT_MSG((indexCount % 3) == 0, "index count must be a multiple of 3");
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    static const ForsythScores sScores;
+
+    // Triangles of each vertex. The first remaining[v] entries of the range
+    // of v are the triangles that were not emitted yet.
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; ++i) {
+        PPX_ASSERT_MSG(pIndices[i] < vertexCount, "vertex index out of range");
+        remaining[pIndices[i]] += 1;
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i) {
+            adjacency[cursors[pIndices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float>   vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        vertexScores[v] = sScores.Get(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    int64_t            bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* pTriangle = pIndices + 3 * t;
+        triangleScores[t]         = vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+        if (triangleScores[t] > triangleScores[bestTriangle]) {
+            bestTriangle = static_cast<int64_t>(t);
+        }
+    }
+
+    std::vector<uint32_t> output(indexCount);
+    std::vector<bool>     emitted(triangleCount, false);
+    size_t                deadEndCursor = 0;
+
+    // The cache holds kForsythCacheSize vertices; it briefly holds 3 more
+    // while a triangle is being added.
+    uint32_t cache[kForsythCacheSize + 3];
+    uint32_t newCache[kForsythCacheSize + 3];
+    uint32_t cacheCount = 0;
+
+    for (size_t outTriangle = 0; outTriangle < triangleCount; ++outTriangle) {
+        // When no triangle of the cache is left, restart from the first
+        // triangle in input order that was not emitted yet.
+        if (bestTriangle < 0) {
+            while (emitted[deadEndCursor]) {
+                ++deadEndCursor;
+            }
+            bestTriangle = static_cast<int64_t>(deadEndCursor);
+        }
+
+        const size_t    triangle  = static_cast<size_t>(bestTriangle);
+        const uint32_t* pTriangle = pIndices + 3 * triangle;
+        emitted[triangle]         = true;
+        std::copy(pTriangle, pTriangle + 3, output.data() + 3 * outTriangle);
+
+        uint32_t newCacheCount = 0;
+        for (uint32_t k = 0; k < 3; ++k) {
+            uint32_t  vertex = pTriangle[k];
+            uint32_t* pBegin = adjacency.data() + offsets[vertex];
+            uint32_t* pEnd   = pBegin + remaining[vertex];
+            uint32_t* pFound = std::find(pBegin, pEnd, static_cast<uint32_t>(triangle));
+            if (pFound != pEnd) {
+                std::swap(*pFound, *(pEnd - 1));
+                remaining[vertex] -= 1;
+            }
+
+            if (std::find(newCache, newCache + newCacheCount, vertex) == (newCache + newCacheCount)) {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i) {
+            uint32_t vertex = cache[i];
+            if ((vertex != pTriangle[0]) && (vertex != pTriangle[1]) && (vertex != pTriangle[2])) {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+
+        // Rescore the vertices of the cache, including the ones that just
+        // fell out of it, and the triangles that use them.
+        for (uint32_t i = 0; i < newCacheCount; ++i) {
+            uint32_t        vertex        = newCache[i];
+            int32_t         cachePosition = (i < kForsythCacheSize) ? static_cast<int32_t>(i) : -1;
+            float           score         = sScores.Get(cachePosition, remaining[vertex]);
+            float           delta         = score - vertexScores[vertex];
+            const uint32_t* pAdjacent     = adjacency.data() + offsets[vertex];
+            cachePositions[vertex]        = cachePosition;
+            vertexScores[vertex]          = score;
+            for (uint32_t j = 0; j < remaining[vertex]; ++j) {
+                triangleScores[pAdjacent[j]] += delta;
+            }
+        }
+
+        cacheCount = std::min(newCacheCount, kForsythCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        // The next triangle is the best one that uses a cached vertex.
+        bestTriangle    = -1;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (uint32_t i = 0; i < cacheCount; ++i) {
+            uint32_t        vertex    = cache[i];
+            const uint32_t* pAdjacent = adjacency.data() + offsets[vertex];
+            for (uint32_t j = 0; j < remaining[vertex]; ++j) {
+                if (triangleScores[pAdjacent[j]] > bestScore) {
+                    bestScore    = triangleScores[pAdjacent[j]];
+                    bestTriangle = static_cast<int64_t>(pAdjacent[j]);
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), pIndices);
+}
+
+void OptimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float3* pPositions, uint32_t vertexCount, float threshold)
+{
+    PPX_ASSERT_MSG((indexCount % 3) == 0, "index count must be a multiple of 3");
+    PPX_ASSERT_NULL_ARG(pPositions);
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Hard boundaries: triangles whose 3 vertices all miss the cache, where
+    // the triangle order can be cut without hurting the cache any further.
+    FifoCache           cache(vertexCount, kDefaultVertexCacheSize);
+    std::vector<size_t> hardBoundaries;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if ((cache.AccessTriangle(pIndices + 3 * t) == 3) || (t == 0)) {
+            hardBoundaries.push_back(t);
+        }
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Soft boundaries: within each hard cluster, cut as soon as the ACMR of
+    // the cluster so far is within threshold of the ACMR of the hard cluster.
+    std::vector<size_t> boundaries;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+        size_t begin = hardBoundaries[h];
+        size_t end   = hardBoundaries[h + 1];
+
+        cache.Flush();
+        uint32_t hardMisses = 0;
+        for (size_t t = begin; t < end; ++t) {
+            hardMisses += cache.AccessTriangle(pIndices + 3 * t);
+        }
+        float maxAcmr = threshold * static_cast<float>(hardMisses) / static_cast<float>(end - begin);
+
+        cache.Flush();
+        size_t   softBegin  = begin;
+        uint32_t softMisses = 0;
+        boundaries.push_back(begin);
+        for (size_t t = begin; t < end; ++t) {
+            softMisses += cache.AccessTriangle(pIndices + 3 * t);
+            if ((t + 1 < end) && (static_cast<float>(softMisses) <= maxAcmr * static_cast<float>(t + 1 - softBegin))) {
+                boundaries.push_back(t + 1);
+                softBegin  = t + 1;
+                softMisses = 0;
+                cache.Flush();
+            }
+        }
+    }
+    boundaries.push_back(triangleCount);
+
+    // Sort the clusters by how much they face away from the center of the mesh.
+    const size_t        clusterCount = boundaries.size() - 1;
+    std::vector<float>  sortKeys(clusterCount);
+    std::vector<float3> clusterCentroids(clusterCount, float3(0));
+    std::vector<float3> clusterNormals(clusterCount, float3(0));
+    float3              meshCentroid = float3(0);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float clusterArea = 0;
+        for (size_t t = boundaries[c]; t < boundaries[c + 1]; ++t) {
+            const float3& p0     = pPositions[pIndices[3 * t + 0]];
+            const float3& p1     = pPositions[pIndices[3 * t + 1]];
+            const float3& p2     = pPositions[pIndices[3 * t + 2]];
+            float3        normal = glm::cross(p1 - p0, p2 - p0);
+            float         area   = glm::length(normal);
+            float3        center = (p0 + p1 + p2) / 3.0f;
+
+            clusterCentroids[c] += center * area;
+            clusterNormals[c] += normal;
+            clusterArea += area;
+            meshCentroid += center;
+        }
+        if (clusterArea > 0) {
+            clusterCentroids[c] /= clusterArea;
+        }
+    }
+    meshCentroid /= static_cast<float>(triangleCount);
+
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float length = glm::length(clusterNormals[c]);
+        sortKeys[c]  = (length > 0) ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length) : 0.0f;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (size_t c : order) {
+        output.insert(output.end(), pIndices + 3 * boundaries[c], pIndices + 3 * boundaries[c + 1]);
+    }
+    std::copy(output.begin(), output.end(), pIndices);
+}
+
+uint32_t OptimizeVertexFetchRemap(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* pRemap)
+{
+    PPX_ASSERT_NULL_ARG(pRemap);
+
+    const uint32_t kUnassigned = UINT32_MAX;
+    pRemap->assign(vertexCount, kUnassigned);
+
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& newVertex = (*pRemap)[pIndices[i]];
+        if (newVertex == kUnassigned) {
+            newVertex = nextVertex++;
+        }
+        pIndices[i] = newVertex;
+    }
+
+    uint32_t referencedCount = nextVertex;
+    for (uint32_t& newVertex : *pRemap) {
+        if (newVertex == kUnassigned) {
+            newVertex = nextVertex++;
+        }
+    }
+    return referencedCount;
+}
+
+} // namespace ppx
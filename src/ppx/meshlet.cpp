@@ -0,0 +1,278 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/meshlet.h"
+#include "ppx/parallel.h"
+
+namespace ppx {
+
+namespace {
+
+// Below this cosine between the cone axis and a triangle normal, i.e. about
+// 84 degrees, the cone would almost never cull and is disabled.
+constexpr float kMinConeCosine = 0.1f;
+
+void ComputeMeshletBounds(const uint32_t* pLocalVertices, const uint8_t* pLocalTriangles, const float3* pPositions, Meshlet* pMeshlet)
+{
+    const uint32_t* pVertices  = pLocalVertices + pMeshlet->vertexOffset;
+    const uint8_t*  pTriangles = pLocalTriangles + 3 * static_cast<size_t>(pMeshlet->triangleOffset);
+
+    pMeshlet->bounds.Set(pPositions[pVertices[0]]);
+    for (uint32_t i = 1; i < pMeshlet->vertexCount; ++i) {
+        pMeshlet->bounds.Expand(pPositions[pVertices[i]]);
+    }
+
+    pMeshlet->sphereCenter = pMeshlet->bounds.GetCenter();
+    pMeshlet->sphereRadius = 0;
+    for (uint32_t i = 0; i < pMeshlet->vertexCount; ++i) {
+        pMeshlet->sphereRadius = std::max(pMeshlet->sphereRadius, glm::length(pPositions[pVertices[i]] - pMeshlet->sphereCenter));
+    }
+
+    // Normal cone: the axis is the average of the unit normals, and the
+    // cutoff is the sine of the widest angle between the axis and a normal.
+    std::vector<float3> normals;
+    normals.reserve(pMeshlet->triangleCount);
+    float3 axis = float3(0);
+    for (uint32_t t = 0; t < pMeshlet->triangleCount; ++t) {
+        const float3& p0     = pPositions[pVertices[pTriangles[3 * t + 0]]];
+        const float3& p1     = pPositions[pVertices[pTriangles[3 * t + 1]]];
+        const float3& p2     = pPositions[pVertices[pTriangles[3 * t + 2]]];
+        float3        normal = glm::cross(p1 - p0, p2 - p0);
+        float         length = glm::length(normal);
+        if (length > 0) {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+        else {
+            normals.push_back(float3(0));
+        }
+    }
+
+    pMeshlet->coneAxis   = float3(0);
+    pMeshlet->coneApex   = pMeshlet->sphereCenter;
+    pMeshlet->coneCutoff = 1;
+
+    float axisLength = glm::length(axis);
+    if (axisLength == 0) {
+        return;
+    }
+    axis /= axisLength;
+
+    float minCosine = 1;
+    for (const float3& normal : normals) {
+        if (normal != float3(0)) {
+            minCosine = std::min(minCosine, glm::dot(axis, normal));
+        }
+    }
+    if (minCosine <= kMinConeCosine) {
+        return;
+    }
+
+    // The apex is moved back along the axis until it is behind the plane of
+    // every triangle, so that the cone test is valid for any camera position.
+    float maxDistance = 0;
+    for (uint32_t t = 0; t < pMeshlet->triangleCount; ++t) {
+        if (normals[t] == float3(0)) {
+            continue;
+        }
+        const float3& p0       = pPositions[pVertices[pTriangles[3 * t]]];
+        float         distance = glm::dot(pMeshlet->sphereCenter - p0, normals[t]) / glm::dot(axis, normals[t]);
+        maxDistance            = std::max(maxDistance, distance);
+    }
+
+    pMeshlet->coneAxis   = axis;
+    pMeshlet->coneApex   = pMeshlet->sphereCenter - axis * maxDistance;
+    pMeshlet->coneCutoff = std::sqrt(1.0f - minCosine * minCosine);
+}
+
+// Builds the meshlets of the triangles [firstTriangle, endTriangle) into
+// pRangeData, with offsets relative to pRangeData. pVertexMeshlets and
+// pLocalIndices are scratch arrays of vertexCount entries.
+void BuildRangeMeshlets(
+    const uint32_t*        pIndices,
+    size_t                 firstTriangle,
+    size_t                 endTriangle,
+    const float3*          pPositions,
+    uint32_t               maxVertices,
+    uint32_t               maxTriangles,
+    std::vector<uint32_t>* pVertexMeshlets,
+    std::vector<uint8_t>*  pLocalIndices,
+    MeshletData*           pRangeData)
+{
+    // pVertexMeshlets holds, for each vertex, the stamp of the last meshlet
+    // that used it: the index of its first triangle plus one, which is unique
+    // across ranges so that the array never needs to be cleared.
+    std::vector<uint32_t>& vertexMeshlets = *pVertexMeshlets;
+    std::vector<uint8_t>&  localIndices   = *pLocalIndices;
+
+    Meshlet  meshlet      = {};
+    uint32_t meshletStamp = static_cast<uint32_t>(firstTriangle) + 1;
+    for (size_t t = firstTriangle; t < endTriangle; ++t) {
+        const uint32_t* pTriangle = pIndices + 3 * t;
+
+        uint32_t newVertexCount = 0;
+        for (uint32_t k = 0; k < 3; ++k) {
+            bool repeated = (k > 0 && pTriangle[k] == pTriangle[0]) || (k > 1 && pTriangle[k] == pTriangle[1]);
+            if (!repeated && (vertexMeshlets[pTriangle[k]] != meshletStamp)) {
+                ++newVertexCount;
+            }
+        }
+
+        if ((meshlet.vertexCount + newVertexCount > maxVertices) || (meshlet.triangleCount == maxTriangles)) {
+            pRangeData->meshlets.push_back(meshlet);
+            meshlet.vertexOffset   = CountU32(pRangeData->vertices);
+            meshlet.vertexCount    = 0;
+            meshlet.triangleOffset = CountU32(pRangeData->triangles) / 3;
+            meshlet.triangleCount  = 0;
+            meshletStamp           = static_cast<uint32_t>(t) + 1;
+        }
+
+        for (uint32_t k = 0; k < 3; ++k) {
+            uint32_t vertex = pTriangle[k];
+            if (vertexMeshlets[vertex] != meshletStamp) {
+                vertexMeshlets[vertex] = meshletStamp;
+                localIndices[vertex]   = static_cast<uint8_t>(meshlet.vertexCount++);
+                pRangeData->vertices.push_back(vertex);
+            }
+            pRangeData->triangles.push_back(localIndices[vertex]);
+        }
+        meshlet.triangleCount += 1;
+    }
+    if (meshlet.triangleCount > 0) {
+        pRangeData->meshlets.push_back(meshlet);
+    }
+
+    for (Meshlet& rangeMeshlet : pRangeData->meshlets) {
+        ComputeMeshletBounds(pRangeData->vertices.data(), pRangeData->triangles.data(), pPositions, &rangeMeshlet);
+    }
+}
+
+} // namespace
+
+MeshletDescriptor MeshletData::GetDescriptor(uint32_t meshletIndex) const
+{
+    const Meshlet& meshlet = meshlets[meshletIndex];
+
+    MeshletDescriptor descriptor = {};
+    descriptor.sphereCenter      = meshlet.sphereCenter;
+    descriptor.sphereRadius      = meshlet.sphereRadius;
+    descriptor.coneApex          = meshlet.coneApex;
+    descriptor.coneCutoff        = meshlet.coneCutoff;
+    descriptor.coneAxis          = meshlet.coneAxis;
+    descriptor.vertexOffset      = meshlet.vertexOffset;
+    descriptor.boundsMin         = meshlet.bounds.GetMin();
+    descriptor.triangleOffset    = meshlet.triangleOffset;
+    descriptor.boundsMax         = meshlet.bounds.GetMax();
+    descriptor.counts            = meshlet.vertexCount | (meshlet.triangleCount << 16);
+    return descriptor;
+}
+
+Result BuildMeshlets(
+    const uint32_t* pIndices,
+    size_t          indexCount,
+    const float3*   pPositions,
+    uint32_t        vertexCount,
+    uint32_t        maxVertices,
+    uint32_t        maxTriangles,
+    MeshletData*    pMeshletData,
+    uint32_t        threadCount)
+{
+    PPX_ASSERT_NULL_ARG(pMeshletData);
+    PPX_ASSERT_MSG((indexCount % 3) == 0, "index count must be a multiple of 3");
+
+    *pMeshletData = MeshletData();
+
+    if ((maxVertices < 3) || (maxVertices > kMeshletMaxVertices) || (maxTriangles < 1) || (maxTriangles > kMeshletMaxTriangles)) {
+        PPX_LOG_ERROR("Invalid meshlet limits: " << maxVertices << " vertices, " << maxTriangles << " triangles");
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (pIndices[i] >= vertexCount) {
+            PPX_LOG_ERROR("Meshlet vertex index out of range: " << pIndices[i]);
+            return ppx::ERROR_OUT_OF_RANGE;
+        }
+    }
+
+    const size_t triangleCount = indexCount / 3;
+    const size_t rangeCount    = (triangleCount + kMeshletBuildRangeTriangleCount - 1) / kMeshletBuildRangeTriangleCount;
+    if (rangeCount == 0) {
+        return ppx::SUCCESS;
+    }
+    if (threadCount == 0) {
+        threadCount = GetParallelThreadCount(rangeCount, 1);
+    }
+    threadCount = std::min<uint32_t>(threadCount, static_cast<uint32_t>(rangeCount));
+
+    std::vector<MeshletData> rangeData(rangeCount);
+    ParallelForRanges(rangeCount, threadCount, [&](uint32_t, size_t beginRange, size_t endRange) {
+        std::vector<uint32_t> vertexMeshlets(vertexCount, 0);
+        std::vector<uint8_t>  localIndices(vertexCount, 0);
+        for (size_t range = beginRange; range < endRange; ++range) {
+            size_t firstTriangle = range * kMeshletBuildRangeTriangleCount;
+            size_t endTriangle   = std::min(triangleCount, firstTriangle + kMeshletBuildRangeTriangleCount);
+            BuildRangeMeshlets(pIndices, firstTriangle, endTriangle, pPositions, maxVertices, maxTriangles, &vertexMeshlets, &localIndices, &rangeData[range]);
+        }
+    });
+
+    size_t meshletCount       = 0;
+    size_t meshletVertexCount = 0;
+    for (const MeshletData& data : rangeData) {
+        meshletCount += data.meshlets.size();
+        meshletVertexCount += data.vertices.size();
+    }
+    pMeshletData->meshlets.reserve(meshletCount);
+    pMeshletData->vertices.reserve(meshletVertexCount);
+    pMeshletData->triangles.reserve(indexCount);
+
+    for (const MeshletData& data : rangeData) {
+        uint32_t vertexOffset   = CountU32(pMeshletData->vertices);
+        uint32_t triangleOffset = CountU32(pMeshletData->triangles) / 3;
+        for (Meshlet meshlet : data.meshlets) {
+            meshlet.vertexOffset += vertexOffset;
+            meshlet.triangleOffset += triangleOffset;
+            pMeshletData->meshlets.push_back(meshlet);
+        }
+        pMeshletData->vertices.insert(pMeshletData->vertices.end(), data.vertices.begin(), data.vertices.end());
+        pMeshletData->triangles.insert(pMeshletData->triangles.end(), data.triangles.begin(), data.triangles.end());
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result BuildMeshlets(
+    const TriMesh& mesh,
+    MeshletData*   pMeshletData,
+    uint32_t       maxVertices,
+    uint32_t       maxTriangles,
+    uint32_t       threadCount)
+{
+    // Non-indexed meshes use their vertices in order.
+    std::vector<uint32_t> indices;
+    if (mesh.GetIndexType() == grfx::INDEX_TYPE_UNDEFINED) {
+        indices.resize(mesh.GetCountPositions());
+        for (uint32_t i = 0; i < mesh.GetCountPositions(); ++i) {
+            indices[i] = i;
+        }
+    }
+    else {
+        indices.resize(mesh.GetCountIndices());
+        for (uint32_t i = 0; i < mesh.GetCountIndices(); ++i) {
+            indices[i] = (mesh.GetIndexType() == grfx::INDEX_TYPE_UINT16) ? *mesh.GetDataIndicesU16(i) : *mesh.GetDataIndicesU32(i);
+        }
+    }
+
+    return BuildMeshlets(indices.data(), indices.size(), mesh.GetDataPositions(), mesh.GetCountPositions(), maxVertices, maxTriangles, pMeshletData, threadCount);
+}
+
+} // namespace ppx
@@ -13,7 +13,12 @@
 // limitations under the License.
 
 #include "ppx/metrics.h"
+#include "ppx/metrics_binary_report.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <regex>
 #include <sstream>
 
@@ -37,6 +42,171 @@ nlohmann::json MetricMetadata::Export() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void QuantileSketch::Store::Add(int32_t index, uint64_t count, uint32_t maxBucketCount)
+{
+    total += count;
+    if (counts.empty()) {
+        minIndex = index;
+        counts.push_back(count);
+        return;
+    }
+
+    int32_t maxIndex = GetMaxIndex();
+    if (index >= minIndex && index <= maxIndex) {
+        counts[index - minIndex] += count;
+        return;
+    }
+
+    // Grow the store to cover the new index. If the range becomes too large,
+    // the lowest buckets are collapsed into the lowest remaining one.
+    int32_t newMinIndex = std::min(minIndex, index);
+    int32_t newMaxIndex = std::max(maxIndex, index);
+    if (static_cast<int64_t>(newMaxIndex) - newMinIndex + 1 > maxBucketCount) {
+        newMinIndex = newMaxIndex - static_cast<int32_t>(maxBucketCount) + 1;
+    }
+
+    std::vector<uint64_t> newCounts(static_cast<size_t>(newMaxIndex - newMinIndex + 1), 0);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        int32_t oldIndex = minIndex + static_cast<int32_t>(i);
+        newCounts[std::max(oldIndex, newMinIndex) - newMinIndex] += counts[i];
+    }
+    newCounts[std::max(index, newMinIndex) - newMinIndex] += count;
+
+    counts   = std::move(newCounts);
+    minIndex = newMinIndex;
+}
+
+int32_t QuantileSketch::Store::GetIndexAtRank(uint64_t rank) const
+{
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        cumulative += counts[i];
+        if (cumulative > rank) {
+            return minIndex + static_cast<int32_t>(i);
+        }
+    }
+    return GetMaxIndex();
+}
+
+QuantileSketch::QuantileSketch(double relativeAccuracy, uint32_t maxBucketCount)
+    : mRelativeAccuracy(relativeAccuracy),
+      mMaxBucketCount(maxBucketCount)
+{
+    PPX_ASSERT_MSG((relativeAccuracy > 0.0) && (relativeAccuracy < 1.0), "Relative accuracy must be in (0, 1)");
+    PPX_ASSERT_MSG(maxBucketCount > 0, "Bucket count must be greater than 0");
+    mGamma    = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+    mLogGamma = std::log(mGamma);
+}
+
+int32_t QuantileSketch::GetIndex(double absValue) const
+{
+    // With a small relative accuracy, the logarithm of values near the ends
+    // of the double range leaves the int32 range. Clamp with enough margin
+    // for the store to offset indices by the bucket count.
+    const double kMaxIndex = static_cast<double>(1 << 30);
+    double       index     = std::ceil(std::log(absValue) / mLogGamma);
+    return static_cast<int32_t>(std::clamp(index, -kMaxIndex, kMaxIndex));
+}
+
+double QuantileSketch::GetValue(int32_t index) const
+{
+    // Any value in (gamma^(index-1), gamma^index] is within the relative
+    // accuracy of this estimate. The bucket of the largest doubles may have
+    // an estimate that is not representable.
+    double value = 2.0 * std::pow(mGamma, index) / (mGamma + 1.0);
+    return std::min(value, std::numeric_limits<double>::max());
+}
+
+void QuantileSketch::Add(double value)
+{
+    if (!std::isfinite(value)) {
+        return;
+    }
+
+    ++mCount;
+    if (value > 0.0) {
+        mPositive.Add(GetIndex(value), 1, mMaxBucketCount);
+    }
+    else if (value < 0.0) {
+        mNegative.Add(GetIndex(-value), 1, mMaxBucketCount);
+    }
+    else {
+        ++mZeroCount;
+    }
+}
+
+bool QuantileSketch::Merge(const QuantileSketch& other)
+{
+    if ((other.mRelativeAccuracy != mRelativeAccuracy) || (other.mMaxBucketCount != mMaxBucketCount)) {
+        PPX_LOG_ERROR("Cannot merge quantile sketches with different parameters.");
+        return false;
+    }
+
+    for (size_t i = 0; i < other.mPositive.counts.size(); ++i) {
+        if (other.mPositive.counts[i] > 0) {
+            mPositive.Add(other.mPositive.minIndex + static_cast<int32_t>(i), other.mPositive.counts[i], mMaxBucketCount);
+        }
+    }
+    for (size_t i = 0; i < other.mNegative.counts.size(); ++i) {
+        if (other.mNegative.counts[i] > 0) {
+            mNegative.Add(other.mNegative.minIndex + static_cast<int32_t>(i), other.mNegative.counts[i], mMaxBucketCount);
+        }
+    }
+    mZeroCount += other.mZeroCount;
+    mCount += other.mCount;
+    return true;
+}
+
+double QuantileSketch::GetValueAtRank(uint64_t rank) const
+{
+    if (mCount == 0) {
+        return 0.0;
+    }
+    rank = std::min(rank, mCount - 1);
+
+    // Negative values come first, in decreasing order of magnitude.
+    if (rank < mNegative.total) {
+        return -GetValue(mNegative.GetIndexAtRank(mNegative.total - 1 - rank));
+    }
+    rank -= mNegative.total;
+
+    if (rank < mZeroCount) {
+        return 0.0;
+    }
+    rank -= mZeroCount;
+
+    return GetValue(mPositive.GetIndexAtRank(rank));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RunningMoments::Add(double value)
+{
+    ++count;
+    double delta = value - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (value - mean);
+}
+
+void RunningMoments::Merge(const RunningMoments& other)
+{
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+
+    double n     = static_cast<double>(count + other.count);
+    double delta = other.mean - mean;
+    mean += delta * static_cast<double>(other.count) / n;
+    m2 += other.m2 + delta * delta * static_cast<double>(count) * static_cast<double>(other.count) / n;
+    count += other.count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool MetricGauge::RecordEntry(const MetricData& data)
 {
     if (data.type != MetricType::GAUGE) {
@@ -49,8 +219,8 @@ bool MetricGauge::RecordEntry(const MetricData& data)
         return false;
     }
 
-    auto entryCount = mTimeSeries.size();
-    if (entryCount > 0 && data.gauge.seconds <= mTimeSeries.back().seconds) {
+    auto entryCount = mEntryCount;
+    if (entryCount > 0 && data.gauge.seconds <= mLastSeconds) {
         PPX_LOG_ERROR("Provided gauge metric had old seconds value; ignoring.");
         return false;
     }
@@ -60,6 +230,9 @@ bool MetricGauge::RecordEntry(const MetricData& data)
     entry.value   = data.gauge.value;
     // This entry will be added at the end; update the count now for calculations.
     ++entryCount;
+    if (entryCount == 1) {
+        mFirstSeconds = entry.seconds;
+    }
 
     // Update the basic stats.
     mAccumulatedValue += entry.value;
@@ -68,15 +241,28 @@ bool MetricGauge::RecordEntry(const MetricData& data)
     mBasicStats.average = mAccumulatedValue / entryCount;
     // Above checks guarantee the 'seconds' field monotonically increases with each entry.
     mBasicStats.timeRatio = (entryCount > 1)
-                                ? mAccumulatedValue / (entry.seconds - mTimeSeries.front().seconds)
+                                ? mAccumulatedValue / (entry.seconds - mFirstSeconds)
                                 : entry.value;
 
-    mTimeSeries.emplace_back(std::move(entry));
+    mEntryCount  = entryCount;
+    mLastSeconds = entry.seconds;
+
+    if (IsStreaming()) {
+        mSketch.Add(entry.value);
+        mMoments.Add(entry.value);
+    }
+    if (KeepsTimeSeries()) {
+        mTimeSeries.emplace_back(std::move(entry));
+    }
     return true;
 }
 
 ppx::metrics::GaugeComplexStatistics MetricGauge::ComputeComplexStats() const
 {
+    if (IsStreaming()) {
+        return EstimateComplexStats();
+    }
+
     GaugeComplexStatistics complex;
     size_t                 entryCount = mTimeSeries.size();
     if (entryCount == 0) {
@@ -113,12 +299,36 @@ ppx::metrics::GaugeComplexStatistics MetricGauge::ComputeComplexStats() const
     return complex;
 }
 
-nlohmann::json MetricGauge::Export() const
+ppx::metrics::GaugeComplexStatistics MetricGauge::EstimateComplexStats() const
 {
-    nlohmann::json metricObject;
-    nlohmann::json statsObject;
+    GaugeComplexStatistics complex;
+    uint64_t               entryCount = mSketch.GetCount();
+    if (entryCount == 0) {
+        return complex;
+    }
 
-    metricObject["metadata"] = mMetadata.Export();
+    // Same ranks as the exact computation, so that both modes agree up to the
+    // sketch's relative accuracy.
+    auto medianIndex = entryCount / 2;
+    complex.median   = (entryCount % 2 == 0)
+                           ? (mSketch.GetValueAtRank(medianIndex - 1) + mSketch.GetValueAtRank(medianIndex)) * 0.5
+                           : mSketch.GetValueAtRank(medianIndex);
+
+    complex.standardDeviation = sqrt(mMoments.GetVariance());
+
+    complex.percentile01 = mSketch.GetValueAtRank(entryCount * 1 / 100);
+    complex.percentile05 = mSketch.GetValueAtRank(entryCount * 5 / 100);
+    complex.percentile10 = mSketch.GetValueAtRank(entryCount * 10 / 100);
+    complex.percentile90 = mSketch.GetValueAtRank(entryCount * 90 / 100);
+    complex.percentile95 = mSketch.GetValueAtRank(entryCount * 95 / 100);
+    complex.percentile99 = mSketch.GetValueAtRank(entryCount * 99 / 100);
+
+    return complex;
+}
+
+nlohmann::json MetricGauge::ExportStatistics() const
+{
+    nlohmann::json statsObject;
 
     GaugeComplexStatistics complex    = ComputeComplexStats();
     statsObject["min"]                = mBasicStats.min;
@@ -133,8 +343,19 @@ nlohmann::json MetricGauge::Export() const
     statsObject["percentile_90"]      = complex.percentile90;
     statsObject["percentile_95"]      = complex.percentile95;
     statsObject["percentile_99"]      = complex.percentile99;
+    if (IsStreaming()) {
+        statsObject["quantile_relative_accuracy"] = mSketch.GetRelativeAccuracy();
+    }
+
+    return statsObject;
+}
+
+nlohmann::json MetricGauge::Export() const
+{
+    nlohmann::json metricObject;
 
-    metricObject["statistics"] = statsObject;
+    metricObject["metadata"]   = mMetadata.Export();
+    metricObject["statistics"] = ExportStatistics();
 
     metricObject["time_series"] = nlohmann::json::array();
     for (const auto& entry : mTimeSeries) {
@@ -229,15 +450,108 @@ nlohmann::json Run::Export() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class Manager::ThreadBuffer
+{
+public:
+    ThreadBuffer()
+    {
+        mHead = mTail = new Block();
+    }
+
+    ~ThreadBuffer()
+    {
+        while (mHead != nullptr) {
+            Block* pNext = mHead->next.load(std::memory_order_relaxed);
+            delete mHead;
+            mHead = pNext;
+        }
+    }
+
+    // Producer side.
+    void Append(const PendingEntry& entry)
+    {
+        uint32_t count = mTail->count.load(std::memory_order_relaxed);
+        if (count == kBlockSize) {
+            Block* pBlock = new Block();
+            mTail->next.store(pBlock, std::memory_order_release);
+            mTail = pBlock;
+            count = 0;
+        }
+        mTail->entries[count] = entry;
+        mTail->count.store(count + 1, std::memory_order_release);
+    }
+
+    // Consumer side.
+    void Drain(std::vector<PendingEntry>* pEntries)
+    {
+        for (;;) {
+            uint32_t count = mHead->count.load(std::memory_order_acquire);
+            for (; mReadIndex < count; ++mReadIndex) {
+                pEntries->push_back(mHead->entries[mReadIndex]);
+            }
+            if (mReadIndex < kBlockSize) {
+                return;
+            }
+            // The producer only links a new block once the current one is full,
+            // so a fully read block with a successor is no longer referenced.
+            Block* pNext = mHead->next.load(std::memory_order_acquire);
+            if (pNext == nullptr) {
+                return;
+            }
+            delete mHead;
+            mHead      = pNext;
+            mReadIndex = 0;
+        }
+    }
+
+private:
+    static constexpr uint32_t kBlockSize = 256;
+
+    struct Block
+    {
+        std::array<PendingEntry, kBlockSize> entries;
+        std::atomic<uint32_t>                count = 0;
+        std::atomic<Block*>                  next  = nullptr;
+    };
+
+    // Consumer only.
+    Block*   mHead      = nullptr;
+    uint32_t mReadIndex = 0;
+    // Producer only.
+    Block* mTail = nullptr;
+};
+
+static std::atomic<uint64_t> sNextManagerInstanceId = 1;
+
+Manager::Manager()
+    : mInstanceId(sNextManagerInstanceId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+Manager::~Manager()
+{
+    StopBinaryReport();
+}
+
 void Manager::StartRun(const std::string& name)
 {
     PPX_ASSERT_MSG(!name.empty(), "A run name must not be empty");
     PPX_ASSERT_MSG(mRuns.find(name) == mRuns.end(), "All runs must have unique names (duplicate name detected)");
     PPX_ASSERT_MSG(mActiveRun == nullptr, "Only one run may be active at a time!");
 
+    // Drop entries of earlier runs that were appended after they ended.
+    FlushConcurrentData();
+
     mActiveRun = new Run(name);
     auto run   = std::unique_ptr<Run>(mActiveRun);
     mRuns.emplace(name, std::move(run));
+
+    mActiveRunEpoch = mNextRunEpoch++;
+    mConcurrentRunEpoch.store(mActiveRunEpoch, std::memory_order_release);
+
+    if (mBinaryReport) {
+        mBinaryReport->BeginRun(name);
+    }
 }
 
 void Manager::EndRun()
@@ -246,6 +560,31 @@ void Manager::EndRun()
         PPX_LOG_ERROR("Requested to end run with no active run!");
     }
 
+    // Stop accepting data before the last flush. Entries appended after the
+    // flush are still tagged with this run and are dropped by later flushes.
+    mConcurrentRunEpoch.store(0, std::memory_order_release);
+    FlushConcurrentData();
+    mActiveRunEpoch = 0;
+
+    if (mBinaryReport && (mActiveRun != nullptr)) {
+        // Write the summaries in creation order.
+        std::vector<MetricID> ids;
+        for (const auto& [id, pMetric] : mActiveMetrics) {
+            ids.push_back(id);
+        }
+        std::sort(ids.begin(), ids.end());
+        for (MetricID id : ids) {
+            const Metric* pMetric = mActiveMetrics[id];
+            if (pMetric->GetType() == MetricType::GAUGE) {
+                mBinaryReport->WriteGaugeStatistics(id, static_cast<const MetricGauge*>(pMetric)->ExportStatistics());
+            }
+            else {
+                mBinaryReport->WriteCounterSummary(id, pMetric->Export());
+            }
+        }
+        mBinaryReport->EndRun();
+    }
+
     mActiveRun = nullptr;
     mActiveMetrics.clear();
 }
@@ -267,6 +606,9 @@ MetricID Manager::AddMetric(const MetricMetadata& metadata)
     }
     auto metricID = mNextMetricID++;
     mActiveMetrics.emplace(metricID, metric);
+    if (mBinaryReport) {
+        mBinaryReport->AddMetric(metricID, metadata);
+    }
     return metricID;
 }
 
@@ -281,11 +623,87 @@ bool Manager::RecordMetricData(MetricID id, const MetricData& data)
         PPX_LOG_ERROR("Attempted to record a metric entry against an invalid ID.");
         return false;
     }
-    return findResult->second->RecordEntry(data);
+    if (!findResult->second->RecordEntry(data)) {
+        return false;
+    }
+    if (mBinaryReport && (data.type == MetricType::GAUGE)) {
+        mBinaryReport->AppendGaugeEntry(id, data.gauge.seconds, data.gauge.value);
+    }
+    return true;
+}
+
+Manager::ThreadBuffer* Manager::GetThreadBuffer()
+{
+    // Cache the buffer of the last manager used by this thread, so that the
+    // common case does not need to take the lock.
+    thread_local uint64_t      sCachedInstanceId = 0;
+    thread_local ThreadBuffer* sCachedBuffer     = nullptr;
+    if (sCachedInstanceId == mInstanceId) {
+        return sCachedBuffer;
+    }
+
+    std::lock_guard<std::mutex> lock(mThreadBuffersMutex);
+    auto&                       buffer = mThreadBuffers[std::this_thread::get_id()];
+    if (!buffer) {
+        buffer = std::make_unique<ThreadBuffer>();
+    }
+    sCachedInstanceId = mInstanceId;
+    sCachedBuffer     = buffer.get();
+    return sCachedBuffer;
+}
+
+bool Manager::RecordMetricDataConcurrent(MetricID id, const MetricData& data)
+{
+    uint64_t runEpoch = mConcurrentRunEpoch.load(std::memory_order_acquire);
+    if (runEpoch == 0) {
+        return false;
+    }
+    GetThreadBuffer()->Append({runEpoch, id, data});
+    return true;
+}
+
+void Manager::FlushConcurrentData()
+{
+    mPendingEntries.clear();
+    {
+        std::lock_guard<std::mutex> lock(mThreadBuffersMutex);
+        for (auto& [threadId, buffer] : mThreadBuffers) {
+            buffer->Drain(&mPendingEntries);
+        }
+    }
+    if (mPendingEntries.empty() || (mActiveRun == nullptr)) {
+        return;
+    }
+
+    // Entries from different threads interleave arbitrarily; gauges require
+    // increasing 'seconds', so apply them in time order. Counters are
+    // order-independent and go first.
+    std::stable_sort(
+        mPendingEntries.begin(), mPendingEntries.end(), [](const PendingEntry& lhs, const PendingEntry& rhs) {
+            double lhsSeconds = (lhs.data.type == MetricType::GAUGE) ? lhs.data.gauge.seconds : -std::numeric_limits<double>::infinity();
+            double rhsSeconds = (rhs.data.type == MetricType::GAUGE) ? rhs.data.gauge.seconds : -std::numeric_limits<double>::infinity();
+            return lhsSeconds < rhsSeconds;
+        });
+
+    for (const auto& entry : mPendingEntries) {
+        if (entry.runEpoch != mActiveRunEpoch) {
+            continue;
+        }
+        auto findResult = mActiveMetrics.find(entry.id);
+        if (findResult == mActiveMetrics.end()) {
+            PPX_LOG_ERROR("Attempted to record a concurrent metric entry against an invalid ID.");
+            continue;
+        }
+        if (findResult->second->RecordEntry(entry.data) && mBinaryReport && (entry.data.type == MetricType::GAUGE)) {
+            mBinaryReport->AppendGaugeEntry(entry.id, entry.data.gauge.seconds, entry.data.gauge.value);
+        }
+    }
 }
 
-Report Manager::CreateReport(const std::string& reportPath) const
+Report Manager::CreateReport(const std::string& reportPath)
 {
+    FlushConcurrentData();
+
     nlohmann::json content;
     content["runs"] = nlohmann::json::array();
     for (const auto& [name, pRun] : mRuns) {
@@ -315,6 +733,33 @@ GaugeBasicStatistics Manager::GetGaugeBasicStatistics(MetricID id) const
     return static_cast<MetricGauge*>(findResult->second)->GetBasicStatistics();
 }
 
+bool Manager::StartBinaryReport(const std::string& reportPath, bool overwriteExisting)
+{
+    if (mActiveRun != nullptr) {
+        PPX_LOG_ERROR("A binary metrics report cannot be started while a run is active.");
+        return false;
+    }
+    if (mBinaryReport) {
+        PPX_LOG_ERROR("A binary metrics report is already being written.");
+        return false;
+    }
+
+    auto binaryReport = std::make_unique<BinaryReportWriter>();
+    if (!binaryReport->Open(reportPath, overwriteExisting)) {
+        return false;
+    }
+    mBinaryReport = std::move(binaryReport);
+    return true;
+}
+
+void Manager::StopBinaryReport()
+{
+    if (mBinaryReport) {
+        mBinaryReport->Close();
+        mBinaryReport.reset();
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 Report::Report(const nlohmann::json& content, const std::string& reportPath)
@@ -0,0 +1,440 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/metrics_binary_report.h"
+#include "ppx/binary_file.h"
+
+#include "ppx/fs.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+namespace ppx {
+namespace metrics {
+
+namespace {
+
+using ppx::internal::ByteReader;
+using ppx::internal::Put;
+using ppx::internal::PutString;
+using ppx::internal::PutVarint;
+
+const char     kMagic[4]      = {'P', 'P', 'X', 'M'};
+const double   kNanosPerSec   = 1e9;
+const uint32_t kChunkIdSize   = 4;
+const uint32_t kChunkHeadSize = kChunkIdSize + sizeof(uint32_t);
+
+bool IsChunk(const char* chunkId, const char* expected)
+{
+    return std::memcmp(chunkId, expected, kChunkIdSize) == 0;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+BinaryReportWriter::~BinaryReportWriter()
+{
+    Close();
+}
+
+bool BinaryReportWriter::Open(const std::string& reportPath, bool overwriteExisting)
+{
+    PPX_ASSERT_MSG(!IsOpen(), "Binary report is already open");
+
+    std::stringstream timeStream;
+    timeStream << std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+    mFilePath = ppx::fs::GetFullPath(std::filesystem::path(reportPath), ppx::fs::GetDefaultOutputDirectory(), "@", timeStream.str());
+
+    if (!overwriteExisting && std::filesystem::exists(mFilePath)) {
+        PPX_LOG_ERROR("Binary metrics report cannot be written to disk. Path [" << mFilePath << "] already exists.");
+        return false;
+    }
+
+    std::filesystem::create_directories(mFilePath.parent_path());
+    mFile.open(mFilePath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!mFile.is_open()) {
+        PPX_LOG_ERROR("Failed to open binary metrics file at path [" << mFilePath << "] for writing!");
+        return false;
+    }
+
+    mFile.write(kMagic, sizeof(kMagic));
+    mScratch.clear();
+    Put<uint32_t>(&mScratch, kVersion);
+    mFile.write(reinterpret_cast<const char*>(mScratch.data()), mScratch.size());
+
+    mScratch.clear();
+    PutString(&mScratch, mFilePath.filename().string());
+    PutString(&mScratch, timeStream.str());
+    WriteChunk("HEAD", mScratch);
+    return true;
+}
+
+void BinaryReportWriter::Close()
+{
+    if (!IsOpen()) {
+        return;
+    }
+
+    // A run that was not ended still gets its entries written.
+    for (MetricID id : mGaugeOrder) {
+        WriteGaugeBlock(id, &mGauges[id]);
+    }
+    mGauges.clear();
+    mGaugeOrder.clear();
+
+    mFile.close();
+    PPX_LOG_INFO("Binary metrics report written to path [" << mFilePath << "]");
+}
+
+void BinaryReportWriter::BeginRun(const std::string& name)
+{
+    mScratch.clear();
+    PutString(&mScratch, name);
+    WriteChunk("RUN ", mScratch);
+}
+
+void BinaryReportWriter::AddMetric(MetricID id, const MetricMetadata& metadata)
+{
+    mScratch.clear();
+    Put<uint32_t>(&mScratch, id);
+    Put<uint32_t>(&mScratch, static_cast<uint32_t>(metadata.type));
+    PutString(&mScratch, metadata.name);
+    PutString(&mScratch, metadata.unit);
+    Put<uint32_t>(&mScratch, static_cast<uint32_t>(metadata.interpretation));
+    Put<double>(&mScratch, metadata.expectedRange.lowerBound);
+    Put<double>(&mScratch, metadata.expectedRange.upperBound);
+    WriteChunk("META", mScratch);
+
+    if (metadata.type == MetricType::GAUGE) {
+        auto& columns = mGauges[id];
+        columns.nanos.reserve(kGaugeEntriesPerBlock);
+        columns.values.reserve(kGaugeEntriesPerBlock);
+        mGaugeOrder.push_back(id);
+    }
+}
+
+void BinaryReportWriter::AppendGaugeEntry(MetricID id, double seconds, double value)
+{
+    auto it = mGauges.find(id);
+    if (it == mGauges.end()) {
+        return;
+    }
+
+    GaugeColumns& columns = it->second;
+    columns.nanos.push_back(std::llround(seconds * kNanosPerSec));
+    columns.values.push_back(static_cast<float>(value));
+    if (columns.nanos.size() >= kGaugeEntriesPerBlock) {
+        WriteGaugeBlock(id, &columns);
+    }
+}
+
+void BinaryReportWriter::WriteGaugeStatistics(MetricID id, const nlohmann::json& statistics)
+{
+    auto it = mGauges.find(id);
+    if (it != mGauges.end()) {
+        WriteGaugeBlock(id, &it->second);
+    }
+
+    mScratch.clear();
+    Put<uint32_t>(&mScratch, id);
+    Put<uint32_t>(&mScratch, static_cast<uint32_t>(statistics.size()));
+    for (const auto& item : statistics.items()) {
+        PutString(&mScratch, item.key());
+        Put<double>(&mScratch, item.value().get<double>());
+    }
+    WriteChunk("GSTA", mScratch);
+}
+
+void BinaryReportWriter::WriteCounterSummary(MetricID id, const nlohmann::json& exported)
+{
+    mScratch.clear();
+    Put<uint32_t>(&mScratch, id);
+    Put<uint64_t>(&mScratch, exported["value"].get<uint64_t>());
+    Put<uint64_t>(&mScratch, exported["entry_count"].get<uint64_t>());
+    WriteChunk("CNTR", mScratch);
+}
+
+void BinaryReportWriter::EndRun()
+{
+    for (MetricID id : mGaugeOrder) {
+        WriteGaugeBlock(id, &mGauges[id]);
+    }
+    mGauges.clear();
+    mGaugeOrder.clear();
+
+    mScratch.clear();
+    WriteChunk("END ", mScratch);
+    mFile.flush();
+}
+
+void BinaryReportWriter::WriteGaugeBlock(MetricID id, GaugeColumns* pColumns)
+{
+    uint32_t count = static_cast<uint32_t>(pColumns->nanos.size());
+    if (count == 0) {
+        return;
+    }
+
+    mScratch.clear();
+    Put<uint32_t>(&mScratch, id);
+    Put<uint32_t>(&mScratch, count);
+    Put<int64_t>(&mScratch, pColumns->nanos[0]);
+    // Entries are recorded in strictly increasing time, so deltas are positive
+    // (or zero if two entries are less than a nanosecond apart).
+    for (uint32_t i = 1; i < count; ++i) {
+        PutVarint(&mScratch, static_cast<uint64_t>(std::max<int64_t>(pColumns->nanos[i] - pColumns->nanos[i - 1], 0)));
+    }
+    size_t offset = mScratch.size();
+    mScratch.resize(offset + count * sizeof(float));
+    std::memcpy(mScratch.data() + offset, pColumns->values.data(), count * sizeof(float));
+    WriteChunk("GAUG", mScratch);
+
+    pColumns->nanos.clear();
+    pColumns->values.clear();
+
+    // Make the block durable, so that a crash only loses the current block.
+    mFile.flush();
+}
+
+void BinaryReportWriter::WriteChunk(const char* chunkId, const std::vector<uint8_t>& payload)
+{
+    if (!IsOpen()) {
+        return;
+    }
+    uint32_t payloadSize = static_cast<uint32_t>(payload.size());
+    mFile.write(chunkId, kChunkIdSize);
+    mFile.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+    mFile.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ReadBinaryReport(const std::filesystem::path& path, nlohmann::json* pContent)
+{
+    PPX_ASSERT_NULL_ARG(pContent);
+
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) {
+        PPX_LOG_ERROR("Failed to open binary metrics file at path [" << path << "] for reading!");
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    uint32_t version = 0;
+    if ((data.size() < sizeof(kMagic) + sizeof(version)) || (std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)) {
+        PPX_LOG_ERROR("File at path [" << path << "] is not a binary metrics report.");
+        return false;
+    }
+    std::memcpy(&version, data.data() + sizeof(kMagic), sizeof(version));
+    if (version != BinaryReportWriter::kVersion) {
+        PPX_LOG_ERROR("Unsupported binary metrics report version: " << version);
+        return false;
+    }
+
+    nlohmann::json content;
+    content["runs"] = nlohmann::json::array();
+
+    // Where each metric of the current run lives in the output: the gauges or
+    // counters array, and the index within it.
+    struct MetricLocation
+    {
+        const char* arrayName;
+        size_t      index;
+    };
+    nlohmann::json*                              pRun = nullptr;
+    std::unordered_map<MetricID, MetricLocation> locations;
+
+    auto findMetric = [&pRun, &locations](MetricID id, MetricType type) -> nlohmann::json* {
+        auto it = locations.find(id);
+        if ((pRun == nullptr) || (it == locations.end())) {
+            return nullptr;
+        }
+        const char* arrayName = (type == MetricType::GAUGE) ? "gauges" : "counters";
+        if (std::strcmp(it->second.arrayName, arrayName) != 0) {
+            return nullptr;
+        }
+        return &(*pRun)[arrayName][it->second.index];
+    };
+
+    size_t offset = sizeof(kMagic) + sizeof(version);
+    while (offset < data.size()) {
+        if ((data.size() - offset) < kChunkHeadSize) {
+            PPX_LOG_WARN("Binary metrics report is truncated; ignoring trailing bytes.");
+            break;
+        }
+        const char* chunkId     = reinterpret_cast<const char*>(data.data() + offset);
+        uint32_t    payloadSize = 0;
+        std::memcpy(&payloadSize, data.data() + offset + kChunkIdSize, sizeof(payloadSize));
+        offset += kChunkHeadSize;
+        if ((data.size() - offset) < payloadSize) {
+            PPX_LOG_WARN("Binary metrics report is truncated; ignoring last chunk.");
+            break;
+        }
+
+        ByteReader reader(data.data() + offset, payloadSize);
+        offset += payloadSize;
+
+        if (IsChunk(chunkId, "HEAD")) {
+            std::string filename;
+            std::string generatedAt;
+            reader.GetString(&filename);
+            reader.GetString(&generatedAt);
+            content["filename"]     = filename;
+            content["generated_at"] = generatedAt;
+        }
+        else if (IsChunk(chunkId, "RUN ")) {
+            std::string name;
+            reader.GetString(&name);
+            nlohmann::json run;
+            run["name"]     = name;
+            run["gauges"]   = nlohmann::json::array();
+            run["counters"] = nlohmann::json::array();
+            content["runs"].push_back(std::move(run));
+            pRun = &content["runs"].back();
+            locations.clear();
+        }
+        else if (IsChunk(chunkId, "META")) {
+            uint32_t    id             = 0;
+            uint32_t    type           = 0;
+            uint32_t    interpretation = 0;
+            std::string name;
+            std::string unit;
+            double      lowerBound = 0.0;
+            double      upperBound = 0.0;
+            reader.Get(&id);
+            reader.Get(&type);
+            reader.GetString(&name);
+            reader.GetString(&unit);
+            reader.Get(&interpretation);
+            reader.Get(&lowerBound);
+            reader.Get(&upperBound);
+            if (!reader.IsValid() || (pRun == nullptr)) {
+                PPX_LOG_ERROR("Malformed metric metadata in binary metrics report.");
+                return false;
+            }
+
+            MetricMetadata metadata = {};
+            metadata.type           = static_cast<MetricType>(type);
+            metadata.name           = name;
+            metadata.unit           = unit;
+            metadata.interpretation = static_cast<MetricInterpretation>(interpretation);
+            metadata.expectedRange  = {lowerBound, upperBound};
+
+            nlohmann::json metric;
+            metric["metadata"] = metadata.Export();
+            if (metadata.type == MetricType::GAUGE) {
+                metric["statistics"]  = nlohmann::json::object();
+                metric["time_series"] = nlohmann::json::array();
+                locations[id]         = {"gauges", (*pRun)["gauges"].size()};
+                (*pRun)["gauges"].push_back(std::move(metric));
+            }
+            else {
+                metric["value"]       = 0;
+                metric["entry_count"] = 0;
+                locations[id]         = {"counters", (*pRun)["counters"].size()};
+                (*pRun)["counters"].push_back(std::move(metric));
+            }
+        }
+        else if (IsChunk(chunkId, "GAUG")) {
+            uint32_t id    = 0;
+            uint32_t count = 0;
+            int64_t  nanos = 0;
+            reader.Get(&id);
+            reader.Get(&count);
+            reader.Get(&nanos);
+            nlohmann::json* pGauge = findMetric(id, MetricType::GAUGE);
+            if (!reader.IsValid() || (pGauge == nullptr) || (count == 0)) {
+                PPX_LOG_ERROR("Malformed gauge block in binary metrics report.");
+                return false;
+            }
+
+            // Every entry but the first has a delta of at least one byte, and
+            // every entry has a value; reject counts the chunk cannot hold
+            // before allocating for them.
+            const uint64_t minEntriesSize = (static_cast<uint64_t>(count) - 1) + static_cast<uint64_t>(count) * sizeof(float);
+            if (reader.GetRemainingSize() < minEntriesSize) {
+                PPX_LOG_ERROR("Malformed gauge block in binary metrics report.");
+                return false;
+            }
+
+            std::vector<int64_t> timestamps(count);
+            timestamps[0] = nanos;
+            for (uint32_t i = 1; i < count; ++i) {
+                uint64_t delta = 0;
+                reader.GetVarint(&delta);
+                timestamps[i] = timestamps[i - 1] + static_cast<int64_t>(delta);
+            }
+            nlohmann::json& timeSeries = (*pGauge)["time_series"];
+            for (uint32_t i = 0; i < count; ++i) {
+                float value = 0.0f;
+                reader.Get(&value);
+                timeSeries.push_back(nlohmann::json::array({static_cast<double>(timestamps[i]) / kNanosPerSec, value}));
+            }
+        }
+        else if (IsChunk(chunkId, "GSTA")) {
+            uint32_t id         = 0;
+            uint32_t fieldCount = 0;
+            reader.Get(&id);
+            reader.Get(&fieldCount);
+            nlohmann::json* pGauge = findMetric(id, MetricType::GAUGE);
+            if (!reader.IsValid() || (pGauge == nullptr)) {
+                PPX_LOG_ERROR("Malformed gauge statistics in binary metrics report.");
+                return false;
+            }
+            for (uint32_t i = 0; i < fieldCount; ++i) {
+                std::string name;
+                double      value = 0.0;
+                reader.GetString(&name);
+                reader.Get(&value);
+                (*pGauge)["statistics"][name] = value;
+            }
+        }
+        else if (IsChunk(chunkId, "CNTR")) {
+            uint32_t id         = 0;
+            uint64_t value      = 0;
+            uint64_t entryCount = 0;
+            reader.Get(&id);
+            reader.Get(&value);
+            reader.Get(&entryCount);
+            nlohmann::json* pCounter = findMetric(id, MetricType::COUNTER);
+            if (!reader.IsValid() || (pCounter == nullptr)) {
+                PPX_LOG_ERROR("Malformed counter in binary metrics report.");
+                return false;
+            }
+            (*pCounter)["value"]       = value;
+            (*pCounter)["entry_count"] = entryCount;
+        }
+        else if (IsChunk(chunkId, "END ")) {
+            pRun = nullptr;
+        }
+        else {
+            PPX_LOG_WARN("Unknown chunk in binary metrics report; skipping.");
+        }
+
+        if (!reader.IsValid()) {
+            PPX_LOG_ERROR("Malformed chunk in binary metrics report.");
+            return false;
+        }
+    }
+
+    *pContent = std::move(content);
+    return true;
+}
+
+} // namespace metrics
+} // namespace ppx
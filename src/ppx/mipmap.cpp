@@ -17,7 +17,6 @@
 #include "ppx/timer.h"
 
 #include "stb_image.h"
-#include "stb_image_resize.h"
 
 #include <filesystem>
 
@@ -66,8 +65,6 @@ static uint64_t CalculateDataSize(uint32_t width, uint32_t height, Bitmap::Forma
     return totalSize;
 }
 
-std::vector<char> Mipmap::mStaticData = {};
-
 Mipmap::Mipmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t levelCount)
     : Mipmap(width, height, format, levelCount, /* useStaticPool= */ false)
 {
@@ -83,12 +80,15 @@ Mipmap::Mipmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t
         return;
     }
 
-    // Choose between static pool use and internal data.
-    // NOTE: This is designed for single-threaded use ONLY!
-    // This will need locks if the consuming paths ever become multi-threaded.
-    std::vector<char>& targetData = mUseStaticPool ? mStaticData : mData;
-    if (targetData.size() < dataSize) {
-        targetData.resize(dataSize);
+    // Choose between pooled and internal data.
+    char* pData = nullptr;
+    if (mUseStaticPool) {
+        mPoolBlock = ScratchPool::Acquire(dataSize);
+        pData      = mPoolBlock.GetData();
+    }
+    else {
+        mData.resize(dataSize);
+        pData = mData.data();
     }
 
     mMips.resize(levelCount);
@@ -96,7 +96,7 @@ Mipmap::Mipmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t
     const size_t pixelWidth = static_cast<size_t>(Bitmap::FormatSize(format));
     size_t       offset     = 0;
     for (uint32_t i = 0; i < levelCount; ++i) {
-        char* pStorage = targetData.data() + offset;
+        char* pStorage = pData + offset;
 
         Bitmap& mip = mMips[i];
 
@@ -120,7 +120,7 @@ Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount)
 {
 }
 
-Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool)
+Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool, bool srgb)
     : Mipmap(bitmap.GetWidth(), bitmap.GetHeight(), bitmap.GetFormat(), levelCount, useStaticPool)
 {
     Bitmap* pMip0 = GetMip(0);
@@ -133,14 +133,15 @@ Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool)
             memcpy(pDstData, pSrcData, srcSize);
 
             // Generate mip
-            for (uint32_t level = 1; level < levelCount; ++level) {
+            for (uint32_t level = 1; level < GetLevelCount(); ++level) {
                 uint32_t prevLevel = level - 1;
                 Bitmap*  pPrevMip  = GetMip(prevLevel);
                 Bitmap*  pMip      = GetMip(level);
 
-                Result ppxres = pPrevMip->ScaleTo(pMip, STBIR_FILTER_BOX);
+                Result ppxres = pPrevMip->DownsampleTo(pMip, srgb);
                 if (Failed(ppxres)) {
                     mData.clear();
+                    mPoolBlock.Release();
                     mMips.clear();
                     return;
                 }
@@ -167,7 +168,7 @@ bool Mipmap::IsOk() const
     uint32_t height      = bitmap.GetHeight();
     uint64_t dataSize    = CalculateDataSize(width, height, format, levelCount);
     uint64_t storageSize = mUseStaticPool
-                               ? static_cast<uint64_t>(mStaticData.size())
+                               ? static_cast<uint64_t>(mPoolBlock.GetSize())
                                : static_cast<uint64_t>(mData.size());
 
     if (storageSize < dataSize) {
@@ -203,13 +204,13 @@ const Bitmap* Mipmap::GetMip(uint32_t level) const
 
 uint32_t Mipmap::GetWidth(uint32_t level) const
 {
-    const Bitmap* pMip = GetMip(0);
+    const Bitmap* pMip = GetMip(level);
     return IsNull(pMip) ? 0 : pMip->GetWidth();
 }
 
 uint32_t Mipmap::GetHeight(uint32_t level) const
 {
-    const Bitmap* pMip = GetMip(0);
+    const Bitmap* pMip = GetMip(level);
     return IsNull(pMip) ? 0 : pMip->GetHeight();
 }
 
@@ -249,7 +250,7 @@ Result Mipmap::LoadFile(const std::filesystem::path& path, uint32_t baseWidth, u
     }
 
     // Load file
-    auto fileBytes = ppx::fs::load_file(path);
+    auto fileBytes = ppx::fs::load_file_view(path);
     if (!fileBytes.has_value()) {
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
@@ -262,8 +263,8 @@ Result Mipmap::LoadFile(const std::filesystem::path& path, uint32_t baseWidth, u
     int   stbiRequiredChannels = 4; // Force to 4 chanenls to make things easier for the graphics APIs
     if (Bitmap::ChannelDataType(format) == Bitmap::DATA_TYPE_UINT8) {
         pStbiData = stbi_load_from_memory(
-            reinterpret_cast<const stbi_uc*>(fileBytes.value().data()),
-            static_cast<int>(fileBytes.value().size()),
+            reinterpret_cast<const stbi_uc*>(fileBytes.value().GetData()),
+            static_cast<int>(fileBytes.value().GetSize()),
             &stbiWidth,
             &stbiHeight,
             &stbiChannels,
@@ -271,8 +272,8 @@ Result Mipmap::LoadFile(const std::filesystem::path& path, uint32_t baseWidth, u
     }
     else if (Bitmap::ChannelDataType(format) == Bitmap::DATA_TYPE_FLOAT) {
         pStbiData = stbi_loadf_from_memory(
-            reinterpret_cast<const stbi_uc*>(fileBytes.value().data()),
-            static_cast<int>(fileBytes.value().size()),
+            reinterpret_cast<const stbi_uc*>(fileBytes.value().GetData()),
+            static_cast<int>(fileBytes.value().GetSize()),
             &stbiWidth,
             &stbiHeight,
             &stbiChannels,
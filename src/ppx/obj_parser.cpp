@@ -0,0 +1,453 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/obj_parser.h"
+#include "ppx/fs.h"
+#include "ppx/parallel.h"
+
+#include <cmath>
+
+namespace ppx {
+
+namespace {
+
+// Chunks smaller than this are not worth a thread.
+constexpr size_t kMinChunkSize = 1 << 20;
+
+// Exact powers of ten representable as doubles.
+constexpr double kPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Geometry parsed from a range of lines. Indices are resolved relative to
+// the chunk: negative (relative) OBJ indices are resolved against the local
+// attribute counts, and recorded so that the offset of the chunk can be added
+// once all the chunks are parsed.
+struct ObjChunk
+{
+    std::vector<float3>   positions;
+    std::vector<float3>   normals;
+    std::vector<float2>   texCoords;
+    std::vector<ObjIndex> indices;
+    std::vector<size_t>   relativePositions;
+    std::vector<size_t>   relativeTexCoords;
+    std::vector<size_t>   relativeNormals;
+    std::vector<uint32_t> shapeFirstTriangles;
+    const char*           pError = nullptr;
+};
+
+bool IsBlank(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+bool IsDigit(char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+const char* SkipBlanks(const char* p, const char* pEnd)
+{
+    while ((p < pEnd) && IsBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* SkipLine(const char* p, const char* pEnd)
+{
+    const char* pNewLine = static_cast<const char*>(memchr(p, '\n', pEnd - p));
+    return IsNull(pNewLine) ? pEnd : pNewLine + 1;
+}
+
+// Parses a decimal floating point number, with an optional sign, fraction and
+// exponent. Digits beyond the 19th significant one only scale the value.
+// Returns the end of the number, or nullptr if there is none.
+const char* ParseFloat(const char* p, const char* pEnd, float* pValue)
+{
+    bool negative = false;
+    if ((p < pEnd) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa   = 0;
+    int32_t  exponent   = 0;
+    uint32_t digitCount = 0;
+    bool     hasDigits  = false;
+    for (; (p < pEnd) && IsDigit(*p); ++p) {
+        hasDigits = true;
+        if (digitCount < 19) {
+            mantissa = (mantissa * 10) + (*p - '0');
+            digitCount += (mantissa > 0) ? 1 : 0;
+        }
+        else {
+            ++exponent;
+        }
+    }
+    if ((p < pEnd) && (*p == '.')) {
+        for (++p; (p < pEnd) && IsDigit(*p); ++p) {
+            hasDigits = true;
+            if (digitCount < 19) {
+                mantissa = (mantissa * 10) + (*p - '0');
+                digitCount += (mantissa > 0) ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+    if (!hasDigits) {
+        return nullptr;
+    }
+    if ((p < pEnd) && ((*p == 'e') || (*p == 'E'))) {
+        const char* pExponent        = p + 1;
+        bool        negativeExponent = false;
+        if ((pExponent < pEnd) && ((*pExponent == '-') || (*pExponent == '+'))) {
+            negativeExponent = (*pExponent == '-');
+            ++pExponent;
+        }
+        if ((pExponent < pEnd) && IsDigit(*pExponent)) {
+            int32_t value = 0;
+            for (; (pExponent < pEnd) && IsDigit(*pExponent); ++pExponent) {
+                value = std::min<int32_t>((value * 10) + (*pExponent - '0'), 100000);
+            }
+            exponent += negativeExponent ? -value : value;
+            p = pExponent;
+        }
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (mantissa == 0) {
+        value = 0.0;
+    }
+    else if ((exponent >= 0) && (exponent <= 22)) {
+        value *= kPowersOfTen[exponent];
+    }
+    else if ((exponent < 0) && (exponent >= -22)) {
+        value /= kPowersOfTen[-exponent];
+    }
+    else {
+        value *= std::pow(10.0, exponent);
+    }
+    *pValue = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+// Parses a signed integer. Returns the end of the integer, or nullptr if
+// there is none.
+const char* ParseInt(const char* p, const char* pEnd, int64_t* pValue)
+{
+    bool negative = false;
+    if ((p < pEnd) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if ((p >= pEnd) || !IsDigit(*p)) {
+        return nullptr;
+    }
+    // Clamped, out of range values are rejected when the indices are checked.
+    int64_t value = 0;
+    for (; (p < pEnd) && IsDigit(*p); ++p) {
+        value = std::min<int64_t>((value * 10) + (*p - '0'), INT32_MAX);
+    }
+    *pValue = negative ? -value : value;
+    return p;
+}
+
+// Parses count floats separated by blanks. Anything after them is ignored,
+// e.g. the optional w of a position or its vertex color.
+const char* ParseFloats(const char* p, const char* pEnd, uint32_t count, float* pValues)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        const char* pStart = SkipBlanks(p, pEnd);
+        if ((i > 0) && (pStart == p)) {
+            return nullptr;
+        }
+        p = ParseFloat(pStart, pEnd, &pValues[i]);
+        if (IsNull(p)) {
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+// Resolves a one-based OBJ index into a zero-based index relative to the
+// chunk. A value of 0 leaves the index unset.
+void ResolveIndex(int64_t value, size_t localCount, size_t corner, int32_t* pIndex, std::vector<size_t>* pRelativeCorners)
+{
+    if (value > 0) {
+        *pIndex = static_cast<int32_t>(value - 1);
+    }
+    else if (value < 0) {
+        *pIndex = static_cast<int32_t>(static_cast<int64_t>(localCount) + value);
+        pRelativeCorners->push_back(corner);
+    }
+}
+
+// Parses the corners of a face and fan triangulates them into the chunk.
+const char* ParseFace(const char* p, const char* pEnd, std::vector<ObjIndex>* pCorners, ObjChunk* pChunk)
+{
+    pCorners->clear();
+    for (;;) {
+        const char* pStart = SkipBlanks(p, pEnd);
+        if ((pStart >= pEnd) || (*pStart == '\n') || (*pStart == '#')) {
+            p = pStart;
+            break;
+        }
+        if (pStart == p) {
+            return nullptr;
+        }
+        p = pStart;
+
+        // The one-based values are kept as is until the face is
+        // triangulated, 0 meaning that the attribute is not referenced.
+        ObjIndex corner = {0, 0, 0};
+        int64_t  value  = 0;
+        p               = ParseInt(p, pEnd, &value);
+        if (IsNull(p) || (value == 0)) {
+            return nullptr;
+        }
+        corner.position = static_cast<int32_t>(value);
+        if ((p < pEnd) && (*p == '/')) {
+            ++p;
+            if ((p < pEnd) && (*p != '/')) {
+                p = ParseInt(p, pEnd, &value);
+                if (IsNull(p) || (value == 0)) {
+                    return nullptr;
+                }
+                corner.texCoord = static_cast<int32_t>(value);
+            }
+            if ((p < pEnd) && (*p == '/')) {
+                p = ParseInt(p + 1, pEnd, &value);
+                if (IsNull(p) || (value == 0)) {
+                    return nullptr;
+                }
+                corner.normal = static_cast<int32_t>(value);
+            }
+        }
+        pCorners->push_back(corner);
+    }
+
+    // Fan triangulation; the corners are resolved as they are stored.
+    size_t cornerCount = pCorners->size();
+    for (size_t i = 1; (i + 1) < cornerCount; ++i) {
+        const ObjIndex* triangle[3] = {&(*pCorners)[0], &(*pCorners)[i], &(*pCorners)[i + 1]};
+        for (const ObjIndex* pRaw : triangle) {
+            size_t   corner   = pChunk->indices.size();
+            ObjIndex resolved = {};
+            ResolveIndex(pRaw->position, pChunk->positions.size(), corner, &resolved.position, &pChunk->relativePositions);
+            ResolveIndex(pRaw->texCoord, pChunk->texCoords.size(), corner, &resolved.texCoord, &pChunk->relativeTexCoords);
+            ResolveIndex(pRaw->normal, pChunk->normals.size(), corner, &resolved.normal, &pChunk->relativeNormals);
+            pChunk->indices.push_back(resolved);
+        }
+    }
+    return p;
+}
+
+// Parses the lines in [pBegin, pEnd); pEnd is either the end of the text or
+// just after a new line.
+void ParseChunk(const char* pBegin, const char* pEnd, ObjChunk* pChunk)
+{
+    std::vector<ObjIndex> corners;
+
+    const char* p = pBegin;
+    while (p < pEnd) {
+        const char* pLine = SkipBlanks(p, pEnd);
+        const char* pNext = nullptr;
+        if ((pLine + 1 < pEnd) && (pLine[0] == 'v') && IsBlank(pLine[1])) {
+            float3 position;
+            pNext = ParseFloats(pLine + 2, pEnd, 3, &position.x);
+            pChunk->positions.push_back(position);
+        }
+        else if ((pLine + 2 < pEnd) && (pLine[0] == 'v') && (pLine[1] == 'n') && IsBlank(pLine[2])) {
+            float3 normal;
+            pNext = ParseFloats(pLine + 3, pEnd, 3, &normal.x);
+            pChunk->normals.push_back(normal);
+        }
+        else if ((pLine + 2 < pEnd) && (pLine[0] == 'v') && (pLine[1] == 't') && IsBlank(pLine[2])) {
+            // The v coordinate is optional and defaults to 0.
+            float2 texCoord(0.0f, 0.0f);
+            pNext = ParseFloats(pLine + 3, pEnd, 1, &texCoord.x);
+            if (!IsNull(pNext)) {
+                const char* pV = SkipBlanks(pNext, pEnd);
+                if ((pV > pNext) && (pV < pEnd) && (*pV != '\n') && (*pV != '#')) {
+                    pNext = ParseFloat(pV, pEnd, &texCoord.y);
+                }
+            }
+            pChunk->texCoords.push_back(texCoord);
+        }
+        else if ((pLine + 1 < pEnd) && (pLine[0] == 'f') && IsBlank(pLine[1])) {
+            pNext = ParseFace(pLine + 1, pEnd, &corners, pChunk);
+        }
+        else if ((pLine < pEnd) && ((pLine[0] == 'o') || (pLine[0] == 'g')) && ((pLine + 1 == pEnd) || IsBlank(pLine[1]) || (pLine[1] == '\n'))) {
+            pChunk->shapeFirstTriangles.push_back(static_cast<uint32_t>(pChunk->indices.size() / 3));
+            pNext = pLine + 1;
+        }
+        else {
+            // Comments, empty lines and unsupported statements
+            pNext = pLine;
+        }
+
+        if (IsNull(pNext)) {
+            pChunk->pError = pLine;
+            return;
+        }
+        p = SkipLine(pNext, pEnd);
+    }
+}
+
+// Returns the start of the line that contains the byte at offset, or the
+// end of the text.
+size_t FindLineStart(const char* pText, size_t size, size_t offset)
+{
+    if ((offset == 0) || (offset >= size)) {
+        return std::min(offset, size);
+    }
+    const char* pNewLine = static_cast<const char*>(memchr(pText + offset - 1, '\n', size - offset + 1));
+    return IsNull(pNewLine) ? size : static_cast<size_t>(pNewLine + 1 - pText);
+}
+
+// Adds the attribute offset of a chunk to its relative indices and checks
+// that every index is within the attribute data.
+template <typename Getter>
+bool ResolveChunkIndices(ObjIndex* pIndices, size_t indexCount, const std::vector<size_t>& relativeCorners, int64_t offset, int64_t total, bool required, Getter getter)
+{
+    for (size_t corner : relativeCorners) {
+        int32_t& index = getter(pIndices[corner]);
+        int64_t  value = offset + index;
+        if ((value < 0) || (value >= total)) {
+            return false;
+        }
+        index = static_cast<int32_t>(value);
+    }
+    for (size_t corner = 0; corner < indexCount; ++corner) {
+        int32_t index = getter(pIndices[corner]);
+        if ((index >= total) || (index < (required ? 0 : -1))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+Result ParseOBJ(const char* pText, size_t size, ObjData* pObjData, uint32_t threadCount)
+{
+    if (IsNull(pObjData) || (IsNull(pText) && (size > 0))) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    *pObjData = ObjData();
+
+    uint32_t              chunkCount = (threadCount > 0) ? threadCount : GetParallelThreadCount(size, kMinChunkSize);
+    std::vector<ObjChunk> chunks(chunkCount);
+    ParallelForRanges(size, chunkCount, [pText, size, &chunks](uint32_t chunkIndex, size_t begin, size_t end) {
+        size_t lineBegin = FindLineStart(pText, size, begin);
+        size_t lineEnd   = FindLineStart(pText, size, end);
+        ParseChunk(pText + lineBegin, pText + lineEnd, &chunks[chunkIndex]);
+    });
+
+    // Offsets of the chunks in the merged data
+    std::vector<size_t> positionOffsets(chunkCount + 1, 0);
+    std::vector<size_t> normalOffsets(chunkCount + 1, 0);
+    std::vector<size_t> texCoordOffsets(chunkCount + 1, 0);
+    std::vector<size_t> indexOffsets(chunkCount + 1, 0);
+    for (uint32_t i = 0; i < chunkCount; ++i) {
+        const ObjChunk& chunk = chunks[i];
+        if (!IsNull(chunk.pError)) {
+            const char* pLineEnd = chunk.pError;
+            while ((pLineEnd < pText + size) && (*pLineEnd != '\n') && (*pLineEnd != '\r')) {
+                ++pLineEnd;
+            }
+            size_t lineNumber = 1 + std::count(pText, chunk.pError, '\n');
+            PPX_LOG_ERROR("OBJ parse error at line " << lineNumber << ": " << std::string(chunk.pError, pLineEnd));
+            return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
+        }
+        positionOffsets[i + 1] = positionOffsets[i] + chunk.positions.size();
+        normalOffsets[i + 1]   = normalOffsets[i] + chunk.normals.size();
+        texCoordOffsets[i + 1] = texCoordOffsets[i] + chunk.texCoords.size();
+        indexOffsets[i + 1]    = indexOffsets[i] + chunk.indices.size();
+
+        // Shapes start at each group that has triangles.
+        for (uint32_t firstTriangle : chunk.shapeFirstTriangles) {
+            pObjData->shapeFirstTriangles.push_back(static_cast<uint32_t>(indexOffsets[i] / 3) + firstTriangle);
+        }
+    }
+
+    uint32_t triangleCount = static_cast<uint32_t>(indexOffsets[chunkCount] / 3);
+    auto&    shapeStarts   = pObjData->shapeFirstTriangles;
+    shapeStarts.insert(shapeStarts.begin(), 0);
+    shapeStarts.erase(std::unique(shapeStarts.begin(), shapeStarts.end()), shapeStarts.end());
+    while (!shapeStarts.empty() && (shapeStarts.back() >= triangleCount)) {
+        shapeStarts.pop_back();
+    }
+
+    int64_t positionCount = static_cast<int64_t>(positionOffsets[chunkCount]);
+    int64_t normalCount   = static_cast<int64_t>(normalOffsets[chunkCount]);
+    int64_t texCoordCount = static_cast<int64_t>(texCoordOffsets[chunkCount]);
+    if ((positionCount > INT32_MAX) || (normalCount > INT32_MAX) || (texCoordCount > INT32_MAX) || ((indexOffsets[chunkCount] / 3) > UINT32_MAX)) {
+        PPX_LOG_ERROR("OBJ data exceeds the supported size");
+        return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
+    }
+
+    pObjData->positions.resize(positionOffsets[chunkCount]);
+    pObjData->normals.resize(normalOffsets[chunkCount]);
+    pObjData->texCoords.resize(texCoordOffsets[chunkCount]);
+    pObjData->indices.resize(indexOffsets[chunkCount]);
+
+    // Merge the chunks in parallel, each one into its own range of the data.
+    std::vector<char> chunkValid(chunkCount, 0);
+    ParallelForRanges(chunkCount, chunkCount, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), pObjData->positions.begin() + positionOffsets[i]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), pObjData->normals.begin() + normalOffsets[i]);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), pObjData->texCoords.begin() + texCoordOffsets[i]);
+
+            ObjIndex* pIndices   = pObjData->indices.data() + indexOffsets[i];
+            size_t    indexCount = chunk.indices.size();
+            std::copy(chunk.indices.begin(), chunk.indices.end(), pIndices);
+
+            bool valid = ResolveChunkIndices(pIndices, indexCount, chunk.relativePositions, positionOffsets[i], positionCount, true, [](ObjIndex& index) -> int32_t& { return index.position; }) &&
+                         ResolveChunkIndices(pIndices, indexCount, chunk.relativeTexCoords, texCoordOffsets[i], texCoordCount, false, [](ObjIndex& index) -> int32_t& { return index.texCoord; }) &&
+                         ResolveChunkIndices(pIndices, indexCount, chunk.relativeNormals, normalOffsets[i], normalCount, false, [](ObjIndex& index) -> int32_t& { return index.normal; });
+            chunkValid[i] = valid ? 1 : 0;
+
+            // Release the chunk memory as early as possible.
+            chunk = ObjChunk();
+        }
+    });
+
+    if (std::find(chunkValid.begin(), chunkValid.end(), 0) != chunkValid.end()) {
+        PPX_LOG_ERROR("OBJ face index out of range");
+        return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result LoadOBJ(const std::filesystem::path& path, ObjData* pObjData, uint32_t threadCount)
+{
+    if (IsNull(pObjData)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    auto view = fs::load_file_view(path, fs::File::ACCESS_PATTERN_SEQUENTIAL);
+    if (!view.has_value()) {
+        PPX_LOG_ERROR("Failed to open OBJ file: " << path);
+        return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
+    }
+
+    return ParseOBJ(view->GetData(), view->GetSize(), pObjData, threadCount);
+}
+
+} // namespace ppx
@@ -0,0 +1,114 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/pipeline_cache_file.h"
+#include "ppx/binary_file.h"
+#include "ppx/fs.h"
+
+#include "xxhash.h"
+
+#include <cstring>
+
+namespace ppx {
+
+namespace {
+
+const char kMagic[4] = {'P', 'P', 'P', 'C'};
+
+// Every platform supported by ppx is little-endian, so values are copied as is.
+struct Header
+{
+    char     magic[4]      = {};
+    uint32_t version       = 0;
+    uint32_t vendorId      = 0;
+    uint32_t deviceId      = 0;
+    uint32_t driverVersion = 0;
+    uint8_t  cacheUuid[16] = {};
+    uint64_t dataSize      = 0;
+    uint64_t dataHash      = 0;
+};
+
+static_assert(sizeof(Header) == 56, "pipeline cache header must not have padding");
+
+uint64_t HashData(const void* pData, size_t size)
+{
+    return static_cast<uint64_t>(XXH64(pData, size, 0));
+}
+
+} // namespace
+
+Result PipelineCacheFile::Load(const std::filesystem::path& path, const PipelineCacheDeviceInfo& deviceInfo, std::vector<char>* pData)
+{
+    PPX_ASSERT_NULL_ARG(pData);
+    pData->clear();
+
+    if (!std::filesystem::exists(path)) {
+        return ppx::ERROR_FAILED;
+    }
+    auto file = fs::load_file(path);
+    if (!file.has_value() || (file->size() < sizeof(Header))) {
+        return ppx::ERROR_FAILED;
+    }
+
+    Header header = {};
+    std::memcpy(&header, file->data(), sizeof(Header));
+    if ((std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) || (header.version != kVersion)) {
+        return ppx::ERROR_FAILED;
+    }
+    if ((header.vendorId != deviceInfo.vendorId) ||
+        (header.deviceId != deviceInfo.deviceId) ||
+        (header.driverVersion != deviceInfo.driverVersion) ||
+        (std::memcmp(header.cacheUuid, deviceInfo.cacheUuid, sizeof(header.cacheUuid)) != 0)) {
+        return ppx::ERROR_FAILED;
+    }
+
+    const char* pFileData = file->data() + sizeof(Header);
+    if ((header.dataSize != (file->size() - sizeof(Header))) || (HashData(pFileData, header.dataSize) != header.dataHash)) {
+        return ppx::ERROR_FAILED;
+    }
+
+    pData->assign(pFileData, pFileData + header.dataSize);
+    return ppx::SUCCESS;
+}
+
+Result PipelineCacheFile::Save(const std::filesystem::path& path, const PipelineCacheDeviceInfo& deviceInfo, const void* pData, size_t size)
+{
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version       = kVersion;
+    header.vendorId      = deviceInfo.vendorId;
+    header.deviceId      = deviceInfo.deviceId;
+    header.driverVersion = deviceInfo.driverVersion;
+    std::memcpy(header.cacheUuid, deviceInfo.cacheUuid, sizeof(header.cacheUuid));
+    header.dataSize = size;
+    header.dataHash = HashData(pData, size);
+
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    bool written = internal::WriteFileAtomic(path, [&](std::ostream& file) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(pData), size);
+    });
+    if (!written) {
+        PPX_LOG_WARN("Failed to write pipeline cache file: " << path);
+        return ppx::ERROR_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
@@ -14,10 +14,268 @@
 
 #include "ppx/ppm_export.h"
 
+#include <cstring>
 #include <filesystem>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PPX_PPM_EXPORT_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PPX_PPM_EXPORT_SSSE3
+#include <tmmintrin.h>
+#endif
+#endif
 
 namespace ppx {
 
+namespace {
+
+// Converts a row of width texels to RGB8. Converters may write up to
+// kRowPadding bytes past the end of the row.
+using ConvertRowFn = void (*)(const uint8_t* pSrc, uint32_t width, uint8_t* pDst);
+
+const uint32_t kRowPadding = 16;
+
+// -------------------------------------------------------------------------------------------------
+// Scalar converters
+//
+// The SIMD converters below produce the same bytes as these, they only
+// process several texels at a time.
+// -------------------------------------------------------------------------------------------------
+
+template <uint32_t RedOffset, uint32_t BlueOffset>
+void ConvertRow8888(const uint8_t* pSrc, uint32_t width, uint8_t* pDst)
+{
+    for (uint32_t x = 0; x < width; ++x) {
+        pDst[0] = pSrc[RedOffset];
+        pDst[1] = pSrc[1];
+        pDst[2] = pSrc[BlueOffset];
+        pSrc += 4;
+        pDst += 3;
+    }
+}
+
+// Rounds a 10-bit UNORM value to 8 bits, equal to (v * 255 + 511) / 1023.
+uint32_t Unorm10ToUnorm8(uint32_t value)
+{
+    uint32_t t = value * 255 + 511;
+    return (t + (t >> 10) + 1) >> 10;
+}
+
+// Red is in the low bits, as in DXGI_FORMAT_R10G10B10A2_UNORM.
+void ConvertRowRGB10A2(const uint8_t* pSrc, uint32_t width, uint8_t* pDst)
+{
+    for (uint32_t x = 0; x < width; ++x) {
+        uint32_t texel = 0;
+        std::memcpy(&texel, pSrc, sizeof(texel));
+        pDst[0] = static_cast<uint8_t>(Unorm10ToUnorm8(texel & 0x3FF));
+        pDst[1] = static_cast<uint8_t>(Unorm10ToUnorm8((texel >> 10) & 0x3FF));
+        pDst[2] = static_cast<uint8_t>(Unorm10ToUnorm8((texel >> 20) & 0x3FF));
+        pSrc += 4;
+        pDst += 3;
+    }
+}
+
+// Exact conversion, including denormals, infinities and NaNs.
+float HalfToFloat(uint16_t half)
+{
+    const uint32_t expMantissa = half & 0x7FFF;
+    const uint32_t sign        = static_cast<uint32_t>(half & 0x8000) << 16;
+
+    // Moves the exponent and mantissa in place and rebias the exponent by
+    // multiplying by 2^112. This also normalizes denormals.
+    float    scaled = 0.0f;
+    uint32_t bits   = expMantissa << 13;
+    std::memcpy(&scaled, &bits, sizeof(scaled));
+    scaled *= 5.192296858534828e33f;
+
+    std::memcpy(&bits, &scaled, sizeof(bits));
+    if (expMantissa > 0x7BFF) {
+        bits |= 0xFFu << 23;
+    }
+    bits |= sign;
+
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Clamps to [0, 1], NaN gives 0, and rounds to 8 bits.
+uint8_t FloatToUnorm8(float value)
+{
+    value = (value > 0.0f) ? value : 0.0f;
+    value = (value < 1.0f) ? value : 1.0f;
+    return static_cast<uint8_t>(static_cast<int32_t>(value * 255.0f + 0.5f));
+}
+
+void ConvertRowRGBA16F(const uint8_t* pSrc, uint32_t width, uint8_t* pDst)
+{
+    for (uint32_t x = 0; x < width; ++x) {
+        uint16_t texel[4] = {};
+        std::memcpy(texel, pSrc, sizeof(texel));
+        pDst[0] = FloatToUnorm8(HalfToFloat(texel[0]));
+        pDst[1] = FloatToUnorm8(HalfToFloat(texel[1]));
+        pDst[2] = FloatToUnorm8(HalfToFloat(texel[2]));
+        pSrc += 8;
+        pDst += 3;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// SIMD converters
+// -------------------------------------------------------------------------------------------------
+
+#if defined(PPX_PPM_EXPORT_SSE2)
+// Writes the low 3 bytes of each 32-bit lane. Each store writes a fourth
+// byte that the next store, or the padding, absorbs.
+void StoreRGBX(__m128i rgbx, uint8_t* pDst)
+{
+    alignas(16) uint32_t texels[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(texels), rgbx);
+    std::memcpy(pDst + 0, &texels[0], 4);
+    std::memcpy(pDst + 3, &texels[1], 4);
+    std::memcpy(pDst + 6, &texels[2], 4);
+    std::memcpy(pDst + 9, &texels[3], 4);
+}
+
+__m128i Unorm10ToUnorm8SSE2(__m128i value)
+{
+    __m128i t = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(value, 8), value), _mm_set1_epi32(511));
+    t         = _mm_add_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 10)), _mm_set1_epi32(1));
+    return _mm_srli_epi32(t, 10);
+}
+
+void ConvertRowRGB10A2SSE2(const uint8_t* pSrc, uint32_t width, uint8_t* pDst)
+{
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+
+    uint32_t x = 0;
+    for (; (x + 4) <= width; x += 4) {
+        __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x));
+        __m128i r      = Unorm10ToUnorm8SSE2(_mm_and_si128(texels, mask));
+        __m128i g      = Unorm10ToUnorm8SSE2(_mm_and_si128(_mm_srli_epi32(texels, 10), mask));
+        __m128i b      = Unorm10ToUnorm8SSE2(_mm_and_si128(_mm_srli_epi32(texels, 20), mask));
+        __m128i rgbx   = _mm_or_si128(r, _mm_or_si128(_mm_slli_epi32(g, 8), _mm_slli_epi32(b, 16)));
+        StoreRGBX(rgbx, pDst + 3 * x);
+    }
+    ConvertRowRGB10A2(pSrc + 4 * x, width - x, pDst + 3 * x);
+}
+
+// Vector version of HalfToFloat, for halves in the low 16 bits of each lane.
+__m128 HalfToFloatSSE2(__m128i half)
+{
+    const __m128i expMantissa = _mm_and_si128(half, _mm_set1_epi32(0x7FFF));
+    const __m128i sign        = _mm_slli_epi32(_mm_xor_si128(half, expMantissa), 16);
+    const __m128  scaled      = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), _mm_set1_ps(5.192296858534828e33f));
+    const __m128i infNan      = _mm_and_si128(_mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(0xFF << 23));
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(infNan, sign)));
+}
+
+__m128i FloatToUnorm8SSE2(__m128 value)
+{
+    // MAXPS returns its second operand if either is NaN.
+    value = _mm_max_ps(value, _mm_setzero_ps());
+    value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+void ConvertRowRGBA16FSSE2(const uint8_t* pSrc, uint32_t width, uint8_t* pDst)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t x = 0;
+    for (; (x + 4) <= width; x += 4) {
+        __m128i texels01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 8 * x));
+        __m128i texels23 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 8 * x + 16));
+        __m128i c0       = FloatToUnorm8SSE2(HalfToFloatSSE2(_mm_unpacklo_epi16(texels01, zero)));
+        __m128i c1       = FloatToUnorm8SSE2(HalfToFloatSSE2(_mm_unpackhi_epi16(texels01, zero)));
+        __m128i c2       = FloatToUnorm8SSE2(HalfToFloatSSE2(_mm_unpacklo_epi16(texels23, zero)));
+        __m128i c3       = FloatToUnorm8SSE2(HalfToFloatSSE2(_mm_unpackhi_epi16(texels23, zero)));
+        // Values are in [0, 255], so saturating packs keep them as is.
+        __m128i rgba = _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+        StoreRGBX(rgba, pDst + 3 * x);
+    }
+    ConvertRowRGBA16F(pSrc + 8 * x, width - x, pDst + 3 * x);
+}
+#endif // defined(PPX_PPM_EXPORT_SSE2)
+
+#if defined(PPX_PPM_EXPORT_SSSE3)
+template <uint32_t RedOffset, uint32_t BlueOffset>
+__attribute__((target("ssse3"))) void ConvertRow8888SSSE3(const uint8_t* pSrc, uint32_t width, uint8_t* pDst)
+{
+    // Picks R, G, B of 4 texels into the low 12 bytes.
+    const __m128i shuffle = _mm_setr_epi8(
+        RedOffset, 1, BlueOffset,
+        4 + RedOffset, 5, 4 + BlueOffset,
+        8 + RedOffset, 9, 8 + BlueOffset,
+        12 + RedOffset, 13, 12 + BlueOffset,
+        -1, -1, -1, -1);
+
+    uint32_t x = 0;
+    for (; (x + 4) <= width; x += 4) {
+        __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 3 * x), _mm_shuffle_epi8(texels, shuffle));
+    }
+    ConvertRow8888<RedOffset, BlueOffset>(pSrc + 4 * x, width - x, pDst + 3 * x);
+}
+
+bool IsSSSE3Supported()
+{
+    static const bool sSupported = __builtin_cpu_supports("ssse3");
+    return sSupported;
+}
+#endif // defined(PPX_PPM_EXPORT_SSSE3)
+
+// Returns a converter for the formats swapchains commonly use, or nullptr.
+ConvertRowFn GetRowConverter(grfx::Format format)
+{
+    switch (format) {
+        default: break;
+
+        case grfx::FORMAT_R8G8B8A8_UNORM:
+        case grfx::FORMAT_R8G8B8A8_SRGB:
+        case grfx::FORMAT_R8G8B8A8_UINT: {
+#if defined(PPX_PPM_EXPORT_SSSE3)
+            if (IsSSSE3Supported()) {
+                return ConvertRow8888SSSE3<0, 2>;
+            }
+#endif
+            return ConvertRow8888<0, 2>;
+        }
+
+        case grfx::FORMAT_B8G8R8A8_UNORM:
+        case grfx::FORMAT_B8G8R8A8_SRGB:
+        case grfx::FORMAT_B8G8R8A8_UINT: {
+#if defined(PPX_PPM_EXPORT_SSSE3)
+            if (IsSSSE3Supported()) {
+                return ConvertRow8888SSSE3<2, 0>;
+            }
+#endif
+            return ConvertRow8888<2, 0>;
+        }
+
+        case grfx::FORMAT_R10G10B10A2_UNORM: {
+#if defined(PPX_PPM_EXPORT_SSE2)
+            return ConvertRowRGB10A2SSE2;
+#else
+            return ConvertRowRGB10A2;
+#endif
+        }
+
+        case grfx::FORMAT_R16G16B16A16_FLOAT: {
+#if defined(PPX_PPM_EXPORT_SSE2)
+            return ConvertRowRGBA16FSSE2;
+#else
+            return ConvertRowRGBA16F;
+#endif
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
 unsigned char ConvertToUint(const char* value, grfx::FormatDataType dataType)
 {
     switch (dataType) {
@@ -61,25 +319,30 @@ Result ExportToPPM(std::ostream& outputStream, grfx::Format inputFormat, const v
 
     const grfx::FormatDesc* desc = grfx::GetFormatDescription(inputFormat);
 
-    // We don't support compressed or packed formats.
-    if (desc->layout != grfx::FORMAT_LAYOUT_LINEAR) {
-        return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
-    }
-    // We don't support FLOAT formats.
-    if (desc->dataType == grfx::FORMAT_DATA_TYPE_FLOAT) {
-        return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
-    }
+    // Common swapchain formats have dedicated converters, including packed
+    // and float formats that the generic path does not handle.
+    ConvertRowFn convertRow = GetRowConverter(inputFormat);
+    if (convertRow == nullptr) {
+        // We don't support compressed or packed formats.
+        if (desc->layout != grfx::FORMAT_LAYOUT_LINEAR) {
+            return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
+        }
+        // We don't support FLOAT formats.
+        if (desc->dataType == grfx::FORMAT_DATA_TYPE_FLOAT) {
+            return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
+        }
 
-    // We only support color formats for now.
-    // The alpha channel, if present, is ignored, as the PPM file format
-    // does not support transparency.
-    auto rgbMask = grfx::FORMAT_COMPONENT_RED_GREEN_BLUE;
-    if ((desc->componentBits & rgbMask) == 0) {
-        return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
-    }
-    // We only support 8-bit formats.
-    if (desc->bytesPerComponent != 1) {
-        return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
+        // We only support color formats for now.
+        // The alpha channel, if present, is ignored, as the PPM file format
+        // does not support transparency.
+        auto rgbMask = grfx::FORMAT_COMPONENT_RED_GREEN_BLUE;
+        if ((desc->componentBits & rgbMask) == 0) {
+            return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
+        }
+        // We only support 8-bit formats.
+        if (desc->bytesPerComponent != 1) {
+            return ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED;
+        }
     }
 
     PPX_ASSERT_MSG(rowStride >= desc->bytesPerTexel * width, "row stride must be at least equal to texel size * width");
@@ -90,46 +353,35 @@ Result ExportToPPM(std::ostream& outputStream, grfx::Format inputFormat, const v
                  << height << "\n"
                  << 255 << "\n";
 
-    // This is a naive implementation, and favors flexibility over performance
-    // with the aim to support as many format variations as possible.
-    // We only optimize for the best possible scenario, and fall back to the
-    // generic implemention in other cases.
+    // Without conversion or row padding, the texels are the PPM data.
     if (IsOptimalFormat(desc, width, rowStride)) {
         outputStream.write((const char*)texels, static_cast<std::streamsize>(rowStride) * height);
         return SUCCESS;
     }
 
-    char        zero = 0;
-    const char* data = (const char*)texels;
+    // Rows are converted to RGB8 and written one at a time.
+    const size_t         rowSize = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> row(rowSize + kRowPadding);
+    const uint8_t*       data = static_cast<const uint8_t*>(texels);
     for (uint32_t y = 0; y < height; y++) {
-        const char* row = data;
-        for (uint32_t x = 0; x < width; x++) {
-            if (desc->componentBits & grfx::FORMAT_COMPONENT_RED) {
-                unsigned char red = ConvertToUint(row + desc->componentOffset.red, desc->dataType);
-                outputStream.write((const char*)&red, 1);
-            }
-            else {
-                outputStream.write(&zero, 1);
-            }
-
-            if (desc->componentBits & grfx::FORMAT_COMPONENT_GREEN) {
-                unsigned char green = ConvertToUint(row + desc->componentOffset.green, desc->dataType);
-                outputStream.write((const char*)&green, 1);
-            }
-            else {
-                outputStream.write(&zero, 1);
-            }
-
-            if (desc->componentBits & grfx::FORMAT_COMPONENT_BLUE) {
-                unsigned char blue = ConvertToUint(row + desc->componentOffset.blue, desc->dataType);
-                outputStream.write((const char*)&blue, 1);
-            }
-            else {
-                outputStream.write(&zero, 1);
+        if (convertRow != nullptr) {
+            convertRow(data, width, row.data());
+        }
+        else {
+            // This is a naive implementation, and favors flexibility over
+            // performance with the aim to support as many format variations
+            // as possible.
+            const char* texel = (const char*)data;
+            uint8_t*    pDst  = row.data();
+            for (uint32_t x = 0; x < width; x++) {
+                pDst[0] = (desc->componentBits & grfx::FORMAT_COMPONENT_RED) ? ConvertToUint(texel + desc->componentOffset.red, desc->dataType) : 0;
+                pDst[1] = (desc->componentBits & grfx::FORMAT_COMPONENT_GREEN) ? ConvertToUint(texel + desc->componentOffset.green, desc->dataType) : 0;
+                pDst[2] = (desc->componentBits & grfx::FORMAT_COMPONENT_BLUE) ? ConvertToUint(texel + desc->componentOffset.blue, desc->dataType) : 0;
+                texel += desc->bytesPerTexel;
+                pDst += 3;
             }
-
-            row += desc->bytesPerTexel;
         }
+        outputStream.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(rowSize));
         data += rowStride;
     }
 
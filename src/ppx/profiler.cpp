@@ -15,7 +15,17 @@
 #include "ppx/profiler.h"
 #include "ppx/timer.h"
 
-#define PPX_MAX_THREAD_PROFILERS 64
+#include "nlohmann/json.hpp"
+
+#include <bitset>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+#define PPX_MAX_THREAD_PROFILERS                 64
+#define PPX_PROFILER_SAMPLE_RING_BUFFER_CAPACITY 16384
+#define PPX_MAX_PROFILER_COUNTERS                256
 
 namespace ppx {
 
@@ -24,6 +34,16 @@ static std::mutex         sThreadIndexMutex;
 static unsigned int       sThreadCount = 0;
 thread_local unsigned int sThreadIndex = UINT32_MAX;
 
+// Serializes the consumer side of the per-thread ring buffers.
+static std::mutex sDrainMutex;
+
+// Counter names are only written under the mutex, before the count is
+// published, so that adding to a counter doesn't need the lock.
+static std::mutex            sCounterMutex;
+static std::string           sCounterNames[PPX_MAX_PROFILER_COUNTERS];
+static std::atomic<uint64_t> sCounterValues[PPX_MAX_PROFILER_COUNTERS];
+static std::atomic<uint32_t> sCounterCount = 0;
+
 static unsigned int GetThreadIndex()
 {
     if (sThreadIndex == UINT32_MAX) {
@@ -56,11 +76,12 @@ ProfilerScopedEventSample::~ProfilerScopedEventSample()
 
 // -------------------------------------------------------------------------------------------------
 
-ProfilerEvent::ProfilerEvent(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, const ProfilerEventToken& token)
+ProfilerEvent::ProfilerEvent(ProfilerEventType type, const std::string& name, XXH64_hash_t nameHash, ProfileEventRecordAction recordAction, const ProfilerEventToken& token)
     : mType(type),
       mName(name),
       mAction(recordAction),
-      mToken(token)
+      mToken(token),
+      mNameHash(nameHash)
 {
 }
 
@@ -70,25 +91,214 @@ ProfilerEvent::~ProfilerEvent()
 
 void ProfilerEvent::RecordSample(const ProfilerEventSample& sample)
 {
-    if (mAction == PROFILER_EVENT_RECORD_ACTION_INSERT) {
-        mSamples.push_back(sample);
+    uint64_t diff = (sample.endTimestamp - sample.startTimestamp);
+    mSampleCount += 1;
+    mSampleTotal += diff;
+    mSampleMin = (diff < mSampleMin) ? diff : mSampleMin;
+    mSampleMax = (diff > mSampleMax) ? diff : mSampleMax;
+}
+
+// -------------------------------------------------------------------------------------------------
+// ProfilerSampleRingBuffer
+// -------------------------------------------------------------------------------------------------
+ProfilerSampleRingBuffer::ProfilerSampleRingBuffer(uint32_t capacity)
+{
+    mCapacity = 1;
+    while (mCapacity < capacity) {
+        mCapacity <<= 1;
+    }
+    mMask = mCapacity - 1;
+
+    // Entries are left uninitialized so that the pages of threads that never
+    // record samples are not committed.
+    mEntries.reset(new Entry[mCapacity]);
+}
+
+ProfilerSampleRingBuffer::~ProfilerSampleRingBuffer()
+{
+}
+
+bool ProfilerSampleRingBuffer::Push(const Entry& entry)
+{
+    uint64_t writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+    uint64_t readIndex  = mReadIndex.load(std::memory_order_acquire);
+    if ((writeIndex - readIndex) >= mCapacity) {
+        mDroppedCount.store(mDroppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    mEntries[writeIndex & mMask] = entry;
+    mWriteIndex.store(writeIndex + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool ProfilerSampleRingBuffer::Pop(Entry* pEntry)
+{
+    uint64_t readIndex  = mReadIndex.load(std::memory_order_relaxed);
+    uint64_t writeIndex = mWriteIndex.load(std::memory_order_acquire);
+    if (readIndex == writeIndex) {
+        return false;
+    }
+
+    *pEntry = mEntries[readIndex & mMask];
+    mReadIndex.store(readIndex + 1, std::memory_order_release);
+
+    return true;
+}
+
+void ProfilerSampleRingBuffer::ResetDroppedCount()
+{
+    mDroppedBase.store(mDroppedCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+uint64_t ProfilerSampleRingBuffer::GetDroppedCount() const
+{
+    return mDroppedCount.load(std::memory_order_relaxed) - mDroppedBase.load(std::memory_order_relaxed);
+}
+
+uint32_t ProfilerSampleRingBuffer::GetSize() const
+{
+    uint64_t readIndex  = mReadIndex.load(std::memory_order_acquire);
+    uint64_t writeIndex = mWriteIndex.load(std::memory_order_acquire);
+    return static_cast<uint32_t>(writeIndex - readIndex);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Trace capture
+// -------------------------------------------------------------------------------------------------
+namespace {
+
+// Streams drained samples to disk as Chrome trace-event JSON. Only the
+// background drain thread touches the writer while a capture is active.
+class ChromeTraceWriter
+{
+public:
+    Result Open(const std::filesystem::path& path, uint64_t baseTimestamp)
+    {
+        mFile.open(path, std::ios::out | std::ios::trunc);
+        if (!mFile.is_open()) {
+            return ppx::ERROR_FAILED;
+        }
+        mBaseTimestamp = baseTimestamp;
+        mEventCount    = 0;
+        mThreadNamed.reset();
+        mFile << std::fixed << std::setprecision(3);
+        mFile << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        return ppx::SUCCESS;
+    }
+
+    void Write(const std::vector<ProfilerThreadSample>& samples, const std::vector<std::string>& eventNames)
+    {
+        for (const ProfilerThreadSample& elem : samples) {
+            if ((elem.token >= eventNames.size()) || (elem.sample.startTimestamp < mBaseTimestamp)) {
+                continue;
+            }
+
+            if (!mThreadNamed[elem.threadIndex]) {
+                BeginEvent();
+                mFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << elem.threadIndex
+                      << ",\"args\":{\"name\":\"ppx thread " << elem.threadIndex << "\"}}";
+                mThreadNamed[elem.threadIndex] = true;
+            }
+
+            double ts  = Timer::TimestampToMicros(elem.sample.startTimestamp - mBaseTimestamp);
+            double dur = Timer::TimestampToMicros(elem.sample.endTimestamp - elem.sample.startTimestamp);
+
+            BeginEvent();
+            mFile << "{\"name\":" << eventNames[elem.token]
+                  << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << elem.threadIndex
+                  << ",\"ts\":" << ts
+                  << ",\"dur\":" << dur << "}";
+        }
+    }
+
+    Result Close()
+    {
+        mFile << "\n]}\n";
+        mFile.close();
+        return mFile.fail() ? ppx::ERROR_FAILED : ppx::SUCCESS;
     }
-    else if (mAction == PROFILER_EVENT_RECORD_ACTION_AVERAGE) {
-        uint64_t diff = (sample.endTimestamp - sample.startTimestamp);
-        mSampleCount += 1;
-        mSampleTotal += diff;
-        mSampleMin = (diff < mSampleMin) ? diff : mSampleMin;
-        mSampleMax = (diff > mSampleMax) ? diff : mSampleMax;
+
+private:
+    void BeginEvent()
+    {
+        mFile << ((mEventCount > 0) ? ",\n" : "\n");
+        ++mEventCount;
     }
-    else {
-        PPX_ASSERT_MSG(false, "unknown event record action");
+
+private:
+    std::ofstream                         mFile;
+    uint64_t                              mBaseTimestamp = 0;
+    uint64_t                              mEventCount    = 0;
+    std::bitset<PPX_MAX_THREAD_PROFILERS> mThreadNamed;
+};
+
+struct TraceCapture
+{
+    std::mutex              mutex;
+    std::condition_variable stopCondition;
+    std::thread             thread;
+    bool                    active = false;
+    bool                    stop   = false;
+    ChromeTraceWriter       writer;
+
+    ~TraceCapture()
+    {
+        // The application is expected to call Profiler::StopTraceCapture(),
+        // but don't let a forgotten capture terminate the process at exit.
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            stopCondition.notify_all();
+            thread.join();
+        }
+    }
+};
+
+TraceCapture sTraceCapture;
+
+// Event names are JSON-escaped once per drain so the writer can paste them as-is.
+std::vector<std::string> GetEscapedEventNames()
+{
+    std::lock_guard<std::mutex> lock(sThreadIndexMutex);
+
+    std::vector<std::string> names;
+    for (const ProfilerEvent& event : sPerThreadProfilers[0].GetEvents()) {
+        names.push_back(nlohmann::json(event.GetName()).dump());
+    }
+    return names;
+}
+
+void DrainTraceCaptureSamples(std::vector<ProfilerThreadSample>& samples)
+{
+    samples.clear();
+    Profiler::DrainSamples(&samples);
+    if (!samples.empty()) {
+        sTraceCapture.writer.Write(samples, GetEscapedEventNames());
     }
 }
 
+void TraceCaptureThreadFunc(uint32_t drainIntervalMs)
+{
+    std::vector<ProfilerThreadSample> samples;
+
+    std::unique_lock<std::mutex> lock(sTraceCapture.mutex);
+    while (!sTraceCapture.stop) {
+        sTraceCapture.stopCondition.wait_for(lock, std::chrono::milliseconds(drainIntervalMs));
+        DrainTraceCaptureSamples(samples);
+    }
+}
+
+} // namespace
+
 // -------------------------------------------------------------------------------------------------
 // Profiler
 // -------------------------------------------------------------------------------------------------
 Profiler::Profiler()
+    : mSampleRingBuffer(PPX_PROFILER_SAMPLE_RING_BUFFER_CAPACITY)
 {
 }
 
@@ -101,6 +311,12 @@ void Profiler::ReinitializeGlobalVariables()
     for (auto& profiler : sPerThreadProfilers) {
         profiler.RemoveAllEvents();
     }
+
+    // Counters are registered once and their tokens kept by their users, so
+    // only their values are reset.
+    for (auto& value : sCounterValues) {
+        value.store(0, std::memory_order_relaxed);
+    }
 }
 
 Profiler* Profiler::GetProfilerForThread()
@@ -115,8 +331,15 @@ Profiler* Profiler::GetProfilerForThread()
 
 void Profiler::RemoveAllEvents()
 {
+    std::lock_guard<std::mutex> drainLock(sDrainMutex);
     std::lock_guard<std::mutex> lock(sThreadIndexMutex);
     mEvents.clear();
+
+    // Samples still in the ring buffer refer to the removed events.
+    ProfilerSampleRingBuffer::Entry entry = {};
+    while (mSampleRingBuffer.Pop(&entry)) {
+    }
+    mSampleRingBuffer.ResetDroppedCount();
 }
 
 Result Profiler::RegisterEvent(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken* pToken)
@@ -128,10 +351,14 @@ Result Profiler::RegisterEvent(ProfilerEventType type, const std::string& name,
 
     std::lock_guard<std::mutex> lock(sThreadIndexMutex);
 
-    ProfilerEventToken token = XXH64(name.c_str(), name.length(), 0xDEADBEEF);
+    XXH64_hash_t nameHash = XXH64(name.c_str(), name.length(), 0xDEADBEEF);
+
+    // Every per-thread profiler holds the same events in the same order,
+    // so the next free slot is the same on all of them.
+    ProfilerEventToken token = CountU32(sPerThreadProfilers[0].mEvents);
 
     for (size_t i = 0; i < PPX_MAX_THREAD_PROFILERS; ++i) {
-        Result ppxres = sPerThreadProfilers[i].RegisterEventInternal(type, name, recordAction, token);
+        Result ppxres = sPerThreadProfilers[i].RegisterEventInternal(type, name, nameHash, recordAction, token);
         if (Failed(ppxres)) {
             return ppxres;
         }
@@ -148,33 +375,190 @@ Result Profiler::RegisterGrfxApiFnEvent(const std::string& name, ProfilerEventTo
     return ppxres;
 }
 
-Result Profiler::RegisterEventInternal(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken token)
+Result Profiler::RegisterEventInternal(ProfilerEventType type, const std::string& name, XXH64_hash_t nameHash, ProfileEventRecordAction recordAction, ProfilerEventToken token)
 {
     auto it = FindIf(
         mEvents,
-        [token](const ProfilerEvent& elem) -> bool {
-            bool isSame = (elem.mToken == token);
+        [nameHash](const ProfilerEvent& elem) -> bool {
+            bool isSame = (elem.mNameHash == nameHash);
             return isSame; });
     if (it != std::end(mEvents)) {
         return ppx::ERROR_DUPLICATE_ELEMENT;
     }
 
-    mEvents.emplace_back(type, name, recordAction, token);
+    if (token != CountU32(mEvents)) {
+        PPX_ASSERT_MSG(false, "profiler event tables are out of sync");
+        return ppx::ERROR_FAILED;
+    }
+
+    mEvents.emplace_back(type, name, nameHash, recordAction, token);
+
+    return ppx::SUCCESS;
+}
+
+Result Profiler::RegisterCounter(const std::string& name, ProfilerCounterToken* pToken)
+{
+    PPX_ASSERT_NULL_ARG(pToken);
+    if (IsNull(pToken)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    std::lock_guard<std::mutex> lock(sCounterMutex);
+
+    uint32_t count = sCounterCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (sCounterNames[i] == name) {
+            *pToken = i;
+            return ppx::SUCCESS;
+        }
+    }
+
+    if (count == PPX_MAX_PROFILER_COUNTERS) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    sCounterNames[count] = name;
+    sCounterValues[count].store(0, std::memory_order_relaxed);
+    sCounterCount.store(count + 1, std::memory_order_release);
+
+    *pToken = count;
 
     return ppx::SUCCESS;
 }
 
+void Profiler::AddToCounter(ProfilerCounterToken token, uint64_t value)
+{
+    if (token < sCounterCount.load(std::memory_order_acquire)) {
+        sCounterValues[token].fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Profiler::GetCounterValue(ProfilerCounterToken token)
+{
+    if (token < sCounterCount.load(std::memory_order_acquire)) {
+        return sCounterValues[token].load(std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+void Profiler::GetCounters(std::vector<ProfilerCounterValue>* pCounters)
+{
+    PPX_ASSERT_NULL_ARG(pCounters);
+    if (IsNull(pCounters)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sCounterMutex);
+
+    uint32_t count = sCounterCount.load(std::memory_order_relaxed);
+    pCounters->resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        (*pCounters)[i].name  = sCounterNames[i];
+        (*pCounters)[i].value = sCounterValues[i].load(std::memory_order_relaxed);
+    }
+}
+
 void Profiler::RecordSample(const ProfilerEventToken& token, const ProfilerEventSample& sample)
 {
-    auto it = FindIf(
-        mEvents,
-        [token](const ProfilerEvent& elem) -> bool {
-            bool isSame = (elem.mToken == token);
-            return isSame; });
-    if (it != std::end(mEvents)) {
-        ProfilerEvent& event = *it;
+    if (token < mEvents.size()) {
+        ProfilerEvent& event = mEvents[token];
         event.RecordSample(sample);
+        if (event.mAction == PROFILER_EVENT_RECORD_ACTION_INSERT) {
+            mSampleRingBuffer.Push({token, sample});
+        }
+    }
+}
+
+void Profiler::DrainSamples(std::vector<ProfilerThreadSample>* pSamples)
+{
+    PPX_ASSERT_NULL_ARG(pSamples);
+    if (IsNull(pSamples)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sDrainMutex);
+
+    for (uint32_t i = 0; i < PPX_MAX_THREAD_PROFILERS; ++i) {
+        ProfilerSampleRingBuffer&       ringBuffer = sPerThreadProfilers[i].mSampleRingBuffer;
+        ProfilerSampleRingBuffer::Entry entry      = {};
+        while (ringBuffer.Pop(&entry)) {
+            pSamples->push_back({entry.token, i, entry.sample});
+        }
+    }
+}
+
+uint64_t Profiler::GetDroppedSampleCount()
+{
+    uint64_t count = 0;
+    for (auto& profiler : sPerThreadProfilers) {
+        count += profiler.mSampleRingBuffer.GetDroppedCount();
+    }
+    return count;
+}
+
+Result Profiler::StartTraceCapture(const std::filesystem::path& path, uint32_t drainIntervalMs)
+{
+    std::lock_guard<std::mutex> lock(sTraceCapture.mutex);
+    if (sTraceCapture.active) {
+        return ppx::ERROR_SINGLE_INIT_ONLY;
     }
+
+    // Discard whatever was recorded before the capture started, and only
+    // report the samples that this capture drops.
+    std::vector<ProfilerThreadSample> staleSamples;
+    DrainSamples(&staleSamples);
+    for (auto& profiler : sPerThreadProfilers) {
+        profiler.mSampleRingBuffer.ResetDroppedCount();
+    }
+
+    uint64_t baseTimestamp = 0;
+    Timer::Timestamp(&baseTimestamp);
+
+    Result ppxres = sTraceCapture.writer.Open(path, baseTimestamp);
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("failed to open profiler trace file: " << path);
+        return ppxres;
+    }
+
+    sTraceCapture.active = true;
+    sTraceCapture.stop   = false;
+    sTraceCapture.thread = std::thread(TraceCaptureThreadFunc, std::max<uint32_t>(drainIntervalMs, 1));
+
+    return ppx::SUCCESS;
+}
+
+Result Profiler::StopTraceCapture()
+{
+    {
+        std::lock_guard<std::mutex> lock(sTraceCapture.mutex);
+        if (!sTraceCapture.active) {
+            return ppx::ERROR_FAILED;
+        }
+        sTraceCapture.stop = true;
+    }
+    sTraceCapture.stopCondition.notify_all();
+    sTraceCapture.thread.join();
+
+    std::lock_guard<std::mutex> lock(sTraceCapture.mutex);
+
+    // Pick up anything recorded after the thread's last drain.
+    std::vector<ProfilerThreadSample> samples;
+    DrainTraceCaptureSamples(samples);
+
+    sTraceCapture.active = false;
+
+    uint64_t droppedCount = GetDroppedSampleCount();
+    if (droppedCount > 0) {
+        PPX_LOG_WARN("profiler dropped " << droppedCount << " samples because of full ring buffers");
+    }
+
+    return sTraceCapture.writer.Close();
+}
+
+bool Profiler::IsTraceCaptureActive()
+{
+    std::lock_guard<std::mutex> lock(sTraceCapture.mutex);
+    return sTraceCapture.active;
 }
 
 } // namespace ppx
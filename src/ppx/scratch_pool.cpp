@@ -0,0 +1,203 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scratch_pool.h"
+
+#include <new>
+
+namespace ppx {
+
+namespace {
+
+constexpr uint32_t kMinSizeClassShift = 16;
+constexpr uint32_t kMaxSizeClassShift = 27;
+constexpr uint32_t kSizeClassCount    = kMaxSizeClassShift - kMinSizeClassShift + 1;
+
+static_assert((size_t(1) << kMinSizeClassShift) == ScratchPool::kMinBlockSize, "size classes must start at kMinBlockSize");
+static_assert((size_t(1) << kMaxSizeClassShift) == ScratchPool::kMaxCachedBlockSize, "size classes must end at kMaxCachedBlockSize");
+static_assert(ScratchPool::kMaxCachedBlockSize <= ScratchPool::kMaxThreadCacheSize, "every cacheable block must fit in a thread cache");
+
+char* AllocateBlock(size_t size)
+{
+    return static_cast<char*>(::operator new(size, std::align_val_t(ScratchPool::kBlockAlignment)));
+}
+
+void FreeBlock(char* pData)
+{
+    ::operator delete(pData, std::align_val_t(ScratchPool::kBlockAlignment));
+}
+
+// Returns the size class of a block size, or kSizeClassCount if blocks of
+// this size are not cached.
+uint32_t GetSizeClass(size_t size)
+{
+    for (uint32_t i = 0; i < kSizeClassCount; ++i) {
+        if (size <= (ScratchPool::kMinBlockSize << i)) {
+            return i;
+        }
+    }
+    return kSizeClassCount;
+}
+
+struct ThreadCache
+{
+    char*    blocks[kSizeClassCount][ScratchPool::kMaxCachedBlocksPerClass] = {};
+    uint32_t blockCounts[kSizeClassCount]                                   = {};
+    size_t   size                                                           = 0;
+
+    // Frees the largest cached blocks until newSize more bytes fit in the
+    // budget.
+    void MakeRoom(size_t newSize);
+    void Trim();
+    ~ThreadCache();
+};
+
+// Blocks released while their thread exits, after its cache is destroyed,
+// are freed directly. This flag is trivially destructible so that it can
+// still be read then.
+thread_local bool sThreadCacheDestroyed = false;
+
+ThreadCache& GetThreadCache()
+{
+    thread_local ThreadCache sThreadCache;
+    return sThreadCache;
+}
+
+void ThreadCache::MakeRoom(size_t newSize)
+{
+    for (uint32_t i = kSizeClassCount; (i > 0) && ((size + newSize) > ScratchPool::kMaxThreadCacheSize); --i) {
+        while ((blockCounts[i - 1] > 0) && ((size + newSize) > ScratchPool::kMaxThreadCacheSize)) {
+            FreeBlock(blocks[i - 1][--blockCounts[i - 1]]);
+            size -= ScratchPool::kMinBlockSize << (i - 1);
+        }
+    }
+}
+
+void ThreadCache::Trim()
+{
+    for (uint32_t i = 0; i < kSizeClassCount; ++i) {
+        for (uint32_t j = 0; j < blockCounts[i]; ++j) {
+            FreeBlock(blocks[i][j]);
+        }
+        blockCounts[i] = 0;
+    }
+    size = 0;
+}
+
+ThreadCache::~ThreadCache()
+{
+    Trim();
+    sThreadCacheDestroyed = true;
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// ScratchPool::Block
+// -------------------------------------------------------------------------------------------------
+ScratchPool::Block::Block(Block&& other)
+    : mData(other.mData), mSize(other.mSize)
+{
+    other.mData = nullptr;
+    other.mSize = 0;
+}
+
+ScratchPool::Block::~Block()
+{
+    Release();
+}
+
+ScratchPool::Block& ScratchPool::Block::operator=(Block&& other)
+{
+    if (this != &other) {
+        Release();
+        mData       = other.mData;
+        mSize       = other.mSize;
+        other.mData = nullptr;
+        other.mSize = 0;
+    }
+    return *this;
+}
+
+void ScratchPool::Block::Release()
+{
+    if (mData == nullptr) {
+        return;
+    }
+
+    uint32_t sizeClass = GetSizeClass(mSize);
+    if ((sizeClass < kSizeClassCount) && !sThreadCacheDestroyed) {
+        ThreadCache& cache = GetThreadCache();
+        if (cache.blockCounts[sizeClass] < kMaxCachedBlocksPerClass) {
+            cache.MakeRoom(mSize);
+            cache.size += mSize;
+            cache.blocks[sizeClass][cache.blockCounts[sizeClass]++] = mData;
+            mData                                                   = nullptr;
+        }
+    }
+
+    if (mData != nullptr) {
+        FreeBlock(mData);
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+
+// -------------------------------------------------------------------------------------------------
+// ScratchPool
+// -------------------------------------------------------------------------------------------------
+ScratchPool::Block ScratchPool::Acquire(size_t size)
+{
+    Block block;
+    if (size == 0) {
+        return block;
+    }
+
+    uint32_t sizeClass = GetSizeClass(size);
+    if (sizeClass == kSizeClassCount) {
+        block.mData = AllocateBlock(size);
+        block.mSize = size;
+        return block;
+    }
+
+    block.mSize = kMinBlockSize << sizeClass;
+    if (!sThreadCacheDestroyed) {
+        ThreadCache& cache = GetThreadCache();
+        if (cache.blockCounts[sizeClass] > 0) {
+            block.mData = cache.blocks[sizeClass][--cache.blockCounts[sizeClass]];
+            cache.size -= block.mSize;
+            return block;
+        }
+    }
+    block.mData = AllocateBlock(block.mSize);
+    return block;
+}
+
+void ScratchPool::TrimThreadCache()
+{
+    if (!sThreadCacheDestroyed) {
+        GetThreadCache().Trim();
+    }
+}
+
+size_t ScratchPool::GetThreadCacheSize()
+{
+    if (sThreadCacheDestroyed) {
+        return 0;
+    }
+
+    return GetThreadCache().size;
+}
+
+} // namespace ppx
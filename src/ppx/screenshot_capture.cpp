@@ -0,0 +1,288 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/screenshot_capture.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_format.h"
+#include "ppx/ppm_export.h"
+
+#include <cstring>
+
+namespace ppx {
+
+ScreenshotCapture::~ScreenshotCapture()
+{
+    PPX_ASSERT_MSG(!IsCreated(), "ScreenshotCapture must be destroyed before the device");
+}
+
+Result ScreenshotCapture::Create(grfx::Queue* pQueue, uint32_t ringSize)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_MSG(!IsCreated(), "ScreenshotCapture is already created");
+
+    mQueue = pQueue;
+    mSlots.resize(std::max<uint32_t>(ringSize, 1));
+    for (Slot& slot : mSlots) {
+        Result ppxres = mQueue->CreateCommandBuffer(&slot.commandBuffer, 0, 0);
+        if (Failed(ppxres)) {
+            Destroy();
+            return ppxres;
+        }
+
+        grfx::FenceCreateInfo fenceCreateInfo = {};
+        ppxres                                = mQueue->GetDevice()->CreateFence(&fenceCreateInfo, &slot.fence);
+        if (Failed(ppxres)) {
+            Destroy();
+            return ppxres;
+        }
+    }
+
+    mStopThread = false;
+    mThread     = std::thread(&ScreenshotCapture::WriteLoop, this);
+    return ppx::SUCCESS;
+}
+
+void ScreenshotCapture::Destroy()
+{
+    if (mThread.joinable()) {
+        Flush();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopThread = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    for (Slot& slot : mSlots) {
+        if (slot.buffer) {
+            mQueue->GetDevice()->DestroyBuffer(slot.buffer);
+        }
+        if (slot.fence) {
+            mQueue->GetDevice()->DestroyFence(slot.fence);
+        }
+        if (slot.commandBuffer) {
+            mQueue->DestroyCommandBuffer(slot.commandBuffer);
+        }
+    }
+    mSlots.clear();
+    mNextSlot = 0;
+    mQueue    = nullptr;
+}
+
+Result ScreenshotCapture::Capture(grfx::Image* pImage, grfx::ResourceState imageState, const std::filesystem::path& path)
+{
+    PPX_ASSERT_NULL_ARG(pImage);
+    PPX_ASSERT_MSG(IsCreated(), "ScreenshotCapture is not created");
+
+    Slot& slot = mSlots[mNextSlot];
+    mNextSlot  = (mNextSlot + 1) % CountU32(mSlots);
+    WaitForSlot(&slot);
+
+    const grfx::FormatDesc* formatDesc = grfx::GetFormatDescription(pImage->GetFormat());
+    const uint32_t          width      = pImage->GetWidth();
+    const uint32_t          height     = pImage->GetHeight();
+
+    // Increase the buffer size by a factor of 2 to ensure that a
+    // larger-than-needed row pitch will not overflow the buffer.
+    const uint64_t bufferSize = 2ull * formatDesc->bytesPerTexel * width * height;
+    if (slot.buffer && (slot.buffer->GetSize() < bufferSize)) {
+        mQueue->GetDevice()->DestroyBuffer(slot.buffer);
+        slot.buffer.Reset();
+    }
+    if (!slot.buffer) {
+        grfx::BufferCreateInfo ci      = {};
+        ci.size                        = bufferSize;
+        ci.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+        ci.usageFlags.bits.transferDst = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+
+        Result ppxres = mQueue->GetDevice()->CreateBuffer(&ci, &slot.buffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Copy the image into the buffer. On failure the command buffer is reset,
+    // so that the next capture in the slot can record it again.
+    grfx::ImageToBufferOutputPitch outPitch;
+    Result                         ppxres = slot.commandBuffer->Begin();
+    if (Failed(ppxres)) {
+        slot.commandBuffer->Reset();
+        return ppxres;
+    }
+    {
+        slot.commandBuffer->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, imageState, grfx::RESOURCE_STATE_COPY_SRC);
+
+        grfx::ImageToBufferCopyInfo copyInfo = {};
+        copyInfo.extent                      = {width, height, 0};
+        outPitch                             = slot.commandBuffer->CopyImageToBuffer(&copyInfo, pImage, slot.buffer);
+
+        slot.commandBuffer->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_COPY_SRC, imageState);
+    }
+    ppxres = slot.commandBuffer->End();
+    if (Failed(ppxres)) {
+        slot.commandBuffer->Reset();
+        return ppxres;
+    }
+
+    // The fence is only reset once there is a copy to submit.
+    ppxres = slot.fence->Reset();
+    if (Failed(ppxres)) {
+        slot.commandBuffer->Reset();
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &slot.commandBuffer;
+    submitInfo.pFence             = slot.fence;
+    ppxres                        = mQueue->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        slot.commandBuffer->Reset();
+        return ppxres;
+    }
+
+    slot.format   = pImage->GetFormat();
+    slot.width    = width;
+    slot.height   = height;
+    slot.rowPitch = outPitch.rowPitch;
+    slot.path     = path;
+
+    slot.redInHighBits = (slot.format == grfx::FORMAT_R10G10B10A2_UNORM) && grfx::IsVk(mQueue->GetDevice()->GetApi());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    slot.state = SLOT_STATE_COPYING;
+    return ppx::SUCCESS;
+}
+
+void ScreenshotCapture::Update()
+{
+    for (Slot& slot : mSlots) {
+        SlotState state = SLOT_STATE_FREE;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            state = slot.state;
+        }
+
+        if ((state == SLOT_STATE_COPYING) && slot.fence->IsSignaled()) {
+            BeginWrite(&slot);
+        }
+        else if (state == SLOT_STATE_WRITTEN) {
+            EndWrite(&slot);
+        }
+    }
+}
+
+void ScreenshotCapture::Flush()
+{
+    for (Slot& slot : mSlots) {
+        WaitForSlot(&slot);
+    }
+}
+
+void ScreenshotCapture::WaitForSlot(Slot* pSlot)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (pSlot->state == SLOT_STATE_COPYING) {
+        lock.unlock();
+        pSlot->fence->Wait();
+        BeginWrite(pSlot);
+        lock.lock();
+    }
+    mCondition.wait(lock, [pSlot]() { return pSlot->state != SLOT_STATE_WRITING; });
+    if (pSlot->state == SLOT_STATE_WRITTEN) {
+        lock.unlock();
+        EndWrite(pSlot);
+    }
+}
+
+void ScreenshotCapture::BeginWrite(Slot* pSlot)
+{
+    void*  pTexels = nullptr;
+    Result ppxres  = pSlot->buffer->MapMemory(0, &pTexels);
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("Failed to map screenshot buffer for: " << pSlot->path.string());
+        std::lock_guard<std::mutex> lock(mMutex);
+        pSlot->state = SLOT_STATE_FREE;
+        return;
+    }
+    pSlot->pTexels = pTexels;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        pSlot->state = SLOT_STATE_WRITING;
+        mWriteQueue.push_back(pSlot);
+    }
+    mCondition.notify_all();
+}
+
+void ScreenshotCapture::EndWrite(Slot* pSlot)
+{
+    pSlot->buffer->UnmapMemory();
+    pSlot->pTexels = nullptr;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    pSlot->state = SLOT_STATE_FREE;
+}
+
+void ScreenshotCapture::SwapRedBlue10(Slot* pSlot)
+{
+    pSlot->swizzledTexels.resize(static_cast<size_t>(pSlot->width) * pSlot->height);
+    uint32_t* pDst = pSlot->swizzledTexels.data();
+    for (uint32_t y = 0; y < pSlot->height; ++y) {
+        const uint8_t* pRow = static_cast<const uint8_t*>(pSlot->pTexels) + static_cast<size_t>(y) * pSlot->rowPitch;
+        for (uint32_t x = 0; x < pSlot->width; ++x) {
+            uint32_t texel = 0;
+            std::memcpy(&texel, pRow + 4 * x, sizeof(texel));
+            *pDst++ = (texel & 0xC00FFC00) | ((texel >> 20) & 0x3FF) | ((texel & 0x3FF) << 20);
+        }
+    }
+}
+
+void ScreenshotCapture::WriteLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this]() { return mStopThread || !mWriteQueue.empty(); });
+        if (mWriteQueue.empty()) {
+            return;
+        }
+        Slot* pSlot = mWriteQueue.front();
+        mWriteQueue.pop_front();
+
+        // The render thread does not touch a slot while it is being written.
+        lock.unlock();
+        const void* pTexels  = pSlot->pTexels;
+        uint32_t    rowPitch = pSlot->rowPitch;
+        if (pSlot->redInHighBits) {
+            SwapRedBlue10(pSlot);
+            pTexels  = pSlot->swizzledTexels.data();
+            rowPitch = pSlot->width * sizeof(uint32_t);
+        }
+        Result ppxres = ExportToPPM(pSlot->path.string(), pSlot->format, pTexels, pSlot->width, pSlot->height, rowPitch);
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("Failed to save screenshot to: " << pSlot->path.string() << " (" << ToString(ppxres) << ")");
+        }
+        else {
+            PPX_LOG_INFO("Screenshot saved to: " << pSlot->path.string());
+        }
+        lock.lock();
+
+        pSlot->state = SLOT_STATE_WRITTEN;
+        mCondition.notify_all();
+    }
+}
+
+} // namespace ppx
@@ -0,0 +1,216 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/task_pool.h"
+
+#include <algorithm>
+
+namespace ppx {
+
+namespace internal {
+
+struct TaskState
+{
+    TaskPool::TaskFunc   func;
+    uint64_t             sequence = 0;
+    std::atomic<int32_t> priority = 0;
+
+    // PENDING -> RUNNING is a compare-exchange, so that a task is either
+    // taken by a thread or canceled. The transitions to COMPLETE and
+    // CANCELED are made under the mutex, which waiters block on.
+    std::atomic<TaskStatus> status = TASK_STATUS_PENDING;
+    std::mutex              mutex;
+    std::condition_variable condition;
+};
+
+} // namespace internal
+
+// -------------------------------------------------------------------------------------------------
+// TaskHandle
+// -------------------------------------------------------------------------------------------------
+TaskStatus TaskHandle::GetStatus() const
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid task handle");
+    return mState->status.load();
+}
+
+bool TaskHandle::IsDone() const
+{
+    TaskStatus status = GetStatus();
+    return (status == TASK_STATUS_COMPLETE) || (status == TASK_STATUS_CANCELED);
+}
+
+void TaskHandle::Wait() const
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid task handle");
+    std::unique_lock<std::mutex> lock(mState->mutex);
+    mState->condition.wait(lock, [this]() { return IsDone(); });
+}
+
+bool TaskHandle::Cancel()
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid task handle");
+    bool               canceled = false;
+    TaskPool::TaskFunc func;
+    {
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        TaskStatus                  expected = TASK_STATUS_PENDING;
+        canceled                             = mState->status.compare_exchange_strong(expected, TASK_STATUS_CANCELED);
+        if (canceled) {
+            // The function never runs. Release what it captured now, since
+            // the state can live on in handles, even in ones it captured.
+            func.swap(mState->func);
+        }
+    }
+    if (canceled) {
+        mState->condition.notify_all();
+    }
+    return canceled;
+}
+
+void TaskHandle::SetPriority(int32_t priority)
+{
+    PPX_ASSERT_MSG(IsValid(), "invalid task handle");
+    mState->priority = priority;
+}
+
+// -------------------------------------------------------------------------------------------------
+// TaskPool
+// -------------------------------------------------------------------------------------------------
+TaskPool::~TaskPool()
+{
+    Destroy();
+}
+
+Result TaskPool::Create(uint32_t threadCount)
+{
+    PPX_ASSERT_MSG(!IsCreated(), "TaskPool is already created");
+    if (threadCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mStopThreads = false;
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&TaskPool::RunTasks, this);
+    }
+    return ppx::SUCCESS;
+}
+
+void TaskPool::Destroy()
+{
+    if (!IsCreated()) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<internal::TaskState>> pendingTasks;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopThreads = true;
+        pendingTasks.swap(mPendingTasks);
+    }
+    mCondition.notify_all();
+
+    for (auto& state : pendingTasks) {
+        TaskHandle handle;
+        handle.mState = state;
+        handle.Cancel();
+    }
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+    mThreads.clear();
+}
+
+TaskHandle TaskPool::Submit(TaskFunc func, int32_t priority)
+{
+    PPX_ASSERT_MSG(IsCreated(), "TaskPool is not created");
+
+    TaskHandle handle;
+    handle.mState           = std::make_shared<internal::TaskState>();
+    handle.mState->func     = std::move(func);
+    handle.mState->priority = priority;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        handle.mState->sequence = mNextSequence++;
+        mPendingTasks.push_back(handle.mState);
+    }
+    mCondition.notify_one();
+    return handle;
+}
+
+void TaskPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]() { return mPendingTasks.empty() && (mRunningCount == 0); });
+}
+
+void TaskPool::RunTasks()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this]() { return mStopThreads || !mPendingTasks.empty(); });
+        if (mStopThreads) {
+            return;
+        }
+
+        // Drop canceled tasks, then take the one to run.
+        mPendingTasks.erase(
+            std::remove_if(
+                mPendingTasks.begin(),
+                mPendingTasks.end(),
+                [](const std::shared_ptr<internal::TaskState>& task) { return task->status.load() != TASK_STATUS_PENDING; }),
+            mPendingTasks.end());
+
+        std::shared_ptr<internal::TaskState> state;
+        if (!mPendingTasks.empty()) {
+            auto best = std::max_element(
+                mPendingTasks.begin(),
+                mPendingTasks.end(),
+                [](const std::shared_ptr<internal::TaskState>& a, const std::shared_ptr<internal::TaskState>& b) {
+                    int32_t priorityA = a->priority;
+                    int32_t priorityB = b->priority;
+                    return (priorityA < priorityB) || ((priorityA == priorityB) && (a->sequence > b->sequence));
+                });
+            state = std::move(*best);
+            *best = std::move(mPendingTasks.back());
+            mPendingTasks.pop_back();
+        }
+
+        TaskStatus expected = TASK_STATUS_PENDING;
+        if (!state || !state->status.compare_exchange_strong(expected, TASK_STATUS_RUNNING)) {
+            // Nothing left, or canceled since the scan.
+            if (mPendingTasks.empty() && (mRunningCount == 0)) {
+                mCondition.notify_all();
+            }
+            continue;
+        }
+
+        ++mRunningCount;
+        lock.unlock();
+        state->func();
+        state->func = nullptr;
+        {
+            std::lock_guard<std::mutex> stateLock(state->mutex);
+            state->status = TASK_STATUS_COMPLETE;
+        }
+        state->condition.notify_all();
+        lock.lock();
+        --mRunningCount;
+
+        // Wakes WaitIdle().
+        mCondition.notify_all();
+    }
+}
+
+} // namespace ppx
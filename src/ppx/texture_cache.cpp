@@ -0,0 +1,204 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/texture_cache.h"
+#include "ppx/binary_file.h"
+
+#include "xxhash.h"
+
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace ppx {
+
+namespace {
+
+using internal::Put;
+
+const char kMagic[4] = {'P', 'P', 'T', 'C'};
+
+// Upper bound on the level count read from a file, enough for any 32-bit size.
+const uint32_t kMaxLevelCount = 32;
+
+std::mutex            sCacheDirectoryMutex;
+std::filesystem::path sCacheDirectory;
+
+void PutKey(std::vector<uint8_t>* pBuffer, const TextureCacheFile::Key& key)
+{
+    Put<uint64_t>(pBuffer, key.contentHash);
+    Put<uint32_t>(pBuffer, key.mipLevelCount);
+    Put<uint32_t>(pBuffer, key.sRGBMipFilter ? 1 : 0);
+    Put<uint32_t>(pBuffer, key.rowStrideAlignment);
+    Put<uint32_t>(pBuffer, key.offsetAlignment);
+}
+
+// Lays out levels one after the other, with rows and levels aligned as
+// required by the key. Returns the size of the data.
+uint64_t ComputeLayout(const TextureCacheFile::Key& key, Bitmap::Format format, std::vector<TextureCacheFile::Level>* pLevels)
+{
+    const uint32_t pixelStride = Bitmap::FormatSize(format);
+    const uint32_t rowAlign    = std::max<uint32_t>(key.rowStrideAlignment, 1);
+    const uint32_t offsetAlign = std::max<uint32_t>(key.offsetAlignment, 1);
+
+    uint64_t size = 0;
+    for (TextureCacheFile::Level& level : *pLevels) {
+        level.rowStride = RoundUp<uint32_t>(level.width * pixelStride, rowAlign);
+        level.offset    = RoundUp<uint64_t>(size, offsetAlign);
+        size            = level.offset + static_cast<uint64_t>(level.rowStride) * level.height;
+    }
+    return size;
+}
+
+} // namespace
+
+uint64_t TextureCacheFile::HashContent(const void* pData, size_t size)
+{
+    return static_cast<uint64_t>(XXH64(pData, size, 0));
+}
+
+std::filesystem::path TextureCacheFile::GetCachePath(const std::filesystem::path& cacheDirectory, const TextureCacheFile::Key& key)
+{
+    std::vector<uint8_t> nameKey;
+    PutKey(&nameKey, key);
+
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key.contentHash << "-";
+    ss << std::hex << std::setw(16) << std::setfill('0') << HashContent(nameKey.data(), nameKey.size()) << ".ppxtex";
+    return cacheDirectory / ss.str();
+}
+
+Result TextureCacheFile::Write(
+    const std::filesystem::path& cachePath,
+    const TextureCacheFile::Key& key,
+    const Mipmap&                mipmap)
+{
+    if (!mipmap.IsOk()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    const Bitmap::Format format     = mipmap.GetMip(0)->GetFormat();
+    const uint32_t       levelCount = std::min<uint32_t>(key.mipLevelCount, mipmap.GetLevelCount());
+
+    std::vector<Level> levels(levelCount);
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        levels[i].width  = mipmap.GetWidth(i);
+        levels[i].height = mipmap.GetHeight(i);
+    }
+    const uint64_t dataSize = ComputeLayout(key, format, &levels);
+
+    std::vector<uint8_t> header;
+    PutKey(&header, key);
+    Put<uint32_t>(&header, static_cast<uint32_t>(format));
+    Put<uint32_t>(&header, levelCount);
+    for (const Level& level : levels) {
+        Put<uint32_t>(&header, level.width);
+        Put<uint32_t>(&header, level.height);
+        Put<uint32_t>(&header, level.rowStride);
+        Put<uint64_t>(&header, level.offset);
+    }
+
+    const uint64_t dataOffset = RoundUp<uint64_t>(GetDataOffset(header.size() + 2 * sizeof(uint64_t)), kDataAlignment);
+    Put<uint64_t>(&header, dataOffset);
+    Put<uint64_t>(&header, dataSize);
+
+    return WriteFile(cachePath, kMagic, kVersion, header, [&](std::ostream& file) {
+        // Rows and levels are padded with zeros up to their aligned offset.
+        const uint32_t    maxAlignment = std::max<uint32_t>({kDataAlignment, key.rowStrideAlignment, key.offsetAlignment});
+        std::vector<char> padding(maxAlignment);
+        file.write(padding.data(), dataOffset - static_cast<uint64_t>(file.tellp()));
+        for (uint32_t i = 0; i < levelCount; ++i) {
+            const Bitmap*  pMip    = mipmap.GetMip(i);
+            const uint32_t rowSize = pMip->GetWidth() * pMip->GetPixelStride();
+            file.write(padding.data(), dataOffset + levels[i].offset - static_cast<uint64_t>(file.tellp()));
+            for (uint32_t y = 0; y < pMip->GetHeight(); ++y) {
+                file.write(pMip->GetData() + y * pMip->GetRowStride(), rowSize);
+                file.write(padding.data(), levels[i].rowStride - rowSize);
+            }
+        }
+    });
+}
+
+Result TextureCacheFile::Open(const std::filesystem::path& cachePath, const TextureCacheFile::Key& key)
+{
+    Unmap();
+    mFormat = Bitmap::FORMAT_UNDEFINED;
+    mLevels.clear();
+    mDataOffset = 0;
+    mDataSize   = 0;
+
+    std::vector<uint8_t> expectedKey;
+    size_t               headerOffset = 0;
+    PutKey(&expectedKey, key);
+    if (Failed(MapFile(cachePath, kMagic, kVersion, expectedKey, &headerOffset))) {
+        return ppx::ERROR_FAILED;
+    }
+
+    internal::ByteReader reader(GetFileData(), GetFileSize());
+    reader.Skip(headerOffset);
+
+    uint32_t format     = 0;
+    uint32_t levelCount = 0;
+    reader.Get(&format);
+    reader.Get(&levelCount);
+    if (!reader.IsValid() || (format == Bitmap::FORMAT_UNDEFINED) || (format > Bitmap::FORMAT_RGBA_FLOAT) || (levelCount == 0) || (levelCount > kMaxLevelCount)) {
+        Unmap();
+        return ppx::ERROR_FAILED;
+    }
+
+    std::vector<Level> levels(levelCount);
+    for (Level& level : levels) {
+        reader.Get(&level.width);
+        reader.Get(&level.height);
+        reader.Get(&level.rowStride);
+        reader.Get(&level.offset);
+    }
+    uint64_t dataOffset = 0;
+    uint64_t dataSize   = 0;
+    reader.Get(&dataOffset);
+    reader.Get(&dataSize);
+    if (!reader.IsValid() || (dataOffset > GetFileSize()) || (dataSize > (GetFileSize() - dataOffset))) {
+        Unmap();
+        return ppx::ERROR_FAILED;
+    }
+
+    const uint64_t pixelStride = Bitmap::FormatSize(static_cast<Bitmap::Format>(format));
+    for (const Level& level : levels) {
+        const uint64_t levelSize = static_cast<uint64_t>(level.rowStride) * level.height;
+        if ((level.rowStride < level.width * pixelStride) || (level.offset > dataSize) || (levelSize > (dataSize - level.offset))) {
+            Unmap();
+            return ppx::ERROR_FAILED;
+        }
+    }
+
+    mFormat     = static_cast<Bitmap::Format>(format);
+    mLevels     = std::move(levels);
+    mDataOffset = dataOffset;
+    mDataSize   = dataSize;
+    return ppx::SUCCESS;
+}
+
+void SetTextureCacheDirectory(const std::filesystem::path& directory)
+{
+    std::lock_guard<std::mutex> lock(sCacheDirectoryMutex);
+    sCacheDirectory = directory;
+}
+
+std::filesystem::path GetTextureCacheDirectory()
+{
+    std::lock_guard<std::mutex> lock(sCacheDirectoryMutex);
+    return sCacheDirectory;
+}
+
+} // namespace ppx
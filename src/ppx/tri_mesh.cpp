@@ -14,13 +14,41 @@
 
 #include "ppx/tri_mesh.h"
 #include "ppx/math_util.h"
+#include "ppx/obj_parser.h"
+#include "ppx/parallel.h"
 #include "ppx/timer.h"
-#include "ppx/fs.h"
 
-#include "tiny_obj_loader.h"
+#include <cstring>
 
 namespace ppx {
 
+void TriMeshOptions::Serialize(std::vector<uint8_t>* pBytes) const
+{
+    auto append = [pBytes](const void* pValue, size_t size) {
+        const uint8_t* pValueBytes = static_cast<const uint8_t*>(pValue);
+        pBytes->insert(pBytes->end(), pValueBytes, pValueBytes + size);
+    };
+
+    const uint8_t flags[] = {
+        mEnableIndices,
+        mEnableVertexColors,
+        mEnableNormals,
+        mEnableTexCoords,
+        mEnableTangents,
+        mEnableObjectColor,
+        mInvertTexCoordsV,
+        mInvertWinding,
+        mOptimizeVertexCache,
+        mOptimizeOverdraw,
+    };
+    append(flags, sizeof(flags));
+    append(&mOverdrawThreshold, sizeof(mOverdrawThreshold));
+    append(&mObjectColor, sizeof(mObjectColor));
+    append(&mTranslate, sizeof(mTranslate));
+    append(&mScale, sizeof(mScale));
+    append(&mTexCoordScale, sizeof(mTexCoordScale));
+}
+
 TriMesh::TriMesh()
 {
 }
@@ -514,6 +542,66 @@ Result TriMesh::GetVertexData(uint32_t vtxIndex, TriMeshVertexData* pVertexData)
     return ppx::SUCCESS;
 }
 
+VertexCacheStatistics TriMesh::AnalyzeVertexCache(uint32_t cacheSize) const
+{
+    uint32_t              indexCount = GetCountIndices();
+    std::vector<uint32_t> indices(indexCount);
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        indices[i] = (mIndexType == grfx::INDEX_TYPE_UINT16) ? *GetDataIndicesU16(i) : *GetDataIndicesU32(i);
+    }
+    return ppx::AnalyzeVertexCache(indices.data(), indices.size(), GetCountPositions(), cacheSize);
+}
+
+void TriMesh::OptimizeVertexCache(bool optimizeOverdraw, float overdrawThreshold)
+{
+    uint32_t indexCount  = GetCountIndices();
+    uint32_t vertexCount = GetCountPositions();
+    if (indexCount == 0) {
+        return;
+    }
+
+    std::vector<uint32_t> indices(indexCount);
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        indices[i] = (mIndexType == grfx::INDEX_TYPE_UINT16) ? *GetDataIndicesU16(i) : *GetDataIndicesU32(i);
+    }
+
+    ppx::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    if (optimizeOverdraw) {
+        ppx::OptimizeOverdraw(indices.data(), indices.size(), mPositions.data(), vertexCount, overdrawThreshold);
+    }
+
+    std::vector<uint32_t> remap;
+    OptimizeVertexFetchRemap(indices.data(), indices.size(), vertexCount, &remap);
+    RemapVertexAttribute(remap, &mPositions);
+    RemapVertexAttribute(remap, &mColors);
+    RemapVertexAttribute(remap, &mNormals);
+    RemapVertexAttribute(remap, &mTexCoords, static_cast<size_t>(mTexCoordDim));
+    RemapVertexAttribute(remap, &mTangents);
+    RemapVertexAttribute(remap, &mBitangents);
+
+    if (mIndexType == grfx::INDEX_TYPE_UINT16) {
+        uint16_t* pIndices = reinterpret_cast<uint16_t*>(mIndices.data());
+        for (uint32_t i = 0; i < indexCount; ++i) {
+            pIndices[i] = static_cast<uint16_t>(indices[i]);
+        }
+    }
+    else {
+        std::memcpy(mIndices.data(), indices.data(), indices.size() * sizeof(uint32_t));
+    }
+}
+
+void TriMesh::ApplyOptimizations(const TriMeshOptions& options)
+{
+    if ((!options.mOptimizeVertexCache && !options.mOptimizeOverdraw) || (mIndexType == grfx::INDEX_TYPE_UNDEFINED)) {
+        return;
+    }
+
+    VertexCacheStatistics before = AnalyzeVertexCache();
+    OptimizeVertexCache(options.mOptimizeOverdraw, options.mOverdrawThreshold);
+    VertexCacheStatistics after = AnalyzeVertexCache();
+    PPX_LOG_INFO("Optimized mesh with " << GetCountTriangles() << " triangles: ACMR " << FloatString(before.acmr, 3) << " -> " << FloatString(after.acmr, 3) << ", ATVR " << FloatString(before.atvr, 3) << " -> " << FloatString(after.atvr, 3));
+}
+
 void TriMesh::AppendIndexAndVertexData(
     std::vector<uint32_t>&    indexData,
     const std::vector<float>& vertexData,
@@ -588,6 +676,8 @@ void TriMesh::AppendIndexAndVertexData(
             }
         }
     }
+
+    mesh.ApplyOptimizations(options);
 }
 
 TriMesh TriMesh::CreatePlane(TriMeshPlane plane, const float2& size, uint32_t usegs, uint32_t vsegs, const TriMeshOptions& options)
@@ -900,6 +990,113 @@ TriMesh TriMesh::CreateSphere(float radius, uint32_t usegs, uint32_t vsegs, cons
     return mesh;
 }
 
+namespace {
+
+// Triangles per thread when filling the mesh from OBJ data.
+constexpr size_t kMinObjTrianglesPerThread = 1 << 16;
+
+// Open addressing hash table mapping the attribute indices of OBJ face
+// corners to vertex indices, used to share the vertices of indexed meshes.
+// Vertices are numbered in the order they are first inserted.
+class ObjVertexTable
+{
+public:
+    explicit ObjVertexTable(size_t expectedVertexCount)
+    {
+        Rehash(std::max<size_t>(expectedVertexCount * 2, 1024));
+        mVertices.reserve(expectedVertexCount);
+    }
+
+    uint32_t Insert(const ObjIndex& corner)
+    {
+        if ((mVertices.size() + 1) * 2 > mSlots.size()) {
+            Rehash(mSlots.size() * 2);
+        }
+        size_t slot = Hash(corner) & mMask;
+        for (;;) {
+            uint32_t vertex = mSlots[slot];
+            if (vertex == kEmptySlot) {
+                vertex       = static_cast<uint32_t>(mVertices.size());
+                mSlots[slot] = vertex;
+                mVertices.push_back(corner);
+                return vertex;
+            }
+            const ObjIndex& other = mVertices[vertex];
+            if ((other.position == corner.position) && (other.texCoord == corner.texCoord) && (other.normal == corner.normal)) {
+                return vertex;
+            }
+            slot = (slot + 1) & mMask;
+        }
+    }
+
+    const std::vector<ObjIndex>& GetVertices() const { return mVertices; }
+
+private:
+    static constexpr uint32_t kEmptySlot = UINT32_MAX;
+
+    static size_t Hash(const ObjIndex& corner)
+    {
+        uint64_t hash = static_cast<uint32_t>(corner.position);
+        hash          = (hash * 0x9E3779B97F4A7C15ull) ^ static_cast<uint32_t>(corner.texCoord);
+        hash          = (hash * 0x9E3779B97F4A7C15ull) ^ static_cast<uint32_t>(corner.normal);
+        hash ^= hash >> 29;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 32;
+        return static_cast<size_t>(hash);
+    }
+
+    void Rehash(size_t minSlotCount)
+    {
+        size_t slotCount = 1;
+        while (slotCount < minSlotCount) {
+            slotCount <<= 1;
+        }
+        mSlots.assign(slotCount, kEmptySlot);
+        mMask = slotCount - 1;
+        for (uint32_t vertex = 0; vertex < CountU32(mVertices); ++vertex) {
+            size_t slot = Hash(mVertices[vertex]) & mMask;
+            while (mSlots[slot] != kEmptySlot) {
+                slot = (slot + 1) & mMask;
+            }
+            mSlots[slot] = vertex;
+        }
+    }
+
+private:
+    std::vector<uint32_t> mSlots;
+    std::vector<ObjIndex> mVertices;
+    size_t                mMask = 0;
+};
+
+// Computes the tangent and bitangent of a triangle from its (unscaled)
+// positions and texture coordinates.
+void ComputeObjTangent(const TriMeshVertexData& vtx0, const TriMeshVertexData& vtx1, const TriMeshVertexData& vtx2, float4* pTangent, float3* pBitangent)
+{
+    float3 edge1 = vtx1.position - vtx0.position;
+    float3 edge2 = vtx2.position - vtx0.position;
+    float2 duv1  = vtx1.texCoord - vtx0.texCoord;
+    float2 duv2  = vtx2.texCoord - vtx0.texCoord;
+    float  r     = 1.0f / (duv1.x * duv2.y - duv1.y * duv2.x);
+
+    float3 tangent = float3(
+        ((edge1.x * duv2.y) - (edge2.x * duv1.y)) * r,
+        ((edge1.y * duv2.y) - (edge2.y * duv1.y)) * r,
+        ((edge1.z * duv2.y) - (edge2.z * duv1.y)) * r);
+
+    float3 bitangent = float3(
+        ((edge1.x * duv2.x) - (edge2.x * duv1.x)) * r,
+        ((edge1.y * duv2.x) - (edge2.y * duv1.x)) * r,
+        ((edge1.z * duv2.x) - (edge2.z * duv1.x)) * r);
+
+    tangent = glm::normalize(tangent - vtx0.normal * glm::dot(vtx0.normal, tangent));
+    float w = 1.0f;
+
+    *pTangent   = float4(-tangent, w);
+    *pBitangent = -bitangent;
+}
+
+} // namespace
+
 Result TriMesh::CreateFromOBJ(const std::filesystem::path& path, const TriMeshOptions& options, TriMesh* pTriMesh)
 {
     if (IsNull(pTriMesh)) {
@@ -927,242 +1124,187 @@ Result TriMesh::CreateFromOBJ(const std::filesystem::path& path, const TriMeshOp
         {1.0f, 1.0f, 1.0f},
     };
 
-    tinyobj::attrib_t                attrib;
-    std::vector<tinyobj::shape_t>    shapes;
-    std::vector<tinyobj::material_t> materials;
-
-    ppx::fs::FileStream objStream;
-    if (!objStream.Open(path.string().c_str())) {
-        return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
-    }
-
-    std::string  warn;
-    std::string  err;
-    std::istream istr(&objStream);
-    bool         loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &istr, nullptr, true);
-    if (!loaded || !err.empty()) {
-        return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
+    // The file is memory-mapped and parsed in parallel.
+    ObjData obj;
+    Result  ppxres = LoadOBJ(path, &obj);
+    if (Failed(ppxres)) {
+        return ppxres;
     }
 
-    size_t numShapes = shapes.size();
-    if (numShapes == 0) {
+    size_t   numShapes      = obj.shapeFirstTriangles.size();
+    uint32_t totalTriangles = obj.GetCountTriangles();
+    if (totalTriangles == 0) {
         return ppx::ERROR_GEOMETRY_FILE_NO_DATA;
     }
 
-    //// Check to see if data can be indexed
-    //bool indexable = true;
-    //for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx) {
-    //    const tinyobj::shape_t& shape     = shapes[shapeIdx];
-    //    const tinyobj::mesh_t&  shapeMesh = shape.mesh;
-    //
-    //    size_t numTriangles = shapeMesh.indices.size() / 3;
-    //    for (size_t triIdx = 0; triIdx < numTriangles; ++triIdx) {
-    //        size_t triVtxIdx0 = triIdx * 3 + 0;
-    //        size_t triVtxIdx1 = triIdx * 3 + 1;
-    //        size_t triVtxIdx2 = triIdx * 3 + 2;
-    //
-    //        // Index data
-    //        const tinyobj::index_t& dataIdx0 = shapeMesh.indices[triVtxIdx0];
-    //        const tinyobj::index_t& dataIdx1 = shapeMesh.indices[triVtxIdx1];
-    //        const tinyobj::index_t& dataIdx2 = shapeMesh.indices[triVtxIdx2];
-    //
-    //        bool sameIdx0 = (dataIdx0.vertex_index == dataIdx0.normal_index) && (dataIdx0.normal_index == dataIdx0.texcoord_index);
-    //        bool sameIdx1 = (dataIdx1.vertex_index == dataIdx1.normal_index) && (dataIdx1.normal_index == dataIdx1.texcoord_index);
-    //        bool sameIdx2 = (dataIdx2.vertex_index == dataIdx2.normal_index) && (dataIdx2.normal_index == dataIdx2.texcoord_index);
-    //        bool same     = sameIdx0 && sameIdx1 && sameIdx2;
-    //        if (!same) {
-    //           indexable = false;
-    //           break;
-    //        }
-    //    }
-    //}
-
-    // Preallocate based on the total number of triangles.
-    size_t totalTriangles = 0;
-    for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx) {
-        totalTriangles += shapes[shapeIdx].mesh.indices.size() / 3;
-    }
-    pTriMesh->PreallocateForTriangleCount(totalTriangles,
-                                          /* enableColors= */ (options.mEnableVertexColors || options.mEnableObjectColor),
-                                          options.mEnableNormals,
-                                          options.mEnableTexCoords,
-                                          options.mEnableTangents);
-
-    // Build geometry
-    for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx) {
-        const tinyobj::shape_t& shape     = shapes[shapeIdx];
-        const tinyobj::mesh_t&  shapeMesh = shape.mesh;
-
-        size_t numTriangles = shapeMesh.indices.size() / 3;
-        for (size_t triIdx = 0; triIdx < numTriangles; ++triIdx) {
-            size_t triVtxIdx0 = triIdx * 3 + 0;
-            size_t triVtxIdx1 = triIdx * 3 + 1;
-            size_t triVtxIdx2 = triIdx * 3 + 2;
-
-            // Index data
-            const tinyobj::index_t& dataIdx0 = shapeMesh.indices[triVtxIdx0];
-            const tinyobj::index_t& dataIdx1 = shapeMesh.indices[triVtxIdx1];
-            const tinyobj::index_t& dataIdx2 = shapeMesh.indices[triVtxIdx2];
-
-            // Vertex data
-            TriMeshVertexData vtx0 = {};
-            TriMeshVertexData vtx1 = {};
-            TriMeshVertexData vtx2 = {};
-
-            // Pick a face color
-            float3 faceColor = colors[triIdx % colors.size()];
-            vtx0.color       = faceColor;
-            vtx1.color       = faceColor;
-            vtx2.color       = faceColor;
-
-            // Vertex positions
-            {
-                int i0        = 3 * dataIdx0.vertex_index + 0;
-                int i1        = 3 * dataIdx0.vertex_index + 1;
-                int i2        = 3 * dataIdx0.vertex_index + 2;
-                vtx0.position = float3(attrib.vertices[i0], attrib.vertices[i1], attrib.vertices[i2]);
-
-                i0            = 3 * dataIdx1.vertex_index + 0;
-                i1            = 3 * dataIdx1.vertex_index + 1;
-                i2            = 3 * dataIdx1.vertex_index + 2;
-                vtx1.position = float3(attrib.vertices[i0], attrib.vertices[i1], attrib.vertices[i2]);
-
-                i0            = 3 * dataIdx2.vertex_index + 0;
-                i1            = 3 * dataIdx2.vertex_index + 1;
-                i2            = 3 * dataIdx2.vertex_index + 2;
-                vtx2.position = float3(attrib.vertices[i0], attrib.vertices[i1], attrib.vertices[i2]);
-            }
+    bool enableColors = options.mEnableVertexColors || options.mEnableObjectColor;
 
-            // Normals
-            if ((dataIdx0.normal_index != -1) && (dataIdx1.normal_index != -1) && (dataIdx2.normal_index != -1)) {
-                int i0      = 3 * dataIdx0.normal_index + 0;
-                int i1      = 3 * dataIdx0.normal_index + 1;
-                int i2      = 3 * dataIdx0.normal_index + 2;
-                vtx0.normal = float3(attrib.normals[i0], attrib.normals[i1], attrib.normals[i2]);
-
-                i0          = 3 * dataIdx1.normal_index + 0;
-                i1          = 3 * dataIdx1.normal_index + 1;
-                i2          = 3 * dataIdx1.normal_index + 2;
-                vtx1.normal = float3(attrib.normals[i0], attrib.normals[i1], attrib.normals[i2]);
-
-                i0          = 3 * dataIdx2.normal_index + 0;
-                i1          = 3 * dataIdx2.normal_index + 1;
-                i2          = 3 * dataIdx2.normal_index + 2;
-                vtx2.normal = float3(attrib.normals[i0], attrib.normals[i1], attrib.normals[i2]);
-            }
+    // Returns the attribute indices of a face corner. Normals and texture
+    // coordinates are only used if all the corners of the triangle have them.
+    auto getCorner = [&obj](uint32_t triIdx, uint32_t vtxIdx) -> ObjIndex {
+        const ObjIndex* pTriangle = &obj.indices[3 * static_cast<size_t>(triIdx)];
+        ObjIndex        corner    = pTriangle[vtxIdx];
+        if ((pTriangle[0].normal == -1) || (pTriangle[1].normal == -1) || (pTriangle[2].normal == -1)) {
+            corner.normal = -1;
+        }
+        if ((pTriangle[0].texCoord == -1) || (pTriangle[1].texCoord == -1) || (pTriangle[2].texCoord == -1)) {
+            corner.texCoord = -1;
+        }
+        return corner;
+    };
 
-            // Texture coordinates
-            if ((dataIdx0.texcoord_index != -1) && (dataIdx1.texcoord_index != -1) && (dataIdx2.texcoord_index != -1)) {
-                int i0        = 2 * dataIdx0.texcoord_index + 0;
-                int i1        = 2 * dataIdx0.texcoord_index + 1;
-                vtx0.texCoord = float2(attrib.texcoords[i0], attrib.texcoords[i1]);
-
-                i0            = 2 * dataIdx1.texcoord_index + 0;
-                i1            = 2 * dataIdx1.texcoord_index + 1;
-                vtx1.texCoord = float2(attrib.texcoords[i0], attrib.texcoords[i1]);
-
-                i0            = 2 * dataIdx2.texcoord_index + 0;
-                i1            = 2 * dataIdx2.texcoord_index + 1;
-                vtx2.texCoord = float2(attrib.texcoords[i0], attrib.texcoords[i1]);
-
-                // Scale tex coords
-                vtx0.texCoord *= options.mTexCoordScale;
-                vtx1.texCoord *= options.mTexCoordScale;
-                vtx2.texCoord *= options.mTexCoordScale;
-
-                if (options.mInvertTexCoordsV) {
-                    vtx0.texCoord.y = 1.0f - vtx0.texCoord.y;
-                    vtx1.texCoord.y = 1.0f - vtx1.texCoord.y;
-                    vtx2.texCoord.y = 1.0f - vtx2.texCoord.y;
-                }
+    // Returns the vertex data of a face corner. The position is not scaled
+    // or translated yet, since tangents are computed from the original one.
+    auto getVertexData = [&obj, &options](const ObjIndex& corner, TriMeshVertexData* pVertexData) {
+        pVertexData->position = obj.positions[corner.position];
+        if (corner.normal != -1) {
+            pVertexData->normal = obj.normals[corner.normal];
+        }
+        if (corner.texCoord != -1) {
+            pVertexData->texCoord = obj.texCoords[corner.texCoord] * options.mTexCoordScale;
+            if (options.mInvertTexCoordsV) {
+                pVertexData->texCoord.y = 1.0f - pVertexData->texCoord.y;
             }
+        }
+    };
 
-            float3 pos0 = (vtx0.position * options.mScale) + options.mTranslate;
-            float3 pos1 = (vtx1.position * options.mScale) + options.mTranslate;
-            float3 pos2 = (vtx2.position * options.mScale) + options.mTranslate;
-
-            uint32_t triVtx0 = pTriMesh->AppendPosition(pos0) - 1;
-            uint32_t triVtx1 = pTriMesh->AppendPosition(pos1) - 1;
-            uint32_t triVtx2 = pTriMesh->AppendPosition(pos2) - 1;
+    // Face colors cycle through the palette within each shape, unless the
+    // object color overrides them.
+    auto getFaceColor = [&obj, &options, &colors](uint32_t triIdx) -> float3 {
+        if (options.mEnableObjectColor) {
+            return options.mObjectColor;
+        }
+        auto     it          = std::upper_bound(obj.shapeFirstTriangles.begin(), obj.shapeFirstTriangles.end(), triIdx);
+        uint32_t shapeTriIdx = triIdx - *(it - 1);
+        return colors[shapeTriIdx % colors.size()];
+    };
 
-            if (options.mEnableVertexColors || options.mEnableObjectColor) {
-                if (options.mEnableObjectColor) {
-                    vtx0.color = options.mObjectColor;
-                    vtx1.color = options.mObjectColor;
-                    vtx2.color = options.mObjectColor;
+    // Vertices can be shared between triangles if they are indexed and have
+    // no per triangle attributes (face colors or tangents).
+    bool shareVertices = (indexType != grfx::INDEX_TYPE_UNDEFINED) &&
+                         !options.mEnableTangents &&
+                         !(options.mEnableVertexColors && !options.mEnableObjectColor);
+
+    // Deduplicate the face corners into vertices, and write the indices.
+    std::vector<ObjIndex> sharedVertices;
+    if (shareVertices) {
+        ObjVertexTable table(obj.positions.size());
+        pTriMesh->mIndices.resize(3 * static_cast<size_t>(totalTriangles) * sizeof(uint32_t));
+        uint32_t* pIndices = reinterpret_cast<uint32_t*>(pTriMesh->mIndices.data());
+        for (uint32_t triIdx = 0; triIdx < totalTriangles; ++triIdx) {
+            uint32_t triVtx[3] = {};
+            for (uint32_t vtxIdx = 0; vtxIdx < 3; ++vtxIdx) {
+                ObjIndex corner = getCorner(triIdx, vtxIdx);
+                if (!options.mEnableNormals) {
+                    corner.normal = -1;
+                }
+                if (!options.mEnableTexCoords) {
+                    corner.texCoord = -1;
                 }
-                pTriMesh->AppendColor(vtx0.color);
-                pTriMesh->AppendColor(vtx1.color);
-                pTriMesh->AppendColor(vtx2.color);
+                triVtx[vtxIdx] = table.Insert(corner);
             }
+            pIndices[3 * triIdx + 0] = triVtx[0];
+            pIndices[3 * triIdx + 1] = options.mInvertWinding ? triVtx[2] : triVtx[1];
+            pIndices[3 * triIdx + 2] = options.mInvertWinding ? triVtx[1] : triVtx[2];
+        }
+        sharedVertices = table.GetVertices();
+    }
 
-            if (options.mEnableNormals) {
-                pTriMesh->AppendNormal(vtx0.normal);
-                pTriMesh->AppendNormal(vtx1.normal);
-                pTriMesh->AppendNormal(vtx2.normal);
+    // Write the vertex data directly into the mesh storage, in parallel.
+    size_t vertexCount = shareVertices ? sharedVertices.size() : 3 * static_cast<size_t>(totalTriangles);
+    pTriMesh->mPositions.resize(vertexCount);
+    if (enableColors) {
+        pTriMesh->mColors.resize(vertexCount);
+    }
+    if (options.mEnableNormals) {
+        pTriMesh->mNormals.resize(vertexCount);
+    }
+    if (options.mEnableTexCoords) {
+        pTriMesh->mTexCoords.resize(2 * vertexCount);
+    }
+    if (options.mEnableTangents) {
+        pTriMesh->mTangents.resize(vertexCount);
+        pTriMesh->mBitangents.resize(vertexCount);
+    }
+    if (!shareVertices && (indexType != grfx::INDEX_TYPE_UNDEFINED)) {
+        pTriMesh->mIndices.resize(vertexCount * sizeof(uint32_t));
+    }
+
+    auto writeVertex = [pTriMesh, &options](size_t index, const TriMeshVertexData& vtx, float3* pMin, float3* pMax) {
+        float3 position                = (vtx.position * options.mScale) + options.mTranslate;
+        pTriMesh->mPositions[index]    = position;
+        *pMin                          = glm::min(*pMin, position);
+        *pMax                          = glm::max(*pMax, position);
+        if (!pTriMesh->mColors.empty()) {
+            pTriMesh->mColors[index] = vtx.color;
+        }
+        if (!pTriMesh->mNormals.empty()) {
+            pTriMesh->mNormals[index] = vtx.normal;
+        }
+        if (!pTriMesh->mTexCoords.empty()) {
+            pTriMesh->mTexCoords[2 * index + 0] = vtx.texCoord.x;
+            pTriMesh->mTexCoords[2 * index + 1] = vtx.texCoord.y;
+        }
+    };
+
+    size_t              workCount   = shareVertices ? vertexCount : totalTriangles;
+    uint32_t            threadCount = GetParallelThreadCount(workCount, kMinObjTrianglesPerThread);
+    std::vector<float3> boundsMin(threadCount, obj.positions[obj.indices[0].position] * options.mScale + options.mTranslate);
+    std::vector<float3> boundsMax(boundsMin);
+    ParallelForRanges(workCount, threadCount, [&](uint32_t rangeIdx, size_t begin, size_t end) {
+        float3* pMin = &boundsMin[rangeIdx];
+        float3* pMax = &boundsMax[rangeIdx];
+        if (shareVertices) {
+            for (size_t vtxIdx = begin; vtxIdx < end; ++vtxIdx) {
+                TriMeshVertexData vtx = {};
+                vtx.color             = options.mObjectColor;
+                getVertexData(sharedVertices[vtxIdx], &vtx);
+                writeVertex(vtxIdx, vtx, pMin, pMax);
             }
+            return;
+        }
 
-            if (options.mEnableTexCoords) {
-                pTriMesh->AppendTexCoord(vtx0.texCoord);
-                pTriMesh->AppendTexCoord(vtx1.texCoord);
-                pTriMesh->AppendTexCoord(vtx2.texCoord);
+        uint32_t* pIndices = reinterpret_cast<uint32_t*>(pTriMesh->mIndices.data());
+        for (uint32_t triIdx = static_cast<uint32_t>(begin); triIdx < end; ++triIdx) {
+            float3            faceColor = enableColors ? getFaceColor(triIdx) : float3(0.0f);
+            TriMeshVertexData vtx[3]    = {};
+            for (uint32_t i = 0; i < 3; ++i) {
+                vtx[i].color = faceColor;
+                getVertexData(getCorner(triIdx, i), &vtx[i]);
+                writeVertex(3 * static_cast<size_t>(triIdx) + i, vtx[i], pMin, pMax);
             }
 
             if (options.mEnableTangents) {
-                float3 edge1 = vtx1.position - vtx0.position;
-                float3 edge2 = vtx2.position - vtx0.position;
-                float2 duv1  = vtx1.texCoord - vtx0.texCoord;
-                float2 duv2  = vtx2.texCoord - vtx0.texCoord;
-                float  r     = 1.0f / (duv1.x * duv2.y - duv1.y * duv2.x);
-
-                float3 tangent = float3(
-                    ((edge1.x * duv2.y) - (edge2.x * duv1.y)) * r,
-                    ((edge1.y * duv2.y) - (edge2.y * duv1.y)) * r,
-                    ((edge1.z * duv2.y) - (edge2.z * duv1.y)) * r);
-
-                float3 bitangent = float3(
-                    ((edge1.x * duv2.x) - (edge2.x * duv1.x)) * r,
-                    ((edge1.y * duv2.x) - (edge2.y * duv1.x)) * r,
-                    ((edge1.z * duv2.x) - (edge2.z * duv1.x)) * r);
-
-                tangent = glm::normalize(tangent - vtx0.normal * glm::dot(vtx0.normal, tangent));
-                float w = 1.0f;
-
-                pTriMesh->AppendTangent(float4(-tangent, w));
-                pTriMesh->AppendTangent(float4(-tangent, w));
-                pTriMesh->AppendTangent(float4(-tangent, w));
-                pTriMesh->AppendBitangent(-bitangent);
-                pTriMesh->AppendBitangent(-bitangent);
-                pTriMesh->AppendBitangent(-bitangent);
+                float4 tangent;
+                float3 bitangent;
+                ComputeObjTangent(vtx[0], vtx[1], vtx[2], &tangent, &bitangent);
+                for (uint32_t i = 0; i < 3; ++i) {
+                    pTriMesh->mTangents[3 * static_cast<size_t>(triIdx) + i]   = tangent;
+                    pTriMesh->mBitangents[3 * static_cast<size_t>(triIdx) + i] = bitangent;
+                }
             }
 
             if (indexType != grfx::INDEX_TYPE_UNDEFINED) {
-                if (options.mInvertWinding) {
-                    pTriMesh->AppendTriangle(triVtx0, triVtx2, triVtx1);
-                }
-                else {
-                    pTriMesh->AppendTriangle(triVtx0, triVtx1, triVtx2);
-                }
+                uint32_t triVtx0      = 3 * triIdx;
+                pIndices[triVtx0 + 0] = triVtx0;
+                pIndices[triVtx0 + 1] = triVtx0 + (options.mInvertWinding ? 2 : 1);
+                pIndices[triVtx0 + 2] = triVtx0 + (options.mInvertWinding ? 1 : 2);
             }
         }
-    }
+    });
 
-    //if (options.mEnableTangents) {
-    //    size_t numPositions  = mesh.mPositions.size();
-    //    size_t numNormals    = mesh.mNormals.size();
-    //    size_t numTangents   = mesh.mTangents.size();
-    //    size_t numBitangents = mesh.mBitangents.size();
-    //    PPX_ASSERT_MSG(numPositions == numNormals == numTangents == numBitangents, "misaligned data for tangent calculation");
-    //
-    //    for (size_t i = 0; i < numPositions; ++i) {
-    //        const float3& T = mesh.mTangents[i];
-    //        const float3& B = mesh.mBitangents[i];
-    //    }
-    //}
+    pTriMesh->mBoundingBoxMin = boundsMin[0];
+    pTriMesh->mBoundingBoxMax = boundsMax[0];
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        pTriMesh->mBoundingBoxMin = glm::min(pTriMesh->mBoundingBoxMin, boundsMin[i]);
+        pTriMesh->mBoundingBoxMax = glm::max(pTriMesh->mBoundingBoxMax, boundsMax[i]);
+    }
 
     double fnEndTime = timer.SecondsSinceStart();
     float  fnElapsed = static_cast<float>(fnEndTime - fnStartTime);
-    PPX_LOG_INFO("Created mesh from OBJ file: " << path << " (" << FloatString(fnElapsed) << " seconds, " << numShapes << " shapes, " << totalTriangles << " triangles)");
+    PPX_LOG_INFO("Created mesh from OBJ file: " << path << " (" << FloatString(fnElapsed) << " seconds, " << numShapes << " shapes, " << totalTriangles << " triangles, " << vertexCount << " vertices)");
+
+    pTriMesh->ApplyOptimizations(options);
 
     return ppx::SUCCESS;
 }
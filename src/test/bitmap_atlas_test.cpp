@@ -0,0 +1,283 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/bitmap_atlas.h"
+
+#include <vector>
+
+namespace ppx {
+namespace {
+
+bool Overlaps(const AtlasRect& a, const AtlasRect& b)
+{
+    return (a.x < b.x + b.width) && (b.x < a.x + a.width) &&
+           (a.y < b.y + b.height) && (b.y < a.y + a.height);
+}
+
+void PackRandomRects(AtlasPackMethod method, std::vector<AtlasRect>* pRects)
+{
+    AtlasPacker packer(256, 256, method);
+    uint32_t    state = 7;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        state          = state * 1664525u + 1013904223u;
+        uint32_t  w    = 4 + ((state >> 8) % 29);
+        uint32_t  h    = 4 + ((state >> 20) % 29);
+        AtlasRect rect = {};
+        if (packer.Insert(w, h, &rect)) {
+            EXPECT_EQ(rect.width, w);
+            EXPECT_EQ(rect.height, h);
+            pRects->push_back(rect);
+        }
+    }
+    EXPECT_EQ(packer.GetRectCount(), CountU32(*pRects));
+}
+
+} // namespace
+
+class AtlasPackerTest : public ::testing::TestWithParam<AtlasPackMethod>
+{
+};
+
+TEST_P(AtlasPackerTest, RectsAreInBoundsAndDoNotOverlap)
+{
+    std::vector<AtlasRect> rects;
+    PackRandomRects(GetParam(), &rects);
+    ASSERT_GT(rects.size(), 50u);
+
+    for (size_t i = 0; i < rects.size(); ++i) {
+        EXPECT_LE(rects[i].x + rects[i].width, 256u);
+        EXPECT_LE(rects[i].y + rects[i].height, 256u);
+        for (size_t j = i + 1; j < rects.size(); ++j) {
+            EXPECT_FALSE(Overlaps(rects[i], rects[j])) << "rects " << i << " and " << j;
+        }
+    }
+}
+
+TEST_P(AtlasPackerTest, FillsUpWithEqualSquares)
+{
+    AtlasPacker packer(64, 64, GetParam());
+    AtlasRect   rect = {};
+    for (uint32_t i = 0; i < 16; ++i) {
+        EXPECT_TRUE(packer.Insert(16, 16, &rect)) << "square " << i;
+    }
+    EXPECT_FALSE(packer.Insert(1, 1, &rect));
+    EXPECT_FLOAT_EQ(packer.GetOccupancy(), 1.0f);
+
+    packer.Clear();
+    EXPECT_EQ(packer.GetRectCount(), 0u);
+    EXPECT_TRUE(packer.Insert(64, 64, &rect));
+}
+
+TEST_P(AtlasPackerTest, RejectsEmptyAndOversizedRects)
+{
+    AtlasPacker packer(32, 32, GetParam());
+    AtlasRect   rect = {};
+    EXPECT_FALSE(packer.Insert(0, 4, &rect));
+    EXPECT_FALSE(packer.Insert(33, 4, &rect));
+    EXPECT_FALSE(packer.Insert(4, 33, &rect));
+    EXPECT_EQ(packer.GetRectCount(), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AtlasPackerTest, AtlasPackerTest, ::testing::Values(ATLAS_PACK_METHOD_SKYLINE, ATLAS_PACK_METHOD_MAX_RECTS));
+
+TEST(BitmapAtlasTest, InsertCopiesPixelsAndLeavesGutterZero)
+{
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 64;
+    createInfo.height                = 64;
+    createInfo.padding               = 2;
+    BitmapAtlas atlas;
+    ASSERT_EQ(BitmapAtlas::Create(createInfo, &atlas), SUCCESS);
+
+    Bitmap bitmap = Bitmap::Create(3, 2, Bitmap::FORMAT_RGBA_UINT8);
+    for (uint32_t y = 0; y < 2; ++y) {
+        for (uint32_t x = 0; x < 3; ++x) {
+            uint8_t* pPixel = bitmap.GetPixel8u(x, y);
+            pPixel[0]       = static_cast<uint8_t>(1 + x + 3 * y);
+            pPixel[1]       = 10;
+            pPixel[2]       = 20;
+            pPixel[3]       = 255;
+        }
+    }
+
+    AtlasEntry entry = {};
+    ASSERT_EQ(atlas.Insert(bitmap, &entry), SUCCESS);
+    EXPECT_EQ(entry.rect.x, 2u);
+    EXPECT_EQ(entry.rect.y, 2u);
+    EXPECT_EQ(entry.rect.width, 3u);
+    EXPECT_EQ(entry.rect.height, 2u);
+    EXPECT_FLOAT_EQ(entry.uvRect.u0, 2.0f / 64.0f);
+    EXPECT_FLOAT_EQ(entry.uvRect.v0, 2.0f / 64.0f);
+    EXPECT_FLOAT_EQ(entry.uvRect.u1, 5.0f / 64.0f);
+    EXPECT_FLOAT_EQ(entry.uvRect.v1, 4.0f / 64.0f);
+
+    const Bitmap& atlasBitmap = static_cast<const BitmapAtlas&>(atlas).GetBitmap();
+    for (uint32_t y = 0; y < 2; ++y) {
+        for (uint32_t x = 0; x < 3; ++x) {
+            EXPECT_EQ(atlasBitmap.GetPixel8u(entry.rect.x + x, entry.rect.y + y)[0], 1 + x + 3 * y);
+        }
+    }
+    EXPECT_EQ(atlasBitmap.GetPixel8u(1, 2)[0], 0);
+    EXPECT_EQ(atlasBitmap.GetPixel8u(5, 3)[3], 0);
+    EXPECT_EQ(atlasBitmap.GetPixel8u(2, 4)[3], 0);
+}
+
+TEST(BitmapAtlasTest, InsertExtrudesEdges)
+{
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 16;
+    createInfo.height                = 16;
+    createInfo.format                = Bitmap::FORMAT_R_UINT8;
+    createInfo.padding               = 2;
+    createInfo.extrudeEdges          = true;
+    BitmapAtlas atlas;
+    ASSERT_EQ(BitmapAtlas::Create(createInfo, &atlas), SUCCESS);
+
+    // 2x2 bitmap with values 1 2 / 3 4.
+    Bitmap bitmap            = Bitmap::Create(2, 2, Bitmap::FORMAT_R_UINT8);
+    *bitmap.GetPixel8u(0, 0) = 1;
+    *bitmap.GetPixel8u(1, 0) = 2;
+    *bitmap.GetPixel8u(0, 1) = 3;
+    *bitmap.GetPixel8u(1, 1) = 4;
+
+    AtlasEntry entry = {};
+    ASSERT_EQ(atlas.Insert(bitmap, &entry), SUCCESS);
+
+    // The 6x6 footprint repeats the edge pixels, and the corners.
+    const uint8_t expected[6][6] = {
+        {1, 1, 1, 2, 2, 2},
+        {1, 1, 1, 2, 2, 2},
+        {1, 1, 1, 2, 2, 2},
+        {3, 3, 3, 4, 4, 4},
+        {3, 3, 3, 4, 4, 4},
+        {3, 3, 3, 4, 4, 4},
+    };
+    const uint32_t x0 = entry.rect.x - 2;
+    const uint32_t y0 = entry.rect.y - 2;
+    for (uint32_t y = 0; y < 6; ++y) {
+        for (uint32_t x = 0; x < 6; ++x) {
+            EXPECT_EQ(*atlas.GetBitmap()->GetPixel8u(x0 + x, y0 + y), expected[y][x]) << "x=" << x << " y=" << y;
+        }
+    }
+}
+
+TEST(BitmapAtlasTest, InsertConvertsFormat)
+{
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 16;
+    createInfo.height                = 16;
+    createInfo.format                = Bitmap::FORMAT_R_UINT8;
+    BitmapAtlas atlas;
+    ASSERT_EQ(BitmapAtlas::Create(createInfo, &atlas), SUCCESS);
+
+    Bitmap   bitmap = Bitmap::Create(1, 1, Bitmap::FORMAT_RGBA_UINT8);
+    uint8_t* pPixel = bitmap.GetPixel8u(0, 0);
+    pPixel[0]       = 77;
+    pPixel[1]       = 1;
+    pPixel[2]       = 2;
+    pPixel[3]       = 3;
+
+    AtlasEntry entry = {};
+    ASSERT_EQ(atlas.Insert(bitmap, &entry), SUCCESS);
+    EXPECT_EQ(*atlas.GetBitmap()->GetPixel8u(entry.rect.x, entry.rect.y), 77);
+}
+
+TEST(BitmapAtlasTest, AllocateAlignsFootprints)
+{
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 128;
+    createInfo.height                = 128;
+    createInfo.padding               = 4;
+    createInfo.alignment             = 8;
+    BitmapAtlas atlas;
+    ASSERT_EQ(BitmapAtlas::Create(createInfo, &atlas), SUCCESS);
+
+    for (uint32_t i = 0; i < 10; ++i) {
+        AtlasEntry entry = {};
+        ASSERT_EQ(atlas.Allocate(3 + i, 5 + 2 * i, &entry), SUCCESS);
+        EXPECT_EQ((entry.rect.x - 4) % 8, 0u);
+        EXPECT_EQ((entry.rect.y - 4) % 8, 0u);
+    }
+    EXPECT_EQ(atlas.GetPacker().GetRectCount(), 10u);
+}
+
+TEST(BitmapAtlasTest, AllocateFailsWhenFull)
+{
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 32;
+    createInfo.height                = 32;
+    createInfo.padding               = 1;
+    BitmapAtlas atlas;
+    ASSERT_EQ(BitmapAtlas::Create(createInfo, &atlas), SUCCESS);
+
+    AtlasEntry entry = {};
+    EXPECT_EQ(atlas.Allocate(30, 30, &entry), SUCCESS);
+    EXPECT_EQ(atlas.Allocate(1, 1, &entry), ERROR_LIMIT_EXCEEDED);
+    EXPECT_EQ(atlas.Allocate(31, 31, &entry), ERROR_LIMIT_EXCEEDED);
+
+    atlas.Clear();
+    EXPECT_EQ(atlas.Allocate(1, 1, &entry), SUCCESS);
+}
+
+TEST(BitmapAtlasTest, TakeDirtyRectCoversWrittenEntries)
+{
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 64;
+    createInfo.height                = 64;
+    createInfo.padding               = 1;
+    createInfo.method                = ATLAS_PACK_METHOD_SKYLINE;
+    BitmapAtlas atlas;
+    ASSERT_EQ(BitmapAtlas::Create(createInfo, &atlas), SUCCESS);
+
+    AtlasRect dirtyRect = {};
+    EXPECT_FALSE(atlas.TakeDirtyRect(&dirtyRect));
+
+    AtlasEntry first  = {};
+    AtlasEntry second = {};
+    ASSERT_EQ(atlas.Allocate(6, 6, &first), SUCCESS);
+    ASSERT_EQ(atlas.Allocate(10, 2, &second), SUCCESS);
+    ASSERT_TRUE(atlas.TakeDirtyRect(&dirtyRect));
+    EXPECT_EQ(dirtyRect.x, 0u);
+    EXPECT_EQ(dirtyRect.y, 0u);
+    EXPECT_EQ(dirtyRect.width, 8u + 12u);
+    EXPECT_EQ(dirtyRect.height, 8u);
+    EXPECT_FALSE(atlas.TakeDirtyRect(&dirtyRect));
+
+    AtlasEntry third = {};
+    ASSERT_EQ(atlas.Allocate(4, 4, &third), SUCCESS);
+    ASSERT_TRUE(atlas.TakeDirtyRect(&dirtyRect));
+    EXPECT_EQ(dirtyRect.x, third.rect.x - 1);
+    EXPECT_EQ(dirtyRect.y, third.rect.y - 1);
+    EXPECT_EQ(dirtyRect.width, 6u);
+    EXPECT_EQ(dirtyRect.height, 6u);
+}
+
+TEST(BitmapAtlasTest, CreateRejectsInvalidArguments)
+{
+    BitmapAtlas           atlas;
+    BitmapAtlasCreateInfo createInfo = {};
+    createInfo.width                 = 0;
+    EXPECT_EQ(BitmapAtlas::Create(createInfo, &atlas), ERROR_INVALID_CREATE_ARGUMENT);
+
+    createInfo           = {};
+    createInfo.alignment = 0;
+    EXPECT_EQ(BitmapAtlas::Create(createInfo, &atlas), ERROR_INVALID_CREATE_ARGUMENT);
+
+    createInfo.alignment = 12;
+    EXPECT_EQ(BitmapAtlas::Create(createInfo, &atlas), ERROR_INVALID_CREATE_ARGUMENT);
+}
+
+} // namespace ppx
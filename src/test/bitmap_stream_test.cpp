@@ -0,0 +1,729 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/bitmap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ppx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Test data
+////////////////////////////////////////////////////////////////////////////////
+
+// Small PNGs written with zlib, covering the color types, bit depths, filters,
+// tRNS chunks, and stored, fixed and dynamic deflate blocks.
+const uint8_t kRGB16Transparent[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x05, 0x10, 0x02, 0x00, 0x00, 0x00, 0x4C, 0x54, 0x5D,
+    0x42, 0x00, 0x00, 0x00, 0x06, 0x74, 0x52, 0x4E, 0x53, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0x89,
+    0xE4, 0x4E, 0xE6, 0x00, 0x00, 0x01, 0x2E, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x10, 0x32,
+    0x09, 0xAB, 0x98, 0xB5, 0xE7, 0x8E, 0x98, 0x70, 0x07, 0x03, 0x03, 0x8B, 0xBA, 0xBA, 0x00, 0x03,
+    0x43, 0xAA, 0x8C, 0xD5, 0x0C, 0x06, 0x06, 0x88, 0xF8, 0xAA, 0x69, 0x89, 0x2B, 0x18, 0x18, 0xE4,
+    0x65, 0x4A, 0x0D, 0x18, 0x18, 0xD6, 0x26, 0x75, 0xEC, 0x80, 0x89, 0xCB, 0x9E, 0x5F, 0x7F, 0x82,
+    0x81, 0x21, 0x6A, 0xED, 0xE1, 0x00, 0x06, 0x06, 0xC6, 0x5B, 0xE5, 0x0C, 0x0C, 0xCA, 0x1A, 0xDC,
+    0x7B, 0x40, 0x46, 0x1C, 0x9F, 0x28, 0x02, 0x24, 0xD3, 0x0A, 0xF4, 0x33, 0xCA, 0xA7, 0x70, 0x56,
+    0xFF, 0x58, 0xD1, 0x99, 0xC3, 0xCC, 0x0C, 0x12, 0x77, 0x6C, 0x01, 0x89, 0x6F, 0xFE, 0xF7, 0xD0,
+    0xA3, 0x7C, 0x0A, 0xA3, 0xA9, 0xDB, 0x89, 0xCE, 0x9C, 0x58, 0x03, 0x90, 0x38, 0x67, 0x13, 0x48,
+    0x9C, 0x69, 0x92, 0x3F, 0xC8, 0x08, 0x89, 0xAD, 0x20, 0x12, 0xA2, 0xF9, 0xDF, 0xE7, 0x27, 0x0A,
+    0x6B, 0xA6, 0x3C, 0xE1, 0x05, 0x89, 0xFC, 0xF6, 0x03, 0x91, 0x10, 0xCD, 0x73, 0x7F, 0x19, 0x39,
+    0xAC, 0x99, 0xE2, 0x9B, 0x0D, 0x12, 0x59, 0x7B, 0x12, 0x44, 0xCE, 0x94, 0x9C, 0xAC, 0x51, 0x3E,
+    0x85, 0xF9, 0x5C, 0x2C, 0x03, 0x83, 0x5B, 0xC0, 0xA4, 0x04, 0x5F, 0x13, 0xE7, 0x88, 0x59, 0x9B,
+    0x2E, 0xCE, 0x38, 0xBF, 0x27, 0x2C, 0x82, 0xCB, 0x45, 0x48, 0xC4, 0xE5, 0x34, 0xD7, 0x11, 0x21,
+    0x91, 0xEF, 0x2F, 0xFE, 0x8B, 0x38, 0x47, 0x7C, 0xC8, 0x93, 0xDF, 0x71, 0x7E, 0xCF, 0x65, 0x31,
+    0x90, 0x38, 0xE3, 0x34, 0x90, 0xF8, 0xC3, 0x27, 0x1B, 0xBF, 0x38, 0x47, 0xA4, 0x95, 0xE7, 0xDE,
+    0x38, 0xBF, 0x87, 0x85, 0xAF, 0x24, 0xAC, 0xC2, 0xD0, 0x25, 0xF1, 0xEC, 0x5E, 0x81, 0x4F, 0x4F,
+    0xFA, 0xAC, 0x44, 0x80, 0x66, 0xEF, 0x98, 0xCC, 0x00, 0x04, 0x5F, 0xE7, 0x70, 0x44, 0xF0, 0xC9,
+    0x9C, 0x2D, 0xE6, 0x36, 0xF8, 0xF4, 0xA4, 0x21, 0x98, 0x61, 0x87, 0xB2, 0x86, 0xFF, 0x7E, 0x90,
+    0x78, 0xCA, 0xB6, 0x5D, 0x16, 0x7C, 0x32, 0x4B, 0x5B, 0x22, 0x03, 0x3E, 0x3D, 0x09, 0x5C, 0xC0,
+    0xD0, 0xA1, 0xAC, 0x01, 0x00, 0x40, 0x20, 0x76, 0xB2, 0x12, 0xA8, 0x51, 0xB4, 0x00, 0x00, 0x00,
+    0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+const uint8_t kPalette4[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x06, 0x04, 0x03, 0x00, 0x00, 0x00, 0xEA, 0x02, 0x09,
+    0x8C, 0x00, 0x00, 0x00, 0x30, 0x50, 0x4C, 0x54, 0x45, 0x00, 0x25, 0x4A, 0x6F, 0x94, 0xB9, 0xDE,
+    0x03, 0x28, 0x4D, 0x72, 0x97, 0xBC, 0xE1, 0x06, 0x2B, 0x50, 0x75, 0x9A, 0xBF, 0xE4, 0x09, 0x2E,
+    0x53, 0x78, 0x9D, 0xC2, 0xE7, 0x0C, 0x31, 0x56, 0x7B, 0xA0, 0xC5, 0xEA, 0x0F, 0x34, 0x59, 0x7E,
+    0xA3, 0xC8, 0xED, 0x12, 0x37, 0x5C, 0x81, 0xA6, 0xCB, 0x76, 0x3A, 0xE9, 0xE8, 0x00, 0x00, 0x00,
+    0x03, 0x74, 0x52, 0x4E, 0x53, 0x00, 0x80, 0xFF, 0xEC, 0xF7, 0xB3, 0x18, 0x00, 0x00, 0x00, 0x3B,
+    0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x01, 0x30, 0x00, 0xCF, 0xFF, 0x00, 0x98, 0xE3, 0x6E, 0x2D,
+    0x0F, 0xA0, 0x40, 0x01, 0x1B, 0x0D, 0xA6, 0xD6, 0xB5, 0xB4, 0x83, 0x02, 0x0D, 0x86, 0x4D, 0x98,
+    0x65, 0xDB, 0x40, 0x03, 0x6C, 0x16, 0xAE, 0x5B, 0x5A, 0x92, 0x37, 0x04, 0x62, 0x81, 0x4A, 0xB5,
+    0xEB, 0x93, 0x4D, 0x00, 0xA2, 0x40, 0xD2, 0xA6, 0xA6, 0x96, 0xE0, 0xC9, 0x2F, 0x14, 0x69, 0xF4,
+    0x35, 0x3B, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+const uint8_t kGray2[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0xD4, 0x52,
+    0xB3, 0x00, 0x00, 0x00, 0x02, 0x74, 0x52, 0x4E, 0x53, 0x00, 0x02, 0x98, 0x9D, 0xAC, 0x14, 0x00,
+    0x00, 0x00, 0x18, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x90, 0x96, 0x66, 0x60, 0xCC, 0x61,
+    0xB8, 0xC2, 0xE4, 0xEA, 0xEA, 0xC0, 0x9C, 0xC7, 0x2D, 0x0B, 0x00, 0x15, 0x9D, 0x02, 0xDD, 0xA8,
+    0xCF, 0x13, 0x41, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+const uint8_t kGrayAlpha16[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x10, 0x04, 0x00, 0x00, 0x00, 0x3E, 0xCB, 0x43,
+    0x1B, 0x00, 0x00, 0x00, 0xD4, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x60, 0xB0, 0xD2,
+    0x55, 0xD6, 0xC8, 0xB8, 0xE7, 0x16, 0xB0, 0x2B, 0x2A, 0xB3, 0xA2, 0x4F, 0xA0, 0x67, 0xC1, 0x6D,
+    0x85, 0xF5, 0x27, 0x4A, 0xB6, 0x5D, 0xFA, 0xC0, 0x61, 0xC6, 0xC8, 0xC0, 0xEC, 0x26, 0xA9, 0xAC,
+    0x11, 0xF1, 0x49, 0x59, 0x23, 0xB4, 0x41, 0x59, 0xE3, 0xF6, 0x12, 0x65, 0x8D, 0xA7, 0x72, 0xCA,
+    0x1A, 0xE1, 0xB1, 0xCA, 0x1A, 0xEF, 0x0E, 0x30, 0x31, 0x30, 0x77, 0x79, 0x32, 0x30, 0xDB, 0xF7,
+    0x32, 0x30, 0x97, 0xBE, 0x65, 0x60, 0x7E, 0x0B, 0xC4, 0xAE, 0x71, 0x0C, 0xCC, 0xA1, 0x7F, 0x18,
+    0x98, 0x99, 0x3C, 0x99, 0x19, 0xD8, 0xF6, 0xFC, 0x17, 0x12, 0x2B, 0x72, 0x14, 0x12, 0x53, 0x0D,
+    0x11, 0x12, 0x33, 0xBB, 0x26, 0x24, 0x26, 0x57, 0x20, 0x24, 0xE6, 0xF3, 0x58, 0x48, 0xCC, 0xFA,
+    0x24, 0x0B, 0x03, 0xB3, 0xC5, 0x2B, 0x06, 0xE6, 0xA9, 0x47, 0x18, 0x98, 0x8D, 0xAD, 0x19, 0x98,
+    0x1F, 0x01, 0x4D, 0x52, 0x98, 0xC0, 0xC0, 0xBC, 0xFA, 0x39, 0x03, 0xB3, 0xDC, 0x46, 0x06, 0x06,
+    0xFE, 0xD9, 0x1A, 0xCA, 0xE6, 0xD2, 0x07, 0xDD, 0xE2, 0x6D, 0xCB, 0x32, 0xDB, 0x05, 0x3E, 0xF6,
+    0xAC, 0xAF, 0x09, 0x5F, 0x7F, 0xFD, 0xFB, 0xAD, 0x4B, 0xFF, 0x2B, 0x1E, 0x32, 0x32, 0x08, 0x5D,
+    0x3B, 0xA9, 0xAC, 0xB1, 0xD2, 0x53, 0x59, 0x23, 0xB9, 0x54, 0x59, 0xA3, 0x5B, 0x0F, 0x88, 0x59,
+    0x95, 0x35, 0x24, 0x3B, 0x54, 0x34, 0x1A, 0x18, 0x01, 0x8F, 0xD2, 0x40, 0x71, 0x18, 0xEC, 0xE4,
+    0x8D, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+const uint8_t kRGBA8Stored[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x0A, 0x08, 0x06, 0x00, 0x00, 0x00, 0x8D, 0x32, 0xCF,
+    0xBD, 0x00, 0x00, 0x00, 0x8D, 0x49, 0x44, 0x41, 0x54, 0x78, 0x01, 0x01, 0x9A, 0x01, 0x65, 0xFE,
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0x19, 0x00, 0x00, 0xFE, 0x32, 0x00, 0x00, 0xFD, 0x4B, 0x00, 0x00,
+    0xFC, 0x64, 0x00, 0x00, 0xFB, 0x7D, 0x00, 0x00, 0xFA, 0x96, 0x00, 0x00, 0xF9, 0xAF, 0x00, 0x00,
+    0xF8, 0xC8, 0x00, 0x00, 0xF7, 0xE1, 0x00, 0x00, 0xF6, 0x01, 0x00, 0x19, 0x00, 0xFF, 0x19, 0x00,
+    0x01, 0xFF, 0x19, 0x00, 0x01, 0xFF, 0x19, 0x00, 0x01, 0xFF, 0x19, 0x00, 0x01, 0xFF, 0x19, 0x00,
+    0x01, 0xFF, 0x19, 0x00, 0x01, 0xFF, 0x19, 0x00, 0x01, 0xFF, 0x19, 0x00, 0x01, 0xFF, 0x19, 0x00,
+    0x01, 0xFF, 0x02, 0x00, 0x19, 0x00, 0x00, 0x00, 0x19, 0x01, 0x00, 0x00, 0x19, 0x02, 0x00, 0x00,
+    0x19, 0x03, 0x00, 0x00, 0x19, 0x04, 0x00, 0x00, 0x19, 0x05, 0x00, 0x00, 0x19, 0x06, 0x00, 0x00,
+    0x19, 0x07, 0x00, 0x00, 0x19, 0x08, 0x00, 0x00, 0x19, 0x09, 0x00, 0x03, 0x00, 0x32, 0x00, 0x80,
+    0x0D, 0x0D, 0x02, 0x00, 0x0D, 0x0D, 0x48, 0x77, 0xE1, 0x41, 0x00, 0x00, 0x00, 0x8D, 0x49, 0x44,
+    0x41, 0x54, 0x03, 0x00, 0x0D, 0x0D, 0x03, 0x00, 0x0D, 0x0D, 0x04, 0x00, 0x0D, 0x0D, 0x04, 0x00,
+    0x0D, 0x0D, 0x05, 0x00, 0x0D, 0x0D, 0x05, 0x00, 0x0D, 0x0D, 0x06, 0x00, 0x0D, 0x0D, 0x06, 0x00,
+    0x04, 0x00, 0x19, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04,
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x7D, 0x00, 0xFF, 0x19, 0x7D,
+    0x05, 0xFE, 0x32, 0x7D, 0x0A, 0xFD, 0x4B, 0x7D, 0x0F, 0xFC, 0x64, 0x7D, 0x14, 0xFB, 0x7D, 0x7D,
+    0x19, 0xFA, 0x96, 0x7D, 0x1E, 0xF9, 0xAF, 0x7D, 0x23, 0xF8, 0xC8, 0x7D, 0x28, 0xF7, 0xE1, 0x7D,
+    0x2D, 0xF6, 0x01, 0x00, 0x96, 0x00, 0xFF, 0x19, 0x00, 0x06, 0xFF, 0x19, 0x00, 0x06, 0xFF, 0x19,
+    0x00, 0x06, 0xFF, 0x19, 0x00, 0x06, 0xFF, 0x19, 0x00, 0x06, 0xFF, 0x19, 0x00, 0x06, 0xFF, 0x19,
+    0x8C, 0x51, 0x7D, 0x00, 0x00, 0x00, 0x8B, 0x49, 0x44, 0x41, 0x54, 0x19, 0x00, 0x06, 0xFF, 0x19,
+    0x00, 0x06, 0xFF, 0x19, 0x00, 0x06, 0xFF, 0x02, 0x00, 0x19, 0x00, 0x00, 0x00, 0x19, 0x01, 0x00,
+    0x00, 0x19, 0x02, 0x00, 0x00, 0x19, 0x03, 0x00, 0x00, 0x19, 0x04, 0x00, 0x00, 0x19, 0x05, 0x00,
+    0x00, 0x19, 0x06, 0x00, 0x00, 0x19, 0x07, 0x00, 0x00, 0x19, 0x08, 0x00, 0x00, 0x19, 0x09, 0x00,
+    0x03, 0x00, 0x71, 0x00, 0x80, 0x0D, 0x0D, 0x05, 0x00, 0x0D, 0x0D, 0x05, 0x00, 0x0D, 0x0D, 0x06,
+    0x00, 0x0D, 0x0D, 0x06, 0x00, 0x0D, 0x0D, 0x07, 0x00, 0x0D, 0x0D, 0x07, 0x00, 0x0D, 0x0D, 0x08,
+    0x00, 0x0D, 0x0D, 0x08, 0x00, 0x0D, 0x0D, 0x09, 0x00, 0x04, 0x00, 0x19, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x05, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x92, 0x86, 0x3F, 0x75, 0x81, 0x15, 0xD3, 0x29, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45,
+    0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+const uint8_t kGray1[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x5D, 0x08, 0xD9,
+    0xC7, 0x00, 0x00, 0x00, 0x14, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x08, 0x0D, 0x65, 0x60,
+    0x5C, 0xC5, 0x70, 0x8D, 0x69, 0xF5, 0xEA, 0x06, 0x00, 0x13, 0xC0, 0x04, 0x04, 0x67, 0x33, 0x91,
+    0x47, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+const uint8_t kRGB8[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x0C, 0x08, 0x02, 0x00, 0x00, 0x00, 0xED, 0x6E, 0x0A,
+    0xAC, 0x00, 0x00, 0x01, 0x1F, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x35, 0x92, 0x4D, 0x68, 0x13,
+    0x41, 0x14, 0xC7, 0x67, 0xB2, 0x2F, 0x6F, 0x4A, 0x2B, 0x65, 0x54, 0xA2, 0x39, 0x44, 0x5D, 0xBA,
+    0x8A, 0xB5, 0xA0, 0x4E, 0x40, 0x6B, 0x50, 0x21, 0x6B, 0x0F, 0x51, 0xC4, 0xE8, 0xA2, 0x85, 0x6A,
+    0x23, 0xBA, 0x14, 0x95, 0xD6, 0x0F, 0x58, 0x7B, 0x30, 0x45, 0x14, 0xF7, 0x12, 0xE8, 0x71, 0xA0,
+    0x78, 0x14, 0x53, 0x4F, 0xA1, 0x97, 0xCC, 0x49, 0x3C, 0x58, 0x3A, 0x78, 0x2D, 0x85, 0x45, 0xBC,
+    0x14, 0x84, 0x2E, 0x15, 0x09, 0xBD, 0xCD, 0x25, 0xE8, 0xA1, 0x54, 0xEB, 0x48, 0xE0, 0xF1, 0x78,
+    0x5F, 0x33, 0xFF, 0xC7, 0x6F, 0x86, 0x10, 0x92, 0x32, 0xE4, 0x85, 0x3D, 0x61, 0x79, 0x9F, 0x8E,
+    0xF2, 0x51, 0xFB, 0xB0, 0xDC, 0x3E, 0x2A, 0x27, 0x46, 0xB4, 0x16, 0xE9, 0xB9, 0x51, 0xF2, 0xF9,
+    0x62, 0x78, 0x63, 0xCC, 0x98, 0x2B, 0xC9, 0xFB, 0xEB, 0xE4, 0xEE, 0x78, 0xF3, 0xF8, 0xA4, 0x20,
+    0x21, 0xE9, 0x3C, 0x0A, 0xBF, 0x3F, 0x25, 0x1B, 0xB3, 0x2E, 0x65, 0x34, 0x60, 0x18, 0xE7, 0x50,
+    0x7A, 0x28, 0x8A, 0x98, 0x94, 0x31, 0xA9, 0xA2, 0xA8, 0x61, 0x3A, 0x83, 0xBA, 0x8E, 0x6E, 0x03,
+    0xD5, 0x02, 0xF2, 0x45, 0xE4, 0x6D, 0x8C, 0x97, 0x91, 0xAC, 0x62, 0xB2, 0x8E, 0xAA, 0x83, 0x69,
+    0x17, 0x5D, 0x07, 0x45, 0x86, 0xD1, 0xF0, 0xDF, 0x79, 0xAA, 0x19, 0x55, 0x8C, 0x36, 0x19, 0x4D,
+    0x6C, 0xC5, 0xB5, 0xB1, 0x6B, 0xEB, 0x81, 0x35, 0xD7, 0xB6, 0x7C, 0xEB, 0x8D, 0x1D, 0x36, 0xCE,
+    0x60, 0x66, 0x9A, 0x81, 0x18, 0x04, 0x9E, 0x83, 0x52, 0x01, 0x3E, 0x79, 0xA0, 0x97, 0x40, 0x15,
+    0x61, 0xBA, 0x04, 0xAD, 0x15, 0xD0, 0x15, 0x20, 0x6B, 0x10, 0x8C, 0x43, 0xBE, 0x06, 0xAD, 0x4D,
+    0x68, 0x6D, 0x41, 0x6A, 0x60, 0xBE, 0x0E, 0xF3, 0x3B, 0x20, 0xB3, 0x90, 0x07, 0x46, 0x23, 0x46,
+    0x53, 0x46, 0x09, 0xA3, 0xC2, 0x5E, 0x2C, 0x7B, 0xA9, 0xB2, 0x82, 0xFF, 0xD3, 0xA6, 0xF5, 0xBE,
+    0xD5, 0xDF, 0x95, 0x75, 0xBB, 0x54, 0x3A, 0xD4, 0xFD, 0x5F, 0xE8, 0x9D, 0x00, 0x00, 0x01, 0x1E,
+    0x49, 0x44, 0x41, 0x54, 0x10, 0x2F, 0x9B, 0x8C, 0x0C, 0x04, 0xE5, 0xBD, 0x7A, 0xEA, 0x20, 0x59,
+    0x38, 0x14, 0x7E, 0xF5, 0x82, 0x23, 0x27, 0xD4, 0xCB, 0xD3, 0xE9, 0x8F, 0xB3, 0xD1, 0xE4, 0x05,
+    0xB3, 0x71, 0x89, 0xCF, 0x5E, 0x56, 0xFB, 0xAB, 0xC9, 0x97, 0x5B, 0xE6, 0xCD, 0x1D, 0x79, 0xF5,
+    0x7E, 0xE0, 0x3D, 0x14, 0xFD, 0x4F, 0xF8, 0x9F, 0xE7, 0x3C, 0x53, 0x0F, 0xE9, 0x08, 0x86, 0x0C,
+    0x9B, 0x39, 0x14, 0x1E, 0x46, 0x45, 0x8C, 0xCB, 0x18, 0x59, 0x60, 0x62, 0x06, 0xFD, 0x3A, 0x06,
+    0x0D, 0x24, 0x0B, 0x18, 0x2D, 0x62, 0xD8, 0x46, 0x7F, 0x19, 0xE5, 0x2A, 0x06, 0xEB, 0xA8, 0x3B,
+    0xE8, 0x77, 0x91, 0x38, 0xA8, 0x33, 0x76, 0x19, 0x63, 0xF7, 0xF4, 0x7B, 0x16, 0x5A, 0x33, 0x76,
+    0xED, 0xA8, 0xE7, 0xB9, 0x0D, 0x48, 0x8F, 0xEB, 0x6E, 0x37, 0x72, 0xDC, 0x2C, 0x61, 0xE0, 0x0F,
+    0xC2, 0xEF, 0x1C, 0x24, 0x05, 0x08, 0x3C, 0xE8, 0x5B, 0x82, 0xBE, 0x22, 0xCC, 0x95, 0x20, 0x5E,
+    0x81, 0xE1, 0x0A, 0xC4, 0x6B, 0xE0, 0x7F, 0x03, 0x51, 0x83, 0xD2, 0x26, 0xA8, 0x2D, 0x68, 0x19,
+    0x98, 0xFB, 0x05, 0x62, 0x07, 0xF2, 0x59, 0xD0, 0x60, 0xD1, 0xAB, 0xDE, 0x83, 0x49, 0x8B, 0x2D,
+    0xB6, 0xA9, 0xB4, 0x3A, 0x89, 0xD5, 0x4C, 0x7B, 0xC0, 0x88, 0x1D, 0x4B, 0xB6, 0x69, 0xEA, 0x50,
+    0x45, 0x2A, 0xFD, 0x69, 0x95, 0xAB, 0xA9, 0x03, 0xA4, 0x51, 0x48, 0x3E, 0x0E, 0xF1, 0xEE, 0xB0,
+    0x19, 0x3B, 0x15, 0xBF, 0x3B, 0xE3, 0xE3, 0x79, 0xF9, 0xDA, 0x97, 0x99, 0x8A, 0x78, 0x7B, 0x2D,
+    0x1A, 0xBD, 0xC9, 0x7F, 0xDE, 0x0E, 0x3E, 0xDC, 0xD3, 0xCF, 0x1E, 0xB8, 0x95, 0xC7, 0xE1, 0xC9,
+    0x28, 0x1D, 0x7A, 0x41, 0x8E, 0xBD, 0xE2, 0xB4, 0x3A, 0xB0, 0xFB, 0xC3, 0x74, 0x0E, 0x9B, 0x1E,
+    0xFA, 0x16, 0x98, 0xA8, 0xA2, 0xA9, 0x21, 0x9F, 0x41, 0x5E, 0x47, 0xD9, 0x40, 0x6E, 0x81, 0x99,
+    0x36, 0xBA, 0xCB, 0x68, 0x2C, 0x30, 0xD1, 0x41, 0xD5, 0x45, 0xE5, 0x60, 0xF2, 0x17, 0x17, 0x2A,
+    0xC7, 0x8F, 0xE3, 0xC6, 0xA4, 0x5E, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42,
+    0x60, 0x82,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////
+
+// Copies the bands into a bitmap and checks that they arrive in order.
+class CollectingSink : public BitmapSink
+{
+public:
+    Result Begin(uint32_t width, uint32_t height, Bitmap::Format format) override
+    {
+        ++mBeginCount;
+        return Bitmap::Create(width, height, format, &mBitmap);
+    }
+
+    Result WriteBand(uint32_t firstRow, const Bitmap& band) override
+    {
+        EXPECT_EQ(firstRow, mNextRow);
+        EXPECT_EQ(band.GetWidth(), mBitmap.GetWidth());
+        EXPECT_EQ(band.GetFormat(), mBitmap.GetFormat());
+        EXPECT_LE(firstRow + band.GetHeight(), mBitmap.GetHeight());
+        if ((firstRow + band.GetHeight()) > mBitmap.GetHeight()) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        const uint32_t rowSize = band.GetWidth() * band.GetPixelStride();
+        for (uint32_t y = 0; y < band.GetHeight(); ++y) {
+            std::memcpy(mBitmap.GetPixelAddress(0, firstRow + y), band.GetPixelAddress(0, y), rowSize);
+        }
+        mBandHeights.push_back(band.GetHeight());
+        mNextRow += band.GetHeight();
+        return SUCCESS;
+    }
+
+    Bitmap                mBitmap;
+    uint32_t              mBeginCount = 0;
+    uint32_t              mNextRow    = 0;
+    std::vector<uint32_t> mBandHeights;
+};
+
+void ExpectSameBitmaps(const Bitmap& expected, const Bitmap& actual)
+{
+    ASSERT_EQ(actual.GetWidth(), expected.GetWidth());
+    ASSERT_EQ(actual.GetHeight(), expected.GetHeight());
+    ASSERT_EQ(actual.GetFormat(), expected.GetFormat());
+    const uint32_t rowSize = expected.GetWidth() * expected.GetPixelStride();
+    for (uint32_t y = 0; y < expected.GetHeight(); ++y) {
+        EXPECT_EQ(std::memcmp(actual.GetPixelAddress(0, y), expected.GetPixelAddress(0, y), rowSize), 0) << "row " << y;
+    }
+}
+
+void ExpectStreamMatchesLoad(const void* pData, size_t size, uint32_t bandHeight)
+{
+    Bitmap expected;
+    ASSERT_EQ(Bitmap::LoadFromMemory(size, pData, &expected), SUCCESS);
+
+    CollectingSink sink;
+    ASSERT_EQ(Bitmap::StreamFromMemory(size, pData, &sink, bandHeight), SUCCESS);
+    EXPECT_EQ(sink.mBeginCount, 1u);
+    EXPECT_EQ(sink.mNextRow, expected.GetHeight());
+    ExpectSameBitmaps(expected, sink.mBitmap);
+}
+
+// Radiance HDR with run-length encoded scanlines, mixing runs and literals.
+std::vector<uint8_t> CreateHDR(uint32_t width, uint32_t height)
+{
+    std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) + " +X " + std::to_string(width) + "\n";
+
+    std::vector<uint8_t> data(header.begin(), header.end());
+    for (uint32_t y = 0; y < height; ++y) {
+        if (width < 8) {
+            for (uint32_t x = 0; x < width; ++x) {
+                data.insert(data.end(), {uint8_t(x * 40), uint8_t(y * 30), 200, uint8_t((x == 0) ? 0 : 128 + x)});
+            }
+            continue;
+        }
+        data.insert(data.end(), {2, 2, uint8_t(width >> 8), uint8_t(width & 0xFF)});
+        for (uint32_t channel = 0; channel < 4; ++channel) {
+            // A run over the first half, literals over the second.
+            uint32_t runLength = width / 2;
+            data.push_back(uint8_t(128 + runLength));
+            data.push_back(uint8_t((channel == 3) ? 130 : (y * 10 + channel)));
+            data.push_back(uint8_t(width - runLength));
+            for (uint32_t x = runLength; x < width; ++x) {
+                data.push_back(uint8_t((channel == 3) ? ((x % 5 == 0) ? 0 : 120 + x) : (x * 3 + channel)));
+            }
+        }
+    }
+    return data;
+}
+
+std::vector<uint8_t> CreatePNG(uint32_t width, uint32_t height, uint8_t bitDepth, const std::vector<uint8_t>& idat);
+
+// 1x1 gray PNG whose only deflate block is dynamic, with \b literalCount
+// literal/length codes and \b distanceCount distance codes. The code lengths
+// are all zero, written as runs of symbol 18, so the block is invalid even
+// when the counts are in range.
+std::vector<uint8_t> CreateDynamicBlockPNG(uint32_t literalCount, uint32_t distanceCount)
+{
+    std::vector<uint8_t> deflate = {0x78, 0x01};
+    uint32_t             bits    = 0;
+    uint32_t             count   = 0;
+    auto                 putBits = [&](uint32_t value, uint32_t bitCount) {
+        bits |= value << count;
+        count += bitCount;
+        while (count >= 8) {
+            deflate.push_back(static_cast<uint8_t>(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    };
+    putBits(1, 1); // Final block
+    putBits(2, 2); // Dynamic Huffman codes
+    putBits(literalCount - 257, 5);
+    putBits(distanceCount - 1, 5);
+    putBits(0, 4); // Lengths of code length symbols 16, 17, 18 and 0
+    putBits(0, 3);
+    putBits(0, 3);
+    putBits(1, 3);
+    putBits(1, 3);
+    for (uint32_t remaining = literalCount + distanceCount; remaining > 0;) {
+        uint32_t repeat = std::min<uint32_t>(remaining, 138);
+        putBits(1, 1); // Symbol 18, code 1
+        putBits(repeat - 11, 7);
+        remaining -= repeat;
+    }
+    putBits(0, 8);
+
+    return CreatePNG(1, 1, 8, deflate);
+}
+
+// Gray PNG with a \b width x \b height header of \b bitDepth bits, whose
+// image data is zlib stream \b idat.
+std::vector<uint8_t> CreatePNG(uint32_t width, uint32_t height, uint8_t bitDepth, const std::vector<uint8_t>& idat)
+{
+    auto putChunk = [](std::vector<uint8_t>* pBytes, const char* pType, const std::vector<uint8_t>& data) {
+        uint32_t length = static_cast<uint32_t>(data.size());
+        pBytes->insert(pBytes->end(), {uint8_t(length >> 24), uint8_t(length >> 16), uint8_t(length >> 8), uint8_t(length)});
+        pBytes->insert(pBytes->end(), pType, pType + 4);
+        pBytes->insert(pBytes->end(), data.begin(), data.end());
+        pBytes->insert(pBytes->end(), {0, 0, 0, 0}); // CRC, not checked
+    };
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    putChunk(&png, "IHDR", {uint8_t(width >> 24), uint8_t(width >> 16), uint8_t(width >> 8), uint8_t(width), uint8_t(height >> 24), uint8_t(height >> 16), uint8_t(height >> 8), uint8_t(height), bitDepth, 0, 0, 0, 0});
+    putChunk(&png, "IDAT", idat);
+    putChunk(&png, "IEND", {});
+    return png;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(BitmapStreamTest, PNGMatchesLoad)
+{
+    const std::pair<const uint8_t*, size_t> images[] = {
+        {kRGB16Transparent, sizeof(kRGB16Transparent)},
+        {kPalette4, sizeof(kPalette4)},
+        {kGray2, sizeof(kGray2)},
+        {kGrayAlpha16, sizeof(kGrayAlpha16)},
+        {kRGBA8Stored, sizeof(kRGBA8Stored)},
+        {kGray1, sizeof(kGray1)},
+        {kRGB8, sizeof(kRGB8)},
+    };
+    for (size_t i = 0; i < std::size(images); ++i) {
+        SCOPED_TRACE(i);
+        ExpectStreamMatchesLoad(images[i].first, images[i].second, 4);
+    }
+}
+
+TEST(BitmapStreamTest, SavedPNGMatchesLoad)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "ppx_bitmap_stream_test.png";
+
+    Bitmap bitmap;
+    ASSERT_EQ(Bitmap::Create(67, 45, Bitmap::FORMAT_RGBA_UINT8, &bitmap), SUCCESS);
+    for (uint32_t y = 0; y < bitmap.GetHeight(); ++y) {
+        for (uint32_t x = 0; x < bitmap.GetWidth(); ++x) {
+            uint8_t* pPixel = bitmap.GetPixel8u(x, y);
+            pPixel[0]       = static_cast<uint8_t>(x * 3);
+            pPixel[1]       = static_cast<uint8_t>(y * 5 + x);
+            pPixel[2]       = static_cast<uint8_t>((x * y) >> 2);
+            pPixel[3]       = static_cast<uint8_t>(255 - y);
+        }
+    }
+    ASSERT_EQ(Bitmap::SaveFilePNG(path, &bitmap), SUCCESS);
+
+    CollectingSink sink;
+    ASSERT_EQ(Bitmap::StreamFile(path, &sink, 16), SUCCESS);
+    ExpectSameBitmaps(bitmap, sink.mBitmap);
+    EXPECT_EQ(sink.mBandHeights, (std::vector<uint32_t>{16, 16, 13}));
+
+    std::filesystem::remove(path);
+}
+
+TEST(BitmapStreamTest, HDRMatchesLoad)
+{
+    std::vector<uint8_t> rle = CreateHDR(24, 9);
+    ExpectStreamMatchesLoad(rle.data(), rle.size(), 4);
+
+    // Narrow images are stored without run-length encoding.
+    std::vector<uint8_t> flat = CreateHDR(5, 3);
+    ExpectStreamMatchesLoad(flat.data(), flat.size(), 2);
+}
+
+TEST(BitmapStreamTest, OtherFormatsFallBackToLoad)
+{
+    // 2x2 24-bit BMP, rows bottom-up and padded to 4 bytes.
+    const uint8_t bmp[] = {
+        'B', 'M', 70, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0,
+        40, 0, 0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 1, 0, 24, 0, 0, 0, 0, 0, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 255, 0, 255, 0, 0, 0,
+        255, 0, 0, 255, 255, 255, 0, 0};
+    ExpectStreamMatchesLoad(bmp, sizeof(bmp), 1);
+}
+
+TEST(BitmapStreamTest, InvalidArguments)
+{
+    CollectingSink sink;
+    EXPECT_EQ(Bitmap::StreamFromMemory(0, kGray1, &sink), ERROR_UNEXPECTED_NULL_ARGUMENT);
+    EXPECT_EQ(Bitmap::StreamFromMemory(sizeof(kGray1), nullptr, &sink), ERROR_UNEXPECTED_NULL_ARGUMENT);
+    EXPECT_EQ(Bitmap::StreamFromMemory(sizeof(kGray1), kGray1, nullptr), ERROR_UNEXPECTED_NULL_ARGUMENT);
+    EXPECT_EQ(Bitmap::StreamFromMemory(sizeof(kGray1), kGray1, &sink, 0), ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(Bitmap::StreamFile("ppx_missing_image.png", &sink), ERROR_PATH_DOES_NOT_EXIST);
+}
+
+TEST(BitmapStreamTest, CorruptDataFails)
+{
+    // Truncated in the middle of the compressed data.
+    std::vector<uint8_t> truncated(kRGB8, kRGB8 + sizeof(kRGB8) / 2);
+    CollectingSink       sink;
+    EXPECT_EQ(Bitmap::StreamFromMemory(truncated.size(), truncated.data(), &sink), ERROR_IMAGE_FILE_LOAD_FAILED);
+
+    // Flipped bits in the compressed data.
+    std::vector<uint8_t> corrupt(kRGB8, kRGB8 + sizeof(kRGB8));
+    for (size_t i = 60; i < corrupt.size() - 20; i += 7) {
+        corrupt[i] ^= 0x5A;
+    }
+    CollectingSink corruptSink;
+    EXPECT_NE(Bitmap::StreamFromMemory(corrupt.size(), corrupt.data(), &corruptSink), SUCCESS);
+
+    std::vector<uint8_t> hdr = CreateHDR(24, 9);
+    hdr.resize(hdr.size() - 10);
+    CollectingSink hdrSink;
+    EXPECT_EQ(Bitmap::StreamFromMemory(hdr.size(), hdr.data(), &hdrSink), ERROR_IMAGE_FILE_LOAD_FAILED);
+}
+
+TEST(BitmapStreamTest, DynamicBlockCodeCountsAreChecked)
+{
+    // HLIT and HDIST can encode 288 literal/length and 32 distance codes,
+    // which is more than the alphabets have and than the decoder stores.
+    const std::pair<uint32_t, uint32_t> counts[] = {
+        {288, 1},
+        {257, 32},
+        {288, 32},
+        {286, 30},
+    };
+    for (auto& count : counts) {
+        SCOPED_TRACE(count.first);
+        SCOPED_TRACE(count.second);
+        std::vector<uint8_t> png = CreateDynamicBlockPNG(count.first, count.second);
+        CollectingSink       sink;
+        EXPECT_EQ(Bitmap::StreamFromMemory(png.size(), png.data(), &sink), ERROR_IMAGE_FILE_LOAD_FAILED);
+    }
+}
+
+TEST(BitmapStreamTest, OversizedImagesAreRejected)
+{
+    // Zlib stream of an empty stored block, never read.
+    const std::vector<uint8_t> idat = {0x78, 0x01, 0x01, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01};
+
+    // 1-bit rows of this width are 32 MB, but their RGBA8 expansion would
+    // wrap a 32-bit size.
+    const std::pair<uint32_t, uint32_t> pngSizes[] = {
+        {(1u << 28) + 8, 4},
+        {(1u << 24) + 1, 1},
+        {1, (1u << 24) + 1},
+    };
+    for (const auto& size : pngSizes) {
+        SCOPED_TRACE(std::to_string(size.first) + "x" + std::to_string(size.second));
+        std::vector<uint8_t> png = CreatePNG(size.first, size.second, 1, idat);
+        CollectingSink       sink;
+        EXPECT_EQ(Bitmap::StreamFromMemory(png.size(), png.data(), &sink), ERROR_IMAGE_FILE_LOAD_FAILED);
+        EXPECT_EQ(sink.mBeginCount, 0u);
+    }
+
+    const std::pair<uint32_t, uint32_t> hdrSizes[] = {
+        {(1u << 24) + 1, 1},
+        {1, (1u << 24) + 1},
+        {(1u << 30), 4},
+    };
+    for (const auto& size : hdrSizes) {
+        SCOPED_TRACE(std::to_string(size.first) + "x" + std::to_string(size.second));
+        std::string    header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(size.second) + " +X " + std::to_string(size.first) + "\n";
+        CollectingSink sink;
+        EXPECT_EQ(Bitmap::StreamFromMemory(header.size(), header.data(), &sink), ERROR_IMAGE_FILE_LOAD_FAILED);
+        EXPECT_EQ(sink.mBeginCount, 0u);
+    }
+}
+
+TEST(BitmapStreamTest, SinkErrorStopsDecode)
+{
+    class FailingSink : public CollectingSink
+    {
+    public:
+        Result WriteBand(uint32_t firstRow, const Bitmap& band) override
+        {
+            ++mWriteCount;
+            return ERROR_FAILED;
+        }
+        uint32_t mWriteCount = 0;
+    };
+
+    FailingSink sink;
+    EXPECT_EQ(Bitmap::StreamFromMemory(sizeof(kRGB8), kRGB8, &sink, 2), ERROR_FAILED);
+    EXPECT_EQ(sink.mWriteCount, 1u);
+}
+
+#if defined(__linux__)
+
+// Writes a width x height 8-bit gray PNG row by row, where row y is filled
+// with (y * 7) & 0xFF. Each row is a literal followed by back-references to
+// it, with fixed Huffman codes, so the file stays small.
+class GrayPNGWriter
+{
+public:
+    static bool Write(const std::filesystem::path& path, uint32_t width, uint32_t height)
+    {
+        GrayPNGWriter writer;
+        writer.PutBytes({0x78, 0x01});
+        uint32_t adlerA = 1;
+        uint32_t adlerB = 0;
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint8_t value = static_cast<uint8_t>(y * 7);
+            writer.PutLiteral(0);
+            writer.PutLiteral(value);
+            for (uint32_t remaining = width - 1; remaining > 0;) {
+                uint32_t length = std::min<uint32_t>(remaining, 258);
+                if (length < 3) {
+                    writer.PutLiteral(value);
+                    remaining -= 1;
+                    continue;
+                }
+                writer.PutMatch(length);
+                remaining -= length;
+            }
+            // Adler-32 of the filter byte and the row.
+            adlerB = (adlerB + adlerA) % 65521;
+            for (uint32_t x = 0; x < width; ++x) {
+                adlerA = (adlerA + value) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+        }
+        writer.PutCode(0, 7); // End of block
+        writer.FlushBits();
+        uint32_t adler = (adlerB << 16) | adlerA;
+        writer.PutBytes({uint8_t(adler >> 24), uint8_t(adler >> 16), uint8_t(adler >> 8), uint8_t(adler)});
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+        std::vector<uint8_t> header;
+        PutBigEndian32(&header, width);
+        PutBigEndian32(&header, height);
+        header.insert(header.end(), {8, 0, 0, 0, 0});
+        WriteChunk(file, "IHDR", header);
+        WriteChunk(file, "IDAT", writer.mBytes);
+        WriteChunk(file, "IEND", {});
+        return file.good();
+    }
+
+private:
+    GrayPNGWriter()
+    {
+        // First block, final, fixed Huffman codes.
+        PutBits(1, 1);
+        PutBits(1, 2);
+    }
+
+    static void PutBigEndian32(std::vector<uint8_t>* pBytes, uint32_t value)
+    {
+        pBytes->insert(pBytes->end(), {uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value)});
+    }
+
+    static void WriteChunk(std::ofstream& file, const char* pType, const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> bytes;
+        PutBigEndian32(&bytes, static_cast<uint32_t>(data.size()));
+        bytes.insert(bytes.end(), pType, pType + 4);
+        bytes.insert(bytes.end(), data.begin(), data.end());
+
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 4; i < bytes.size(); ++i) {
+            crc ^= bytes[i];
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        PutBigEndian32(&bytes, ~crc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    void PutBytes(std::initializer_list<uint8_t> bytes) { mBytes.insert(mBytes.end(), bytes); }
+
+    void PutBits(uint32_t value, uint32_t count)
+    {
+        mBits |= value << mBitCount;
+        mBitCount += count;
+        while (mBitCount >= 8) {
+            mBytes.push_back(static_cast<uint8_t>(mBits));
+            mBits >>= 8;
+            mBitCount -= 8;
+        }
+    }
+
+    // Huffman codes are stored from their most significant bit.
+    void PutCode(uint32_t code, uint32_t length)
+    {
+        for (uint32_t i = length; i > 0; --i) {
+            PutBits((code >> (i - 1)) & 1, 1);
+        }
+    }
+
+    void PutLiteral(uint8_t value)
+    {
+        if (value < 144) {
+            PutCode(0x30 + value, 8);
+        }
+        else {
+            PutCode(0x190 + (value - 144), 9);
+        }
+    }
+
+    // Back-reference to the previous byte.
+    void PutMatch(uint32_t length)
+    {
+        static const uint16_t kLengthBase[29]  = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t  kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+        uint32_t index = 28;
+        while (kLengthBase[index] > length) {
+            --index;
+        }
+        uint32_t symbol = 257 + index;
+        if (symbol < 280) {
+            PutCode(symbol - 256, 7);
+        }
+        else {
+            PutCode(0xC0 + (symbol - 280), 8);
+        }
+        PutBits(length - kLengthBase[index], kLengthExtra[index]);
+        PutCode(0, 5); // Distance 1
+    }
+
+    void FlushBits()
+    {
+        if (mBitCount > 0) {
+            PutBits(0, 8 - mBitCount);
+        }
+    }
+
+    std::vector<uint8_t> mBytes;
+    uint32_t             mBits     = 0;
+    uint32_t             mBitCount = 0;
+};
+
+// Returns a field of /proc/self/status in bytes, or 0 if it is missing.
+uint64_t GetProcessStatusBytes(const char* pField)
+{
+    std::ifstream file("/proc/self/status");
+    std::string   line;
+    while (std::getline(file, line)) {
+        if (line.rfind(pField, 0) == 0) {
+            return std::stoull(line.substr(std::strlen(pField))) * 1024;
+        }
+    }
+    return 0;
+}
+
+TEST(BitmapStreamTest, LargeImagePeakMemoryIsBounded)
+{
+    const uint32_t size = 16384;
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "ppx_bitmap_stream_large.png";
+    ASSERT_TRUE(GrayPNGWriter::Write(path, size, size));
+
+    // Writing 5 resets the peak resident set size of the process.
+    {
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+        if (!clearRefs.good()) {
+            std::filesystem::remove(path);
+            GTEST_SKIP() << "Peak memory cannot be reset";
+        }
+    }
+    const uint64_t baseline = GetProcessStatusBytes("VmRSS:");
+
+    // Check the first and last pixel of every row instead of keeping the image.
+    class CheckingSink : public BitmapSink
+    {
+    public:
+        Result Begin(uint32_t width, uint32_t height, Bitmap::Format format) override
+        {
+            return ((width == 16384) && (height == 16384) && (format == Bitmap::FORMAT_RGBA_UINT8)) ? SUCCESS : ERROR_FAILED;
+        }
+
+        Result WriteBand(uint32_t firstRow, const Bitmap& band) override
+        {
+            for (uint32_t y = 0; y < band.GetHeight(); ++y) {
+                const uint8_t expected = static_cast<uint8_t>((firstRow + y) * 7);
+                const uint8_t* pFirst  = band.GetPixel8u(0, y);
+                const uint8_t* pLast   = band.GetPixel8u(band.GetWidth() - 1, y);
+                if ((pFirst[0] != expected) || (pFirst[3] != 255) || (pLast[2] != expected)) {
+                    return ERROR_FAILED;
+                }
+            }
+            mRowCount += band.GetHeight();
+            return SUCCESS;
+        }
+
+        uint32_t mRowCount = 0;
+    };
+
+    CheckingSink sink;
+    EXPECT_EQ(Bitmap::StreamFile(path, &sink), SUCCESS);
+    EXPECT_EQ(sink.mRowCount, size);
+
+    // The full RGBA8 image is 1 GiB, a band of 64 rows is 4 MiB.
+    const uint64_t peak = GetProcessStatusBytes("VmHWM:");
+    EXPECT_LT(peak - std::min(peak, baseline), 64ull * 1024 * 1024);
+
+    std::filesystem::remove(path);
+}
+
+#endif // defined(__linux__)
+
+} // namespace
+} // namespace ppx
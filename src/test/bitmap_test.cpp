@@ -0,0 +1,437 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/bitmap.h"
+#include "ppx/mipmap.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ppx {
+namespace {
+
+template <typename T>
+Bitmap CreateBitmap(uint32_t width, uint32_t height, Bitmap::Format format, const std::vector<T>& values)
+{
+    Bitmap bitmap;
+    EXPECT_EQ(Bitmap::Create(width, height, format, &bitmap), SUCCESS);
+    EXPECT_EQ(values.size() * sizeof(T), bitmap.GetFootprintSize());
+    memcpy(bitmap.GetData(), values.data(), bitmap.GetFootprintSize());
+    return bitmap;
+}
+
+template <typename T>
+std::vector<T> GetValues(const Bitmap& bitmap)
+{
+    const T* pData = reinterpret_cast<const T*>(bitmap.GetData());
+    return std::vector<T>(pData, pData + bitmap.GetFootprintSize() / sizeof(T));
+}
+
+template <typename T>
+Bitmap CreateRandomBitmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t seed)
+{
+    std::vector<T> values(width * height * Bitmap::ChannelCount(format));
+    uint32_t       state = seed;
+    for (T& value : values) {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<T>(state >> 16);
+    }
+    return CreateBitmap(width, height, format, values);
+}
+
+// Straightforward box filter over the source pixels of each destination
+// pixel, as documented by Bitmap::DownsampleTo.
+template <typename T>
+std::vector<T> ReferenceDownsample(const Bitmap& src)
+{
+    const uint32_t srcWidth     = src.GetWidth();
+    const uint32_t srcHeight    = src.GetHeight();
+    const uint32_t dstWidth     = std::max<uint32_t>(srcWidth / 2, 1);
+    const uint32_t dstHeight    = std::max<uint32_t>(srcHeight / 2, 1);
+    const uint32_t channelCount = src.GetChannelCount();
+    const T*       pSrc         = reinterpret_cast<const T*>(src.GetData());
+
+    std::vector<T> dst(dstWidth * dstHeight * channelCount);
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+        uint32_t y0 = (srcHeight == 1) ? 0 : 2 * y;
+        uint32_t y1 = (srcHeight == 1) ? 1 : ((y == dstHeight - 1) ? srcHeight : 2 * y + 2);
+        for (uint32_t x = 0; x < dstWidth; ++x) {
+            uint32_t x0 = (srcWidth == 1) ? 0 : 2 * x;
+            uint32_t x1 = (srcWidth == 1) ? 1 : ((x == dstWidth - 1) ? srcWidth : 2 * x + 2);
+            uint64_t n  = (y1 - y0) * (x1 - x0);
+            for (uint32_t c = 0; c < channelCount; ++c) {
+                double sum = 0;
+                for (uint32_t sy = y0; sy < y1; ++sy) {
+                    for (uint32_t sx = x0; sx < x1; ++sx) {
+                        sum += pSrc[(sy * srcWidth + sx) * channelCount + c];
+                    }
+                }
+                T& value = dst[(y * dstWidth + x) * channelCount + c];
+                if (std::is_floating_point<T>::value) {
+                    value = static_cast<T>(sum / n);
+                }
+                else {
+                    value = static_cast<T>((static_cast<uint64_t>(sum) + n / 2) / n);
+                }
+            }
+        }
+    }
+    return dst;
+}
+
+template <typename T>
+void ExpectMatchesReference(Bitmap::Format format)
+{
+    for (uint32_t height = 1; height <= 7; ++height) {
+        for (uint32_t width = 1; width <= 41; ++width) {
+            Bitmap src = CreateRandomBitmap<T>(width, height, format, width * 100 + height);
+            Bitmap dst;
+            ASSERT_EQ(Bitmap::Create(std::max<uint32_t>(width / 2, 1), std::max<uint32_t>(height / 2, 1), format, &dst), SUCCESS);
+            ASSERT_EQ(src.DownsampleTo(&dst), SUCCESS);
+
+            std::vector<T> expected = ReferenceDownsample<T>(src);
+            std::vector<T> actual   = GetValues<T>(dst);
+            ASSERT_EQ(actual.size(), expected.size());
+            for (size_t i = 0; i < actual.size(); ++i) {
+                if (std::is_floating_point<T>::value) {
+                    ASSERT_NEAR(actual[i], expected[i], 1e-6 * std::abs(static_cast<double>(expected[i]))) << width << "x" << height << " at " << i;
+                }
+                else {
+                    ASSERT_EQ(actual[i], expected[i]) << width << "x" << height << " at " << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(BitmapTest, DownsampleRGBA8Golden)
+{
+    // clang-format off
+    Bitmap src = CreateBitmap<uint8_t>(4, 2, Bitmap::FORMAT_RGBA_UINT8, {
+        0,   10, 20, 255,   4,   10, 21, 255,   100, 0, 255, 0,   101, 0, 255, 0,
+        0,   10, 20, 255,   255, 11, 21, 0,     100, 0, 255, 0,   102, 1, 255, 1,
+    });
+    // clang-format on
+    Bitmap dst;
+    ASSERT_EQ(Bitmap::Create(2, 1, Bitmap::FORMAT_RGBA_UINT8, &dst), SUCCESS);
+    ASSERT_EQ(src.DownsampleTo(&dst), SUCCESS);
+    EXPECT_EQ(GetValues<uint8_t>(dst), (std::vector<uint8_t>{65, 10, 21, 191, 101, 0, 255, 0}));
+}
+
+TEST(BitmapTest, DownsampleOddSizesKeepEveryPixel)
+{
+    // The single destination pixel of a 3x3 bitmap averages all 9 pixels.
+    std::vector<uint8_t> values;
+    for (uint8_t i = 0; i < 9; ++i) {
+        values.insert(values.end(), {static_cast<uint8_t>(10 * i), 0, 255, static_cast<uint8_t>(i == 8 ? 90 : 0)});
+    }
+    Bitmap src = CreateBitmap(3, 3, Bitmap::FORMAT_RGBA_UINT8, values);
+    Bitmap dst;
+    ASSERT_EQ(Bitmap::Create(1, 1, Bitmap::FORMAT_RGBA_UINT8, &dst), SUCCESS);
+    ASSERT_EQ(src.DownsampleTo(&dst), SUCCESS);
+    EXPECT_EQ(GetValues<uint8_t>(dst), (std::vector<uint8_t>{40, 0, 255, 10}));
+
+    // A 5x1 bitmap: pixels 0-1 and 2-4.
+    Bitmap row = CreateBitmap<float>(5, 1, Bitmap::FORMAT_R_FLOAT, {1, 2, 3, 4, 8});
+    ASSERT_EQ(Bitmap::Create(2, 1, Bitmap::FORMAT_R_FLOAT, &dst), SUCCESS);
+    ASSERT_EQ(row.DownsampleTo(&dst), SUCCESS);
+    EXPECT_EQ(GetValues<float>(dst), (std::vector<float>{1.5f, 5.0f}));
+}
+
+TEST(BitmapTest, DownsampleRGBA16AndFloatGolden)
+{
+    Bitmap src16 = CreateBitmap<uint16_t>(2, 2, Bitmap::FORMAT_RGBA_UINT16, {65535, 0, 1, 2, 65535, 0, 1, 2, 65535, 0, 1, 3, 65534, 1, 2, 3});
+    Bitmap dst;
+    ASSERT_EQ(Bitmap::Create(1, 1, Bitmap::FORMAT_RGBA_UINT16, &dst), SUCCESS);
+    ASSERT_EQ(src16.DownsampleTo(&dst), SUCCESS);
+    EXPECT_EQ(GetValues<uint16_t>(dst), (std::vector<uint16_t>{65535, 0, 1, 3}));
+
+    Bitmap srcF = CreateBitmap<float>(2, 2, Bitmap::FORMAT_RGBA_FLOAT, {1, -1, 0.5f, 100, 2, -2, 0.5f, 0, 3, -3, 0.5f, 0, 4, -4, 0.5f, 0});
+    ASSERT_EQ(Bitmap::Create(1, 1, Bitmap::FORMAT_RGBA_FLOAT, &dst), SUCCESS);
+    ASSERT_EQ(srcF.DownsampleTo(&dst), SUCCESS);
+    EXPECT_EQ(GetValues<float>(dst), (std::vector<float>{2.5f, -2.5f, 0.5f, 25.0f}));
+}
+
+TEST(BitmapTest, DownsampleSRGB)
+{
+    // One white pixel out of four: 25% linear coverage, which encodes to 137
+    // in sRGB instead of 64. Alpha is averaged linearly either way.
+    Bitmap src = CreateBitmap<uint8_t>(2, 2, Bitmap::FORMAT_RGBA_UINT8, {255, 255, 0, 255, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    Bitmap dst;
+    ASSERT_EQ(Bitmap::Create(1, 1, Bitmap::FORMAT_RGBA_UINT8, &dst), SUCCESS);
+    ASSERT_EQ(src.DownsampleTo(&dst, /* srgb= */ true), SUCCESS);
+    EXPECT_EQ(GetValues<uint8_t>(dst), (std::vector<uint8_t>{137, 137, 0, 64}));
+    ASSERT_EQ(src.DownsampleTo(&dst, /* srgb= */ false), SUCCESS);
+    EXPECT_EQ(GetValues<uint8_t>(dst), (std::vector<uint8_t>{64, 64, 0, 64}));
+
+    // Uniform colors are preserved exactly.
+    for (uint32_t i = 0; i < 256; ++i) {
+        Bitmap uniform = CreateBitmap(2, 1, Bitmap::FORMAT_RGBA_UINT8, std::vector<uint8_t>(8, static_cast<uint8_t>(i)));
+        ASSERT_EQ(uniform.DownsampleTo(&dst, /* srgb= */ true), SUCCESS);
+        EXPECT_EQ(GetValues<uint8_t>(dst), std::vector<uint8_t>(4, static_cast<uint8_t>(i)));
+    }
+}
+
+TEST(BitmapTest, DownsampleMatchesReference)
+{
+    ExpectMatchesReference<uint8_t>(Bitmap::FORMAT_RGBA_UINT8);
+    ExpectMatchesReference<uint8_t>(Bitmap::FORMAT_RGB_UINT8);
+    ExpectMatchesReference<uint16_t>(Bitmap::FORMAT_RGBA_UINT16);
+    ExpectMatchesReference<uint32_t>(Bitmap::FORMAT_RG_UINT32);
+    ExpectMatchesReference<float>(Bitmap::FORMAT_RGBA_FLOAT);
+}
+
+TEST(BitmapTest, DownsampleInvalidArguments)
+{
+    Bitmap src = CreateRandomBitmap<uint8_t>(8, 8, Bitmap::FORMAT_RGBA_UINT8, 1);
+    Bitmap dst;
+    EXPECT_EQ(src.DownsampleTo(nullptr), ERROR_UNEXPECTED_NULL_ARGUMENT);
+    ASSERT_EQ(Bitmap::Create(4, 4, Bitmap::FORMAT_RGBA_UINT16, &dst), SUCCESS);
+    EXPECT_EQ(src.DownsampleTo(&dst), ERROR_IMAGE_INVALID_FORMAT);
+    ASSERT_EQ(Bitmap::Create(4, 3, Bitmap::FORMAT_RGBA_UINT8, &dst), SUCCESS);
+    EXPECT_EQ(src.DownsampleTo(&dst), ERROR_BITMAP_FOOTPRINT_MISMATCH);
+}
+
+TEST(BitmapTest, MipmapChain)
+{
+    Bitmap src = CreateRandomBitmap<uint8_t>(37, 20, Bitmap::FORMAT_RGBA_UINT8, 7);
+    Mipmap mipmap(src, PPX_REMAINING_MIP_LEVELS);
+    ASSERT_TRUE(mipmap.IsOk());
+    ASSERT_EQ(mipmap.GetLevelCount(), 5u);
+    for (uint32_t level = 1; level < mipmap.GetLevelCount(); ++level) {
+        const Bitmap* pPrev = mipmap.GetMip(level - 1);
+        const Bitmap* pMip  = mipmap.GetMip(level);
+        EXPECT_EQ(pMip->GetWidth(), pPrev->GetWidth() / 2);
+        EXPECT_EQ(pMip->GetHeight(), pPrev->GetHeight() / 2);
+        EXPECT_EQ(GetValues<uint8_t>(*pMip), ReferenceDownsample<uint8_t>(*pPrev));
+    }
+}
+
+template <typename T>
+void ExpectBandsMatchSingleThread(Bitmap::Format format, uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, double tolerance)
+{
+    Bitmap src = CreateRandomBitmap<T>(srcWidth, srcHeight, format, srcWidth + srcHeight);
+    if (std::is_floating_point<T>::value) {
+        float* pValues = reinterpret_cast<float*>(src.GetData());
+        for (uint64_t i = 0; i < src.GetFootprintSize() / sizeof(float); ++i) {
+            pValues[i] = static_cast<float>((i * 7919) % 1000) / 999.0f;
+        }
+    }
+
+    Bitmap single;
+    ASSERT_EQ(Bitmap::Create(dstWidth, dstHeight, format, &single), SUCCESS);
+    ASSERT_EQ(src.ScaleTo(&single, STBIR_FILTER_DEFAULT, 1), SUCCESS);
+
+    for (uint32_t threadCount : {2u, 3u, 8u}) {
+        Bitmap banded;
+        ASSERT_EQ(Bitmap::Create(dstWidth, dstHeight, format, &banded), SUCCESS);
+        ASSERT_EQ(src.ScaleTo(&banded, STBIR_FILTER_DEFAULT, threadCount), SUCCESS);
+
+        std::vector<T> expected = GetValues<T>(single);
+        std::vector<T> actual   = GetValues<T>(banded);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            ASSERT_NEAR(static_cast<double>(actual[i]), static_cast<double>(expected[i]), tolerance) << threadCount << " threads at " << i;
+        }
+    }
+}
+
+TEST(BitmapTest, ScaleBandsMatchSingleThread)
+{
+    // Bands may round the filter weights differently in the last float bit.
+    ExpectBandsMatchSingleThread<uint8_t>(Bitmap::FORMAT_RGBA_UINT8, 997, 613, 331, 207, 1.0);
+    ExpectBandsMatchSingleThread<uint8_t>(Bitmap::FORMAT_RGB_UINT8, 64, 48, 301, 177, 1.0);
+    ExpectBandsMatchSingleThread<uint16_t>(Bitmap::FORMAT_RG_UINT16, 256, 256, 128, 128, 1.0);
+    ExpectBandsMatchSingleThread<float>(Bitmap::FORMAT_RGBA_FLOAT, 300, 200, 450, 130, 1e-5);
+}
+
+// Value conversions as documented by Bitmap::ConvertTo, written independently
+// of the implementation.
+template <typename T>
+double ReferenceNormalize(T value)
+{
+    if (std::is_floating_point<T>::value) {
+        return static_cast<double>(value);
+    }
+    return static_cast<double>(value) / static_cast<double>(std::numeric_limits<T>::max());
+}
+
+template <typename T>
+T ReferenceDenormalize(double value)
+{
+    if (std::is_floating_point<T>::value) {
+        return static_cast<T>(value);
+    }
+    if (!(value > 0.0)) {
+        return 0;
+    }
+    value = std::min(value, 1.0);
+    return static_cast<T>(std::floor(value * std::numeric_limits<T>::max() + 0.5));
+}
+
+template <typename SrcT, typename DstT>
+std::vector<DstT> ReferenceConvert(const Bitmap& src, Bitmap::Format format)
+{
+    const uint32_t srcChannelCount = src.GetChannelCount();
+    const uint32_t dstChannelCount = Bitmap::ChannelCount(format);
+    const uint32_t pixelCount      = src.GetWidth() * src.GetHeight();
+    const SrcT*    pSrc            = reinterpret_cast<const SrcT*>(src.GetData());
+
+    std::vector<DstT> dst(pixelCount * dstChannelCount);
+    for (uint32_t i = 0; i < pixelCount; ++i) {
+        for (uint32_t c = 0; c < dstChannelCount; ++c) {
+            double value = (c == 3) ? 1.0 : 0.0;
+            if (c < srcChannelCount) {
+                value = ReferenceNormalize(pSrc[i * srcChannelCount + c]);
+            }
+            dst[i * dstChannelCount + c] = ReferenceDenormalize<DstT>(value);
+        }
+    }
+    return dst;
+}
+
+template <typename SrcT, typename DstT>
+void ExpectConvertMatchesReference(Bitmap::Format srcFormat, Bitmap::Format dstFormat)
+{
+    // Widths cover the SIMD kernels and their scalar tails.
+    for (uint32_t width = 1; width <= 37; ++width) {
+        Bitmap src = CreateRandomBitmap<SrcT>(width, 3, srcFormat, width);
+        if (std::is_floating_point<SrcT>::value) {
+            float* pValues = reinterpret_cast<float*>(src.GetData());
+            for (uint64_t i = 0; i < src.GetFootprintSize() / sizeof(float); ++i) {
+                pValues[i] = static_cast<float>((i * 7919) % 1001) / 500.0f - 0.5f;
+            }
+            pValues[0] = std::numeric_limits<float>::quiet_NaN();
+        }
+
+        Bitmap dst;
+        ASSERT_EQ(src.ConvertTo(dstFormat, &dst), SUCCESS);
+        ASSERT_EQ(dst.GetFormat(), dstFormat);
+
+        std::vector<DstT> expected = ReferenceConvert<SrcT, DstT>(src, dstFormat);
+        std::vector<DstT> actual   = GetValues<DstT>(dst);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            if (std::is_floating_point<DstT>::value && !std::isnan(static_cast<double>(expected[i]))) {
+                ASSERT_NEAR(static_cast<double>(actual[i]), static_cast<double>(expected[i]), 1e-6) << width << " at " << i;
+            }
+            else if (!std::is_floating_point<DstT>::value) {
+                ASSERT_EQ(actual[i], expected[i]) << width << " at " << i;
+            }
+        }
+    }
+}
+
+TEST(BitmapTest, ConvertMatchesReference)
+{
+    ExpectConvertMatchesReference<uint8_t, uint16_t>(Bitmap::FORMAT_RGBA_UINT8, Bitmap::FORMAT_RGBA_UINT16);
+    ExpectConvertMatchesReference<uint8_t, float>(Bitmap::FORMAT_RGBA_UINT8, Bitmap::FORMAT_RGBA_FLOAT);
+    ExpectConvertMatchesReference<uint16_t, uint8_t>(Bitmap::FORMAT_RGBA_UINT16, Bitmap::FORMAT_RGBA_UINT8);
+    ExpectConvertMatchesReference<uint16_t, float>(Bitmap::FORMAT_RG_UINT16, Bitmap::FORMAT_RG_FLOAT);
+    ExpectConvertMatchesReference<float, uint8_t>(Bitmap::FORMAT_RGBA_FLOAT, Bitmap::FORMAT_RGBA_UINT8);
+    ExpectConvertMatchesReference<float, uint16_t>(Bitmap::FORMAT_RGB_FLOAT, Bitmap::FORMAT_RGB_UINT16);
+    ExpectConvertMatchesReference<uint8_t, uint8_t>(Bitmap::FORMAT_RGB_UINT8, Bitmap::FORMAT_RGBA_UINT8);
+    ExpectConvertMatchesReference<uint8_t, uint8_t>(Bitmap::FORMAT_RGBA_UINT8, Bitmap::FORMAT_RG_UINT8);
+    ExpectConvertMatchesReference<uint8_t, float>(Bitmap::FORMAT_R_UINT8, Bitmap::FORMAT_RGBA_FLOAT);
+    ExpectConvertMatchesReference<float, uint16_t>(Bitmap::FORMAT_RGBA_FLOAT, Bitmap::FORMAT_R_UINT16);
+}
+
+TEST(BitmapTest, ConvertRGB8ToRGBA8StaysInLastRow)
+{
+    // Widths where a 16-byte load of the SSSE3 kernel would end past the
+    // last row.
+    for (uint32_t width : {5u, 9u, 13u}) {
+        const uint32_t height   = 2;
+        const size_t   dataSize = static_cast<size_t>(width) * height * 3;
+
+#if defined(__linux__)
+        // The rows end right before a page that faults when read.
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        char*        pPages   = static_cast<char*>(mmap(nullptr, 2 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        ASSERT_NE(pPages, MAP_FAILED);
+        ASSERT_EQ(mprotect(pPages + pageSize, pageSize, PROT_NONE), 0);
+        char* pData = pPages + pageSize - dataSize;
+#else
+        std::vector<char> storage(dataSize);
+        char*             pData = storage.data();
+#endif
+        for (size_t i = 0; i < dataSize; ++i) {
+            pData[i] = static_cast<char>(i * 37);
+        }
+
+        Bitmap src;
+        ASSERT_EQ(Bitmap::Create(width, height, Bitmap::FORMAT_RGB_UINT8, pData, &src), SUCCESS);
+        Bitmap dst;
+        ASSERT_EQ(src.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &dst), SUCCESS);
+        EXPECT_EQ(GetValues<uint8_t>(dst), (ReferenceConvert<uint8_t, uint8_t>(src, Bitmap::FORMAT_RGBA_UINT8))) << width;
+
+#if defined(__linux__)
+        munmap(pPages, 2 * pageSize);
+#endif
+    }
+}
+
+TEST(BitmapTest, ConvertRoundTrips)
+{
+    std::vector<uint8_t> values(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+        values[i] = static_cast<uint8_t>(i);
+    }
+    Bitmap src = CreateBitmap(64, 4, Bitmap::FORMAT_R_UINT8, values);
+
+    for (Bitmap::Format format : {Bitmap::FORMAT_R_UINT16, Bitmap::FORMAT_R_FLOAT}) {
+        Bitmap wide;
+        Bitmap narrow;
+        ASSERT_EQ(src.ConvertTo(format, &wide), SUCCESS);
+        ASSERT_EQ(wide.ConvertTo(Bitmap::FORMAT_R_UINT8, &narrow), SUCCESS);
+        EXPECT_EQ(GetValues<uint8_t>(narrow), values);
+    }
+}
+
+TEST(BitmapTest, ConvertReusesTarget)
+{
+    Bitmap src = CreateRandomBitmap<uint8_t>(16, 8, Bitmap::FORMAT_RGBA_UINT8, 3);
+    Bitmap dst;
+    ASSERT_EQ(Bitmap::Create(16, 8, Bitmap::FORMAT_RGBA_FLOAT, &dst), SUCCESS);
+    const char* pData = dst.GetData();
+    ASSERT_EQ(src.ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, &dst), SUCCESS);
+    EXPECT_EQ(dst.GetData(), pData);
+
+    ASSERT_EQ(src.ConvertTo(Bitmap::FORMAT_RGB_UINT16, &dst), SUCCESS);
+    EXPECT_EQ(dst.GetFormat(), Bitmap::FORMAT_RGB_UINT16);
+    EXPECT_EQ(dst.GetWidth(), 16u);
+    EXPECT_EQ(dst.GetHeight(), 8u);
+}
+
+TEST(BitmapTest, ConvertInvalidArguments)
+{
+    Bitmap src = CreateRandomBitmap<uint8_t>(8, 8, Bitmap::FORMAT_RGBA_UINT8, 1);
+    Bitmap dst;
+    EXPECT_EQ(src.ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, nullptr), ERROR_UNEXPECTED_NULL_ARGUMENT);
+    EXPECT_EQ(src.ConvertTo(Bitmap::FORMAT_RGBA_UINT32, &dst), ERROR_IMAGE_INVALID_FORMAT);
+    EXPECT_EQ(src.ConvertTo(Bitmap::FORMAT_UNDEFINED, &dst), ERROR_IMAGE_INVALID_FORMAT);
+    EXPECT_EQ(Bitmap().ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, &dst), ERROR_BITMAP_BAD_COPY_SOURCE);
+}
+
+} // namespace
+} // namespace ppx
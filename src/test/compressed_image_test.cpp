@@ -0,0 +1,264 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "temp_directory_fixture.h"
+
+#include "ppx/compressed_image.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace ppx {
+namespace {
+
+const CompressedImage::Format kFormats[] = {
+    CompressedImage::FORMAT_BC1,
+    CompressedImage::FORMAT_BC3,
+    CompressedImage::FORMAT_BC4,
+    CompressedImage::FORMAT_BC5,
+    CompressedImage::FORMAT_BC7,
+};
+
+const CompressedImage::Quality kQualities[] = {
+    CompressedImage::QUALITY_FAST,
+    CompressedImage::QUALITY_NORMAL,
+    CompressedImage::QUALITY_HIGH,
+};
+
+// Smooth gradients with a little noise and a hard edge, which is closer to
+// real textures than random noise.
+Bitmap CreateTestBitmap(uint32_t width, uint32_t height)
+{
+    Bitmap bitmap;
+    EXPECT_EQ(Bitmap::Create(width, height, Bitmap::FORMAT_RGBA_UINT8, &bitmap), SUCCESS);
+    uint32_t state = 1;
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* pRow = reinterpret_cast<uint8_t*>(bitmap.GetData() + y * bitmap.GetRowStride());
+        for (uint32_t x = 0; x < width; ++x) {
+            state       = state * 1664525u + 1013904223u;
+            int noise   = static_cast<int>(state >> 29) - 4;
+            int edge    = (x > width / 2) ? 60 : 0;
+            pRow[4 * x] = static_cast<uint8_t>(std::clamp(static_cast<int>(x * 255 / width) + noise, 0, 255));
+            pRow[4 * x + 1] = static_cast<uint8_t>(std::clamp(static_cast<int>(y * 255 / height) + edge, 0, 255));
+            pRow[4 * x + 2] = static_cast<uint8_t>(std::clamp(128 + static_cast<int>(60.0 * std::sin(0.2 * (x + y))), 0, 255));
+            pRow[4 * x + 3] = static_cast<uint8_t>(std::clamp(255 - static_cast<int>(y * 200 / height) - noise, 0, 255));
+        }
+    }
+    return bitmap;
+}
+
+double EncodeAndMeasure(const Bitmap& bitmap, CompressedImage::Format format, CompressedImage::Quality quality)
+{
+    CompressedImage image;
+    EXPECT_EQ(CompressedImage::Encode(bitmap, format, quality, &image), SUCCESS);
+    double psnr = 0.0;
+    EXPECT_EQ(image.ComputePSNR(0, bitmap, &psnr), SUCCESS);
+    return psnr;
+}
+
+// Tests that write files. gtest does not allow TEST and TEST_F in one suite.
+using CompressedImageFileTest = TempDirectoryTestFixture;
+
+TEST(CompressedImageTest, LevelLayout)
+{
+    Bitmap bitmap = CreateTestBitmap(10, 6);
+
+    CompressedImage image;
+    ASSERT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_BC1, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+    ASSERT_TRUE(image.IsOk());
+    EXPECT_EQ(image.GetLevelCount(), 1u);
+    EXPECT_EQ(image.GetWidth(0), 10u);
+    EXPECT_EQ(image.GetHeight(0), 6u);
+    EXPECT_EQ(image.GetRowStride(0), 3u * 8u);
+    EXPECT_EQ(image.GetLevelSize(0), 3u * 2u * 8u);
+
+    Mipmap mipmap(CreateTestBitmap(64, 32), PPX_REMAINING_MIP_LEVELS);
+    ASSERT_EQ(CompressedImage::Encode(mipmap, CompressedImage::FORMAT_BC7, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+    ASSERT_EQ(image.GetLevelCount(), mipmap.GetLevelCount());
+    uint64_t offset = 0;
+    for (uint32_t level = 0; level < image.GetLevelCount(); ++level) {
+        EXPECT_EQ(image.GetWidth(level), mipmap.GetMip(level)->GetWidth());
+        EXPECT_EQ(image.GetHeight(level), mipmap.GetMip(level)->GetHeight());
+        EXPECT_EQ(image.GetLevelData(level), image.GetLevelData(0) + offset);
+        offset += image.GetLevelSize(level);
+    }
+    EXPECT_EQ(image.GetDataSize(), offset);
+
+    ASSERT_EQ(CompressedImage::Encode(mipmap, CompressedImage::FORMAT_BC4, CompressedImage::QUALITY_FAST, &image, 2), SUCCESS);
+    EXPECT_EQ(image.GetLevelCount(), 2u);
+}
+
+TEST(CompressedImageTest, PSNRAboveThresholds)
+{
+    Bitmap bitmap = CreateTestBitmap(64, 64);
+
+    // Lower bounds for the FAST preset; the others must not do worse.
+    const double thresholds[] = {31.0, 32.0, 48.0, 48.0, 32.0};
+    for (size_t i = 0; i < std::size(kFormats); ++i) {
+        double previous = 0.0;
+        for (CompressedImage::Quality quality : kQualities) {
+            double psnr = EncodeAndMeasure(bitmap, kFormats[i], quality);
+            EXPECT_GT(psnr, thresholds[i]) << CompressedImage::ToString(kFormats[i]) << " quality " << quality;
+            EXPECT_GE(psnr, previous - 0.05) << CompressedImage::ToString(kFormats[i]) << " quality " << quality;
+            previous = psnr;
+        }
+    }
+}
+
+TEST(CompressedImageTest, ConstantBlocksAreExact)
+{
+    // Colors that BC1 can represent exactly in RGB565.
+    Bitmap bitmap;
+    ASSERT_EQ(Bitmap::Create(8, 8, Bitmap::FORMAT_RGBA_UINT8, &bitmap), SUCCESS);
+    bitmap.Fill<uint8_t>(255, 0, 255, 255);
+
+    const CompressedImage::Format exactFormats[] = {
+        CompressedImage::FORMAT_BC1,
+        CompressedImage::FORMAT_BC3,
+        CompressedImage::FORMAT_BC4,
+        CompressedImage::FORMAT_BC5,
+    };
+    for (CompressedImage::Format format : exactFormats) {
+        for (CompressedImage::Quality quality : kQualities) {
+            EXPECT_TRUE(std::isinf(EncodeAndMeasure(bitmap, format, quality))) << CompressedImage::ToString(format);
+        }
+    }
+
+    // Mode 6 shares one p-bit across the channels of an endpoint, so a color
+    // mixing odd and even values is off by at most one step.
+    for (CompressedImage::Quality quality : kQualities) {
+        EXPECT_GT(EncodeAndMeasure(bitmap, CompressedImage::FORMAT_BC7, quality), 48.0);
+    }
+
+    // Any 8-bit value is exact in BC4 and BC5.
+    bitmap.Fill<uint8_t>(37, 201, 90, 133);
+    for (CompressedImage::Format format : {CompressedImage::FORMAT_BC4, CompressedImage::FORMAT_BC5}) {
+        EXPECT_TRUE(std::isinf(EncodeAndMeasure(bitmap, format, CompressedImage::QUALITY_NORMAL))) << CompressedImage::ToString(format);
+    }
+}
+
+TEST(CompressedImageTest, DecodedChannels)
+{
+    Bitmap bitmap;
+    ASSERT_EQ(Bitmap::Create(4, 4, Bitmap::FORMAT_RGBA_UINT8, &bitmap), SUCCESS);
+    bitmap.Fill<uint8_t>(255, 0, 255, 0);
+
+    CompressedImage image;
+    Bitmap          decoded;
+    ASSERT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_BC4, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+    ASSERT_EQ(image.Decode(0, &decoded), SUCCESS);
+    EXPECT_EQ(memcmp(decoded.GetData(), "\xFF\x00\x00\xFF", 4), 0);
+
+    ASSERT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_BC1, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+    ASSERT_EQ(image.Decode(0, &decoded), SUCCESS);
+    EXPECT_EQ(memcmp(decoded.GetData(), "\xFF\x00\xFF\xFF", 4), 0);
+
+    ASSERT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_BC3, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+    ASSERT_EQ(image.Decode(0, &decoded), SUCCESS);
+    EXPECT_EQ(memcmp(decoded.GetData(), "\xFF\x00\xFF\x00", 4), 0);
+}
+
+TEST(CompressedImageTest, ThreadCountDoesNotChangeOutput)
+{
+    Bitmap bitmap = CreateTestBitmap(256, 200);
+    for (CompressedImage::Format format : kFormats) {
+        CompressedImage single;
+        CompressedImage parallel;
+        ASSERT_EQ(CompressedImage::Encode(bitmap, format, CompressedImage::QUALITY_NORMAL, &single, 1), SUCCESS);
+        ASSERT_EQ(CompressedImage::Encode(bitmap, format, CompressedImage::QUALITY_NORMAL, &parallel, 7), SUCCESS);
+        ASSERT_EQ(single.GetDataSize(), parallel.GetDataSize());
+        EXPECT_EQ(memcmp(single.GetLevelData(0), parallel.GetLevelData(0), single.GetDataSize()), 0) << CompressedImage::ToString(format);
+    }
+}
+
+TEST(CompressedImageTest, ConvertsSourceFormat)
+{
+    Bitmap rgba8 = CreateTestBitmap(16, 16);
+    Bitmap rgbaFloat;
+    ASSERT_EQ(rgba8.ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, &rgbaFloat), SUCCESS);
+
+    CompressedImage fromRGBA8;
+    CompressedImage fromFloat;
+    ASSERT_EQ(CompressedImage::Encode(rgba8, CompressedImage::FORMAT_BC7, CompressedImage::QUALITY_NORMAL, &fromRGBA8), SUCCESS);
+    ASSERT_EQ(CompressedImage::Encode(rgbaFloat, CompressedImage::FORMAT_BC7, CompressedImage::QUALITY_NORMAL, &fromFloat), SUCCESS);
+    EXPECT_EQ(memcmp(fromRGBA8.GetLevelData(0), fromFloat.GetLevelData(0), fromRGBA8.GetDataSize()), 0);
+}
+
+TEST_F(CompressedImageFileTest, DDSRoundTrip)
+{
+    Mipmap mipmap(CreateTestBitmap(32, 16), PPX_REMAINING_MIP_LEVELS);
+    for (CompressedImage::Format format : kFormats) {
+        CompressedImage image;
+        ASSERT_EQ(CompressedImage::Encode(mipmap, format, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+
+        std::filesystem::path path = mDirectory / (std::string(CompressedImage::ToString(format)) + ".dds");
+        ASSERT_EQ(image.SaveDDS(path), SUCCESS);
+        EXPECT_EQ(std::filesystem::file_size(path), 4u + 124u + 20u + image.GetDataSize());
+
+        CompressedImage loaded;
+        ASSERT_EQ(CompressedImage::LoadDDS(path, &loaded), SUCCESS);
+        EXPECT_EQ(loaded.GetFormat(), format);
+        ASSERT_EQ(loaded.GetLevelCount(), image.GetLevelCount());
+        EXPECT_EQ(loaded.GetWidth(0), 32u);
+        EXPECT_EQ(loaded.GetHeight(0), 16u);
+        ASSERT_EQ(loaded.GetDataSize(), image.GetDataSize());
+        EXPECT_EQ(memcmp(loaded.GetLevelData(0), image.GetLevelData(0), image.GetDataSize()), 0);
+    }
+
+    // Truncated file.
+    std::filesystem::path bc7Path = mDirectory / "bc7.dds";
+    std::filesystem::resize_file(bc7Path, std::filesystem::file_size(bc7Path) - 1);
+    CompressedImage loaded;
+    EXPECT_EQ(CompressedImage::LoadDDS(bc7Path, &loaded), ERROR_IMAGE_FILE_LOAD_FAILED);
+
+    // Widths near 2^32 must not wrap to levels without blocks. The width
+    // follows the magic, the header size, the flags and the height.
+    CompressedImage singleLevel;
+    ASSERT_EQ(CompressedImage::Encode(CreateTestBitmap(8, 8), CompressedImage::FORMAT_BC1, CompressedImage::QUALITY_FAST, &singleLevel), SUCCESS);
+    std::filesystem::path singleLevelPath = mDirectory / "single_level.dds";
+    ASSERT_EQ(singleLevel.SaveDDS(singleLevelPath), SUCCESS);
+    {
+        std::fstream   file(singleLevelPath, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t width = 0xFFFFFFFF;
+        file.seekp(16);
+        file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+    }
+    EXPECT_NE(CompressedImage::LoadDDS(singleLevelPath, &loaded), SUCCESS);
+
+    // Not a DDS file.
+    std::filesystem::path textPath = mDirectory / "text.dds";
+    std::ofstream(textPath) << "not a dds file";
+    EXPECT_EQ(CompressedImage::LoadDDS(textPath, &loaded), ERROR_IMAGE_FILE_LOAD_FAILED);
+}
+
+TEST(CompressedImageTest, InvalidArguments)
+{
+    Bitmap          bitmap = CreateTestBitmap(8, 8);
+    CompressedImage image;
+    EXPECT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_BC1, CompressedImage::QUALITY_FAST, nullptr), ERROR_UNEXPECTED_NULL_ARGUMENT);
+    EXPECT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_UNDEFINED, CompressedImage::QUALITY_FAST, &image), ERROR_IMAGE_INVALID_FORMAT);
+    EXPECT_EQ(CompressedImage::Encode(Bitmap(), CompressedImage::FORMAT_BC1, CompressedImage::QUALITY_FAST, &image), ERROR_BITMAP_BAD_COPY_SOURCE);
+    EXPECT_FALSE(image.IsOk());
+
+    ASSERT_EQ(CompressedImage::Encode(bitmap, CompressedImage::FORMAT_BC1, CompressedImage::QUALITY_FAST, &image), SUCCESS);
+    double psnr = 0.0;
+    EXPECT_EQ(image.ComputePSNR(1, bitmap, &psnr), ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(image.ComputePSNR(0, CreateTestBitmap(4, 4), &psnr), ERROR_BITMAP_FOOTPRINT_MISMATCH);
+    EXPECT_EQ(image.Decode(0, nullptr), ERROR_UNEXPECTED_NULL_ARGUMENT);
+}
+
+} // namespace
+} // namespace ppx
@@ -190,5 +190,79 @@ TEST_F(FsTest, CloseFileDescriptorOnScopeEnd)
     EXPECT_EQ(getOpenFDCount(), fdCountBefore);
 }
 
+TEST_F(FsTest, RegularFileIsMapped)
+{
+    fs::File file;
+    EXPECT_TRUE(file.Open(readableFile, fs::File::ACCESS_PATTERN_SEQUENTIAL));
+    ASSERT_TRUE(file.IsMapped());
+
+    std::string_view content(reinterpret_cast<const char*>(file.GetMappedData()), file.GetLength());
+    EXPECT_EQ(content, kDefaultFileContent);
+}
+
+TEST_F(FsTest, EmptyFileIsReadableButNotMapped)
+{
+    FILE* emptyFileHandle = tmpfile();
+    ASSERT_NE(emptyFileHandle, nullptr);
+    std::filesystem::path emptyFile = std::filesystem::path("/proc/self/fd/") / std::to_string(fileno(emptyFileHandle));
+
+    {
+        fs::File file;
+        EXPECT_TRUE(file.Open(emptyFile));
+        EXPECT_TRUE(file.IsValid());
+        EXPECT_FALSE(file.IsMapped());
+        EXPECT_EQ(file.GetLength(), 0);
+    }
+
+    auto view = fs::load_file_view(emptyFile);
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(view->GetSize(), 0);
+
+    fclose(emptyFileHandle);
+}
+
+TEST_F(FsTest, LoadFileViewBorrowsMapping)
+{
+    auto view = fs::load_file_view(readableFile);
+    ASSERT_TRUE(view.has_value());
+    EXPECT_TRUE(view->IsMapped());
+    EXPECT_EQ(std::string_view(view->GetData(), view->GetSize()), kDefaultFileContent);
+
+    // Moving the view keeps the data valid.
+    fs::FileView moved = std::move(view.value());
+    EXPECT_EQ(std::string_view(moved.GetData(), moved.GetSize()), kDefaultFileContent);
+}
+
+TEST_F(FsTest, LoadFileViewNonExistantFileFails)
+{
+    EXPECT_FALSE(fs::load_file_view(nonExistantFile).has_value());
+}
+
+TEST_F(FsTest, FileStreamReadsContent)
+{
+    fs::FileStream stream;
+    ASSERT_TRUE(stream.Open(readableFile.c_str()));
+
+    std::istream istr(&stream);
+    std::string  first;
+    std::string  second;
+    istr >> first >> second;
+    EXPECT_EQ(first, "some");
+    EXPECT_EQ(second, "content");
+}
+
+TEST_F(FsTest, CloseMappingOnScopeEnd)
+{
+    const size_t fdCountBefore = getOpenFDCount();
+
+    {
+        auto view = fs::load_file_view(readableFile);
+        ASSERT_TRUE(view.has_value());
+        EXPECT_EQ(getOpenFDCount(), fdCountBefore + 1);
+    }
+
+    EXPECT_EQ(getOpenFDCount(), fdCountBefore);
+}
+
 } // namespace ppx
 #endif
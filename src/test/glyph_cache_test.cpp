@@ -0,0 +1,218 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/glyph_cache.h"
+
+#include <vector>
+
+namespace ppx {
+namespace {
+
+// Fills the glyph area with the low byte of the codepoint.
+void FillWithCodepoint(uint32_t codepoint, uint32_t width, uint32_t height, uint32_t rowStride, unsigned char* pOutput)
+{
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            pOutput[y * rowStride + x] = static_cast<unsigned char>(codepoint);
+        }
+    }
+}
+
+// 2x2 cells of 8x8 pixels.
+GlyphCacheCreateInfo SmallCacheCreateInfo()
+{
+    GlyphCacheCreateInfo createInfo = {};
+    createInfo.width                = 16;
+    createInfo.height               = 16;
+    createInfo.cellWidth            = 8;
+    createInfo.cellHeight           = 8;
+    createInfo.padding              = 1;
+    createInfo.rasterize            = FillWithCodepoint;
+    return createInfo;
+}
+
+} // namespace
+
+TEST(GlyphCacheTest, AcquireRasterizesOnce)
+{
+    GlyphCache cache;
+    ASSERT_EQ(cache.Create(SmallCacheCreateInfo()), SUCCESS);
+    EXPECT_EQ(cache.GetSlotCount(), 4u);
+
+    bool           inserted = false;
+    const uint32_t slot     = cache.Acquire('A', 3, 5, &inserted);
+    ASSERT_NE(slot, GlyphCache::kInvalidSlot);
+    EXPECT_TRUE(inserted);
+    EXPECT_FALSE(cache.IsResident(slot));
+    EXPECT_EQ(cache.Acquire('A', 3, 5, &inserted), slot);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+    EXPECT_EQ(cache.GetMissCount(), 1u);
+
+    cache.WaitIdle();
+    std::vector<RasterizedGlyph> glyphs;
+    EXPECT_EQ(cache.TakeRasterizedGlyphs(10, &glyphs), 1u);
+    ASSERT_EQ(glyphs.size(), 1u);
+    EXPECT_TRUE(cache.IsResident(slot));
+
+    // The glyph sits inside the padding of its cell, the rest is zero.
+    const RasterizedGlyph& glyph = glyphs[0];
+    const AtlasRect&       rect  = cache.GetGlyphRect(slot);
+    EXPECT_EQ(glyph.cellRect.width, 8u);
+    EXPECT_EQ(glyph.cellRect.height, 8u);
+    EXPECT_EQ(rect.x, glyph.cellRect.x + 1);
+    EXPECT_EQ(rect.y, glyph.cellRect.y + 1);
+    for (uint32_t y = 0; y < 8; ++y) {
+        for (uint32_t x = 0; x < 8; ++x) {
+            const bool inside = (x >= 1) && (x < 4) && (y >= 1) && (y < 6);
+            EXPECT_EQ(glyph.pixels[y * 8 + x], inside ? 'A' : 0) << "x=" << x << " y=" << y;
+        }
+    }
+
+    const AtlasUVRect& uvRect = cache.GetGlyphUVRect(slot);
+    EXPECT_FLOAT_EQ(uvRect.u0, rect.x / 16.0f);
+    EXPECT_FLOAT_EQ(uvRect.v1, (rect.y + 5) / 16.0f);
+}
+
+TEST(GlyphCacheTest, EvictsLeastRecentlyUsed)
+{
+    GlyphCache cache;
+    ASSERT_EQ(cache.Create(SmallCacheCreateInfo()), SUCCESS);
+
+    uint32_t slots[4] = {};
+    for (uint32_t i = 0; i < 4; ++i) {
+        slots[i] = cache.Acquire('a' + i, 4, 4);
+    }
+    cache.NextFrame();
+    cache.NextFrame();
+
+    // Use 'a' again, so that 'b' is the least recently used glyph.
+    const uint32_t generationA = cache.GetGeneration(slots[0]);
+    EXPECT_TRUE(cache.Touch(slots[0], generationA));
+    cache.NextFrame();
+    cache.NextFrame();
+
+    const uint32_t generationB = cache.GetGeneration(slots[1]);
+    const uint32_t slotE       = cache.Acquire('e', 4, 4);
+    EXPECT_EQ(slotE, slots[1]);
+    EXPECT_EQ(cache.GetEvictionCount(), 1u);
+    EXPECT_EQ(cache.Find('b'), GlyphCache::kInvalidSlot);
+    EXPECT_EQ(cache.Find('a'), slots[0]);
+    EXPECT_FALSE(cache.Touch(slots[1], generationB));
+    EXPECT_EQ(cache.GetGlyphCount(), 4u);
+}
+
+TEST(GlyphCacheTest, KeepsGlyphsOfRecentFrames)
+{
+    GlyphCache cache;
+    ASSERT_EQ(cache.Create(SmallCacheCreateInfo()), SUCCESS);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        ASSERT_NE(cache.Acquire('a' + i, 4, 4), GlyphCache::kInvalidSlot);
+    }
+    // Full of glyphs used by the current frame, then by the previous one.
+    EXPECT_EQ(cache.Acquire('e', 4, 4), GlyphCache::kInvalidSlot);
+    cache.NextFrame();
+    EXPECT_EQ(cache.Acquire('e', 4, 4), GlyphCache::kInvalidSlot);
+    cache.NextFrame();
+    EXPECT_NE(cache.Acquire('e', 4, 4), GlyphCache::kInvalidSlot);
+}
+
+TEST(GlyphCacheTest, DropsGlyphsEvictedBeforeUpload)
+{
+    GlyphCache cache;
+    ASSERT_EQ(cache.Create(SmallCacheCreateInfo()), SUCCESS);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        cache.Acquire('a' + i, 4, 4);
+    }
+    cache.NextFrame();
+    cache.NextFrame();
+    const uint32_t slot = cache.Acquire('e', 4, 4);
+    ASSERT_NE(slot, GlyphCache::kInvalidSlot);
+    cache.WaitIdle();
+
+    // 'a' was rasterized, but its slot now holds 'e'.
+    std::vector<RasterizedGlyph> glyphs;
+    EXPECT_EQ(cache.TakeRasterizedGlyphs(2, &glyphs), 2u);
+    EXPECT_EQ(glyphs[0].pixels[9], 'b');
+    EXPECT_EQ(glyphs[1].pixels[9], 'c');
+    EXPECT_EQ(cache.TakeRasterizedGlyphs(10, &glyphs), 2u);
+    EXPECT_EQ(glyphs[3].slot, slot);
+    EXPECT_EQ(glyphs[3].pixels[9], 'e');
+}
+
+TEST(GlyphCacheTest, EvictionRewritesGlyphRects)
+{
+    GlyphCache cache;
+    ASSERT_EQ(cache.Create(SmallCacheCreateInfo()), SUCCESS);
+
+    uint32_t slots[4] = {};
+    for (uint32_t i = 0; i < 4; ++i) {
+        slots[i] = cache.Acquire('a' + i, 4, 4);
+    }
+    cache.WaitIdle();
+    std::vector<RasterizedGlyph> glyphs;
+    EXPECT_EQ(cache.TakeRasterizedGlyphs(10, &glyphs), 4u);
+    cache.NextFrame();
+    cache.NextFrame();
+
+    // 'e' takes the slot of 'a', with another size.
+    const uint32_t slot = cache.Acquire('e', 6, 3);
+    ASSERT_EQ(slot, slots[0]);
+    EXPECT_FALSE(cache.IsResident(slot));
+
+    const AtlasRect&   rect   = cache.GetGlyphRect(slot);
+    const AtlasUVRect& uvRect = cache.GetGlyphUVRect(slot);
+    EXPECT_EQ(rect.width, 6u);
+    EXPECT_EQ(rect.height, 3u);
+    EXPECT_FLOAT_EQ(uvRect.u0, rect.x / 16.0f);
+    EXPECT_FLOAT_EQ(uvRect.u1, (rect.x + 6) / 16.0f);
+    EXPECT_FLOAT_EQ(uvRect.v0, rect.y / 16.0f);
+    EXPECT_FLOAT_EQ(uvRect.v1, (rect.y + 3) / 16.0f);
+
+    // The upload covers the whole cell, so no pixel of 'a' is left.
+    cache.WaitIdle();
+    glyphs.clear();
+    EXPECT_EQ(cache.TakeRasterizedGlyphs(10, &glyphs), 1u);
+    ASSERT_EQ(glyphs.size(), 1u);
+    EXPECT_EQ(glyphs[0].slot, slot);
+    for (uint32_t y = 0; y < 8; ++y) {
+        for (uint32_t x = 0; x < 8; ++x) {
+            const bool inside = (x >= 1) && (x < 7) && (y >= 1) && (y < 4);
+            EXPECT_EQ(glyphs[0].pixels[y * 8 + x], inside ? 'e' : 0) << "x=" << x << " y=" << y;
+        }
+    }
+    EXPECT_TRUE(cache.IsResident(slot));
+}
+
+TEST(GlyphCacheTest, CreateRejectsInvalidArguments)
+{
+    GlyphCacheCreateInfo createInfo = SmallCacheCreateInfo();
+    createInfo.cellWidth            = 2;
+    GlyphCache cache;
+    EXPECT_EQ(cache.Create(createInfo), ERROR_INVALID_CREATE_ARGUMENT);
+
+    createInfo           = SmallCacheCreateInfo();
+    createInfo.cellWidth = 32;
+    EXPECT_EQ(cache.Create(createInfo), ERROR_INVALID_CREATE_ARGUMENT);
+
+    createInfo           = SmallCacheCreateInfo();
+    createInfo.rasterize = nullptr;
+    EXPECT_EQ(cache.Create(createInfo), ERROR_INVALID_CREATE_ARGUMENT);
+}
+
+} // namespace ppx
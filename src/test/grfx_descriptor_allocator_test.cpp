@@ -0,0 +1,234 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/grfx/grfx_descriptor_allocator.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <set>
+
+namespace ppx {
+namespace grfx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fakes
+////////////////////////////////////////////////////////////////////////////////
+
+// The allocator only passes pools and sets around, so these have no API
+// objects and no device.
+class FakeDescriptorPool : public DescriptorPool
+{
+protected:
+    Result CreateApiObjects(const DescriptorPoolCreateInfo* pCreateInfo) override { return SUCCESS; }
+    void   DestroyApiObjects() override {}
+};
+
+class FakeDescriptorSet : public DescriptorSet
+{
+public:
+    explicit FakeDescriptorSet(const DescriptorSetLayout* pLayout_)
+        : pLayout(pLayout_) {}
+
+    const DescriptorSetLayout* pLayout = nullptr;
+
+protected:
+    Result CreateApiObjects(const internal::DescriptorSetCreateInfo* pCreateInfo) override { return SUCCESS; }
+    void   DestroyApiObjects() override {}
+    Result UpdateApiDescriptors(uint32_t writeCount, const WriteDescriptor* pWrites) override { return SUCCESS; }
+};
+
+class FakeDescriptorSetLayout : public DescriptorSetLayout
+{
+public:
+    explicit FakeDescriptorSetLayout(DescriptorType type)
+    {
+        DescriptorSetLayoutCreateInfo createInfo = {};
+        createInfo.bindings.push_back(DescriptorBinding(0, type));
+        EXPECT_EQ(Create(&createInfo), SUCCESS);
+    }
+
+protected:
+    Result CreateApiObjects(const DescriptorSetLayoutCreateInfo* pCreateInfo) override { return SUCCESS; }
+    void   DestroyApiObjects() override {}
+};
+
+class TestAllocator : public FrameDescriptorAllocator
+{
+public:
+    uint32_t mAllocatedSetCount = 0;
+    uint32_t mFreedSetCount     = 0;
+
+protected:
+    Result CreatePool(const DescriptorPoolCreateInfo* pCreateInfo, DescriptorPool** ppPool) override
+    {
+        mPools.push_back(std::make_unique<FakeDescriptorPool>());
+        *ppPool = mPools.back().get();
+        return SUCCESS;
+    }
+
+    void DestroyPool(DescriptorPool* pPool) override {}
+
+    Result AllocateSet(DescriptorPool* pPool, const DescriptorSetLayout* pLayout, DescriptorSet** ppSet) override
+    {
+        mSets.push_back(std::make_unique<FakeDescriptorSet>(pLayout));
+        *ppSet = mSets.back().get();
+        mAllocatedSetCount += 1;
+        return SUCCESS;
+    }
+
+    void FreeSet(DescriptorSet* pSet) override { mFreedSetCount += 1; }
+
+private:
+    std::vector<std::unique_ptr<FakeDescriptorPool>> mPools;
+    std::vector<std::unique_ptr<FakeDescriptorSet>>  mSets;
+};
+
+class FrameDescriptorAllocatorTest : public ::testing::Test
+{
+protected:
+    // Pages of two sets, with room for uniform buffers and samplers.
+    void Create(uint32_t frameCount)
+    {
+        FrameDescriptorAllocatorCreateInfo createInfo = {};
+        createInfo.frameCount                         = frameCount;
+        createInfo.pageSize.uniformBuffer             = 16;
+        createInfo.pageSize.sampler                   = 16;
+        createInfo.maxSetsPerPage                     = 2;
+        ASSERT_EQ(mAllocator.Create(nullptr, &createInfo), SUCCESS);
+    }
+
+    void TearDown() override { mAllocator.Destroy(); }
+
+    std::vector<DescriptorSet*> Allocate(const std::vector<const DescriptorSetLayout*>& layouts)
+    {
+        std::vector<DescriptorSet*> sets;
+        for (const DescriptorSetLayout* pLayout : layouts) {
+            DescriptorSet* pSet = nullptr;
+            EXPECT_EQ(mAllocator.AllocateDescriptorSet(pLayout, &pSet), SUCCESS);
+            EXPECT_EQ(static_cast<FakeDescriptorSet*>(pSet)->pLayout, pLayout);
+            sets.push_back(pSet);
+        }
+        // A set is handed out once per frame.
+        EXPECT_EQ(std::set<DescriptorSet*>(sets.begin(), sets.end()).size(), sets.size());
+        return sets;
+    }
+
+    TestAllocator mAllocator;
+};
+
+} // namespace
+
+TEST_F(FrameDescriptorAllocatorTest, BeginFrameRecyclesSetsOfThatFrame)
+{
+    Create(2);
+    FakeDescriptorSetLayout layout(DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+
+    mAllocator.BeginFrame(0);
+    std::vector<DescriptorSet*> frame0 = Allocate({&layout, &layout, &layout});
+    EXPECT_EQ(mAllocator.GetFrameSetCount(), 3u);
+
+    mAllocator.BeginFrame(1);
+    EXPECT_EQ(mAllocator.GetFrameSetCount(), 0u);
+    std::vector<DescriptorSet*> frame1 = Allocate({&layout, &layout, &layout});
+    EXPECT_EQ(mAllocator.mAllocatedSetCount, 6u);
+    for (DescriptorSet* pSet : frame1) {
+        EXPECT_EQ(std::count(frame0.begin(), frame0.end(), pSet), 0);
+    }
+
+    // Frame 0 gets its sets back, and allocates only what it did not use before.
+    mAllocator.BeginFrame(0);
+    std::vector<DescriptorSet*> frame0Again = Allocate({&layout, &layout, &layout, &layout});
+    EXPECT_EQ(std::vector<DescriptorSet*>(frame0Again.begin(), frame0Again.begin() + 3), frame0);
+    EXPECT_EQ(mAllocator.mAllocatedSetCount, 7u);
+}
+
+TEST_F(FrameDescriptorAllocatorTest, InterleavedLayoutsReuseSetsOfAllPages)
+{
+    Create(1);
+    FakeDescriptorSetLayout layoutA(DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    FakeDescriptorSetLayout layoutB(DESCRIPTOR_TYPE_SAMPLER);
+
+    // Sets of A fill the first page, and the sets of B start on the second.
+    mAllocator.BeginFrame(0);
+    Allocate({&layoutA, &layoutA, &layoutA, &layoutB, &layoutB, &layoutB});
+    const uint32_t pageCount = mAllocator.GetPageCount();
+    const uint32_t setCount  = mAllocator.mAllocatedSetCount;
+    EXPECT_EQ(pageCount, 3u);
+    EXPECT_EQ(setCount, 6u);
+
+    // Requesting the layouts in other orders recycles the same sets.
+    const std::vector<const DescriptorSetLayout*> orders[] = {
+        {&layoutB, &layoutB, &layoutB, &layoutA, &layoutA, &layoutA},
+        {&layoutA, &layoutB, &layoutA, &layoutB, &layoutA, &layoutB},
+        {&layoutB, &layoutA, &layoutB, &layoutA, &layoutB, &layoutA},
+    };
+    for (uint32_t i = 0; i < 10; ++i) {
+        mAllocator.BeginFrame(0);
+        Allocate(orders[i % std::size(orders)]);
+        EXPECT_EQ(mAllocator.GetPageCount(), pageCount);
+        EXPECT_EQ(mAllocator.mAllocatedSetCount, setCount);
+    }
+}
+
+TEST_F(FrameDescriptorAllocatorTest, LayoutAtAddressOfDestroyedLayoutGetsItsOwnSets)
+{
+    Create(1);
+
+    // Both layouts are constructed in the same storage, so they have the
+    // same address.
+    alignas(FakeDescriptorSetLayout) unsigned char storage[sizeof(FakeDescriptorSetLayout)];
+
+    FakeDescriptorSetLayout* pLayout = new (storage) FakeDescriptorSetLayout(DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    mAllocator.BeginFrame(0);
+    Allocate({pLayout});
+    pLayout->~FakeDescriptorSetLayout();
+
+    pLayout = new (storage) FakeDescriptorSetLayout(DESCRIPTOR_TYPE_SAMPLER);
+    mAllocator.BeginFrame(0);
+    Allocate({pLayout});
+    pLayout->~FakeDescriptorSetLayout();
+    EXPECT_EQ(mAllocator.mAllocatedSetCount, 2u);
+}
+
+TEST_F(FrameDescriptorAllocatorTest, PagesOfDestroyedLayoutsAreReleased)
+{
+    Create(2);
+
+    // Layouts recreated every frame never get recycled sets. Their pages are
+    // released once a frame no longer uses them.
+    for (uint32_t i = 0; i < 32; ++i) {
+        FakeDescriptorSetLayout layoutA(DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        FakeDescriptorSetLayout layoutB(DESCRIPTOR_TYPE_SAMPLER);
+        mAllocator.BeginFrame(i % 2);
+        Allocate({&layoutA, &layoutA, &layoutB});
+        EXPECT_LE(mAllocator.GetPageCount(), 8u) << i;
+        EXPECT_LE(mAllocator.mAllocatedSetCount - mAllocator.mFreedSetCount, 16u) << i;
+    }
+
+    // A layout that is used every frame keeps its sets.
+    FakeDescriptorSetLayout layout(DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    mAllocator.BeginFrame(0);
+    std::vector<DescriptorSet*> sets = Allocate({&layout, &layout, &layout});
+    for (uint32_t i = 0; i < 4; ++i) {
+        mAllocator.BeginFrame(0);
+        EXPECT_EQ(Allocate({&layout, &layout, &layout}), sets);
+    }
+}
+
+} // namespace grfx
+} // namespace ppx
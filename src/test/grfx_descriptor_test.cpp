@@ -0,0 +1,180 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_descriptor.h"
+
+#include <vector>
+
+namespace ppx {
+namespace grfx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fakes
+////////////////////////////////////////////////////////////////////////////////
+
+// Descriptor writes only read the object id of a buffer.
+class FakeBuffer : public Buffer
+{
+public:
+    Result MapMemory(uint64_t offset, void** ppMappedAddress) override { return ERROR_FAILED; }
+    void   UnmapMemory() override {}
+
+protected:
+    Result CreateApiObjects(const BufferCreateInfo* pCreateInfo) override { return SUCCESS; }
+    void   DestroyApiObjects() override {}
+};
+
+// Records the writes that reach the API.
+class FakeDescriptorSet : public DescriptorSet
+{
+public:
+    std::vector<WriteDescriptor> apiWrites;
+
+protected:
+    Result CreateApiObjects(const internal::DescriptorSetCreateInfo* pCreateInfo) override { return SUCCESS; }
+    void   DestroyApiObjects() override {}
+
+    Result UpdateApiDescriptors(uint32_t writeCount, const WriteDescriptor* pWrites) override
+    {
+        apiWrites.insert(apiWrites.end(), pWrites, pWrites + writeCount);
+        return SUCCESS;
+    }
+};
+
+// Issues the writes of a flush without a device.
+class TestWriteBatch : public DescriptorWriteBatch
+{
+public:
+    std::vector<DescriptorSetWrite> issuedWrites;
+
+protected:
+    Result UpdateDescriptorSets(uint32_t writeCount, const DescriptorSetWrite* pWrites) override
+    {
+        for (uint32_t i = 0; i < writeCount; ++i) {
+            issuedWrites.push_back(pWrites[i]);
+            EXPECT_EQ(pWrites[i].pSet->UpdateDescriptors(1, &pWrites[i].write), SUCCESS);
+        }
+        return SUCCESS;
+    }
+};
+
+WriteDescriptor UniformBufferWrite(uint32_t binding, const Buffer* pBuffer, uint64_t offset)
+{
+    WriteDescriptor write = {};
+    write.binding         = binding;
+    write.type            = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.bufferOffset    = offset;
+    write.bufferRange     = 256;
+    write.pBuffer         = pBuffer;
+    return write;
+}
+
+} // namespace
+
+TEST(DescriptorSetTest, HelpersSkipWritesOfTheSameResource)
+{
+    FakeDescriptorSet set;
+    FakeBuffer        bufferA;
+    FakeBuffer        bufferB;
+
+    EXPECT_EQ(set.UpdateUniformBuffer(0, 0, &bufferA, 0, 256), SUCCESS);
+    EXPECT_EQ(set.UpdateUniformBuffer(0, 0, &bufferA, 0, 256), SUCCESS);
+    EXPECT_EQ(set.apiWrites.size(), 1u);
+
+    // A changed offset, buffer or binding is written.
+    EXPECT_EQ(set.UpdateUniformBuffer(0, 0, &bufferA, 256, 256), SUCCESS);
+    EXPECT_EQ(set.UpdateUniformBuffer(0, 0, &bufferB, 256, 256), SUCCESS);
+    EXPECT_EQ(set.UpdateUniformBuffer(1, 0, &bufferB, 256, 256), SUCCESS);
+    ASSERT_EQ(set.apiWrites.size(), 4u);
+    EXPECT_EQ(set.apiWrites[1].bufferOffset, 256u);
+    EXPECT_EQ(set.apiWrites[2].pBuffer, &bufferB);
+    EXPECT_EQ(set.apiWrites[3].binding, 1u);
+
+    // Writing a resource back is not a redundant write.
+    EXPECT_EQ(set.UpdateUniformBuffer(0, 0, &bufferA, 256, 256), SUCCESS);
+    EXPECT_EQ(set.apiWrites.size(), 5u);
+}
+
+TEST(DescriptorSetTest, LaterWriteOfAnUpdateReplacesEarlierOne)
+{
+    FakeDescriptorSet set;
+    FakeBuffer        buffer;
+
+    const WriteDescriptor writes[] = {
+        UniformBufferWrite(0, &buffer, 0),
+        UniformBufferWrite(0, &buffer, 256),
+    };
+    EXPECT_EQ(set.UpdateDescriptors(2, writes), SUCCESS);
+    ASSERT_EQ(set.apiWrites.size(), 1u);
+    EXPECT_EQ(set.apiWrites[0].bufferOffset, 256u);
+
+    // The first write changes the descriptor, but the second one writes it
+    // back to what it holds.
+    const WriteDescriptor writesBack[] = {
+        UniformBufferWrite(0, &buffer, 0),
+        UniformBufferWrite(0, &buffer, 256),
+    };
+    EXPECT_EQ(set.UpdateDescriptors(2, writesBack), SUCCESS);
+    EXPECT_EQ(set.apiWrites.size(), 1u);
+}
+
+TEST(DescriptorWriteBatchTest, LaterWriteReplacesEarlierOne)
+{
+    FakeDescriptorSet set;
+    FakeBuffer        buffer;
+    TestWriteBatch    batch;
+
+    batch.Write(&set, UniformBufferWrite(0, &buffer, 0));
+    batch.Write(&set, UniformBufferWrite(1, &buffer, 0));
+    batch.Write(&set, UniformBufferWrite(0, &buffer, 512));
+    EXPECT_EQ(batch.GetPendingCount(), 2u);
+
+    EXPECT_EQ(batch.Flush(), SUCCESS);
+    EXPECT_EQ(batch.GetPendingCount(), 0u);
+    ASSERT_EQ(batch.issuedWrites.size(), 2u);
+    EXPECT_EQ(batch.issuedWrites[0].write.binding, 0u);
+    EXPECT_EQ(batch.issuedWrites[0].write.bufferOffset, 512u);
+    EXPECT_EQ(batch.issuedWrites[1].write.binding, 1u);
+}
+
+TEST(DescriptorWriteBatchTest, FlushSkipsWritesOfTheSameResource)
+{
+    FakeDescriptorSet set;
+    FakeBuffer        buffer;
+    TestWriteBatch    batch;
+
+    batch.Write(&set, UniformBufferWrite(0, &buffer, 0));
+    EXPECT_EQ(batch.Flush(), SUCCESS);
+    EXPECT_EQ(batch.issuedWrites.size(), 1u);
+
+    // Descriptors written by the helpers are known to the batch too.
+    EXPECT_EQ(set.UpdateUniformBuffer(1, 0, &buffer, 0, 256), SUCCESS);
+    batch.Write(&set, UniformBufferWrite(0, &buffer, 0));
+    batch.Write(&set, UniformBufferWrite(1, &buffer, 0));
+    EXPECT_EQ(batch.Flush(), SUCCESS);
+    EXPECT_EQ(batch.issuedWrites.size(), 1u);
+
+    batch.Write(&set, UniformBufferWrite(0, &buffer, 256));
+    EXPECT_EQ(batch.Flush(), SUCCESS);
+    ASSERT_EQ(batch.issuedWrites.size(), 2u);
+    EXPECT_EQ(batch.issuedWrites[1].write.bufferOffset, 256u);
+    EXPECT_EQ(set.apiWrites.size(), 3u);
+}
+
+} // namespace grfx
+} // namespace ppx
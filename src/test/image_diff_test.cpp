@@ -0,0 +1,253 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/image_diff.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace ppx {
+namespace {
+
+Bitmap CreateRandomRGBA8(uint32_t width, uint32_t height, uint32_t seed)
+{
+    Bitmap bitmap;
+    EXPECT_EQ(Bitmap::Create(width, height, Bitmap::FORMAT_RGBA_UINT8, &bitmap), SUCCESS);
+    uint32_t state = seed;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint8_t* pPixel = bitmap.GetPixel8u(x, y);
+            for (uint32_t c = 0; c < 4; ++c) {
+                // Smooth gradients plus noise, so that SSIM is not dominated by noise.
+                state     = state * 1664525u + 1013904223u;
+                pPixel[c] = static_cast<uint8_t>((x * 3 + y * 5 + c * 40 + (state >> 28)) & 0xFF);
+            }
+        }
+    }
+    return bitmap;
+}
+
+// Adds a deterministic perturbation of up to +/- amplitude to every channel.
+Bitmap Perturb(const Bitmap& src, int amplitude, uint32_t seed)
+{
+    Bitmap dst;
+    EXPECT_EQ(Bitmap::Create(src.GetWidth(), src.GetHeight(), src.GetFormat(), &dst), SUCCESS);
+    uint32_t state = seed;
+    for (uint32_t y = 0; y < src.GetHeight(); ++y) {
+        for (uint32_t x = 0; x < src.GetWidth(); ++x) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                state     = state * 1664525u + 1013904223u;
+                int delta = static_cast<int>(state >> 16) % (2 * amplitude + 1) - amplitude;
+                int value = src.GetPixel8u(x, y)[c] + delta;
+
+                dst.GetPixel8u(x, y)[c] = static_cast<uint8_t>(std::clamp(value, 0, 255));
+            }
+        }
+    }
+    return dst;
+}
+
+// SSIM of one channel over 8x8 windows every 4 pixels, as documented.
+double ReferenceSSIM(const Bitmap& a, const Bitmap& b, uint32_t channel)
+{
+    const double c1    = 0.01 * 0.01;
+    const double c2    = 0.03 * 0.03;
+    double       sum   = 0;
+    uint32_t     count = 0;
+    for (uint32_t wy = 0; wy + 8 <= a.GetHeight(); wy += 4) {
+        for (uint32_t wx = 0; wx + 8 <= a.GetWidth(); wx += 4) {
+            double s1 = 0, s2 = 0, ss = 0, s12 = 0;
+            for (uint32_t y = wy; y < wy + 8; ++y) {
+                for (uint32_t x = wx; x < wx + 8; ++x) {
+                    double va = a.GetPixel8u(x, y)[channel] / 255.0;
+                    double vb = b.GetPixel8u(x, y)[channel] / 255.0;
+                    s1 += va;
+                    s2 += vb;
+                    ss += va * va + vb * vb;
+                    s12 += va * vb;
+                }
+            }
+            double mu1     = s1 / 64;
+            double mu2     = s2 / 64;
+            double sigmaSq = ss / 64 - mu1 * mu1 - mu2 * mu2;
+            double covar   = s12 / 64 - mu1 * mu2;
+            sum += (2 * mu1 * mu2 + c1) * (2 * covar + c2) / ((mu1 * mu1 + mu2 * mu2 + c1) * (sigmaSq + c2));
+            ++count;
+        }
+    }
+    return sum / count;
+}
+
+TEST(ImageDiffTest, IdenticalImages)
+{
+    Bitmap a = CreateRandomRGBA8(37, 29, 1);
+    Bitmap b = CreateRandomRGBA8(37, 29, 1);
+
+    ImageDiffStats stats;
+    ASSERT_EQ(CompareBitmaps(a, b, ImageDiffOptions(), &stats), SUCCESS);
+    EXPECT_EQ(stats.width, 37u);
+    EXPECT_EQ(stats.height, 29u);
+    EXPECT_EQ(stats.channelCount, 4u);
+    EXPECT_EQ(stats.differentPixelCount, 0u);
+    EXPECT_EQ(stats.psnr, std::numeric_limits<double>::infinity());
+    EXPECT_NEAR(stats.ssim, 1.0, 1e-6);
+    for (uint32_t c = 0; c < 4; ++c) {
+        EXPECT_EQ(stats.maxAbsError[c], 0.0);
+        EXPECT_EQ(stats.meanRelError[c], 0.0);
+        EXPECT_NEAR(stats.channelSSIM[c], 1.0, 1e-6);
+    }
+}
+
+TEST(ImageDiffTest, SinglePixelError)
+{
+    Bitmap a = CreateRandomRGBA8(16, 12, 2);
+    Bitmap b = CreateRandomRGBA8(16, 12, 2);
+
+    a.GetPixel8u(5, 7)[1] = 100;
+    b.GetPixel8u(5, 7)[1] = 151;
+
+    ImageDiffStats stats;
+    ASSERT_EQ(CompareBitmaps(a, b, ImageDiffOptions(), &stats), SUCCESS);
+    EXPECT_EQ(stats.differentPixelCount, 1u);
+    EXPECT_NEAR(stats.maxAbsError[1], 51.0 / 255.0, 1e-6);
+    EXPECT_NEAR(stats.meanAbsError[1], 51.0 / 255.0 / (16 * 12), 1e-7);
+    EXPECT_NEAR(stats.maxRelError[1], 51.0 / 151.0, 1e-6);
+    EXPECT_EQ(stats.maxAbsError[0], 0.0);
+    EXPECT_EQ(stats.channelPSNR[0], std::numeric_limits<double>::infinity());
+
+    const double mse = (51.0 / 255.0) * (51.0 / 255.0) / (16 * 12);
+    EXPECT_NEAR(stats.channelPSNR[1], 10.0 * std::log10(1.0 / mse), 1e-4);
+    EXPECT_NEAR(stats.psnr, 10.0 * std::log10(3.0 / mse), 1e-4);
+    EXPECT_LT(stats.ssim, 1.0);
+}
+
+TEST(ImageDiffTest, MatchesReferenceAtAnyThreadCount)
+{
+    // 8x8 windows do not tile this size, and bands split block rows.
+    Bitmap a = CreateRandomRGBA8(203, 150, 3);
+    Bitmap b = Perturb(a, 12, 4);
+
+    for (uint32_t threadCount : {1u, 3u, 8u}) {
+        ImageDiffOptions options;
+        options.threadCount = threadCount;
+
+        ImageDiffStats stats;
+        ASSERT_EQ(CompareBitmaps(a, b, options, &stats), SUCCESS);
+        double colorSSIM = 0;
+        for (uint32_t c = 0; c < 4; ++c) {
+            double expected = ReferenceSSIM(a, b, c);
+            EXPECT_NEAR(stats.channelSSIM[c], expected, 1e-5) << "channel " << c << ", threads " << threadCount;
+            colorSSIM += (c < 3) ? expected / 3 : 0;
+        }
+        EXPECT_NEAR(stats.ssim, colorSSIM, 1e-5);
+        EXPECT_LE(stats.maxAbsError[0], 12.0 / 255.0 + 1e-6);
+    }
+}
+
+TEST(ImageDiffTest, SmallImageUsesSingleWindow)
+{
+    Bitmap a = CreateRandomRGBA8(5, 3, 5);
+    Bitmap b = Perturb(a, 40, 6);
+
+    ImageDiffStats same;
+    ASSERT_EQ(CompareBitmaps(a, a, ImageDiffOptions(), &same), SUCCESS);
+    EXPECT_NEAR(same.ssim, 1.0, 1e-6);
+
+    ImageDiffStats different;
+    ASSERT_EQ(CompareBitmaps(a, b, ImageDiffOptions(), &different), SUCCESS);
+    EXPECT_LT(different.ssim, 1.0);
+    EXPECT_GT(different.ssim, 0.0);
+}
+
+TEST(ImageDiffTest, FloatImages)
+{
+    Bitmap a;
+    Bitmap b;
+    ASSERT_EQ(Bitmap::Create(4, 1, Bitmap::FORMAT_R_FLOAT, &a), SUCCESS);
+    ASSERT_EQ(Bitmap::Create(4, 1, Bitmap::FORMAT_R_FLOAT, &b), SUCCESS);
+    const float valuesA[] = {0.0f, 2.0f, -4.0f, 10.0f};
+    const float valuesB[] = {0.0f, 3.0f, -4.0f, 5.0f};
+    for (uint32_t x = 0; x < 4; ++x) {
+        *a.GetPixel32f(x, 0) = valuesA[x];
+        *b.GetPixel32f(x, 0) = valuesB[x];
+    }
+
+    ImageDiffOptions options;
+    options.computeSSIM = false;
+
+    ImageDiffStats stats;
+    ASSERT_EQ(CompareBitmaps(a, b, options, &stats), SUCCESS);
+    EXPECT_EQ(stats.channelCount, 1u);
+    EXPECT_EQ(stats.differentPixelCount, 2u);
+    EXPECT_NEAR(stats.maxAbsError[0], 5.0, 1e-6);
+    EXPECT_NEAR(stats.meanAbsError[0], 6.0 / 4, 1e-6);
+    EXPECT_NEAR(stats.maxRelError[0], 0.5, 1e-6);
+    EXPECT_NEAR(stats.meanRelError[0], (1.0 / 3.0 + 0.5) / 4, 1e-6);
+    EXPECT_NEAR(stats.psnr, 10.0 * std::log10(4.0 / 26.0), 1e-4);
+    EXPECT_EQ(stats.ssim, 0.0);
+}
+
+TEST(ImageDiffTest, Heatmap)
+{
+    Bitmap a = CreateRandomRGBA8(9, 9, 7);
+    Bitmap b = CreateRandomRGBA8(9, 9, 7);
+
+    // Alpha differences count too.
+    a.GetPixel8u(1, 1)[3] = 0;
+    b.GetPixel8u(1, 1)[3] = 255;
+    b.GetPixel8u(2, 1)[0] = a.GetPixel8u(2, 1)[0] ^ 0x01;
+
+    ImageDiffOptions options;
+    options.heatmapMaxError = 0.5f;
+
+    ImageDiffStats stats;
+    Bitmap         heatmap;
+    ASSERT_EQ(CompareBitmaps(a, b, options, &stats, &heatmap), SUCCESS);
+    ASSERT_EQ(heatmap.GetFormat(), Bitmap::FORMAT_RGBA_UINT8);
+    ASSERT_EQ(heatmap.GetWidth(), 9u);
+    ASSERT_EQ(heatmap.GetHeight(), 9u);
+
+    const uint8_t* pSame = heatmap.GetPixel8u(0, 0);
+    EXPECT_EQ(pSame[0], 0);
+    EXPECT_EQ(pSame[1], 0);
+    EXPECT_EQ(pSame[2], 0);
+    EXPECT_EQ(pSame[3], 255);
+
+    const uint8_t* pSaturated = heatmap.GetPixel8u(1, 1);
+    EXPECT_EQ(pSaturated[0], 255);
+    EXPECT_EQ(pSaturated[1], 255);
+    EXPECT_EQ(pSaturated[2], 255);
+
+    const uint8_t* pSmall = heatmap.GetPixel8u(2, 1);
+    EXPECT_GT(pSmall[0], 0);
+    EXPECT_EQ(pSmall[1], 0);
+    EXPECT_EQ(pSmall[2], 0);
+}
+
+TEST(ImageDiffTest, MismatchedImagesFail)
+{
+    Bitmap         a = CreateRandomRGBA8(8, 8, 8);
+    Bitmap         b = CreateRandomRGBA8(8, 9, 8);
+    Bitmap         c;
+    ImageDiffStats stats;
+    ASSERT_EQ(Bitmap::Create(8, 8, Bitmap::FORMAT_RGBA_UINT16, &c), SUCCESS);
+    EXPECT_EQ(CompareBitmaps(a, b, ImageDiffOptions(), &stats), ERROR_BITMAP_FOOTPRINT_MISMATCH);
+    EXPECT_EQ(CompareBitmaps(a, c, ImageDiffOptions(), &stats), ERROR_IMAGE_INVALID_FORMAT);
+}
+
+} // namespace
+} // namespace ppx
@@ -0,0 +1,237 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "temp_directory_fixture.h"
+
+#include "ppx/mesh_cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace ppx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+////////////////////////////////////////////////////////////////////////////////
+
+class MeshCacheTestFixture : public TempDirectoryTestFixture
+{
+protected:
+    void SetUp() override
+    {
+        TempDirectoryTestFixture::SetUp();
+
+        mSourcePath = mDirectory / "source.obj";
+        WriteSource("v 0 0 0\n");
+
+        mOptions = TriMeshOptions().Indices().Normals().TexCoords();
+        mMesh    = TriMesh::CreateCube(float3(1, 2, 3), mOptions);
+        ASSERT_EQ(Geometry::Create(mMesh, &mGeometry), SUCCESS);
+
+        mCachePath = MeshCacheFile::GetCachePath(mDirectory, mSourcePath, mOptions);
+    }
+
+    void WriteSource(const std::string& text)
+    {
+        std::ofstream file(mSourcePath, std::ios::binary | std::ios::trunc);
+        file << text;
+    }
+
+    std::filesystem::path mSourcePath;
+    std::filesystem::path mCachePath;
+    TriMeshOptions        mOptions;
+    TriMesh               mMesh;
+    Geometry              mGeometry;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(MeshCacheTestFixture, RoundTripMatchesGeometry)
+{
+    ASSERT_EQ(MeshCacheFile::Write(mCachePath, mSourcePath, mOptions, mGeometry), SUCCESS);
+    EXPECT_TRUE(std::filesystem::exists(mCachePath));
+
+    MeshCacheFile cache;
+    ASSERT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), SUCCESS);
+    EXPECT_TRUE(cache.IsOpen());
+
+    grfx::MeshCreateInfo expected = grfx::MeshCreateInfo(mGeometry);
+    grfx::MeshCreateInfo actual   = cache.GetMeshCreateInfo();
+    EXPECT_EQ(actual.indexType, expected.indexType);
+    EXPECT_EQ(actual.indexCount, expected.indexCount);
+    EXPECT_EQ(actual.vertexCount, expected.vertexCount);
+    ASSERT_EQ(actual.vertexBufferCount, expected.vertexBufferCount);
+    for (uint32_t i = 0; i < expected.vertexBufferCount; ++i) {
+        EXPECT_EQ(actual.vertexBuffers[i].stride, expected.vertexBuffers[i].stride);
+        EXPECT_EQ(actual.vertexBuffers[i].vertexInputRate, expected.vertexBuffers[i].vertexInputRate);
+        ASSERT_EQ(actual.vertexBuffers[i].attributeCount, expected.vertexBuffers[i].attributeCount);
+        for (uint32_t j = 0; j < expected.vertexBuffers[i].attributeCount; ++j) {
+            EXPECT_EQ(actual.vertexBuffers[i].attributes[j].format, expected.vertexBuffers[i].attributes[j].format);
+            EXPECT_EQ(actual.vertexBuffers[i].attributes[j].stride, expected.vertexBuffers[i].attributes[j].stride);
+            EXPECT_EQ(actual.vertexBuffers[i].attributes[j].vertexSemantic, expected.vertexBuffers[i].attributes[j].vertexSemantic);
+        }
+    }
+
+    const Geometry::Buffer* pIndexBuffer = mGeometry.GetIndexBuffer();
+    ASSERT_EQ(cache.GetIndexDataSize(), pIndexBuffer->GetSize());
+    EXPECT_EQ(std::memcmp(cache.GetIndexData(), pIndexBuffer->GetData(), pIndexBuffer->GetSize()), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(cache.GetIndexData()) % MeshCacheFile::kStreamAlignment, 0u);
+
+    ASSERT_EQ(cache.GetVertexBufferCount(), mGeometry.GetVertexBufferCount());
+    for (uint32_t i = 0; i < cache.GetVertexBufferCount(); ++i) {
+        const Geometry::Buffer* pBuffer = mGeometry.GetVertexBuffer(i);
+        ASSERT_EQ(cache.GetVertexDataSize(i), pBuffer->GetSize());
+        EXPECT_EQ(std::memcmp(cache.GetVertexData(i), pBuffer->GetData(), pBuffer->GetSize()), 0);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(cache.GetVertexData(i)) % MeshCacheFile::kStreamAlignment, 0u);
+    }
+}
+
+TEST_F(MeshCacheTestFixture, ConcurrentWritesDoNotCollide)
+{
+    // Each writer has its own temporary file, so every write succeeds and
+    // only the cache file is left next to the source.
+    const uint32_t           kWriterCount = 8;
+    std::vector<Result>      results(kWriterCount, ERROR_FAILED);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < kWriterCount; ++i) {
+        threads.emplace_back([&, i]() {
+            results[i] = MeshCacheFile::Write(mCachePath, mSourcePath, mOptions, mGeometry);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (Result result : results) {
+        EXPECT_EQ(result, SUCCESS);
+    }
+
+    MeshCacheFile cache;
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), SUCCESS);
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(mDirectory), std::filesystem::directory_iterator()), 2);
+}
+
+TEST_F(MeshCacheTestFixture, CachePathDependsOnOptions)
+{
+    TriMeshOptions otherOptions = TriMeshOptions(mOptions).Scale(float3(2, 2, 2));
+    EXPECT_NE(MeshCacheFile::GetCachePath(mDirectory, mSourcePath, otherOptions), mCachePath);
+    EXPECT_EQ(MeshCacheFile::GetCachePath(mDirectory, mSourcePath, mOptions), mCachePath);
+    EXPECT_EQ(mCachePath.extension(), ".ppxmesh");
+}
+
+TEST_F(MeshCacheTestFixture, MissingFileFailsToOpen)
+{
+    MeshCacheFile cache;
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+    EXPECT_FALSE(cache.IsOpen());
+}
+
+TEST_F(MeshCacheTestFixture, ChangedOptionsInvalidate)
+{
+    ASSERT_EQ(MeshCacheFile::Write(mCachePath, mSourcePath, mOptions, mGeometry), SUCCESS);
+
+    MeshCacheFile cache;
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, TriMeshOptions(mOptions).Tangents()), ERROR_FAILED);
+    EXPECT_FALSE(cache.IsOpen());
+}
+
+TEST_F(MeshCacheTestFixture, ChangedSourceInvalidates)
+{
+    ASSERT_EQ(MeshCacheFile::Write(mCachePath, mSourcePath, mOptions, mGeometry), SUCCESS);
+
+    WriteSource("v 0 0 0\nv 1 1 1\n");
+
+    MeshCacheFile cache;
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+
+    // Same size, only the modification time changes.
+    ASSERT_EQ(MeshCacheFile::Write(mCachePath, mSourcePath, mOptions, mGeometry), SUCCESS);
+    ASSERT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), SUCCESS);
+    auto writeTime = std::filesystem::last_write_time(mSourcePath);
+    std::filesystem::last_write_time(mSourcePath, writeTime + std::chrono::seconds(10));
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+    EXPECT_FALSE(cache.IsOpen());
+}
+
+TEST_F(MeshCacheTestFixture, CorruptFilesFailToOpen)
+{
+    ASSERT_EQ(MeshCacheFile::Write(mCachePath, mSourcePath, mOptions, mGeometry), SUCCESS);
+    auto size = std::filesystem::file_size(mCachePath);
+
+    std::vector<char> bytes(size);
+    {
+        std::ifstream file(mCachePath, std::ios::binary);
+        file.read(bytes.data(), bytes.size());
+    }
+    auto writeBytes = [&](const std::vector<char>& data) {
+        std::ofstream file(mCachePath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    };
+
+    MeshCacheFile cache;
+
+    // Wrong version.
+    std::vector<char> badVersion = bytes;
+    badVersion[4] += 1;
+    writeBytes(badVersion);
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+
+    // Wrong magic.
+    std::vector<char> badMagic = bytes;
+    badMagic[0] = 'X';
+    writeBytes(badMagic);
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+
+    // Truncated streams.
+    std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+    writeBytes(truncated);
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+
+    // Truncated header.
+    std::vector<char> truncatedHeader(bytes.begin(), bytes.begin() + 16);
+    writeBytes(truncatedHeader);
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), ERROR_FAILED);
+
+    writeBytes(bytes);
+    EXPECT_EQ(cache.Open(mCachePath, mSourcePath, mOptions), SUCCESS);
+}
+
+TEST_F(MeshCacheTestFixture, SourceWithoutFileIsNotCached)
+{
+    std::filesystem::path source    = mDirectory / "missing.obj";
+    std::filesystem::path cachePath = MeshCacheFile::GetCachePath(mDirectory, source, TriMeshOptions());
+
+    Geometry geometry;
+    ASSERT_EQ(Geometry::Create(TriMesh::CreateCube(float3(1, 1, 1)), &geometry), SUCCESS);
+    EXPECT_EQ(MeshCacheFile::Write(cachePath, source, TriMeshOptions(), geometry), ERROR_FAILED);
+    EXPECT_FALSE(std::filesystem::exists(cachePath));
+}
+
+TEST(MeshCacheTest, DirectoryDefaultsToDisabled)
+{
+    EXPECT_TRUE(GetMeshCacheDirectory().empty());
+    SetMeshCacheDirectory("cache");
+    EXPECT_EQ(GetMeshCacheDirectory(), std::filesystem::path("cache"));
+    SetMeshCacheDirectory("");
+    EXPECT_TRUE(GetMeshCacheDirectory().empty());
+}
+
+} // namespace
+} // namespace ppx
@@ -0,0 +1,240 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/mesh_optimizer.h"
+#include "ppx/tri_mesh.h"
+
+#include <algorithm>
+#include <array>
+
+namespace ppx {
+namespace {
+
+// Triangles of a size x size grid of quads, in a deterministic shuffled order.
+std::vector<uint32_t> ShuffledGrid(uint32_t size)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            uint32_t v0 = y * (size + 1) + x;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + (size + 1);
+            uint32_t v3 = v2 + 1;
+            triangles.push_back({v0, v1, v2});
+            triangles.push_back({v2, v1, v3});
+        }
+    }
+
+    uint32_t state = 12345;
+    for (size_t i = triangles.size() - 1; i > 0; --i) {
+        state = state * 1664525u + 1013904223u;
+        std::swap(triangles[i], triangles[state % (i + 1)]);
+    }
+
+    std::vector<uint32_t> indices;
+    for (const auto& triangle : triangles) {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+    return indices;
+}
+
+// Sorted triangles, each one kept with its winding.
+std::vector<std::array<uint32_t, 3>> SortedTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        triangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+std::vector<std::array<float, 9>> SortedTrianglePositions(const TriMesh& mesh)
+{
+    std::vector<std::array<float, 9>> triangles;
+    for (uint32_t i = 0; i < mesh.GetCountTriangles(); ++i) {
+        uint32_t v[3] = {};
+        EXPECT_EQ(mesh.GetTriangle(i, v[0], v[1], v[2]), SUCCESS);
+        std::array<float, 9> triangle = {};
+        for (uint32_t k = 0; k < 3; ++k) {
+            const float3* pPosition = mesh.GetDataPositions(v[k]);
+            triangle[3 * k + 0]     = pPosition->x;
+            triangle[3 * k + 1]     = pPosition->y;
+            triangle[3 * k + 2]     = pPosition->z;
+        }
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST(MeshOptimizerTest, AnalyzeVertexCache)
+{
+    std::vector<uint32_t> triangle = {0, 1, 2};
+    VertexCacheStatistics stats    = AnalyzeVertexCache(triangle.data(), triangle.size(), 3);
+    EXPECT_EQ(stats.transformedVertexCount, 3u);
+    EXPECT_EQ(stats.referencedVertexCount, 3u);
+    EXPECT_FLOAT_EQ(stats.acmr, 3.0f);
+    EXPECT_FLOAT_EQ(stats.atvr, 1.0f);
+
+    // A quad, with an unreferenced vertex.
+    std::vector<uint32_t> quad = {0, 1, 2, 2, 1, 3};
+    stats                      = AnalyzeVertexCache(quad.data(), quad.size(), 5);
+    EXPECT_EQ(stats.transformedVertexCount, 4u);
+    EXPECT_EQ(stats.referencedVertexCount, 4u);
+    EXPECT_FLOAT_EQ(stats.acmr, 2.0f);
+    EXPECT_FLOAT_EQ(stats.atvr, 1.0f);
+
+    // The first vertex is evicted from a cache of 3 before it is reused.
+    std::vector<uint32_t> evicted = {0, 1, 2, 3, 4, 0};
+    stats                         = AnalyzeVertexCache(evicted.data(), evicted.size(), 5, 3);
+    EXPECT_EQ(stats.transformedVertexCount, 6u);
+    EXPECT_FLOAT_EQ(stats.atvr, 6.0f / 5.0f);
+
+    stats = AnalyzeVertexCache(nullptr, 0, 0);
+    EXPECT_EQ(stats.transformedVertexCount, 0u);
+    EXPECT_EQ(stats.acmr, 0.0f);
+}
+
+TEST(MeshOptimizerTest, OptimizeVertexCacheKeepsTrianglesAndImprovesAcmr)
+{
+    const uint32_t        size        = 64;
+    const uint32_t        vertexCount = (size + 1) * (size + 1);
+    std::vector<uint32_t> indices     = ShuffledGrid(size);
+    std::vector<uint32_t> optimized   = indices;
+
+    OptimizeVertexCache(optimized.data(), optimized.size(), vertexCount);
+    EXPECT_EQ(SortedTriangles(optimized), SortedTriangles(indices));
+
+    VertexCacheStatistics before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+    VertexCacheStatistics after  = AnalyzeVertexCache(optimized.data(), optimized.size(), vertexCount);
+    EXPECT_GT(before.acmr, 2.5f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.5f);
+}
+
+TEST(MeshOptimizerTest, OptimizeVertexCacheHandlesDegenerateAndDisconnectedTriangles)
+{
+    std::vector<uint32_t> indices   = {0, 0, 1, 2, 3, 4, 5, 6, 7, 1, 0, 2, 7, 7, 7};
+    std::vector<uint32_t> optimized = indices;
+    OptimizeVertexCache(optimized.data(), optimized.size(), 8);
+    EXPECT_EQ(SortedTriangles(optimized), SortedTriangles(indices));
+}
+
+TEST(MeshOptimizerTest, OptimizeOverdrawSortsOutwardClustersFirst)
+{
+    // Two disconnected triangles facing +Z: the one in front of the center
+    // of the mesh occludes the one behind it.
+    std::vector<float3> positions = {
+        float3(0, 0, -1),
+        float3(1, 0, -1),
+        float3(0, 1, -1),
+        float3(0, 0, 1),
+        float3(1, 0, 1),
+        float3(0, 1, 1),
+    };
+    std::vector<uint32_t> indices = {0, 1, 2, 3, 4, 5};
+    OptimizeOverdraw(indices.data(), indices.size(), positions.data(), 6);
+    EXPECT_EQ(indices, (std::vector<uint32_t>{3, 4, 5, 0, 1, 2}));
+}
+
+TEST(MeshOptimizerTest, OptimizeOverdrawKeepsTrianglesAndBoundsAcmr)
+{
+    TriMesh                     sphere = TriMesh::CreateSphere(1.0f, 64, 32, TriMeshOptions().Indices().OptimizeVertexCache());
+    const uint32_t*             pData  = sphere.GetDataIndicesU32();
+    const std::vector<uint32_t> indices(pData, pData + sphere.GetCountIndices());
+    const uint32_t              vertexCount = sphere.GetCountPositions();
+    const float                 threshold   = 1.05f;
+
+    std::vector<uint32_t> optimized = indices;
+    OptimizeOverdraw(optimized.data(), optimized.size(), sphere.GetDataPositions(), vertexCount, threshold);
+    EXPECT_EQ(SortedTriangles(optimized), SortedTriangles(indices));
+
+    VertexCacheStatistics before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+    VertexCacheStatistics after  = AnalyzeVertexCache(optimized.data(), optimized.size(), vertexCount);
+    EXPECT_LE(after.acmr, before.acmr * threshold + 0.05f);
+}
+
+TEST(MeshOptimizerTest, OptimizeVertexFetchRemapNumbersVerticesInFirstUseOrder)
+{
+    std::vector<uint32_t> indices = {4, 2, 0, 0, 2, 5};
+    std::vector<uint32_t> remap;
+    EXPECT_EQ(OptimizeVertexFetchRemap(indices.data(), indices.size(), 6, &remap), 4u);
+    EXPECT_EQ(indices, (std::vector<uint32_t>{0, 1, 2, 2, 1, 3}));
+    EXPECT_EQ(remap, (std::vector<uint32_t>{2, 4, 1, 5, 0, 3}));
+
+    std::vector<float> attribute = {0, 0.5f, 1, 1.5f, 2, 2.5f, 3, 3.5f, 4, 4.5f, 5, 5.5f};
+    RemapVertexAttribute(remap, &attribute, 2);
+    EXPECT_EQ(attribute, (std::vector<float>{4, 4.5f, 2, 2.5f, 0, 0.5f, 5, 5.5f, 1, 1.5f, 3, 3.5f}));
+}
+
+TEST(MeshOptimizerTest, TriMeshOptionsOptimizeSphere)
+{
+    TriMeshOptions options   = TriMeshOptions().Indices().Normals().TexCoords().Tangents();
+    TriMesh        raw       = TriMesh::CreateSphere(1.0f, 48, 24, options);
+    TriMesh        optimized = TriMesh::CreateSphere(1.0f, 48, 24, TriMeshOptions(options).OptimizeVertexCache());
+
+    ASSERT_EQ(optimized.GetCountTriangles(), raw.GetCountTriangles());
+    ASSERT_EQ(optimized.GetCountPositions(), raw.GetCountPositions());
+    EXPECT_EQ(optimized.GetCountNormals(), raw.GetCountNormals());
+    EXPECT_EQ(optimized.GetCountTexCoords(), raw.GetCountTexCoords());
+    EXPECT_EQ(optimized.GetCountTangents(), raw.GetCountTangents());
+    EXPECT_EQ(SortedTrianglePositions(optimized), SortedTrianglePositions(raw));
+
+    // Vertex attributes move along with their positions.
+    for (uint32_t i = 0; i < optimized.GetCountPositions(); ++i) {
+        TriMeshVertexData vertex = {};
+        ASSERT_EQ(optimized.GetVertexData(i, &vertex), SUCCESS);
+        EXPECT_NEAR(glm::length(vertex.normal - vertex.position), 0.0f, 1e-5f);
+    }
+
+    VertexCacheStatistics rawStats       = raw.AnalyzeVertexCache();
+    VertexCacheStatistics optimizedStats = optimized.AnalyzeVertexCache();
+    EXPECT_LT(optimizedStats.acmr, rawStats.acmr);
+    EXPECT_LT(optimizedStats.atvr, rawStats.atvr);
+
+    // The first triangle uses the first vertices.
+    uint32_t v0 = 0, v1 = 0, v2 = 0;
+    ASSERT_EQ(optimized.GetTriangle(0, v0, v1, v2), SUCCESS);
+    EXPECT_EQ(std::max({v0, v1, v2}), 2u);
+}
+
+TEST(MeshOptimizerTest, NonIndexedMeshesAreNotOptimized)
+{
+    TriMesh raw       = TriMesh::CreateCube(float3(1, 1, 1));
+    TriMesh optimized = TriMesh::CreateCube(float3(1, 1, 1), TriMeshOptions().OptimizeOverdraw());
+    ASSERT_EQ(optimized.GetCountPositions(), raw.GetCountPositions());
+    for (uint32_t i = 0; i < raw.GetCountPositions(); ++i) {
+        EXPECT_EQ(*optimized.GetDataPositions(i), *raw.GetDataPositions(i));
+    }
+    EXPECT_EQ(optimized.AnalyzeVertexCache().transformedVertexCount, 0u);
+}
+
+TEST(MeshOptimizerTest, OptionsChangeSerialization)
+{
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> optimized;
+    std::vector<uint8_t> overdraw;
+    TriMeshOptions().Indices().Serialize(&raw);
+    TriMeshOptions().Indices().OptimizeVertexCache().Serialize(&optimized);
+    TriMeshOptions().Indices().OptimizeOverdraw(1.1f).Serialize(&overdraw);
+    EXPECT_NE(raw, optimized);
+    EXPECT_NE(raw, overdraw);
+    EXPECT_NE(optimized, overdraw);
+}
+
+} // namespace
+} // namespace ppx
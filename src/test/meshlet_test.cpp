@@ -0,0 +1,234 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/geometry.h"
+#include "ppx/meshlet.h"
+
+#include <algorithm>
+#include <array>
+
+namespace ppx {
+namespace {
+
+// A size x size grid of quads on the XZ plane, facing +Y.
+void CreateGrid(uint32_t size, std::vector<uint32_t>* pIndices, std::vector<float3>* pPositions)
+{
+    for (uint32_t y = 0; y <= size; ++y) {
+        for (uint32_t x = 0; x <= size; ++x) {
+            pPositions->push_back(float3(static_cast<float>(x), 0, static_cast<float>(y)));
+        }
+    }
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            uint32_t v0 = y * (size + 1) + x;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + (size + 1);
+            uint32_t v3 = v2 + 1;
+            pIndices->insert(pIndices->end(), {v0, v2, v1, v1, v2, v3});
+        }
+    }
+}
+
+// The triangles of the meshlets as mesh vertex indices, in meshlet order.
+std::vector<uint32_t> MeshletIndices(const MeshletData& data)
+{
+    std::vector<uint32_t> indices;
+    for (const Meshlet& meshlet : data.meshlets) {
+        for (uint32_t i = 0; i < 3 * meshlet.triangleCount; ++i) {
+            uint8_t local = data.triangles[3 * meshlet.triangleOffset + i];
+            EXPECT_LT(local, meshlet.vertexCount);
+            indices.push_back(data.vertices[meshlet.vertexOffset + local]);
+        }
+    }
+    return indices;
+}
+
+void ExpectBoundsContainVertices(const MeshletData& data, const float3* pPositions)
+{
+    for (const Meshlet& meshlet : data.meshlets) {
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            const float3& p = pPositions[data.vertices[meshlet.vertexOffset + i]];
+            for (int k = 0; k < 3; ++k) {
+                EXPECT_GE(p[k], meshlet.bounds.GetMin()[k]);
+                EXPECT_LE(p[k], meshlet.bounds.GetMax()[k]);
+            }
+            EXPECT_LE(glm::length(p - meshlet.sphereCenter), meshlet.sphereRadius * 1.0001f + 1e-6f);
+        }
+    }
+}
+
+TEST(MeshletTest, CoversEveryTriangleOnceInOrder)
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3>   positions;
+    CreateGrid(32, &indices, &positions);
+
+    MeshletData data;
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 64, 124, &data), SUCCESS);
+
+    // Triangles keep their order and winding.
+    EXPECT_EQ(MeshletIndices(data), indices);
+
+    uint32_t triangleOffset = 0;
+    uint32_t vertexOffset   = 0;
+    for (const Meshlet& meshlet : data.meshlets) {
+        EXPECT_EQ(meshlet.triangleOffset, triangleOffset);
+        EXPECT_EQ(meshlet.vertexOffset, vertexOffset);
+        EXPECT_GT(meshlet.triangleCount, 0u);
+        EXPECT_LE(meshlet.triangleCount, 124u);
+        EXPECT_LE(meshlet.vertexCount, 64u);
+        triangleOffset += meshlet.triangleCount;
+        vertexOffset += meshlet.vertexCount;
+    }
+    EXPECT_EQ(triangleOffset * 3, CountU32(indices));
+    EXPECT_EQ(vertexOffset, CountU32(data.vertices));
+    EXPECT_EQ(data.triangles.size(), indices.size());
+}
+
+TEST(MeshletTest, RespectsLimits)
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3>   positions;
+    CreateGrid(16, &indices, &positions);
+    const uint32_t triangleCount = CountU32(indices) / 3;
+
+    // Disconnected triangles fill a meshlet with 3 vertices each.
+    MeshletData data;
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 3, 124, &data), SUCCESS);
+    EXPECT_EQ(data.GetCountMeshlets(), triangleCount);
+
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 256, 8, &data), SUCCESS);
+    EXPECT_EQ(data.GetCountMeshlets(), triangleCount / 8);
+    for (const Meshlet& meshlet : data.meshlets) {
+        EXPECT_EQ(meshlet.triangleCount, 8u);
+    }
+
+    // A row of 16 quads uses 34 vertices, so 32 vertices fit fewer triangles.
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 32, 512, &data), SUCCESS);
+    for (const Meshlet& meshlet : data.meshlets) {
+        EXPECT_LE(meshlet.vertexCount, 32u);
+    }
+    EXPECT_EQ(MeshletIndices(data), indices);
+}
+
+TEST(MeshletTest, BoundsContainVertices)
+{
+    TriMesh mesh = TriMesh::CreateSphere(1.0f, 48, 24, TriMeshOptions().Indices().OptimizeVertexCache());
+
+    MeshletData data;
+    ASSERT_EQ(BuildMeshlets(mesh, &data), SUCCESS);
+    EXPECT_GT(data.GetCountMeshlets(), 1u);
+    ExpectBoundsContainVertices(data, mesh.GetDataPositions());
+}
+
+TEST(MeshletTest, NormalCone)
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3>   positions;
+    CreateGrid(4, &indices, &positions);
+
+    MeshletData data;
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 64, 124, &data), SUCCESS);
+    ASSERT_EQ(data.GetCountMeshlets(), 1u);
+
+    // All normals are +Y: the cone is a half space below the plane.
+    const Meshlet& meshlet = data.meshlets[0];
+    EXPECT_NEAR(meshlet.coneAxis.y, 1.0f, 1e-5f);
+    EXPECT_NEAR(meshlet.coneCutoff, 0.0f, 1e-3f);
+    EXPECT_LE(meshlet.coneApex.y, 1e-5f);
+
+    auto IsCulled = [&meshlet](const float3& camera) {
+        return glm::dot(glm::normalize(meshlet.coneApex - camera), meshlet.coneAxis) >= meshlet.coneCutoff;
+    };
+    EXPECT_FALSE(IsCulled(float3(2, 10, 2)));
+    EXPECT_TRUE(IsCulled(float3(2, -10, 2)));
+
+    // The triangles of a closed box face every direction: the cone is disabled.
+    TriMesh cube = TriMesh::CreateCube(float3(1, 1, 1), TriMeshOptions().Indices());
+    ASSERT_EQ(BuildMeshlets(cube, &data), SUCCESS);
+    ASSERT_EQ(data.GetCountMeshlets(), 1u);
+    EXPECT_EQ(data.meshlets[0].coneAxis, float3(0));
+    EXPECT_EQ(data.meshlets[0].coneCutoff, 1.0f);
+}
+
+TEST(MeshletTest, DeterministicAcrossThreadCounts)
+{
+    // Large enough for several build ranges.
+    std::vector<uint32_t> indices;
+    std::vector<float3>   positions;
+    CreateGrid(160, &indices, &positions);
+    ASSERT_GT(indices.size() / 3, 3 * kMeshletBuildRangeTriangleCount);
+
+    MeshletData serial;
+    MeshletData parallel;
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 64, 124, &serial, 1), SUCCESS);
+    ASSERT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), CountU32(positions), 64, 124, &parallel, 4), SUCCESS);
+
+    EXPECT_EQ(serial.vertices, parallel.vertices);
+    EXPECT_EQ(serial.triangles, parallel.triangles);
+    ASSERT_EQ(serial.GetCountMeshlets(), parallel.GetCountMeshlets());
+    for (uint32_t i = 0; i < serial.GetCountMeshlets(); ++i) {
+        MeshletDescriptor a = serial.GetDescriptor(i);
+        MeshletDescriptor b = parallel.GetDescriptor(i);
+        EXPECT_EQ(memcmp(&a, &b, sizeof(a)), 0);
+    }
+    EXPECT_EQ(MeshletIndices(parallel), indices);
+    ExpectBoundsContainVertices(parallel, positions.data());
+}
+
+TEST(MeshletTest, InvalidArguments)
+{
+    std::vector<uint32_t> indices   = {0, 1, 2};
+    std::vector<float3>   positions = {float3(0, 0, 0), float3(1, 0, 0), float3(0, 1, 0)};
+
+    MeshletData data;
+    EXPECT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), 3, 2, 124, &data), ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), 3, kMeshletMaxVertices + 1, 124, &data), ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), 3, 64, 0, &data), ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), 3, 64, kMeshletMaxTriangles + 1, &data), ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(BuildMeshlets(indices.data(), indices.size(), positions.data(), 2, 64, 124, &data), ERROR_OUT_OF_RANGE);
+
+    ASSERT_EQ(BuildMeshlets(nullptr, 0, nullptr, 0, 64, 124, &data), SUCCESS);
+    EXPECT_EQ(data.GetCountMeshlets(), 0u);
+}
+
+TEST(MeshletTest, GeometryMeshletBuffers)
+{
+    TriMesh     mesh = TriMesh::CreateSphere(1.0f, 16, 8, TriMeshOptions().Indices());
+    MeshletData data;
+    ASSERT_EQ(BuildMeshlets(mesh, &data), SUCCESS);
+
+    Geometry geometry;
+    ASSERT_EQ(Geometry::Create(mesh, data, &geometry), SUCCESS);
+    EXPECT_EQ(geometry.GetIndexCount(), mesh.GetCountIndices());
+    ASSERT_EQ(geometry.GetMeshletCount(), data.GetCountMeshlets());
+    EXPECT_EQ(geometry.GetMeshletBuffer()->GetSize(), data.GetCountMeshlets() * sizeof(MeshletDescriptor));
+    EXPECT_EQ(geometry.GetMeshletVertexBuffer()->GetElementCount(), CountU32(data.vertices));
+    ASSERT_EQ(geometry.GetMeshletTriangleBuffer()->GetElementCount(), CountU32(data.triangles) / 3);
+
+    const MeshletDescriptor* pDescriptors = reinterpret_cast<const MeshletDescriptor*>(geometry.GetMeshletBuffer()->GetData());
+    const Meshlet&           last         = data.meshlets.back();
+    const MeshletDescriptor& descriptor   = pDescriptors[data.GetCountMeshlets() - 1];
+    EXPECT_EQ(descriptor.counts, last.vertexCount | (last.triangleCount << 16));
+    EXPECT_EQ(descriptor.triangleOffset, last.triangleOffset);
+    EXPECT_EQ(descriptor.sphereCenter, last.sphereCenter);
+
+    const uint32_t* pTriangles = reinterpret_cast<const uint32_t*>(geometry.GetMeshletTriangleBuffer()->GetData());
+    EXPECT_EQ(pTriangles[1], data.triangles[3] | (data.triangles[4] << 8) | (data.triangles[5] << 16));
+}
+
+} // namespace
+} // namespace ppx
@@ -0,0 +1,210 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "temp_directory_fixture.h"
+
+#include "ppx/metrics.h"
+#include "ppx/metrics_binary_report.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace ppx {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+////////////////////////////////////////////////////////////////////////////////
+
+class MetricsBinaryReportTestFixture : public TempDirectoryTestFixture
+{
+protected:
+    void SetUp() override
+    {
+        TempDirectoryTestFixture::SetUp();
+        mPath = mDirectory / "report.ppxm";
+    }
+
+    // Adds a gauge and a counter, and records 'entryCount' entries in each.
+    void RecordRun(metrics::Manager* pManager, const std::string& name, uint32_t entryCount)
+    {
+        pManager->StartRun(name);
+
+        metrics::MetricMetadata gaugeMetadata;
+        gaugeMetadata.type           = metrics::MetricType::GAUGE;
+        gaugeMetadata.name           = "gauge";
+        gaugeMetadata.unit           = "ms";
+        gaugeMetadata.interpretation = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        gaugeMetadata.expectedRange  = {1.0, 100.0};
+        auto gaugeId                 = pManager->AddMetric(gaugeMetadata);
+        ASSERT_NE(gaugeId, metrics::kInvalidMetricID);
+
+        metrics::MetricMetadata counterMetadata;
+        counterMetadata.type = metrics::MetricType::COUNTER;
+        counterMetadata.name = "counter";
+        auto counterId       = pManager->AddMetric(counterMetadata);
+        ASSERT_NE(counterId, metrics::kInvalidMetricID);
+
+        metrics::MetricData gaugeData   = {metrics::MetricType::GAUGE};
+        metrics::MetricData counterData = {metrics::MetricType::COUNTER};
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            // Values that are exactly representable as 32-bit floats.
+            gaugeData.gauge.seconds = 0.016 * i;
+            gaugeData.gauge.value   = 16.0 + static_cast<double>(i % 64) * 0.25;
+            ASSERT_TRUE(pManager->RecordMetricData(gaugeId, gaugeData));
+            counterData.counter.increment = i % 3;
+            ASSERT_TRUE(pManager->RecordMetricData(counterId, counterData));
+        }
+    }
+
+protected:
+    std::filesystem::path mPath;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(MetricsBinaryReportTestFixture, RoundTripMatchesJsonReport)
+{
+    // More entries than a single block, and a partial last block.
+    const uint32_t kEntryCount = metrics::BinaryReportWriter::kGaugeEntriesPerBlock * 2 + 17;
+
+    metrics::Manager manager;
+    ASSERT_TRUE(manager.StartBinaryReport(mPath.string()));
+    RecordRun(&manager, "run0", kEntryCount);
+    manager.EndRun();
+    RecordRun(&manager, "run1", 10);
+    manager.EndRun();
+    manager.StopBinaryReport();
+
+    nlohmann::json converted;
+    ASSERT_TRUE(metrics::ReadBinaryReport(mPath, &converted));
+    nlohmann::json expected = nlohmann::json::parse(manager.CreateReport("report").GetContentString());
+
+    ASSERT_EQ(converted["runs"].size(), 2);
+    EXPECT_EQ(converted["filename"], mPath.filename().string());
+    for (const auto& run : converted["runs"]) {
+        const nlohmann::json* pExpectedRun = nullptr;
+        for (const auto& expectedRun : expected["runs"]) {
+            if (expectedRun["name"] == run["name"]) {
+                pExpectedRun = &expectedRun;
+            }
+        }
+        ASSERT_NE(pExpectedRun, nullptr);
+
+        ASSERT_EQ(run["gauges"].size(), 1);
+        const auto& gauge         = run["gauges"][0];
+        const auto& expectedGauge = (*pExpectedRun)["gauges"][0];
+        EXPECT_EQ(gauge["metadata"], expectedGauge["metadata"]);
+        EXPECT_EQ(gauge["statistics"], expectedGauge["statistics"]);
+        ASSERT_EQ(gauge["time_series"].size(), expectedGauge["time_series"].size());
+        for (size_t i = 0; i < gauge["time_series"].size(); ++i) {
+            EXPECT_NEAR(gauge["time_series"][i][0].get<double>(), expectedGauge["time_series"][i][0].get<double>(), 1e-9);
+            EXPECT_EQ(gauge["time_series"][i][1], expectedGauge["time_series"][i][1]);
+        }
+
+        EXPECT_EQ(run["counters"], (*pExpectedRun)["counters"]);
+    }
+}
+
+TEST_F(MetricsBinaryReportTestFixture, IsSmallerThanJsonReport)
+{
+    metrics::Manager manager;
+    ASSERT_TRUE(manager.StartBinaryReport(mPath.string()));
+    RecordRun(&manager, "run", 100000);
+    manager.EndRun();
+    manager.StopBinaryReport();
+
+    size_t jsonSize   = manager.CreateReport("report").GetContentString().size();
+    size_t binarySize = std::filesystem::file_size(mPath);
+    // 4 bytes per value and 4 bytes per timestamp delta at frame intervals.
+    EXPECT_LT(binarySize, 100000 * 9);
+    EXPECT_LT(binarySize * 5, jsonSize);
+}
+
+TEST_F(MetricsBinaryReportTestFixture, UnfinishedRunIsReadable)
+{
+    const uint32_t kEntryCount = metrics::BinaryReportWriter::kGaugeEntriesPerBlock + 1;
+
+    metrics::Manager manager;
+    ASSERT_TRUE(manager.StartBinaryReport(mPath.string()));
+    RecordRun(&manager, "run", kEntryCount);
+    // Closing without ending the run, e.g. the application is shutting down early.
+    manager.StopBinaryReport();
+
+    nlohmann::json converted;
+    ASSERT_TRUE(metrics::ReadBinaryReport(mPath, &converted));
+    ASSERT_EQ(converted["runs"].size(), 1);
+    const auto& gauge = converted["runs"][0]["gauges"][0];
+    EXPECT_EQ(gauge["time_series"].size(), kEntryCount);
+    EXPECT_TRUE(gauge["statistics"].empty());
+}
+
+TEST_F(MetricsBinaryReportTestFixture, StartFailsWithActiveRun)
+{
+    metrics::Manager manager;
+    manager.StartRun("run");
+    EXPECT_FALSE(manager.StartBinaryReport(mPath.string()));
+    EXPECT_FALSE(std::filesystem::exists(mPath));
+}
+
+TEST_F(MetricsBinaryReportTestFixture, ReadRejectsOtherFiles)
+{
+    {
+        std::ofstream file(mPath);
+        file << "{\"runs\": []}";
+    }
+    nlohmann::json converted;
+    EXPECT_FALSE(metrics::ReadBinaryReport(mPath, &converted));
+}
+
+TEST_F(MetricsBinaryReportTestFixture, ReadRejectsCorruptGaugeEntryCount)
+{
+    metrics::Manager manager;
+    ASSERT_TRUE(manager.StartBinaryReport(mPath.string()));
+    RecordRun(&manager, "run", 16);
+    manager.EndRun();
+    manager.StopBinaryReport();
+
+    std::vector<char> data;
+    {
+        std::ifstream file(mPath, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // The entry count follows the chunk id, the payload size and the metric
+    // id. Claim far more entries than the chunk holds.
+    const char* kGaugeChunkId = "GAUG";
+    auto        it            = std::search(data.begin(), data.end(), kGaugeChunkId, kGaugeChunkId + 4);
+    ASSERT_NE(it, data.end());
+    const uint32_t count = std::numeric_limits<uint32_t>::max();
+    std::memcpy(&*it + 12, &count, sizeof(count));
+    {
+        std::ofstream file(mPath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    }
+
+    nlohmann::json converted;
+    EXPECT_FALSE(metrics::ReadBinaryReport(mPath, &converted));
+}
+
+} // namespace ppx
@@ -18,9 +18,13 @@
 
 #include "nlohmann/json.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <memory>
 #include <limits>
 #include <regex>
+#include <thread>
 
 #if !defined(NDEBUG)
 #define PERFORM_DEATH_TESTS
@@ -522,4 +526,409 @@ TEST_F(MetricsTestFixture, MetricsGaugeIgnoresSameSeconds)
     EXPECT_EQ(gauge["time_series"][1][1], 11.0);
 }
 
+
+TEST_F(MetricsTestFixture, MetricsStreamingGaugeMatchesExactWithinBound)
+{
+    metrics::MetricMetadata exactMetadata;
+    exactMetadata.type = metrics::MetricType::GAUGE;
+    exactMetadata.name = "exact";
+    auto exactId       = pManager->AddMetric(exactMetadata);
+    ASSERT_NE(exactId, metrics::kInvalidMetricID);
+
+    metrics::MetricMetadata streamingMetadata;
+    streamingMetadata.type      = metrics::MetricType::GAUGE;
+    streamingMetadata.name      = "streaming";
+    streamingMetadata.gaugeMode = metrics::GaugeMode::STREAMING;
+    auto streamingId            = pManager->AddMetric(streamingMetadata);
+    ASSERT_NE(streamingId, metrics::kInvalidMetricID);
+
+    // Long-tailed frame-time-like distribution.
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    for (uint32_t i = 0; i < 10000; ++i) {
+        data.gauge.seconds = 0.016 * i;
+        data.gauge.value   = 16.0 + static_cast<double>((i * 7919) % 1000) / 100.0 + ((i % 97 == 0) ? 50.0 : 0.0);
+        ASSERT_TRUE(pManager->RecordMetricData(exactId, data));
+        ASSERT_TRUE(pManager->RecordMetricData(streamingId, data));
+    }
+
+    auto           result    = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed    = nlohmann::json::parse(result);
+    auto           exact     = parsed["runs"][0]["gauges"][0];
+    auto           streaming = parsed["runs"][0]["gauges"][1];
+    EXPECT_EQ(exact["time_series"].size(), 10000);
+    EXPECT_EQ(streaming["time_series"].size(), 0);
+
+    auto   exactStats     = exact["statistics"];
+    auto   streamingStats = streaming["statistics"];
+    double bound          = streamingStats["quantile_relative_accuracy"].get<double>();
+    EXPECT_EQ(bound, metrics::QuantileSketch::kDefaultRelativeAccuracy);
+    EXPECT_FALSE(exactStats.contains("quantile_relative_accuracy"));
+
+    for (const char* key : {"min", "max", "average", "time_ratio"}) {
+        EXPECT_EQ(streamingStats[key], exactStats[key]) << key;
+    }
+    for (const char* key : {"median", "percentile_01", "percentile_05", "percentile_10", "percentile_90", "percentile_95", "percentile_99"}) {
+        double expected = exactStats[key].get<double>();
+        EXPECT_NEAR(streamingStats[key].get<double>(), expected, expected * bound) << key;
+    }
+    EXPECT_NEAR(streamingStats["standard_deviation"].get<double>(), exactStats["standard_deviation"].get<double>(), 1e-9);
+}
+
+TEST_F(MetricsTestFixture, MetricsStreamingGaugeKeepsTimeSeriesOnRequest)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type           = metrics::MetricType::GAUGE;
+    metadata.name           = "gauge";
+    metadata.gaugeMode      = metrics::GaugeMode::STREAMING;
+    metadata.keepTimeSeries = true;
+    auto metricId           = pManager->AddMetric(metadata);
+    ASSERT_NE(metricId, metrics::kInvalidMetricID);
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = 0.0;
+    data.gauge.value         = 10.0;
+    EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+    data.gauge.seconds = 1.0;
+    data.gauge.value   = 11.0;
+    EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+    data.gauge.seconds = 1.0;
+    data.gauge.value   = 12.0;
+    EXPECT_FALSE(pManager->RecordMetricData(metricId, data));
+
+    auto           result = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed = nlohmann::json::parse(result);
+    auto           gauge  = parsed["runs"][0]["gauges"][0];
+    EXPECT_EQ(gauge["time_series"].size(), 2);
+    EXPECT_EQ(gauge["time_series"][1][0], 1.0);
+    EXPECT_EQ(gauge["time_series"][1][1], 11.0);
+    EXPECT_EQ(gauge["statistics"]["time_ratio"], 21.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Streaming Statistics Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(QuantileSketchTest, EmptySketch)
+{
+    metrics::QuantileSketch sketch;
+    EXPECT_EQ(sketch.GetCount(), 0);
+    EXPECT_EQ(sketch.GetValueAtRank(0), 0.0);
+}
+
+TEST(QuantileSketchTest, RanksWithinRelativeAccuracy)
+{
+    const double            kAccuracy = 0.01;
+    metrics::QuantileSketch sketch(kAccuracy);
+    std::vector<double>     values;
+    for (int i = -500; i <= 2000; ++i) {
+        double value = (i == 0) ? 0.0 : i * 0.37;
+        values.push_back(value);
+        sketch.Add(value);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(sketch.GetCount(), values.size());
+
+    for (size_t rank = 0; rank < values.size(); ++rank) {
+        EXPECT_NEAR(sketch.GetValueAtRank(rank), values[rank], std::abs(values[rank]) * kAccuracy) << rank;
+    }
+}
+
+TEST(QuantileSketchTest, MemoryIsBoundedByBucketCount)
+{
+    // Values spanning many orders of magnitude with only a few buckets: the
+    // smallest values collapse, the high quantiles stay accurate.
+    const double            kAccuracy = 0.01;
+    metrics::QuantileSketch sketch(kAccuracy, 64);
+    double                  value = 1e-6;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        sketch.Add(value);
+        value *= 1.05;
+    }
+    double largest = value / 1.05;
+    EXPECT_EQ(sketch.GetCount(), 1000);
+    EXPECT_NEAR(sketch.GetValueAtRank(999), largest, largest * kAccuracy);
+}
+
+TEST(QuantileSketchTest, NonFiniteValuesAreIgnored)
+{
+    metrics::QuantileSketch sketch;
+    sketch.Add(std::numeric_limits<double>::infinity());
+    sketch.Add(-std::numeric_limits<double>::infinity());
+    sketch.Add(std::numeric_limits<double>::quiet_NaN());
+    EXPECT_EQ(sketch.GetCount(), 0);
+
+    sketch.Add(2.0);
+    EXPECT_EQ(sketch.GetCount(), 1);
+    EXPECT_NEAR(sketch.GetValueAtRank(0), 2.0, 2.0 * metrics::QuantileSketch::kDefaultRelativeAccuracy);
+}
+
+TEST(QuantileSketchTest, ExtremeValues)
+{
+    const double            kMax      = std::numeric_limits<double>::max();
+    const double            kAccuracy = 0.01;
+    metrics::QuantileSketch sketch(kAccuracy);
+    sketch.Add(-kMax);
+    sketch.Add(std::numeric_limits<double>::denorm_min());
+    sketch.Add(kMax);
+    ASSERT_EQ(sketch.GetCount(), 3);
+    EXPECT_NEAR(sketch.GetValueAtRank(0), -kMax, kMax * kAccuracy);
+    EXPECT_GT(sketch.GetValueAtRank(1), 0.0);
+    EXPECT_NEAR(sketch.GetValueAtRank(2), kMax, kMax * kAccuracy);
+
+    // Indices of these values do not fit in 32 bits at this accuracy; they
+    // are clamped to the ends of the index range.
+    metrics::QuantileSketch fine(1e-15);
+    fine.Add(std::numeric_limits<double>::denorm_min());
+    fine.Add(kMax);
+    ASSERT_EQ(fine.GetCount(), 2);
+    EXPECT_TRUE(std::isfinite(fine.GetValueAtRank(0)));
+    EXPECT_TRUE(std::isfinite(fine.GetValueAtRank(1)));
+    EXPECT_LE(fine.GetValueAtRank(0), fine.GetValueAtRank(1));
+}
+
+TEST(QuantileSketchTest, MergeMatchesSingleSketch)
+{
+    metrics::QuantileSketch all;
+    metrics::QuantileSketch first;
+    metrics::QuantileSketch second;
+    for (uint32_t i = 1; i <= 1000; ++i) {
+        double value = static_cast<double>((i * 31) % 1000 + 1);
+        all.Add(value);
+        ((i % 2 == 0) ? first : second).Add(value);
+    }
+    ASSERT_TRUE(first.Merge(second));
+    ASSERT_EQ(first.GetCount(), all.GetCount());
+    for (uint64_t rank = 0; rank < all.GetCount(); ++rank) {
+        EXPECT_EQ(first.GetValueAtRank(rank), all.GetValueAtRank(rank));
+    }
+
+    metrics::QuantileSketch other(0.05);
+    EXPECT_FALSE(first.Merge(other));
+}
+
+TEST(RunningMomentsTest, MergeMatchesSinglePass)
+{
+    metrics::RunningMoments all;
+    metrics::RunningMoments first;
+    metrics::RunningMoments second;
+    for (uint32_t i = 0; i < 100; ++i) {
+        double value = 1000.0 + static_cast<double>(i % 7) * 0.5;
+        all.Add(value);
+        ((i < 30) ? first : second).Add(value);
+    }
+    first.Merge(second);
+    EXPECT_EQ(first.count, all.count);
+    EXPECT_NEAR(first.mean, all.mean, 1e-9);
+    EXPECT_NEAR(first.GetVariance(), all.GetVariance(), 1e-9);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Concurrent Recording Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(MetricsTest, ManagerRecordConcurrentWithNoRun)
+{
+    metrics::Manager manager;
+    metrics::MetricData data = {metrics::MetricType::COUNTER};
+    data.counter.increment   = 1;
+    EXPECT_FALSE(manager.RecordMetricDataConcurrent(1, data));
+}
+
+TEST_F(MetricsTestFixture, MetricsConcurrentDataAppliedOnFlush)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type = metrics::MetricType::COUNTER;
+    metadata.name = "counter";
+    auto metricId = pManager->AddMetric(metadata);
+    ASSERT_NE(metricId, metrics::kInvalidMetricID);
+
+    metrics::MetricData data = {metrics::MetricType::COUNTER};
+    data.counter.increment   = 3;
+    EXPECT_TRUE(pManager->RecordMetricDataConcurrent(metricId, data));
+    EXPECT_TRUE(pManager->RecordMetricDataConcurrent(metrics::kInvalidMetricID, data));
+
+    // Creating the report flushes the pending data; the invalid ID is dropped.
+    auto result = pManager->CreateReport("report").GetContentString();
+    auto parsed = nlohmann::json::parse(result);
+    EXPECT_EQ(parsed["runs"][0]["counters"][0]["value"], 3);
+    EXPECT_EQ(parsed["runs"][0]["counters"][0]["entry_count"], 1);
+
+    // Data recorded after the run ends is rejected.
+    pManager->EndRun();
+    EXPECT_FALSE(pManager->RecordMetricDataConcurrent(metricId, data));
+}
+
+// Records from several threads, flushing concurrently from the owning thread,
+// and checks that the results are identical to a single-threaded recording.
+TEST_F(MetricsTestFixture, MetricsConcurrentRecordingStress)
+{
+    const uint32_t kThreadCount      = 8;
+    const uint32_t kEntriesPerThread = 20000;
+
+    auto valueFor = [](uint32_t thread, uint32_t i) {
+        return static_cast<double>((thread * 131 + i * 7919) % 1000) / 10.0;
+    };
+
+    metrics::MetricMetadata counterMetadata;
+    counterMetadata.type = metrics::MetricType::COUNTER;
+    counterMetadata.name = "counter";
+    auto counterId       = pManager->AddMetric(counterMetadata);
+    ASSERT_NE(counterId, metrics::kInvalidMetricID);
+
+    // One gauge per thread, plus the same data recorded on this thread.
+    std::vector<metrics::MetricID> concurrentIds;
+    std::vector<metrics::MetricID> referenceIds;
+    for (uint32_t t = 0; t < kThreadCount; ++t) {
+        metrics::MetricMetadata metadata;
+        metadata.type = metrics::MetricType::GAUGE;
+        metadata.name = "concurrent_" + std::to_string(t);
+        concurrentIds.push_back(pManager->AddMetric(metadata));
+        metadata.name = "reference_" + std::to_string(t);
+        referenceIds.push_back(pManager->AddMetric(metadata));
+    }
+
+    std::atomic<uint32_t>    finishedCount = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            metrics::MetricData counterData = {metrics::MetricType::COUNTER};
+            counterData.counter.increment   = 1;
+            metrics::MetricData gaugeData   = {metrics::MetricType::GAUGE};
+            for (uint32_t i = 0; i < kEntriesPerThread; ++i) {
+                gaugeData.gauge.seconds = static_cast<double>(i);
+                gaugeData.gauge.value   = valueFor(t, i);
+                EXPECT_TRUE(pManager->RecordMetricDataConcurrent(concurrentIds[t], gaugeData));
+                EXPECT_TRUE(pManager->RecordMetricDataConcurrent(counterId, counterData));
+            }
+            ++finishedCount;
+        });
+    }
+    while (finishedCount.load() < kThreadCount) {
+        pManager->FlushConcurrentData();
+        std::this_thread::yield();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    metrics::MetricData gaugeData = {metrics::MetricType::GAUGE};
+    for (uint32_t t = 0; t < kThreadCount; ++t) {
+        for (uint32_t i = 0; i < kEntriesPerThread; ++i) {
+            gaugeData.gauge.seconds = static_cast<double>(i);
+            gaugeData.gauge.value   = valueFor(t, i);
+            pManager->RecordMetricData(referenceIds[t], gaugeData);
+        }
+    }
+
+    auto result = pManager->CreateReport("report").GetContentString();
+    auto parsed = nlohmann::json::parse(result);
+    auto run    = parsed["runs"][0];
+    EXPECT_EQ(run["counters"][0]["value"], kThreadCount * kEntriesPerThread);
+    EXPECT_EQ(run["counters"][0]["entry_count"], kThreadCount * kEntriesPerThread);
+
+    std::unordered_map<std::string, nlohmann::json> gauges;
+    for (const auto& gauge : run["gauges"]) {
+        gauges[gauge["metadata"]["name"]] = gauge;
+    }
+    for (uint32_t t = 0; t < kThreadCount; ++t) {
+        const auto& concurrent = gauges["concurrent_" + std::to_string(t)];
+        const auto& reference  = gauges["reference_" + std::to_string(t)];
+        EXPECT_EQ(concurrent["time_series"].size(), kEntriesPerThread);
+        EXPECT_EQ(concurrent["statistics"], reference["statistics"]);
+        EXPECT_EQ(concurrent["time_series"], reference["time_series"]);
+    }
+}
+
+// A thread keeps recording against the first run while it ends and the next
+// one starts. Its entries may be dropped around EndRun, but none of them may
+// reach the second run.
+TEST_F(MetricsTestFixture, MetricsConcurrentDataDoesNotCrossRuns)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type = metrics::MetricType::COUNTER;
+    metadata.name = "counter";
+    auto firstId  = pManager->AddMetric(metadata);
+    ASSERT_NE(firstId, metrics::kInvalidMetricID);
+
+    std::atomic<bool>     stop          = false;
+    std::atomic<uint32_t> acceptedCount = 0;
+    std::thread           thread([&]() {
+        metrics::MetricData data = {metrics::MetricType::COUNTER};
+        data.counter.increment   = 1;
+        while (!stop.load()) {
+            if (pManager->RecordMetricDataConcurrent(firstId, data)) {
+                ++acceptedCount;
+            }
+        }
+    });
+    while (acceptedCount.load() < 1000) {
+        std::this_thread::yield();
+    }
+
+    pManager->EndRun();
+    pManager->StartRun("second_run");
+    auto secondId = pManager->AddMetric(metadata);
+    ASSERT_NE(secondId, metrics::kInvalidMetricID);
+
+    metrics::MetricData data = {metrics::MetricType::COUNTER};
+    data.counter.increment   = 1;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(pManager->RecordMetricDataConcurrent(secondId, data));
+        pManager->FlushConcurrentData();
+    }
+    stop = true;
+    thread.join();
+
+    auto result = pManager->CreateReport("report").GetContentString();
+    auto parsed = nlohmann::json::parse(result);
+    for (const auto& run : parsed["runs"]) {
+        ASSERT_EQ(run["counters"].size(), 1u);
+        if (run["name"] == "second_run") {
+            EXPECT_EQ(run["counters"][0]["value"], 1000);
+            EXPECT_EQ(run["counters"][0]["entry_count"], 1000);
+        }
+        else {
+            EXPECT_LE(run["counters"][0]["value"], acceptedCount.load());
+        }
+    }
+}
+
+// Entries for a shared gauge come from several threads in arbitrary order,
+// but they are applied in time order within a flush.
+TEST_F(MetricsTestFixture, MetricsConcurrentSharedGaugeIsOrdered)
+{
+    const uint32_t kThreadCount      = 4;
+    const uint32_t kEntriesPerThread = 1000;
+
+    metrics::MetricMetadata metadata;
+    metadata.type = metrics::MetricType::GAUGE;
+    metadata.name = "gauge";
+    auto metricId = pManager->AddMetric(metadata);
+    ASSERT_NE(metricId, metrics::kInvalidMetricID);
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            metrics::MetricData data = {metrics::MetricType::GAUGE};
+            for (uint32_t i = 0; i < kEntriesPerThread; ++i) {
+                data.gauge.seconds = static_cast<double>(i * kThreadCount + t);
+                data.gauge.value   = data.gauge.seconds;
+                pManager->RecordMetricDataConcurrent(metricId, data);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto result = pManager->CreateReport("report").GetContentString();
+    auto parsed = nlohmann::json::parse(result);
+    auto gauge  = parsed["runs"][0]["gauges"][0];
+    ASSERT_EQ(gauge["time_series"].size(), kThreadCount * kEntriesPerThread);
+    for (uint32_t i = 0; i < kThreadCount * kEntriesPerThread; ++i) {
+        EXPECT_EQ(gauge["time_series"][i][0], static_cast<double>(i));
+    }
+}
+
 } // namespace ppx
@@ -0,0 +1,189 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/mipmap.h"
+#include "ppx/parallel.h"
+#include "ppx/scratch_pool.h"
+
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+namespace ppx {
+namespace {
+
+Bitmap CreatePatternBitmap(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t seed)
+{
+    Bitmap bitmap;
+    EXPECT_EQ(Bitmap::Create(width, height, format, &bitmap), SUCCESS);
+    char*    pData = bitmap.GetData();
+    uint32_t state = seed;
+    for (uint64_t i = 0; i < bitmap.GetFootprintSize(); ++i) {
+        state    = state * 1664525u + 1013904223u;
+        pData[i] = static_cast<char>(state >> 24);
+    }
+    if (Bitmap::ChannelDataType(format) == Bitmap::DATA_TYPE_FLOAT) {
+        float* pFloats = reinterpret_cast<float*>(pData);
+        for (uint64_t i = 0; i < bitmap.GetFootprintSize() / sizeof(float); ++i) {
+            pFloats[i] = static_cast<float>(i % 251) / 250.0f;
+        }
+    }
+    return bitmap;
+}
+
+bool MipmapsEqual(const Mipmap& a, const Mipmap& b)
+{
+    if (a.GetLevelCount() != b.GetLevelCount()) {
+        return false;
+    }
+    for (uint32_t level = 0; level < a.GetLevelCount(); ++level) {
+        const Bitmap* pA = a.GetMip(level);
+        const Bitmap* pB = b.GetMip(level);
+        if ((pA->GetFootprintSize() != pB->GetFootprintSize()) ||
+            (memcmp(pA->GetData(), pB->GetData(), pA->GetFootprintSize()) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(ScratchPoolTest, ReusesReleasedBlocksOnSameThread)
+{
+    ScratchPool::TrimThreadCache();
+
+    ScratchPool::Block block = ScratchPool::Acquire(100 * 1024);
+    ASSERT_NE(block.GetData(), nullptr);
+    EXPECT_EQ(block.GetSize(), 128u * 1024u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block.GetData()) % ScratchPool::kBlockAlignment, 0u);
+
+    char* pData = block.GetData();
+    block.Release();
+    EXPECT_EQ(block.GetData(), nullptr);
+    EXPECT_EQ(ScratchPool::GetThreadCacheSize(), 128u * 1024u);
+
+    // Same size class.
+    ScratchPool::Block reused = ScratchPool::Acquire(70 * 1024);
+    EXPECT_EQ(reused.GetData(), pData);
+    EXPECT_EQ(ScratchPool::GetThreadCacheSize(), 0u);
+
+    // Other threads have their own cache.
+    char* pOtherData = nullptr;
+    reused.Release();
+    std::thread thread([&pOtherData]() {
+        ScratchPool::Block other = ScratchPool::Acquire(70 * 1024);
+        pOtherData               = other.GetData();
+    });
+    thread.join();
+    EXPECT_NE(pOtherData, pData);
+
+    ScratchPool::TrimThreadCache();
+    EXPECT_EQ(ScratchPool::GetThreadCacheSize(), 0u);
+}
+
+TEST(ScratchPoolTest, LimitsCachedBlocks)
+{
+    ScratchPool::TrimThreadCache();
+    {
+        std::vector<ScratchPool::Block> blocks;
+        for (uint32_t i = 0; i < ScratchPool::kMaxCachedBlocksPerClass + 2; ++i) {
+            blocks.push_back(ScratchPool::Acquire(ScratchPool::kMinBlockSize));
+        }
+        ScratchPool::Block large = ScratchPool::Acquire(ScratchPool::kMaxCachedBlockSize + 1);
+        EXPECT_EQ(large.GetSize(), ScratchPool::kMaxCachedBlockSize + 1);
+    }
+    EXPECT_EQ(ScratchPool::GetThreadCacheSize(), ScratchPool::kMaxCachedBlocksPerClass * ScratchPool::kMinBlockSize);
+    ScratchPool::TrimThreadCache();
+
+    EXPECT_EQ(ScratchPool::Acquire(0).GetData(), nullptr);
+}
+
+TEST(ScratchPoolTest, ThreadCacheStaysWithinBudget)
+{
+    ScratchPool::TrimThreadCache();
+    {
+        // Released in reverse order. The medium block does not fit with the
+        // large one, which is freed, and the small one fits with the medium.
+        ScratchPool::Block small  = ScratchPool::Acquire(ScratchPool::kMinBlockSize);
+        ScratchPool::Block medium = ScratchPool::Acquire(ScratchPool::kMaxCachedBlockSize / 2);
+        ScratchPool::Block large  = ScratchPool::Acquire(ScratchPool::kMaxCachedBlockSize);
+    }
+    EXPECT_EQ(ScratchPool::GetThreadCacheSize(), ScratchPool::kMaxCachedBlockSize / 2 + ScratchPool::kMinBlockSize);
+    EXPECT_LE(ScratchPool::GetThreadCacheSize(), ScratchPool::kMaxThreadCacheSize);
+    ScratchPool::TrimThreadCache();
+}
+
+TEST(MipmapTest, PooledMipmapMatchesInternalStorage)
+{
+    Bitmap bitmap = CreatePatternBitmap(64, 32, Bitmap::FORMAT_RGBA_UINT8, 1);
+    Mipmap mipmap(bitmap, PPX_REMAINING_MIP_LEVELS);
+    Mipmap pooled(bitmap, PPX_REMAINING_MIP_LEVELS, /* useStaticPool= */ true);
+    ASSERT_TRUE(mipmap.IsOk());
+    ASSERT_TRUE(pooled.IsOk());
+    EXPECT_EQ(pooled.GetLevelCount(), 6u);
+    EXPECT_TRUE(MipmapsEqual(mipmap, pooled));
+}
+
+TEST(MipmapTest, LevelSizes)
+{
+    Mipmap mipmap(CreatePatternBitmap(40, 12, Bitmap::FORMAT_RGBA_UINT8, 1), 3);
+    ASSERT_EQ(mipmap.GetLevelCount(), 3u);
+    EXPECT_EQ(mipmap.GetWidth(2), 10u);
+    EXPECT_EQ(mipmap.GetHeight(2), 3u);
+    EXPECT_EQ(mipmap.GetWidth(3), 0u);
+}
+
+TEST(MipmapTest, PooledMipmapsAreThreadSafe)
+{
+    const Bitmap bitmaps[] = {
+        CreatePatternBitmap(256, 256, Bitmap::FORMAT_RGBA_UINT8, 1),
+        CreatePatternBitmap(200, 120, Bitmap::FORMAT_RGBA_UINT8, 2),
+        CreatePatternBitmap(128, 64, Bitmap::FORMAT_RGBA_UINT16, 3),
+        CreatePatternBitmap(96, 96, Bitmap::FORMAT_RGBA_FLOAT, 4),
+    };
+    const uint32_t bitmapCount = static_cast<uint32_t>(std::size(bitmaps));
+
+    std::vector<std::unique_ptr<Mipmap>> references;
+    for (const Bitmap& bitmap : bitmaps) {
+        references.push_back(std::make_unique<Mipmap>(bitmap, PPX_REMAINING_MIP_LEVELS));
+        ASSERT_TRUE(references.back()->IsOk());
+    }
+
+    // Several mipmaps are alive at once on each thread, and blocks go back
+    // and forth between the pool and the mipmaps.
+    const uint32_t        threadCount = 8;
+    const size_t          chainCount  = 512;
+    std::atomic<uint32_t> mismatchCount(0);
+    ParallelForRanges(chainCount, threadCount, [&](uint32_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += 2) {
+            const uint32_t index0 = static_cast<uint32_t>(i % bitmapCount);
+            const uint32_t index1 = static_cast<uint32_t>((i + 1) % bitmapCount);
+            Mipmap         mipmap0(bitmaps[index0], PPX_REMAINING_MIP_LEVELS, /* useStaticPool= */ true);
+            Mipmap         mipmap1(bitmaps[index1], PPX_REMAINING_MIP_LEVELS, /* useStaticPool= */ true);
+            if (!mipmap0.IsOk() || !MipmapsEqual(mipmap0, *references[index0])) {
+                ++mismatchCount;
+            }
+            if (!mipmap1.IsOk() || !MipmapsEqual(mipmap1, *references[index1])) {
+                ++mismatchCount;
+            }
+        }
+    });
+    EXPECT_EQ(mismatchCount.load(), 0u);
+}
+
+} // namespace
+} // namespace ppx
@@ -0,0 +1,263 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/obj_parser.h"
+#include "ppx/tri_mesh.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace ppx {
+namespace {
+
+// A quad and a triangle in two groups, with a comment, CRLF line endings,
+// extra position components and relative indices.
+const char* kTwoShapes =
+    "# two shapes\r\n"
+    "o quad\r\n"
+    "v -1.0 -1.0 0.0\r\n"
+    "v  1.0 -1.0 0.0 1.0\r\n"
+    "v\t1.0  1.0 0.0 0.5 0.5 0.5\r\n"
+    "v -1.0 1.0 0.0\r\n"
+    "vt 0 0\r\n"
+    "vt 1 0\r\n"
+    "vt 1 1\r\n"
+    "vt 0\r\n"
+    "vn 0 0 1\r\n"
+    "f 1/1/1 2/2/1 3/3/1 4/4/1\r\n"
+    "g tri\r\n"
+    "usemtl unused\r\n"
+    "v 0 0 2e0\r\n"
+    "f -4//-1 -3//-1 -1//-1\r\n";
+
+std::string GenerateGrid(uint32_t size)
+{
+    std::stringstream ss;
+    for (uint32_t y = 0; y <= size; ++y) {
+        for (uint32_t x = 0; x <= size; ++x) {
+            ss << "v " << (x * 0.125f) << " " << (y * -0.5f) << " " << (x * y * 1e-3f) << "\n";
+            ss << "vt " << (x / float(size)) << " " << (y / float(size)) << "\n";
+        }
+    }
+    for (uint32_t y = 0; y < size; ++y) {
+        if ((y % 4) == 0) {
+            ss << "o row" << y << "\n";
+        }
+        for (uint32_t x = 0; x < size; ++x) {
+            uint32_t v0 = y * (size + 1) + x + 1;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v1 + size + 1;
+            uint32_t v3 = v0 + size + 1;
+            ss << "f " << v0 << "/" << v0 << " " << v1 << "/" << v1 << " " << v2 << "/" << v2 << " " << v3 << "/" << v3 << "\n";
+        }
+    }
+    return ss.str();
+}
+
+bool operator==(const ObjIndex& a, const ObjIndex& b)
+{
+    return (a.position == b.position) && (a.texCoord == b.texCoord) && (a.normal == b.normal);
+}
+
+std::filesystem::path WriteTempFile(const std::string& name, const std::string& content)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::ofstream         file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+    return path;
+}
+
+} // namespace
+
+TEST(ObjParserTest, ParsesGeometry)
+{
+    ObjData obj;
+    ASSERT_EQ(ParseOBJ(kTwoShapes, strlen(kTwoShapes), &obj), SUCCESS);
+
+    ASSERT_EQ(obj.positions.size(), 5);
+    EXPECT_EQ(obj.positions[1], float3(1.0f, -1.0f, 0.0f));
+    EXPECT_EQ(obj.positions[2], float3(1.0f, 1.0f, 0.0f));
+    EXPECT_EQ(obj.positions[4], float3(0.0f, 0.0f, 2.0f));
+    ASSERT_EQ(obj.texCoords.size(), 4);
+    EXPECT_EQ(obj.texCoords[3], float2(0.0f, 0.0f));
+    ASSERT_EQ(obj.normals.size(), 1);
+    EXPECT_EQ(obj.normals[0], float3(0.0f, 0.0f, 1.0f));
+
+    // The quad is fan triangulated.
+    ASSERT_EQ(obj.GetCountTriangles(), 3);
+    std::vector<ObjIndex> expected = {
+        {0, 0, 0},
+        {1, 1, 0},
+        {2, 2, 0},
+        {0, 0, 0},
+        {2, 2, 0},
+        {3, 3, 0},
+        {1, -1, 0},
+        {2, -1, 0},
+        {4, -1, 0},
+    };
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_TRUE(obj.indices[i] == expected[i]) << "corner " << i;
+    }
+
+    EXPECT_EQ(obj.shapeFirstTriangles, (std::vector<uint32_t>{0, 2}));
+}
+
+TEST(ObjParserTest, ParsesFloatsLikeStrtof)
+{
+    const char* values[] = {"0", "-0.0", "+1.5", "3.14159265358979", ".5", "5.", "1e-3", "-2.5E+4", "123456789012345678901234", "0.000000000000000000000001234", "1e-40", "6.02214076e23"};
+    for (const char* value : values) {
+        std::string text = std::string("v ") + value + " 0 0\n";
+        ObjData     obj;
+        ASSERT_EQ(ParseOBJ(text.c_str(), text.size(), &obj), SUCCESS) << value;
+        ASSERT_EQ(obj.positions.size(), 1);
+        float expected = strtof(value, nullptr);
+        EXPECT_NEAR(obj.positions[0].x, expected, std::abs(expected) * 1e-6f) << value;
+    }
+}
+
+TEST(ObjParserTest, ChunkedParseMatchesSerialParse)
+{
+    std::string text = GenerateGrid(32);
+
+    ObjData serial;
+    ASSERT_EQ(ParseOBJ(text.c_str(), text.size(), &serial, 1), SUCCESS);
+    EXPECT_EQ(serial.GetCountTriangles(), 32 * 32 * 2);
+    EXPECT_EQ(serial.shapeFirstTriangles.size(), 8);
+
+    for (uint32_t threadCount : {2u, 3u, 7u, 64u}) {
+        ObjData chunked;
+        ASSERT_EQ(ParseOBJ(text.c_str(), text.size(), &chunked, threadCount), SUCCESS);
+        EXPECT_EQ(chunked.positions, serial.positions) << threadCount;
+        EXPECT_EQ(chunked.texCoords, serial.texCoords) << threadCount;
+        ASSERT_EQ(chunked.indices.size(), serial.indices.size());
+        for (size_t i = 0; i < serial.indices.size(); ++i) {
+            ASSERT_TRUE(chunked.indices[i] == serial.indices[i]) << threadCount << " corner " << i;
+        }
+        EXPECT_EQ(chunked.shapeFirstTriangles, serial.shapeFirstTriangles) << threadCount;
+    }
+}
+
+TEST(ObjParserTest, RelativeIndicesAcrossChunks)
+{
+    std::string text;
+    for (uint32_t i = 0; i < 64; ++i) {
+        text += "v " + std::to_string(i) + " 0 0\n";
+    }
+    text += "f -64 -1 -32\n";
+
+    for (uint32_t threadCount : {1u, 8u}) {
+        ObjData obj;
+        ASSERT_EQ(ParseOBJ(text.c_str(), text.size(), &obj, threadCount), SUCCESS);
+        ASSERT_EQ(obj.GetCountTriangles(), 1);
+        EXPECT_EQ(obj.indices[0].position, 0);
+        EXPECT_EQ(obj.indices[1].position, 63);
+        EXPECT_EQ(obj.indices[2].position, 32);
+    }
+}
+
+TEST(ObjParserTest, RejectsMalformedInput)
+{
+    const char* inputs[] = {
+        "v 1 2\n",
+        "v 1 a 3\n",
+        "vn 1 2\n",
+        "v 0 0 0\nf 1 1 x\n",
+        "v 0 0 0\nf 0 1 1\n",
+        "v 0 0 0\nf 1 1 2\n",
+        "v 0 0 0\nf 1 1 -2\n",
+        "v 0 0 0\nf 1/1 1/1 1/1\n",
+    };
+    for (const char* input : inputs) {
+        ObjData obj;
+        EXPECT_EQ(ParseOBJ(input, strlen(input), &obj), ERROR_GEOMETRY_FILE_LOAD_FAILED) << input;
+    }
+}
+
+TEST(ObjParserTest, IgnoresUnsupportedStatements)
+{
+    const char* input = "mtllib a.mtl\nvp 0.5\ns off\nl 1 2\nv 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3 # comment\nf 1 2\n";
+    ObjData     obj;
+    ASSERT_EQ(ParseOBJ(input, strlen(input), &obj), SUCCESS);
+    EXPECT_EQ(obj.positions.size(), 3);
+    EXPECT_EQ(obj.GetCountTriangles(), 1);
+    EXPECT_EQ(obj.shapeFirstTriangles, (std::vector<uint32_t>{0}));
+}
+
+TEST(ObjParserTest, CreateTriMeshWithoutIndices)
+{
+    std::filesystem::path path = WriteTempFile("ppx_obj_parser_test_flat.obj", kTwoShapes);
+
+    TriMesh mesh;
+    ASSERT_EQ(TriMesh::CreateFromOBJ(path, TriMeshOptions().AllAttributes().Scale(float3(2.0f)), &mesh), SUCCESS);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(mesh.GetCountIndices(), 0);
+    EXPECT_EQ(mesh.GetCountPositions(), 9);
+    EXPECT_EQ(mesh.GetCountColors(), 9);
+    EXPECT_EQ(mesh.GetCountNormals(), 9);
+    EXPECT_EQ(mesh.GetCountTexCoords(), 9);
+    EXPECT_EQ(mesh.GetCountTangents(), 9);
+    EXPECT_EQ(mesh.GetBoundingBoxMin(), float3(-2.0f, -2.0f, 0.0f));
+    EXPECT_EQ(mesh.GetBoundingBoxMax(), float3(2.0f, 2.0f, 4.0f));
+
+    // Face colors restart with each shape.
+    EXPECT_EQ(mesh.GetDataColors(0)[0], float3(1.0f, 0.0f, 0.0f));
+    EXPECT_EQ(mesh.GetDataColors(3)[0], float3(0.0f, 1.0f, 0.0f));
+    EXPECT_EQ(mesh.GetDataColors(6)[0], float3(1.0f, 0.0f, 0.0f));
+
+    // The last triangle has no texture coordinates, so it gets none.
+    EXPECT_EQ(mesh.GetDataTexCoords2(2)[0], float2(1.0f, 1.0f));
+    EXPECT_EQ(mesh.GetDataTexCoords2(8)[0], float2(0.0f, 0.0f));
+    EXPECT_EQ(mesh.GetDataNormalls(8)[0], float3(0.0f, 0.0f, 1.0f));
+}
+
+TEST(ObjParserTest, CreateTriMeshSharesIndexedVertices)
+{
+    std::filesystem::path path = WriteTempFile("ppx_obj_parser_test_indexed.obj", GenerateGrid(16));
+
+    TriMesh mesh;
+    ASSERT_EQ(TriMesh::CreateFromOBJ(path, TriMeshOptions().Indices().TexCoords().InvertWinding(), &mesh), SUCCESS);
+
+    EXPECT_EQ(mesh.GetCountTriangles(), 16 * 16 * 2);
+    EXPECT_EQ(mesh.GetCountPositions(), 17 * 17);
+    EXPECT_EQ(mesh.GetCountTexCoords(), 17 * 17);
+
+    // Indices reference the first occurrence of each corner, with the winding
+    // inverted.
+    uint32_t v0 = 0, v1 = 0, v2 = 0;
+    ASSERT_EQ(mesh.GetTriangle(0, v0, v1, v2), SUCCESS);
+    EXPECT_EQ(v0, 0);
+    EXPECT_EQ(v1, 2);
+    EXPECT_EQ(v2, 1);
+    EXPECT_EQ(mesh.GetDataPositions(v1)[0], float3(0.125f, -0.5f, 1e-3f));
+
+    // Per triangle attributes prevent sharing.
+    TriMesh colored;
+    ASSERT_EQ(TriMesh::CreateFromOBJ(path, TriMeshOptions().Indices().VertexColors(), &colored), SUCCESS);
+    std::filesystem::remove(path);
+    EXPECT_EQ(colored.GetCountPositions(), 16 * 16 * 2 * 3);
+}
+
+TEST(ObjParserTest, CreateTriMeshFailsOnMissingFile)
+{
+    TriMesh mesh;
+    EXPECT_EQ(TriMesh::CreateFromOBJ(std::filesystem::temp_directory_path() / "ppx_obj_parser_test_missing.obj", TriMeshOptions(), &mesh), ERROR_GEOMETRY_FILE_LOAD_FAILED);
+}
+
+} // namespace ppx
@@ -0,0 +1,141 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "temp_directory_fixture.h"
+
+#include "ppx/pipeline_cache_file.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace ppx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+////////////////////////////////////////////////////////////////////////////////
+
+class PipelineCacheFileTestFixture : public TempDirectoryTestFixture
+{
+protected:
+    void SetUp() override
+    {
+        TempDirectoryTestFixture::SetUp();
+        // Save creates the directory of the file.
+        mPath = mDirectory / "cache" / "pipeline_cache.bin";
+
+        mDeviceInfo.vendorId      = 0x10DE;
+        mDeviceInfo.deviceId      = 0x2204;
+        mDeviceInfo.driverVersion = 0x21C00000;
+        for (uint8_t i = 0; i < 16; ++i) {
+            mDeviceInfo.cacheUuid[i] = i;
+        }
+
+        for (size_t i = 0; i < 1000; ++i) {
+            mData.push_back(static_cast<char>(i * 7));
+        }
+    }
+
+    std::filesystem::path   mPath;
+    PipelineCacheDeviceInfo mDeviceInfo;
+    std::vector<char>       mData;
+};
+
+} // namespace
+
+TEST_F(PipelineCacheFileTestFixture, SaveThenLoad)
+{
+    ASSERT_EQ(PipelineCacheFile::Save(mPath, mDeviceInfo, mData.data(), mData.size()), SUCCESS);
+    // The temporary file was renamed.
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(mPath.parent_path()), std::filesystem::directory_iterator()), 1);
+
+    std::vector<char> data;
+    ASSERT_EQ(PipelineCacheFile::Load(mPath, mDeviceInfo, &data), SUCCESS);
+    EXPECT_EQ(data, mData);
+}
+
+TEST_F(PipelineCacheFileTestFixture, ConcurrentSavesDoNotCollide)
+{
+    // Each writer has its own temporary file, so every save succeeds and
+    // the file holds the data of one of them.
+    const uint32_t                 kWriterCount = 8;
+    std::vector<std::vector<char>> writerData(kWriterCount, mData);
+    std::vector<Result>            results(kWriterCount, ERROR_FAILED);
+    std::vector<std::thread>       threads;
+    for (uint32_t i = 0; i < kWriterCount; ++i) {
+        writerData[i][0] = static_cast<char>(i);
+        threads.emplace_back([&, i]() {
+            results[i] = PipelineCacheFile::Save(mPath, mDeviceInfo, writerData[i].data(), writerData[i].size());
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (Result result : results) {
+        EXPECT_EQ(result, SUCCESS);
+    }
+
+    std::vector<char> data;
+    ASSERT_EQ(PipelineCacheFile::Load(mPath, mDeviceInfo, &data), SUCCESS);
+    EXPECT_NE(std::find(writerData.begin(), writerData.end(), data), writerData.end());
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(mPath.parent_path()), std::filesystem::directory_iterator()), 1);
+}
+
+TEST_F(PipelineCacheFileTestFixture, MissingFileFails)
+{
+    std::vector<char> data = {1};
+    EXPECT_EQ(PipelineCacheFile::Load(mPath, mDeviceInfo, &data), ERROR_FAILED);
+    EXPECT_TRUE(data.empty());
+}
+
+TEST_F(PipelineCacheFileTestFixture, OtherDriverFails)
+{
+    ASSERT_EQ(PipelineCacheFile::Save(mPath, mDeviceInfo, mData.data(), mData.size()), SUCCESS);
+
+    std::vector<char>       data;
+    PipelineCacheDeviceInfo deviceInfo = mDeviceInfo;
+    deviceInfo.driverVersion += 1;
+    EXPECT_EQ(PipelineCacheFile::Load(mPath, deviceInfo, &data), ERROR_FAILED);
+
+    deviceInfo              = mDeviceInfo;
+    deviceInfo.cacheUuid[3] = 0xFF;
+    EXPECT_EQ(PipelineCacheFile::Load(mPath, deviceInfo, &data), ERROR_FAILED);
+
+    deviceInfo          = mDeviceInfo;
+    deviceInfo.deviceId = 0;
+    EXPECT_EQ(PipelineCacheFile::Load(mPath, deviceInfo, &data), ERROR_FAILED);
+}
+
+TEST_F(PipelineCacheFileTestFixture, CorruptedFileFails)
+{
+    ASSERT_EQ(PipelineCacheFile::Save(mPath, mDeviceInfo, mData.data(), mData.size()), SUCCESS);
+    {
+        std::fstream file(mPath, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(100);
+        file.put('x');
+    }
+    std::vector<char> data;
+    EXPECT_EQ(PipelineCacheFile::Load(mPath, mDeviceInfo, &data), ERROR_FAILED);
+
+    // Truncated
+    ASSERT_EQ(PipelineCacheFile::Save(mPath, mDeviceInfo, mData.data(), mData.size()), SUCCESS);
+    std::filesystem::resize_file(mPath, 500);
+    EXPECT_EQ(PipelineCacheFile::Load(mPath, mDeviceInfo, &data), ERROR_FAILED);
+}
+
+} // namespace ppx
@@ -16,6 +16,8 @@
 
 #include "ppx/ppm_export.h"
 
+#include <cmath>
+#include <cstring>
 #include <optional>
 #include <sstream>
 
@@ -234,6 +236,138 @@ TEST(PPMExport, RowStrideLargerThanRowBytes)
     EXPECT_EQ(data->texels, wantTexels);
 }
 
+// Swapchain formats with dedicated converters. The images are wide enough to
+// go through the SIMD converters, with a few texels left for the scalar tail,
+// and have padded rows.
+const uint32_t kWideWidth     = 13;
+const uint32_t kWideHeight    = 3;
+const uint32_t kWideRowTexels = 16;
+
+std::vector<unsigned char> ExportWide(grfx::Format format, const void* texels, uint32_t bytesPerTexel)
+{
+    std::stringstream buffer(std::stringstream::out | std::stringstream::in | std::ios::binary);
+    Result            res = ExportToPPM(buffer, format, texels, kWideWidth, kWideHeight, kWideRowTexels * bytesPerTexel);
+    EXPECT_EQ(res, 0);
+
+    auto data = PPMData::FromStream(std::move(buffer));
+    if (!data.has_value()) {
+        ADD_FAILURE() << "invalid PPM data";
+        return {};
+    }
+    EXPECT_EQ(data->width, kWideWidth);
+    EXPECT_EQ(data->height, kWideHeight);
+    return data->texels;
+}
+
+TEST(PPMExport, ExportRGBA8_UNORM)
+{
+    std::vector<unsigned char> texels(kWideRowTexels * kWideHeight * 4);
+    std::vector<unsigned char> wantTexels;
+    for (uint32_t y = 0; y < kWideHeight; ++y) {
+        for (uint32_t x = 0; x < kWideRowTexels; ++x) {
+            unsigned char* texel = &texels[(y * kWideRowTexels + x) * 4];
+            for (uint32_t c = 0; c < 4; ++c) {
+                texel[c] = static_cast<unsigned char>(y * 67 + x * 5 + c * 31);
+            }
+            if (x < kWideWidth) {
+                wantTexels.insert(wantTexels.end(), {texel[0], texel[1], texel[2]});
+            }
+        }
+    }
+    EXPECT_EQ(ExportWide(grfx::FORMAT_R8G8B8A8_UNORM, texels.data(), 4), wantTexels);
+    EXPECT_EQ(ExportWide(grfx::FORMAT_R8G8B8A8_SRGB, texels.data(), 4), wantTexels);
+}
+
+TEST(PPMExport, ExportBGRA8_UNORM)
+{
+    std::vector<unsigned char> texels(kWideRowTexels * kWideHeight * 4);
+    std::vector<unsigned char> wantTexels;
+    for (uint32_t y = 0; y < kWideHeight; ++y) {
+        for (uint32_t x = 0; x < kWideRowTexels; ++x) {
+            unsigned char* texel = &texels[(y * kWideRowTexels + x) * 4];
+            for (uint32_t c = 0; c < 4; ++c) {
+                texel[c] = static_cast<unsigned char>(y * 67 + x * 5 + c * 31);
+            }
+            if (x < kWideWidth) {
+                wantTexels.insert(wantTexels.end(), {texel[2], texel[1], texel[0]});
+            }
+        }
+    }
+    EXPECT_EQ(ExportWide(grfx::FORMAT_B8G8R8A8_UNORM, texels.data(), 4), wantTexels);
+    EXPECT_EQ(ExportWide(grfx::FORMAT_B8G8R8A8_SRGB, texels.data(), 4), wantTexels);
+}
+
+TEST(PPMExport, ExportRGB10A2_UNORM)
+{
+    // Red in the low bits. 10-bit values are rounded to the nearest 8-bit value.
+    std::vector<uint32_t>      texels(kWideRowTexels * kWideHeight);
+    std::vector<unsigned char> wantTexels;
+    for (uint32_t y = 0; y < kWideHeight; ++y) {
+        for (uint32_t x = 0; x < kWideRowTexels; ++x) {
+            uint32_t rgb[3] = {(x * 79 + y) % 1024, (x * 1023 / 15), (1023 - x * 3 - y * 300) % 1024};
+            if (x == 0) {
+                rgb[0] = 0;
+                rgb[1] = 1023;
+                rgb[2] = 2; // Rounds down to 0, 3 rounds up to 1
+            }
+            texels[y * kWideRowTexels + x] = rgb[0] | (rgb[1] << 10) | (rgb[2] << 20) | (3u << 30);
+            if (x < kWideWidth) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    wantTexels.push_back(static_cast<unsigned char>(std::lround(rgb[c] * 255.0 / 1023.0)));
+                }
+            }
+        }
+    }
+    EXPECT_EQ(ExportWide(grfx::FORMAT_R10G10B10A2_UNORM, texels.data(), 4), wantTexels);
+}
+
+TEST(PPMExport, ExportRGBA16_FLOAT)
+{
+    // Values are clamped to [0, 1], and NaN is exported as 0.
+    const uint16_t kHalfOne      = 0x3C00;
+    const uint16_t kHalfHalf     = 0x3800;
+    const uint16_t kHalfTwo      = 0x4000;
+    const uint16_t kHalfMinusOne = 0xBC00;
+    const uint16_t kHalfInfinity = 0x7C00;
+    const uint16_t kHalfNaN      = 0x7E00;
+    const uint16_t kHalfDenormal = 0x03FF;
+    const uint16_t kHalfSmall    = 0x1804; // Just above 0.5 / 255
+    const uint16_t special[]     = {kHalfOne, kHalfHalf, kHalfTwo, kHalfMinusOne, kHalfInfinity, kHalfNaN, kHalfDenormal, kHalfSmall};
+
+    std::vector<uint16_t>      texels(kWideRowTexels * kWideHeight * 4);
+    std::vector<unsigned char> wantTexels;
+    for (uint32_t y = 0; y < kWideHeight; ++y) {
+        for (uint32_t x = 0; x < kWideRowTexels; ++x) {
+            uint16_t* texel = &texels[(y * kWideRowTexels + x) * 4];
+            for (uint32_t c = 0; c < 4; ++c) {
+                // Normal halves in [0, 1): exponent 0..14 and any mantissa.
+                uint32_t exponent = (x + c + y) % 15;
+                uint32_t mantissa = (x * 97 + c * 13 + y * 7) % 1024;
+                texel[c]          = static_cast<uint16_t>((exponent << 10) | mantissa);
+            }
+            if (y == 0) {
+                texel[0] = special[x % 8];
+                texel[1] = special[(x + 3) % 8];
+            }
+            if (x < kWideWidth) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    uint32_t exponent = (texel[c] >> 10) & 0x1F;
+                    uint32_t mantissa = texel[c] & 0x3FF;
+                    double   value    = (exponent == 0) ? std::ldexp(mantissa, -24) : std::ldexp(1024 + mantissa, static_cast<int>(exponent) - 25);
+                    if (exponent == 31) {
+                        value = (mantissa == 0) ? 1.0 : 0.0;
+                    }
+                    if ((texel[c] & 0x8000) != 0) {
+                        value = 0.0;
+                    }
+                    wantTexels.push_back(static_cast<unsigned char>(std::floor(std::min(value, 1.0) * 255.0 + 0.5)));
+                }
+            }
+        }
+    }
+    EXPECT_EQ(ExportWide(grfx::FORMAT_R16G16B16A16_FLOAT, texels.data(), 8), wantTexels);
+}
+
 // Errors and unsupported formats.
 TEST(PPMExport, InvalidSize)
 {
@@ -274,7 +408,7 @@ TEST(PPMExport, PackedFormatsNotSupported)
 {
     std::stringstream buffer(std::ios::binary);
     const int16_t     texels[] = {0, 1, 2, 3};
-    Result            res      = ExportToPPM(buffer, grfx::FORMAT_R10G10B10A2_UNORM, texels, 1, 1, 4);
+    Result            res      = ExportToPPM(buffer, grfx::FORMAT_R11G11B10_FLOAT, texels, 1, 1, 4);
     EXPECT_EQ(res, ERROR_PPM_EXPORT_FORMAT_NOT_SUPPORTED);
 }
 
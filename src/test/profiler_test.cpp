@@ -0,0 +1,303 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/profiler.h"
+
+#include "nlohmann/json.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace ppx {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+////////////////////////////////////////////////////////////////////////////////
+
+class ProfilerTestFixture : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Profiler::ReinitializeGlobalVariables();
+    }
+
+    void TearDown() override
+    {
+        Profiler::ReinitializeGlobalVariables();
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Ring Buffer Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(ProfilerSampleRingBufferTest, CapacityRoundsUpToPowerOfTwo)
+{
+    ProfilerSampleRingBuffer ringBuffer(100);
+    EXPECT_EQ(ringBuffer.GetCapacity(), 128);
+    EXPECT_EQ(ringBuffer.GetSize(), 0);
+}
+
+TEST(ProfilerSampleRingBufferTest, PopReturnsEntriesInOrder)
+{
+    ProfilerSampleRingBuffer ringBuffer(4);
+    for (uint32_t i = 0; i < 3; ++i) {
+        EXPECT_TRUE(ringBuffer.Push({i, {i, i + 1}}));
+    }
+    EXPECT_EQ(ringBuffer.GetSize(), 3);
+
+    ProfilerSampleRingBuffer::Entry entry = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+        ASSERT_TRUE(ringBuffer.Pop(&entry));
+        EXPECT_EQ(entry.token, i);
+        EXPECT_EQ(entry.sample.startTimestamp, i);
+        EXPECT_EQ(entry.sample.endTimestamp, i + 1);
+    }
+    EXPECT_FALSE(ringBuffer.Pop(&entry));
+}
+
+TEST(ProfilerSampleRingBufferTest, PushDropsWhenFull)
+{
+    ProfilerSampleRingBuffer ringBuffer(2);
+    EXPECT_TRUE(ringBuffer.Push({0, {0, 1}}));
+    EXPECT_TRUE(ringBuffer.Push({1, {1, 2}}));
+    EXPECT_FALSE(ringBuffer.Push({2, {2, 3}}));
+    EXPECT_EQ(ringBuffer.GetDroppedCount(), 1);
+
+    ProfilerSampleRingBuffer::Entry entry = {};
+    ASSERT_TRUE(ringBuffer.Pop(&entry));
+    EXPECT_EQ(entry.token, 0);
+    EXPECT_TRUE(ringBuffer.Push({3, {3, 4}}));
+}
+
+TEST(ProfilerSampleRingBufferTest, ResetDroppedCount)
+{
+    ProfilerSampleRingBuffer ringBuffer(1);
+    EXPECT_TRUE(ringBuffer.Push({0, {0, 1}}));
+    EXPECT_FALSE(ringBuffer.Push({1, {1, 2}}));
+    EXPECT_FALSE(ringBuffer.Push({2, {2, 3}}));
+    EXPECT_EQ(ringBuffer.GetDroppedCount(), 2);
+
+    ringBuffer.ResetDroppedCount();
+    EXPECT_EQ(ringBuffer.GetDroppedCount(), 0);
+    EXPECT_FALSE(ringBuffer.Push({3, {3, 4}}));
+    EXPECT_EQ(ringBuffer.GetDroppedCount(), 1);
+}
+
+TEST(ProfilerSampleRingBufferTest, ConcurrentProducerConsumer)
+{
+    const uint32_t           kCount = 20000;
+    ProfilerSampleRingBuffer ringBuffer(256);
+
+    std::thread producer([&ringBuffer, kCount]() {
+        for (uint32_t i = 0; i < kCount; ++i) {
+            while (!ringBuffer.Push({i, {i, i}})) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t                        expected = 0;
+    ProfilerSampleRingBuffer::Entry entry    = {};
+    while (expected < kCount) {
+        if (!ringBuffer.Pop(&entry)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(entry.token, expected);
+        ++expected;
+    }
+    producer.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Profiler Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(ProfilerTestFixture, RegisterEventAssignsDenseTokens)
+{
+    ProfilerEventToken token0 = kInvalidProfilerEventToken;
+    ProfilerEventToken token1 = kInvalidProfilerEventToken;
+    EXPECT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "event0", PROFILER_EVENT_RECORD_ACTION_AVERAGE, &token0), SUCCESS);
+    EXPECT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "event1", PROFILER_EVENT_RECORD_ACTION_AVERAGE, &token1), SUCCESS);
+    EXPECT_EQ(token0, 0);
+    EXPECT_EQ(token1, 1);
+
+    ProfilerEventToken duplicate = kInvalidProfilerEventToken;
+    EXPECT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "event0", PROFILER_EVENT_RECORD_ACTION_AVERAGE, &duplicate), ERROR_DUPLICATE_ELEMENT);
+}
+
+TEST_F(ProfilerTestFixture, RecordSampleUpdatesEvent)
+{
+    ProfilerEventToken token = kInvalidProfilerEventToken;
+    ASSERT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "event", PROFILER_EVENT_RECORD_ACTION_AVERAGE, &token), SUCCESS);
+
+    Profiler* pProfiler = Profiler::GetProfilerForThread();
+    ASSERT_NE(pProfiler, nullptr);
+    pProfiler->RecordSample(token, {10, 15});
+    pProfiler->RecordSample(token, {20, 40});
+    pProfiler->RecordSample(kInvalidProfilerEventToken, {0, 1});
+
+    const ProfilerEvent& event = pProfiler->GetEvents()[token];
+    EXPECT_EQ(event.GetSampleCount(), 2);
+    EXPECT_EQ(event.GetSampleTotal(), 25);
+    EXPECT_EQ(event.GetSampleMin(), 5);
+    EXPECT_EQ(event.GetSampleMax(), 20);
+}
+
+TEST_F(ProfilerTestFixture, DrainSamplesFromMultipleThreads)
+{
+    ProfilerEventToken token = kInvalidProfilerEventToken;
+    ASSERT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "event", PROFILER_EVENT_RECORD_ACTION_INSERT, &token), SUCCESS);
+
+    const uint32_t           kThreadCount      = 4;
+    const uint32_t           kSamplesPerThread = 100;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < kThreadCount; ++i) {
+        threads.emplace_back([token, kSamplesPerThread]() {
+            for (uint32_t j = 0; j < kSamplesPerThread; ++j) {
+                ProfilerScopedEventSample sample(token);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<ProfilerThreadSample> samples;
+    Profiler::DrainSamples(&samples);
+    EXPECT_EQ(samples.size(), kThreadCount * kSamplesPerThread);
+    for (const auto& elem : samples) {
+        EXPECT_EQ(elem.token, token);
+        EXPECT_LE(elem.sample.startTimestamp, elem.sample.endTimestamp);
+    }
+
+    samples.clear();
+    Profiler::DrainSamples(&samples);
+    EXPECT_TRUE(samples.empty());
+}
+
+TEST_F(ProfilerTestFixture, TraceCaptureResetsDroppedSampleCount)
+{
+    ProfilerEventToken token = kInvalidProfilerEventToken;
+    ASSERT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "event", PROFILER_EVENT_RECORD_ACTION_INSERT, &token), SUCCESS);
+
+    // Fill the ring buffer of this thread past its capacity.
+    Profiler* pProfiler = Profiler::GetProfilerForThread();
+    ASSERT_NE(pProfiler, nullptr);
+    for (uint32_t i = 0; i < 20000; ++i) {
+        pProfiler->RecordSample(token, {i, i + 1});
+    }
+    EXPECT_GT(Profiler::GetDroppedSampleCount(), 0);
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "ppx_profiler_dropped_test.json";
+    ASSERT_EQ(Profiler::StartTraceCapture(path, 1), SUCCESS);
+    EXPECT_EQ(Profiler::GetDroppedSampleCount(), 0);
+    EXPECT_EQ(Profiler::StopTraceCapture(), SUCCESS);
+    std::filesystem::remove(path);
+}
+
+TEST_F(ProfilerTestFixture, TraceCaptureWritesChromeTraceJson)
+{
+    ProfilerEventToken outerToken = kInvalidProfilerEventToken;
+    ProfilerEventToken innerToken = kInvalidProfilerEventToken;
+    ASSERT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "outer", PROFILER_EVENT_RECORD_ACTION_INSERT, &outerToken), SUCCESS);
+    ASSERT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_UNDEFINED, "inner \"quoted\"", PROFILER_EVENT_RECORD_ACTION_INSERT, &innerToken), SUCCESS);
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "ppx_profiler_trace_test.json";
+    ASSERT_EQ(Profiler::StartTraceCapture(path, 1), SUCCESS);
+    EXPECT_TRUE(Profiler::IsTraceCaptureActive());
+    EXPECT_EQ(Profiler::StartTraceCapture(path, 1), ERROR_SINGLE_INIT_ONLY);
+
+    {
+        ProfilerScopedEventSample outer(outerToken);
+        ProfilerScopedEventSample inner(innerToken);
+    }
+
+    EXPECT_EQ(Profiler::StopTraceCapture(), SUCCESS);
+    EXPECT_FALSE(Profiler::IsTraceCaptureActive());
+
+    std::ifstream  file(path);
+    nlohmann::json trace = nlohmann::json::parse(file);
+    file.close();
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(trace.contains("traceEvents"));
+    const nlohmann::json* pOuter = nullptr;
+    const nlohmann::json* pInner = nullptr;
+    for (const auto& event : trace["traceEvents"]) {
+        if (event["ph"] != "X") {
+            continue;
+        }
+        if (event["name"] == "outer") {
+            pOuter = &event;
+        }
+        else if (event["name"] == "inner \"quoted\"") {
+            pInner = &event;
+        }
+    }
+    ASSERT_NE(pOuter, nullptr);
+    ASSERT_NE(pInner, nullptr);
+    EXPECT_EQ((*pOuter)["tid"], (*pInner)["tid"]);
+
+    // The inner scope must be nested within the outer one.
+    double outerStart = (*pOuter)["ts"];
+    double outerEnd   = outerStart + (*pOuter)["dur"].get<double>();
+    double innerStart = (*pInner)["ts"];
+    double innerEnd   = innerStart + (*pInner)["dur"].get<double>();
+    EXPECT_LE(outerStart, innerStart);
+    EXPECT_GE(outerEnd + 0.001, innerEnd);
+}
+
+TEST_F(ProfilerTestFixture, CountersAreSharedByAllThreads)
+{
+    ProfilerCounterToken token = kInvalidProfilerCounterToken;
+    ASSERT_EQ(Profiler::RegisterCounter("counter", &token), SUCCESS);
+
+    ProfilerCounterToken sameToken = kInvalidProfilerCounterToken;
+    ASSERT_EQ(Profiler::RegisterCounter("counter", &sameToken), SUCCESS);
+    EXPECT_EQ(sameToken, token);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([token]() {
+            for (int j = 0; j < 1000; ++j) {
+                Profiler::AddToCounter(token, 2);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    Profiler::AddToCounter(kInvalidProfilerCounterToken, 1);
+    EXPECT_EQ(Profiler::GetCounterValue(token), 8000);
+
+    std::vector<ProfilerCounterValue> counters;
+    Profiler::GetCounters(&counters);
+    auto it = std::find_if(counters.begin(), counters.end(), [](const ProfilerCounterValue& elem) { return elem.name == "counter"; });
+    ASSERT_NE(it, counters.end());
+    EXPECT_EQ(it->value, 8000);
+
+    // Values are reset but tokens stay valid.
+    Profiler::ReinitializeGlobalVariables();
+    EXPECT_EQ(Profiler::GetCounterValue(token), 0);
+    Profiler::AddToCounter(token, 3);
+    EXPECT_EQ(Profiler::GetCounterValue(token), 3);
+}
+
+} // namespace ppx
@@ -0,0 +1,105 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/slot_map.h"
+
+#include <vector>
+
+namespace ppx {
+
+TEST(SlotMapTest, InsertGetRemove)
+{
+    SlotMap<int>     map;
+    const SlotHandle a = map.Insert(10);
+    const SlotHandle b = map.Insert(20);
+    EXPECT_EQ(map.GetCount(), 2u);
+    ASSERT_NE(map.Get(a), nullptr);
+    EXPECT_EQ(*map.Get(a), 10);
+    EXPECT_EQ(*map.Get(b), 20);
+
+    EXPECT_TRUE(map.Remove(a));
+    EXPECT_FALSE(map.Contains(a));
+    EXPECT_EQ(map.Get(a), nullptr);
+    EXPECT_FALSE(map.Remove(a));
+    EXPECT_EQ(map.GetCount(), 1u);
+    EXPECT_EQ(*map.Get(b), 20);
+}
+
+TEST(SlotMapTest, ReusesFreedSlotsWithNewGeneration)
+{
+    SlotMap<int>     map;
+    const SlotHandle a = map.Insert(1);
+    map.Insert(2);
+    map.Remove(a);
+
+    const SlotHandle c = map.Insert(3);
+    EXPECT_EQ(c.index, a.index);
+    EXPECT_NE(c.generation, a.generation);
+    EXPECT_EQ(map.GetSlotCount(), 2u);
+    EXPECT_EQ(map.Get(a), nullptr);
+    EXPECT_EQ(*map.Get(c), 3);
+}
+
+TEST(SlotMapTest, FreeListIsLastInFirstOut)
+{
+    SlotMap<int>            map;
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(map.Insert(i));
+    }
+    map.Remove(handles[1]);
+    map.Remove(handles[3]);
+    EXPECT_EQ(map.Insert(5).index, handles[3].index);
+    EXPECT_EQ(map.Insert(6).index, handles[1].index);
+    EXPECT_EQ(map.Insert(7).index, 4u);
+}
+
+TEST(SlotMapTest, FindIfAndForEachSkipFreeSlots)
+{
+    SlotMap<int>     map;
+    const SlotHandle a = map.Insert(1);
+    const SlotHandle b = map.Insert(2);
+    map.Insert(3);
+    map.Remove(a);
+
+    EXPECT_EQ(map.FindIf([](int value) { return value == 2; }), b);
+    EXPECT_FALSE(map.FindIf([](int value) { return value == 1; }).IsValid());
+    EXPECT_FALSE(map.GetHandle(a.index).IsValid());
+    EXPECT_EQ(map.GetHandle(b.index), b);
+
+    int sum = 0;
+    map.ForEach([&sum](int value) { sum += value; });
+    EXPECT_EQ(sum, 5);
+}
+
+TEST(SlotMapTest, ClearInvalidatesHandles)
+{
+    SlotMap<int>     map;
+    const SlotHandle a = map.Insert(1);
+    const SlotHandle b = map.Insert(2);
+    map.Clear();
+    EXPECT_TRUE(map.IsEmpty());
+    EXPECT_FALSE(map.Contains(a));
+    EXPECT_FALSE(map.Contains(b));
+
+    // Slots are reused from the lowest index.
+    const SlotHandle c = map.Insert(3);
+    EXPECT_EQ(c.index, 0u);
+    EXPECT_FALSE(map.Contains(a));
+    EXPECT_EQ(map.GetSlotCount(), 2u);
+}
+
+} // namespace ppx
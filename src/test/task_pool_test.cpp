@@ -0,0 +1,199 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/task_pool.h"
+
+#include <future>
+
+namespace ppx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+////////////////////////////////////////////////////////////////////////////////
+
+// Uses a single thread, which is held by a gate task until the test opens
+// the gate, so that the order of the tasks queued behind it is deterministic.
+class TaskPoolTestFixture : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(mPool.Create(1), SUCCESS);
+        std::shared_future<void> gate = mGate.get_future().share();
+        mGateTask                     = mPool.Submit([gate]() { gate.wait(); }, INT32_MAX);
+        while (mGateTask.GetStatus() != TASK_STATUS_RUNNING) {
+            std::this_thread::yield();
+        }
+    }
+
+    void TearDown() override
+    {
+        OpenGate();
+        mPool.Destroy();
+    }
+
+    void OpenGate()
+    {
+        if (!mGateOpen) {
+            mGate.set_value();
+            mGateOpen = true;
+        }
+    }
+
+    TaskHandle SubmitRecorded(int value, int32_t priority)
+    {
+        return mPool.Submit([this, value]() { mOrder.push_back(value); }, priority);
+    }
+
+    TaskPool           mPool;
+    std::promise<void> mGate;
+    bool               mGateOpen = false;
+    TaskHandle         mGateTask;
+    std::vector<int>   mOrder;
+};
+
+} // namespace
+
+TEST_F(TaskPoolTestFixture, RunsByPriorityThenSubmissionOrder)
+{
+    SubmitRecorded(0, 0);
+    SubmitRecorded(1, 5);
+    SubmitRecorded(2, 0);
+    SubmitRecorded(3, 5);
+    SubmitRecorded(4, -1);
+    OpenGate();
+    mPool.WaitIdle();
+
+    EXPECT_EQ(mOrder, std::vector<int>({1, 3, 0, 2, 4}));
+}
+
+TEST_F(TaskPoolTestFixture, SetPriorityReordersPendingTasks)
+{
+    SubmitRecorded(0, 0);
+    TaskHandle task = SubmitRecorded(1, 0);
+    task.SetPriority(1);
+    OpenGate();
+    mPool.WaitIdle();
+
+    EXPECT_EQ(mOrder, std::vector<int>({1, 0}));
+}
+
+TEST_F(TaskPoolTestFixture, CancelPendingTask)
+{
+    TaskHandle task = SubmitRecorded(0, 0);
+    SubmitRecorded(1, 0);
+    EXPECT_TRUE(task.Cancel());
+    EXPECT_EQ(task.GetStatus(), TASK_STATUS_CANCELED);
+    EXPECT_TRUE(task.IsDone());
+    task.Wait();
+
+    OpenGate();
+    mPool.WaitIdle();
+    EXPECT_EQ(mOrder, std::vector<int>({1}));
+    EXPECT_FALSE(task.Cancel());
+}
+
+TEST_F(TaskPoolTestFixture, CancelReleasesFunction)
+{
+    // The function holds its own handle, as pipeline compile jobs do, which
+    // would keep both alive if the canceled function were not released.
+    struct Job
+    {
+        TaskHandle task;
+    };
+    auto job  = std::make_shared<Job>();
+    job->task = mPool.Submit([job]() {});
+
+    std::weak_ptr<Job> weakJob = job;
+    TaskHandle         task    = job->task;
+    job.reset();
+    EXPECT_FALSE(weakJob.expired());
+
+    EXPECT_TRUE(task.Cancel());
+    EXPECT_TRUE(weakJob.expired());
+}
+
+TEST_F(TaskPoolTestFixture, DestroyReleasesPendingFunctions)
+{
+    auto               value     = std::make_shared<int>(0);
+    std::weak_ptr<int> weakValue = value;
+    TaskHandle         task      = mPool.Submit([value]() {});
+    value.reset();
+
+    // Keep the gate task running so that the other task is still pending.
+    std::thread destroyThread([this]() { mPool.Destroy(); });
+    task.Wait();
+    OpenGate();
+    destroyThread.join();
+
+    EXPECT_EQ(task.GetStatus(), TASK_STATUS_CANCELED);
+    EXPECT_TRUE(weakValue.expired());
+}
+
+TEST_F(TaskPoolTestFixture, CannotCancelRunningOrCompleteTask)
+{
+    EXPECT_FALSE(mGateTask.Cancel());
+    EXPECT_EQ(mGateTask.GetStatus(), TASK_STATUS_RUNNING);
+
+    OpenGate();
+    mGateTask.Wait();
+    EXPECT_EQ(mGateTask.GetStatus(), TASK_STATUS_COMPLETE);
+    EXPECT_FALSE(mGateTask.Cancel());
+}
+
+TEST_F(TaskPoolTestFixture, DestroyCancelsPendingTasks)
+{
+    TaskHandle task = SubmitRecorded(0, 0);
+    OpenGate();
+    mPool.Destroy();
+
+    EXPECT_TRUE(mGateTask.IsDone());
+    EXPECT_TRUE(task.IsDone());
+    if (task.GetStatus() == TASK_STATUS_CANCELED) {
+        EXPECT_TRUE(mOrder.empty());
+    }
+    else {
+        EXPECT_EQ(mOrder, std::vector<int>({0}));
+    }
+}
+
+TEST(TaskPoolTest, CreateWithoutThreadsFails)
+{
+    TaskPool pool;
+    EXPECT_EQ(pool.Create(0), ERROR_INVALID_CREATE_ARGUMENT);
+    EXPECT_FALSE(pool.IsCreated());
+}
+
+TEST(TaskPoolTest, RunsTasksOnAllThreads)
+{
+    TaskPool pool;
+    ASSERT_EQ(pool.Create(4), SUCCESS);
+    EXPECT_EQ(pool.GetThreadCount(), 4);
+
+    std::atomic<int>        sum = 0;
+    std::vector<TaskHandle> tasks;
+    for (int i = 1; i <= 100; ++i) {
+        tasks.push_back(pool.Submit([&sum, i]() { sum += i; }));
+    }
+    for (auto& task : tasks) {
+        task.Wait();
+        EXPECT_EQ(task.GetStatus(), TASK_STATUS_COMPLETE);
+    }
+    EXPECT_EQ(sum.load(), 5050);
+}
+
+} // namespace ppx
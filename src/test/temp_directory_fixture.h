@@ -0,0 +1,60 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_test_temp_directory_fixture_h
+#define ppx_test_temp_directory_fixture_h
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace ppx {
+
+// Fixture of tests that write files. Each test gets an empty directory named
+// after the test and a random token, so that tests running in parallel never
+// share files, and the directory is removed after the test.
+class TempDirectoryTestFixture : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        const ::testing::TestInfo* pInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+
+        std::stringstream ss;
+        ss << "ppx_" << pInfo->test_suite_name() << "_" << pInfo->name() << "_" << std::hex << std::random_device{}();
+        // Parameterized tests have a '/' in their names.
+        std::string name = ss.str();
+        std::replace(name.begin(), name.end(), '/', '_');
+
+        mDirectory = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(mDirectory);
+        std::filesystem::create_directories(mDirectory);
+    }
+
+    void TearDown() override
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(mDirectory, ec);
+    }
+
+    std::filesystem::path mDirectory;
+};
+
+} // namespace ppx
+
+#endif // ppx_test_temp_directory_fixture_h
@@ -0,0 +1,209 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "temp_directory_fixture.h"
+
+#include "ppx/texture_cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace ppx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+////////////////////////////////////////////////////////////////////////////////
+
+class TextureCacheTestFixture : public TempDirectoryTestFixture
+{
+protected:
+    void SetUp() override
+    {
+        TempDirectoryTestFixture::SetUp();
+
+        Bitmap bitmap;
+        ASSERT_EQ(Bitmap::Create(37, 20, Bitmap::FORMAT_RGBA_UINT8, &bitmap), SUCCESS);
+        for (uint32_t y = 0; y < bitmap.GetHeight(); ++y) {
+            for (uint32_t x = 0; x < bitmap.GetWidth(); ++x) {
+                uint8_t* pPixel = bitmap.GetPixel8u(x, y);
+                pPixel[0]       = static_cast<uint8_t>(x * 7);
+                pPixel[1]       = static_cast<uint8_t>(y * 13);
+                pPixel[2]       = static_cast<uint8_t>(x ^ y);
+                pPixel[3]       = 255;
+            }
+        }
+        mMipmap = std::make_unique<Mipmap>(bitmap, PPX_REMAINING_MIP_LEVELS);
+        ASSERT_TRUE(mMipmap->IsOk());
+
+        const char content[] = "source image content";
+        mKey.contentHash     = TextureCacheFile::HashContent(content, sizeof(content));
+        mKey.mipLevelCount   = PPX_REMAINING_MIP_LEVELS;
+        mCachePath           = TextureCacheFile::GetCachePath(mDirectory, mKey);
+    }
+
+    std::filesystem::path   mCachePath;
+    TextureCacheFile::Key   mKey;
+    std::unique_ptr<Mipmap> mMipmap;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(TextureCacheTestFixture, RoundTripMatchesMipmap)
+{
+    // D3D12 copy alignments, to check the padding of rows and levels.
+    mKey.rowStrideAlignment = 256;
+    mKey.offsetAlignment    = 512;
+    mCachePath              = TextureCacheFile::GetCachePath(mDirectory, mKey);
+    ASSERT_EQ(TextureCacheFile::Write(mCachePath, mKey, *mMipmap), SUCCESS);
+
+    TextureCacheFile cache;
+    ASSERT_EQ(cache.Open(mCachePath, mKey), SUCCESS);
+    EXPECT_TRUE(cache.IsOpen());
+    EXPECT_EQ(cache.GetFormat(), Bitmap::FORMAT_RGBA_UINT8);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(cache.GetData()) % TextureCacheFile::kDataAlignment, 0u);
+
+    ASSERT_EQ(cache.GetLevelCount(), mMipmap->GetLevelCount());
+    for (uint32_t i = 0; i < cache.GetLevelCount(); ++i) {
+        const TextureCacheFile::Level& level = cache.GetLevel(i);
+        const Bitmap*                  pMip  = mMipmap->GetMip(i);
+        ASSERT_EQ(level.width, pMip->GetWidth());
+        ASSERT_EQ(level.height, pMip->GetHeight());
+        EXPECT_EQ(level.rowStride % 256, 0u);
+        EXPECT_EQ(level.offset % 512, 0u);
+        ASSERT_LE(level.offset + uint64_t(level.rowStride) * level.height, cache.GetDataSize());
+
+        const uint32_t rowSize = pMip->GetWidth() * pMip->GetPixelStride();
+        for (uint32_t y = 0; y < level.height; ++y) {
+            const char* pCached = cache.GetData() + level.offset + y * level.rowStride;
+            EXPECT_EQ(std::memcmp(pCached, pMip->GetData() + y * pMip->GetRowStride(), rowSize), 0) << "level " << i << " row " << y;
+        }
+    }
+}
+
+TEST_F(TextureCacheTestFixture, CapsLevelCountToKey)
+{
+    mKey.mipLevelCount = 2;
+    ASSERT_EQ(TextureCacheFile::Write(mCachePath, mKey, *mMipmap), SUCCESS);
+
+    TextureCacheFile cache;
+    ASSERT_EQ(cache.Open(mCachePath, mKey), SUCCESS);
+    EXPECT_EQ(cache.GetLevelCount(), 2u);
+    EXPECT_EQ(cache.GetLevel(1).width, 18u);
+    EXPECT_EQ(cache.GetLevel(1).height, 10u);
+}
+
+TEST_F(TextureCacheTestFixture, CachePathDependsOnKey)
+{
+    EXPECT_EQ(TextureCacheFile::GetCachePath(mDirectory, mKey), mCachePath);
+    EXPECT_EQ(mCachePath.extension(), ".ppxtex");
+
+    TextureCacheFile::Key otherKey = mKey;
+    otherKey.sRGBMipFilter         = true;
+    EXPECT_NE(TextureCacheFile::GetCachePath(mDirectory, otherKey), mCachePath);
+
+    otherKey             = mKey;
+    otherKey.contentHash = TextureCacheFile::HashContent("other", 5);
+    EXPECT_NE(TextureCacheFile::GetCachePath(mDirectory, otherKey), mCachePath);
+}
+
+TEST_F(TextureCacheTestFixture, HashDependsOnContent)
+{
+    const char a[] = "abcdef";
+    const char b[] = "abcdeg";
+    EXPECT_EQ(TextureCacheFile::HashContent(a, sizeof(a)), TextureCacheFile::HashContent(a, sizeof(a)));
+    EXPECT_NE(TextureCacheFile::HashContent(a, sizeof(a)), TextureCacheFile::HashContent(b, sizeof(b)));
+}
+
+TEST_F(TextureCacheTestFixture, MissingFileFailsToOpen)
+{
+    TextureCacheFile cache;
+    EXPECT_EQ(cache.Open(mCachePath, mKey), ERROR_FAILED);
+    EXPECT_FALSE(cache.IsOpen());
+}
+
+TEST_F(TextureCacheTestFixture, OtherKeyFailsToOpen)
+{
+    ASSERT_EQ(TextureCacheFile::Write(mCachePath, mKey, *mMipmap), SUCCESS);
+
+    TextureCacheFile      cache;
+    TextureCacheFile::Key otherKey = mKey;
+    otherKey.rowStrideAlignment    = 256;
+    EXPECT_EQ(cache.Open(mCachePath, otherKey), ERROR_FAILED);
+    EXPECT_FALSE(cache.IsOpen());
+
+    otherKey             = mKey;
+    otherKey.contentHash = mKey.contentHash + 1;
+    EXPECT_EQ(cache.Open(mCachePath, otherKey), ERROR_FAILED);
+}
+
+TEST_F(TextureCacheTestFixture, CorruptFilesFailToOpen)
+{
+    ASSERT_EQ(TextureCacheFile::Write(mCachePath, mKey, *mMipmap), SUCCESS);
+    auto size = std::filesystem::file_size(mCachePath);
+
+    std::vector<char> bytes(size);
+    {
+        std::ifstream file(mCachePath, std::ios::binary);
+        file.read(bytes.data(), bytes.size());
+    }
+    auto writeBytes = [&](const std::vector<char>& data) {
+        std::ofstream file(mCachePath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    };
+
+    TextureCacheFile cache;
+
+    // Wrong version.
+    std::vector<char> badVersion = bytes;
+    badVersion[4] += 1;
+    writeBytes(badVersion);
+    EXPECT_EQ(cache.Open(mCachePath, mKey), ERROR_FAILED);
+
+    // Wrong magic.
+    std::vector<char> badMagic = bytes;
+    badMagic[0] = 'X';
+    writeBytes(badMagic);
+    EXPECT_EQ(cache.Open(mCachePath, mKey), ERROR_FAILED);
+
+    // Truncated data.
+    std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+    writeBytes(truncated);
+    EXPECT_EQ(cache.Open(mCachePath, mKey), ERROR_FAILED);
+
+    // Truncated header.
+    std::vector<char> truncatedHeader(bytes.begin(), bytes.begin() + 40);
+    writeBytes(truncatedHeader);
+    EXPECT_EQ(cache.Open(mCachePath, mKey), ERROR_FAILED);
+
+    writeBytes(bytes);
+    EXPECT_EQ(cache.Open(mCachePath, mKey), SUCCESS);
+}
+
+TEST(TextureCacheTest, DirectoryDefaultsToDisabled)
+{
+    EXPECT_TRUE(GetTextureCacheDirectory().empty());
+    SetTextureCacheDirectory("cache");
+    EXPECT_EQ(GetTextureCacheDirectory(), std::filesystem::path("cache"));
+    SetTextureCacheDirectory("");
+    EXPECT_TRUE(GetTextureCacheDirectory().empty());
+}
+
+} // namespace
+} // namespace ppx
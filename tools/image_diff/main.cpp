@@ -0,0 +1,176 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares two images, such as screenshots saved with --screenshot-frame-number,
+// and exits with 0 if they match within a threshold, 1 if they do not, and 2
+// on errors. PNG, PPM and any other format Bitmap::LoadFile reads are accepted.
+
+#include "ppx/bitmap.h"
+#include "ppx/image_diff.h"
+#include "ppx/ppm_export.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace ppx;
+
+static const int kExitMatch    = 0;
+static const int kExitMismatch = 1;
+static const int kExitError    = 2;
+
+static void PrintUsage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s <reference> <test> <threshold> [options]\n"
+            "\n"
+            "Options:\n"
+            "  --metric <name>          Metric compared against the threshold (default: ssim):\n"
+            "                             ssim, psnr         pass if the value is at least the threshold\n"
+            "                             max-abs, mean-abs  pass if the largest channel error, in [0, 1],\n"
+            "                                                is at most the threshold\n"
+            "  --heatmap <path>         Save the per-pixel error heatmap as PNG, or as PPM if the\n"
+            "                           path ends in .ppm\n"
+            "  --heatmap-max-error <v>  Error shown with the hottest heatmap color (default: 0.1)\n"
+            "  --threads <n>            Number of threads, 0 for all cores (default: 0)\n",
+            program);
+}
+
+static bool ParseFloat(const char* text, double* pValue)
+{
+    char* pEnd = nullptr;
+    *pValue    = strtod(text, &pEnd);
+    return (pEnd != text) && (*pEnd == '\0');
+}
+
+static double MaxOf(const double* pValues, uint32_t count)
+{
+    double value = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        value = std::max(value, pValues[i]);
+    }
+    return value;
+}
+
+static Result SaveHeatmap(const std::string& path, const Bitmap& heatmap)
+{
+    if ((path.size() >= 4) && (path.compare(path.size() - 4, 4, ".ppm") == 0)) {
+        return ExportToPPM(path, grfx::FORMAT_R8G8B8A8_UNORM, heatmap.GetData(), heatmap.GetWidth(), heatmap.GetHeight(), heatmap.GetRowStride());
+    }
+    return Bitmap::SaveFilePNG(path, &heatmap);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        PrintUsage(argv[0]);
+        return kExitError;
+    }
+
+    const char* referencePath = argv[1];
+    const char* testPath      = argv[2];
+    double      threshold     = 0;
+    if (!ParseFloat(argv[3], &threshold)) {
+        fprintf(stderr, "invalid threshold: %s\n", argv[3]);
+        return kExitError;
+    }
+
+    std::string      metric = "ssim";
+    std::string      heatmapPath;
+    ImageDiffOptions options;
+    for (int i = 4; i < argc; ++i) {
+        const bool hasValue = (i + 1 < argc);
+        double     value    = 0;
+        if ((strcmp(argv[i], "--metric") == 0) && hasValue) {
+            metric = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--heatmap") == 0) && hasValue) {
+            heatmapPath = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--heatmap-max-error") == 0) && hasValue && ParseFloat(argv[i + 1], &value)) {
+            options.heatmapMaxError = static_cast<float>(value);
+            ++i;
+        }
+        else if ((strcmp(argv[i], "--threads") == 0) && hasValue && ParseFloat(argv[i + 1], &value) && (value >= 0)) {
+            options.threadCount = static_cast<uint32_t>(value);
+            ++i;
+        }
+        else {
+            fprintf(stderr, "invalid option: %s\n", argv[i]);
+            PrintUsage(argv[0]);
+            return kExitError;
+        }
+    }
+    if ((metric != "ssim") && (metric != "psnr") && (metric != "max-abs") && (metric != "mean-abs")) {
+        fprintf(stderr, "unknown metric: %s\n", metric.c_str());
+        return kExitError;
+    }
+    options.computeSSIM = (metric == "ssim");
+
+    Bitmap reference;
+    Bitmap test;
+    if (Failed(Bitmap::LoadFile(referencePath, &reference))) {
+        fprintf(stderr, "failed to load %s\n", referencePath);
+        return kExitError;
+    }
+    if (Failed(Bitmap::LoadFile(testPath, &test))) {
+        fprintf(stderr, "failed to load %s\n", testPath);
+        return kExitError;
+    }
+
+    ImageDiffStats stats;
+    Bitmap         heatmap;
+    Result         ppxres = CompareBitmaps(reference, test, options, &stats, heatmapPath.empty() ? nullptr : &heatmap);
+    if (Failed(ppxres)) {
+        fprintf(stderr, "failed to compare %ux%u and %ux%u images: %s\n", reference.GetWidth(), reference.GetHeight(), test.GetWidth(), test.GetHeight(), ToString(ppxres));
+        return kExitError;
+    }
+
+    printf("size:        %ux%u\n", stats.width, stats.height);
+    printf("different:   %llu pixels\n", static_cast<unsigned long long>(stats.differentPixelCount));
+    printf("max abs:     %.6f %.6f %.6f %.6f\n", stats.maxAbsError[0], stats.maxAbsError[1], stats.maxAbsError[2], stats.maxAbsError[3]);
+    printf("mean abs:    %.6f %.6f %.6f %.6f\n", stats.meanAbsError[0], stats.meanAbsError[1], stats.meanAbsError[2], stats.meanAbsError[3]);
+    printf("max rel:     %.6f %.6f %.6f %.6f\n", stats.maxRelError[0], stats.maxRelError[1], stats.maxRelError[2], stats.maxRelError[3]);
+    printf("psnr:        %.3f dB\n", stats.psnr);
+    if (options.computeSSIM) {
+        printf("ssim:        %.6f\n", stats.ssim);
+    }
+
+    if (!heatmapPath.empty()) {
+        ppxres = SaveHeatmap(heatmapPath, heatmap);
+        if (Failed(ppxres)) {
+            fprintf(stderr, "failed to save heatmap to %s: %s\n", heatmapPath.c_str(), ToString(ppxres));
+            return kExitError;
+        }
+    }
+
+    bool match = false;
+    if (metric == "ssim") {
+        match = (stats.ssim >= threshold);
+    }
+    else if (metric == "psnr") {
+        match = (stats.psnr >= threshold);
+    }
+    else if (metric == "max-abs") {
+        match = (MaxOf(stats.maxAbsError, stats.channelCount) <= threshold);
+    }
+    else {
+        match = (MaxOf(stats.meanAbsError, stats.channelCount) <= threshold);
+    }
+    printf("%s (%s, threshold %g)\n", match ? "MATCH" : "MISMATCH", metric.c_str(), threshold);
+
+    return match ? kExitMatch : kExitMismatch;
+}
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+
+# Copyright 2023 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Convert a binary metrics report to the JSON metrics report format.
+
+Binary reports are written by applications run with
+`--metrics-binary-filename`. The format is documented in
+include/ppx/metrics_binary_report.h. The output of this script follows the
+same schema as the reports written with `--metrics-filename`, so existing
+tooling can consume it.
+
+Example use:
+$ tools/metrics-binary-to-json.py report.ppxm report.json
+$ tools/metrics-binary-to-json.py report.ppxm > report.json
+"""
+
+import argparse
+import json
+import logging
+import struct
+import sys
+
+_MAGIC = b'PPXM'
+_VERSION = 1
+_NANOS_PER_SEC = 1e9
+
+_METRIC_TYPE_GAUGE = 1
+
+
+class _ByteReader:
+  """Reads little-endian values from a chunk payload."""
+
+  def __init__(self, data: bytes):
+    self._data = data
+    self._offset = 0
+
+  def get(self, fmt: str):
+    values = struct.unpack_from('<' + fmt, self._data, self._offset)
+    self._offset += struct.calcsize('<' + fmt)
+    return values if len(values) > 1 else values[0]
+
+  def get_string(self) -> str:
+    length = self.get('I')
+    value = self._data[self._offset:self._offset + length].decode('utf-8')
+    self._offset += length
+    return value
+
+  def get_varint(self) -> int:
+    value = 0
+    shift = 0
+    while True:
+      byte = self._data[self._offset]
+      self._offset += 1
+      value |= (byte & 0x7F) << shift
+      if not byte & 0x80:
+        return value
+      shift += 7
+
+
+def convert(data: bytes) -> dict:
+  """Converts the content of a binary report to the JSON report schema."""
+  if data[:4] != _MAGIC:
+    raise ValueError('not a binary metrics report')
+  version = struct.unpack_from('<I', data, 4)[0]
+  if version != _VERSION:
+    raise ValueError(f'unsupported version: {version}')
+
+  content = {'runs': []}
+  run = None
+  metrics = {}
+  offset = 8
+  while offset < len(data):
+    if len(data) - offset < 8:
+      logging.warning('Report is truncated; ignoring trailing bytes.')
+      break
+    chunk_id = data[offset:offset + 4]
+    payload_size = struct.unpack_from('<I', data, offset + 4)[0]
+    offset += 8
+    if len(data) - offset < payload_size:
+      logging.warning('Report is truncated; ignoring last chunk.')
+      break
+    reader = _ByteReader(data[offset:offset + payload_size])
+    offset += payload_size
+
+    if chunk_id == b'HEAD':
+      content['filename'] = reader.get_string()
+      content['generated_at'] = reader.get_string()
+    elif chunk_id == b'RUN ':
+      run = {'name': reader.get_string(), 'gauges': [], 'counters': []}
+      content['runs'].append(run)
+      metrics = {}
+    elif chunk_id == b'META':
+      metric_id, metric_type = reader.get('II')
+      name = reader.get_string()
+      unit = reader.get_string()
+      interpretation, lower_bound, upper_bound = reader.get('Idd')
+      metric = {
+          'metadata': {
+              'name': name,
+              'unit': unit,
+              'interpretation': interpretation,
+              'expected_lower_bound': lower_bound,
+              'expected_upper_bound': upper_bound,
+          }
+      }
+      if metric_type == _METRIC_TYPE_GAUGE:
+        metric['statistics'] = {}
+        metric['time_series'] = []
+        run['gauges'].append(metric)
+      else:
+        metric['value'] = 0
+        metric['entry_count'] = 0
+        run['counters'].append(metric)
+      metrics[metric_id] = metric
+    elif chunk_id == b'GAUG':
+      metric_id, count, nanos = reader.get('IIq')
+      timestamps = [nanos]
+      for _ in range(count - 1):
+        timestamps.append(timestamps[-1] + reader.get_varint())
+      values = reader.get(f'{count}f') if count > 1 else [reader.get('f')]
+      metrics[metric_id]['time_series'].extend(
+          [t / _NANOS_PER_SEC, v] for t, v in zip(timestamps, values))
+    elif chunk_id == b'GSTA':
+      metric_id, field_count = reader.get('II')
+      statistics = metrics[metric_id]['statistics']
+      for _ in range(field_count):
+        name = reader.get_string()
+        statistics[name] = reader.get('d')
+    elif chunk_id == b'CNTR':
+      metric_id, value, entry_count = reader.get('IQQ')
+      metrics[metric_id]['value'] = value
+      metrics[metric_id]['entry_count'] = entry_count
+    elif chunk_id == b'END ':
+      run = None
+    else:
+      logging.warning('Unknown chunk %s; skipping.', chunk_id)
+
+  return content
+
+
+def main() -> int:
+  parser = argparse.ArgumentParser(description=__doc__,
+                                   formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('input', help='Binary metrics report.')
+  parser.add_argument('output', nargs='?',
+                      help='Output JSON file. Defaults to standard output.')
+  args = parser.parse_args()
+
+  with open(args.input, 'rb') as f:
+    data = f.read()
+  try:
+    content = convert(data)
+  except (ValueError, struct.error, KeyError) as e:
+    logging.error('Failed to convert %s: %s', args.input, e)
+    return 1
+
+  if args.output:
+    with open(args.output, 'w') as f:
+      json.dump(content, f, indent=4, sort_keys=True)
+      f.write('\n')
+  else:
+    json.dump(content, sys.stdout, indent=4, sort_keys=True)
+    sys.stdout.write('\n')
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())